@@ -0,0 +1,55 @@
+/**
+  * @file	crc.h
+  * @author	Parham Estiri
+  * @brief	CRC-32 on the hardware CRC calculation unit.
+  *
+  * 		The unit takes one 32-bit word per write (4 AHB cycles) and computes
+  * 		CRC-32/MPEG-2: polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no
+  * 		reflection, no final XOR. Words are fed as the CPU reads them from
+  * 		memory (little-endian), so byte strings are processed in 4-byte
+  * 		groups and the last group is padded with zeros.
+  *
+  * @note	QEMU builds (QEMU_NETDUINOPLUS2) compute the same CRC in software,
+  * 		the unit is not emulated. Tools/image_tool.py implements it on the host.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Enable the CRC unit clock.
+  * @retval	None
+  */
+void CRC_Init(void);
+
+/**
+  * @brief	CRC of a word-aligned block.
+  * @param[in] data		Words.
+  * @param[in] words	Number of words.
+  * @retval	CRC-32/MPEG-2 over the words.
+  */
+uint32_t CRC_Words(const uint32_t *data, uint32_t words);
+
+/**
+  * @brief	CRC of a byte string, zero-padded to a multiple of 4 bytes.
+  * @param[in] data	Bytes (any alignment).
+  * @param[in] len	Number of bytes.
+  * @retval	CRC-32/MPEG-2 over the padded words.
+  */
+uint32_t CRC_Bytes(const void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CRC_H_ */
@@ -0,0 +1,116 @@
+/**
+  * @file	image.h
+  * @author	Parham Estiri
+  * @brief	Flash layout and application image format.
+  *
+  * 		| Region     | Sectors  | Address    | Size    |
+  * 		|------------|----------|------------|---------|
+  * 		| Bootloader | 0 .. 1   | 0x08000000 | 32 KiB  |
+  * 		| Boot state | 2 .. 3   | 0x08008000 | 2x16 KiB|
+  * 		| (free)     | 4        | 0x08010000 | 64 KiB  |
+  * 		| Slot A     | 5 .. 7   | 0x08020000 | 384 KiB |
+  * 		| Slot B     | 8 .. 10  | 0x08080000 | 384 KiB |
+  * 		| (free)     | 11       | 0x080E0000 | 128 KiB |
+  *
+  * 		An image runs in place from its slot, so it is linked for one slot:
+  * 		flash origin = slot address + IMAGE_HEADER_SIZE, where its vector
+  * 		table starts (512-byte aligned, as VTOR requires for 98 vectors).
+  * 		The header in front of it is added by Tools/image_tool.py:
+  *
+  * 		| Word | Field       | Meaning                                      |
+  * 		|------|-------------|----------------------------------------------|
+  * 		| 0    | magic       | IMAGE_MAGIC                                  |
+  * 		| 1    | header_size | IMAGE_HEADER_SIZE                            |
+  * 		| 2    | version     | major << 24, minor << 16, patch              |
+  * 		| 3    | size        | Bytes after the header, multiple of 4        |
+  * 		| 4    | crc         | CRC-32 (crc.h) of those bytes                |
+  * 		| 5    | load_addr   | Vector table address the image is linked for |
+  * 		| 6-14 | reserved    | 0                                            |
+  * 		| 15   | header_crc  | CRC-32 of words 0 .. 14                      |
+  *
+  * 		Checking a header costs one 60-byte CRC; checking the image costs
+  * 		one pass of the CRC unit over it (about 1 ms per 10 KiB at 16 MHz).
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef IMAGE_H_
+#define IMAGE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define IMAGE_SLOTS				2U
+#define IMAGE_SLOT_NONE			0xFFU
+#define IMAGE_SLOT_A_ADDR		0x08020000UL	/**< Sector 5							*/
+#define IMAGE_SLOT_B_ADDR		0x08080000UL	/**< Sector 8							*/
+#define IMAGE_SLOT_A_SECTOR		5U
+#define IMAGE_SLOT_B_SECTOR		8U
+#define IMAGE_SLOT_SECTORS		3U				/**< 128 KiB sectors per slot			*/
+#define IMAGE_SLOT_SIZE			0x60000UL		/**< 384 KiB							*/
+#define IMAGE_HEADER_SIZE		0x200U			/**< Header area, vector table follows	*/
+#define IMAGE_MAGIC				0x474D4942UL	/**< "BIMG"								*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Image header, at the start of a slot.
+  */
+typedef struct {
+	uint32_t	magic;
+	uint32_t	header_size;
+	uint32_t	version;
+	uint32_t	size;				/**< Bytes after the header area				*/
+	uint32_t	crc;				/**< CRC-32 of those bytes						*/
+	uint32_t	load_addr;			/**< Vector table address						*/
+	uint32_t	reserved[9];
+	uint32_t	header_crc;			/**< CRC-32 of the words above					*/
+} Image_Header_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Start address of a slot.
+  * @param[in] slot	0 (A) or 1 (B).
+  * @retval	Address.
+  */
+uint32_t Image_SlotAddr(uint8_t slot);
+
+/**
+  * @brief	First flash sector of a slot.
+  * @param[in] slot	0 (A) or 1 (B).
+  * @retval	Sector number.
+  */
+uint32_t Image_SlotSector(uint8_t slot);
+
+/**
+  * @brief	Slot that contains an address.
+  * @param[in] addr	Address, e.g. SCB->VTOR of the running image.
+  * @retval	Slot, or IMAGE_SLOT_NONE.
+  */
+uint8_t Image_SlotOf(uint32_t addr);
+
+/**
+  * @brief	Header of a slot, if it is consistent.
+  * @param[in] slot	0 (A) or 1 (B).
+  * @retval	Header, or NULL if missing, corrupt or not linked for this slot.
+  * @note	Checks the header only, not the image behind it.
+  */
+const Image_Header_t *Image_GetHeader(uint8_t slot);
+
+/**
+  * @brief	Check the image behind a header against its CRC.
+  * @param[in] header	Header returned by Image_GetHeader().
+  * @retval	1 if the image is intact, 0 otherwise.
+  */
+uint8_t Image_Verify(const Image_Header_t *header);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* IMAGE_H_ */
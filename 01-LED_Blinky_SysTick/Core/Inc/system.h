@@ -14,6 +14,9 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include "stm32f4xx.h"
+#if defined(QEMU_NETDUINOPLUS2)
+#include "qemu_board.h"
+#endif /* QEMU_NETDUINOPLUS2 */
 
 /******************************  Function Prototypes  ******************************/
 
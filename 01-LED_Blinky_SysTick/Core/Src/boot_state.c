@@ -0,0 +1,136 @@
+/**
+  * @file	boot_state.c
+  * @author	Parham Estiri
+  * @brief	Persistent boot state: confirmed slot, trial, verification cache.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <stddef.h>
+#include "boot_state.h"
+#include "crc.h"
+
+#define BOOT_STATE_RECORDS		(BOOT_STATE_SECTOR_SIZE / sizeof(Boot_State_t))
+#define BOOT_STATE_WORDS		(sizeof(Boot_State_t) / 4U)
+#define BOOT_STATE_BLANK		0xFFFFFFFFUL	/**< Erased flash word					*/
+
+static uint8_t boot_state_sector;			/**< 0 or 1: sector holding the current record	*/
+static uint32_t boot_state_next;			/**< Index of the next free record in it		*/
+
+/**************************  Static Function Prototypes  ***************************/
+static const Boot_State_t *BootState_Scan(uint8_t sector, uint32_t *next);
+static uint32_t BootState_Addr(uint8_t sector);
+
+/**
+  * @brief	Read the current state.
+  * @param[out] state	State; defaults (nothing confirmed, nothing cached) if none is stored.
+  * @retval	None
+  */
+void BootState_Load(Boot_State_t *state)
+{
+	uint32_t next[2];
+	const Boot_State_t *last0 = BootState_Scan(0, &next[0]);
+	const Boot_State_t *last1 = BootState_Scan(1, &next[1]);
+
+	boot_state_sector = (last1 != NULL && (last0 == NULL || last1->seq > last0->seq)) ? 1U : 0U;
+	boot_state_next = next[boot_state_sector];
+
+	if (last0 == NULL && last1 == NULL)
+	{
+		*state = (Boot_State_t){
+			.magic = BOOT_STATE_MAGIC,
+			.confirmed = IMAGE_SLOT_NONE,
+			.trial = IMAGE_SLOT_NONE,
+		};
+		return;
+	}
+	*state = *(boot_state_sector ? last1 : last0);
+}
+
+/**
+  * @brief	Append a record with a changed state.
+  * @param[in,out] state	State from BootState_Load(); seq and crc are updated.
+  * @retval	FLASH_OK, or the error of the failed erase or write.
+  * @note	Call BootState_Load() first: it finds where the next record goes.
+  */
+Flash_Status_t BootState_Save(Boot_State_t *state)
+{
+	Flash_Status_t status;
+
+	state->magic = BOOT_STATE_MAGIC;
+	state->seq++;
+	state->crc = CRC_Words((const uint32_t *)state, BOOT_STATE_WORDS - 1U);
+
+	if (boot_state_next >= BOOT_STATE_RECORDS)
+	{
+		/* Current sector full: start over in the other one, this one stays valid meanwhile */
+		status = Flash_EraseSector(boot_state_sector ? BOOT_STATE_SECTOR0 : BOOT_STATE_SECTOR1);
+		if (status != FLASH_OK)
+			return status;
+		boot_state_sector ^= 1U;
+		boot_state_next = 0;
+	}
+
+	status = Flash_Program(BootState_Addr(boot_state_sector) + boot_state_next * sizeof(Boot_State_t),
+						   state, BOOT_STATE_WORDS);
+	boot_state_next++;						/**< A failed record is skipped, never rewritten	*/
+	return status;
+}
+
+/**
+  * @brief	Mark the running image as good (called by the application).
+  * @retval	FLASH_OK if confirmed (or already confirmed), FLASH_EINVAL when not
+  * 		running from a slot, or the error of the failed write.
+  * @note	Ends the trial of a new image: it will not be rolled back.
+  */
+Flash_Status_t BootState_Confirm(void)
+{
+	const uint8_t slot = Image_SlotOf(SCB->VTOR);
+	Boot_State_t state;
+
+	if (slot == IMAGE_SLOT_NONE)
+		return FLASH_EINVAL;
+
+	CRC_Init();								/**< The application may not have enabled it	*/
+	BootState_Load(&state);
+	if (state.confirmed == slot && state.trial != slot)
+		return FLASH_OK;
+
+	state.confirmed = slot;
+	if (state.trial == slot)
+	{
+		state.trial = IMAGE_SLOT_NONE;
+		state.attempts = 0;
+	}
+	return BootState_Save(&state);
+}
+
+/**
+  * @brief	Find the last valid record of a sector and the first free one.
+  * @param[in] sector	0 or 1.
+  * @param[out] next	Index after the last programmed record.
+  * @retval	Last valid record, or NULL.
+  */
+static const Boot_State_t *BootState_Scan(uint8_t sector, uint32_t *next)
+{
+	const Boot_State_t *record = (const Boot_State_t *)BootState_Addr(sector);
+	uint32_t n = 0;
+
+	while (n < BOOT_STATE_RECORDS && record[n].magic != BOOT_STATE_BLANK)
+		n++;
+	*next = n;
+
+	while (n--)								/**< A torn last record falls back to the one before	*/
+		if (record[n].magic == BOOT_STATE_MAGIC
+		 && CRC_Words((const uint32_t *)&record[n], BOOT_STATE_WORDS - 1U) == record[n].crc)
+			return &record[n];
+	return NULL;
+}
+
+/**
+  * @brief	Address of a state sector.
+  */
+static uint32_t BootState_Addr(uint8_t sector)
+{
+	return sector ? BOOT_STATE_ADDR1 : BOOT_STATE_ADDR0;
+}
@@ -7,12 +7,25 @@
   * 		and SysTick timer, then enters the main loop toggling the red LED
   * 		every 1 second.
   *
+  * 		The Slot-A and Slot-B configurations (BOOT_SLOT) link the image
+  * 		behind the 15-Bootloader image header and confirm the boot once the
+  * 		start-up self-check passed; the orange LED marks an unconfirmed boot.
+  *
   * @note	Uses CMSIS-only style (no HAL).
   */
 
 #include "system.h"
 #include "stm32f407g_disc1.h"
 #include "systick.h"
+#include "selftest.h"
+#if defined(BOOT_SLOT)
+#include "boot_state.h"
+
+#define MAIN_TICK_SPIN_MAX	1000000UL	/**< Loop bound for one 1 ms SysTick tick		*/
+
+/**************************  Static Function Prototypes  ***************************/
+static uint8_t Main_SelfCheck(void);
+#endif /* BOOT_SLOT */
 
 /**
   * @brief	Application entry point.
@@ -21,7 +34,8 @@
   * 		1. Initializes system clock and core peripherals.
   * 		2. Initializes board support package (LEDs).
   * 		3. Initializes SysTick for millisecond timing.
-  * 		4. Enters an infinite loop where the red LED is toggled every 1 second.
+  * 		4. Slot builds: confirms the boot to the bootloader after the self-check.
+  * 		5. Enters an infinite loop where the red LED is toggled every 1 second.
   *
   * @param	None
   * @retval int		Always returns 0 (though this function never exits).
@@ -31,11 +45,40 @@ int main(void)
 	System_Init();						/**< Initialize system configuration		*/
 	BSP_LED_Init();						/**< Initialize LEDs on the board			*/
 	SysTick_Init(1000, SYSTICK_CMSIS);	/**< Initialize SysTick using CMSIS			*/
+#if defined(QEMU_SELFTEST)
+	SelfTest_Run();						/**< QEMU-Test build: check and exit		*/
+#endif /* QEMU_SELFTEST */
+#if defined(BOOT_SLOT)
+	if (!Main_SelfCheck() || BootState_Confirm() != FLASH_OK)
+		BSP_LED_On(LED_ORANGE);			/**< Not confirmed: rolled back after 3 boots	*/
+#endif /* BOOT_SLOT */
 
 	/**< Main loop */
 	while (1)
 	{
 		BSP_LED_Toggle(LED_RED);	/**< Toggle the LED	*/
 		SysTick_delay_ms(1000);		/**< 1 second delay	*/
+#if defined(BOOT_SLOT)
+		IWDG->KR = 0xAAAAU;			/**< Reload the bootloader's trial watchdog (4 s)	*/
+#endif /* BOOT_SLOT */
 	}
 }
+
+#if defined(BOOT_SLOT)
+/**
+  * @brief	Start-up self-check of a slot build.
+  * @retval	1 when the PLL drives SYSCLK and SysTick interrupts arrive, 0 otherwise.
+  */
+static uint8_t Main_SelfCheck(void)
+{
+	const uint32_t t0 = SysTick_GetTick();
+	uint32_t spin = 0;
+
+	if ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL)
+		return 0;
+
+	while (SysTick_GetTick() == t0 && spin < MAIN_TICK_SPIN_MAX)
+		spin++;
+	return (SysTick_GetTick() != t0) ? 1U : 0U;
+}
+#endif /* BOOT_SLOT */
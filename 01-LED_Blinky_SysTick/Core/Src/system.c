@@ -6,12 +6,14 @@
   * 		This file contains:
   * 		 - NVIC priority grouping macros
   *			 - Serial Wire Debug (SWD) interface configuration
-  * 		 - System Clock configurations
+  * 		 - System Clock configurations (flash wait states via flash.h)
+  * 		 - QEMU (netduinoplus2) start-up path, selected by QEMU_NETDUINOPLUS2
   *
   * Target	STM32F407VGT6
   */
 
 #include "system.h"
+#include "flash.h"
 
 /************************  NVIC Priority Group Definitions  ************************/
 #define NVIC_PRIORITYGROUP_0	0x7UL	/**< 0 bits for pre-emption priority, 4 bits for subpriority */
@@ -25,10 +27,13 @@
 #define PLL_N		168UL			/**< PLL multiplication factor for VCO				*/
 #define PLL_P		2UL				/**< PLL division factor for main system clock		*/
 #define PLL_Q		7UL				/**< PLL division factor for USB clock				*/
+#define SYSTEM_HCLK_HZ	((HSE_VALUE / PLL_M) * PLL_N / PLL_P)	/**< Resulting HCLK (AHB prescaler /1)	*/
 
 /**************************  Static Function Prototypes  ***************************/
+#if !defined(QEMU_NETDUINOPLUS2)
 static void System_SWD_Init(void);
 static void System_Clock_Config(void);
+#endif /* QEMU_NETDUINOPLUS2 */
 
 /**
   * @brief	Sets NVIC priority grouping, initializes SWD, configures system clock, and updates SystemCoreClock variable.
@@ -39,11 +44,18 @@ static void System_Clock_Config(void);
 void System_Init(void)
 {
 	NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);	/**< NVIC: 4 preemptive, 0 sub-priority bits  */
+#if defined(QEMU_NETDUINOPLUS2)
+	/* RCC, PWR, FLASH and DBGMCU are not emulated: HSE/PLL ready flags never set */
+	SystemCoreClock = QEMU_SYSCLK_HZ;				/**< SYSCLK is fixed by the QEMU machine	  */
+#else
 	System_SWD_Init();								/**< Enable Serial Wire Debug				  */
 	System_Clock_Config();							/**< Clock configuration					  */
 	SystemCoreClockUpdate();						/**< Update SystemCoreClock variable		  */
+#endif /* QEMU_NETDUINOPLUS2 */
 }
 
+#if !defined(QEMU_NETDUINOPLUS2)
+
 /**
   * @brief	Initializes Serial Wire Debug (SWD) Interface on PA13 and PA14.
   * @param	None
@@ -84,10 +96,8 @@ static void System_Clock_Config(void)
 
 	PWR->CR |= PWR_CR_VOS;					/**< Set voltage regulator to default value		*/
 
-	FLASH->ACR |= FLASH_ACR_ICEN			/**< Enable instruction cache					*/
-			   |  FLASH_ACR_PRFTEN			/**< Enable FLASH prefetch buffer				*/
-			   |  FLASH_ACR_DCEN			/**< Enable data cache							*/
-			   |  FLASH_ACR_LATENCY_5WS;	/**< Set latency on 5 wait states for 168 MHz	*/
+	Flash_SetLatencyForClock(SYSTEM_HCLK_HZ, FLASH_VRANGE_BOARD);	/**< Minimum wait states, before raising HCLK	*/
+	Flash_SetProfile(FLASH_PROFILE_LINEAR);	/**< Reset caches, enable I/D cache and prefetch	*/
 
 	RCC->CFGR |= RCC_CFGR_HPRE_DIV1			/**< AHB  prescaler => /1						*/
 			  |  RCC_CFGR_PPRE1_DIV4		/**< APB1 prescaler => /4						*/
@@ -109,3 +119,4 @@ static void System_Clock_Config(void)
 
 	RCC->CR |= RCC_CR_CSSON;				/**< Enable clock security system (CSS)			*/
 }
+#endif /* QEMU_NETDUINOPLUS2 */
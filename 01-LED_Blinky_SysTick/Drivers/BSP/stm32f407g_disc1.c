@@ -18,6 +18,8 @@
   * 	  with software debounce support using TIM7.
   * 	- The BSP_Button_Callback() is declared as a weak function and can be
   * 	  overridden by the user application.
+  * 	- QEMU builds (QEMU_NETDUINOPLUS2) debounce on TIM4 and treat a software
+  * 	  trigger of EXTI0 (EXTI->SWIER) as a button press, since GPIO is not emulated.
   *
   * @attention
   * 	This module is designed for CMSIS-level bare-metal projects and does NOT
@@ -49,6 +51,11 @@ static const uint16_t LED_PIN[LEDn] = {
 		LED_RED_PIN,
 		LED_BLUE_PIN
 };
+
+#if defined(QEMU_NETDUINOPLUS2)
+/** @brief	Virtual button level, latched by EXTI0 and released after the debounce check. */
+static volatile uint8_t qemu_button_pressed = 0;
+#endif /* QEMU_NETDUINOPLUS2 */
 /**
   * @}
   */
@@ -78,7 +85,7 @@ void BSP_LED_Init(void)
 		LED_GPIO_PORT->MODER &= ~(3UL << (LED_PIN[i] * 2));		/**< Clear mode bits		*/
 		LED_GPIO_PORT->MODER |=  (1UL << (LED_PIN[i] * 2));		/**< Set pin as output		*/
 		LED_GPIO_PORT->OTYPER &= ~(1UL << LED_PIN[i]);			/**< Configure as push-pull	*/
-		LED_GPIO_PORT->OSPEEDR &= ~(3UL << LED_PIN[i]);			/**< Configure as low speed	*/
+		LED_GPIO_PORT->OSPEEDR &= ~(3UL << (LED_PIN[i] * 2));		/**< Configure as low speed	*/
 	}
 }
 
@@ -174,7 +181,11 @@ void BSP_Button_Init(ButtonMode_TypeDef Mode)
   */
 uint8_t BSP_Button_Read(void)
 {
+#if defined(QEMU_NETDUINOPLUS2)
+	return qemu_button_pressed;		/**< GPIO is not emulated: report the latched EXTI0 trigger	*/
+#else
 	return ((BUTTON_GPIO_PORT->IDR & (1UL << BUTTON_PIN)) != 0) ? 1 : 0;	/**< Return pressed state	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 }
 
 /**
@@ -236,7 +247,7 @@ void BSP_Button_NVIC_Init(void)
 }
 
 /**
-  * @brief	Initialize TIM7 debounce timer.
+  * @brief	Initialize TIM7 debounce timer (TIM4 in QEMU builds).
   * @details	This function:
   * 				- Configures TIM7 in one-pulse mode with a 1kHz tick to generate
   * 				  a software debounce interval defined by BUTTON_DEBOUNCE_MS.
@@ -248,16 +259,16 @@ void BSP_Button_NVIC_Init(void)
   */
 static void BSP_Button_DebounceTimer_Init(void)
 {
-	RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;				/**< Enable TIM7 clock			*/
+	BUTTON_DEBOUNCE_TIM_CLK_EN();					/**< Enable debounce timer clock	*/
 
-	TIM7->PSC = (SystemCoreClock / 1000) - 1;		/**< 1 kHz tick (1 ms)			*/
-	TIM7->ARR = BUTTON_DEBOUNCE_MS;					/**< Debounce interval			*/
-	TIM7->CR1 |= TIM_CR1_OPM;						/**< One-pulse mode				*/
-	TIM7->DIER |= TIM_DIER_UIE;						/**< Enable update interrupt	*/
+	BUTTON_DEBOUNCE_TIM->PSC = BUTTON_DEBOUNCE_TIM_PSC;							/**< 1 kHz tick (1 ms)			*/
+	BUTTON_DEBOUNCE_TIM->ARR = BUTTON_DEBOUNCE_TIM_ARR(BUTTON_DEBOUNCE_MS);		/**< Debounce interval			*/
+	BUTTON_DEBOUNCE_TIM->CR1 |= TIM_CR1_OPM;		/**< One-pulse mode				*/
+	BUTTON_DEBOUNCE_TIM->DIER |= TIM_DIER_UIE;		/**< Enable update interrupt	*/
 
 	uint32_t PG = NVIC_GetPriorityGrouping();		/**< Get priority grouping	*/
-	NVIC_SetPriority(TIM7_IRQn, NVIC_EncodePriority(PG, 0x0F, 0));		/**< Set interrupt priority	*/
-	NVIC_EnableIRQ(TIM7_IRQn);						/**< Enable IRQ	*/
+	NVIC_SetPriority(BUTTON_DEBOUNCE_TIM_IRQn, NVIC_EncodePriority(PG, 0x0F, 0));		/**< Set interrupt priority	*/
+	NVIC_EnableIRQ(BUTTON_DEBOUNCE_TIM_IRQn);		/**< Enable IRQ	*/
 }
 
 /**
@@ -284,25 +295,34 @@ void EXTI0_IRQHandler(void)
 	{
 		EXTI->PR = (1 << BUTTON_PIN);		/**< Clear pending flag	*/
 		EXTI->IMR &= ~(1 << BUTTON_PIN);	/**< Disable EXTI line	*/
-		TIM7->CNT = 0;						/**< Reset counter		*/
-		TIM7->CR1 |= TIM_CR1_CEN;			/**< Start TIM7			*/
+#if defined(QEMU_NETDUINOPLUS2)
+		qemu_button_pressed = 1;			/**< Latch virtual press	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+		BUTTON_DEBOUNCE_TIM->CNT = 0;				/**< Reset counter		*/
+		BUTTON_DEBOUNCE_TIM->CR1 |= TIM_CR1_CEN;	/**< Start debounce timer	*/
 	}
 }
 
 /**
-  * @brief	TIM7 Interrupt Handler for debounce.
+  * @brief	TIM7 Interrupt Handler for debounce (TIM4 in QEMU builds).
   * @details	Clear update flag, re-enables EXTI line, calls button callback if pressed.
   */
-void TIM7_IRQHandler(void)
+void BUTTON_DEBOUNCE_TIM_IRQHandler(void)
 {
-	if (TIM7->SR & TIM_SR_UIF)				/**< Check update flag		*/
+	if (BUTTON_DEBOUNCE_TIM->SR & TIM_SR_UIF)		/**< Check update flag		*/
 	{
-		TIM7->SR &= ~TIM_SR_UIF;			/**< Clear update flag		*/
+		BUTTON_DEBOUNCE_TIM->SR &= ~TIM_SR_UIF;		/**< Clear update flag		*/
+#if defined(QEMU_NETDUINOPLUS2)
+		BUTTON_DEBOUNCE_TIM->CR1 &= ~TIM_CR1_CEN;	/**< Stop timer: one-pulse mode is not emulated	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 		EXTI->IMR |= (1 << BUTTON_PIN);		/**< Re-enable EXTI line	*/
 
 		if (BSP_Button_Read()) {			/**< If button still pressed */
 			BSP_Button_Callback();			/**< Call button callback	*/
 		}
+#if defined(QEMU_NETDUINOPLUS2)
+		qemu_button_pressed = 0;			/**< Release virtual press	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 	}
 }
 /**
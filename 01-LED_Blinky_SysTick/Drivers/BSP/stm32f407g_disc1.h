@@ -31,6 +31,9 @@ extern "C" {
 
 #include "stm32f407xx.h"
 #include "assert.h"
+#if defined(QEMU_NETDUINOPLUS2)
+#include "qemu_board.h"
+#endif /* QEMU_NETDUINOPLUS2 */
 
 /** @defgroup STM32F407G_DISC1_BSP_Exported_Types STM32F407G-DISC1 BSP Exported types
   * @{
@@ -88,6 +91,23 @@ typedef enum {
 #define BUTTON_PIN				0		/**< Pin number for user button		*/
 
 #define BUTTON_EXTI_IRQn		EXTI0_IRQn	/**< External interrupt line for user button	*/
+
+#if defined(QEMU_NETDUINOPLUS2)
+/* TIM7 is not emulated by QEMU: debounce on TIM4 clocked at QEMU_TIMER_CLK_HZ */
+#define BUTTON_DEBOUNCE_TIM				TIM4			/**< Debounce timer instance		*/
+#define BUTTON_DEBOUNCE_TIM_IRQn		TIM4_IRQn		/**< Debounce timer interrupt		*/
+#define BUTTON_DEBOUNCE_TIM_IRQHandler	TIM4_IRQHandler	/**< Debounce timer handler name	*/
+#define BUTTON_DEBOUNCE_TIM_CLK_EN()	(RCC->APB1ENR |= RCC_APB1ENR_TIM4EN)	/**< Enable timer clock	*/
+#define BUTTON_DEBOUNCE_TIM_PSC			((QEMU_TIMER_CLK_HZ / 100000UL) - 1)	/**< 100 kHz tick		*/
+#define BUTTON_DEBOUNCE_TIM_ARR(ms)		((ms) * 100UL)	/**< Ticks for a debounce interval	*/
+#else
+#define BUTTON_DEBOUNCE_TIM				TIM7			/**< Debounce timer instance		*/
+#define BUTTON_DEBOUNCE_TIM_IRQn		TIM7_IRQn		/**< Debounce timer interrupt		*/
+#define BUTTON_DEBOUNCE_TIM_IRQHandler	TIM7_IRQHandler	/**< Debounce timer handler name	*/
+#define BUTTON_DEBOUNCE_TIM_CLK_EN()	(RCC->APB1ENR |= RCC_APB1ENR_TIM7EN)	/**< Enable timer clock	*/
+#define BUTTON_DEBOUNCE_TIM_PSC			((SystemCoreClock / 1000) - 1)		/**< 1 kHz tick (1 ms)	*/
+#define BUTTON_DEBOUNCE_TIM_ARR(ms)		(ms)			/**< Ticks for a debounce interval	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 /**
   * @}
   */
@@ -19,6 +19,9 @@ extern "C" {
 #endif
 
 #include "stm32f407xx.h"
+#if defined(QEMU_NETDUINOPLUS2)
+#include "qemu_board.h"
+#endif /* QEMU_NETDUINOPLUS2 */
 
 /**
   * @brief	Initialize TIM6 for delay functions.
@@ -30,6 +33,7 @@ extern "C" {
   *	@retval	None
   *
   *	@note	This function must be called at main() before using Delay_us() or Delay_ms().
+  *	@note	QEMU builds use free-running TIM5 instead, since TIM6 is not emulated.
   */
 void Delay_Init(void);
 
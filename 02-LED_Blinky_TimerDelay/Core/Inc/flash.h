@@ -0,0 +1,116 @@
+/**
+  * @file	flash.h
+  * @author	Parham Estiri
+  * @brief	Flash interface performance configuration (wait states and ART accelerator).
+  *
+  * 		This module provides:
+  * 		 - Minimum wait-state (LATENCY) selection from HCLK and supply voltage
+  * 		 - Instruction/data cache enable, disable and reset
+  * 		 - Prefetch buffer control, selectable per workload
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Supply voltage range (RM0090, "Number of wait states according to CPU clock").
+  */
+typedef enum {
+	FLASH_VRANGE_1V8_2V1	= 0,	/**< 1.8 V - 2.1 V: 20 MHz per wait state, no prefetch	*/
+	FLASH_VRANGE_2V1_2V4	= 1,	/**< 2.1 V - 2.4 V: 22 MHz per wait state				*/
+	FLASH_VRANGE_2V4_2V7	= 2,	/**< 2.4 V - 2.7 V: 24 MHz per wait state				*/
+	FLASH_VRANGE_2V7_3V6	= 3		/**< 2.7 V - 3.6 V: 30 MHz per wait state				*/
+} Flash_VRange_t;
+
+/**
+  * @brief	Accelerator workload profiles.
+  */
+typedef enum {
+	FLASH_PROFILE_LINEAR	= 0,	/**< Long straight-line code: caches and prefetch on		*/
+	FLASH_PROFILE_BRANCHY	= 1,	/**< Branch-heavy code: caches on, prefetch off (saves
+										 flash bandwidth and power on discarded prefetches)	*/
+	FLASH_PROFILE_OFF		= 2		/**< Caches and prefetch off (deterministic timing)		*/
+} Flash_Profile_t;
+
+/******************************  Constants  ******************************/
+#define FLASH_VRANGE_BOARD		FLASH_VRANGE_2V7_3V6	/**< STM32F407G-DISC1 runs at VDD = 3 V	*/
+
+#define FLASH_ACCEL_ICACHE		FLASH_ACR_ICEN		/**< Instruction cache	*/
+#define FLASH_ACCEL_DCACHE		FLASH_ACR_DCEN		/**< Data cache			*/
+#define FLASH_ACCEL_PREFETCH	FLASH_ACR_PRFTEN	/**< Prefetch buffer	*/
+#define FLASH_ACCEL_ALL			(FLASH_ACCEL_ICACHE | FLASH_ACCEL_DCACHE | FLASH_ACCEL_PREFETCH)
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Minimum number of wait states for a given HCLK and supply voltage.
+  * @param[in] hclk_hz	AHB clock in Hz.
+  * @param[in] vrange	Supply voltage range.
+  * @retval	Wait states (0 to 7).
+  */
+uint32_t Flash_GetLatency(uint32_t hclk_hz, Flash_VRange_t vrange);
+
+/**
+  * @brief	Program FLASH_ACR LATENCY and wait until it is taken into account.
+  * @param[in] latency	Wait states (0 to 7).
+  * @retval	None
+  * @note	When raising HCLK, call this before switching the clock; when
+  * 		lowering HCLK, call it after the switch.
+  */
+void Flash_SetLatency(uint32_t latency);
+
+/**
+  * @brief	Program the minimum wait states for a given HCLK and supply voltage.
+  * @param[in] hclk_hz	AHB clock in Hz.
+  * @param[in] vrange	Supply voltage range.
+  * @retval	None
+  * @note	Same ordering rule as Flash_SetLatency().
+  */
+void Flash_SetLatencyForClock(uint32_t hclk_hz, Flash_VRange_t vrange);
+
+/**
+  * @brief	Enable a set of accelerator features and disable the others.
+  * @param[in] accel	OR of FLASH_ACCEL_ICACHE, FLASH_ACCEL_DCACHE, FLASH_ACCEL_PREFETCH.
+  * @retval	None
+  * @note	Caches that are switched on are reset first, so no stale lines survive.
+  */
+void Flash_SetAccelerator(uint32_t accel);
+
+/**
+  * @brief	Apply an accelerator workload profile.
+  * @param[in] profile	Workload profile.
+  * @retval	None
+  */
+void Flash_SetProfile(Flash_Profile_t profile);
+
+/**
+  * @brief	Enable or disable the prefetch buffer only.
+  * @param[in] enable	1 to enable, 0 to disable.
+  * @retval	None
+  */
+void Flash_SetPrefetch(uint8_t enable);
+
+/**
+  * @brief	Invalidate the instruction and data caches, keeping their enable state.
+  * @param	None
+  * @retval	None
+  * @note	Call after programming or erasing flash, before executing or reading
+  * 		the modified area.
+  */
+void Flash_ResetCaches(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FLASH_H_ */
@@ -0,0 +1,51 @@
+/**
+  * @file	selftest.h
+  * @author	Parham Estiri
+  * @brief	QEMU integration self-test, reported over semihosting.
+  *
+  * 		The QEMU-Test build configuration defines QEMU_SELFTEST next to
+  * 		QEMU_NETDUINOPLUS2. main() then calls SelfTest_Run() after the
+  * 		initialization, which:
+  * 		 - times the firmware's clocks against TIM2, free-running at 1 MHz
+  * 		   as an independent reference (virtual time under -icount)
+  * 		 - checks that the interrupts are dispatched to their handlers
+  * 		 - prints one PASS/FAIL line per check (SYS_WRITE0) and ends QEMU
+  * 		   with SYS_EXIT: exit status 0 if every check passed, 1 otherwise
+  *
+  * 		Tools/qemu_test.py (repository root) runs the image and collects
+  * 		the result.
+  *
+  * @note	Needs -semihosting-config enable=on: without it the BKPT of a
+  * 		semihosting call stops the core.
+  *
+  * Target	QEMU netduinoplus2 (STM32F405RG)
+  */
+
+#ifndef SELFTEST_H_
+#define SELFTEST_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if defined(QEMU_SELFTEST)
+
+#if !defined(QEMU_NETDUINOPLUS2)
+#error "QEMU_SELFTEST needs the QEMU board shim (QEMU_NETDUINOPLUS2)"
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Run every check, report, and end the QEMU session.
+  * @retval	Does not return.
+  */
+void SelfTest_Run(void) __attribute__((noreturn));
+
+#endif /* QEMU_SELFTEST */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SELFTEST_H_ */
@@ -11,6 +11,9 @@
 
 #include "stm32f407xx.h"
 #include "system_stm32f4xx.h"
+#if defined(QEMU_NETDUINOPLUS2)
+#include "qemu_board.h"
+#endif /* QEMU_NETDUINOPLUS2 */
 
 #ifdef __cplusplus
 extern "C" {
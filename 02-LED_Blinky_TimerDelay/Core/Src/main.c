@@ -13,6 +13,7 @@
 #include "system.h"
 #include "stm32f407g_disc1.h"
 #include "delay.h"
+#include "selftest.h"
 
 /**
   * @brief	Application entry point.
@@ -31,6 +32,9 @@ int main(void)
 	System_Init();			/**< Initialize system configuration		*/
 	BSP_LED_Init();			/**< Initialize LEDs on the board			*/
 	Delay_Init();			/**< Initialize TIM6 for delays				*/
+#if defined(QEMU_SELFTEST)
+	SelfTest_Run();			/**< QEMU-Test build: check and exit		*/
+#endif /* QEMU_SELFTEST */
 
 	/**< Main loop */
 	while (1)
@@ -0,0 +1,208 @@
+/**
+  * @file	atomic.h
+  * @author	Parham Estiri
+  * @brief	Lock-free atomics and bit-band access for state shared with interrupts.
+  *
+  * 		This module provides:
+  * 		 - Word read-modify-write with LDREX/STREX: fetch-add, fetch-or,
+  * 		   fetch-and and compare-exchange. An exception between LDREX and
+  * 		   STREX clears the exclusive monitor, so STREX fails and the
+  * 		   operation is retried; no interrupt is ever masked.
+  * 		 - Single-bit writes through the bit-band alias (SRAM1/SRAM2 and
+  * 		   peripherals), done by the bus as one locked read-modify-write.
+  * 		 - Acquire/release accessors and the barrier for the points where
+  * 		   ordering matters: data before a flag, buffers before a DMA start,
+  * 		   peripheral writes before sleep or before leaving a handler.
+  *
+  * 		Cost on the Cortex-M4 (zero wait state SRAM, no retry; "+bus" is
+  * 		the peripheral bus access, a few AHB cycles on APB):
+  *
+  * 		| Primitive                     | Instructions                    | Cycles   |
+  * 		|-------------------------------|---------------------------------|----------|
+  * 		| Atomic_FetchAdd/Or/And        | LDREX, op, STREX, CBNZ          | 6        |
+  * 		| Atomic_CompareExchange        | LDREX, CMP, BNE, STREX, CBNZ    | 7        |
+  * 		| Atomic_BitSet/Clear (SRAM)    | STR to the alias                | 1 (+2)   |
+  * 		| Atomic_BitSet/Clear (periph)  | STR to the alias                | 1 (+bus) |
+  * 		| Atomic_BitRead                | LDR from the alias              | 2 (+bus) |
+  * 		| Atomic_LoadAcquire            | LDR, DMB                        | 3-4      |
+  * 		| Atomic_StoreRelease           | DMB, STR                        | 2-3      |
+  * 		| Atomic_WriteSync              | DSB (waits for buffered writes) | 1 (+bus) |
+  * 		| For comparison: PRIMASK pair  | MRS, CPSID, ..., MSR            | 3 + body, blocks all IRQs |
+  *
+  * 		A retry costs the same again and only happens when an interrupt
+  * 		arrives inside the few cycles between LDREX and STREX.
+  *
+  * @note	Bit-band covers 0x20000000-0x200FFFFF and 0x40000000-0x400FFFFF
+  * 		only: not CCM RAM (0x10000000) and not the core peripherals
+  * 		(SysTick, NVIC, SCB). Do not bit-band registers with write-1-to-clear
+  * 		bits (EXTI->PR, DMA xIFCR): the bus writes back the other bits as
+  * 		read and clears them too. Flags that are cleared by writing 0 (TIMx->SR)
+  * 		are cleared with one plain write of the inverted mask instead.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef ATOMIC_H_
+#define ATOMIC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+
+/******************************  Configuration  ******************************/
+
+/** Bit-band alias word of bit `bit` at `addr` (SRAM or peripheral region, see the note) */
+#define ATOMIC_BITBAND(addr, bit)	((volatile uint32_t *)((((uint32_t)(addr)) & 0xF0000000UL) + 0x02000000UL \
+										+ ((((uint32_t)(addr)) & 0x000FFFFFUL) << 5) + ((uint32_t)(bit) << 2)))
+
+/******************************  Inline Functions  ******************************/
+
+/**
+  * @brief	Add to a word.
+  * @param[in,out] ptr	Word.
+  * @param[in] value	Value to add (wraps).
+  * @retval	Previous value.
+  */
+static inline uint32_t Atomic_FetchAdd(volatile uint32_t *ptr, uint32_t value)
+{
+	uint32_t old;
+
+	do {
+		old = __LDREXW(ptr);
+	} while (__STREXW(old + value, ptr));
+	return old;
+}
+
+/**
+  * @brief	Set bits in a word.
+  * @param[in,out] ptr	Word.
+  * @param[in] mask		Bits to set.
+  * @retval	Previous value.
+  */
+static inline uint32_t Atomic_FetchOr(volatile uint32_t *ptr, uint32_t mask)
+{
+	uint32_t old;
+
+	do {
+		old = __LDREXW(ptr);
+	} while (__STREXW(old | mask, ptr));
+	return old;
+}
+
+/**
+  * @brief	Clear bits in a word (pass the inverted mask).
+  * @param[in,out] ptr	Word.
+  * @param[in] mask		Bits to keep.
+  * @retval	Previous value.
+  */
+static inline uint32_t Atomic_FetchAnd(volatile uint32_t *ptr, uint32_t mask)
+{
+	uint32_t old;
+
+	do {
+		old = __LDREXW(ptr);
+	} while (__STREXW(old & mask, ptr));
+	return old;
+}
+
+/**
+  * @brief	Replace a word if it still holds the expected value.
+  * @param[in,out] ptr		Word.
+  * @param[in,out] expected	Expected value; receives the current one on failure.
+  * @param[in] desired		New value.
+  * @retval	1 if replaced, 0 if the word held another value.
+  */
+static inline uint8_t Atomic_CompareExchange(volatile uint32_t *ptr, uint32_t *expected, uint32_t desired)
+{
+	uint32_t old;
+
+	do {
+		old = __LDREXW(ptr);
+		if (old != *expected)
+		{
+			__CLREX();
+			*expected = old;
+			return 0;
+		}
+	} while (__STREXW(desired, ptr));
+	return 1;
+}
+
+/**
+  * @brief	Set one bit through its bit-band alias.
+  * @param[in] addr	Word in SRAM1/SRAM2 or a peripheral register.
+  * @param[in] bit	Bit position, 0..31.
+  * @retval	None
+  */
+static inline void Atomic_BitSet(volatile void *addr, uint32_t bit)
+{
+	*ATOMIC_BITBAND(addr, bit) = 1U;
+}
+
+/**
+  * @brief	Clear one bit through its bit-band alias.
+  * @param[in] addr	Word in SRAM1/SRAM2 or a peripheral register.
+  * @param[in] bit	Bit position, 0..31.
+  * @retval	None
+  */
+static inline void Atomic_BitClear(volatile void *addr, uint32_t bit)
+{
+	*ATOMIC_BITBAND(addr, bit) = 0U;
+}
+
+/**
+  * @brief	Read one bit through its bit-band alias.
+  * @param[in] addr	Word in SRAM1/SRAM2 or a peripheral register.
+  * @param[in] bit	Bit position, 0..31.
+  * @retval	0 or 1.
+  */
+static inline uint32_t Atomic_BitRead(const volatile void *addr, uint32_t bit)
+{
+	return *ATOMIC_BITBAND(addr, bit);
+}
+
+/**
+  * @brief	Read a flag or index, then let the data it guards be read.
+  * @param[in] ptr	Word written with Atomic_StoreRelease() elsewhere.
+  * @retval	Value.
+  */
+static inline uint32_t Atomic_LoadAcquire(const volatile uint32_t *ptr)
+{
+	const uint32_t value = *ptr;
+
+	__DMB();
+	return value;
+}
+
+/**
+  * @brief	Complete the data writes, then publish a flag or index.
+  * @param[out] ptr		Word read with Atomic_LoadAcquire() elsewhere.
+  * @param[in] value	Value.
+  * @retval	None
+  * @note	The DMB also orders RAM writes before a DMA enable.
+  */
+static inline void Atomic_StoreRelease(volatile uint32_t *ptr, uint32_t value)
+{
+	__DMB();
+	*ptr = value;
+}
+
+/**
+  * @brief	Wait until all buffered writes have reached their target.
+  * @retval	None
+  * @note	Before WFI, before stopping a peripheral clock, and after clearing
+  * 		an interrupt flag at the end of a handler (otherwise the still
+  * 		pending request can enter the handler a second time).
+  */
+static inline void Atomic_WriteSync(void)
+{
+	__DSB();
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ATOMIC_H_ */
@@ -0,0 +1,145 @@
+/**
+  * @file	clock.h
+  * @author	Parham Estiri
+  * @brief	Reference-counted peripheral clock gating.
+  *
+  * 		Drivers do not write the RCC enable registers themselves. They take
+  * 		a reference on the clocks they use with Clock_Enable() and release it
+  * 		with Clock_Disable(); a clock runs while it has at least one
+  * 		reference, so drivers sharing a clock (GPIOA for the button and the
+  * 		console) need not know about each other.
+  *
+  * 		 - The counts change with LDREXB/STREXB, the enable bits through
+  * 		   their bit-band alias: no read-modify-write of an RCC register, so
+  * 		   drivers may start and stop from the main loop and from interrupts.
+  * 		 - Each reference also says whether the peripheral has to keep
+  * 		   running while the core sleeps (WFI). Clock_Init() clears every
+  * 		   peripheral bit of the *LPENR registers; only clocks with a sleep
+  * 		   reference are set again, so the others stop in sleep mode.
+  * 		 - Clock_GetActive() and Clock_GetRefs() report what is running.
+  *
+  * @note	Registers of a peripheral keep their contents while its clock is
+  * 		stopped, but can only be written with the clock running.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+
+/******************************  Configuration  ******************************/
+#define CLOCK_ID(bus, bit)		(((uint32_t)(bus) << 5) | (uint32_t)(bit))	/**< Bus, enable bit position	*/
+#define CLOCK_IDS				128U		/**< 4 buses x 32 enable bits					*/
+#define CLOCK_REFS_MAX			255U		/**< References per clock						*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Peripheral buses, in the order of the RCC enable registers.
+  */
+typedef enum {
+	CLOCK_AHB1		= 0,
+	CLOCK_AHB2		= 1,
+	CLOCK_APB1		= 2,
+	CLOCK_APB2		= 3
+} Clock_Bus_t;
+
+/**
+  * @brief	Peripheral clocks: bus and bit position of the enable bit.
+  */
+typedef enum {
+	CLOCK_GPIOA		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_GPIOAEN_Pos),
+	CLOCK_GPIOB		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_GPIOBEN_Pos),
+	CLOCK_GPIOC		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_GPIOCEN_Pos),
+	CLOCK_GPIOD		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_GPIODEN_Pos),
+	CLOCK_GPIOE		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_GPIOEEN_Pos),
+	CLOCK_CRC		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_CRCEN_Pos),
+	CLOCK_DMA1		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_DMA1EN_Pos),
+	CLOCK_DMA2		= CLOCK_ID(CLOCK_AHB1, RCC_AHB1ENR_DMA2EN_Pos),
+	CLOCK_TIM2		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_TIM2EN_Pos),
+	CLOCK_TIM3		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_TIM3EN_Pos),
+	CLOCK_TIM4		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_TIM4EN_Pos),
+	CLOCK_TIM5		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_TIM5EN_Pos),
+	CLOCK_TIM6		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_TIM6EN_Pos),
+	CLOCK_TIM7		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_TIM7EN_Pos),
+	CLOCK_SPI2		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_SPI2EN_Pos),
+	CLOCK_USART2	= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_USART2EN_Pos),
+	CLOCK_USART3	= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_USART3EN_Pos),
+	CLOCK_I2C1		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_I2C1EN_Pos),
+	CLOCK_PWR		= CLOCK_ID(CLOCK_APB1, RCC_APB1ENR_PWREN_Pos),
+	CLOCK_TIM1		= CLOCK_ID(CLOCK_APB2, RCC_APB2ENR_TIM1EN_Pos),
+	CLOCK_USART1	= CLOCK_ID(CLOCK_APB2, RCC_APB2ENR_USART1EN_Pos),
+	CLOCK_ADC1		= CLOCK_ID(CLOCK_APB2, RCC_APB2ENR_ADC1EN_Pos),
+	CLOCK_SPI1		= CLOCK_ID(CLOCK_APB2, RCC_APB2ENR_SPI1EN_Pos),
+	CLOCK_SYSCFG	= CLOCK_ID(CLOCK_APB2, RCC_APB2ENR_SYSCFGEN_Pos)
+} Clock_Id_t;
+
+/**
+  * @brief	Whether a reference keeps the clock running in sleep mode.
+  */
+typedef enum {
+	CLOCK_SLEEP_OFF	= 0,	/**< Stopped while the core sleeps (registers only, outputs hold)	*/
+	CLOCK_SLEEP_ON	= 1		/**< Keeps running: interrupts, DMA or counting during WFI			*/
+} Clock_Sleep_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Stop all peripheral clocks in sleep mode unless referenced for it.
+  * @retval	None
+  * @note	Call once at start-up, before the first Clock_Enable(). The flash
+  * 		interface and SRAM1/SRAM2 keep their sleep clocks (DMA, wake-up).
+  */
+void Clock_Init(void);
+
+/**
+  * @brief	Take a reference on a peripheral clock; starts it on the first one.
+  * @param[in] id		Peripheral clock.
+  * @param[in] sleep	CLOCK_SLEEP_ON if it has to run while the core sleeps.
+  * @retval	None
+  * @note	The peripheral can be accessed when this returns.
+  */
+void Clock_Enable(Clock_Id_t id, Clock_Sleep_t sleep);
+
+/**
+  * @brief	Release a reference; stops the clock with the last one.
+  * @param[in] id		Peripheral clock.
+  * @param[in] sleep	The value given to the matching Clock_Enable().
+  * @retval	None
+  */
+void Clock_Disable(Clock_Id_t id, Clock_Sleep_t sleep);
+
+/**
+  * @brief	Number of references on a clock.
+  * @param[in] id		Peripheral clock.
+  * @param[in] sleep	CLOCK_SLEEP_ON: count the sleep references only.
+  * @retval	References.
+  */
+uint32_t Clock_GetRefs(Clock_Id_t id, Clock_Sleep_t sleep);
+
+/**
+  * @brief	Clocks of a bus that have references.
+  * @param[in] bus		Bus.
+  * @param[in] sleep	CLOCK_SLEEP_ON: those that run in sleep mode.
+  * @retval	Mask in the layout of the bus enable register (RCC_xxxENR).
+  */
+uint32_t Clock_GetActive(Clock_Bus_t bus, Clock_Sleep_t sleep);
+
+/**
+  * @brief	Short name of a clock, e.g. "TIM7".
+  * @param[in] id	Peripheral clock.
+  * @retval	Name, or NULL for a clock not in Clock_Id_t.
+  */
+const char *Clock_Name(Clock_Id_t id);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,146 @@
+/**
+  * @file	irq_plan.h
+  * @author	Parham Estiri
+  * @brief	Interrupt plan: every interrupt with its priority, cost and rate.
+  *
+  * 		IRQ_PLAN is the only place where interrupt priorities are set.
+  * 		IrqPlan_Apply() sets the priority grouping and all priorities in
+  * 		one pass; drivers only enable their interrupts.
+  *
+  * 		Each entry declares:
+  * 		 - prio: pre-emption priority, 0 (highest) .. 15. Equal priorities
+  * 		   do not pre-empt each other.
+  * 		 - wcet: worst-case execution time in core cycles, handler entry
+  * 		   to exit. Measured values are kept by IrqPlan_Enter()/_Exit()
+  * 		   and shown by the `irqs` shell command next to the declared ones.
+  * 		 - period: minimum time between two requests, in microseconds.
+  * 		 - deadline: latest completion after the request, in microseconds.
+  *
+  * 		The plan is checked for IRQ_PLAN_SYSCLK_MIN_HZ, the slowest clock
+  * 		the firmware can switch to (HSE, 8 MHz), where cycles take longest:
+  * 		 - at build time (irq_plan.c): priorities in range, wcet within
+  * 		   the deadline, total utilization at most 100 % and the
+  * 		   response time of every entry (at most eight iterations)
+  * 		 - Tools/irq_rta.py: the same response-time analysis as a table
+  * 		   with the slack of each entry (pre-build step of every build
+  * 		   configuration, exits 1 when a deadline can be missed)
+  *
+  * @note	Keep the table in the X(...) layout below: irq_rta.py reads it.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef IRQ_PLAN_H_
+#define IRQ_PLAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define IRQ_PLAN_GROUPING		3U			/**< NVIC_PRIORITYGROUP_4: 4 pre-emption bits, no sub-priority	*/
+#define IRQ_PLAN_SYSCLK_MIN_HZ	8000000UL	/**< Slowest SYSCLK (HSE): the plan must hold there				*/
+#define IRQ_PLAN_RTA_OVERHEAD	24U			/**< Exception entry + exit cycles per activation (irq_rta.py --overhead)	*/
+#define IRQ_PLAN_RTA_BLOCKING	0U			/**< Longest interrupt-masked section elsewhere, cycles (--blocking)		*/
+
+/*
+ * name           IRQn                         prio  wcet  period  deadline
+ *                                                   (cyc)  (us)    (us)
+ *
+ * DMA1_S6: TX run complete, one byte at 115200 baud at the shortest.
+ * USART2:  idle line, at least one character and one idle frame apart.
+ * DMA1_S5: RX half/full, every UART_RX_SIZE / 2 characters.
+ * EXTI0 and the debounce timer: the line stays masked until the timer has
+ * fired, so at most once per debounce interval (1 ms minimum).
+ * RTC_WKUP: wake-up timer, two RTCCLK/16 periods (1 ms) at the shortest.
+ */
+#define IRQ_PLAN(X) \
+	X(DMA1_S6,    DMA1_Stream6_IRQn,           0x0D,  200,    87,    87) \
+	X(USART2,     USART2_IRQn,                 0x0D,  120,   174,   174) \
+	X(DMA1_S5,    DMA1_Stream5_IRQn,           0x0D,  100,  2778,  2778) \
+	X(SYSTICK,    SysTick_IRQn,                0x0E,   60,  1000,  1000) \
+	X(EXTI0,      BUTTON_EXTI_IRQn,            0x0E,  120,  1000,  1000) \
+	X(DEBOUNCE,   BUTTON_DEBOUNCE_TIM_IRQn,    0x0F,  500,  1000,  1000) \
+	X(RTC_WKUP,   RTC_WKUP_IRQn,               0x0F,   80,   976,   976)
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Plan entries, in table order.
+  */
+typedef enum {
+#define IRQ_PLAN_ID(name, irqn, prio, wcet, period, deadline)	IRQ_ID_##name,
+	IRQ_PLAN(IRQ_PLAN_ID)
+#undef IRQ_PLAN_ID
+	IRQ_IDS
+} Irq_Id_t;
+
+/**
+  * @brief	One plan entry, with the measured execution time.
+  */
+typedef struct {
+	const char	*name;
+	uint8_t		prio;
+	uint32_t	wcet;				/**< Declared, cycles						*/
+	uint32_t	period_us;
+	uint32_t	deadline_us;
+	uint32_t	measured;			/**< Longest seen, cycles (includes pre-emption)	*/
+} IrqPlan_Info_t;
+
+/******************************  Inline Functions  ******************************/
+
+/**
+  * @brief	Start timing a handler: call first thing in it.
+  * @retval	Cycle counter, for IrqPlan_Exit().
+  */
+static inline uint32_t IrqPlan_Enter(void)
+{
+	return DWT->CYCCNT;
+}
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Set the priority grouping and the priority of every planned interrupt.
+  * @retval	None
+  * @note	Called by System_Init(), before any interrupt is enabled.
+  */
+void IrqPlan_Apply(void);
+
+/**
+  * @brief	Set the planned priority of one interrupt again.
+  * @param[in] id	Plan entry.
+  * @retval	None
+  * @note	For code that overwrites it, such as SysTick_Config().
+  */
+void IrqPlan_Restore(Irq_Id_t id);
+
+/**
+  * @brief	Stop timing a handler: call last thing in it.
+  * @param[in] id		Plan entry of the handler.
+  * @param[in] start	Value from IrqPlan_Enter().
+  * @retval	None
+  */
+void IrqPlan_Exit(Irq_Id_t id, uint32_t start);
+
+/**
+  * @brief	Read a plan entry.
+  * @param[in] id		Plan entry.
+  * @param[out] info	Declared values and the measured maximum.
+  * @retval	None
+  */
+void IrqPlan_GetInfo(Irq_Id_t id, IrqPlan_Info_t *info);
+
+/**
+  * @brief	Forget the measured maxima.
+  * @retval	None
+  */
+void IrqPlan_ResetMeasured(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* IRQ_PLAN_H_ */
@@ -0,0 +1,95 @@
+/**
+  * @file	pattern.h
+  * @author	Parham Estiri
+  * @brief	Non-blocking LED patterns, adjustable at run time.
+  *
+  * 		This module provides:
+  * 		 - The clockwise LED chase of this project, plus blink and off
+  * 		 - A step period in milliseconds instead of a blocking delay, so
+  * 		   the main loop stays free for the shell
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef PATTERN_H_
+#define PATTERN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define PATTERN_PERIOD_MS		500U		/**< Default step period					*/
+#define PATTERN_PERIOD_MIN		10U			/**< Shortest step period					*/
+#define PATTERN_PERIOD_MAX		10000U		/**< Longest step period					*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	LED patterns.
+  */
+typedef enum {
+	PATTERN_OFF			= 0,	/**< All LEDs off								*/
+	PATTERN_CHASE		= 1,	/**< One LED at a time, clockwise				*/
+	PATTERN_BLINK		= 2,	/**< All LEDs together							*/
+	PATTERNS			= 3
+} Pattern_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Select a pattern (starts from its first step).
+  * @param[in] pattern	Pattern.
+  * @retval	None
+  */
+void Pattern_Set(Pattern_t pattern);
+
+/**
+  * @brief	Current pattern.
+  * @retval	Pattern.
+  */
+Pattern_t Pattern_Get(void);
+
+/**
+  * @brief	Set the step period.
+  * @param[in] ms	Period, PATTERN_PERIOD_MIN .. PATTERN_PERIOD_MAX.
+  * @retval	1 if applied, 0 if out of range.
+  */
+uint8_t Pattern_SetPeriod(uint32_t ms);
+
+/**
+  * @brief	Current step period.
+  * @retval	Period in milliseconds.
+  */
+uint32_t Pattern_GetPeriod(void);
+
+/**
+  * @brief	Name of a pattern.
+  * @param[in] pattern	Pattern.
+  * @retval	Name, as accepted by Pattern_Find().
+  */
+const char *Pattern_Name(Pattern_t pattern);
+
+/**
+  * @brief	Look up a pattern by name.
+  * @param[in] name		Name.
+  * @param[out] pattern	Pattern.
+  * @retval	1 if found, 0 otherwise.
+  */
+uint8_t Pattern_Find(const char *name, Pattern_t *pattern);
+
+/**
+  * @brief	Advance the pattern when its step is due.
+  * @param[in] now_ms	Current time in milliseconds.
+  * @retval	None
+  * @note	Call from the main loop; returns at once when nothing is due.
+  */
+void Pattern_Run(uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PATTERN_H_ */
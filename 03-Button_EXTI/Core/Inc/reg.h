@@ -0,0 +1,126 @@
+/**
+  * @file	reg.h
+  * @author	Parham Estiri
+  * @brief	Compile-time checked register field access.
+  *
+  * 		Fields are described by the CMSIS _Pos and _Msk macros. A field is
+  * 		named by its register prefix and its own name, REG_SET(RCC->PLLCFGR,
+  * 		RCC_PLLCFGR, PLLN, 168) uses RCC_PLLCFGR_PLLN_Pos/_Msk, so a field of
+  * 		another register does not exist under that prefix and fails to
+  * 		compile. All field writes given to one call expand to a single
+  * 		assignment, so the register is read and written once per call,
+  * 		at any optimization level (the fields are ORed at compile time):
+  *
+  * 		| Macro                                   | Access                              |
+  * 		|-----------------------------------------|-------------------------------------|
+  * 		| REG_WRITE(reg, prefix, f1, v1, ...)     | one store, fields not named are 0   |
+  * 		| REG_SET(reg, prefix, f1, v1, ...)       | one read-modify-write, others kept  |
+  * 		| REG_MODIFY(reg, mask, value)            | one read-modify-write from masks    |
+  * 		| REG_VAL(RCC_PLLCFGR_PLLN, v)            | field value for REG_MODIFY          |
+  *
+  * 		Up to six field/value pairs per call. A value must be a constant
+  * 		expression: one that does not fit its field stops the build
+  * 		("value too wide for RCC_PLLCFGR_PLLN") instead of spilling into
+  * 		the neighbouring field.
+  *
+  * 		GPIO registers repeat one field per pin. REG_PIN2()/REG_PIN4() build
+  * 		the field of one pin (MODER, OSPEEDR, PUPDR / AFRL, AFRH), REG_PINS2()
+  * 		the same field of several pins given as a pin mask, so a port is
+  * 		configured with one access per register whatever the number of pins.
+  *
+  * 		What this buys is fewer volatile register accesses, which the
+  * 		compiler may not merge by itself. Code size has not been compared
+  * 		(no arm-none-eabi-size before/after of the BSP_*_Init functions).
+  *
+  * @note	The pin number may be a run-time value; the value may not.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef REG_H_
+#define REG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+
+/******************************  Configuration  ******************************/
+
+/** GPIO field values */
+#define GPIO_MODE_INPUT			0U
+#define GPIO_MODE_OUTPUT		1U
+#define GPIO_MODE_AF			2U
+#define GPIO_MODE_ANALOG		3U
+
+#define GPIO_SPEED_LOW			0U
+#define GPIO_SPEED_MEDIUM		1U
+#define GPIO_SPEED_HIGH			2U
+#define GPIO_SPEED_VERY_HIGH	3U
+
+#define GPIO_PULL_NONE			0U
+#define GPIO_PULL_UP			1U
+#define GPIO_PULL_DOWN			2U
+
+/******************************  Field Values  ******************************/
+
+/** 0, or a build error with `msg` if the constant `cond` is false */
+#define REG_ASSERT(cond, msg)	(0U * sizeof(struct { _Static_assert(cond, msg); int reg_unused; }))
+
+/** Field value moved to its position; `value` must be a constant that fits */
+#define REG_VAL(field, value)	((((uint32_t)(value) << field##_Pos) & field##_Msk) \
+								 + REG_ASSERT((uint32_t)(value) <= (field##_Msk >> field##_Pos), "value too wide for " #field))
+#define REG_MSK(field, value)	(field##_Msk)
+
+/* Same, field given as register prefix and name (macro arguments are expanded when forwarded,
+   the complete CMSIS name would turn into its mask before it can be pasted) */
+#define REG_VAL_(prefix, f, value)	REG_VAL(prefix##_##f, value)
+#define REG_MSK_(prefix, f, value)	(prefix##_##f##_Msk)
+
+/** 2-bit field of one pin (MODER, OSPEEDR, PUPDR) */
+#define REG_PIN2_MSK(pin)		(3UL << ((pin) * 2U))
+#define REG_PIN2(pin, value)	(((uint32_t)(value) << ((pin) * 2U)) + REG_ASSERT((uint32_t)(value) <= 3U, "value too wide for a 2-bit pin field"))
+
+/** 4-bit field of one pin in AFR[(pin) >> 3] */
+#define REG_PIN4_MSK(pin)		(0xFUL << (((pin) & 7U) * 4U))
+#define REG_PIN4(pin, value)	(((uint32_t)(value) << (((pin) & 7U) * 4U)) + REG_ASSERT((uint32_t)(value) <= 15U, "value too wide for a 4-bit pin field"))
+
+/** 2-bit fields of all pins in a 16-bit pin mask (bit n: pin n) */
+#define REG_SPREAD1(x)			((((x) & 0xFF00UL) << 8) | ((x) & 0x00FFUL))
+#define REG_SPREAD2(x)			((((x) & 0x00F000F0UL) << 4) | ((x) & 0x000F000FUL))
+#define REG_SPREAD3(x)			((((x) & 0x0C0C0C0CUL) << 2) | ((x) & 0x03030303UL))
+#define REG_SPREAD4(x)			((((x) & 0x22222222UL) << 1) | ((x) & 0x11111111UL))
+#define REG_PINS2_MSK(pins)		(REG_SPREAD4(REG_SPREAD3(REG_SPREAD2(REG_SPREAD1((uint32_t)(pins))))) * 3U)
+#define REG_PINS2(pins, value)	(REG_SPREAD4(REG_SPREAD3(REG_SPREAD2(REG_SPREAD1((uint32_t)(pins))))) * (uint32_t)(value) \
+								 + REG_ASSERT((uint32_t)(value) <= 3U, "value too wide for a 2-bit pin field"))
+
+/******************************  Register Access  ******************************/
+
+/** One read-modify-write: bits in `mask` take `value`, the others are kept */
+#define REG_MODIFY(reg, mask, value)	((reg) = ((reg) & ~(uint32_t)(mask)) | (uint32_t)(value))
+
+/** Store field/value pairs of `prefix`, the rest of the register 0 */
+#define REG_WRITE(reg, prefix, ...)	((reg) = REG_EACH(REG_VAL_, prefix, __VA_ARGS__))
+
+/** Set field/value pairs of `prefix` in one read-modify-write */
+#define REG_SET(reg, prefix, ...)	REG_MODIFY(reg, REG_EACH(REG_MSK_, prefix, __VA_ARGS__), REG_EACH(REG_VAL_, prefix, __VA_ARGS__))
+
+/* Apply op(prefix, field, value) to each pair and OR the results */
+#define REG_EACH(op, p, ...)	(REG_CAT(REG_EACH_, REG_PAIRS(__VA_ARGS__))(op, p, __VA_ARGS__))
+#define REG_PAIRS(...)			REG_PAIRS_(__VA_ARGS__, 6, odd, 5, odd, 4, odd, 3, odd, 2, odd, 1, odd)
+#define REG_PAIRS_(a1, b1, a2, b2, a3, b3, a4, b4, a5, b5, a6, b6, n, ...)	n
+#define REG_CAT(a, b)			REG_CAT_(a, b)
+#define REG_CAT_(a, b)			a##b
+#define REG_EACH_1(op, p, f, v)			op(p, f, v)
+#define REG_EACH_2(op, p, f, v, ...)	op(p, f, v) | REG_EACH_1(op, p, __VA_ARGS__)
+#define REG_EACH_3(op, p, f, v, ...)	op(p, f, v) | REG_EACH_2(op, p, __VA_ARGS__)
+#define REG_EACH_4(op, p, f, v, ...)	op(p, f, v) | REG_EACH_3(op, p, __VA_ARGS__)
+#define REG_EACH_5(op, p, f, v, ...)	op(p, f, v) | REG_EACH_4(op, p, __VA_ARGS__)
+#define REG_EACH_6(op, p, f, v, ...)	op(p, f, v) | REG_EACH_5(op, p, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* REG_H_ */
@@ -0,0 +1,227 @@
+/**
+  * @file	rtc.h
+  * @author	Parham Estiri
+  * @brief	RTC calendar, wall-clock timestamps, calibration and wake-up timer.
+  *
+  * 		This module provides:
+  * 		 - The RTC on LSE (32.768 kHz crystal), or on LSI when the crystal
+  * 		   does not start. The calendar, the prescalers and the calibration
+  * 		   live in the backup domain: they survive a reset, and Rtc_Init()
+  * 		   leaves a running RTC alone.
+  * 		 - Calendar time with the RTC_SSR sub-second counter: 1/8192 s
+  * 		   steps on LSE (PREDIV_A 3, PREDIV_S 8191).
+  * 		 - Cheap timestamps: Rtc_TickToUnixMs() maps a SysTick millisecond
+  * 		   (trace entries, SysTick_GetTick()) to Unix time with one
+  * 		   subtraction and one addition, from an anchor taken by
+  * 		   Rtc_Sync(). Reading the calendar itself costs two consistent
+  * 		   register reads, BCD decoding and a date computation.
+  * 		 - Calibration from a measured reference: Rtc_MeasureStart()/
+  * 		   _Poll() compare the RTC against the core cycle counter (HSE
+  * 		   crystal when SYSCLK runs from HSE or the PLL), Rtc_SetCalibration()
+  * 		   applies a correction with smooth calibration (RTC_CALR, 0.95 ppm
+  * 		   steps, +-487 ppm) and, beyond that range (LSI), PREDIV_S first.
+  * 		 - The wake-up timer (EXTI line 22) for System_EnterStop(): up to
+  * 		   32 s in RTCCLK/16 steps, longer periods in whole seconds.
+  *
+  * 		STOP mode stops SysTick. The caller of System_EnterStop() adds the
+  * 		time slept, read from the RTC, with SysTick_Advance(), so the tick
+  * 		stays monotonic across low-power periods and one anchor keeps
+  * 		mapping it; Rtc_Poll() refreshes the anchor every RTC_SYNC_MS against
+  * 		the drift between the SysTick and RTC clocks.
+  *
+  * @note	Rtc_Init() needs a running SysTick (LSE start-up timeout) and may
+  * 		wait up to RTC_LSE_TIMEOUT_MS on a cold start without a crystal.
+  * 		The conversion functions and Rtc_Sync() are for thread context.
+  * 		The RTC is not emulated by QEMU: Rtc_Init() returns RTC_ENOCLOCK.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef RTC_H_
+#define RTC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define RTC_LSE_TIMEOUT_MS		2000U		/**< LSE crystal start-up (datasheet: 2 s)		*/
+#define RTC_PREDIV_A			3U			/**< Asynchronous prescaler (>= 3 for CALP)		*/
+#define RTC_LSE_HZ				32768UL
+#define RTC_LSI_HZ				32000UL		/**< Nominal; the real LSI is 17..47 kHz		*/
+#define RTC_SYNC_MS				60000UL		/**< Anchor refresh by Rtc_Poll()				*/
+#define RTC_MEASURE_S_MAX		20U			/**< Cycle counter wraps after 25 s at 168 MHz	*/
+#define RTC_WAKEUP_MS_MAX		65536000UL	/**< ck_spre steps of 1 s, 16-bit counter		*/
+#define RTC_CAL_SMOOTH_PPB		487000L		/**< Smooth calibration range, either side		*/
+#define RTC_UNIX_2000			946684800UL	/**< 2000-01-01 00:00:00 UTC in Unix seconds	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	RTC clock source.
+  */
+typedef enum {
+	RTC_SOURCE_NONE			= 0,	/**< Not running								*/
+	RTC_SOURCE_LSE			= 1,	/**< 32.768 kHz crystal							*/
+	RTC_SOURCE_LSI			= 2		/**< Internal RC, calibrate before use			*/
+} Rtc_Source_t;
+
+/**
+  * @brief	Status codes.
+  */
+typedef enum {
+	RTC_OK					= 0,
+	RTC_BUSY				= 1,	/**< Measurement still running					*/
+	RTC_ETIMEOUT			= 2,	/**< Oscillator, init mode or a flag did not come	*/
+	RTC_EINVAL				= 3,	/**< Argument out of range						*/
+	RTC_ENOCLOCK			= 4		/**< No RTC clock (no LSE or LSI, or QEMU)		*/
+} Rtc_Status_t;
+
+/**
+  * @brief	Calendar time, 2000-01-01 .. 2099-12-31, UTC.
+  */
+typedef struct {
+	uint16_t	year;				/**< 2000 .. 2099								*/
+	uint8_t		month;				/**< 1 .. 12									*/
+	uint8_t		day;				/**< 1 .. 31									*/
+	uint8_t		hour;				/**< 0 .. 23									*/
+	uint8_t		minute;
+	uint8_t		second;
+	uint8_t		weekday;			/**< 1 Monday .. 7 Sunday (set by the driver)	*/
+	uint16_t	ms;					/**< From RTC_SSR								*/
+} Rtc_DateTime_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Start the RTC, or take over the one still running from before the reset.
+  * @retval	RTC_OK or RTC_ENOCLOCK.
+  * @note	Call after SysTick_Init(). Also sets up the wake-up interrupt.
+  */
+Rtc_Status_t Rtc_Init(void);
+
+/**
+  * @brief	Clock source of the RTC.
+  * @retval	Source, RTC_SOURCE_NONE if Rtc_Init() failed.
+  */
+Rtc_Source_t Rtc_GetSource(void);
+
+/**
+  * @brief	Whether the calendar has been set since the backup domain was reset.
+  * @retval	1 if set (RTC_ISR_INITS), 0 if it still counts from 2000-01-01.
+  */
+uint8_t Rtc_IsSet(void);
+
+/**
+  * @brief	Read the calendar.
+  * @param[out] time	Date, time and milliseconds.
+  * @retval	RTC_OK or RTC_ENOCLOCK.
+  */
+Rtc_Status_t Rtc_GetTime(Rtc_DateTime_t *time);
+
+/**
+  * @brief	Set the calendar (the weekday is computed), then Rtc_Sync().
+  * @param[in] time		Date and time; ms is ignored, the second starts now.
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  */
+Rtc_Status_t Rtc_SetTime(const Rtc_DateTime_t *time);
+
+/**
+  * @brief	Read the calendar as Unix time.
+  * @retval	Milliseconds since 1970-01-01 00:00:00 UTC, 0 without an RTC.
+  */
+uint64_t Rtc_ReadUnixMs(void);
+
+/**
+  * @brief	Take a new anchor: the current SysTick time and the calendar at that instant.
+  * @retval	None
+  */
+void Rtc_Sync(void);
+
+/**
+  * @brief	Refresh the anchor every RTC_SYNC_MS; call from the main loop.
+  * @param[in] now	SysTick_GetTick().
+  * @retval	None
+  */
+void Rtc_Poll(uint32_t now);
+
+/**
+  * @brief	Convert a SysTick time to Unix time through the anchor.
+  * @param[in] tick_ms	SysTick_GetTick() value, within 24 days of the anchor.
+  * @retval	Milliseconds since 1970-01-01 00:00:00 UTC, 0 without an RTC.
+  */
+uint64_t Rtc_TickToUnixMs(uint32_t tick_ms);
+
+/**
+  * @brief	Convert Unix time to calendar time.
+  * @param[in] unix_ms	Milliseconds since 1970, 2000-01-01 or later.
+  * @param[out] time	Calendar time.
+  * @retval	None
+  */
+void Rtc_UnixToDateTime(uint64_t unix_ms, Rtc_DateTime_t *time);
+
+/**
+  * @brief	Set the frequency correction.
+  * @param[in] ppb	Correction in parts per billion; positive makes the RTC run faster.
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  * @note	Within +-RTC_CAL_SMOOTH_PPB only RTC_CALR changes and the calendar
+  * 		runs on. Beyond, PREDIV_S is changed in init mode, which restarts
+  * 		the current second (up to 1 s is lost).
+  */
+Rtc_Status_t Rtc_SetCalibration(int32_t ppb);
+
+/**
+  * @brief	Correction in effect (prescaler and smooth calibration).
+  * @retval	Parts per billion, positive: the RTC is sped up.
+  */
+int32_t Rtc_GetCalibration(void);
+
+/**
+  * @brief	Start measuring the RTC rate against the core cycle counter.
+  * @param[in] seconds	Gate time, 1 .. RTC_MEASURE_S_MAX.
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  * @note	SYSCLK must not change until the measurement ends. The result is
+  * 		only as good as the SYSCLK source: use HSE or the PLL.
+  */
+Rtc_Status_t Rtc_MeasureStart(uint32_t seconds);
+
+/**
+  * @brief	Finish the measurement once the gate time has passed.
+  * @param[out] error_ppb	Rate error of the corrected RTC, positive: fast.
+  * @retval	RTC_BUSY until then, RTC_OK, or RTC_ETIMEOUT.
+  */
+Rtc_Status_t Rtc_MeasurePoll(int32_t *error_ppb);
+
+/**
+  * @brief	Cancel a measured rate error with the calibration.
+  * @param[in] error_ppb	Error from Rtc_MeasurePoll(), positive: fast.
+  * @retval	As Rtc_SetCalibration().
+  */
+Rtc_Status_t Rtc_Trim(int32_t error_ppb);
+
+/**
+  * @brief	Start the periodic wake-up timer.
+  * @param[in] ms	Period, 1 .. RTC_WAKEUP_MS_MAX (above 32 s rounded to seconds).
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  */
+Rtc_Status_t Rtc_SetWakeup(uint32_t ms);
+
+/**
+  * @brief	Stop the wake-up timer.
+  * @retval	None
+  */
+void Rtc_StopWakeup(void);
+
+/**
+  * @brief	Wake-up timer events so far.
+  * @retval	Count.
+  */
+uint32_t Rtc_GetWakeups(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RTC_H_ */
@@ -0,0 +1,153 @@
+/**
+  * @file	shell.h
+  * @author	Parham Estiri
+  * @brief	Non-blocking command shell on the USART2 console.
+  *
+  * 		This module provides:
+  * 		 - Line input with echo, backspace and Ctrl-C, polled from the main
+  * 		   loop: interrupts only move bytes (see uart.h), all parsing runs
+  * 		   in thread context
+  * 		 - An in-place tokenizer: arguments are pointers into the line
+  * 		   buffer, split by writing '\0' over the separators. Double quotes
+  * 		   group words. No copies, no heap
+  * 		 - Dispatch by binary search in a command table sorted by name at
+  * 		   compile time (checked once by Shell_Init())
+  * 		 - Bounded work per Shell_Poll(): at most SHELL_RX_BATCH input bytes,
+  * 		   or one call of a command handler. A handler that needs more time
+  * 		   or output space returns SHELL_AGAIN and is called again on the
+  * 		   next poll, with `call` counting up
+  * 		 - Timing statistics: cycles per handler call and the longest gap
+  * 		   between two polls (the main loop's worst-case latency)
+  *
+  * @note	The command table `shell_commands[]` is defined by the application
+  * 		(shell_cmds.c).
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef SHELL_H_
+#define SHELL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define SHELL_LINE_MAX			64U			/**< Input line, including the '\0'			*/
+#define SHELL_ARGS_MAX			8U			/**< Arguments per line, command included	*/
+#define SHELL_RX_BATCH			32U			/**< Input bytes handled per Shell_Poll()	*/
+#define SHELL_PROMPT			"> "
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Result of a command handler call.
+  */
+typedef enum {
+	SHELL_OK		= 0,	/**< Done										*/
+	SHELL_AGAIN		= 1,	/**< Not done: call again on the next poll		*/
+	SHELL_EUSAGE	= 2,	/**< Bad arguments: the shell prints the usage	*/
+	SHELL_EFAIL		= 3		/**< Failed: the handler printed why			*/
+} Shell_Status_t;
+
+/**
+  * @brief	Command handler.
+  * @param[in] argc	Number of arguments, command name included.
+  * @param[in] argv	Arguments (pointers into the line buffer, valid until done).
+  * @param[in] call	0 on the first call, counts up after each SHELL_AGAIN.
+  */
+typedef Shell_Status_t (*Shell_Handler_t)(uint32_t argc, char *argv[], uint32_t call);
+
+/**
+  * @brief	Command table entry.
+  */
+typedef struct {
+	const char		*name;
+	Shell_Handler_t	handler;
+	const char		*usage;			/**< Arguments, printed after the name		*/
+	const char		*help;			/**< One-line description					*/
+} Shell_Command_t;
+
+/**
+  * @brief	Shell statistics.
+  */
+typedef struct {
+	uint32_t	lines;				/**< Non-empty lines entered					*/
+	uint32_t	errors;				/**< Unknown commands, usage errors, failures	*/
+	uint32_t	call_last;			/**< Cycles of the last handler call			*/
+	uint32_t	call_max;			/**< Cycles of the longest handler call			*/
+	uint32_t	poll_max;			/**< Longest gap between two polls, cycles		*/
+} Shell_Stats_t;
+
+/**
+  * @brief	Command table, sorted by name (strcmp order). Defined by the application.
+  */
+extern const Shell_Command_t shell_commands[];
+extern const uint32_t shell_commands_count;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Start the console, check the command table and print the prompt.
+  * @retval	None
+  */
+void Shell_Init(void);
+
+/**
+  * @brief	Handle pending input or continue the running command.
+  * @retval	None
+  * @note	Call from the main loop; never waits.
+  */
+void Shell_Poll(void);
+
+/**
+  * @brief	Look up a command.
+  * @param[in] name	Command name.
+  * @retval	Table entry, or NULL.
+  */
+const Shell_Command_t *Shell_Find(const char *name);
+
+/**
+  * @brief	Parse an unsigned number: decimal, or hexadecimal with 0x.
+  * @param[in] str		Text.
+  * @param[out] value	Number.
+  * @retval	1 if the whole text is a number that fits 32 bits, 0 otherwise.
+  */
+uint8_t Shell_ParseU32(const char *str, uint32_t *value);
+
+/**
+  * @brief	Print a string.
+  * @param[in] str	Text.
+  * @retval	None
+  */
+void Shell_Print(const char *str);
+
+/**
+  * @brief	Print an unsigned decimal.
+  * @param[in] value	Number.
+  * @retval	None
+  */
+void Shell_PrintU32(uint32_t value);
+
+/**
+  * @brief	Print 0x and a fixed number of hexadecimal digits.
+  * @param[in] value	Number.
+  * @param[in] digits	Digits, 1 .. 8.
+  * @retval	None
+  */
+void Shell_PrintHex(uint32_t value, uint32_t digits);
+
+/**
+  * @brief	Copy the shell statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void Shell_GetStats(Shell_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SHELL_H_ */
@@ -11,21 +11,81 @@
 
 #include "stm32f407xx.h"
 #include "system_stm32f4xx.h"
+#if defined(QEMU_NETDUINOPLUS2)
+#include "qemu_board.h"
+#endif /* QEMU_NETDUINOPLUS2 */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	System clock sources.
+  */
+typedef enum {
+	SYSTEM_CLOCK_HSI		= 0,	/**< 16 MHz internal RC, APB1/APB2 at 16 MHz		*/
+	SYSTEM_CLOCK_HSE		= 1,	/**< 8 MHz crystal, APB1/APB2 at 8 MHz				*/
+	SYSTEM_CLOCK_PLL		= 2		/**< 168 MHz from HSE, APB1 at 42, APB2 at 84 MHz	*/
+} System_Clock_t;
+
+/**
+  * @brief	Clock switch status.
+  */
+typedef enum {
+	SYSTEM_OK				= 0,
+	SYSTEM_ETIMEOUT			= 1,	/**< Oscillator or PLL did not become ready			*/
+	SYSTEM_EINVAL			= 2		/**< Unknown source, or not possible in this build	*/
+} System_Status_t;
+
 /******************************  Function Prototypes  ******************************/
 
 /**
-  * @brief	Sets NVIC priority grouping, initializes SWD, configures system clock, and updates SystemCoreClock variable.
+  * @brief	Moves the vector table to SRAM, applies the interrupt plan, initializes SWD, configures system clock, and updates SystemCoreClock variable.
   * @param	None
   * @retval	None
   * @note	This function must be called at the beginning of main() before using peripherals.
   */
 void System_Init(void);
 
+/**
+  * @brief	Switch SYSCLK to another source at run time.
+  * @param[in] source	New clock source.
+  * @retval	SYSTEM_OK, SYSTEM_ETIMEOUT (clock unchanged) or SYSTEM_EINVAL.
+  * @note	Updates SystemCoreClock. Everything derived from a bus clock (SysTick,
+  * 		baud rates, timer prescalers) must be reprogrammed by the caller.
+  */
+System_Status_t System_SetClock(System_Clock_t source);
+
+/**
+  * @brief	Enter STOP mode until an EXTI event (RTC wake-up, button), then restore SYSCLK.
+  * @retval	SYSTEM_OK, SYSTEM_ETIMEOUT (running on HSI) or SYSTEM_EINVAL (QEMU).
+  * @note	STOP exits on HSI with HSE and the PLL off, and SysTick does not
+  * 		count while stopped. As after System_SetClock(), the caller
+  * 		reprograms what derives from a bus clock, and adds the time slept
+  * 		with SysTick_Advance(). Wait for the UART to finish sending first.
+  */
+System_Status_t System_EnterStop(void);
+
+/**
+  * @brief	Current SYSCLK source.
+  * @retval	Clock source.
+  */
+System_Clock_t System_GetClock(void);
+
+/**
+  * @brief	Clock of the timers on APB1 (TIM2..TIM7, TIM12..TIM14).
+  * @retval	Frequency in Hz: PCLK1, doubled when the APB1 prescaler is not 1.
+  */
+uint32_t System_GetTimerClock1(void);
+
+/**
+  * @brief	APB1 peripheral clock (USART2..5, I2C, SPI2/3).
+  * @retval	Frequency in Hz.
+  */
+uint32_t System_GetPCLK1(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,92 @@
+/**
+  * @file	trace.h
+  * @author	Parham Estiri
+  * @brief	Event trace ring for post-mortem inspection from the shell.
+  *
+  * 		This module provides:
+  * 		 - A fixed ring of the last TRACE_SIZE events, each with a millisecond
+  * 		   timestamp, the cycle counter, an event code and one argument
+  * 		 - Recording from any context (thread or interrupt), in a few cycles
+  * 		 - Reading by sequence number, so a dump can be paged over several
+  * 		   calls while new events keep arriving
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define TRACE_SIZE				32U			/**< Events kept (power of two)				*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Event codes.
+  */
+typedef enum {
+	TRACE_BOOT			= 0,	/**< arg: SYSCLK in Hz							*/
+	TRACE_BUTTON		= 1,	/**< arg: press count							*/
+	TRACE_COMMAND		= 2,	/**< arg: command table index					*/
+	TRACE_CLOCK			= 3,	/**< arg: new SYSCLK in Hz						*/
+	TRACE_DEBOUNCE		= 4,	/**< arg: new interval in ms					*/
+	TRACE_PATTERN		= 5,	/**< arg: new pattern							*/
+	TRACE_POKE			= 6,	/**< arg: address written						*/
+	TRACE_STOP			= 7,	/**< arg: ms spent in STOP mode					*/
+	TRACE_DATE			= 8,	/**< arg: new Unix time in seconds				*/
+	TRACE_RTC_CAL		= 9,	/**< arg: new RTC correction in ppb (signed)	*/
+	TRACE_EVENTS		= 10
+} Trace_Event_t;
+
+/**
+  * @brief	One trace entry.
+  */
+typedef struct {
+	uint32_t	ms;					/**< SysTick time								*/
+	uint32_t	cycles;				/**< DWT cycle counter							*/
+	uint32_t	arg;
+	uint8_t		event;				/**< Trace_Event_t								*/
+} Trace_Entry_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Record an event (any context).
+  * @param[in] event	Event code.
+  * @param[in] arg		Event argument.
+  * @retval	None
+  */
+void Trace_Record(Trace_Event_t event, uint32_t arg);
+
+/**
+  * @brief	Sequence number of the next event (events recorded so far).
+  * @retval	Sequence number.
+  */
+uint32_t Trace_Head(void);
+
+/**
+  * @brief	Copy one event by sequence number.
+  * @param[in] seq		Sequence number, Trace_Head() - TRACE_SIZE .. Trace_Head() - 1.
+  * @param[out] entry	Event.
+  * @retval	1 if the event is still in the ring, 0 if overwritten or not yet recorded.
+  */
+uint8_t Trace_Get(uint32_t seq, Trace_Entry_t *entry);
+
+/**
+  * @brief	Name of an event code.
+  * @param[in] event	Event code.
+  * @retval	Short name.
+  */
+const char *Trace_Name(uint8_t event);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,110 @@
+/**
+  * @file	uart.h
+  * @author	Parham Estiri
+  * @brief	USART2 console with DMA reception and transmission.
+  *
+  * 		This module provides:
+  * 		 - Reception into a circular DMA buffer. The idle-line, half- and
+  * 		   full-transfer interrupts only publish how far DMA has written,
+  * 		   so a whole burst of characters costs a few interrupts, not one
+  * 		   per byte
+  * 		 - Transmission from a ring buffer drained by DMA. UART_Write()
+  * 		   copies and returns at once; what does not fit is dropped and
+  * 		   counted, the caller is never blocked
+  *
+  * 		| Signal    | Pin | Resource                    |
+  * 		|-----------|-----|-----------------------------|
+  * 		| TX        | PA2 | AF7                         |
+  * 		| RX        | PA3 | AF7, pull-up                |
+  * 		| USART2_RX |     | DMA1 Stream5, channel 4     |
+  * 		| USART2_TX |     | DMA1 Stream6, channel 4     |
+  *
+  * @note	QEMU builds (QEMU_NETDUINOPLUS2) have no DMA: RXNE interrupts fill
+  * 		the same ring and bytes are written straight to DR.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef UART_H_
+#define UART_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define UART_BAUD				115200UL	/**< Console baud rate							*/
+#define UART_RX_SIZE			64U			/**< Circular DMA buffer (power of two)			*/
+#define UART_TX_SIZE			512U		/**< Transmit ring (power of two)				*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Console statistics.
+  */
+typedef struct {
+	uint32_t	rx_bytes;			/**< Bytes received								*/
+	uint32_t	rx_lost;			/**< Bytes overwritten before they were read	*/
+	uint32_t	tx_bytes;			/**< Bytes queued								*/
+	uint32_t	tx_dropped;			/**< Bytes dropped: transmit ring full			*/
+} UART_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure PA2/PA3, USART2 and both DMA streams, start reception.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  */
+void UART_Init(uint32_t baud);
+
+/**
+  * @brief	Recompute the baud rate divider from the current APB1 clock.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  * @note	Call after a clock change, once UART_TxIdle() returns 1.
+  */
+void UART_SetBaud(uint32_t baud);
+
+/**
+  * @brief	Take received bytes (never waits).
+  * @param[out] dst	Destination.
+  * @param[in] max	Destination size.
+  * @retval	Bytes copied.
+  */
+uint32_t UART_Read(uint8_t *dst, uint32_t max);
+
+/**
+  * @brief	Queue bytes for transmission (never waits).
+  * @param[in] data	Bytes.
+  * @param[in] len	Number of bytes.
+  * @retval	Bytes queued; the rest was dropped.
+  */
+uint32_t UART_Write(const void *data, uint32_t len);
+
+/**
+  * @brief	Free space in the transmit ring.
+  * @retval	Bytes.
+  */
+uint32_t UART_TxFree(void);
+
+/**
+  * @brief	Whether everything queued has left the shift register.
+  * @retval	1 if idle, 0 otherwise.
+  */
+uint8_t UART_TxIdle(void);
+
+/**
+  * @brief	Copy the console statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void UART_GetStats(UART_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UART_H_ */
@@ -0,0 +1,92 @@
+/**
+  * @file	vectors.h
+  * @author	Parham Estiri
+  * @brief	SRAM vector table with handlers installed at run time.
+  *
+  * 		The flash table (g_pfnVectors, startup_stm32f407vgtx.s) binds
+  * 		handlers by weak symbol name, so a driver has to export a fixed
+  * 		global such as EXTI0_IRQHandler. Vectors_Init() copies that table
+  * 		to SRAM1 and points SCB->VTOR at the copy; from then on a driver
+  * 		installs its own static handler for its IRQn with Vectors_Install().
+  *
+  * 		 - The core fetches the handler address straight from the SRAM
+  * 		   table on exception entry: no dispatcher, no second call or
+  * 		   lookup, same latency as the flash table (SRAM1 has no wait
+  * 		   states, flash has them at 168 MHz unless the ART cache hits).
+  * 		 - A handler can be replaced while its interrupt is enabled (one
+  * 		   aligned word store, completed before Vectors_Install() returns),
+  * 		   e.g. by a timed wrapper for profiling or a stub in a test mode;
+  * 		   Vectors_Restore() puts the flash entry back.
+  * 		 - Vectors without an installed handler keep the flash entry
+  * 		   (Default_Handler, or a handler still bound by name).
+  *
+  * @note	The table is 98 words (16 exceptions, 82 interrupts) aligned to
+  * 		512 bytes, as VTOR requires. It is in SRAM1, not CCM RAM: the
+  * 		core cannot fetch vectors from CCM RAM.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef VECTORS_H_
+#define VECTORS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+
+/******************************  Configuration  ******************************/
+#define VECTORS_COUNT			(16U + (uint32_t)FPU_IRQn + 1U)	/**< Exceptions + STM32F407 interrupts		*/
+#define VECTORS_ALIGN			512U		/**< Power of two >= table size (VTOR rule)		*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Exception or interrupt handler.
+  */
+typedef void (*Vectors_Handler_t)(void);
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Copy the flash vector table to SRAM and switch VTOR to it.
+  * @retval	None
+  * @note	Called by System_Init(), before any handler is installed.
+  */
+void Vectors_Init(void);
+
+/**
+  * @brief	Install a handler for an exception or interrupt.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @param[in] handler	Handler; taken from the next exception entry on.
+  * @retval	Previous handler, or NULL if irqn is out of range (nothing installed).
+  */
+Vectors_Handler_t Vectors_Install(IRQn_Type irqn, Vectors_Handler_t handler);
+
+/**
+  * @brief	Put the flash table entry of an exception or interrupt back.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @retval	None
+  */
+void Vectors_Restore(IRQn_Type irqn);
+
+/**
+  * @brief	Handler currently in the table.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @retval	Handler, or NULL if irqn is out of range.
+  */
+Vectors_Handler_t Vectors_Get(IRQn_Type irqn);
+
+/**
+  * @brief	Whether an entry still holds the flash table handler.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @retval	1 if unchanged, 0 if a handler is installed.
+  */
+uint8_t Vectors_IsDefault(IRQn_Type irqn);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* VECTORS_H_ */
@@ -0,0 +1,162 @@
+/**
+  * @file	clock.c
+  * @author	Parham Estiri
+  * @brief	Reference-counted peripheral clock gating.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <stddef.h>
+#include "clock.h"
+#include "atomic.h"
+
+#define CLOCK_BUS(id)			((uint32_t)(id) >> 5)
+#define CLOCK_BIT(id)			((uint32_t)(id) & 31U)
+
+/** Bit-band alias of bit `bit` of the RCC register at `offset` */
+#define CLOCK_BB(offset, bit)	ATOMIC_BITBAND(RCC_BASE + (offset), bit)
+
+/** Sleep clocks left on by Clock_Init(): flash interface, SRAM1, SRAM2 */
+#define CLOCK_AHB1_SLEEP_KEEP	(RCC_AHB1LPENR_FLITFLPEN | RCC_AHB1LPENR_SRAM1LPEN | RCC_AHB1LPENR_SRAM2LPEN)
+
+/** RCC_xxxENR and RCC_xxxLPENR register of each Clock_Bus_t */
+static const uint8_t clock_enr[4] = {
+	offsetof(RCC_TypeDef, AHB1ENR), offsetof(RCC_TypeDef, AHB2ENR),
+	offsetof(RCC_TypeDef, APB1ENR), offsetof(RCC_TypeDef, APB2ENR)
+};
+static const uint8_t clock_lpenr[4] = {
+	offsetof(RCC_TypeDef, AHB1LPENR), offsetof(RCC_TypeDef, AHB2LPENR),
+	offsetof(RCC_TypeDef, APB1LPENR), offsetof(RCC_TypeDef, APB2LPENR)
+};
+
+/** Names for Clock_Name() */
+static const struct {
+	uint8_t		id;
+	char		name[7];
+} clock_names[] = {
+	{ CLOCK_GPIOA, "GPIOA" }, { CLOCK_GPIOB, "GPIOB" }, { CLOCK_GPIOC, "GPIOC" },
+	{ CLOCK_GPIOD, "GPIOD" }, { CLOCK_GPIOE, "GPIOE" }, { CLOCK_CRC, "CRC" },
+	{ CLOCK_DMA1, "DMA1" }, { CLOCK_DMA2, "DMA2" }, { CLOCK_TIM2, "TIM2" },
+	{ CLOCK_TIM3, "TIM3" }, { CLOCK_TIM4, "TIM4" }, { CLOCK_TIM5, "TIM5" },
+	{ CLOCK_TIM6, "TIM6" }, { CLOCK_TIM7, "TIM7" }, { CLOCK_SPI2, "SPI2" },
+	{ CLOCK_USART2, "USART2" }, { CLOCK_USART3, "USART3" }, { CLOCK_I2C1, "I2C1" },
+	{ CLOCK_PWR, "PWR" }, { CLOCK_TIM1, "TIM1" }, { CLOCK_USART1, "USART1" },
+	{ CLOCK_ADC1, "ADC1" }, { CLOCK_SPI1, "SPI1" }, { CLOCK_SYSCFG, "SYSCFG" }
+};
+
+static volatile uint8_t clock_refs[CLOCK_IDS];			/**< All references			*/
+static volatile uint8_t clock_sleep_refs[CLOCK_IDS];	/**< CLOCK_SLEEP_ON ones	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static void Clock_Ref(volatile uint8_t *count, volatile uint32_t *bit, int32_t delta);
+
+/**
+  * @brief	Stop all peripheral clocks in sleep mode unless referenced for it.
+  * @retval	None
+  * @note	Call once at start-up, before the first Clock_Enable(). The flash
+  * 		interface and SRAM1/SRAM2 keep their sleep clocks (DMA, wake-up).
+  */
+void Clock_Init(void)
+{
+	RCC->AHB1LPENR &= CLOCK_AHB1_SLEEP_KEEP;
+	RCC->AHB2LPENR = 0;
+	RCC->APB1LPENR = 0;
+	RCC->APB2LPENR = 0;
+}
+
+/**
+  * @brief	Take a reference on a peripheral clock; starts it on the first one.
+  * @param[in] id		Peripheral clock.
+  * @param[in] sleep	CLOCK_SLEEP_ON if it has to run while the core sleeps.
+  * @retval	None
+  * @note	The peripheral can be accessed when this returns.
+  */
+void Clock_Enable(Clock_Id_t id, Clock_Sleep_t sleep)
+{
+	Clock_Ref(&clock_refs[id], CLOCK_BB(clock_enr[CLOCK_BUS(id)], CLOCK_BIT(id)), 1);
+	if (sleep == CLOCK_SLEEP_ON)
+		Clock_Ref(&clock_sleep_refs[id], CLOCK_BB(clock_lpenr[CLOCK_BUS(id)], CLOCK_BIT(id)), 1);
+	Atomic_WriteSync();						/**< Clock running before the first access	*/
+}
+
+/**
+  * @brief	Release a reference; stops the clock with the last one.
+  * @param[in] id		Peripheral clock.
+  * @param[in] sleep	The value given to the matching Clock_Enable().
+  * @retval	None
+  */
+void Clock_Disable(Clock_Id_t id, Clock_Sleep_t sleep)
+{
+	Atomic_WriteSync();						/**< Last access done before the clock stops	*/
+	if (sleep == CLOCK_SLEEP_ON)
+		Clock_Ref(&clock_sleep_refs[id], CLOCK_BB(clock_lpenr[CLOCK_BUS(id)], CLOCK_BIT(id)), -1);
+	Clock_Ref(&clock_refs[id], CLOCK_BB(clock_enr[CLOCK_BUS(id)], CLOCK_BIT(id)), -1);
+}
+
+/**
+  * @brief	Number of references on a clock.
+  * @param[in] id		Peripheral clock.
+  * @param[in] sleep	CLOCK_SLEEP_ON: count the sleep references only.
+  * @retval	References.
+  */
+uint32_t Clock_GetRefs(Clock_Id_t id, Clock_Sleep_t sleep)
+{
+	return (sleep == CLOCK_SLEEP_ON) ? clock_sleep_refs[id] : clock_refs[id];
+}
+
+/**
+  * @brief	Clocks of a bus that have references.
+  * @param[in] bus		Bus.
+  * @param[in] sleep	CLOCK_SLEEP_ON: those that run in sleep mode.
+  * @retval	Mask in the layout of the bus enable register (RCC_xxxENR).
+  */
+uint32_t Clock_GetActive(Clock_Bus_t bus, Clock_Sleep_t sleep)
+{
+	const volatile uint8_t *count = ((sleep == CLOCK_SLEEP_ON) ? clock_sleep_refs : clock_refs) + ((uint32_t)bus << 5);
+	uint32_t mask = 0;
+
+	for (uint32_t bit = 0; bit < 32U; bit++)
+		if (count[bit])
+			mask |= 1UL << bit;
+	return mask;
+}
+
+/**
+  * @brief	Short name of a clock, e.g. "TIM7".
+  * @param[in] id	Peripheral clock.
+  * @retval	Name, or NULL for a clock not in Clock_Id_t.
+  */
+const char *Clock_Name(Clock_Id_t id)
+{
+	for (uint32_t i = 0; i < sizeof(clock_names) / sizeof(clock_names[0]); i++)
+		if (clock_names[i].id == (uint8_t)id)
+			return clock_names[i].name;
+	return NULL;
+}
+
+/**
+  * @brief	Change a reference count and set the enable bit to match it.
+  * @param[in,out] count	Reference count.
+  * @param[in] bit		Bit-band alias of the enable bit.
+  * @param[in] delta	+1 or -1; a count at 0 or CLOCK_REFS_MAX is left alone.
+  * @retval	None
+  * @note	The bit is written between LDREXB and STREXB. An interrupt that
+  * 		changes the same count in between makes the STREXB fail, so the
+  * 		interrupted caller writes the bit again from the new count: the
+  * 		last bit written always matches the stored count.
+  */
+static void Clock_Ref(volatile uint8_t *count, volatile uint32_t *bit, int32_t delta)
+{
+	uint32_t value;
+
+	do {
+		value = __LDREXB(count);
+		if ((delta < 0) ? (value == 0U) : (value == CLOCK_REFS_MAX))
+		{
+			__CLREX();						/**< Unbalanced Disable or too many references	*/
+			return;
+		}
+		value = (uint32_t)((int32_t)value + delta);
+		*bit = (value != 0U);
+	} while (__STREXB((uint8_t)value, count));
+}
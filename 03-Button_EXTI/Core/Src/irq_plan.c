@@ -0,0 +1,178 @@
+/**
+  * @file	irq_plan.c
+  * @author	Parham Estiri
+  * @brief	Interrupt plan: priorities applied at boot, build-time checks,
+  * 		measured handler times.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "irq_plan.h"
+#include "stm32f407g_disc1.h"
+
+#define IRQ_PLAN_CYCLES_PER_US	(IRQ_PLAN_SYSCLK_MIN_HZ / 1000000UL)
+#define IRQ_PLAN_PRIO_MAX		((1UL << __NVIC_PRIO_BITS) - 1UL)
+
+/*********************************  Build-Time Checks  *********************************/
+
+/* Per entry: priority in range, constrained deadline, wcet fits within it */
+#define IRQ_PLAN_CHECK(name, irqn, prio, wcet, period, deadline)								\
+	_Static_assert((prio) <= IRQ_PLAN_PRIO_MAX, "IRQ plan: priority out of range for " #name);	\
+	_Static_assert((deadline) <= (period), "IRQ plan: deadline after the next request for " #name);	\
+	_Static_assert((wcet) <= (deadline) * IRQ_PLAN_CYCLES_PER_US, "IRQ plan: wcet exceeds the deadline of " #name);
+IRQ_PLAN(IRQ_PLAN_CHECK)
+
+/* Whole plan: utilization at IRQ_PLAN_SYSCLK_MIN_HZ, in parts per million */
+#define IRQ_PLAN_PPM(name, irqn, prio, wcet, period, deadline)	\
+	+ ((uint64_t)(wcet) * 1000000ULL / ((uint64_t)(period) * IRQ_PLAN_CYCLES_PER_US))
+_Static_assert((0 IRQ_PLAN(IRQ_PLAN_PPM)) <= 1000000ULL, "IRQ plan: interrupts need more than 100 % of the CPU");
+
+/* Whole plan: response time of every entry at IRQ_PLAN_SYSCLK_MIN_HZ, as Tools/irq_rta.py.
+   R = C + B + sum of ceil(R / Tj) * Cj over the other entries of the same or a higher
+   priority, C = wcet + entry/exit overhead, iterated from R = C + B. The sequence only
+   grows: a value past the deadline is a miss, eight steps without a fixed point fail too. */
+#define IRQ_PLAN_RTA_MAX		12U			/**< Entries the analysis below covers		*/
+_Static_assert(IRQ_IDS <= IRQ_PLAN_RTA_MAX, "IRQ plan: extend IRQ_RTA_INDEX_ and IRQ_RTA_W for more entries");
+
+/* Entries as numbered constants IRQ_RTA_Pj/Cj/Tj (priority, cost, period in cycles), so the
+   sum over j can be written inside a per-entry X-macro. Unused numbers get priority 255. */
+#define IRQ_RTA_ROW(name, irqn, prio, wcet, period, deadline)	\
+	, (prio), (wcet) + IRQ_PLAN_RTA_OVERHEAD, (period) * IRQ_PLAN_CYCLES_PER_US
+#define IRQ_RTA_PAD4			255, 0, 1, 255, 0, 1, 255, 0, 1, 255, 0, 1
+#define IRQ_RTA_APPLY(m, args)	m args
+#define IRQ_RTA_INDEX(...)		IRQ_RTA_APPLY(IRQ_RTA_INDEX_, (__VA_ARGS__, IRQ_RTA_PAD4, IRQ_RTA_PAD4, IRQ_RTA_PAD4, 0))
+#define IRQ_RTA_INDEX_(z, p0, c0, t0, p1, c1, t1, p2, c2, t2, p3, c3, t3, p4, c4, t4, p5, c5, t5,	\
+					   p6, c6, t6, p7, c7, t7, p8, c8, t8, p9, c9, t9, p10, c10, t10, p11, c11, t11, ...)	\
+	IRQ_RTA_P0 = p0, IRQ_RTA_C0 = c0, IRQ_RTA_T0 = t0, IRQ_RTA_P1 = p1, IRQ_RTA_C1 = c1, IRQ_RTA_T1 = t1,			\
+	IRQ_RTA_P2 = p2, IRQ_RTA_C2 = c2, IRQ_RTA_T2 = t2, IRQ_RTA_P3 = p3, IRQ_RTA_C3 = c3, IRQ_RTA_T3 = t3,			\
+	IRQ_RTA_P4 = p4, IRQ_RTA_C4 = c4, IRQ_RTA_T4 = t4, IRQ_RTA_P5 = p5, IRQ_RTA_C5 = c5, IRQ_RTA_T5 = t5,			\
+	IRQ_RTA_P6 = p6, IRQ_RTA_C6 = c6, IRQ_RTA_T6 = t6, IRQ_RTA_P7 = p7, IRQ_RTA_C7 = c7, IRQ_RTA_T7 = t7,			\
+	IRQ_RTA_P8 = p8, IRQ_RTA_C8 = c8, IRQ_RTA_T8 = t8, IRQ_RTA_P9 = p9, IRQ_RTA_C9 = c9, IRQ_RTA_T9 = t9,			\
+	IRQ_RTA_P10 = p10, IRQ_RTA_C10 = c10, IRQ_RTA_T10 = t10, IRQ_RTA_P11 = p11, IRQ_RTA_C11 = c11, IRQ_RTA_T11 = t11
+enum { IRQ_RTA_INDEX(IRQ_PLAN(IRQ_RTA_ROW)) };
+
+/* Interference of entry j on entry `id` of priority `prio` within a response time r */
+#define IRQ_RTA_J(j, r, prio, id)	\
+	(((j) != (id) && IRQ_RTA_P##j <= (prio)) ? ((r) + IRQ_RTA_T##j - 1) / IRQ_RTA_T##j * IRQ_RTA_C##j : 0)
+#define IRQ_RTA_W(r, prio, wcet, id)	((wcet) + IRQ_PLAN_RTA_OVERHEAD + IRQ_PLAN_RTA_BLOCKING						\
+	+ IRQ_RTA_J(0, r, prio, id) + IRQ_RTA_J(1, r, prio, id) + IRQ_RTA_J(2, r, prio, id) + IRQ_RTA_J(3, r, prio, id)	\
+	+ IRQ_RTA_J(4, r, prio, id) + IRQ_RTA_J(5, r, prio, id) + IRQ_RTA_J(6, r, prio, id) + IRQ_RTA_J(7, r, prio, id)	\
+	+ IRQ_RTA_J(8, r, prio, id) + IRQ_RTA_J(9, r, prio, id) + IRQ_RTA_J(10, r, prio, id) + IRQ_RTA_J(11, r, prio, id))
+
+/* One iteration per X-macro, IRQ_RTA_Rk_<name> (pasted here: names such as USART2 are macros) */
+#define IRQ_RTA_R0(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R0_##name = (wcet) + IRQ_PLAN_RTA_OVERHEAD + IRQ_PLAN_RTA_BLOCKING,
+#define IRQ_RTA_R1(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R1_##name = IRQ_RTA_W(IRQ_RTA_R0_##name, prio, wcet, IRQ_ID_##name),
+#define IRQ_RTA_R2(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R2_##name = IRQ_RTA_W(IRQ_RTA_R1_##name, prio, wcet, IRQ_ID_##name),
+#define IRQ_RTA_R3(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R3_##name = IRQ_RTA_W(IRQ_RTA_R2_##name, prio, wcet, IRQ_ID_##name),
+#define IRQ_RTA_R4(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R4_##name = IRQ_RTA_W(IRQ_RTA_R3_##name, prio, wcet, IRQ_ID_##name),
+#define IRQ_RTA_R5(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R5_##name = IRQ_RTA_W(IRQ_RTA_R4_##name, prio, wcet, IRQ_ID_##name),
+#define IRQ_RTA_R6(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R6_##name = IRQ_RTA_W(IRQ_RTA_R5_##name, prio, wcet, IRQ_ID_##name),
+#define IRQ_RTA_R7(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R7_##name = IRQ_RTA_W(IRQ_RTA_R6_##name, prio, wcet, IRQ_ID_##name),
+#define IRQ_RTA_R8(name, irqn, prio, wcet, period, deadline)	\
+	IRQ_RTA_R8_##name = IRQ_RTA_W(IRQ_RTA_R7_##name, prio, wcet, IRQ_ID_##name),
+enum { IRQ_PLAN(IRQ_RTA_R0) IRQ_PLAN(IRQ_RTA_R1) IRQ_PLAN(IRQ_RTA_R2) };
+enum { IRQ_PLAN(IRQ_RTA_R3) IRQ_PLAN(IRQ_RTA_R4) IRQ_PLAN(IRQ_RTA_R5) };
+enum { IRQ_PLAN(IRQ_RTA_R6) IRQ_PLAN(IRQ_RTA_R7) IRQ_PLAN(IRQ_RTA_R8) };
+
+#define IRQ_RTA_CHECK(name, irqn, prio, wcet, period, deadline)												\
+	_Static_assert(IRQ_RTA_R8_##name <= (deadline) * IRQ_PLAN_CYCLES_PER_US, "IRQ plan: response time exceeds the deadline of " #name);	\
+	_Static_assert(IRQ_RTA_R8_##name > (deadline) * IRQ_PLAN_CYCLES_PER_US || IRQ_RTA_R8_##name == IRQ_RTA_R7_##name,	\
+				   "IRQ plan: response time of " #name " not settled in 8 steps, run Tools/irq_rta.py");
+IRQ_PLAN(IRQ_RTA_CHECK)
+
+/*********************************  Plan Table  *********************************/
+
+/**
+  * @brief	Plan entry as stored.
+  */
+typedef struct {
+	const char	*name;
+	int16_t		irqn;
+	uint8_t		prio;
+	uint32_t	wcet;
+	uint32_t	period_us;
+	uint32_t	deadline_us;
+} IrqPlan_Entry_t;
+
+static const IrqPlan_Entry_t irq_plan[IRQ_IDS] = {
+#define IRQ_PLAN_ENTRY(name, irqn, prio, wcet, period, deadline)	\
+	{ #name, (irqn), (prio), (wcet), (period), (deadline) },
+	IRQ_PLAN(IRQ_PLAN_ENTRY)
+#undef IRQ_PLAN_ENTRY
+};
+
+static volatile uint32_t irq_plan_measured[IRQ_IDS];	/**< Longest handler time, cycles	*/
+
+/**
+  * @brief	Set the priority grouping and the priority of every planned interrupt.
+  * @retval	None
+  * @note	Called by System_Init(), before any interrupt is enabled.
+  */
+void IrqPlan_Apply(void)
+{
+	NVIC_SetPriorityGrouping(IRQ_PLAN_GROUPING);
+	for (uint32_t id = 0; id < IRQ_IDS; id++)
+		IrqPlan_Restore((Irq_Id_t)id);
+}
+
+/**
+  * @brief	Set the planned priority of one interrupt again.
+  * @param[in] id	Plan entry.
+  * @retval	None
+  * @note	For code that overwrites it, such as SysTick_Config().
+  */
+void IrqPlan_Restore(Irq_Id_t id)
+{
+	NVIC_SetPriority((IRQn_Type)irq_plan[id].irqn, NVIC_EncodePriority(IRQ_PLAN_GROUPING, irq_plan[id].prio, 0));
+}
+
+/**
+  * @brief	Stop timing a handler: call last thing in it.
+  * @param[in] id		Plan entry of the handler.
+  * @param[in] start	Value from IrqPlan_Enter().
+  * @retval	None
+  * @note	Only the handler itself writes its entry: no locking needed.
+  */
+void IrqPlan_Exit(Irq_Id_t id, uint32_t start)
+{
+	const uint32_t cycles = DWT->CYCCNT - start;
+
+	if (cycles > irq_plan_measured[id])
+		irq_plan_measured[id] = cycles;
+}
+
+/**
+  * @brief	Read a plan entry.
+  * @param[in] id		Plan entry.
+  * @param[out] info	Declared values and the measured maximum.
+  * @retval	None
+  */
+void IrqPlan_GetInfo(Irq_Id_t id, IrqPlan_Info_t *info)
+{
+	const IrqPlan_Entry_t *e = &irq_plan[id];
+
+	info->name        = e->name;
+	info->prio        = e->prio;
+	info->wcet        = e->wcet;
+	info->period_us   = e->period_us;
+	info->deadline_us = e->deadline_us;
+	info->measured    = irq_plan_measured[id];
+}
+
+/**
+  * @brief	Forget the measured maxima.
+  * @retval	None
+  */
+void IrqPlan_ResetMeasured(void)
+{
+	for (uint32_t id = 0; id < IRQ_IDS; id++)
+		irq_plan_measured[id] = 0;
+}
@@ -1,28 +1,37 @@
 /**
   * @file	main.c
   * @author	Parham Estiri
-  * @brief	Interrupt-driven push button.
+  * @brief	Interrupt-driven push button with a UART command shell.
   *
-  * 		This file initializes the system, board support package (BSP) LEDs,
-  * 		BSP user button in interrupt mode, and TIM6 peripheral, then enters
-  * 		into the infinite loop, waiting for the EXTI0 interrupt to occur to
-  * 		call the `BSP_Button_Callback()` function.
+  * 		This file initializes the system, SysTick, board support package (BSP)
+  * 		LEDs, BSP user button in interrupt mode and the USART2 shell, then
+  * 		enters a non-blocking loop that advances the LED pattern and serves
+  * 		the shell. The EXTI0 interrupt calls `BSP_Button_Callback()`.
   *
   * @note	Uses CMSIS-only style (no HAL).
   */
 
 #include "system.h"
+#include "systick.h"
 #include "stm32f407g_disc1.h"
-#include "delay.h"
+#include "pattern.h"
+#include "shell.h"
+#include "trace.h"
+#include "rtc.h"
+#include "selftest.h"
 
 /**
   * @brief	Application entry point.
   *
   * 		The main function performs the following steps:
   * 		1. Initializes system clock and core peripherals.
-  * 		2. Initializes board support package (LEDs, button, EXTI0 for the button).
-  * 		4. Enters an infinite loop (LEDs turn on and off clockwise). Whenever the
-  * 		   button is pressed, all LEDs turn on at once.
+  * 		2. Starts the 1 ms SysTick.
+  * 		3. Initializes board support package (LEDs, button, EXTI0 for the button).
+  * 		4. Starts the shell on USART2.
+  * 		5. Starts the RTC, or keeps the one running since before the reset.
+  * 		6. Enters an infinite loop: the LED pattern (clockwise by default),
+  * 		   the shell and the RTC time anchor are polled, none of them
+  * 		   waits. Whenever the button is pressed, all LEDs turn on at once.
   *
   * @param	None
   * @retval int		Always returns 0 (though this function never exits).
@@ -30,27 +39,34 @@
 int main(void)
 {
 	System_Init();			/**< Initialize system configuration		*/
+	SysTick_Init(1000, SYSTICK_CMSIS);		/**< 1 ms tick for the pattern and the trace	*/
 	BSP_LED_Init();			/**< Initialize all LEDs on the board		*/
 	BSP_Button_Init(BUTTON_MODE_EXTI);		/**< Initialize the button with interrupt generation capability	*/
-	Delay_Init();			/**< Initialize TIM6 for delay				*/
+	Shell_Init();			/**< Start the console on USART2			*/
+	(void)Rtc_Init();		/**< Calendar on LSE, else LSI; none under QEMU	*/
+	Trace_Record(TRACE_BOOT, SystemCoreClock);
 
 	__enable_irq();			/**< Enable IRQs globally					*/
+#if defined(QEMU_SELFTEST)
+	SelfTest_Run();			/**< QEMU-Test build: check and exit		*/
+#endif /* QEMU_SELFTEST */
 
 	/**< Main loop */
 	while (1)
 	{
-		for (int i = 0; i < 4; i++) {
-			BSP_LED_On(i);
-			Delay_ms(500);
-			BSP_LED_Off(i);
-		}
+		Pattern_Run(SysTick_GetTick());
+		Shell_Poll();
+		Rtc_Poll(SysTick_GetTick());
 	}
 }
 
 void BSP_Button_Callback(void)
 {
+	static uint32_t presses;
+
 	BSP_LED_On(LED_GREEN);
 	BSP_LED_On(LED_ORANGE);
 	BSP_LED_On(LED_RED);
 	BSP_LED_On(LED_BLUE);
+	Trace_Record(TRACE_BUTTON, ++presses);
 }
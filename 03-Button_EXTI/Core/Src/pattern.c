@@ -0,0 +1,133 @@
+/**
+  * @file	pattern.c
+  * @author	Parham Estiri
+  * @brief	Non-blocking LED patterns, adjustable at run time.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <string.h>
+#include "pattern.h"
+#include "stm32f407g_disc1.h"
+
+static Pattern_t pattern_now = PATTERN_CHASE;
+static uint32_t pattern_period = PATTERN_PERIOD_MS;
+static uint32_t pattern_step;				/**< Steps taken since Pattern_Set()	*/
+static uint32_t pattern_due;				/**< Time of the next step				*/
+static uint8_t pattern_restart = 1;
+
+static const char *const pattern_names[PATTERNS] = { "off", "chase", "blink" };
+
+/**
+  * @brief	Select a pattern (starts from its first step).
+  * @param[in] pattern	Pattern.
+  * @retval	None
+  */
+void Pattern_Set(Pattern_t pattern)
+{
+	if (pattern >= PATTERNS)
+		return;
+	pattern_now = pattern;
+	pattern_restart = 1;
+}
+
+/**
+  * @brief	Current pattern.
+  * @retval	Pattern.
+  */
+Pattern_t Pattern_Get(void)
+{
+	return pattern_now;
+}
+
+/**
+  * @brief	Set the step period.
+  * @param[in] ms	Period, PATTERN_PERIOD_MIN .. PATTERN_PERIOD_MAX.
+  * @retval	1 if applied, 0 if out of range.
+  */
+uint8_t Pattern_SetPeriod(uint32_t ms)
+{
+	if (ms < PATTERN_PERIOD_MIN || ms > PATTERN_PERIOD_MAX)
+		return 0;
+	pattern_period = ms;
+	return 1;
+}
+
+/**
+  * @brief	Current step period.
+  * @retval	Period in milliseconds.
+  */
+uint32_t Pattern_GetPeriod(void)
+{
+	return pattern_period;
+}
+
+/**
+  * @brief	Name of a pattern.
+  * @param[in] pattern	Pattern.
+  * @retval	Name, as accepted by Pattern_Find().
+  */
+const char *Pattern_Name(Pattern_t pattern)
+{
+	return (pattern < PATTERNS) ? pattern_names[pattern] : "?";
+}
+
+/**
+  * @brief	Look up a pattern by name.
+  * @param[in] name	Name.
+  * @param[out] pattern	Pattern.
+  * @retval	1 if found, 0 otherwise.
+  */
+uint8_t Pattern_Find(const char *name, Pattern_t *pattern)
+{
+	for (uint32_t i = 0; i < PATTERNS; i++)
+		if (strcmp(name, pattern_names[i]) == 0)
+		{
+			*pattern = (Pattern_t)i;
+			return 1;
+		}
+	return 0;
+}
+
+/**
+  * @brief	Advance the pattern when its step is due.
+  * @param[in] now_ms	Current time in milliseconds.
+  * @retval	None
+  * @note	Call from the main loop; returns at once when nothing is due.
+  */
+void Pattern_Run(uint32_t now_ms)
+{
+	if (pattern_restart)
+	{
+		pattern_restart = 0;
+		pattern_step = 0;
+		pattern_due = now_ms;
+		for (uint32_t i = 0; i < LEDn; i++)
+			BSP_LED_Off((LED_TypeDef)i);
+	}
+	if ((int32_t)(now_ms - pattern_due) < 0)
+		return;
+	pattern_due = now_ms + pattern_period;
+
+	switch (pattern_now)
+	{
+		case PATTERN_CHASE:
+			BSP_LED_Off((LED_TypeDef)((pattern_step + LEDn - 1U) % LEDn));	/**< Previous LED	*/
+			BSP_LED_On((LED_TypeDef)(pattern_step % LEDn));
+			break;
+
+		case PATTERN_BLINK:
+			for (uint32_t i = 0; i < LEDn; i++)
+			{
+				if (pattern_step & 1U)
+					BSP_LED_Off((LED_TypeDef)i);
+				else
+					BSP_LED_On((LED_TypeDef)i);
+			}
+			break;
+
+		default:
+			break;
+	}
+	pattern_step++;
+}
@@ -0,0 +1,734 @@
+/**
+  * @file	rtc.c
+  * @author	Parham Estiri
+  * @brief	RTC calendar, wall-clock timestamps, calibration and wake-up timer.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "rtc.h"
+#include "systick.h"
+#include "clock.h"
+#include "atomic.h"
+#include "reg.h"
+#include "vectors.h"
+#include "irq_plan.h"
+
+#define RTC_PREDIV_S_LSE		((RTC_LSE_HZ / (RTC_PREDIV_A + 1U)) - 1U)	/**< 8191: 1 Hz from LSE	*/
+#define RTC_PREDIV_S_LSI		((RTC_LSI_HZ / (RTC_PREDIV_A + 1U)) - 1U)	/**< 7999: 1 Hz from LSI	*/
+#define RTC_PREDIV_S_MAX		0x7FFFU
+
+#define RTC_CAL_WINDOW			(1L << 20)	/**< Smooth calibration cycle, RTCCLK periods	*/
+#define RTC_CAL_MIN_PPB			(-500000000L)	/**< Correction limits: LSI 17 .. 47 kHz	*/
+#define RTC_CAL_MAX_PPB			1000000000L
+#define RTC_PPB					1000000000LL
+
+#define RTC_SOURCE_LSE_SEL		1U			/**< RCC_BDCR RTCSEL values						*/
+#define RTC_SOURCE_LSI_SEL		2U
+#define RTC_WUCKSEL_DIV16		0U			/**< Wake-up clock: RTCCLK / 16					*/
+#define RTC_WUCKSEL_SPRE		4U			/**< Wake-up clock: ck_spre (1 Hz)				*/
+#define RTC_WUT_MAX				65536UL		/**< Wake-up counter periods					*/
+#define RTC_EXTI_WAKEUP			22U			/**< EXTI line of the wake-up timer				*/
+#define RTC_READY_TIMEOUT		100000UL	/**< Polls for LSI, init mode, WUTWF, an SSR edge	*/
+
+/** Clear rc_w0 flags of RTC_ISR, leaving INIT as it is */
+#define RTC_CLEAR(flags)		(RTC->ISR = ~((flags) | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT))
+
+static Rtc_Source_t rtc_source;
+static uint32_t rtc_prediv_s;				/**< Current PREDIV_S							*/
+static volatile uint32_t rtc_wakeups;
+
+static uint8_t rtc_anchored;
+static uint32_t rtc_anchor_tick;			/**< SysTick time of the anchor					*/
+static uint64_t rtc_anchor_us;				/**< Unix time at the start of that tick		*/
+
+static uint64_t rtc_meas_ticks;				/**< Sub-second ticks at the gate start			*/
+static uint32_t rtc_meas_cycles;			/**< Cycle counter at the gate start			*/
+static uint32_t rtc_meas_gate;				/**< Gate length, cycles						*/
+
+static const uint8_t rtc_month_days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+static const uint16_t rtc_month_before[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+/**************************  Static Function Prototypes  ***************************/
+#if !defined(QEMU_NETDUINOPLUS2)
+static Rtc_Source_t Rtc_Start(void);
+static uint8_t Rtc_WaitLsi(void);
+#endif /* QEMU_NETDUINOPLUS2 */
+static void Rtc_Unlock(void);
+static void Rtc_Lock(void);
+static uint8_t Rtc_EnterInit(void);
+static void Rtc_ExitInit(void);
+static void Rtc_Read(uint32_t *tr, uint32_t *dr, uint32_t *ssr);
+static uint32_t Rtc_Seconds(uint32_t tr, uint32_t dr);
+static uint64_t Rtc_ReadUs(void);
+static uint8_t Rtc_Edge(uint64_t *ticks, uint32_t *cycles);
+static uint32_t Rtc_Days(uint32_t year, uint32_t month, uint32_t day);
+static uint8_t Rtc_DaysInMonth(uint32_t year, uint32_t month);
+static void Rtc_Encode(const Rtc_DateTime_t *time, uint32_t *tr, uint32_t *dr);
+static int32_t Rtc_RatioPpb(int64_t num, int64_t den);
+static uint32_t Rtc_NominalHz(void);
+static void Rtc_Wakeup_IRQHandler(void);
+
+/**
+  * @brief	Start the RTC, or take over the one still running from before the reset.
+  * @retval	RTC_OK or RTC_ENOCLOCK.
+  * @note	Call after SysTick_Init(). Also sets up the wake-up interrupt.
+  */
+Rtc_Status_t Rtc_Init(void)
+{
+#if defined(QEMU_NETDUINOPLUS2)
+	return RTC_ENOCLOCK;							/**< No RTC in the netduinoplus2 machine	*/
+#else
+	Clock_Enable(CLOCK_PWR, CLOCK_SLEEP_OFF);
+	PWR->CR |= PWR_CR_DBP;							/**< Backup domain writable from now on		*/
+	Clock_Disable(CLOCK_PWR, CLOCK_SLEEP_OFF);		/**< DBP keeps its value without the clock	*/
+
+	rtc_source = Rtc_Start();
+	if (rtc_source == RTC_SOURCE_NONE)
+		return RTC_ENOCLOCK;
+	rtc_prediv_s = (RTC->PRER & RTC_PRER_PREDIV_S) >> RTC_PRER_PREDIV_S_Pos;
+
+	Atomic_BitSet(&EXTI->RTSR, RTC_EXTI_WAKEUP);	/**< Wake-up timer: rising edge on line 22	*/
+	Atomic_BitSet(&EXTI->IMR, RTC_EXTI_WAKEUP);
+	Vectors_Install(RTC_WKUP_IRQn, Rtc_Wakeup_IRQHandler);
+	NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+	Rtc_Sync();
+	return RTC_OK;
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+/**
+  * @brief	Clock source of the RTC.
+  * @retval	Source, RTC_SOURCE_NONE if Rtc_Init() failed.
+  */
+Rtc_Source_t Rtc_GetSource(void)
+{
+	return rtc_source;
+}
+
+/**
+  * @brief	Whether the calendar has been set since the backup domain was reset.
+  * @retval	1 if set (RTC_ISR_INITS), 0 if it still counts from 2000-01-01.
+  */
+uint8_t Rtc_IsSet(void)
+{
+	return rtc_source != RTC_SOURCE_NONE && (RTC->ISR & RTC_ISR_INITS) != 0U;
+}
+
+/**
+  * @brief	Read the calendar.
+  * @param[out] time	Date, time and milliseconds.
+  * @retval	RTC_OK or RTC_ENOCLOCK.
+  */
+Rtc_Status_t Rtc_GetTime(Rtc_DateTime_t *time)
+{
+	if (rtc_source == RTC_SOURCE_NONE)
+		return RTC_ENOCLOCK;
+
+	Rtc_UnixToDateTime(Rtc_ReadUs() / 1000U, time);
+	return RTC_OK;
+}
+
+/**
+  * @brief	Set the calendar (the weekday is computed), then Rtc_Sync().
+  * @param[in] time		Date and time; ms is ignored, the second starts now.
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  */
+Rtc_Status_t Rtc_SetTime(const Rtc_DateTime_t *time)
+{
+	uint32_t tr, dr;
+
+	if (rtc_source == RTC_SOURCE_NONE)
+		return RTC_ENOCLOCK;
+	if (time->year < 2000U || time->year > 2099U || time->month < 1U || time->month > 12U
+		|| time->day < 1U || time->day > Rtc_DaysInMonth(time->year, time->month)
+		|| time->hour > 23U || time->minute > 59U || time->second > 59U)
+		return RTC_EINVAL;
+
+	Rtc_Encode(time, &tr, &dr);
+	Rtc_Unlock();
+	if (!Rtc_EnterInit())
+	{
+		Rtc_Lock();
+		return RTC_ETIMEOUT;
+	}
+	RTC->TR = tr;
+	RTC->DR = dr;
+	Rtc_ExitInit();
+	Rtc_Lock();
+
+	Rtc_Sync();
+	return RTC_OK;
+}
+
+/**
+  * @brief	Read the calendar as Unix time.
+  * @retval	Milliseconds since 1970-01-01 00:00:00 UTC, 0 without an RTC.
+  */
+uint64_t Rtc_ReadUnixMs(void)
+{
+	return (rtc_source == RTC_SOURCE_NONE) ? 0U : Rtc_ReadUs() / 1000U;
+}
+
+/**
+  * @brief	Take a new anchor: the current SysTick time and the calendar at that instant.
+  * @retval	None
+  * @note	The SysTick down-counter gives the part of the current tick that
+  * 		has passed, so the anchor is the Unix time at the start of the tick.
+  */
+void Rtc_Sync(void)
+{
+	uint32_t tick, elapsed;
+	uint64_t us;
+
+	if (rtc_source == RTC_SOURCE_NONE)
+		return;
+
+	do {
+		tick    = SysTick_GetTick();
+		elapsed = SysTick->LOAD - SysTick->VAL;
+		us      = Rtc_ReadUs();
+	} while (tick != SysTick_GetTick());			/**< A tick in between: VAL has reloaded	*/
+
+	rtc_anchor_tick = tick;
+	rtc_anchor_us   = us - (uint64_t)elapsed * 1000U / (SysTick->LOAD + 1U);
+	rtc_anchored    = 1;
+}
+
+/**
+  * @brief	Refresh the anchor every RTC_SYNC_MS; call from the main loop.
+  * @param[in] now	SysTick_GetTick().
+  * @retval	None
+  */
+void Rtc_Poll(uint32_t now)
+{
+	if (rtc_anchored && now - rtc_anchor_tick >= RTC_SYNC_MS)
+		Rtc_Sync();
+}
+
+/**
+  * @brief	Convert a SysTick time to Unix time through the anchor.
+  * @param[in] tick_ms	SysTick_GetTick() value, within 24 days of the anchor.
+  * @retval	Milliseconds since 1970-01-01 00:00:00 UTC, 0 without an RTC.
+  */
+uint64_t Rtc_TickToUnixMs(uint32_t tick_ms)
+{
+	if (!rtc_anchored)
+		return 0;
+	return (uint64_t)((int64_t)rtc_anchor_us + (int64_t)(int32_t)(tick_ms - rtc_anchor_tick) * 1000) / 1000U;
+}
+
+/**
+  * @brief	Convert Unix time to calendar time.
+  * @param[in] unix_ms	Milliseconds since 1970, 2000-01-01 or later.
+  * @param[out] time	Calendar time.
+  * @retval	None
+  */
+void Rtc_UnixToDateTime(uint64_t unix_ms, Rtc_DateTime_t *time)
+{
+	const uint32_t seconds = (uint32_t)(unix_ms / 1000U) - RTC_UNIX_2000;
+	uint32_t days = seconds / 86400U, sod = seconds % 86400U;
+	uint32_t year = 2000U + 4U * (days / 1461U), month = 1;
+
+	time->weekday = (uint8_t)((days + 5U) % 7U + 1U);	/**< 2000-01-01 was a Saturday	*/
+	days %= 1461U;
+	for (uint32_t length = 366U; days >= length; length = 365U)
+	{
+		days -= length;
+		year++;
+	}
+	while (days >= Rtc_DaysInMonth(year, month))
+		days -= Rtc_DaysInMonth(year, month++);
+
+	time->year   = (uint16_t)year;
+	time->month  = (uint8_t)month;
+	time->day    = (uint8_t)(days + 1U);
+	time->hour   = (uint8_t)(sod / 3600U);
+	time->minute = (uint8_t)(sod / 60U % 60U);
+	time->second = (uint8_t)(sod % 60U);
+	time->ms     = (uint16_t)(unix_ms % 1000U);
+}
+
+/**
+  * @brief	Set the frequency correction.
+  * @param[in] ppb	Correction in parts per billion; positive makes the RTC run faster.
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  * @note	Smooth calibration adds 512 RTCCLK pulses (CALP) and masks CALM
+  * 		of them in every 2^20: F = F_RTCCLK * 2^20 / (2^20 - p), with
+  * 		p = 512 * CALP - CALM. Beyond its range PREDIV_S is chosen first,
+  * 		in steps of 1/8192 (122 ppm), and the rest is left to CALR.
+  */
+Rtc_Status_t Rtc_SetCalibration(int32_t ppb)
+{
+	const int64_t nominal = Rtc_NominalHz();
+	uint32_t prediv_s = (rtc_source == RTC_SOURCE_LSE) ? RTC_PREDIV_S_LSE : RTC_PREDIV_S_LSI;
+	uint32_t timeout = RTC_READY_TIMEOUT;
+
+	if (rtc_source == RTC_SOURCE_NONE)
+		return RTC_ENOCLOCK;
+	if (ppb < RTC_CAL_MIN_PPB || ppb > RTC_CAL_MAX_PPB)
+		return RTC_EINVAL;
+
+	if (ppb < -RTC_CAL_SMOOTH_PPB || ppb > RTC_CAL_SMOOTH_PPB)
+	{
+		const int64_t den = (int64_t)(RTC_PREDIV_A + 1U) * (RTC_PPB + ppb);
+
+		prediv_s = (uint32_t)((nominal * RTC_PPB + den / 2) / den) - 1U;
+		if (prediv_s > RTC_PREDIV_S_MAX)
+			return RTC_EINVAL;
+	}
+
+	/* Rest for smooth calibration: 2^20 / (2^20 - p) = (1 + ppb) * N / N0 */
+	const int64_t scaled = (RTC_PPB + ppb) * (int64_t)((RTC_PREDIV_A + 1U) * (prediv_s + 1U));
+	const int64_t num = (scaled - nominal * RTC_PPB) * RTC_CAL_WINDOW;
+	const int32_t pulses = (int32_t)((num + ((num < 0) ? -scaled / 2 : scaled / 2)) / scaled);
+
+	if (pulses < -511 || pulses > 512)
+		return RTC_EINVAL;
+
+	while ((RTC->ISR & RTC_ISR_RECALPF) && --timeout);	/**< Previous calibration taken over	*/
+	if (timeout == 0U)
+		return RTC_ETIMEOUT;
+
+	Rtc_Unlock();
+	if (prediv_s != rtc_prediv_s)
+	{
+		uint32_t tr, dr, ssr;
+
+		Rtc_Read(&tr, &dr, &ssr);
+		if (!Rtc_EnterInit())
+		{
+			Rtc_Lock();
+			return RTC_ETIMEOUT;
+		}
+		RTC->PRER = prediv_s;						/**< Synchronous first, then asynchronous	*/
+		RTC->PRER = prediv_s | (RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos);
+		RTC->TR = tr;								/**< Restart the second that was running	*/
+		RTC->DR = dr;
+		Rtc_ExitInit();
+		rtc_prediv_s = prediv_s;
+	}
+	RTC->CALR = (pulses > 0) ? (RTC_CALR_CALP | (uint32_t)(512 - pulses)) : (uint32_t)(-pulses);
+	Rtc_Lock();
+
+	Rtc_Sync();
+	return RTC_OK;
+}
+
+/**
+  * @brief	Correction in effect (prescaler and smooth calibration).
+  * @retval	Parts per billion, positive: the RTC is sped up.
+  */
+int32_t Rtc_GetCalibration(void)
+{
+	uint32_t calr;
+	int64_t pulses;
+
+	if (rtc_source == RTC_SOURCE_NONE)
+		return 0;
+	calr = RTC->CALR;
+	pulses = ((calr & RTC_CALR_CALP) ? 512 : 0) - (int64_t)(calr & RTC_CALR_CALM);
+	return Rtc_RatioPpb((int64_t)Rtc_NominalHz() * RTC_CAL_WINDOW,
+						(int64_t)((RTC_PREDIV_A + 1U) * (rtc_prediv_s + 1U)) * (RTC_CAL_WINDOW - pulses));
+}
+
+/**
+  * @brief	Start measuring the RTC rate against the core cycle counter.
+  * @param[in] seconds	Gate time, 1 .. RTC_MEASURE_S_MAX.
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  * @note	Both ends of the gate are taken on a change of RTC_SSR, so the
+  * 		number of sub-second ticks is exact and only the cycle count
+  * 		carries the polling delay (well below 1 us). The smooth calibration
+  * 		pulses are spread over 32 s: a shorter gate sees them to within one
+  * 		pulse.
+  */
+Rtc_Status_t Rtc_MeasureStart(uint32_t seconds)
+{
+	if (rtc_source == RTC_SOURCE_NONE)
+		return RTC_ENOCLOCK;
+	if (seconds == 0U || seconds > RTC_MEASURE_S_MAX || (uint64_t)seconds * SystemCoreClock > 0xFFFFFFFFUL)
+		return RTC_EINVAL;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	rtc_meas_gate = seconds * SystemCoreClock;
+	return Rtc_Edge(&rtc_meas_ticks, &rtc_meas_cycles) ? RTC_OK : RTC_ETIMEOUT;
+}
+
+/**
+  * @brief	Finish the measurement once the gate time has passed.
+  * @param[out] error_ppb	Rate error of the corrected RTC, positive: fast.
+  * @retval	RTC_BUSY until then, RTC_OK, or RTC_ETIMEOUT.
+  */
+Rtc_Status_t Rtc_MeasurePoll(int32_t *error_ppb)
+{
+	uint64_t ticks;
+	uint32_t cycles;
+
+	if (DWT->CYCCNT - rtc_meas_cycles < rtc_meas_gate)
+		return RTC_BUSY;
+	if (!Rtc_Edge(&ticks, &cycles))
+		return RTC_ETIMEOUT;
+
+	/* RTC seconds / true seconds - 1 */
+	*error_ppb = Rtc_RatioPpb((int64_t)(ticks - rtc_meas_ticks) * SystemCoreClock,
+							  (int64_t)(rtc_prediv_s + 1U) * (uint32_t)(cycles - rtc_meas_cycles));
+	return RTC_OK;
+}
+
+/**
+  * @brief	Cancel a measured rate error with the calibration.
+  * @param[in] error_ppb	Error from Rtc_MeasurePoll(), positive: fast.
+  * @retval	As Rtc_SetCalibration().
+  */
+Rtc_Status_t Rtc_Trim(int32_t error_ppb)
+{
+	int64_t corrected;
+
+	if (rtc_source == RTC_SOURCE_NONE)
+		return RTC_ENOCLOCK;
+	if (error_ppb <= -RTC_PPB / 2)
+		return RTC_EINVAL;
+
+	/* (1 + new) = (1 + current) / (1 + error): exact, also for LSI-sized errors */
+	corrected = ((RTC_PPB + Rtc_GetCalibration()) * RTC_PPB) / (RTC_PPB + error_ppb) - RTC_PPB;
+	if (corrected < RTC_CAL_MIN_PPB || corrected > RTC_CAL_MAX_PPB)
+		return RTC_EINVAL;
+	return Rtc_SetCalibration((int32_t)corrected);
+}
+
+/**
+  * @brief	Start the periodic wake-up timer.
+  * @param[in] ms	Period, 1 .. RTC_WAKEUP_MS_MAX (above 32 s rounded to seconds).
+  * @retval	RTC_OK, RTC_EINVAL, RTC_ETIMEOUT or RTC_ENOCLOCK.
+  */
+Rtc_Status_t Rtc_SetWakeup(uint32_t ms)
+{
+	const uint32_t div16_hz = (RTC_PREDIV_A + 1U) * (rtc_prediv_s + 1U) / 16U;
+	uint32_t ticks = (uint32_t)((uint64_t)ms * div16_hz / 1000U), wucksel = RTC_WUCKSEL_DIV16;
+	uint32_t timeout = RTC_READY_TIMEOUT;
+
+	if (rtc_source == RTC_SOURCE_NONE)
+		return RTC_ENOCLOCK;
+	if (ms == 0U || ms > RTC_WAKEUP_MS_MAX)
+		return RTC_EINVAL;
+	if (ticks == 0U)
+		ticks = 1;
+	if (ticks > RTC_WUT_MAX)
+	{
+		ticks = (ms + 500U) / 1000U;				/**< Whole seconds on ck_spre				*/
+		wucksel = RTC_WUCKSEL_SPRE;
+	}
+
+	Rtc_Unlock();
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+	while (!(RTC->ISR & RTC_ISR_WUTWF) && --timeout);
+	if (timeout == 0U)
+	{
+		Rtc_Lock();
+		return RTC_ETIMEOUT;
+	}
+	RTC->WUTR = ticks - 1U;
+	REG_MODIFY(RTC->CR, RTC_CR_WUCKSEL, (wucksel << RTC_CR_WUCKSEL_Pos) | RTC_CR_WUTIE | RTC_CR_WUTE);
+	RTC_CLEAR(RTC_ISR_WUTF);
+	Rtc_Lock();
+	EXTI->PR = 1UL << RTC_EXTI_WAKEUP;
+	return RTC_OK;
+}
+
+/**
+  * @brief	Stop the wake-up timer.
+  * @retval	None
+  */
+void Rtc_StopWakeup(void)
+{
+	if (rtc_source == RTC_SOURCE_NONE)
+		return;
+
+	Rtc_Unlock();
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+	RTC_CLEAR(RTC_ISR_WUTF);
+	Rtc_Lock();
+	EXTI->PR = 1UL << RTC_EXTI_WAKEUP;
+}
+
+/**
+  * @brief	Wake-up timer events so far.
+  * @retval	Count.
+  */
+uint32_t Rtc_GetWakeups(void)
+{
+	return rtc_wakeups;
+}
+
+#if !defined(QEMU_NETDUINOPLUS2)
+/**
+  * @brief	Keep a running RTC or start one on LSE, else on LSI.
+  * @retval	Source, RTC_SOURCE_NONE if neither oscillator starts.
+  * @note	A cold start (RTC not enabled, or its clock gone) resets the
+  * 		backup domain and sets the calendar to 2000-01-01 00:00:00, not set.
+  */
+static Rtc_Source_t Rtc_Start(void)
+{
+	const uint32_t bdcr = RCC->BDCR;
+	const uint32_t sel = (bdcr & RCC_BDCR_RTCSEL) >> RCC_BDCR_RTCSEL_Pos;
+	uint32_t prediv_s = RTC_PREDIV_S_LSE;
+	Rtc_Source_t source = RTC_SOURCE_LSE;
+	Rtc_DateTime_t epoch = { 2000, 1, 1, 0, 0, 0, 0, 0 };
+	uint32_t tr, dr;
+
+	/* Warm start: keep calendar, prescalers and calibration */
+	if ((bdcr & RCC_BDCR_RTCEN) && sel == RTC_SOURCE_LSE_SEL && (bdcr & RCC_BDCR_LSERDY))
+		source = RTC_SOURCE_LSE;
+	else if ((bdcr & RCC_BDCR_RTCEN) && sel == RTC_SOURCE_LSI_SEL && Rtc_WaitLsi())
+		source = RTC_SOURCE_LSI;					/**< LSI is not in the backup domain: restarted	*/
+	else
+	{
+		RCC->BDCR = RCC_BDCR_BDRST;					/**< RTCSEL can only change after a reset	*/
+		RCC->BDCR = RCC_BDCR_LSEON;
+
+		const uint32_t start = SysTick_GetTick();
+		while (!(RCC->BDCR & RCC_BDCR_LSERDY) && SysTick_GetTick() - start < RTC_LSE_TIMEOUT_MS);
+
+		if (RCC->BDCR & RCC_BDCR_LSERDY)
+			RCC->BDCR = RCC_BDCR_LSEON | (RTC_SOURCE_LSE_SEL << RCC_BDCR_RTCSEL_Pos) | RCC_BDCR_RTCEN;
+		else
+		{
+			RCC->BDCR = 0;							/**< No crystal: LSE off, LSI instead		*/
+			if (!Rtc_WaitLsi())
+				return RTC_SOURCE_NONE;
+			RCC->BDCR = (RTC_SOURCE_LSI_SEL << RCC_BDCR_RTCSEL_Pos) | RCC_BDCR_RTCEN;
+			source = RTC_SOURCE_LSI;
+			prediv_s = RTC_PREDIV_S_LSI;
+		}
+
+		Rtc_Encode(&epoch, &tr, &dr);
+		Rtc_Unlock();
+		if (!Rtc_EnterInit())
+		{
+			Rtc_Lock();
+			return RTC_SOURCE_NONE;
+		}
+		RTC->PRER = prediv_s;						/**< Synchronous first, then asynchronous	*/
+		RTC->PRER = prediv_s | (RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos);
+		RTC->TR = tr;
+		RTC->DR = dr;
+		RTC->CR = 0;								/**< 24-hour format							*/
+		Rtc_ExitInit();
+		Rtc_Lock();
+	}
+
+	Rtc_Unlock();
+	RTC->CR |= RTC_CR_BYPSHAD;						/**< Read the counters, not the shadow copies	*/
+	Rtc_Lock();
+	return source;
+}
+
+/**
+  * @brief	Start LSI and wait until it runs.
+  * @retval	1 if ready, 0 on timeout.
+  */
+static uint8_t Rtc_WaitLsi(void)
+{
+	uint32_t timeout = RTC_READY_TIMEOUT;
+
+	RCC->CSR |= RCC_CSR_LSION;
+	while (!(RCC->CSR & RCC_CSR_LSIRDY) && --timeout);
+	return timeout != 0U;
+}
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/**
+  * @brief	Remove the RTC register write protection.
+  * @retval	None
+  */
+static void Rtc_Unlock(void)
+{
+	RTC->WPR = 0xCAU;
+	RTC->WPR = 0x53U;
+}
+
+/**
+  * @brief	Restore the RTC register write protection.
+  * @retval	None
+  */
+static void Rtc_Lock(void)
+{
+	RTC->WPR = 0xFFU;
+}
+
+/**
+  * @brief	Stop the calendar for programming (RTC unlocked).
+  * @retval	1 once in init mode, 0 on timeout.
+  */
+static uint8_t Rtc_EnterInit(void)
+{
+	uint32_t timeout = RTC_READY_TIMEOUT;
+
+	RTC->ISR = 0xFFFFFFFFUL;						/**< INIT set, rc_w0 flags left alone		*/
+	while (!(RTC->ISR & RTC_ISR_INITF) && --timeout);
+	if (timeout == 0U)
+		Rtc_ExitInit();
+	return timeout != 0U;
+}
+
+/**
+  * @brief	Restart the calendar from the values written in init mode.
+  * @retval	None
+  */
+static void Rtc_ExitInit(void)
+{
+	RTC->ISR = ~RTC_ISR_INIT;
+}
+
+/**
+  * @brief	Read time, date and sub-second counter consistently.
+  * @param[out] tr	RTC_TR.
+  * @param[out] dr	RTC_DR.
+  * @param[out] ssr	RTC_SSR.
+  * @retval	None
+  * @note	BYPSHAD is set, so the counters are read directly: an unchanged
+  * 		RTC_SSR around the TR/DR reads means no second has passed in between.
+  */
+static void Rtc_Read(uint32_t *tr, uint32_t *dr, uint32_t *ssr)
+{
+	uint32_t first;
+
+	do {
+		first = RTC->SSR;
+		*tr   = RTC->TR;
+		*dr   = RTC->DR;
+		*ssr  = RTC->SSR;
+	} while (first != *ssr);
+}
+
+/**
+  * @brief	Seconds since 2000-01-01 00:00:00 of a TR/DR pair.
+  * @param[in] tr	RTC_TR.
+  * @param[in] dr	RTC_DR.
+  * @retval	Seconds.
+  */
+static uint32_t Rtc_Seconds(uint32_t tr, uint32_t dr)
+{
+#define RTC_BCD(reg, shift, mask)	((((reg) >> ((shift) + 4U)) & ((mask) >> 4U)) * 10U + (((reg) >> (shift)) & 0xFU))
+	const uint32_t days = Rtc_Days(2000U + RTC_BCD(dr, 16U, 0xFFU), RTC_BCD(dr, 8U, 0x1FU), RTC_BCD(dr, 0U, 0x3FU));
+
+	return days * 86400U + RTC_BCD(tr, 16U, 0x3FU) * 3600U + RTC_BCD(tr, 8U, 0x7FU) * 60U + RTC_BCD(tr, 0U, 0x7FU);
+#undef RTC_BCD
+}
+
+/**
+  * @brief	Read the calendar in Unix microseconds.
+  * @retval	Microseconds since 1970-01-01 00:00:00 UTC.
+  */
+static uint64_t Rtc_ReadUs(void)
+{
+	uint32_t tr, dr, ssr;
+
+	Rtc_Read(&tr, &dr, &ssr);
+	return ((uint64_t)Rtc_Seconds(tr, dr) + RTC_UNIX_2000) * 1000000U
+		 + (uint64_t)(rtc_prediv_s - ssr) * 1000000U / (rtc_prediv_s + 1U);
+}
+
+/**
+  * @brief	Wait for the next change of RTC_SSR and stamp it.
+  * @param[out] ticks	Sub-second ticks since 2000-01-01 after the change.
+  * @param[out] cycles	Cycle counter right after the change.
+  * @retval	1 on success, 0 if RTC_SSR did not change.
+  */
+static uint8_t Rtc_Edge(uint64_t *ticks, uint32_t *cycles)
+{
+	const uint32_t ssr0 = RTC->SSR;
+	uint32_t timeout = RTC_READY_TIMEOUT, tr, dr, ssr;
+
+	while (RTC->SSR == ssr0 && --timeout);
+	*cycles = DWT->CYCCNT;
+	if (timeout == 0U)
+		return 0;
+
+	Rtc_Read(&tr, &dr, &ssr);
+	*ticks = (uint64_t)Rtc_Seconds(tr, dr) * (rtc_prediv_s + 1U) + (rtc_prediv_s - ssr);
+	return 1;
+}
+
+/**
+  * @brief	Days from 2000-01-01 to a date (2000 .. 2099: every fourth year is a leap year).
+  * @param[in] year		2000 .. 2099.
+  * @param[in] month	1 .. 12.
+  * @param[in] day		1 .. 31.
+  * @retval	Days.
+  */
+static uint32_t Rtc_Days(uint32_t year, uint32_t month, uint32_t day)
+{
+	const uint32_t y = year - 2000U;
+
+	return y * 365U + (y + 3U) / 4U + rtc_month_before[month - 1U] + day - 1U
+		 + ((month > 2U && (y & 3U) == 0U) ? 1U : 0U);
+}
+
+/**
+  * @brief	Length of a month.
+  * @param[in] year		2000 .. 2099.
+  * @param[in] month	1 .. 12.
+  * @retval	Days.
+  */
+static uint8_t Rtc_DaysInMonth(uint32_t year, uint32_t month)
+{
+	return (uint8_t)(rtc_month_days[month - 1U] + ((month == 2U && (year & 3U) == 0U) ? 1U : 0U));
+}
+
+/**
+  * @brief	Calendar time to RTC_TR/RTC_DR (BCD, 24-hour format).
+  * @param[in] time	Valid date and time.
+  * @param[out] tr	RTC_TR value.
+  * @param[out] dr	RTC_DR value, with the weekday computed from the date.
+  * @retval	None
+  */
+static void Rtc_Encode(const Rtc_DateTime_t *time, uint32_t *tr, uint32_t *dr)
+{
+#define RTC_TO_BCD(v)	((((uint32_t)(v) / 10U) << 4) | ((uint32_t)(v) % 10U))
+	const uint32_t weekday = (Rtc_Days(time->year, time->month, time->day) + 5U) % 7U + 1U;
+
+	*tr = (RTC_TO_BCD(time->hour) << 16) | (RTC_TO_BCD(time->minute) << 8) | RTC_TO_BCD(time->second);
+	*dr = (RTC_TO_BCD(time->year - 2000U) << 16) | (weekday << RTC_DR_WDU_Pos)
+		| (RTC_TO_BCD(time->month) << 8) | RTC_TO_BCD(time->day);
+#undef RTC_TO_BCD
+}
+
+/**
+  * @brief	num / den - 1 in parts per billion without overflowing 64 bits.
+  * @param[in] num	Numerator, below 2^46.
+  * @param[in] den	Denominator, below 2^46 and not 0.
+  * @retval	Ratio minus one, ppb.
+  */
+static int32_t Rtc_RatioPpb(int64_t num, int64_t den)
+{
+	const int64_t diff = (num - den) * 1000000;		/**< ppm part, then the remainder	*/
+	const int64_t ppm  = diff / den;
+
+	return (int32_t)(ppm * 1000 + (diff - ppm * den) * 1000 / den);
+}
+
+/**
+  * @brief	Nominal frequency of the RTC clock source.
+  * @retval	Hz.
+  */
+static uint32_t Rtc_NominalHz(void)
+{
+	return (rtc_source == RTC_SOURCE_LSE) ? RTC_LSE_HZ : RTC_LSI_HZ;
+}
+
+/**
+  * @brief	RTC wake-up interrupt handler (EXTI line 22), installed by Rtc_Init().
+  */
+static void Rtc_Wakeup_IRQHandler(void)
+{
+	const uint32_t start = IrqPlan_Enter();
+
+	RTC_CLEAR(RTC_ISR_WUTF);
+	EXTI->PR = 1UL << RTC_EXTI_WAKEUP;
+	rtc_wakeups++;
+	Atomic_WriteSync();								/**< Flags cleared before the return	*/
+	IrqPlan_Exit(IRQ_ID_RTC_WKUP, start);
+}
@@ -0,0 +1,145 @@
+/**
+  * @file	selftest.c
+  * @author	Parham Estiri
+  * @brief	QEMU integration self-test: SysTick and TIM timing, EXTI0 and debounce dispatch.
+  *
+  * Target	QEMU netduinoplus2 (STM32F405RG)
+  */
+
+#include "selftest.h"
+
+#if defined(QEMU_SELFTEST)
+
+#include "system.h"
+#include "systick.h"
+#include "trace.h"
+#include "stm32f407g_disc1.h"
+
+#define SELFTEST_REF_TIM		TIM2		/**< 32-bit reference timer, not used by the firmware	*/
+#define SELFTEST_REF_HZ			1000000UL	/**< Reference tick: 1 us								*/
+#define SELFTEST_PRESS_US		100000UL	/**< Longest wait for the button callback				*/
+
+#define SEMIHOST_SYS_WRITE0		0x04U		/**< Print a NUL-terminated string						*/
+#define SEMIHOST_SYS_EXIT		0x18U		/**< End the session									*/
+#define SEMIHOST_EXIT_OK		0x20026UL	/**< ADP_Stopped_ApplicationExit: status 0				*/
+#define SEMIHOST_EXIT_FAIL		0x20023UL	/**< ADP_Stopped_RunTimeErrorUnknown: status 1			*/
+
+static uint32_t selftest_failed;
+
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t SelfTest_Semihost(uint32_t op, const void *arg);
+static void SelfTest_RefInit(void);
+static uint32_t SelfTest_Us(void);
+static void SelfTest_Check(const char *name, uint32_t value, uint32_t min, uint32_t max);
+
+/**
+  * @brief	Run every check, report, and end the QEMU session.
+  * @retval	Does not return.
+  */
+void SelfTest_Run(void)
+{
+	const uint32_t debounce_us = BSP_Button_GetDebounce() * 1000U;
+	uint32_t t0, tick0, head;
+	Trace_Entry_t entry;
+
+	SelfTest_RefInit();
+
+	/* SysTick reload and dispatch through the SRAM vector table */
+	SelfTest_Check("systick-reload", SysTick->LOAD + 1U, SystemCoreClock / 1000U, SystemCoreClock / 1000U);
+	tick0 = SysTick_GetTick();
+	t0 = SelfTest_Us();
+	while (SelfTest_Us() - t0 < 20000U);
+	SelfTest_Check("systick-isr", SysTick_GetTick() - tick0, 19U, 21U);
+
+	/* Software press: EXTI0 handler, debounce timer (TIM4) handler, callback trace entry */
+	head = Trace_Head();
+	t0 = SelfTest_Us();
+	EXTI->SWIER = 1UL << BUTTON_PIN;
+	while (Trace_Head() == head && SelfTest_Us() - t0 < SELFTEST_PRESS_US)
+		__WFI();
+	SelfTest_Check("exti-debounce-us", SelfTest_Us() - t0, debounce_us, debounce_us + 1000U);
+	SelfTest_Check("exti-callback", Trace_Get(head, &entry) && entry.event == TRACE_BUTTON, 1U, 1U);
+
+	SelfTest_Semihost(SEMIHOST_SYS_WRITE0, selftest_failed ? "selftest: FAIL\n" : "selftest: PASS\n");
+	SelfTest_Semihost(SEMIHOST_SYS_EXIT, (const void *)(selftest_failed ? SEMIHOST_EXIT_FAIL : SEMIHOST_EXIT_OK));
+	while (1);										/**< Not reached with semihosting enabled	*/
+}
+
+/**
+  * @brief	Semihosting call (BKPT 0xAB, trapped by QEMU).
+  * @param[in] op	Operation number in r0.
+  * @param[in] arg	Parameter in r1.
+  * @retval	Result in r0.
+  */
+static uint32_t SelfTest_Semihost(uint32_t op, const void *arg)
+{
+	register uint32_t r0 __asm__("r0") = op;
+	register const void *r1 __asm__("r1") = arg;
+
+	__asm__ volatile ("bkpt 0xAB" : "+r"(r0) : "r"(r1) : "memory");
+	return r0;
+}
+
+/**
+  * @brief	Start the reference timer, free-running at SELFTEST_REF_HZ.
+  * @retval	None
+  */
+static void SelfTest_RefInit(void)
+{
+	SELFTEST_REF_TIM->CR1 = 0;
+	SELFTEST_REF_TIM->PSC = QEMU_TIMER_CLK_HZ / SELFTEST_REF_HZ - 1U;
+	SELFTEST_REF_TIM->ARR = 0xFFFFFFFFUL;
+	SELFTEST_REF_TIM->EGR = TIM_EGR_UG;				/**< Load the prescaler						*/
+	SELFTEST_REF_TIM->CR1 = TIM_CR1_CEN;
+}
+
+/**
+  * @brief	Reference time.
+  * @retval	Microseconds, wrapping at 2^32.
+  */
+static uint32_t SelfTest_Us(void)
+{
+	return SELFTEST_REF_TIM->CNT;
+}
+
+/**
+  * @brief	Report one check: "PASS name value [min, max]" or "FAIL ...".
+  * @param[in] name		Check name.
+  * @param[in] value	Measured value.
+  * @param[in] min		Lowest accepted value.
+  * @param[in] max		Highest accepted value.
+  * @retval	None
+  */
+static void SelfTest_Check(const char *name, uint32_t value, uint32_t min, uint32_t max)
+{
+	const uint32_t numbers[3] = { value, min, max };
+	const char *const separators[3] = { " ", " [", ", " };
+	char line[96], digits[10];
+	uint32_t len = 0;
+
+	if (value < min || value > max)
+		selftest_failed++;
+	for (const char *s = (value < min || value > max) ? "FAIL " : "PASS "; *s; s++)
+		line[len++] = *s;
+	while (*name && len < 40U)
+		line[len++] = *name++;
+	for (uint32_t i = 0; i < 3U; i++)
+	{
+		uint32_t n = 0, v = numbers[i];
+
+		for (const char *s = separators[i]; *s; s++)
+			line[len++] = *s;
+		do {
+			digits[n++] = (char)('0' + v % 10U);
+			v /= 10U;
+		} while (v != 0U);
+		while (n > 0U)
+			line[len++] = digits[--n];
+	}
+	line[len++] = ']';
+	line[len++] = '\n';
+	line[len] = '\0';
+	SelfTest_Semihost(SEMIHOST_SYS_WRITE0, line);
+}
+
+#endif /* QEMU_SELFTEST */
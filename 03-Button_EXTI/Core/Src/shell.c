@@ -0,0 +1,359 @@
+/**
+  * @file	shell.c
+  * @author	Parham Estiri
+  * @brief	Non-blocking command shell on the USART2 console.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <stddef.h>
+#include <string.h>
+#include "shell.h"
+#include "uart.h"
+#include "trace.h"
+
+#define SHELL_CTRL_C		0x03U
+#define SHELL_BACKSPACE		0x08U
+#define SHELL_DELETE		0x7FU
+
+static char shell_line[SHELL_LINE_MAX];
+static uint32_t shell_len;
+static char shell_prev;						/**< Last character: swallows the LF of CR LF	*/
+static char *shell_argv[SHELL_ARGS_MAX];
+static uint32_t shell_argc;
+static const Shell_Command_t *shell_running;	/**< Command waiting for its next call		*/
+static uint32_t shell_call;
+static uint32_t shell_polled;				/**< CYCCNT at the previous poll				*/
+static Shell_Stats_t shell_stats;
+
+/**************************  Static Function Prototypes  ***************************/
+static void Shell_Input(char c);
+static void Shell_Execute(void);
+static void Shell_Run(void);
+static uint32_t Shell_Tokenize(char *line, char *argv[], uint32_t max);
+
+/**
+  * @brief	Start the console, check the command table and print the prompt.
+  * @retval	None
+  */
+void Shell_Init(void)
+{
+	UART_Init(UART_BAUD);
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;		/**< Cycle counter for the statistics	*/
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	shell_polled = DWT->CYCCNT;
+
+	Shell_Print("\r\n03-Button_EXTI shell, 'help' lists the commands\r\n");
+	for (uint32_t i = 1; i < shell_commands_count; i++)
+		if (strcmp(shell_commands[i - 1U].name, shell_commands[i].name) >= 0)
+		{
+			Shell_Print("shell: table not sorted at ");		/**< Binary search would miss commands	*/
+			Shell_Print(shell_commands[i].name);
+			Shell_Print("\r\n");
+		}
+	Shell_Print(SHELL_PROMPT);
+}
+
+/**
+  * @brief	Handle pending input or continue the running command.
+  * @retval	None
+  * @note	Call from the main loop; never waits.
+  */
+void Shell_Poll(void)
+{
+	const uint32_t now = DWT->CYCCNT;
+
+	if (now - shell_polled > shell_stats.poll_max)
+		shell_stats.poll_max = now - shell_polled;
+	shell_polled = now;
+
+	if (shell_running)
+		Shell_Run();								/**< Input waits in the RX ring meanwhile	*/
+	else
+		for (uint32_t i = 0; i < SHELL_RX_BATCH && !shell_running; i++)
+		{
+			uint8_t c;
+
+			if (UART_Read(&c, 1U) == 0U)
+				break;
+			Shell_Input((char)c);
+		}
+
+	shell_polled = DWT->CYCCNT;						/**< Own work is not loop latency		*/
+}
+
+/**
+  * @brief	Look up a command (binary search).
+  * @param[in] name	Command name.
+  * @retval	Table entry, or NULL.
+  */
+const Shell_Command_t *Shell_Find(const char *name)
+{
+	uint32_t lo = 0, hi = shell_commands_count;
+
+	while (lo < hi)
+	{
+		const uint32_t mid = (lo + hi) / 2U;
+		const int cmp = strcmp(name, shell_commands[mid].name);
+
+		if (cmp == 0)
+			return &shell_commands[mid];
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1U;
+	}
+	return NULL;
+}
+
+/**
+  * @brief	Parse an unsigned number: decimal, or hexadecimal with 0x.
+  * @param[in] str		Text.
+  * @param[out] value	Number.
+  * @retval	1 if the whole text is a number that fits 32 bits, 0 otherwise.
+  */
+uint8_t Shell_ParseU32(const char *str, uint32_t *value)
+{
+	uint32_t base = 10, v = 0;
+
+	if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+	{
+		base = 16;
+		str += 2;
+	}
+	if (*str == '\0')
+		return 0;
+
+	for (; *str; str++)
+	{
+		uint32_t d;
+
+		if (*str >= '0' && *str <= '9')
+			d = (uint32_t)(*str - '0');
+		else if (base == 16U && *str >= 'a' && *str <= 'f')
+			d = (uint32_t)(*str - 'a' + 10);
+		else if (base == 16U && *str >= 'A' && *str <= 'F')
+			d = (uint32_t)(*str - 'A' + 10);
+		else
+			return 0;
+
+		if (v > (0xFFFFFFFFUL - d) / base)
+			return 0;								/**< Overflow							*/
+		v = v * base + d;
+	}
+
+	*value = v;
+	return 1;
+}
+
+/**
+  * @brief	Print a string.
+  * @param[in] str	Text.
+  * @retval	None
+  */
+void Shell_Print(const char *str)
+{
+	UART_Write(str, strlen(str));
+}
+
+/**
+  * @brief	Print an unsigned decimal.
+  * @param[in] value	Number.
+  * @retval	None
+  */
+void Shell_PrintU32(uint32_t value)
+{
+	char buf[10];
+	uint32_t i = sizeof(buf);
+
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	UART_Write(&buf[i], sizeof(buf) - i);
+}
+
+/**
+  * @brief	Print 0x and a fixed number of hexadecimal digits.
+  * @param[in] value	Number.
+  * @param[in] digits	Digits, 1 .. 8.
+  * @retval	None
+  */
+void Shell_PrintHex(uint32_t value, uint32_t digits)
+{
+	static const char hex[] = "0123456789abcdef";
+	char buf[10] = { '0', 'x' };
+
+	if (digits == 0U || digits > 8U)
+		digits = 8U;
+	for (uint32_t i = 0; i < digits; i++)
+		buf[2U + i] = hex[(value >> (4U * (digits - 1U - i))) & 0xFU];
+	UART_Write(buf, 2U + digits);
+}
+
+/**
+  * @brief	Copy the shell statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void Shell_GetStats(Shell_Stats_t *stats)
+{
+	*stats = shell_stats;
+}
+
+/**
+  * @brief	Line editing: one input character.
+  */
+static void Shell_Input(char c)
+{
+	const char prev = shell_prev;
+
+	shell_prev = c;
+	switch (c)
+	{
+		case '\n':
+			if (prev == '\r')
+				break;								/**< CR LF: the line already ended		*/
+			/* fall through */
+		case '\r':
+			Shell_Print("\r\n");
+			Shell_Execute();
+			break;
+
+		case SHELL_BACKSPACE:
+		case SHELL_DELETE:
+			if (shell_len)
+			{
+				shell_len--;
+				Shell_Print("\b \b");
+			}
+			break;
+
+		case SHELL_CTRL_C:
+			shell_len = 0;
+			Shell_Print("^C\r\n" SHELL_PROMPT);
+			break;
+
+		default:
+			if (c < ' ' || c > '~')
+				break;								/**< Other control characters			*/
+			if (shell_len >= SHELL_LINE_MAX - 1U)
+			{
+				Shell_Print("\a");					/**< Line full							*/
+				break;
+			}
+			shell_line[shell_len++] = c;
+			UART_Write(&c, 1U);
+			break;
+	}
+}
+
+/**
+  * @brief	A line is complete: tokenize it and start its command.
+  */
+static void Shell_Execute(void)
+{
+	shell_line[shell_len] = '\0';
+	shell_len = 0;
+	shell_argc = Shell_Tokenize(shell_line, shell_argv, SHELL_ARGS_MAX);
+
+	if (shell_argc == 0U)
+	{
+		Shell_Print(SHELL_PROMPT);
+		return;
+	}
+	shell_stats.lines++;
+
+	if (shell_argc > SHELL_ARGS_MAX)
+	{
+		shell_stats.errors++;
+		Shell_Print("too many arguments\r\n" SHELL_PROMPT);
+		return;
+	}
+
+	shell_running = Shell_Find(shell_argv[0]);
+	if (shell_running == NULL)
+	{
+		shell_stats.errors++;
+		Shell_Print(shell_argv[0]);
+		Shell_Print(": unknown command, try 'help'\r\n" SHELL_PROMPT);
+		return;
+	}
+
+	Trace_Record(TRACE_COMMAND, (uint32_t)(shell_running - shell_commands));
+	shell_call = 0;
+	Shell_Run();
+}
+
+/**
+  * @brief	One call of the running command's handler, timed.
+  */
+static void Shell_Run(void)
+{
+	const Shell_Command_t *cmd = shell_running;
+	const uint32_t start = DWT->CYCCNT;
+	const Shell_Status_t status = cmd->handler(shell_argc, shell_argv, shell_call);
+	const uint32_t cycles = DWT->CYCCNT - start;
+
+	shell_stats.call_last = cycles;
+	if (cycles > shell_stats.call_max)
+		shell_stats.call_max = cycles;
+
+	if (status == SHELL_AGAIN)
+	{
+		shell_call++;
+		return;
+	}
+	shell_running = NULL;
+
+	if (status == SHELL_EUSAGE)
+	{
+		Shell_Print("usage: ");
+		Shell_Print(cmd->name);
+		Shell_Print(" ");
+		Shell_Print(cmd->usage);
+		Shell_Print("\r\n");
+	}
+	if (status != SHELL_OK)
+		shell_stats.errors++;
+	Shell_Print(SHELL_PROMPT);
+}
+
+/**
+  * @brief	Split a line in place.
+  * @param[in,out] line	Line; separators are overwritten with '\0'.
+  * @param[out] argv	Argument pointers into the line.
+  * @param[in] max		Size of argv.
+  * @retval	Number of arguments, or max + 1 if there are more.
+  */
+static uint32_t Shell_Tokenize(char *line, char *argv[], uint32_t max)
+{
+	uint32_t argc = 0;
+	char *p = line;
+
+	while (1)
+	{
+		while (*p == ' ')
+			*p++ = '\0';
+		if (*p == '\0')
+			return argc;
+		if (argc == max)
+			return max + 1U;
+
+		if (*p == '"')
+		{
+			argv[argc++] = ++p;						/**< Quoted: up to the closing quote	*/
+			while (*p && *p != '"')
+				p++;
+			if (*p)
+				*p++ = '\0';
+		}
+		else
+		{
+			argv[argc++] = p;
+			while (*p && *p != ' ')
+				p++;
+		}
+	}
+}
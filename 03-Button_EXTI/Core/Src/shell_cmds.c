@@ -0,0 +1,836 @@
+/**
+  * @file	shell_cmds.c
+  * @author	Parham Estiri
+  * @brief	Shell command table and handlers.
+  *
+  * 		Each handler does a bounded amount of work per call. Output longer
+  * 		than the free transmit space is paged: the handler returns
+  * 		SHELL_AGAIN and continues on the next poll.
+  *
+  * @note	Keep `shell_commands[]` sorted by name: Shell_Find() is a binary search.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <string.h>
+#include "shell.h"
+#include "uart.h"
+#include "trace.h"
+#include "pattern.h"
+#include "systick.h"
+#include "clock.h"
+#include "irq_plan.h"
+#include "vectors.h"
+#include "rtc.h"
+#include "stm32f407g_disc1.h"
+
+#define CMD_LINE_SPACE			80U			/**< Transmit space needed for one output line	*/
+#define CMD_PEEK_MAX			16U			/**< Words per peek								*/
+#define CMD_RTC_GATE_S			10U			/**< Default rtc measure/trim gate				*/
+
+/**************************  Static Function Prototypes  ***************************/
+static Shell_Status_t Cmd_Clock(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Clocks(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Date(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Debounce(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Help(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Irqs(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Led(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Peek(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Poke(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Rtc(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Stats(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Stop(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Trace(uint32_t argc, char *argv[], uint32_t call);
+static Shell_Status_t Cmd_Vectors(uint32_t argc, char *argv[], uint32_t call);
+static uint8_t Cmd_Access(uint32_t addr, uint32_t *value, uint8_t write);
+static void Cmd_PrintCycles(const char *label, uint32_t cycles);
+static void Cmd_ClockChanged(void);
+static uint8_t Cmd_ParseI32(const char *str, int32_t *value);
+static uint8_t Cmd_ParseFields(const char *str, char sep, uint32_t field[3]);
+static void Cmd_PrintI32(int32_t value);
+static void Cmd_PrintPadded(uint32_t value, uint32_t digits);
+static void Cmd_PrintDateTime(const Rtc_DateTime_t *time);
+
+/**
+  * @brief	Command table, sorted by name.
+  */
+const Shell_Command_t shell_commands[] = {
+	{ "clock",		Cmd_Clock,		"[hsi|hse|pll]",			"show or switch SYSCLK"				},
+	{ "clocks",		Cmd_Clocks,		"",							"peripheral clocks and references"	},
+	{ "date",		Cmd_Date,		"[YYYY-MM-DD HH:MM:SS]",	"show or set the RTC calendar (UTC)"	},
+	{ "debounce",	Cmd_Debounce,	"[ms]",						"show or set the button debounce"	},
+	{ "help",		Cmd_Help,		"",							"list the commands"					},
+	{ "irqs",		Cmd_Irqs,		"[reset]",					"interrupt plan and measured times"	},
+	{ "led",		Cmd_Led,		"[off|chase|blink] [ms]",	"show or set the LED pattern"		},
+	{ "peek",		Cmd_Peek,		"<addr> [words]",			"read memory (32-bit, aligned)"		},
+	{ "poke",		Cmd_Poke,		"<addr> <value>",			"write memory (32-bit, aligned)"	},
+	{ "rtc",		Cmd_Rtc,		"[cal <ppb>|measure|trim] [s]",	"RTC source, calibration, rate"	},
+	{ "stats",		Cmd_Stats,		"",							"shell, console and clock counters"	},
+	{ "stop",		Cmd_Stop,		"<ms>",						"STOP mode, RTC wake-up after ms"	},
+	{ "trace",		Cmd_Trace,		"[count]",					"dump the last events"				},
+	{ "vectors",	Cmd_Vectors,	"",							"handlers installed at run time"	},
+};
+
+const uint32_t shell_commands_count = sizeof(shell_commands) / sizeof(shell_commands[0]);
+
+static const char *const cmd_clock_names[] = { "hsi", "hse", "pll" };
+static const char *const cmd_bus_names[] = { "AHB1", "AHB2", "APB1", "APB2" };
+static const char *const cmd_rtc_sources[] = { "none", "lse", "lsi" };
+static const char *const cmd_weekdays[] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+
+/**
+  * @brief	clock [hsi|hse|pll]
+  *
+  * 		Switching waits (SHELL_AGAIN) until the console has sent everything,
+  * 		since the baud rate divider is recomputed afterwards, then brings
+  * 		SysTick, the console and the debounce timer onto the new clock.
+  */
+static Shell_Status_t Cmd_Clock(uint32_t argc, char *argv[], uint32_t call)
+{
+	uint32_t source;
+	System_Status_t status;
+
+	(void)call;
+	if (argc == 1U)
+	{
+		Shell_Print("SYSCLK ");
+		Shell_PrintU32(SystemCoreClock);
+		Shell_Print(" Hz (");
+		Shell_Print(cmd_clock_names[System_GetClock()]);
+		Shell_Print("), PCLK1 ");
+		Shell_PrintU32(System_GetPCLK1());
+		Shell_Print(" Hz, APB1 timers ");
+		Shell_PrintU32(System_GetTimerClock1());
+		Shell_Print(" Hz\r\n");
+		return SHELL_OK;
+	}
+	if (argc != 2U)
+		return SHELL_EUSAGE;
+
+	for (source = 0; source < 3U; source++)
+		if (strcmp(argv[1], cmd_clock_names[source]) == 0)
+			break;
+	if (source == 3U)
+		return SHELL_EUSAGE;
+
+	if (!UART_TxIdle())
+		return SHELL_AGAIN;
+
+	status = System_SetClock((System_Clock_t)source);
+	Cmd_ClockChanged();
+	if (status != SYSTEM_OK)
+	{
+		Shell_Print(status == SYSTEM_ETIMEOUT ? "clock: not ready, unchanged\r\n"
+											  : "clock: not possible in this build\r\n");
+		return SHELL_EFAIL;
+	}
+
+	Trace_Record(TRACE_CLOCK, SystemCoreClock);
+	Shell_Print("SYSCLK ");
+	Shell_PrintU32(SystemCoreClock);
+	Shell_Print(" Hz\r\n");
+	return SHELL_OK;
+}
+
+/**
+  * @brief	clocks: per bus the enable register, the clocks with references
+  * 		and those running in sleep mode, then the references per clock.
+  * 		Paged.
+  */
+static Shell_Status_t Cmd_Clocks(uint32_t argc, char *argv[], uint32_t call)
+{
+	static const volatile uint32_t *const enr[] = { &RCC->AHB1ENR, &RCC->AHB2ENR, &RCC->APB1ENR, &RCC->APB2ENR };
+	static uint32_t next;
+
+	(void)argc;
+	(void)argv;
+	if (call == 0U)
+		next = 0;
+
+	for (; next < 4U + CLOCK_IDS; next++)
+	{
+		if (UART_TxFree() < CMD_LINE_SPACE)
+			return SHELL_AGAIN;
+		if (next < 4U)
+		{
+			Shell_Print(cmd_bus_names[next]);
+			Shell_Print(" enr ");
+			Shell_PrintHex(*enr[next], 8);
+			Shell_Print(" refs ");
+			Shell_PrintHex(Clock_GetActive((Clock_Bus_t)next, CLOCK_SLEEP_OFF), 8);
+			Shell_Print(" sleep ");
+			Shell_PrintHex(Clock_GetActive((Clock_Bus_t)next, CLOCK_SLEEP_ON), 8);
+			Shell_Print("\r\n");
+			continue;
+		}
+
+		const Clock_Id_t id = (Clock_Id_t)(next - 4U);
+		const char *name = Clock_Name(id);
+
+		if (Clock_GetRefs(id, CLOCK_SLEEP_OFF) == 0U)
+			continue;
+		if (name != NULL)
+			Shell_Print(name);
+		else
+		{
+			Shell_Print(cmd_bus_names[id >> 5]);
+			Shell_Print(".");
+			Shell_PrintU32(id & 31U);
+		}
+		Shell_Print(" ");
+		Shell_PrintU32(Clock_GetRefs(id, CLOCK_SLEEP_OFF));
+		Shell_Print(" (sleep ");
+		Shell_PrintU32(Clock_GetRefs(id, CLOCK_SLEEP_ON));
+		Shell_Print(")\r\n");
+	}
+	return SHELL_OK;
+}
+
+/**
+  * @brief	date [YYYY-MM-DD HH:MM:SS]
+  */
+static Shell_Status_t Cmd_Date(uint32_t argc, char *argv[], uint32_t call)
+{
+	Rtc_DateTime_t time;
+	Rtc_Status_t status;
+
+	(void)call;
+	if (argc == 3U)
+	{
+		uint32_t date[3], clock[3];
+
+		if (!Cmd_ParseFields(argv[1], '-', date) || !Cmd_ParseFields(argv[2], ':', clock))
+			return SHELL_EUSAGE;
+		time.year   = (uint16_t)date[0];
+		time.month  = (uint8_t)date[1];
+		time.day    = (uint8_t)date[2];
+		time.hour   = (uint8_t)clock[0];
+		time.minute = (uint8_t)clock[1];
+		time.second = (uint8_t)clock[2];
+
+		status = Rtc_SetTime(&time);
+		if (status != RTC_OK)
+		{
+			Shell_Print(status == RTC_EINVAL ? "date: 2000-01-01 .. 2099-12-31, 24-hour time\r\n"
+											 : (status == RTC_ENOCLOCK ? "date: no RTC\r\n" : "date: RTC not ready\r\n"));
+			return SHELL_EFAIL;
+		}
+		Trace_Record(TRACE_DATE, (uint32_t)(Rtc_ReadUnixMs() / 1000U));
+	}
+	else if (argc != 1U)
+		return SHELL_EUSAGE;
+
+	if (Rtc_GetTime(&time) != RTC_OK)
+	{
+		Shell_Print("date: no RTC\r\n");
+		return SHELL_EFAIL;
+	}
+	Cmd_PrintDateTime(&time);
+	Shell_Print(" UTC ");
+	Shell_Print(cmd_weekdays[time.weekday - 1U]);
+	Shell_Print(Rtc_IsSet() ? "\r\n" : " (not set)\r\n");
+	return SHELL_OK;
+}
+
+/**
+  * @brief	debounce [ms]
+  */
+static Shell_Status_t Cmd_Debounce(uint32_t argc, char *argv[], uint32_t call)
+{
+	uint32_t ms;
+
+	(void)call;
+	if (argc == 2U)
+	{
+		if (!Shell_ParseU32(argv[1], &ms) || !BSP_Button_SetDebounce(ms))
+		{
+			Shell_Print("debounce: 1 .. ");
+			Shell_PrintU32(BUTTON_DEBOUNCE_MS_MAX);
+			Shell_Print(" ms\r\n");
+			return SHELL_EFAIL;
+		}
+		Trace_Record(TRACE_DEBOUNCE, ms);
+	}
+	else if (argc != 1U)
+		return SHELL_EUSAGE;
+
+	Shell_Print("debounce ");
+	Shell_PrintU32(BSP_Button_GetDebounce());
+	Shell_Print(" ms\r\n");
+	return SHELL_OK;
+}
+
+/**
+  * @brief	help: one command per line, paged.
+  */
+static Shell_Status_t Cmd_Help(uint32_t argc, char *argv[], uint32_t call)
+{
+	static uint32_t next;
+
+	(void)argc;
+	(void)argv;
+	if (call == 0U)
+		next = 0;
+
+	while (next < shell_commands_count)
+	{
+		const Shell_Command_t *cmd = &shell_commands[next];
+
+		if (UART_TxFree() < CMD_LINE_SPACE)
+			return SHELL_AGAIN;
+		Shell_Print(cmd->name);
+		Shell_Print(" ");
+		Shell_Print(cmd->usage);
+		Shell_Print(" - ");
+		Shell_Print(cmd->help);
+		Shell_Print("\r\n");
+		next++;
+	}
+	return SHELL_OK;
+}
+
+/**
+  * @brief	irqs [reset]: per plan entry the priority, declared and measured
+  * 		execution time in cycles, period and deadline. "over" marks a
+  * 		handler that took longer than declared. Paged.
+  */
+static Shell_Status_t Cmd_Irqs(uint32_t argc, char *argv[], uint32_t call)
+{
+	static uint32_t next;
+	IrqPlan_Info_t info;
+
+	if (argc > 2U || (argc == 2U && strcmp(argv[1], "reset") != 0))
+		return SHELL_EUSAGE;
+	if (call == 0U)
+	{
+		if (argc == 2U)
+			IrqPlan_ResetMeasured();
+		next = 0;
+	}
+
+	for (; next < IRQ_IDS; next++)
+	{
+		if (UART_TxFree() < CMD_LINE_SPACE)
+			return SHELL_AGAIN;
+		IrqPlan_GetInfo((Irq_Id_t)next, &info);
+		Shell_Print(info.name);
+		Shell_Print(" prio ");
+		Shell_PrintU32(info.prio);
+		Shell_Print(" wcet ");
+		Shell_PrintU32(info.wcet);
+		Shell_Print(" max ");
+		Shell_PrintU32(info.measured);
+		Shell_Print(" period ");
+		Shell_PrintU32(info.period_us);
+		Shell_Print(" us deadline ");
+		Shell_PrintU32(info.deadline_us);
+		Shell_Print(" us");
+		if (info.measured > info.wcet)
+			Shell_Print(" over");
+		Shell_Print("\r\n");
+	}
+	return SHELL_OK;
+}
+
+/**
+  * @brief	led [off|chase|blink] [ms]
+  */
+static Shell_Status_t Cmd_Led(uint32_t argc, char *argv[], uint32_t call)
+{
+	Pattern_t pattern = PATTERN_OFF;
+	uint32_t ms;
+
+	(void)call;
+	if (argc > 3U)
+		return SHELL_EUSAGE;
+	if (argc >= 2U && !Pattern_Find(argv[1], &pattern))
+		return SHELL_EUSAGE;
+	if (argc == 3U && (!Shell_ParseU32(argv[2], &ms) || !Pattern_SetPeriod(ms)))
+	{
+		Shell_Print("led: ");
+		Shell_PrintU32(PATTERN_PERIOD_MIN);
+		Shell_Print(" .. ");
+		Shell_PrintU32(PATTERN_PERIOD_MAX);
+		Shell_Print(" ms\r\n");
+		return SHELL_EFAIL;
+	}
+	if (argc >= 2U)
+	{
+		Pattern_Set(pattern);
+		Trace_Record(TRACE_PATTERN, pattern);
+	}
+
+	Shell_Print("led ");
+	Shell_Print(Pattern_Name(Pattern_Get()));
+	Shell_Print(" ");
+	Shell_PrintU32(Pattern_GetPeriod());
+	Shell_Print(" ms\r\n");
+	return SHELL_OK;
+}
+
+/**
+  * @brief	peek <addr> [words]: four words per line; an address that
+  * 		bus-faults prints as "--------".
+  */
+static Shell_Status_t Cmd_Peek(uint32_t argc, char *argv[], uint32_t call)
+{
+	uint32_t addr, count = 1;
+
+	(void)call;
+	if (argc < 2U || argc > 3U || !Shell_ParseU32(argv[1], &addr) || (addr & 3U))
+		return SHELL_EUSAGE;
+	if (argc == 3U && (!Shell_ParseU32(argv[2], &count) || count == 0U || count > CMD_PEEK_MAX))
+		return SHELL_EUSAGE;
+	if (addr > 0xFFFFFFFFUL - 4U * (count - 1U))
+		return SHELL_EUSAGE;					/**< Wraps around the address space	*/
+
+	for (uint32_t i = 0; i < count; i++, addr += 4U)
+	{
+		uint32_t value;
+
+		if ((i & 3U) == 0U)
+		{
+			Shell_PrintHex(addr, 8U);
+			Shell_Print(":");
+		}
+		Shell_Print(" ");
+		if (Cmd_Access(addr, &value, 0U))
+			Shell_PrintHex(value, 8U);
+		else
+			Shell_Print("  --------");
+		if ((i & 3U) == 3U || i == count - 1U)
+			Shell_Print("\r\n");
+	}
+	return SHELL_OK;
+}
+
+/**
+  * @brief	poke <addr> <value>: writes, then reads back.
+  */
+static Shell_Status_t Cmd_Poke(uint32_t argc, char *argv[], uint32_t call)
+{
+	uint32_t addr, value;
+
+	(void)call;
+	if (argc != 3U || !Shell_ParseU32(argv[1], &addr) || (addr & 3U) || !Shell_ParseU32(argv[2], &value))
+		return SHELL_EUSAGE;
+
+	Trace_Record(TRACE_POKE, addr);
+	if (!Cmd_Access(addr, &value, 1U) || !Cmd_Access(addr, &value, 0U))
+	{
+		Shell_Print("poke: bus fault\r\n");
+		return SHELL_EFAIL;
+	}
+	Shell_PrintHex(addr, 8U);
+	Shell_Print(": ");
+	Shell_PrintHex(value, 8U);
+	Shell_Print("\r\n");
+	return SHELL_OK;
+}
+
+/**
+  * @brief	rtc [cal <ppb>|measure [s]|trim [s]]
+  *
+  * 		measure compares the RTC with the core cycle counter over s seconds
+  * 		(default CMD_RTC_GATE_S) and prints the rate error; trim also
+  * 		cancels it with the calibration. Both wait (SHELL_AGAIN) for the
+  * 		gate; the reference is only as good as SYSCLK, so use hse or pll.
+  */
+static Shell_Status_t Cmd_Rtc(uint32_t argc, char *argv[], uint32_t call)
+{
+	const uint8_t trim = (argc >= 2U && strcmp(argv[1], "trim") == 0);
+	uint32_t seconds = CMD_RTC_GATE_S;
+	Rtc_Status_t status;
+	int32_t ppb;
+
+	if (Rtc_GetSource() == RTC_SOURCE_NONE)
+	{
+		Shell_Print("rtc: no RTC\r\n");
+		return SHELL_EFAIL;
+	}
+
+	if (argc == 3U && strcmp(argv[1], "cal") == 0)
+	{
+		if (!Cmd_ParseI32(argv[2], &ppb))
+			return SHELL_EUSAGE;
+		status = Rtc_SetCalibration(ppb);
+	}
+	else if ((argc == 2U || argc == 3U) && (trim || strcmp(argv[1], "measure") == 0))
+	{
+		if (call == 0U)
+		{
+			if (argc == 3U && !Shell_ParseU32(argv[2], &seconds))
+				return SHELL_EUSAGE;
+			status = Rtc_MeasureStart(seconds);
+			if (status == RTC_EINVAL)
+			{
+				Shell_Print("rtc: 1 .. ");
+				Shell_PrintU32(RTC_MEASURE_S_MAX);
+				Shell_Print(" s at this SYSCLK\r\n");
+				return SHELL_EFAIL;
+			}
+			if (status == RTC_OK)
+			{
+				if (System_GetClock() == SYSTEM_CLOCK_HSI)
+					Shell_Print("rtc: SYSCLK on HSI, reference within 1 %\r\n");
+				return SHELL_AGAIN;
+			}
+		}
+		else
+		{
+			status = Rtc_MeasurePoll(&ppb);
+			if (status == RTC_BUSY)
+				return SHELL_AGAIN;
+			if (status == RTC_OK)
+			{
+				Shell_Print("error ");
+				Cmd_PrintI32(ppb);
+				Shell_Print(" ppb\r\n");
+				if (trim)
+					status = Rtc_Trim(ppb);
+			}
+		}
+		if (status == RTC_OK && !trim)
+			return SHELL_OK;
+	}
+	else if (argc == 1U)
+		status = RTC_OK;
+	else
+		return SHELL_EUSAGE;
+
+	if (status != RTC_OK)
+	{
+		Shell_Print(status == RTC_EINVAL ? "rtc: correction out of range\r\n" : "rtc: RTC not ready\r\n");
+		return SHELL_EFAIL;
+	}
+	if (argc > 1U)
+		Trace_Record(TRACE_RTC_CAL, (uint32_t)Rtc_GetCalibration());
+
+	Shell_Print("rtc ");
+	Shell_Print(cmd_rtc_sources[Rtc_GetSource()]);
+	Shell_Print(", calibration ");
+	Cmd_PrintI32(Rtc_GetCalibration());
+	Shell_Print(" ppb, wake-ups ");
+	Shell_PrintU32(Rtc_GetWakeups());
+	Shell_Print("\r\n");
+	return SHELL_OK;
+}
+
+/**
+  * @brief	stats
+  */
+static Shell_Status_t Cmd_Stats(uint32_t argc, char *argv[], uint32_t call)
+{
+	Shell_Stats_t shell;
+	UART_Stats_t uart;
+
+	(void)argc;
+	(void)argv;
+	(void)call;
+	if (UART_TxFree() < 4U * CMD_LINE_SPACE)
+		return SHELL_AGAIN;
+
+	Shell_GetStats(&shell);
+	UART_GetStats(&uart);
+
+	Shell_Print("uptime ");
+	Shell_PrintU32(SysTick_GetTick());
+	Shell_Print(" ms, SYSCLK ");
+	Shell_PrintU32(SystemCoreClock);
+	Shell_Print(" Hz, events ");
+	Shell_PrintU32(Trace_Head());
+	Shell_Print("\r\nlines ");
+	Shell_PrintU32(shell.lines);
+	Shell_Print(", errors ");
+	Shell_PrintU32(shell.errors);
+	Shell_Print("\r\n");
+	Cmd_PrintCycles("command last ", shell.call_last);
+	Cmd_PrintCycles(", max ", shell.call_max);
+	Cmd_PrintCycles(", poll gap max ", shell.poll_max);
+	Shell_Print("\r\nrx ");
+	Shell_PrintU32(uart.rx_bytes);
+	Shell_Print(" (lost ");
+	Shell_PrintU32(uart.rx_lost);
+	Shell_Print("), tx ");
+	Shell_PrintU32(uart.tx_bytes);
+	Shell_Print(" (dropped ");
+	Shell_PrintU32(uart.tx_dropped);
+	Shell_Print(")\r\n");
+	return SHELL_OK;
+}
+
+/**
+  * @brief	stop <ms>
+  *
+  * 		Waits (SHELL_AGAIN) until the console has sent everything, sleeps
+  * 		in STOP mode until the RTC wake-up timer (or the button) ends it,
+  * 		then restores the clocks and adds the time slept, read from the
+  * 		RTC, to the SysTick count.
+  */
+static Shell_Status_t Cmd_Stop(uint32_t argc, char *argv[], uint32_t call)
+{
+	uint32_t ms;
+	uint64_t before;
+	System_Status_t status;
+
+	(void)call;
+	if (argc != 2U || !Shell_ParseU32(argv[1], &ms) || ms == 0U || ms > RTC_WAKEUP_MS_MAX)
+		return SHELL_EUSAGE;
+	if (!UART_TxIdle())
+		return SHELL_AGAIN;
+
+	if (Rtc_SetWakeup(ms) != RTC_OK)
+	{
+		Shell_Print("stop: no RTC wake-up\r\n");
+		return SHELL_EFAIL;
+	}
+	before = Rtc_ReadUnixMs();
+	status = System_EnterStop();
+	ms = (uint32_t)(Rtc_ReadUnixMs() - before);
+	Rtc_StopWakeup();
+	SysTick_Advance(ms);
+	Cmd_ClockChanged();
+
+	Trace_Record(TRACE_STOP, ms);
+	Shell_Print("woke after ");
+	Shell_PrintU32(ms);
+	Shell_Print(" ms\r\n");
+	if (status != SYSTEM_OK)
+	{
+		Shell_Print("stop: clock not restored, on hsi\r\n");
+		return SHELL_EFAIL;
+	}
+	return SHELL_OK;
+}
+
+/**
+  * @brief	trace [count]: oldest first, paged. Entries get their UTC time
+  * 		once the RTC calendar is set.
+  */
+static Shell_Status_t Cmd_Trace(uint32_t argc, char *argv[], uint32_t call)
+{
+	static uint32_t next, end;
+	Trace_Entry_t entry;
+
+	if (call == 0U)
+	{
+		uint32_t count = TRACE_SIZE;
+
+		if (argc > 2U || (argc == 2U && !Shell_ParseU32(argv[1], &count)))
+			return SHELL_EUSAGE;
+		if (count > TRACE_SIZE)
+			count = TRACE_SIZE;
+		end = Trace_Head();
+		next = end - ((count < end) ? count : end);
+	}
+
+	while (next != end)
+	{
+		if (UART_TxFree() < CMD_LINE_SPACE)
+			return SHELL_AGAIN;
+		if (Trace_Get(next, &entry))			/**< Skips what was overwritten meanwhile	*/
+		{
+			Shell_PrintU32(next);
+			Shell_Print(" ");
+			Shell_PrintU32(entry.ms);
+			Shell_Print(" ms ");
+			Shell_PrintHex(entry.cycles, 8U);
+			Shell_Print(" ");
+			if (Rtc_IsSet())
+			{
+				Rtc_DateTime_t time;
+
+				Rtc_UnixToDateTime(Rtc_TickToUnixMs(entry.ms), &time);
+				Cmd_PrintDateTime(&time);
+				Shell_Print(" ");
+			}
+			Shell_Print(Trace_Name(entry.event));
+			Shell_Print(" ");
+			Shell_PrintU32(entry.arg);
+			Shell_Print("\r\n");
+		}
+		next++;
+	}
+	return SHELL_OK;
+}
+
+/**
+  * @brief	vectors: the active table, then every entry that no longer holds
+  * 		its flash handler ("exc" for core exceptions, "irq" for IRQn >= 0).
+  * 		Paged.
+  */
+static Shell_Status_t Cmd_Vectors(uint32_t argc, char *argv[], uint32_t call)
+{
+	static uint32_t next;
+
+	(void)argc;
+	(void)argv;
+	if (call == 0U)
+	{
+		Shell_Print("VTOR ");
+		Shell_PrintHex(SCB->VTOR, 8U);
+		Shell_Print("\r\n");
+		next = 2U;								/**< Stack pointer and reset: not installable	*/
+	}
+
+	for (; next < VECTORS_COUNT; next++)
+	{
+		const IRQn_Type irqn = (IRQn_Type)((int32_t)next - 16);
+
+		if (Vectors_IsDefault(irqn))
+			continue;
+		if (UART_TxFree() < CMD_LINE_SPACE)
+			return SHELL_AGAIN;
+		Shell_Print((next < 16U) ? "exc " : "irq ");
+		Shell_PrintU32((next < 16U) ? next : next - 16U);
+		Shell_Print(" ");
+		Shell_PrintHex((uint32_t)Vectors_Get(irqn), 8U);
+		Shell_Print("\r\n");
+	}
+	return SHELL_OK;
+}
+
+/**
+  * @brief	Read or write one word, surviving a bus fault.
+  *
+  * 		With FAULTMASK set and CCR.BFHFNMIGN, a precise or imprecise data
+  * 		bus fault is ignored and only latched in CFSR, which is checked
+  * 		afterwards.
+  * @param[in] addr			Word address.
+  * @param[in,out] value	Value read or to write.
+  * @param[in] write		1 to write, 0 to read.
+  * @retval	1 if the access completed, 0 on a bus fault.
+  */
+static uint8_t Cmd_Access(uint32_t addr, uint32_t *value, uint8_t write)
+{
+	const uint32_t faultmask = __get_FAULTMASK();
+	uint8_t ok;
+
+	__set_FAULTMASK(1);
+	SCB->CFSR = SCB_CFSR_BUSFAULTSR_Msk;		/**< Write 1 to clear						*/
+	SCB->CCR |= SCB_CCR_BFHFNMIGN_Msk;
+	__DSB();
+	__ISB();
+
+	if (write)
+		*(volatile uint32_t *)addr = *value;
+	else
+		*value = *(volatile uint32_t *)addr;
+	__DSB();									/**< Lets an imprecise fault land here		*/
+
+	ok = !(SCB->CFSR & (SCB_CFSR_PRECISERR_Msk | SCB_CFSR_IMPRECISERR_Msk));
+	SCB->CFSR = SCB_CFSR_BUSFAULTSR_Msk;
+	SCB->CCR &= ~SCB_CCR_BFHFNMIGN_Msk;
+	__DSB();
+	__ISB();
+	__set_FAULTMASK(faultmask);
+	return ok;
+}
+
+/**
+  * @brief	Print a cycle count with its duration in microseconds.
+  */
+static void Cmd_PrintCycles(const char *label, uint32_t cycles)
+{
+	Shell_Print(label);
+	Shell_PrintU32(cycles);
+	Shell_Print(" cyc/");
+	Shell_PrintU32(cycles / (SystemCoreClock / 1000000UL));
+	Shell_Print(" us");
+}
+
+/**
+  * @brief	Bring SysTick, the console and the debounce timer onto a new SYSCLK.
+  */
+static void Cmd_ClockChanged(void)
+{
+	SysTick_Init(1000U, SYSTICK_CMSIS);
+	UART_SetBaud(UART_BAUD);
+	BSP_Button_SetDebounce(BSP_Button_GetDebounce());
+}
+
+/**
+  * @brief	Parse a signed decimal, "-123" or "+123".
+  * @param[in] str		Text.
+  * @param[out] value	Result.
+  * @retval	1 on success, 0 if not a number or out of range.
+  */
+static uint8_t Cmd_ParseI32(const char *str, int32_t *value)
+{
+	const uint8_t negative = (*str == '-');
+	uint32_t magnitude;
+
+	if (*str == '-' || *str == '+')
+		str++;
+	if (!Shell_ParseU32(str, &magnitude) || magnitude > (negative ? 0x80000000UL : 0x7FFFFFFFUL))
+		return 0;
+	*value = negative ? (int32_t)(0U - magnitude) : (int32_t)magnitude;
+	return 1;
+}
+
+/**
+  * @brief	Parse three decimal fields of up to four digits, "2026-10-17" or "12:34:56".
+  * @param[in] str		Text.
+  * @param[in] sep		Separator between the fields.
+  * @param[out] field	The three values.
+  * @retval	1 on success, 0 otherwise.
+  */
+static uint8_t Cmd_ParseFields(const char *str, char sep, uint32_t field[3])
+{
+	for (uint32_t i = 0; i < 3U; i++)
+	{
+		uint32_t digits = 0;
+
+		for (field[i] = 0; *str >= '0' && *str <= '9'; str++)
+		{
+			if (++digits > 4U)
+				return 0;
+			field[i] = field[i] * 10U + (uint32_t)(*str - '0');
+		}
+		if (digits == 0U || *str != ((i < 2U) ? sep : '\0'))
+			return 0;
+		str++;
+	}
+	return 1;
+}
+
+/**
+  * @brief	Print a signed value with its sign.
+  */
+static void Cmd_PrintI32(int32_t value)
+{
+	Shell_Print((value < 0) ? "-" : "+");
+	Shell_PrintU32((value < 0) ? 0U - (uint32_t)value : (uint32_t)value);
+}
+
+/**
+  * @brief	Print a value with leading zeros.
+  */
+static void Cmd_PrintPadded(uint32_t value, uint32_t digits)
+{
+	for (uint32_t limit = 10U; --digits > 0U; limit *= 10U)
+		if (value < limit)
+			Shell_Print("0");
+	Shell_PrintU32(value);
+}
+
+/**
+  * @brief	Print YYYY-MM-DD HH:MM:SS.mmm.
+  */
+static void Cmd_PrintDateTime(const Rtc_DateTime_t *time)
+{
+	Shell_PrintU32(time->year);
+	Shell_Print("-");
+	Cmd_PrintPadded(time->month, 2U);
+	Shell_Print("-");
+	Cmd_PrintPadded(time->day, 2U);
+	Shell_Print(" ");
+	Cmd_PrintPadded(time->hour, 2U);
+	Shell_Print(":");
+	Cmd_PrintPadded(time->minute, 2U);
+	Shell_Print(":");
+	Cmd_PrintPadded(time->second, 2U);
+	Shell_Print(".");
+	Cmd_PrintPadded(time->ms, 3U);
+}
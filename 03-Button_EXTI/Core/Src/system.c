@@ -4,46 +4,202 @@
   * @brief	System Initialization and Configuration.
   *
   * 		This file contains:
-  * 		 - NVIC priority grouping macros
+  * 		 - SRAM vector table and interrupt priorities (IRQ_PLAN, applied in one pass)
   *			 - Serial Wire Debug (SWD) interface configuration
-  * 		 - System Clock configurations
+  * 		 - System Clock configurations (flash wait states via flash.h)
+  * 		 - Run-time switching between HSI, HSE and PLL
+  * 		 - STOP mode entry, SYSCLK restored on wake-up
+  * 		 - QEMU (netduinoplus2) start-up path, selected by QEMU_NETDUINOPLUS2
   *
   * Target	STM32F407VGT6
   */
 
 #include "system.h"
-
-/************************  NVIC Priority Group Definitions  ************************/
-#define NVIC_PRIORITYGROUP_0	0x7UL	/**< 0 bits for pre-emption priority, 4 bits for subpriority */
-#define NVIC_PRIORITYGROUP_1	0x6UL	/**< 1 bits for pre-emption priority, 3 bits for subpriority */
-#define NVIC_PRIORITYGROUP_2	0x5UL	/**< 2 bits for pre-emption priority, 2 bits for subpriority */
-#define NVIC_PRIORITYGROUP_3	0x4UL	/**< 3 bits for pre-emption priority, 1 bits for subpriority */
-#define NVIC_PRIORITYGROUP_4	0x3UL	/**< 4 bits for pre-emption priority, 0 bits for subpriority */
+#include "flash.h"
+#include "clock.h"
+#include "reg.h"
+#include "atomic.h"
+#include "irq_plan.h"
+#include "vectors.h"
 
 /**************************  PLL Configuration Constants  **************************/
 #define PLL_M		4U				/**< PLL division factor for main PLL input clock	*/
 #define PLL_N		168U			/**< PLL multiplication factor for VCO				*/
 #define PLL_P		2U				/**< PLL division factor for main system clock		*/
 #define PLL_Q		7U				/**< PLL division factor for USB clock				*/
+#define SYSTEM_HCLK_HZ	((HSE_VALUE / PLL_M) * PLL_N / PLL_P)	/**< Resulting HCLK (AHB prescaler /1)	*/
+
+#define SWD_PINS	((1UL << 13) | (1UL << 14))	/**< PA13 SWDIO, PA14 SWCLK	*/
+
+#define SYSTEM_READY_TIMEOUT	100000UL	/**< Polls for an oscillator, the PLL or a clock switch	*/
 
 /**************************  Static Function Prototypes  ***************************/
+#if !defined(QEMU_NETDUINOPLUS2)
 static void System_SWD_Init(void);
 static void System_Clock_Config(void);
+static uint8_t System_Wait(volatile uint32_t *reg, uint32_t mask, uint32_t value);
+static uint8_t System_SwitchDown(uint32_t sw, uint32_t sws);
+#endif /* QEMU_NETDUINOPLUS2 */
 
 /**
-  * @brief	Sets NVIC priority grouping, initializes SWD, configures system clock, and updates SystemCoreClock variable.
+  * @brief	Moves the vector table to SRAM, applies the interrupt plan, initializes SWD, configures system clock, and updates SystemCoreClock variable.
   * @param	None
   * @retval	None
   * @note	This function must be called at the beginning of main() before using peripherals.
   */
 void System_Init(void)
 {
-	NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);	/**< NVIC: 4 preemptive, 0 sub-priority bits  */
+	Vectors_Init();									/**< Handlers installed at run time		  */
+	IrqPlan_Apply();								/**< NVIC grouping and all priorities	  */
+	Clock_Init();									/**< Peripheral clocks stop in sleep mode	  */
+#if defined(QEMU_NETDUINOPLUS2)
+	/* RCC, PWR, FLASH and DBGMCU are not emulated: HSE/PLL ready flags never set */
+	SystemCoreClock = QEMU_SYSCLK_HZ;				/**< SYSCLK is fixed by the QEMU machine	  */
+#else
 	System_SWD_Init();								/**< Enable Serial Wire Debug				  */
 	System_Clock_Config();							/**< Clock configuration					  */
 	SystemCoreClockUpdate();						/**< Update SystemCoreClock variable		  */
+#endif /* QEMU_NETDUINOPLUS2 */
 }
 
+/**
+  * @brief	Switch SYSCLK to another source at run time.
+  *
+  * 		Going up to the PLL, the flash wait states and APB prescalers are
+  * 		raised before the switch; going down to HSI or HSE they are lowered
+  * 		after it (APB1/APB2 at /1, 0 wait states) and the PLL is stopped.
+  *
+  * @param[in] source	New clock source.
+  * @retval	SYSTEM_OK, SYSTEM_ETIMEOUT (clock unchanged) or SYSTEM_EINVAL.
+  * @note	Updates SystemCoreClock. Everything derived from a bus clock (SysTick,
+  * 		baud rates, timer prescalers) must be reprogrammed by the caller.
+  */
+System_Status_t System_SetClock(System_Clock_t source)
+{
+#if defined(QEMU_NETDUINOPLUS2)
+	(void)source;
+	return SYSTEM_EINVAL;							/**< RCC is not emulated: SYSCLK is fixed	  */
+#else
+	if (source == System_GetClock())
+		return SYSTEM_OK;
+
+	switch (source)
+	{
+		case SYSTEM_CLOCK_HSI:
+			RCC->CR |= RCC_CR_HSION;
+			if (!System_Wait(&RCC->CR, RCC_CR_HSIRDY, RCC_CR_HSIRDY)
+				|| !System_SwitchDown(RCC_CFGR_SW_HSI, RCC_CFGR_SWS_HSI))
+				return SYSTEM_ETIMEOUT;
+			break;
+
+		case SYSTEM_CLOCK_HSE:
+			RCC->CR |= RCC_CR_HSEON;
+			if (!System_Wait(&RCC->CR, RCC_CR_HSERDY, RCC_CR_HSERDY)
+				|| !System_SwitchDown(RCC_CFGR_SW_HSE, RCC_CFGR_SWS_HSE))
+				return SYSTEM_ETIMEOUT;
+			break;
+
+		case SYSTEM_CLOCK_PLL:
+			RCC->CR |= RCC_CR_HSEON;
+			if (!System_Wait(&RCC->CR, RCC_CR_HSERDY, RCC_CR_HSERDY))
+				return SYSTEM_ETIMEOUT;
+			RCC->CR |= RCC_CR_PLLON;				/**< PLLCFGR still holds the 168 MHz setup	*/
+			if (!System_Wait(&RCC->CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY))
+				return SYSTEM_ETIMEOUT;
+
+			Flash_SetLatencyForClock(SYSTEM_HCLK_HZ, FLASH_VRANGE_BOARD);	/**< Before the speed-up	*/
+			RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2))
+					  | RCC_CFGR_PPRE1_DIV4 | RCC_CFGR_PPRE2_DIV2;
+
+			RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+			if (!System_Wait(&RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_PLL))
+				return SYSTEM_ETIMEOUT;
+			break;
+
+		default:
+			return SYSTEM_EINVAL;
+	}
+
+	SystemCoreClockUpdate();
+	return SYSTEM_OK;
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+/**
+  * @brief	Enter STOP mode until an EXTI event (RTC wake-up, button), then restore SYSCLK.
+  * @retval	SYSTEM_OK, SYSTEM_ETIMEOUT (running on HSI) or SYSTEM_EINVAL (QEMU).
+  * @note	STOP exits on HSI with HSE and the PLL off, and SysTick does not
+  * 		count while stopped. As after System_SetClock(), the caller
+  * 		reprograms what derives from a bus clock, and adds the time slept
+  * 		with SysTick_Advance(). Wait for the UART to finish sending first.
+  */
+System_Status_t System_EnterStop(void)
+{
+#if defined(QEMU_NETDUINOPLUS2)
+	return SYSTEM_EINVAL;							/**< PWR is not emulated					  */
+#else
+	const System_Clock_t source = System_GetClock();
+
+	Clock_Enable(CLOCK_PWR, CLOCK_SLEEP_OFF);
+	REG_SET(PWR->CR, PWR_CR,
+			PDDS, 0,								/**< STOP, not STANDBY						*/
+			LPDS, 1);								/**< Regulator in low-power mode			*/
+	Clock_Disable(CLOCK_PWR, CLOCK_SLEEP_OFF);
+
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	Atomic_WriteSync();								/**< Everything written before the stop		*/
+	__WFI();
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	SystemCoreClockUpdate();						/**< HSI now								*/
+	return System_SetClock(source);
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+/**
+  * @brief	Current SYSCLK source.
+  * @retval	Clock source.
+  */
+System_Clock_t System_GetClock(void)
+{
+#if defined(QEMU_NETDUINOPLUS2)
+	return SYSTEM_CLOCK_PLL;
+#else
+	switch (RCC->CFGR & RCC_CFGR_SWS)
+	{
+		case RCC_CFGR_SWS_HSE:	return SYSTEM_CLOCK_HSE;
+		case RCC_CFGR_SWS_PLL:	return SYSTEM_CLOCK_PLL;
+		default:				return SYSTEM_CLOCK_HSI;
+	}
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+/**
+  * @brief	APB1 peripheral clock (USART2..5, I2C, SPI2/3).
+  * @retval	Frequency in Hz.
+  */
+uint32_t System_GetPCLK1(void)
+{
+	return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+/**
+  * @brief	Clock of the timers on APB1 (TIM2..TIM7, TIM12..TIM14).
+  * @retval	Frequency in Hz: PCLK1, doubled when the APB1 prescaler is not 1.
+  */
+uint32_t System_GetTimerClock1(void)
+{
+#if defined(QEMU_NETDUINOPLUS2)
+	return QEMU_TIMER_CLK_HZ;
+#else
+	const uint32_t pclk1 = System_GetPCLK1();
+
+	return (pclk1 == SystemCoreClock) ? pclk1 : 2U * pclk1;
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+#if !defined(QEMU_NETDUINOPLUS2)
+
 /**
   * @brief	Initializes Serial Wire Debug (SWD) Interface on PA13 and PA14.
   * @param	None
@@ -51,23 +207,16 @@ void System_Init(void)
   */
 static void System_SWD_Init(void)
 {
-	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;			/**< Enable GPIOA clock								*/
+	Clock_Enable(CLOCK_GPIOA, CLOCK_SLEEP_OFF);		/**< GPIOA clock, kept for the SWD pins				*/
 
 	DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP				/**< Enable debugging in sleep mode					*/
 			   |  DBGMCU_CR_DBG_STOP				/**< Enable debugging in stop mode					*/
 			   |  DBGMCU_CR_DBG_STANDBY;			/**< Enable debugging in standby mode				*/
 
-	GPIOA->MODER &= ~(GPIO_MODER_MODER13 | GPIO_MODER_MODER14);
-	GPIOA->MODER |= (GPIO_MODER_MODER13_1 | GPIO_MODER_MODER14_1);	/**< Set PA13 and PA14 to AF mode	*/
-
-	GPIOA->AFR[1] &= ~((0xFU << (4 * 5)) | (0xFU << (4 * 6)));
-	GPIOA->AFR[1] |= ((0x0U << (4 * 5)) | (0x0U << (4 * 6)));		/**< Set AF0 for PA13 and PA14		*/
-
-	GPIOA->OSPEEDR |= GPIO_OSPEEDER_OSPEEDR13		/**< Set PA13 to very high speed					*/
-				   |  GPIO_OSPEEDER_OSPEEDR14;		/**< Set PA14 to very high speed					*/
-
-	GPIOA->PUPDR &= ~(GPIO_PUPDR_PUPDR13 | GPIO_PUPDR_PUPDR14);		/**< Set pins on no pull-up/down	*/
-	GPIOA->PUPDR |= GPIO_PUPDR_PUPDR13_0;			/**< Enable pull-up on PA13 for stability			*/
+	REG_MODIFY(GPIOA->MODER, REG_PINS2_MSK(SWD_PINS), REG_PINS2(SWD_PINS, GPIO_MODE_AF));	/**< AF mode		*/
+	REG_MODIFY(GPIOA->AFR[1], REG_PIN4_MSK(13) | REG_PIN4_MSK(14), REG_PIN4(13, 0) | REG_PIN4(14, 0));	/**< AF0	*/
+	REG_MODIFY(GPIOA->OSPEEDR, REG_PINS2_MSK(SWD_PINS), REG_PINS2(SWD_PINS, GPIO_SPEED_VERY_HIGH));
+	REG_MODIFY(GPIOA->PUPDR, REG_PINS2_MSK(SWD_PINS), REG_PIN2(13, GPIO_PULL_UP));	/**< Pull-up on PA13 only	*/
 }
 
 /**
@@ -80,32 +229,62 @@ static void System_Clock_Config(void)
 	RCC->CR |= RCC_CR_HSEON;				/**< Enable HSE clock							*/
 	while(!(RCC->CR & RCC_CR_HSERDY));		/**< Wait until HSE is ready					*/
 
-	RCC->APB1ENR |= RCC_APB1ENR_PWREN;		/**< Enable power interface clock				*/
-
+	Clock_Enable(CLOCK_PWR, CLOCK_SLEEP_OFF);	/**< Power interface clock					*/
 	PWR->CR |= PWR_CR_VOS;					/**< Set voltage regulator to default value		*/
+	Clock_Disable(CLOCK_PWR, CLOCK_SLEEP_OFF);	/**< VOS keeps its value					*/
 
-	FLASH->ACR |= FLASH_ACR_ICEN			/**< Enable instruction cache					*/
-			   |  FLASH_ACR_PRFTEN			/**< Enable FLASH prefetch buffer				*/
-			   |  FLASH_ACR_DCEN			/**< Enable data cache							*/
-			   |  FLASH_ACR_LATENCY_5WS;	/**< Set latency on 5 wait states for 168 MHz	*/
+	Flash_SetLatencyForClock(SYSTEM_HCLK_HZ, FLASH_VRANGE_BOARD);	/**< Minimum wait states, before raising HCLK	*/
+	Flash_SetProfile(FLASH_PROFILE_LINEAR);	/**< Reset caches, enable I/D cache and prefetch	*/
 
-	RCC->CFGR |= RCC_CFGR_HPRE_DIV1			/**< AHB  prescaler => /1						*/
-			  |  RCC_CFGR_PPRE1_DIV4		/**< APB1 prescaler => /4						*/
-	          |  RCC_CFGR_PPRE2_DIV2;		/**< APB2 prescaler => /2						*/
+	REG_SET(RCC->CFGR, RCC_CFGR,
+			HPRE, 0,						/**< AHB  prescaler => /1						*/
+			PPRE1, 5,						/**< APB1 prescaler => /4						*/
+			PPRE2, 4);						/**< APB2 prescaler => /2						*/
 
-	RCC->PLLCFGR = 0;						/**< Clear PLL configuration					*/
-	RCC->PLLCFGR |= (PLL_M & 0x3FU)						/**< PLLM = 4						*/
-				 |	((PLL_N & 0x1FFU) << 6)				/**< PLLN = 168						*/
-				 |	(((PLL_P / 2 - 1) & 0x3U) << 16)	/**< PLLP = 2						*/
-				 |	((PLL_Q & 0xFU) << 24)				/**< PLLQ = 7						*/
-				 |	RCC_PLLCFGR_PLLSRC_HSE;		/**< Set HSE as PLL clock source			*/
+	REG_WRITE(RCC->PLLCFGR, RCC_PLLCFGR,	/**< One store, a value too wide fails to build	*/
+			  PLLM, PLL_M,					/**< PLLM = 4									*/
+			  PLLN, PLL_N,					/**< PLLN = 168									*/
+			  PLLP, PLL_P / 2U - 1U,		/**< PLLP = 2									*/
+			  PLLQ, PLL_Q,					/**< PLLQ = 7									*/
+			  PLLSRC, 1);					/**< Set HSE as PLL clock source				*/
 
 	RCC->CR |= RCC_CR_PLLON;				/**< Enable PLL									*/
 	while(!(RCC->CR & RCC_CR_PLLRDY));		/**< Wait until PLL is stable					*/
 
-	RCC->CFGR &= ~RCC_CFGR_SW;
-	RCC->CFGR |= RCC_CFGR_SW_PLL;			/**< Select PLL as system clock source			*/
+	REG_MODIFY(RCC->CFGR, RCC_CFGR_SW, RCC_CFGR_SW_PLL);	/**< Select PLL as system clock source	*/
 	while((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);		/**< Wait until PLL is set	*/
 
 	RCC->CR |= RCC_CR_CSSON;				/**< Enable clock security system (CSS)			*/
 }
+
+/**
+  * @brief	Poll a register until (reg & mask) == value, at most SYSTEM_READY_TIMEOUT times.
+  * @retval	1 on success, 0 on timeout.
+  */
+static uint8_t System_Wait(volatile uint32_t *reg, uint32_t mask, uint32_t value)
+{
+	for (uint32_t i = 0; i < SYSTEM_READY_TIMEOUT; i++)
+		if ((*reg & mask) == value)
+			return 1;
+	return 0;
+}
+
+/**
+  * @brief	Switch from the PLL (or between HSI and HSE) to a slower clock.
+  * @param[in] sw	RCC_CFGR_SW_xxx of the new source (already running).
+  * @param[in] sws	Matching RCC_CFGR_SWS_xxx.
+  * @retval	1 on success, 0 on timeout.
+  */
+static uint8_t System_SwitchDown(uint32_t sw, uint32_t sws)
+{
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | sw;
+	if (!System_Wait(&RCC->CFGR, RCC_CFGR_SWS, sws))
+		return 0;
+
+	RCC->CFGR &= ~(RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2);			/**< APB1/APB2 at /1 (16 MHz at most)	*/
+	SystemCoreClockUpdate();
+	Flash_SetLatencyForClock(SystemCoreClock, FLASH_VRANGE_BOARD);	/**< After the slow-down	*/
+	RCC->CR &= ~RCC_CR_PLLON;								/**< Stop the PLL until it is needed	*/
+	return 1;
+}
+#endif /* QEMU_NETDUINOPLUS2 */
@@ -0,0 +1,126 @@
+/**
+  * @file	systick.c
+  * @author	Parham Estiri
+  * @brief	SysTick driver implementation.
+  */
+
+#include "systick.h"
+#include "irq_plan.h"
+#include "vectors.h"
+#include "atomic.h"
+
+/**
+  *	@brief	Global tick counter in milliseconds
+  */
+static volatile uint32_t systick_ms = 0;
+
+/**************************  Static Function Prototypes  ***************************/
+static void SysTick_IRQHandler(void);
+
+/**
+  * @brief	Initialize SysTick timer
+  * @details	Configures the SysTick timer to generate a 1ms tick interrupt
+  * 			based on the system core clock.
+  * @param[in] ticks_per_second		Number of SysTick interrupt per second
+  * 								Typically, 1000 for 1ms tick
+  * @param[in] impl		Implementation style: CMSIS or Custom
+  * @retval	None
+  * @note	This function must be called at the beginning of main() before using SysTick.
+  * 		Call it again after a clock change; the tick count is kept.
+  */
+void SysTick_Init(uint32_t ticks_per_second, SysTick_Impl_t impl)
+{
+	Vectors_Install(SysTick_IRQn, SysTick_IRQHandler);
+
+	switch (impl)
+	{
+		case SYSTICK_CMSIS:
+			/* CMSIS function: automatically sets reload, enables counter & interrupt */
+			SysTick_Config(SystemCoreClock / ticks_per_second);
+			IrqPlan_Restore(IRQ_ID_SYSTICK);	/**< SysTick_Config() sets the lowest priority */
+			break;
+
+		case SYSTICK_CUSTOM:
+			/* Manual register-level configuration */
+			SysTick->LOAD = (uint32_t)((SystemCoreClock / ticks_per_second) - 1UL);	/**< Set reload value */
+			SysTick->VAL  = 0UL;							/**< Reset SysTick current value */
+			SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk		/**< Use processor clock	*/
+						  | SysTick_CTRL_TICKINT_Msk		/**< Enable interrupt		*/
+						  | SysTick_CTRL_ENABLE_Msk;		/**< Enable SysTick counter	*/
+			break;
+
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief	Enable SysTick timer and interrupt
+  */
+void SysTick_Enable(void)
+{
+	SysTick->CTRL = SysTick_CTRL_TICKINT_Msk		/**< Enable interrupt		*/
+				  | SysTick_CTRL_ENABLE_Msk;		/**< Enable SysTick counter	*/
+}
+
+/**
+  * @brief	Disable SysTick timer and interrupt
+  */
+void SysTick_Disable(void)
+{
+	SysTick->CTRL &= ~(SysTick_CTRL_TICKINT_Msk		/**< Disable interrupt		*/
+				  | SysTick_CTRL_ENABLE_Msk);		/**< Disable SysTick counter	*/
+}
+
+/**
+  * @brief	Blocking delay in milliseconds
+  * @param[in] ms	Number of milliseconds to delay.
+  * @retval	None
+  */
+void SysTick_delay_ms(uint32_t ms)
+{
+	uint32_t start = systick_ms;		/**< Record starting tick count			*/
+	while ((systick_ms - start) < ms){	/**< Wait until specified time passes	*/
+		__WFI();						/**< Sleep until next interrupt			*/
+	}
+}
+
+/**
+  * @brief	Get current tick count in milliseconds
+  * @param	None
+  * @retval	Tick count since SysTick initialization.
+  */
+uint32_t SysTick_GetTick(void)
+{
+	return systick_ms;
+}
+
+/**
+  * @brief	Add time that passed without ticks (STOP mode) to the tick count.
+  * @param[in] ms	Milliseconds to add.
+  * @retval	None
+  */
+void SysTick_Advance(uint32_t ms)
+{
+	(void)Atomic_FetchAdd(&systick_ms, ms);	/**< The tick interrupt may add one meanwhile	*/
+}
+
+/**
+  * @brief	Called from the SysTick interrupt on every tick.
+  * @note	Define your own SysTick_Callback() in your application to run periodic work.
+  */
+__WEAK void SysTick_Callback(void)
+{
+}
+
+/**
+  * @brief	SysTick interrupt handler, installed by SysTick_Init().
+  */
+static void SysTick_IRQHandler(void)
+{
+	const uint32_t start = IrqPlan_Enter();
+
+	systick_ms++;		/**< Increment millisecond counter	*/
+	SysTick_Callback();	/**< Application periodic work		*/
+	IrqPlan_Exit(IRQ_ID_SYSTICK, start);
+}
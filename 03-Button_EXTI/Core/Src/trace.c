@@ -0,0 +1,98 @@
+/**
+  * @file	trace.c
+  * @author	Parham Estiri
+  * @brief	Event trace ring for post-mortem inspection from the shell.
+  *
+  * 		Lock-free: a writer claims a sequence number with Atomic_FetchAdd()
+  * 		and fills the slot between two stamps, `begin` before the data and
+  * 		`end` after it. A reader copies the slot between reading `end` and
+  * 		`begin`; the copy is only valid if both hold the wanted sequence
+  * 		number, otherwise the slot was being written or was overwritten
+  * 		meanwhile. Interrupts are never masked.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "trace.h"
+#include "systick.h"
+#include "atomic.h"
+
+#define TRACE_MASK			(TRACE_SIZE - 1U)
+
+#if (TRACE_SIZE & TRACE_MASK) != 0U
+#error "TRACE_SIZE must be a power of two"
+#endif
+
+/**
+  * @brief	Ring slot: an entry between its two sequence stamps.
+  */
+typedef struct {
+	volatile uint32_t	begin;		/**< Sequence number + 1, stored before the entry	*/
+	Trace_Entry_t		entry;
+	volatile uint32_t	end;		/**< Sequence number + 1, stored after the entry	*/
+} Trace_Slot_t;
+
+static Trace_Slot_t trace_ring[TRACE_SIZE];
+static volatile uint32_t trace_head;		/**< Sequence number of the next entry	*/
+
+static const char *const trace_names[TRACE_EVENTS] = {
+		"boot", "button", "command", "clock", "debounce", "pattern", "poke",
+		"stop", "date", "rtc-cal"
+};
+
+/**
+  * @brief	Record an event (any context).
+  * @param[in] event	Event code.
+  * @param[in] arg		Event argument.
+  * @retval	None
+  */
+void Trace_Record(Trace_Event_t event, uint32_t arg)
+{
+	const uint32_t seq = Atomic_FetchAdd(&trace_head, 1U);
+	Trace_Slot_t *slot = &trace_ring[seq & TRACE_MASK];
+
+	slot->begin = seq + 1U;					/**< + 1: a blank slot (0) matches nothing		*/
+	__DMB();								/**< Readers see begin change before the data	*/
+	slot->entry.ms     = SysTick_GetTick();
+	slot->entry.cycles = DWT->CYCCNT;
+	slot->entry.arg    = arg;
+	slot->entry.event  = (uint8_t)event;
+	Atomic_StoreRelease(&slot->end, seq + 1U);
+}
+
+/**
+  * @brief	Sequence number of the next event (events recorded so far).
+  * @retval	Sequence number.
+  */
+uint32_t Trace_Head(void)
+{
+	return trace_head;
+}
+
+/**
+  * @brief	Copy one event by sequence number.
+  * @param[in] seq		Sequence number, Trace_Head() - TRACE_SIZE .. Trace_Head() - 1.
+  * @param[out] entry	Event.
+  * @retval	1 if the event is still in the ring, 0 if overwritten or not yet recorded.
+  */
+uint8_t Trace_Get(uint32_t seq, Trace_Entry_t *entry)
+{
+	const uint32_t age = trace_head - seq;		/**< 1 = newest							*/
+	const Trace_Slot_t *slot = &trace_ring[seq & TRACE_MASK];
+
+	if (age == 0U || age > TRACE_SIZE || Atomic_LoadAcquire(&slot->end) != seq + 1U)
+		return 0;								/**< Not in the ring, or still being written	*/
+	*entry = slot->entry;
+	__DMB();								/**< Copy done before begin is checked			*/
+	return (slot->begin == seq + 1U);			/**< Otherwise overwritten during the copy		*/
+}
+
+/**
+  * @brief	Name of an event code.
+  * @param[in] event	Event code.
+  * @retval	Short name.
+  */
+const char *Trace_Name(uint8_t event)
+{
+	return (event < TRACE_EVENTS) ? trace_names[event] : "?";
+}
@@ -0,0 +1,332 @@
+/**
+  * @file	uart.c
+  * @author	Parham Estiri
+  * @brief	USART2 console with DMA reception and transmission.
+  *
+  * 		Reception: DMA1 Stream5 writes into `uart_rx` forever (circular
+  * 		mode). The idle-line, half-transfer and transfer-complete
+  * 		interrupts turn the DMA position into a free-running byte count,
+  * 		`uart_rx_head`; with one of them at least every half buffer, no
+  * 		wrap is missed. UART_Read() copies from its own tail up to it.
+  *
+  * 		Transmission: UART_Write() appends to `uart_tx` and, if DMA is
+  * 		idle, starts it on the longest contiguous run. Each transfer-complete
+  * 		interrupt releases that run and starts the next one.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "uart.h"
+#include "clock.h"
+#include "atomic.h"
+#include "reg.h"
+#include "irq_plan.h"
+#include "vectors.h"
+
+#define UART_TX_PIN			2U			/**< PA2										*/
+#define UART_RX_PIN			3U			/**< PA3										*/
+#define UART_PINS			((1UL << UART_TX_PIN) | (1UL << UART_RX_PIN))
+#define UART_AF				7U			/**< USART1..3									*/
+#define UART_DMA_CHANNEL	4U			/**< USART2_RX on Stream5, USART2_TX on Stream6	*/
+#define UART_RX_FLAGS		(0x3DUL << 6)	/**< Stream5 flags in HIFCR				*/
+#define UART_TX_FLAGS		(0x3DUL << 16)	/**< Stream6 flags in HIFCR				*/
+#define UART_RX_MASK		(UART_RX_SIZE - 1U)
+#define UART_TX_MASK		(UART_TX_SIZE - 1U)
+#define UART_TX_CLAIMED		0xFFFFFFFFUL	/**< uart_tx_run: a writer is starting DMA	*/
+
+#if ((UART_RX_SIZE & UART_RX_MASK) != 0U) || ((UART_TX_SIZE & UART_TX_MASK) != 0U)
+#error "UART_RX_SIZE and UART_TX_SIZE must be powers of two"
+#endif
+
+static uint8_t uart_rx[UART_RX_SIZE];
+static volatile uint32_t uart_rx_head;		/**< Bytes received (written by interrupts)	*/
+static uint32_t uart_rx_tail;				/**< Bytes read									*/
+static uint32_t uart_rx_lost;
+
+static volatile uint32_t uart_tx_head;		/**< Bytes queued (read by the DMA interrupt)	*/
+static volatile uint32_t uart_tx_tail;		/**< Bytes sent (advanced by the DMA interrupt)	*/
+static uint32_t uart_tx_dropped;
+
+#if !defined(QEMU_NETDUINOPLUS2)
+static uint32_t uart_rx_pos;				/**< DMA position at the last update			*/
+static uint8_t uart_tx[UART_TX_SIZE];
+static volatile uint32_t uart_tx_run;		/**< Length of the running DMA transfer, 0: idle	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/**************************  Static Function Prototypes  ***************************/
+static void UART_Pins_Init(void);
+static void UART_IRQHandler(void);
+#if !defined(QEMU_NETDUINOPLUS2)
+static void UART_RxUpdate(void);
+static void UART_TxStart(void);
+static void UART_RxDma_IRQHandler(void);
+static void UART_TxDma_IRQHandler(void);
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/**
+  * @brief	Configure PA2/PA3, USART2 and both DMA streams, start reception.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  */
+void UART_Init(uint32_t baud)
+{
+	Clock_Enable(CLOCK_GPIOA, CLOCK_SLEEP_ON);	/**< Reception and DMA go on during WFI	*/
+	Clock_Enable(CLOCK_DMA1, CLOCK_SLEEP_ON);
+	Clock_Enable(CLOCK_USART2, CLOCK_SLEEP_ON);
+
+	UART_Pins_Init();
+
+	USART2->CR1 = 0;
+	UART_SetBaud(baud);
+	USART2->CR2 = 0;							/**< 1 stop bit								*/
+
+#if defined(QEMU_NETDUINOPLUS2)
+	USART2->CR3 = 0;
+	USART2->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE;
+#else
+	DMA1_Stream5->CR   = 0;
+	while (DMA1_Stream5->CR & DMA_SxCR_EN);
+	DMA1_Stream5->PAR  = (uint32_t)&USART2->DR;
+	DMA1_Stream5->M0AR = (uint32_t)uart_rx;
+	DMA1_Stream5->NDTR = UART_RX_SIZE;
+	DMA1_Stream5->FCR  = 0;
+	DMA1->HIFCR = UART_RX_FLAGS;
+	DMA1_Stream5->CR   = (UART_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+					   | DMA_SxCR_MINC | DMA_SxCR_CIRC		/**< Peripheral to memory, forever		*/
+					   | DMA_SxCR_HTIE | DMA_SxCR_TCIE
+					   | DMA_SxCR_EN;
+
+	DMA1_Stream6->CR   = 0;
+	while (DMA1_Stream6->CR & DMA_SxCR_EN);
+	DMA1_Stream6->PAR  = (uint32_t)&USART2->DR;
+	DMA1_Stream6->FCR  = 0;
+	DMA1_Stream6->CR   = (UART_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+					   | DMA_SxCR_MINC						/**< Byte transfers, memory increments	*/
+					   | DMA_SxCR_DIR_0						/**< Memory to peripheral				*/
+					   | DMA_SxCR_TCIE;
+	DMA1->HIFCR = UART_TX_FLAGS;
+
+	USART2->CR3 = USART_CR3_DMAR | USART_CR3_DMAT;
+	USART2->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE | USART_CR1_IDLEIE;
+
+	Vectors_Install(DMA1_Stream5_IRQn, UART_RxDma_IRQHandler);
+	Vectors_Install(DMA1_Stream6_IRQn, UART_TxDma_IRQHandler);
+	NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+	NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	Vectors_Install(USART2_IRQn, UART_IRQHandler);
+	NVIC_EnableIRQ(USART2_IRQn);				/**< Priorities: IRQ_PLAN (irq_plan.h)		*/
+}
+
+/**
+  * @brief	Recompute the baud rate divider from the current APB1 clock.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  * @note	Call after a clock change, once UART_TxIdle() returns 1.
+  */
+void UART_SetBaud(uint32_t baud)
+{
+	USART2->BRR = (System_GetPCLK1() + baud / 2U) / baud;	/**< 16x oversampling: BRR = PCLK1 / baud	*/
+}
+
+/**
+  * @brief	Take received bytes (never waits).
+  * @param[out] dst	Destination.
+  * @param[in] max	Destination size.
+  * @retval	Bytes copied.
+  */
+uint32_t UART_Read(uint8_t *dst, uint32_t max)
+{
+	const uint32_t head = uart_rx_head;
+	uint32_t n = head - uart_rx_tail;
+
+	if (n > UART_RX_SIZE)
+	{
+		uart_rx_lost += n - UART_RX_SIZE;			/**< Overwritten by DMA before being read	*/
+		uart_rx_tail = head - UART_RX_SIZE;
+		n = UART_RX_SIZE;
+	}
+	if (n > max)
+		n = max;
+
+	for (uint32_t i = 0; i < n; i++)
+		dst[i] = uart_rx[(uart_rx_tail + i) & UART_RX_MASK];
+	uart_rx_tail += n;
+	return n;
+}
+
+/**
+  * @brief	Queue bytes for transmission (never waits).
+  * @param[in] data	Bytes.
+  * @param[in] len	Number of bytes.
+  * @retval	Bytes queued; the rest was dropped.
+  */
+uint32_t UART_Write(const void *data, uint32_t len)
+{
+	const uint8_t *p = data;
+
+#if defined(QEMU_NETDUINOPLUS2)
+	for (uint32_t i = 0; i < len; i++)
+	{
+		while (!(USART2->SR & USART_SR_TXE));		/**< Always set: the model sends at once	*/
+		USART2->DR = p[i];
+	}
+	uart_tx_head += len;
+	uart_tx_tail = uart_tx_head;
+	return len;
+#else
+	const uint32_t free = UART_TxFree();
+	const uint32_t n = (len < free) ? len : free;
+	uint32_t idle = 0;								/**< Expected uart_tx_run				*/
+
+	for (uint32_t i = 0; i < n; i++)
+		uart_tx[(uart_tx_head + i) & UART_TX_MASK] = p[i];
+	Atomic_StoreRelease(&uart_tx_head, uart_tx_head + n);	/**< Bytes before the new head	*/
+	uart_tx_dropped += len - n;
+
+	/* Start DMA only if idle; otherwise its interrupt picks the bytes up */
+	if (Atomic_CompareExchange(&uart_tx_run, &idle, UART_TX_CLAIMED))
+		UART_TxStart();
+	return n;
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+/**
+  * @brief	Free space in the transmit ring.
+  * @retval	Bytes.
+  */
+uint32_t UART_TxFree(void)
+{
+	return UART_TX_SIZE - (uart_tx_head - uart_tx_tail);
+}
+
+/**
+  * @brief	Whether everything queued has left the shift register.
+  * @retval	1 if idle, 0 otherwise.
+  */
+uint8_t UART_TxIdle(void)
+{
+	return (uart_tx_head == uart_tx_tail) && (USART2->SR & USART_SR_TC);
+}
+
+/**
+  * @brief	Copy the console statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void UART_GetStats(UART_Stats_t *stats)
+{
+	stats->rx_bytes   = uart_rx_head;
+	stats->rx_lost    = uart_rx_lost;
+	stats->tx_bytes   = uart_tx_head;
+	stats->tx_dropped = uart_tx_dropped;
+}
+
+/**
+  * @brief	Put both UART pins in alternate-function mode, one access per register.
+  */
+static void UART_Pins_Init(void)
+{
+	REG_MODIFY(GPIOA->MODER, REG_PINS2_MSK(UART_PINS), REG_PINS2(UART_PINS, GPIO_MODE_AF));
+	GPIOA->OTYPER &= ~UART_PINS;
+	REG_MODIFY(GPIOA->OSPEEDR, REG_PINS2_MSK(UART_PINS), REG_PINS2(UART_PINS, GPIO_SPEED_HIGH));
+	REG_MODIFY(GPIOA->PUPDR, REG_PINS2_MSK(UART_PINS), REG_PIN2(UART_RX_PIN, GPIO_PULL_UP));	/**< RX idles high	*/
+	REG_MODIFY(GPIOA->AFR[0], REG_PIN4_MSK(UART_TX_PIN) | REG_PIN4_MSK(UART_RX_PIN),
+			   REG_PIN4(UART_TX_PIN, UART_AF) | REG_PIN4(UART_RX_PIN, UART_AF));	/**< PA2, PA3 in AFRL	*/
+}
+
+#if !defined(QEMU_NETDUINOPLUS2)
+
+/**
+  * @brief	Publish how far DMA has written (USART2 and Stream5 interrupts only).
+  */
+static void UART_RxUpdate(void)
+{
+	const uint32_t pos = (UART_RX_SIZE - DMA1_Stream5->NDTR) & UART_RX_MASK;
+
+	uart_rx_head += (pos - uart_rx_pos) & UART_RX_MASK;
+	uart_rx_pos = pos;
+}
+
+/**
+  * @brief	Start DMA on the next contiguous run of queued bytes.
+  * @note	Called from the Stream6 interrupt, or by UART_Write() after claiming
+  * 		an idle transmitter (uart_tx_run 0 -> UART_TX_CLAIMED): no transfer
+  * 		is running then, so the interrupt cannot enter meanwhile.
+  */
+static void UART_TxStart(void)
+{
+	const uint32_t tail = uart_tx_tail;
+	const uint32_t queued = Atomic_LoadAcquire(&uart_tx_head) - tail;
+	const uint32_t to_end = UART_TX_SIZE - (tail & UART_TX_MASK);
+	const uint32_t run = (queued < to_end) ? queued : to_end;
+
+	uart_tx_run = run;
+	if (run == 0U)
+		return;
+
+	DMA1->HIFCR = UART_TX_FLAGS;
+	DMA1_Stream6->M0AR = (uint32_t)&uart_tx[tail & UART_TX_MASK];
+	DMA1_Stream6->NDTR = run;
+	DMA1_Stream6->CR  |= DMA_SxCR_EN;
+}
+
+/**
+  * @brief	DMA1 Stream5 interrupt handler (USART2 RX half / full buffer).
+  */
+static void UART_RxDma_IRQHandler(void)
+{
+	const uint32_t start = IrqPlan_Enter();
+
+	DMA1->HIFCR = UART_RX_FLAGS;
+	UART_RxUpdate();
+	IrqPlan_Exit(IRQ_ID_DMA1_S5, start);
+}
+
+/**
+  * @brief	DMA1 Stream6 interrupt handler (USART2 TX run complete).
+  */
+static void UART_TxDma_IRQHandler(void)
+{
+	const uint32_t start = IrqPlan_Enter();
+
+	DMA1->HIFCR = UART_TX_FLAGS;
+	uart_tx_tail += uart_tx_run;
+	UART_TxStart();
+	IrqPlan_Exit(IRQ_ID_DMA1_S6, start);
+}
+
+/**
+  * @brief	USART2 interrupt handler (idle line: a burst of input has ended).
+  */
+static void UART_IRQHandler(void)
+{
+	const uint32_t start = IrqPlan_Enter();
+
+	if (USART2->SR & USART_SR_IDLE)
+	{
+		(void)USART2->DR;							/**< SR then DR read clears IDLE			*/
+		UART_RxUpdate();
+	}
+	IrqPlan_Exit(IRQ_ID_USART2, start);
+}
+
+#else
+
+/**
+  * @brief	USART2 interrupt handler (QEMU: one byte per interrupt, no DMA).
+  */
+static void UART_IRQHandler(void)
+{
+	const uint32_t start = IrqPlan_Enter();
+
+	while (USART2->SR & USART_SR_RXNE)
+	{
+		uart_rx[uart_rx_head & UART_RX_MASK] = (uint8_t)USART2->DR;
+		uart_rx_head++;
+	}
+	IrqPlan_Exit(IRQ_ID_USART2, start);
+}
+
+#endif /* QEMU_NETDUINOPLUS2 */
@@ -0,0 +1,97 @@
+/**
+  * @file	vectors.c
+  * @author	Parham Estiri
+  * @brief	SRAM vector table with handlers installed at run time.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <stddef.h>
+#include "vectors.h"
+
+#define VECTORS_INDEX(irqn)		((uint32_t)((int32_t)(irqn) + 16))	/**< Table word of an IRQn	*/
+
+_Static_assert(VECTORS_COUNT * 4U <= VECTORS_ALIGN, "vector table larger than its alignment");
+
+extern const uint32_t g_pfnVectors[];	/**< Flash table (startup_stm32f407vgtx.s)	*/
+
+static volatile uint32_t vectors_ram[VECTORS_COUNT] __attribute__((aligned(VECTORS_ALIGN)));	/**< Active table	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static uint8_t Vectors_Valid(IRQn_Type irqn);
+
+/**
+  * @brief	Copy the flash vector table to SRAM and switch VTOR to it.
+  * @retval	None
+  * @note	Called by System_Init(), before any handler is installed.
+  */
+void Vectors_Init(void)
+{
+	for (uint32_t i = 0; i < VECTORS_COUNT; i++)
+		vectors_ram[i] = g_pfnVectors[i];
+
+	__DMB();								/**< Table complete before it is used	*/
+	SCB->VTOR = (uint32_t)vectors_ram;
+	__DSB();								/**< Next exception uses the new table	*/
+}
+
+/**
+  * @brief	Install a handler for an exception or interrupt.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @param[in] handler	Handler; taken from the next exception entry on.
+  * @retval	Previous handler, or NULL if irqn is out of range (nothing installed).
+  */
+Vectors_Handler_t Vectors_Install(IRQn_Type irqn, Vectors_Handler_t handler)
+{
+	if (!Vectors_Valid(irqn))
+		return NULL;
+
+	const uint32_t index = VECTORS_INDEX(irqn);
+	const Vectors_Handler_t previous = (Vectors_Handler_t)vectors_ram[index];
+
+	vectors_ram[index] = (uint32_t)handler;
+	__DSB();								/**< Stored before a request can fetch it	*/
+	return previous;
+}
+
+/**
+  * @brief	Put the flash table entry of an exception or interrupt back.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @retval	None
+  */
+void Vectors_Restore(IRQn_Type irqn)
+{
+	if (Vectors_Valid(irqn))
+		(void)Vectors_Install(irqn, (Vectors_Handler_t)g_pfnVectors[VECTORS_INDEX(irqn)]);
+}
+
+/**
+  * @brief	Handler currently in the table.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @retval	Handler, or NULL if irqn is out of range.
+  */
+Vectors_Handler_t Vectors_Get(IRQn_Type irqn)
+{
+	return Vectors_Valid(irqn) ? (Vectors_Handler_t)vectors_ram[VECTORS_INDEX(irqn)] : NULL;
+}
+
+/**
+  * @brief	Whether an entry still holds the flash table handler.
+  * @param[in] irqn		NonMaskableInt_IRQn .. FPU_IRQn.
+  * @retval	1 if unchanged, 0 if a handler is installed.
+  */
+uint8_t Vectors_IsDefault(IRQn_Type irqn)
+{
+	return !Vectors_Valid(irqn) || vectors_ram[VECTORS_INDEX(irqn)] == g_pfnVectors[VECTORS_INDEX(irqn)];
+}
+
+/**
+  * @brief	Check that an IRQn has a handler entry.
+  * @param[in] irqn		IRQn.
+  * @retval	1 for NonMaskableInt_IRQn .. FPU_IRQn, 0 otherwise (stack pointer,
+  * 		reset and beyond the table).
+  */
+static uint8_t Vectors_Valid(IRQn_Type irqn)
+{
+	return (int32_t)irqn >= (int32_t)NonMaskableInt_IRQn && (int32_t)irqn <= (int32_t)FPU_IRQn;
+}
@@ -18,6 +18,8 @@
   * 	  with software debounce support using TIM7.
   * 	- The BSP_Button_Callback() is declared as a weak function and can be
   * 	  overridden by the user application.
+  * 	- QEMU builds (QEMU_NETDUINOPLUS2) debounce on TIM4 and treat a software
+  * 	  trigger of EXTI0 (EXTI->SWIER) as a button press, since GPIO is not emulated.
   *
   * @attention
   * 	This module is designed for CMSIS-level bare-metal projects and does NOT
@@ -29,11 +31,15 @@
   */
 
 #include "stm32f407g_disc1.h"
+#include "atomic.h"
+#include "reg.h"
+#include "irq_plan.h"
+#include "vectors.h"
 
 /** @defgroup STM32F407G_DISC1_BSP_Private_Macros STM32F407G-DISC1 BSP Private macros
   * @{
   */
-/** @brief	Debounce interval for the button in milliseconds. */
+/** @brief	Default debounce interval for the button in milliseconds. */
 #define BUTTON_DEBOUNCE_MS		20
 /**
   * @}
@@ -49,6 +55,14 @@ static const uint16_t LED_PIN[LEDn] = {
 		LED_RED_PIN,
 		LED_BLUE_PIN
 };
+
+/** @brief	Debounce interval in milliseconds, see BSP_Button_SetDebounce(). */
+static uint32_t button_debounce_ms = BUTTON_DEBOUNCE_MS;
+
+#if defined(QEMU_NETDUINOPLUS2)
+/** @brief	Virtual button level, latched by EXTI0 and released after the debounce check. */
+static volatile uint8_t qemu_button_pressed = 0;
+#endif /* QEMU_NETDUINOPLUS2 */
 /**
   * @}
   */
@@ -63,23 +77,19 @@ static const uint16_t LED_PIN[LEDn] = {
 
 /*
  * @brief	Initialize all LEDs on the board.
- * @details	Enables the GPIO clock for the LED port and configures all LED pins
+ * @details	Takes a reference on the GPIO clock of the LED port and configures all LED pins
  * 			as general purpose output push-pull with low speed.
  * @param	None
  * @retval	None
  */
 void BSP_LED_Init(void)
 {
-	LED_GPIO_CLK_EN();				/**< Enable clock for the GPIO port containing the LEDs	*/
+	Clock_Enable(LED_GPIO_CLK, CLOCK_SLEEP_OFF);	/**< Outputs hold their level while the core sleeps	*/
 
-	// Configure each LED pin as general purpose output mode
-	for (int i = 0; i < LEDn; i++)
-	{
-		LED_GPIO_PORT->MODER &= ~(3UL << (LED_PIN[i] * 2));		/**< Clear mode bits		*/
-		LED_GPIO_PORT->MODER |=  (1UL << (LED_PIN[i] * 2));		/**< Set pin as output		*/
-		LED_GPIO_PORT->OTYPER &= ~(1UL << LED_PIN[i]);			/**< Configure as push-pull	*/
-		LED_GPIO_PORT->OSPEEDR &= ~(3UL << LED_PIN[i]);			/**< Configure as low speed	*/
-	}
+	// Configure all LED pins as general purpose outputs, one access per register
+	REG_MODIFY(LED_GPIO_PORT->MODER, REG_PINS2_MSK(LED_PINS), REG_PINS2(LED_PINS, GPIO_MODE_OUTPUT));	/**< Output	*/
+	LED_GPIO_PORT->OTYPER &= ~LED_PINS;																/**< Push-pull	*/
+	REG_MODIFY(LED_GPIO_PORT->OSPEEDR, REG_PINS2_MSK(LED_PINS), REG_PINS2(LED_PINS, GPIO_SPEED_LOW));	/**< Low speed	*/
 }
 
 /*
@@ -117,7 +127,10 @@ void BSP_LED_Toggle(LED_TypeDef led)
 {
 	if (led < LEDn)		/**< Validate LED index	*/
 	{
-		LED_GPIO_PORT->ODR ^= (1UL << LED_PIN[led]);	/**< XOR the ODR bit to toggle LED */
+		const uint32_t bit = 1UL << LED_PIN[led];
+
+		/* One BSRR write: other pins of the port are never written back */
+		LED_GPIO_PORT->BSRR = (LED_GPIO_PORT->ODR & bit) ? (bit << 16) : bit;
 	}
 }
 /**
@@ -136,6 +149,12 @@ void BSP_Button_EXTI_Init(void);
 void BSP_Button_NVIC_Init(void);
 /** @brief	Initialize button debounce timer (TIM7). */
 static void BSP_Button_DebounceTimer_Init(void);
+/** @brief	Button EXTI line interrupt handler. */
+static void BSP_Button_EXTI_IRQHandler(void);
+/** @brief	Debounce timer interrupt handler. */
+static void BSP_Button_Debounce_IRQHandler(void);
+
+static uint32_t BSP_Button_TimerClock(void);
 
 /**
   * @brief	Initialize the user button GPIO and EXTI line.
@@ -151,7 +170,7 @@ static void BSP_Button_DebounceTimer_Init(void);
   */
 void BSP_Button_Init(ButtonMode_TypeDef Mode)
 {
-	BUTTON_GPIO_CLK_EN();		/**< Enable clock for the GPIO port containing the button	*/
+	Clock_Enable(BUTTON_GPIO_CLK, CLOCK_SLEEP_OFF);	/**< EXTI needs no port clock to wake up	*/
 	BSP_Button_GPIO_Init();		/**< Configure button pin as input with pull-down			*/
 
 	switch (Mode) {
@@ -174,7 +193,11 @@ void BSP_Button_Init(ButtonMode_TypeDef Mode)
   */
 uint8_t BSP_Button_Read(void)
 {
+#if defined(QEMU_NETDUINOPLUS2)
+	return qemu_button_pressed;		/**< GPIO is not emulated: report the latched EXTI0 trigger	*/
+#else
 	return ((BUTTON_GPIO_PORT->IDR & (1UL << BUTTON_PIN)) != 0) ? 1 : 0;	/**< Return pressed state	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 }
 
 /**
@@ -185,18 +208,14 @@ uint8_t BSP_Button_Read(void)
   */
 static __INLINE BSP_Button_GPIO_Init(void)
 {
-	BUTTON_GPIO_PORT->MODER &= ~(3UL << (BUTTON_PIN * 2));		/**< Set the pin as input	*/
-
-	BUTTON_GPIO_PORT->PUPDR &= ~(3UL << (BUTTON_PIN * 2));		/**< Clear pull bits		*/
-	BUTTON_GPIO_PORT->PUPDR |=  (2UL << (BUTTON_PIN * 2));		/**< Enable pull-down		*/
-
-	BUTTON_GPIO_PORT->OSPEEDR &= ~(3UL << (BUTTON_PIN * 2));	/**< Configure low speed	*/
+	REG_MODIFY(BUTTON_GPIO_PORT->MODER, REG_PIN2_MSK(BUTTON_PIN), REG_PIN2(BUTTON_PIN, GPIO_MODE_INPUT));	/**< Input		*/
+	REG_MODIFY(BUTTON_GPIO_PORT->PUPDR, REG_PIN2_MSK(BUTTON_PIN), REG_PIN2(BUTTON_PIN, GPIO_PULL_DOWN));	/**< Pull-down	*/
+	REG_MODIFY(BUTTON_GPIO_PORT->OSPEEDR, REG_PIN2_MSK(BUTTON_PIN), REG_PIN2(BUTTON_PIN, GPIO_SPEED_LOW));	/**< Low speed	*/
 }
 
 /**
   * @brief	Initialize the user button EXTI.
-  * @details	- Enables the SYSCFG clock.
-  * 			- Maps the button GPIO pin to the EXTI line.
+  * @details	- Maps the button GPIO pin to the EXTI line.
   * 			- Unmasks the EXTI interrupt and enables rising edge trigger.
   * 			- Clears any pending interrupt flag.
   * @param	None
@@ -204,10 +223,10 @@ static __INLINE BSP_Button_GPIO_Init(void)
   */
 void BSP_Button_EXTI_Init(void)
 {
-	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;			/**< Enable SYSCFG Clock */
-
+	Clock_Enable(CLOCK_SYSCFG, CLOCK_SLEEP_OFF);	/**< Only to write the register	*/
 	SYSCFG->EXTICR[0] &= ~SYSCFG_EXTICR1_EXTI0;		/**< Clear EXTICR[0] bits	*/
 	SYSCFG->EXTICR[0] |= SYSCFG_EXTICR1_EXTI0_PA;	/**< Route PA0 to EXTI0		*/
+	Clock_Disable(CLOCK_SYSCFG, CLOCK_SLEEP_OFF);	/**< The routing stays		*/
 
 	EXTI->IMR |= (1 << BUTTON_PIN);					/**< Unmask the interrupt request	*/
 
@@ -220,44 +239,90 @@ void BSP_Button_EXTI_Init(void)
 /**
   * @brief	Initialize NVIC for button EXTI.
   * @details	This function:
-  * 			- Retrieves the current NVIC priority grouping.
-  * 			- Sets preemptive and subpriority for the button EXTI interrupt.
+  * 			- Installs the EXTI handler in the vector table.
   * 			- Enables the EXTI interrupt in the NVIC.
   * @param	None
   * @retval	None
   *
-  * @note	Preemptive priority is set to 0x0E, subpriority to 0.
+  * @note	The priority comes from IRQ_PLAN (irq_plan.h).
   */
 void BSP_Button_NVIC_Init(void)
 {
-	uint32_t PG = NVIC_GetPriorityGrouping();		/**< Get priority grouping	*/
-	NVIC_SetPriority(BUTTON_EXTI_IRQn, NVIC_EncodePriority(PG, 0x0E, 0));		/**< Set interrupt priority	*/
+	Vectors_Install(BUTTON_EXTI_IRQn, BSP_Button_EXTI_IRQHandler);	/**< Bind the handler	*/
 	NVIC_EnableIRQ(BUTTON_EXTI_IRQn);				/**< Enable IRQ	*/
 }
 
 /**
-  * @brief	Initialize TIM7 debounce timer.
+  * @brief	Initialize TIM7 debounce timer (TIM4 in QEMU builds).
   * @details	This function:
-  * 				- Configures TIM7 in one-pulse mode with a 1kHz tick to generate
-  * 				  a software debounce interval defined by BUTTON_DEBOUNCE_MS.
-  * 			The timer update interrupt is enabled, and NVIC priority is set for TIM7.
+  * 				- Configures TIM7 in one-pulse mode with a BUTTON_DEBOUNCE_TICK_HZ
+  * 				  tick to generate a software debounce interval (BUTTON_DEBOUNCE_MS
+  * 				  until changed with BSP_Button_SetDebounce()).
+  * 			The timer update interrupt is enabled in TIM7 and in the NVIC.
+  * 			The timer clock is only on from the button edge to the end of
+  * 			the interval (BSP_Button_EXTI_IRQHandler() to the timer interrupt).
   * @param	None
   * @retval	None
   *
-  * @note	Preemptive priority is set to 0x0F, subpriority to 0.
+  * @note	The priority comes from IRQ_PLAN (irq_plan.h).
   */
 static void BSP_Button_DebounceTimer_Init(void)
 {
-	RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;				/**< Enable TIM7 clock			*/
+	Clock_Enable(BUTTON_DEBOUNCE_TIM_CLK, CLOCK_SLEEP_ON);	/**< Runs only during a debounce	*/
+	REG_SET(BUTTON_DEBOUNCE_TIM->CR1, TIM_CR1,
+			OPM, 1,									/**< One-pulse mode				*/
+			URS, 1);								/**< Only overflows interrupt	*/
+	BSP_Button_SetDebounce(button_debounce_ms);		/**< Prescaler and interval		*/
+	BUTTON_DEBOUNCE_TIM->DIER |= TIM_DIER_UIE;		/**< Enable update interrupt	*/
+	Clock_Disable(BUTTON_DEBOUNCE_TIM_CLK, CLOCK_SLEEP_ON);
+
+	Vectors_Install(BUTTON_DEBOUNCE_TIM_IRQn, BSP_Button_Debounce_IRQHandler);	/**< Bind the handler	*/
+	NVIC_EnableIRQ(BUTTON_DEBOUNCE_TIM_IRQn);		/**< Enable IRQ	*/
+}
 
-	TIM7->PSC = (SystemCoreClock / 1000) - 1;		/**< 1 kHz tick (1 ms)			*/
-	TIM7->ARR = BUTTON_DEBOUNCE_MS;					/**< Debounce interval			*/
-	TIM7->CR1 |= TIM_CR1_OPM;						/**< One-pulse mode				*/
-	TIM7->DIER |= TIM_DIER_UIE;						/**< Enable update interrupt	*/
+/**
+  * @brief	Set the debounce interval (EXTI mode).
+  * @param[in] ms	Interval in milliseconds, 1 .. BUTTON_DEBOUNCE_MS_MAX.
+  * @retval	1 if applied, 0 if out of range.
+  * @note	Also recomputes the timer prescaler from the current APB1 clock:
+  * 		call it again (with BSP_Button_GetDebounce()) after a clock change.
+  */
+uint8_t BSP_Button_SetDebounce(uint32_t ms)
+{
+	if (ms == 0U || ms > BUTTON_DEBOUNCE_MS_MAX)
+		return 0;
+
+	button_debounce_ms = ms;
+	Clock_Enable(BUTTON_DEBOUNCE_TIM_CLK, CLOCK_SLEEP_ON);	/**< Stopped between presses	*/
+	BUTTON_DEBOUNCE_TIM->PSC = BSP_Button_TimerClock() / BUTTON_DEBOUNCE_TICK_HZ - 1U;
+	BUTTON_DEBOUNCE_TIM->ARR = BUTTON_DEBOUNCE_TIM_ARR(ms);
+	BUTTON_DEBOUNCE_TIM->EGR = TIM_EGR_UG;			/**< Load PSC now (URS: no interrupt)	*/
+	Clock_Disable(BUTTON_DEBOUNCE_TIM_CLK, CLOCK_SLEEP_ON);
+	return 1;
+}
+
+/**
+  * @brief	Current debounce interval.
+  * @retval	Interval in milliseconds.
+  */
+uint32_t BSP_Button_GetDebounce(void)
+{
+	return button_debounce_ms;
+}
 
-	uint32_t PG = NVIC_GetPriorityGrouping();		/**< Get priority grouping	*/
-	NVIC_SetPriority(TIM7_IRQn, NVIC_EncodePriority(PG, 0x0F, 0));		/**< Set interrupt priority	*/
-	NVIC_EnableIRQ(TIM7_IRQn);						/**< Enable IRQ	*/
+/**
+  * @brief	Input clock of the debounce timer.
+  * @retval	Frequency in Hz (APB1 timer clock).
+  */
+static uint32_t BSP_Button_TimerClock(void)
+{
+#if defined(QEMU_NETDUINOPLUS2)
+	return QEMU_TIMER_CLK_HZ;
+#else
+	const uint32_t shift = APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+
+	return shift ? (SystemCoreClock >> shift) * 2U : SystemCoreClock;	/**< x2 unless APB1 is at /1	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 }
 
 /**
@@ -275,35 +340,53 @@ __WEAK void BSP_Button_Callback(void)
 }
 
 /**
-  * @brief	EXTI0 Interrupt Handler.
+  * @brief	EXTI0 Interrupt Handler, installed by BSP_Button_NVIC_Init().
   * @details	Clear pending flag, disables EXTI line, starts TIM7 for debounce.
   */
-void EXTI0_IRQHandler(void)
+static void BSP_Button_EXTI_IRQHandler(void)
 {
+	const uint32_t start = IrqPlan_Enter();
+
 	if (EXTI->PR & (1 << BUTTON_PIN))		/**< Check if EXTI0 pending	*/
 	{
 		EXTI->PR = (1 << BUTTON_PIN);		/**< Clear pending flag	*/
-		EXTI->IMR &= ~(1 << BUTTON_PIN);	/**< Disable EXTI line	*/
-		TIM7->CNT = 0;						/**< Reset counter		*/
-		TIM7->CR1 |= TIM_CR1_CEN;			/**< Start TIM7			*/
+		Atomic_BitClear(&EXTI->IMR, BUTTON_PIN);	/**< Disable EXTI line	*/
+#if defined(QEMU_NETDUINOPLUS2)
+		qemu_button_pressed = 1;			/**< Latch virtual press	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+		Clock_Enable(BUTTON_DEBOUNCE_TIM_CLK, CLOCK_SLEEP_ON);	/**< Released by the timer interrupt	*/
+		BUTTON_DEBOUNCE_TIM->CNT = 0;				/**< Reset counter		*/
+		Atomic_BitSet(&BUTTON_DEBOUNCE_TIM->CR1, TIM_CR1_CEN_Pos);	/**< Start debounce timer	*/
 	}
+	IrqPlan_Exit(IRQ_ID_EXTI0, start);
 }
 
 /**
-  * @brief	TIM7 Interrupt Handler for debounce.
+  * @brief	TIM7 Interrupt Handler for debounce (TIM4 in QEMU builds).
   * @details	Clear update flag, re-enables EXTI line, calls button callback if pressed.
+  * 			Installed by BSP_Button_DebounceTimer_Init().
   */
-void TIM7_IRQHandler(void)
+static void BSP_Button_Debounce_IRQHandler(void)
 {
-	if (TIM7->SR & TIM_SR_UIF)				/**< Check update flag		*/
+	const uint32_t start = IrqPlan_Enter();
+
+	if (BUTTON_DEBOUNCE_TIM->SR & TIM_SR_UIF)		/**< Check update flag		*/
 	{
-		TIM7->SR &= ~TIM_SR_UIF;			/**< Clear update flag		*/
-		EXTI->IMR |= (1 << BUTTON_PIN);		/**< Re-enable EXTI line	*/
+		BUTTON_DEBOUNCE_TIM->SR = ~TIM_SR_UIF;		/**< Clear update flag only (rc_w0)	*/
+#if defined(QEMU_NETDUINOPLUS2)
+		Atomic_BitClear(&BUTTON_DEBOUNCE_TIM->CR1, TIM_CR1_CEN_Pos);	/**< Stop timer: one-pulse mode is not emulated	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+		Clock_Disable(BUTTON_DEBOUNCE_TIM_CLK, CLOCK_SLEEP_ON);	/**< Debounce over: stop the timer clock	*/
+		Atomic_BitSet(&EXTI->IMR, BUTTON_PIN);	/**< Re-enable EXTI line	*/
 
 		if (BSP_Button_Read()) {			/**< If button still pressed */
 			BSP_Button_Callback();			/**< Call button callback	*/
 		}
+#if defined(QEMU_NETDUINOPLUS2)
+		qemu_button_pressed = 0;			/**< Release virtual press	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 	}
+	IrqPlan_Exit(IRQ_ID_DEBOUNCE, start);
 }
 /**
   * @}
@@ -31,6 +31,10 @@ extern "C" {
 
 #include "stm32f407xx.h"
 #include "assert.h"
+#include "clock.h"
+#if defined(QEMU_NETDUINOPLUS2)
+#include "qemu_board.h"
+#endif /* QEMU_NETDUINOPLUS2 */
 
 /** @defgroup STM32F407G_DISC1_BSP_Exported_Types STM32F407G-DISC1 BSP Exported types
   * @{
@@ -67,12 +71,14 @@ typedef enum {
 #define LEDn					4		/**< Total number of LEDs on board	*/
 
 #define LED_GPIO_PORT			GPIOD	/**< Port conneted to LEDs		*/
-#define LED_GPIO_CLK_EN()		(RCC->AHB1ENR |= RCC_AHB1ENR_GPIODEN)	/**< Enable port clock	*/
+#define LED_GPIO_CLK			CLOCK_GPIOD	/**< Port clock (clock.h)	*/
 
 #define LED_GREEN_PIN			12		/**< Pin number for Green LED	*/
 #define LED_ORANGE_PIN			13		/**< Pin number for Orange LED	*/
 #define LED_RED_PIN				14		/**< Pin number for Red LED		*/
 #define LED_BLUE_PIN			15		/**< Pin number for Blue LED	*/
+#define LED_PINS				((1UL << LED_GREEN_PIN) | (1UL << LED_ORANGE_PIN) \
+								| (1UL << LED_RED_PIN) | (1UL << LED_BLUE_PIN))	/**< All LED pins	*/
 /**
   * @}
   */
@@ -83,11 +89,26 @@ typedef enum {
 #define BUTTONn					1		/**< Total number of user buttons	*/
 
 #define BUTTON_GPIO_PORT		GPIOA	/**< Port conneted to user button	*/
-#define BUTTON_GPIO_CLK_EN()	(RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN)	/**< Enable port clock	*/
+#define BUTTON_GPIO_CLK			CLOCK_GPIOA	/**< Port clock (clock.h)		*/
 
 #define BUTTON_PIN				0		/**< Pin number for user button		*/
 
 #define BUTTON_EXTI_IRQn		EXTI0_IRQn	/**< External interrupt line for user button	*/
+
+#if defined(QEMU_NETDUINOPLUS2)
+/* TIM7 is not emulated by QEMU: debounce on TIM4 clocked at QEMU_TIMER_CLK_HZ */
+#define BUTTON_DEBOUNCE_TIM				TIM4			/**< Debounce timer instance		*/
+#define BUTTON_DEBOUNCE_TIM_IRQn		TIM4_IRQn		/**< Debounce timer interrupt		*/
+#define BUTTON_DEBOUNCE_TIM_CLK		CLOCK_TIM4		/**< Timer clock (clock.h)		*/
+#define BUTTON_DEBOUNCE_TICK_HZ			100000UL		/**< Timer tick						*/
+#else
+#define BUTTON_DEBOUNCE_TIM				TIM7			/**< Debounce timer instance		*/
+#define BUTTON_DEBOUNCE_TIM_IRQn		TIM7_IRQn		/**< Debounce timer interrupt		*/
+#define BUTTON_DEBOUNCE_TIM_CLK		CLOCK_TIM7		/**< Timer clock (clock.h)		*/
+#define BUTTON_DEBOUNCE_TICK_HZ			10000UL			/**< Timer tick (PSC fits 16 bits)	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+#define BUTTON_DEBOUNCE_TIM_ARR(ms)		((ms) * (BUTTON_DEBOUNCE_TICK_HZ / 1000UL))	/**< Ticks for a debounce interval	*/
+#define BUTTON_DEBOUNCE_MS_MAX			(0xFFFFUL / (BUTTON_DEBOUNCE_TICK_HZ / 1000UL))	/**< 16-bit ARR limit	*/
 /**
   * @}
   */
@@ -137,6 +158,21 @@ void BSP_Button_Init(ButtonMode_TypeDef Mode);
   * @retval	1 if pressed, 0 if released
   */
 uint8_t BSP_Button_Read(void);
+
+/**
+  * @brief	Set the debounce interval (EXTI mode).
+  * @param[in] ms	Interval in milliseconds, 1 .. BUTTON_DEBOUNCE_MS_MAX.
+  * @retval	1 if applied, 0 if out of range.
+  * @note	Also recomputes the timer prescaler from the current APB1 clock:
+  * 		call it again (with BSP_Button_GetDebounce()) after a clock change.
+  */
+uint8_t BSP_Button_SetDebounce(uint32_t ms);
+
+/**
+  * @brief	Current debounce interval.
+  * @retval	Interval in milliseconds.
+  */
+uint32_t BSP_Button_GetDebounce(void);
 /**
   * @}
   */
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Response-time analysis of the 03-Button_EXTI interrupt plan.
+
+Reads the IRQ_PLAN table of Core/Inc/irq_plan.h:
+
+    X(name, irqn, prio, wcet_cycles, period_us, deadline_us)
+
+and computes the worst-case response time of every entry with fixed-priority
+response-time analysis. An interrupt is delayed by every other entry of the
+same or a higher priority (a lower number): higher ones pre-empt it, equal
+ones are not pre-empted but may be taken first. Iterate to a fixed point:
+
+    R = C + B + sum over those j of ceil(R / T_j) * C_j
+
+with C the wcet plus the exception entry/exit overhead and B the longest
+time interrupts are masked elsewhere (--blocking). Every build configuration
+of the STM32CubeIDE project runs it as its pre-build step, at the slowest
+SYSCLK the firmware can switch to:
+
+    python3 Tools/irq_rta.py --sysclk 8000000
+
+The exit status is 1 when a deadline can be missed, 0 otherwise. The managed
+build ignores the exit status of pre-build steps, so irq_plan.c repeats the
+analysis at compile time with the same defaults (IRQ_PLAN_RTA_OVERHEAD and
+IRQ_PLAN_RTA_BLOCKING in irq_plan.h) and a missed deadline stops the build.
+This script prints the response time and slack of every entry, and other
+clocks, overheads or blocking times can be tried with it.
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              "..", "Core", "Inc", "irq_plan.h")
+
+ROW = re.compile(r"X\(\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*\)")
+
+
+def parse(path):
+    """Return the IRQ_PLAN rows of a header as a list of dicts, in table order."""
+    with open(path, encoding="utf-8") as fh:
+        text = fh.read()
+    start = text.find("#define IRQ_PLAN(X)")
+    if start < 0:
+        sys.exit(f"{path}: no IRQ_PLAN(X) table")
+
+    rows = []
+    for line in text[start:].splitlines()[1:]:
+        match = ROW.search(line)
+        if match is None:
+            break
+        name, irqn, prio, wcet, period, deadline = match.groups()
+        rows.append({
+            "name": name, "irqn": irqn, "prio": int(prio, 0),
+            "wcet": int(wcet, 0), "period": int(period, 0), "deadline": int(deadline, 0),
+        })
+        if not line.rstrip().endswith("\\"):
+            break
+    if not rows:
+        sys.exit(f"{path}: IRQ_PLAN(X) has no entries")
+    return rows
+
+
+def response_time(task, others, blocking):
+    """Fixed point of the response-time recurrence, or None past the deadline."""
+    r = task["c"] + blocking
+    while True:
+        nxt = task["c"] + blocking + sum(math.ceil(r / o["t"]) * o["c"] for o in others)
+        if nxt > task["d"]:
+            return None
+        if nxt == r:
+            return r
+        r = nxt
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--header", default=DEFAULT_HEADER,
+                        help="plan header (default: Core/Inc/irq_plan.h)")
+    parser.add_argument("--sysclk", type=int, default=8000000,
+                        help="SYSCLK in Hz (default: 8000000, HSE)")
+    parser.add_argument("--overhead", type=int, default=24,
+                        help="exception entry + exit cycles per activation (default: 24)")
+    parser.add_argument("--blocking", type=int, default=0,
+                        help="longest interrupt-masked section elsewhere, cycles (default: 0)")
+    args = parser.parse_args()
+
+    rows = parse(args.header)
+    errors = 0
+
+    seen = {}
+    for row in rows:
+        if row["irqn"] in seen:
+            print(f"error: {row['name']} and {seen[row['irqn']]} share {row['irqn']}")
+            errors += 1
+        seen[row["irqn"]] = row["name"]
+        if row["deadline"] > row["period"]:
+            print(f"error: {row['name']}: deadline after the next request")
+            errors += 1
+
+    cycles_per_us = args.sysclk / 1e6
+    for row in rows:
+        row["c"] = row["wcet"] + args.overhead
+        row["t"] = row["period"] * cycles_per_us
+        row["d"] = row["deadline"] * cycles_per_us
+
+    utilization = sum(row["c"] / row["t"] for row in rows)
+
+    print(f"{'name':<10} {'prio':>4} {'C':>7} {'T':>9} {'D':>9} {'R':>9} {'slack':>7}")
+    for row in rows:
+        others = [o for o in rows if o is not row and o["prio"] <= row["prio"]]
+        r = response_time(row, others, args.blocking)
+        if r is None:
+            print(f"{row['name']:<10} {row['prio']:>4} {row['c']:>7} {row['t']:>9.0f} {row['d']:>9.0f} "
+                  f"{'>D':>9} {'':>7}  MISSES DEADLINE")
+            errors += 1
+            continue
+        slack = 100.0 * (row["d"] - r) / row["d"]
+        print(f"{row['name']:<10} {row['prio']:>4} {row['c']:>7} {row['t']:>9.0f} {row['d']:>9.0f} "
+              f"{r:>9} {slack:>6.1f}%")
+
+    print(f"\ncycles at {args.sysclk} Hz, utilization {100.0 * utilization:.1f}%, "
+          f"{errors} error(s)")
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
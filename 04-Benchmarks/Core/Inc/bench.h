@@ -0,0 +1,171 @@
+/**
+  * @file	bench.h
+  * @author	Parham Estiri
+  * @brief	Cycle-accurate micro-benchmark framework based on DWT CYCCNT.
+  *
+  * 		This module provides:
+  * 		 - DWT cycle counter initialization and inline time stamps
+  * 		 - Min/avg/max statistics over repeated samples
+  * 		 - Machine-readable result output over ITM stimulus port 0 (SWO)
+  * 		 - Benchmark suite entry points (GPIO, ISR latency, delays, memory)
+  *
+  * 		Every result is emitted as one CSV line:
+  * 		`BENCH,<suite>,<case>,<ops>,<expected>,<min>,<avg>,<max>`
+  * 		where min/avg/max are cycles per sample of `ops` operations and
+  * 		`expected` is the nominal cycle count (0 when not applicable).
+  * 		A run is framed by `BENCH_BEGIN,<sysclk_hz>` and `BENCH_END` lines.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+#include "stm32f407xx.h"
+
+/******************************  Configuration  ******************************/
+#define BENCH_SAMPLES			16U		/**< Number of samples taken per benchmark case	*/
+#define BENCH_RESULTS_MAX		128U		/**< Capacity of the in-RAM result table		*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Statistics of one benchmark case.
+  */
+typedef struct {
+	const char	*suite;		/**< Suite name (e.g. "gpio")					*/
+	const char	*name;		/**< Case name (e.g. "odr_xor")					*/
+	uint32_t	ops;		/**< Operations measured per sample				*/
+	uint32_t	expected;	/**< Nominal cycles per sample, 0 if none		*/
+	uint32_t	min;		/**< Minimum cycles per sample					*/
+	uint32_t	max;		/**< Maximum cycles per sample					*/
+	uint32_t	sum;		/**< Sum of cycles over all samples				*/
+	uint32_t	samples;	/**< Number of samples accumulated				*/
+} Bench_Result_t;
+
+/******************************  Inline Functions  ******************************/
+
+/**
+  * @brief	Read the DWT cycle counter.
+  * @retval	Current core cycle count.
+  */
+static inline uint32_t Bench_Cycles(void)
+{
+	return DWT->CYCCNT;
+}
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Enable the DWT cycle counter and calibrate the time stamp overhead.
+  * @param	None
+  * @retval	None
+  * @note	Must be called after System_Init() and before any benchmark suite.
+  */
+void Bench_Init(void);
+
+/**
+  * @brief	Cycles consumed by a back-to-back pair of Bench_Cycles() reads.
+  * @retval	Overhead in cycles, subtracted by Bench_Add().
+  */
+uint32_t Bench_Overhead(void);
+
+/**
+  * @brief	Start a benchmark case.
+  * @param[in] suite		Suite name.
+  * @param[in] name			Case name.
+  * @param[in] ops			Operations measured per sample.
+  * @param[in] expected		Nominal cycles per sample (0 if not applicable).
+  * @retval	Pointer to the result slot, or NULL if the result table is full.
+  */
+Bench_Result_t *Bench_Open(const char *suite, const char *name, uint32_t ops, uint32_t expected);
+
+/**
+  * @brief	Accumulate one sample into a benchmark case.
+  * @param[in,out] result	Result slot returned by Bench_Open().
+  * @param[in] cycles		Raw cycles measured between two Bench_Cycles() stamps.
+  * @retval	None
+  */
+void Bench_Add(Bench_Result_t *result, uint32_t cycles);
+
+/**
+  * @brief	Emit a finished benchmark case as a `BENCH,...` line.
+  * @param[in] result	Result slot returned by Bench_Open().
+  * @retval	None
+  */
+void Bench_Close(const Bench_Result_t *result);
+
+/**
+  * @brief	Emit the `BENCH_BEGIN` line and clear the result table.
+  */
+void Bench_Begin(void);
+
+/**
+  * @brief	Emit the `BENCH_END` line.
+  */
+void Bench_End(void);
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  * @param[in] str	Null-terminated string.
+  * @retval	None
+  * @note	Characters are dropped when no debugger has enabled the ITM.
+  */
+void Bench_Print(const char *str);
+
+/**
+  * @brief	Write an unsigned decimal number to ITM stimulus port 0.
+  * @param[in] value	Number to print.
+  * @retval	None
+  */
+void Bench_PrintU32(uint32_t value);
+
+/**
+  * @brief	Write a 32-bit number as `0x%08X` to ITM stimulus port 0.
+  * @param[in] value	Number to print.
+  * @retval	None
+  */
+void Bench_PrintHex32(uint32_t value);
+
+/**
+  * @brief	GPIO toggle rate (ODR XOR, BSRR, bit-band) and BSP_LED_* call overhead.
+  */
+void Bench_GPIO_Run(void);
+
+/**
+  * @brief	Interrupt entry and exit latency for EXTI and TIM interrupts.
+  */
+void Bench_ISR_Run(void);
+
+/**
+  * @brief	Accuracy and overshoot of Delay_us(), Delay_ms() and SysTick_delay_ms().
+  */
+void Bench_Delay_Run(void);
+
+/**
+  * @brief	Flash vs SRAM execution and flash/SRAM/CCM data access for every
+  * 		combination of the FLASH_ACR ICEN, DCEN and PRFTEN bits.
+  */
+void Bench_Memory_Run(void);
+
+/**
+  * @brief	Linear vs branchy code executed from flash for several wait-state,
+  * 		prefetch and instruction cache settings.
+  */
+void Bench_Flash_Run(void);
+
+/**
+  * @brief	Sampling profiler overhead on a fixed workload at 1 kHz and 10 kHz.
+  */
+void Bench_Profiler_Run(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BENCH_H_ */
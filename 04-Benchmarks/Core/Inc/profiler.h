@@ -0,0 +1,155 @@
+/**
+  * @file	profiler.h
+  * @author	Parham Estiri
+  * @brief	Statistical (sampling) profiler based on a periodic timer interrupt.
+  *
+  * 		This module provides:
+  * 		 - A timer interrupt (TIM5, 100 Hz to 10 kHz) that reads the stacked PC
+  * 		   of the interrupted context, thread or handler mode
+  * 		 - A hash-bucketed PC histogram kept in RAM
+  * 		 - Start/stop/reset/dump commands, callable from code or written
+  * 		   by a debugger into `prof_command` and executed by Prof_Poll()
+  * 		 - Histogram output over ITM stimulus port 0 (SWO):
+  * 		   `PROF_BEGIN,<rate_hz>,<samples>,<dropped>,<overhead_ppm>`,
+  * 		   one `PROF,<pc>,<count>` line per bucket and `PROF_END`
+  *
+  * 		Bit 0 of a dumped PC is set when the sample hit handler mode (an
+  * 		ISR); Tools/prof_symbolize.py uses it as the root of the flame graph.
+  *
+  * @note	Interrupts with the same or a higher priority than PROF_PRIORITY
+  * 		are not sampled while they run.
+  * @note	QEMU builds use TIM3, since TIM5 stands in for TIM6 in delay.c.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+#if defined(QEMU_NETDUINOPLUS2)
+#include "qemu_board.h"
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/******************************  Configuration  ******************************/
+#define PROF_BUCKETS_LOG2		9U		/**< 512 histogram buckets (8 bytes each)			*/
+#define PROF_PROBE_MAX			8U		/**< Linear probes before a sample is dropped		*/
+#define PROF_PC_SHIFT			1U		/**< PC granularity: 1 = exact, 4 = 16-byte blocks	*/
+#define PROF_PRIORITY			0x00U	/**< Sampling interrupt pre-emption priority		*/
+#define PROF_RATE_MIN_HZ		100U	/**< Lowest sampling rate							*/
+#define PROF_RATE_MAX_HZ		10000U	/**< Highest sampling rate							*/
+#define PROF_RATE_DEFAULT_HZ	1000U	/**< Default sampling rate							*/
+
+#define PROF_BUCKETS			(1UL << PROF_BUCKETS_LOG2)
+
+/******************************  Timer Selection  ******************************/
+#if defined(QEMU_NETDUINOPLUS2)
+#define PROF_TIM				TIM3
+#define PROF_TIM_IRQn			TIM3_IRQn
+#define PROF_TIM_IRQHandler		TIM3_IRQHandler
+#define PROF_TIM_CLK_EN()		(RCC->APB1ENR |= RCC_APB1ENR_TIM3EN)	/**< Enable timer clock	*/
+#define PROF_TIM_CLK_HZ			QEMU_TIMER_CLK_HZ
+#else
+#define PROF_TIM				TIM5
+#define PROF_TIM_IRQn			TIM5_IRQn
+#define PROF_TIM_IRQHandler		TIM5_IRQHandler
+#define PROF_TIM_CLK_EN()		(RCC->APB1ENR |= RCC_APB1ENR_TIM5EN)	/**< Enable timer clock	*/
+#define PROF_TIM_CLK_HZ			(SystemCoreClock / 2U)	/**< APB1 /4, timer clock x2 (84 MHz)	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+
+#define PROF_PC_HANDLER			0x1UL	/**< Dumped PC flag: sample taken in handler mode	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Commands accepted by Prof_Command() and Prof_Poll().
+  */
+typedef enum {
+	PROF_CMD_NONE	= 0,	/**< Nothing pending						*/
+	PROF_CMD_START	= 1,	/**< Start sampling at the last used rate	*/
+	PROF_CMD_STOP	= 2,	/**< Stop sampling							*/
+	PROF_CMD_RESET	= 3,	/**< Clear the histogram					*/
+	PROF_CMD_DUMP	= 4		/**< Dump the histogram over ITM			*/
+} Prof_Cmd_t;
+
+/**
+  * @brief	Profiler statistics.
+  */
+typedef struct {
+	uint32_t	rate_hz;		/**< Sampling rate							*/
+	uint32_t	samples;		/**< Samples recorded in the histogram		*/
+	uint32_t	dropped;		/**< Samples lost to full probe chains		*/
+	uint32_t	isr_cycles;		/**< Cycles spent in the sampling code		*/
+	uint32_t	overhead_ppm;	/**< Estimated CPU share, parts per million	*/
+} Prof_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure the sampling timer and its interrupt (stopped).
+  * @param	None
+  * @retval	None
+  * @note	Requires the DWT cycle counter (Bench_Init()) for overhead accounting.
+  */
+void Prof_Init(void);
+
+/**
+  * @brief	Start sampling.
+  * @param[in] rate_hz	Sampling rate, clamped to PROF_RATE_MIN_HZ..PROF_RATE_MAX_HZ.
+  * @retval	None
+  */
+void Prof_Start(uint32_t rate_hz);
+
+/**
+  * @brief	Stop sampling. The histogram is kept.
+  * @param	None
+  * @retval	None
+  */
+void Prof_Stop(void);
+
+/**
+  * @brief	Clear the histogram and statistics.
+  * @param	None
+  * @retval	None
+  */
+void Prof_Reset(void);
+
+/**
+  * @brief	Write the histogram to ITM stimulus port 0.
+  * @param	None
+  * @retval	None
+  * @note	Sampling is paused during the dump and resumed afterwards.
+  */
+void Prof_Dump(void);
+
+/**
+  * @brief	Read the profiler statistics.
+  * @param[out] stats	Destination.
+  * @retval	None
+  */
+void Prof_GetStats(Prof_Stats_t *stats);
+
+/**
+  * @brief	Queue a command for the next Prof_Poll().
+  * @param[in] cmd	Command.
+  * @retval	None
+  */
+void Prof_Command(Prof_Cmd_t cmd);
+
+/**
+  * @brief	Execute a pending command (from Prof_Command() or the debugger).
+  * @param	None
+  * @retval	None
+  * @note	Call from the main loop.
+  */
+void Prof_Poll(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PROFILER_H_ */
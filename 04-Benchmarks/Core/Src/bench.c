@@ -0,0 +1,197 @@
+/**
+  * @file	bench.c
+  * @author	Parham Estiri
+  * @brief	Cycle-accurate micro-benchmark framework based on DWT CYCCNT.
+  *
+  * 		This file provides:
+  * 		 - DWT cycle counter initialization and overhead calibration
+  * 		 - Result table kept in RAM (readable with a debugger)
+  * 		 - CSV result output over ITM stimulus port 0 (SWO)
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "bench.h"
+
+static Bench_Result_t bench_results[BENCH_RESULTS_MAX];	/**< Result table of the current run		*/
+static uint32_t bench_count = 0;						/**< Number of used result slots			*/
+static uint32_t bench_overhead = 0;						/**< Cycles of an empty stamp pair			*/
+
+/**
+  * @brief	Enable the DWT cycle counter and calibrate the time stamp overhead.
+  * @param	None
+  * @retval	None
+  * @note	Must be called after System_Init() and before any benchmark suite.
+  */
+void Bench_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;		/**< Enable trace (DWT and ITM) blocks	*/
+	DWT->CYCCNT = 0;									/**< Reset cycle counter				*/
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;				/**< Start cycle counter				*/
+
+	uint32_t best = 0xFFFFFFFFUL;
+	for (uint32_t i = 0; i < BENCH_SAMPLES; i++)		/**< Keep the smallest empty measurement	*/
+	{
+		uint32_t t0 = Bench_Cycles();
+		uint32_t t1 = Bench_Cycles();
+		if ((t1 - t0) < best)
+			best = t1 - t0;
+	}
+	bench_overhead = best;
+}
+
+/**
+  * @brief	Cycles consumed by a back-to-back pair of Bench_Cycles() reads.
+  * @retval	Overhead in cycles, subtracted by Bench_Add().
+  */
+uint32_t Bench_Overhead(void)
+{
+	return bench_overhead;
+}
+
+/**
+  * @brief	Start a benchmark case.
+  * @param[in] suite		Suite name.
+  * @param[in] name			Case name.
+  * @param[in] ops			Operations measured per sample.
+  * @param[in] expected		Nominal cycles per sample (0 if not applicable).
+  * @retval	Pointer to the result slot, or NULL if the result table is full.
+  */
+Bench_Result_t *Bench_Open(const char *suite, const char *name, uint32_t ops, uint32_t expected)
+{
+	if (bench_count >= BENCH_RESULTS_MAX)		/**< Result table full	*/
+		return NULL;
+
+	Bench_Result_t *r = &bench_results[bench_count++];
+	r->suite	= suite;
+	r->name		= name;
+	r->ops		= ops;
+	r->expected	= expected;
+	r->min		= 0xFFFFFFFFUL;
+	r->max		= 0;
+	r->sum		= 0;
+	r->samples	= 0;
+	return r;
+}
+
+/**
+  * @brief	Accumulate one sample into a benchmark case.
+  * @param[in,out] result	Result slot returned by Bench_Open().
+  * @param[in] cycles		Raw cycles measured between two Bench_Cycles() stamps.
+  * @retval	None
+  */
+void Bench_Add(Bench_Result_t *result, uint32_t cycles)
+{
+	if (result == NULL)
+		return;
+
+	cycles = (cycles > bench_overhead) ? (cycles - bench_overhead) : 0;	/**< Remove stamp overhead	*/
+
+	if (cycles < result->min)
+		result->min = cycles;
+	if (cycles > result->max)
+		result->max = cycles;
+	result->sum += cycles;
+	result->samples++;
+}
+
+/**
+  * @brief	Emit a finished benchmark case as a `BENCH,...` line.
+  * @param[in] result	Result slot returned by Bench_Open().
+  * @retval	None
+  */
+void Bench_Close(const Bench_Result_t *result)
+{
+	if (result == NULL || result->samples == 0)
+		return;
+
+	Bench_Print("BENCH,");
+	Bench_Print(result->suite);
+	Bench_Print(",");
+	Bench_Print(result->name);
+	Bench_Print(",");
+	Bench_PrintU32(result->ops);
+	Bench_Print(",");
+	Bench_PrintU32(result->expected);
+	Bench_Print(",");
+	Bench_PrintU32(result->min);
+	Bench_Print(",");
+	Bench_PrintU32(result->sum / result->samples);
+	Bench_Print(",");
+	Bench_PrintU32(result->max);
+	Bench_Print("\n");
+}
+
+/**
+  * @brief	Emit the `BENCH_BEGIN` line and clear the result table.
+  */
+void Bench_Begin(void)
+{
+	bench_count = 0;
+
+	Bench_Print("BENCH_BEGIN,");
+	Bench_PrintU32(SystemCoreClock);
+	Bench_Print("\n");
+}
+
+/**
+  * @brief	Emit the `BENCH_END` line.
+  */
+void Bench_End(void)
+{
+	Bench_Print("BENCH_END\n");
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  * @param[in] str	Null-terminated string.
+  * @retval	None
+  * @note	Characters are dropped when no debugger has enabled the ITM.
+  */
+void Bench_Print(const char *str)
+{
+	while (*str)
+	{
+		ITM_SendChar((uint32_t)*str++);		/**< No-op when ITM/port 0 is disabled	*/
+	}
+}
+
+/**
+  * @brief	Write an unsigned decimal number to ITM stimulus port 0.
+  * @param[in] value	Number to print.
+  * @retval	None
+  */
+void Bench_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf) - 1;
+
+	buf[i] = '\0';
+	do {
+		buf[--i] = (char)('0' + (value % 10U));
+		value /= 10U;
+	} while (value != 0);
+
+	Bench_Print(&buf[i]);
+}
+
+/**
+  * @brief	Write a 32-bit number as `0x%08X` to ITM stimulus port 0.
+  * @param[in] value	Number to print.
+  * @retval	None
+  */
+void Bench_PrintHex32(uint32_t value)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	char buf[11];
+
+	buf[0] = '0';
+	buf[1] = 'x';
+	for (uint32_t i = 0; i < 8U; i++)
+	{
+		buf[2 + i] = hex[(value >> (28U - 4U * i)) & 0xFU];
+	}
+	buf[10] = '\0';
+
+	Bench_Print(buf);
+}
@@ -0,0 +1,77 @@
+/**
+  * @file	bench_delay.c
+  * @author	Parham Estiri
+  * @brief	Accuracy and overshoot benchmarks for the blocking delay functions.
+  *
+  * 		Each case reports the nominal delay as `expected` cycles, so the
+  * 		overshoot is `avg - expected` and the jitter is `max - min`:
+  * 		 - Delay_us() / Delay_ms() (TIM6 one-pulse mode)
+  * 		 - SysTick_delay_ms() (1 ms SysTick tick, WFI between ticks)
+  *
+  * @note	CYCCNT keeps counting across WFI because System_Init() sets
+  * 		DBGMCU_CR_DBG_SLEEP, which keeps HCLK running in sleep mode.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "bench.h"
+#include "delay.h"
+#include "systick.h"
+
+/** @brief	Microsecond delays measured with Delay_us(). */
+static const uint32_t bench_delay_us[] = { 1U, 10U, 100U, 1000U };
+
+/** @brief	Case names matching bench_delay_us[]. */
+static const char *const bench_delay_us_name[] = { "delay_us_1", "delay_us_10", "delay_us_100", "delay_us_1000" };
+
+/** @brief	Millisecond delays measured with SysTick_delay_ms(). */
+static const uint32_t bench_systick_ms[] = { 1U, 10U };
+
+/** @brief	Case names matching bench_systick_ms[]. */
+static const char *const bench_systick_ms_name[] = { "systick_delay_ms_1", "systick_delay_ms_10" };
+
+/**
+  * @brief	Accuracy and overshoot of Delay_us(), Delay_ms() and SysTick_delay_ms().
+  */
+void Bench_Delay_Run(void)
+{
+	const uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+
+	for (uint32_t c = 0; c < sizeof(bench_delay_us) / sizeof(bench_delay_us[0]); c++)
+	{
+		Bench_Result_t *r = Bench_Open("delay", bench_delay_us_name[c], 1, bench_delay_us[c] * cycles_per_us);
+
+		for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+		{
+			uint32_t t0 = Bench_Cycles();
+			Delay_us(bench_delay_us[c]);
+			uint32_t t1 = Bench_Cycles();
+			Bench_Add(r, t1 - t0);
+		}
+		Bench_Close(r);
+	}
+
+	Bench_Result_t *ms = Bench_Open("delay", "delay_ms_1", 1, 1000U * cycles_per_us);
+	for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+	{
+		uint32_t t0 = Bench_Cycles();
+		Delay_ms(1);
+		uint32_t t1 = Bench_Cycles();
+		Bench_Add(ms, t1 - t0);
+	}
+	Bench_Close(ms);
+
+	for (uint32_t c = 0; c < sizeof(bench_systick_ms) / sizeof(bench_systick_ms[0]); c++)
+	{
+		Bench_Result_t *r = Bench_Open("delay", bench_systick_ms_name[c], 1, bench_systick_ms[c] * 1000U * cycles_per_us);
+
+		for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+		{
+			uint32_t t0 = Bench_Cycles();
+			SysTick_delay_ms(bench_systick_ms[c]);
+			uint32_t t1 = Bench_Cycles();
+			Bench_Add(r, t1 - t0);
+		}
+		Bench_Close(r);
+	}
+}
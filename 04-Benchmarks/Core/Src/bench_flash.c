@@ -0,0 +1,163 @@
+/**
+  * @file	bench_flash.c
+  * @author	Parham Estiri
+  * @brief	Linear vs branchy code throughput from flash under several
+  * 		wait-state, prefetch and instruction cache settings.
+  *
+  * 		Two kernels run from flash with their data in SRAM:
+  * 		 - linear:  512 unrolled rotate/add steps (about 2 KB of straight-line
+  * 		            code, larger than the 1 KB instruction cache)
+  * 		 - branchy: 256 iterations of a data-dependent switch over
+  * 		            pseudo-random selectors (taken branches every iteration)
+  *
+  * 		Each kernel is measured at the minimum LATENCY for the current HCLK,
+  * 		one wait state above it and at the maximum (7), with prefetch and
+  * 		instruction cache on/off. The data cache stays enabled.
+  *
+  * 		Case names are `<kernel>_ws<n>_pf<0|1>_ic<0|1>`.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "bench.h"
+#include "flash.h"
+
+#define BENCH_FLASH_LINEAR_OPS	512U		/**< Unrolled steps in the linear kernel		*/
+#define BENCH_FLASH_BRANCHY_OPS	256U		/**< Iterations of the branchy kernel			*/
+#define BENCH_FLASH_NAME_LEN	24U			/**< Maximum case name length (with terminator)	*/
+#define BENCH_FLASH_WS_SETS		3U			/**< Minimum, minimum + 1, maximum				*/
+#define BENCH_FLASH_CASES		(2U * BENCH_FLASH_WS_SETS * 4U)	/**< kernel x WS x (PF, IC)	*/
+
+#define BENCH_FLASH_STEP(k)		x = ((x << 7) | (x >> 25)) + (k);	/**< Rotate-left by 7, add	*/
+#define BENCH_FLASH_STEP4		BENCH_FLASH_STEP(0x9E3779B9UL) BENCH_FLASH_STEP(0x7F4A7C15UL) \
+								BENCH_FLASH_STEP(0x85EBCA6BUL) BENCH_FLASH_STEP(0xC2B2AE35UL)
+#define BENCH_FLASH_STEP16		BENCH_FLASH_STEP4 BENCH_FLASH_STEP4 BENCH_FLASH_STEP4 BENCH_FLASH_STEP4
+#define BENCH_FLASH_STEP128		BENCH_FLASH_STEP16 BENCH_FLASH_STEP16 BENCH_FLASH_STEP16 BENCH_FLASH_STEP16 \
+								BENCH_FLASH_STEP16 BENCH_FLASH_STEP16 BENCH_FLASH_STEP16 BENCH_FLASH_STEP16
+
+static uint8_t bench_flash_sel[BENCH_FLASH_BRANCHY_OPS];			/**< Branch selectors (SRAM)	*/
+static char bench_flash_names[BENCH_FLASH_CASES][BENCH_FLASH_NAME_LEN];	/**< Generated case names	*/
+
+/**
+  * @brief	Linear kernel: long straight-line sequence without branches.
+  * @param[in] x	Seed.
+  * @retval	Result (keeps the code from being optimized away).
+  */
+static __attribute__((noinline)) uint32_t Bench_Flash_Linear(uint32_t x)
+{
+	BENCH_FLASH_STEP128
+	BENCH_FLASH_STEP128
+	BENCH_FLASH_STEP128
+	BENCH_FLASH_STEP128
+	return x;
+}
+
+/**
+  * @brief	Branchy kernel: data-dependent switch and conditionals per element.
+  * @param[in] sel	Selector array.
+  * @param[in] n		Number of selectors.
+  * @retval	Result (keeps the code from being optimized away).
+  */
+static __attribute__((noinline)) uint32_t Bench_Flash_Branchy(const uint8_t *sel, uint32_t n)
+{
+	uint32_t acc = 0x811C9DC5UL;
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		switch (sel[i] & 7U)
+		{
+			case 0:  acc += 0x9E3779B9UL;			break;
+			case 1:  acc ^= acc >> 7;				break;
+			case 2:  acc = (acc << 3) | (acc >> 29);	break;
+			case 3:  acc -= 0x7F4A7C15UL;			break;
+			case 4:  acc ^= acc << 11;				break;
+			case 5:  acc += i;						break;
+			case 6:  acc = ~acc;					break;
+			default: acc *= 33U;					break;
+		}
+
+		if (sel[i] & 0x80U)
+			acc ^= 0x5A5A5A5AUL;
+		else if (sel[i] & 0x40U)
+			acc += 1U;
+	}
+	return acc;
+}
+
+/**
+  * @brief	Build a case name `<kernel>_ws<n>_pf<n>_ic<n>`.
+  * @retval	Pointer to the generated name.
+  */
+static const char *Bench_Flash_Name(uint32_t index, const char *kernel, uint32_t ws,
+									uint32_t prften, uint32_t icen)
+{
+	char *p = bench_flash_names[index];
+
+	while (*kernel) *p++ = *kernel++;
+	*p++ = '_'; *p++ = 'w'; *p++ = 's'; *p++ = (char)('0' + ws);
+	*p++ = '_'; *p++ = 'p'; *p++ = 'f'; *p++ = (char)('0' + prften);
+	*p++ = '_'; *p++ = 'i'; *p++ = 'c'; *p++ = (char)('0' + icen);
+	*p = '\0';
+
+	return bench_flash_names[index];
+}
+
+/**
+  * @brief	Linear vs branchy code executed from flash for several wait-state,
+  * 		prefetch and instruction cache settings.
+  */
+void Bench_Flash_Run(void)
+{
+	const uint32_t acr_saved = FLASH->ACR;
+	const uint32_t ws_min = Flash_GetLatency(SystemCoreClock, FLASH_VRANGE_BOARD);
+	uint32_t ws_set[BENCH_FLASH_WS_SETS] = { ws_min, ws_min + 1U, 7U };
+	volatile uint32_t seed = 0x1B873593UL;
+	volatile uint32_t sink;
+	uint32_t index = 0;
+
+	if (ws_set[1] > 7U)
+		ws_set[1] = 7U;
+
+	uint32_t lfsr = 0xACE1ACE1UL;					/**< xorshift32 selector generator	*/
+	for (uint32_t i = 0; i < BENCH_FLASH_BRANCHY_OPS; i++)
+	{
+		lfsr ^= lfsr << 13;
+		lfsr ^= lfsr >> 17;
+		lfsr ^= lfsr << 5;
+		bench_flash_sel[i] = (uint8_t)lfsr;
+	}
+
+	for (uint32_t w = 0; w < BENCH_FLASH_WS_SETS; w++)
+	{
+		Flash_SetLatency(ws_set[w]);				/**< HCLK unchanged: never below minimum	*/
+
+		for (uint32_t cfg = 0; cfg < 4U; cfg++)
+		{
+			uint32_t prften = (cfg >> 0) & 1U, icen = (cfg >> 1) & 1U;
+
+			for (uint32_t k = 0; k < 2U; k++)
+			{
+				Bench_Result_t *r = Bench_Open("flash",
+						Bench_Flash_Name(index++, k ? "branchy" : "linear", ws_set[w], prften, icen),
+						k ? BENCH_FLASH_BRANCHY_OPS : BENCH_FLASH_LINEAR_OPS, 0);
+
+				Flash_SetAccelerator(FLASH_ACCEL_DCACHE			/**< Cold caches for every case	*/
+								   | (icen   ? FLASH_ACCEL_ICACHE   : 0U)
+								   | (prften ? FLASH_ACCEL_PREFETCH : 0U));
+				for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+				{
+					uint32_t t0 = Bench_Cycles();
+					sink = k ? Bench_Flash_Branchy(bench_flash_sel, BENCH_FLASH_BRANCHY_OPS)
+							 : Bench_Flash_Linear(seed);
+					uint32_t t1 = Bench_Cycles();
+					Bench_Add(r, t1 - t0);
+				}
+				Bench_Close(r);
+			}
+		}
+	}
+	(void)sink;
+
+	FLASH->ACR = acr_saved;							/**< Restore start-up LATENCY and accelerator	*/
+	Flash_ResetCaches();
+}
@@ -0,0 +1,100 @@
+/**
+  * @file	bench_gpio.c
+  * @author	Parham Estiri
+  * @brief	GPIO toggle rate and BSP LED call overhead benchmarks.
+  *
+  * 		This file measures, on the green LED pin:
+  * 		 - Read-modify-write toggling through `ODR ^=`
+  * 		 - Set/reset through `BSRR` (one store per edge)
+  * 		 - Set/reset and toggle through the peripheral bit-band alias of ODR
+  * 		 - Cost of one BSP_LED_On(), BSP_LED_Off() and BSP_LED_Toggle() call
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "bench.h"
+#include "stm32f407g_disc1.h"
+
+/** @brief	Operations per sample (edges or calls), unrolled by 8 to hide loop overhead. */
+#define BENCH_GPIO_OPS			256U
+
+/** @brief	Peripheral bit-band alias word of a register bit. */
+#define BENCH_BITBAND(reg, bit)	(*(volatile uint32_t *)(PERIPH_BB_BASE + (((uint32_t)&(reg) - PERIPH_BASE) * 32U) + ((bit) * 4U)))
+
+/** @brief	Repeat a statement 8 times. */
+#define REPEAT8(x)				do { x; x; x; x; x; x; x; x; } while (0)
+
+/**
+  * @brief	GPIO toggle rate (ODR XOR, BSRR, bit-band) and BSP_LED_* call overhead.
+  */
+void Bench_GPIO_Run(void)
+{
+	const uint32_t set   = (1UL << LED_GREEN_PIN);
+	const uint32_t reset = (1UL << (LED_GREEN_PIN + 16U));
+	volatile uint32_t *odr_bb = &BENCH_BITBAND(LED_GPIO_PORT->ODR, LED_GREEN_PIN);
+
+	Bench_Result_t *odr_xor	  = Bench_Open("gpio", "odr_xor_toggle", BENCH_GPIO_OPS, 0);
+	Bench_Result_t *bsrr	  = Bench_Open("gpio", "bsrr_set_reset", BENCH_GPIO_OPS, 0);
+	Bench_Result_t *bb_write  = Bench_Open("gpio", "bitband_set_reset", BENCH_GPIO_OPS, 0);
+	Bench_Result_t *bb_toggle = Bench_Open("gpio", "bitband_toggle", BENCH_GPIO_OPS, 0);
+	Bench_Result_t *led_on	  = Bench_Open("gpio", "bsp_led_on", BENCH_GPIO_OPS, 0);
+	Bench_Result_t *led_off	  = Bench_Open("gpio", "bsp_led_off", BENCH_GPIO_OPS, 0);
+	Bench_Result_t *led_tgl	  = Bench_Open("gpio", "bsp_led_toggle", BENCH_GPIO_OPS, 0);
+
+	for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+	{
+		uint32_t t0, t1;
+
+		t0 = Bench_Cycles();
+		for (uint32_t i = 0; i < BENCH_GPIO_OPS / 8U; i++)
+			REPEAT8(LED_GPIO_PORT->ODR ^= set);
+		t1 = Bench_Cycles();
+		Bench_Add(odr_xor, t1 - t0);
+
+		t0 = Bench_Cycles();
+		for (uint32_t i = 0; i < BENCH_GPIO_OPS / 8U; i++)
+			REPEAT8(LED_GPIO_PORT->BSRR = set; LED_GPIO_PORT->BSRR = reset);
+		t1 = Bench_Cycles();
+		Bench_Add(bsrr, (t1 - t0) / 2U);		/**< Two edges per repetition	*/
+
+		t0 = Bench_Cycles();
+		for (uint32_t i = 0; i < BENCH_GPIO_OPS / 8U; i++)
+			REPEAT8(*odr_bb = 1U; *odr_bb = 0U);
+		t1 = Bench_Cycles();
+		Bench_Add(bb_write, (t1 - t0) / 2U);	/**< Two edges per repetition	*/
+
+		t0 = Bench_Cycles();
+		for (uint32_t i = 0; i < BENCH_GPIO_OPS / 8U; i++)
+			REPEAT8(*odr_bb ^= 1U);
+		t1 = Bench_Cycles();
+		Bench_Add(bb_toggle, t1 - t0);
+
+		t0 = Bench_Cycles();
+		for (uint32_t i = 0; i < BENCH_GPIO_OPS / 8U; i++)
+			REPEAT8(BSP_LED_On(LED_GREEN));
+		t1 = Bench_Cycles();
+		Bench_Add(led_on, t1 - t0);
+
+		t0 = Bench_Cycles();
+		for (uint32_t i = 0; i < BENCH_GPIO_OPS / 8U; i++)
+			REPEAT8(BSP_LED_Off(LED_GREEN));
+		t1 = Bench_Cycles();
+		Bench_Add(led_off, t1 - t0);
+
+		t0 = Bench_Cycles();
+		for (uint32_t i = 0; i < BENCH_GPIO_OPS / 8U; i++)
+			REPEAT8(BSP_LED_Toggle(LED_GREEN));
+		t1 = Bench_Cycles();
+		Bench_Add(led_tgl, t1 - t0);
+	}
+
+	BSP_LED_Off(LED_GREEN);
+
+	Bench_Close(odr_xor);
+	Bench_Close(bsrr);
+	Bench_Close(bb_write);
+	Bench_Close(bb_toggle);
+	Bench_Close(led_on);
+	Bench_Close(led_off);
+	Bench_Close(led_tgl);
+}
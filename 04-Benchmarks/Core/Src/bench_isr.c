@@ -0,0 +1,115 @@
+/**
+  * @file	bench_isr.c
+  * @author	Parham Estiri
+  * @brief	Interrupt entry/exit latency benchmarks for EXTI and TIM.
+  *
+  * 		Each sample triggers an interrupt from thread mode and time-stamps:
+  * 		 - before the trigger (thread), on handler entry and before handler
+  * 		   return (handler), and after the return (thread).
+  * 		Entry latency is trigger-to-first-handler-instruction, exit latency is
+  * 		last-handler-instruction-to-thread.
+  *
+  * 		 - EXTI: line 1 is triggered by software (EXTI->SWIER), so no pin is
+  * 		   needed and the button on EXTI0 keeps working.
+  * 		 - TIM:  TIM2 update interrupt is triggered by a software update
+  * 		   event (TIM2->EGR = UG).
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "bench.h"
+
+#define BENCH_ISR_PRIORITY		0x00U		/**< Highest pre-emption priority for the measured IRQs	*/
+
+static volatile uint32_t isr_entry_stamp;	/**< Cycle stamp taken on handler entry		*/
+static volatile uint32_t isr_exit_stamp;	/**< Cycle stamp taken before handler return	*/
+
+/**
+  * @brief	Measure entry/exit latency of one interrupt source.
+  * @param[in] entry		Result slot for entry latency.
+  * @param[in] exit		Result slot for exit latency.
+  * @param[in] trigger	Register written to trigger the interrupt.
+  * @param[in] value		Value written to the trigger register.
+  * @retval	None
+  */
+static void Bench_ISR_Measure(Bench_Result_t *entry, Bench_Result_t *exit,
+							  volatile uint32_t *trigger, uint32_t value)
+{
+	for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+	{
+		uint32_t t0 = Bench_Cycles();
+		*trigger = value;						/**< Pend the interrupt				*/
+		__DSB();								/**< Complete the bus write			*/
+		__ISB();								/**< Take the interrupt here		*/
+		uint32_t t1 = Bench_Cycles();
+
+		/* The stamp overhead is removed by Bench_Add(), so add it back here:
+		 * these intervals are measured between stamps of different contexts. */
+		Bench_Add(entry, (isr_entry_stamp - t0) + Bench_Overhead());
+		Bench_Add(exit,  (t1 - isr_exit_stamp) + Bench_Overhead());
+	}
+}
+
+/**
+  * @brief	Interrupt entry and exit latency for EXTI and TIM interrupts.
+  */
+void Bench_ISR_Run(void)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+
+	/* EXTI1: software trigger only */
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;		/**< Enable SYSCFG clock (EXTI registers)	*/
+	EXTI->IMR  |= EXTI_IMR_MR1;					/**< Unmask line 1							*/
+	EXTI->RTSR &= ~EXTI_RTSR_TR1;				/**< No edge triggers: SWIER only			*/
+	EXTI->FTSR &= ~EXTI_FTSR_TR1;
+	EXTI->PR = EXTI_PR_PR1;						/**< Clear pending flag						*/
+	NVIC_SetPriority(EXTI1_IRQn, NVIC_EncodePriority(PG, BENCH_ISR_PRIORITY, 0));
+	NVIC_EnableIRQ(EXTI1_IRQn);
+
+	/* TIM2: update interrupt from a software update event */
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;			/**< Enable TIM2 clock						*/
+	TIM2->CR1  = 0;								/**< Counter stopped, URS = 0				*/
+	TIM2->SR   = 0;
+	TIM2->DIER = TIM_DIER_UIE;					/**< Update interrupt						*/
+	NVIC_SetPriority(TIM2_IRQn, NVIC_EncodePriority(PG, BENCH_ISR_PRIORITY, 0));
+	NVIC_EnableIRQ(TIM2_IRQn);
+
+	Bench_Result_t *exti_entry = Bench_Open("isr", "exti_entry", 1, 12);	/**< 12 cycles: Cortex-M4 zero wait-state entry	*/
+	Bench_Result_t *exti_exit  = Bench_Open("isr", "exti_exit", 1, 0);
+	Bench_ISR_Measure(exti_entry, exti_exit, &EXTI->SWIER, EXTI_SWIER_SWIER1);
+	Bench_Close(exti_entry);
+	Bench_Close(exti_exit);
+
+	Bench_Result_t *tim_entry = Bench_Open("isr", "tim_entry", 1, 12);
+	Bench_Result_t *tim_exit  = Bench_Open("isr", "tim_exit", 1, 0);
+	Bench_ISR_Measure(tim_entry, tim_exit, &TIM2->EGR, TIM_EGR_UG);
+	Bench_Close(tim_entry);
+	Bench_Close(tim_exit);
+
+	NVIC_DisableIRQ(EXTI1_IRQn);
+	NVIC_DisableIRQ(TIM2_IRQn);
+	EXTI->IMR &= ~EXTI_IMR_MR1;
+	TIM2->DIER = 0;
+}
+
+/**
+  * @brief	EXTI line 1 interrupt handler (benchmark only).
+  */
+void EXTI1_IRQHandler(void)
+{
+	isr_entry_stamp = Bench_Cycles();
+	EXTI->PR = EXTI_PR_PR1;						/**< Clear pending flag (also clears SWIER)	*/
+	__DSB();									/**< Avoid re-entry on a late flag clear	*/
+	isr_exit_stamp = Bench_Cycles();
+}
+
+/**
+  * @brief	TIM2 interrupt handler (benchmark only).
+  */
+void TIM2_IRQHandler(void)
+{
+	isr_entry_stamp = Bench_Cycles();
+	TIM2->SR = ~TIM_SR_UIF;						/**< Clear update flag (rc_w0)				*/
+	__DSB();									/**< Avoid re-entry on a late flag clear	*/
+	isr_exit_stamp = Bench_Cycles();
+}
@@ -0,0 +1,136 @@
+/**
+  * @file	bench_memory.c
+  * @author	Parham Estiri
+  * @brief	Flash vs SRAM vs CCM benchmarks under every FLASH_ACR accelerator setting.
+  *
+  * 		The same kernel is compiled twice, once into flash (.text) and once
+  * 		into SRAM (.RamFunc, copied by the startup code), and run over the
+  * 		same data held in flash (.rodata), SRAM and CCM RAM. Every pair is
+  * 		measured for all 8 combinations of FLASH_ACR ICEN, DCEN and PRFTEN.
+  *
+  * 		Case names are `<exec>_<data>_ic<0|1>_dc<0|1>_pf<0|1>`.
+  *
+  * @note	CCM RAM is only connected to the D-bus on the STM32F407 and cannot
+  * 		execute code, so it is benchmarked as a data location only.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "bench.h"
+#include "flash.h"
+
+#define BENCH_MEM_WORDS			256U		/**< Kernel data set size in 32-bit words (1 KB)	*/
+#define BENCH_MEM_NAME_LEN		24U			/**< Maximum case name length (with terminator)	*/
+#define BENCH_MEM_CASES			(2U * 3U * 8U)	/**< exec x data x ACR combinations			*/
+
+/** @brief	Kernel data in flash (seeded with a few non-zero words). */
+static const uint32_t bench_data_flash[BENCH_MEM_WORDS] = {
+		0x9E3779B9UL, 0x7F4A7C15UL, 0xF39CC060UL, 0x5CEDC834UL,
+		0x1B873593UL, 0xCC9E2D51UL, 0x85EBCA6BUL, 0xC2B2AE35UL
+};
+
+static uint32_t bench_data_sram[BENCH_MEM_WORDS];								/**< Kernel data in SRAM	*/
+static uint32_t bench_data_ccm[BENCH_MEM_WORDS] __attribute__((section(".ccmram")));	/**< Kernel data in CCM	*/
+
+static char bench_mem_names[BENCH_MEM_CASES][BENCH_MEM_NAME_LEN];				/**< Generated case names	*/
+
+/**
+  * @brief	Benchmark kernel: shift/add hash over a data set (linear, load-bound).
+  * @param[in] data	Data set.
+  * @param[in] n		Number of words.
+  * @retval	Hash value (keeps the loop from being optimized away).
+  */
+static inline __attribute__((always_inline)) uint32_t Bench_Kernel(const uint32_t *data, uint32_t n)
+{
+	uint32_t acc = 0x811C9DC5UL;
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		acc = ((acc << 5) + (acc >> 2)) ^ data[i];
+	}
+	return acc;
+}
+
+/** @brief	Kernel copy executed from flash. */
+static __attribute__((noinline)) uint32_t Bench_Kernel_Flash(const uint32_t *data, uint32_t n)
+{
+	return Bench_Kernel(data, n);
+}
+
+/** @brief	Kernel copy executed from SRAM. */
+static __attribute__((noinline, section(".RamFunc"))) uint32_t Bench_Kernel_Sram(const uint32_t *data, uint32_t n)
+{
+	return Bench_Kernel(data, n);
+}
+
+/**
+  * @brief	Build a case name `<exec>_<data>_ic<n>_dc<n>_pf<n>`.
+  * @retval	Pointer to the generated name.
+  */
+static const char *Bench_Memory_Name(uint32_t index, const char *exec, const char *data,
+									 uint32_t icen, uint32_t dcen, uint32_t prften)
+{
+	char *p = bench_mem_names[index];
+
+	while (*exec) *p++ = *exec++;
+	*p++ = '_';
+	while (*data) *p++ = *data++;
+	*p++ = '_'; *p++ = 'i'; *p++ = 'c'; *p++ = (char)('0' + icen);
+	*p++ = '_'; *p++ = 'd'; *p++ = 'c'; *p++ = (char)('0' + dcen);
+	*p++ = '_'; *p++ = 'p'; *p++ = 'f'; *p++ = (char)('0' + prften);
+	*p = '\0';
+
+	return bench_mem_names[index];
+}
+
+/**
+  * @brief	Flash vs SRAM execution and flash/SRAM/CCM data access for every
+  * 		combination of the FLASH_ACR ICEN, DCEN and PRFTEN bits.
+  */
+void Bench_Memory_Run(void)
+{
+	static const char *const exec_name[2] = { "flash", "sram" };
+	static const char *const data_name[3] = { "flash", "sram", "ccm" };
+	const uint32_t *data_set[3] = { bench_data_flash, bench_data_sram, bench_data_ccm };
+	uint32_t (*const kernel[2])(const uint32_t *, uint32_t) = { Bench_Kernel_Flash, Bench_Kernel_Sram };
+
+	const uint32_t acr_saved = FLASH->ACR;
+	volatile uint32_t sink;
+	uint32_t index = 0;
+
+	for (uint32_t i = 0; i < BENCH_MEM_WORDS; i++)		/**< Same contents in every location	*/
+	{
+		bench_data_sram[i] = bench_data_flash[i];
+		bench_data_ccm[i]  = bench_data_flash[i];
+	}
+
+	for (uint32_t acr = 0; acr < 8U; acr++)
+	{
+		uint32_t icen = (acr >> 0) & 1U, dcen = (acr >> 1) & 1U, prften = (acr >> 2) & 1U;
+
+		for (uint32_t e = 0; e < 2U; e++)
+		{
+			for (uint32_t d = 0; d < 3U; d++)
+			{
+				Bench_Result_t *r = Bench_Open("memory",
+						Bench_Memory_Name(index++, exec_name[e], data_name[d], icen, dcen, prften),
+						BENCH_MEM_WORDS, 0);
+
+				Flash_SetAccelerator((icen   ? FLASH_ACCEL_ICACHE   : 0U)	/**< Start every case with cold caches	*/
+								   | (dcen   ? FLASH_ACCEL_DCACHE   : 0U)
+								   | (prften ? FLASH_ACCEL_PREFETCH : 0U));
+				for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+				{
+					uint32_t t0 = Bench_Cycles();
+					sink = kernel[e](data_set[d], BENCH_MEM_WORDS);
+					uint32_t t1 = Bench_Cycles();
+					Bench_Add(r, t1 - t0);
+				}
+				Bench_Close(r);
+			}
+		}
+	}
+	(void)sink;
+
+	FLASH->ACR = acr_saved;								/**< Restore start-up accelerator setting	*/
+}
@@ -0,0 +1,79 @@
+/**
+  * @file	bench_profiler.c
+  * @author	Parham Estiri
+  * @brief	Sampling profiler overhead benchmark.
+  *
+  * 		A fixed CPU-bound workload (about 5 ms) is timed with the profiler
+  * 		stopped, then with the profiler sampling at 1 kHz and 10 kHz. The
+  * 		stopped time is reported as `expected`, so the overhead of a rate is
+  * 		`avg / expected - 1`. The cost of one sample is reported separately.
+  *
+  * @note	The profiler is left stopped and its histogram cleared.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "bench.h"
+#include "profiler.h"
+
+#define BENCH_PROF_WORK_LOOPS	280000U		/**< Workload iterations (about 5 ms at 168 MHz)	*/
+
+/** @brief	Sampling rates measured. */
+static const uint32_t bench_prof_rate[] = { 1000U, 10000U };
+
+/** @brief	Case names matching bench_prof_rate[]. */
+static const char *const bench_prof_rate_name[] = { "workload_1khz", "workload_10khz" };
+
+/**
+  * @brief	Fixed CPU-bound workload.
+  * @retval	Cycles taken.
+  */
+static __attribute__((noinline)) uint32_t Bench_Profiler_Workload(void)
+{
+	uint32_t t0 = Bench_Cycles();
+	for (uint32_t i = 0; i < BENCH_PROF_WORK_LOOPS; i++)
+	{
+		__NOP();
+	}
+	return Bench_Cycles() - t0;
+}
+
+/**
+  * @brief	Sampling profiler overhead on a fixed workload at 1 kHz and 10 kHz.
+  */
+void Bench_Profiler_Run(void)
+{
+	uint32_t baseline = 0xFFFFFFFFUL;
+	Prof_Stats_t stats;
+
+	Prof_Stop();
+	for (uint32_t s = 0; s < BENCH_SAMPLES; s++)		/**< Profiler stopped: reference time	*/
+	{
+		uint32_t c = Bench_Profiler_Workload();
+		if (c < baseline)
+			baseline = c;
+	}
+	baseline -= Bench_Overhead();					/**< Same correction as Bench_Add()			*/
+
+	for (uint32_t c = 0; c < sizeof(bench_prof_rate) / sizeof(bench_prof_rate[0]); c++)
+	{
+		Bench_Result_t *r = Bench_Open("profiler", bench_prof_rate_name[c], 1, baseline);
+
+		Prof_Reset();
+		Prof_Start(bench_prof_rate[c]);
+		for (uint32_t s = 0; s < BENCH_SAMPLES; s++)
+		{
+			Bench_Add(r, Bench_Profiler_Workload());
+		}
+		Prof_Stop();
+		Bench_Close(r);
+	}
+
+	Prof_GetStats(&stats);							/**< Last rate: cost of one sample			*/
+	Bench_Result_t *r = Bench_Open("profiler", "sample_isr", 1, 0);
+	if (stats.samples + stats.dropped)
+		Bench_Add(r, stats.isr_cycles / (stats.samples + stats.dropped));
+	Bench_Close(r);
+
+	Prof_Reset();
+}
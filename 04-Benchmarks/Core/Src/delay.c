@@ -13,7 +13,11 @@
 
 #include "delay.h"
 
+#if defined(QEMU_NETDUINOPLUS2)
+#define DELAY_QEMU_TIM		TIM5			/**< Emulated 32-bit timer standing in for TIM6				*/
+#else
 static uint32_t last_delay_us = 0;			/**< Stores last delay value (µs) to reduce redundant updates	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 
 /**
   * @brief	Initialize TIM6 for delay functions.
@@ -28,11 +32,18 @@ static uint32_t last_delay_us = 0;			/**< Stores last delay value (µs) to reduc
   */
 void Delay_Init(void)
 {
+#if defined(QEMU_NETDUINOPLUS2)
+	DELAY_QEMU_TIM->PSC = (QEMU_TIMER_CLK_HZ / 1000000UL) - 1;	/**< 1MHz -> 1µs tick		*/
+	DELAY_QEMU_TIM->ARR = 0xFFFFFFFFUL;		/**< Free-running over the full 32-bit range		*/
+	DELAY_QEMU_TIM->EGR = TIM_EGR_UG;		/**< Load prescaler								*/
+	DELAY_QEMU_TIM->CR1 = TIM_CR1_CEN;		/**< Start timer (one-pulse mode is not emulated)	*/
+#else
 	RCC->APB1ENR |= RCC_APB1ENR_TIM6EN;		/**< Enable TIM6 clock								*/
 
 	TIM6->PSC = 84 - 1;						/**< Prescaler: 84Mhz / 84 = 1MHz -> 1µs tick		*/
 
 	TIM6->CR1 = TIM_CR1_OPM;				/**< One-pulse mode: stops timer after each delay	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 }
 
 /**
@@ -53,6 +64,10 @@ void Delay_us(uint32_t us)
 	if (us == 0 || us > 0xFFFF)		/**< Limit maximum delay and ignore delay of 0				*/
 		return;
 
+#if defined(QEMU_NETDUINOPLUS2)
+	uint32_t start = DELAY_QEMU_TIM->CNT;	/**< UIF is only raised with UIE set: poll the counter	*/
+	while ((DELAY_QEMU_TIM->CNT - start) < us);
+#else
 	// Only update ARR and EGR if value changed
 	if (us != last_delay_us)		/**< Update ARR only if new delay differs from previous one	*/
 	{
@@ -67,6 +82,7 @@ void Delay_us(uint32_t us)
 
 	while (!(TIM6->SR & TIM_SR_UIF));	/**< Wait until update event (overflow)	*/
 	TIM6->SR = 0;				/**< Clear flag again	*/
+#endif /* QEMU_NETDUINOPLUS2 */
 }
 
 /**
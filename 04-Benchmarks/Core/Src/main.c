@@ -0,0 +1,93 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	On-target micro-benchmark suite.
+  *
+  * 		This file initializes the system, board support package (BSP),
+  * 		TIM6 delay, SysTick and the DWT cycle counter, runs every benchmark
+  * 		suite once and then blinks the green LED. Each press of the user
+  * 		button runs the suites again.
+  *
+  * 		Between runs the sampling profiler records the main loop at 1 kHz;
+  * 		its histogram is dumped at the start of the next run.
+  *
+  * 		Results are written to ITM stimulus port 0 (SWO on PB3) as CSV lines
+  * 		(see bench.h) and kept in RAM for inspection with a debugger.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "delay.h"
+#include "systick.h"
+#include "bench.h"
+#include "profiler.h"
+
+static volatile uint8_t bench_request = 1;		/**< Set by the button callback to rerun the suites	*/
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs, button in EXTI mode).
+  * 		3. Initializes TIM6 delay, SysTick (1 ms), the DWT cycle counter and
+  * 		   the sampling profiler.
+  * 		4. Enters an infinite loop that runs the benchmark suites whenever
+  * 		   requested and blinks the green LED in between.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	BSP_Button_Init(BUTTON_MODE_EXTI);	/**< Button reruns the benchmarks			*/
+	Delay_Init();						/**< Initialize TIM6 for delay				*/
+	SysTick_Init(1000, SYSTICK_CMSIS);	/**< 1 ms SysTick							*/
+	Bench_Init();						/**< Enable DWT cycle counter				*/
+	Prof_Init();						/**< Sampling profiler timer (stopped)		*/
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	/**< Main loop */
+	while (1)
+	{
+		if (bench_request)
+		{
+			bench_request = 0;
+
+			Prof_Stop();				/**< Dump the main-loop profile since the last run	*/
+			Prof_Dump();
+
+			BSP_LED_On(LED_ORANGE);		/**< Orange LED: benchmarks running	*/
+			Bench_Begin();
+			Bench_GPIO_Run();
+			Bench_ISR_Run();
+			Bench_Delay_Run();
+			Bench_Memory_Run();
+			Bench_Flash_Run();
+			Bench_Profiler_Run();
+			Bench_End();
+			BSP_LED_Off(LED_ORANGE);
+
+			Prof_Reset();
+			Prof_Start(PROF_RATE_DEFAULT_HZ);	/**< Profile the main loop until the next run	*/
+		}
+
+		Prof_Poll();					/**< Commands written by the debugger	*/
+
+		BSP_LED_Toggle(LED_GREEN);		/**< Heartbeat	*/
+		SysTick_delay_ms(500);
+	}
+}
+
+/**
+  * @brief	Button callback: request another benchmark run.
+  */
+void BSP_Button_Callback(void)
+{
+	bench_request = 1;
+}
@@ -0,0 +1,275 @@
+/**
+  * @file	profiler.c
+  * @author	Parham Estiri
+  * @brief	Statistical (sampling) profiler based on a periodic timer interrupt.
+  *
+  * 		This file provides:
+  * 		 - The sampling interrupt handler (reads the stacked PC)
+  * 		 - An open-addressing PC histogram (multiplicative hash, linear probing)
+  * 		 - Start/stop/reset/dump commands and ITM output
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "profiler.h"
+#include "bench.h"
+
+#define PROF_EXC_CYCLES		30U			/**< Exception entry + exit + handler stub (estimate)	*/
+#define PROF_HASH_MUL		2654435761UL	/**< Knuth multiplicative hash constant				*/
+#define PROF_PC_MASK		(~((1UL << PROF_PC_SHIFT) - 1UL))	/**< Clears bit 0 at least			*/
+
+_Static_assert(PROF_PC_SHIFT >= 1U, "bit 0 of a histogram key holds the handler-mode flag");
+_Static_assert(PROF_PROBE_MAX <= PROF_BUCKETS, "probe chain longer than the table");
+
+/**
+  * @brief	Histogram bucket. A zero key marks an empty bucket.
+  */
+typedef struct {
+	uint32_t	pc;			/**< Masked PC | PROF_PC_HANDLER			*/
+	uint32_t	count;		/**< Number of samples						*/
+} Prof_Bucket_t;
+
+static Prof_Bucket_t prof_table[PROF_BUCKETS];		/**< PC histogram							*/
+static volatile uint32_t prof_samples = 0;			/**< Samples recorded						*/
+static volatile uint32_t prof_dropped = 0;			/**< Samples lost to full probe chains		*/
+static volatile uint32_t prof_isr_cycles = 0;		/**< Cycles spent in Prof_Sample()			*/
+static uint32_t prof_rate_hz = PROF_RATE_DEFAULT_HZ;	/**< Current / last sampling rate		*/
+static volatile uint32_t prof_command = PROF_CMD_NONE;	/**< Pending command (debugger-writable)	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static void Prof_Sample(uint32_t pc, uint32_t exc_return) __attribute__((used));
+
+/**
+  * @brief	Configure the sampling timer and its interrupt (stopped).
+  * @param	None
+  * @retval	None
+  * @note	Requires the DWT cycle counter (Bench_Init()) for overhead accounting.
+  */
+void Prof_Init(void)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+
+	PROF_TIM_CLK_EN();
+	PROF_TIM->CR1  = 0;								/**< Counter stopped							*/
+	PROF_TIM->DIER = 0;
+	PROF_TIM->PSC  = (PROF_TIM_CLK_HZ / 1000000UL) - 1;	/**< 1 MHz -> 1 µs tick						*/
+	PROF_TIM->EGR  = TIM_EGR_UG;					/**< Load prescaler								*/
+	PROF_TIM->SR   = 0;
+
+	NVIC_SetPriority(PROF_TIM_IRQn, NVIC_EncodePriority(PG, PROF_PRIORITY, 0));
+	NVIC_EnableIRQ(PROF_TIM_IRQn);
+}
+
+/**
+  * @brief	Start sampling.
+  * @param[in] rate_hz	Sampling rate, clamped to PROF_RATE_MIN_HZ..PROF_RATE_MAX_HZ.
+  * @retval	None
+  */
+void Prof_Start(uint32_t rate_hz)
+{
+	if (rate_hz < PROF_RATE_MIN_HZ)
+		rate_hz = PROF_RATE_MIN_HZ;
+	if (rate_hz > PROF_RATE_MAX_HZ)
+		rate_hz = PROF_RATE_MAX_HZ;
+	prof_rate_hz = rate_hz;
+
+	PROF_TIM->CR1  = 0;
+	PROF_TIM->ARR  = (1000000UL / rate_hz) - 1;		/**< Sampling period in µs						*/
+	PROF_TIM->CNT  = 0;
+	PROF_TIM->SR   = 0;
+	PROF_TIM->DIER = TIM_DIER_UIE;					/**< Update interrupt							*/
+	PROF_TIM->CR1  = TIM_CR1_CEN;					/**< Start counter								*/
+}
+
+/**
+  * @brief	Stop sampling. The histogram is kept.
+  * @param	None
+  * @retval	None
+  */
+void Prof_Stop(void)
+{
+	PROF_TIM->CR1  = 0;
+	PROF_TIM->DIER = 0;
+	PROF_TIM->SR   = 0;
+	NVIC_ClearPendingIRQ(PROF_TIM_IRQn);
+}
+
+/**
+  * @brief	Clear the histogram and statistics.
+  * @param	None
+  * @retval	None
+  */
+void Prof_Reset(void)
+{
+	uint32_t running = PROF_TIM->CR1 & TIM_CR1_CEN;
+
+	Prof_Stop();
+	for (uint32_t i = 0; i < PROF_BUCKETS; i++)
+	{
+		prof_table[i].pc = 0;
+		prof_table[i].count = 0;
+	}
+	prof_samples = 0;
+	prof_dropped = 0;
+	prof_isr_cycles = 0;
+
+	if (running)
+		Prof_Start(prof_rate_hz);
+}
+
+/**
+  * @brief	Read the profiler statistics.
+  * @param[out] stats	Destination.
+  * @retval	None
+  */
+void Prof_GetStats(Prof_Stats_t *stats)
+{
+	__disable_irq();
+	stats->rate_hz    = prof_rate_hz;
+	stats->samples    = prof_samples;
+	stats->dropped    = prof_dropped;
+	stats->isr_cycles = prof_isr_cycles;
+	__enable_irq();
+
+	uint32_t taken = stats->samples + stats->dropped;
+	uint32_t per_sample = (taken ? (stats->isr_cycles / taken) : 0U) + PROF_EXC_CYCLES;
+	stats->overhead_ppm = (uint32_t)(((uint64_t)per_sample * stats->rate_hz * 1000000ULL) / SystemCoreClock);
+}
+
+/**
+  * @brief	Write the histogram to ITM stimulus port 0.
+  * @param	None
+  * @retval	None
+  * @note	Sampling is paused during the dump and resumed afterwards.
+  */
+void Prof_Dump(void)
+{
+	uint32_t running = PROF_TIM->CR1 & TIM_CR1_CEN;
+	Prof_Stats_t stats;
+
+	Prof_Stop();
+	Prof_GetStats(&stats);
+
+	Bench_Print("PROF_BEGIN,");
+	Bench_PrintU32(stats.rate_hz);
+	Bench_Print(",");
+	Bench_PrintU32(stats.samples);
+	Bench_Print(",");
+	Bench_PrintU32(stats.dropped);
+	Bench_Print(",");
+	Bench_PrintU32(stats.overhead_ppm);
+	Bench_Print("\n");
+
+	for (uint32_t i = 0; i < PROF_BUCKETS; i++)
+	{
+		if (prof_table[i].count == 0)
+			continue;
+		Bench_Print("PROF,");
+		Bench_PrintHex32(prof_table[i].pc);
+		Bench_Print(",");
+		Bench_PrintU32(prof_table[i].count);
+		Bench_Print("\n");
+	}
+	Bench_Print("PROF_END\n");
+
+	if (running)
+		Prof_Start(prof_rate_hz);
+}
+
+/**
+  * @brief	Queue a command for the next Prof_Poll().
+  * @param[in] cmd	Command.
+  * @retval	None
+  */
+void Prof_Command(Prof_Cmd_t cmd)
+{
+	prof_command = cmd;
+}
+
+/**
+  * @brief	Execute a pending command (from Prof_Command() or the debugger).
+  * @param	None
+  * @retval	None
+  * @note	Call from the main loop.
+  */
+void Prof_Poll(void)
+{
+	uint32_t cmd = prof_command;
+
+	if (cmd == PROF_CMD_NONE)
+		return;
+	prof_command = PROF_CMD_NONE;
+
+	switch (cmd)
+	{
+		case PROF_CMD_START:	Prof_Start(prof_rate_hz);	break;
+		case PROF_CMD_STOP:		Prof_Stop();				break;
+		case PROF_CMD_RESET:	Prof_Reset();				break;
+		case PROF_CMD_DUMP:		Prof_Dump();				break;
+		default:											break;
+	}
+}
+
+/**
+  * @brief	Record one sample in the histogram.
+  * @param[in] pc			Stacked PC of the interrupted context.
+  * @param[in] exc_return	EXC_RETURN value of the sampling interrupt.
+  * @retval	None
+  */
+static void Prof_Sample(uint32_t pc, uint32_t exc_return)
+{
+	uint32_t t0 = DWT->CYCCNT;
+
+	PROF_TIM->SR = ~TIM_SR_UIF;						/**< Clear update flag (rc_w0)				*/
+
+	pc &= PROF_PC_MASK;
+	if ((exc_return & 0x8UL) == 0)					/**< EXC_RETURN bit 3 clear: handler mode	*/
+		pc |= PROF_PC_HANDLER;
+
+	uint32_t idx = (pc * PROF_HASH_MUL) >> (32U - PROF_BUCKETS_LOG2);
+	uint32_t probe;
+	for (probe = 0; probe < PROF_PROBE_MAX; probe++)
+	{
+		Prof_Bucket_t *b = &prof_table[idx];
+		if (b->pc == pc)
+		{
+			b->count++;
+			break;
+		}
+		if (b->pc == 0)								/**< Claim an empty bucket					*/
+		{
+			b->pc = pc;
+			b->count = 1;
+			break;
+		}
+		idx = (idx + 1U) & (PROF_BUCKETS - 1U);
+	}
+
+	if (probe < PROF_PROBE_MAX)
+		prof_samples++;
+	else
+		prof_dropped++;
+
+	prof_isr_cycles += DWT->CYCCNT - t0;
+}
+
+/**
+  * @brief	Sampling timer interrupt handler.
+  *
+  * 		Selects the stack the interrupted context used (EXC_RETURN bit 2),
+  * 		loads the stacked PC (offset 24 of the exception frame, with or
+  * 		without FPU state) and tail-calls Prof_Sample(pc, EXC_RETURN).
+  * 		Prof_Sample() returns with the EXC_RETURN value still in LR.
+  */
+__attribute__((naked)) void PROF_TIM_IRQHandler(void)
+{
+	__asm volatile(
+		"	tst		lr, #4			\n"
+		"	ite		eq				\n"
+		"	mrseq	r0, msp			\n"
+		"	mrsne	r0, psp			\n"
+		"	ldr		r0, [r0, #24]	\n"
+		"	mov		r1, lr			\n"
+		"	b		Prof_Sample		\n"
+	);
+}
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""Compare two 04-Benchmarks runs and flag regressions.
+
+The firmware writes one CSV line per benchmark case to ITM port 0 (SWO):
+
+    BENCH_BEGIN,<sysclk_hz>
+    BENCH,<suite>,<case>,<ops>,<expected>,<min>,<avg>,<max>
+    BENCH_END
+
+Capture the SWO output of two runs to text files (for example with the
+STM32CubeIDE SWV console or `openocd ... itm port 0 on`), then run:
+
+    python3 bench_compare.py baseline.txt current.txt --threshold 5
+
+Lines that do not start with `BENCH` are ignored, so raw console logs work.
+The exit status is 1 when at least one case got slower than the threshold
+or disappeared, 0 otherwise. A case that measured 0 cycles in the baseline
+has no percentage: its delta is printed in cycles (suffix `c`) and any
+increase counts as a regression.
+"""
+
+import argparse
+import sys
+
+METRICS = ("min", "avg", "max")
+
+
+def parse(path):
+    """Return ({(suite, case): record}, sysclk_hz) for the last run in a capture."""
+    results, sysclk = {}, None
+    with open(path, encoding="utf-8", errors="replace") as fh:
+        for line in fh:
+            fields = line.strip().split(",")
+            if fields[0] == "BENCH_BEGIN" and len(fields) == 2:
+                results, sysclk = {}, int(fields[1])
+            elif fields[0] == "BENCH" and len(fields) == 8:
+                suite, case = fields[1], fields[2]
+                ops, expected, mn, avg, mx = (int(v) for v in fields[3:])
+                results[(suite, case)] = {
+                    "ops": ops, "expected": expected,
+                    "min": mn, "avg": avg, "max": mx,
+                }
+    return results, sysclk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="capture of the reference run")
+    parser.add_argument("current", help="capture of the run under test")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="allowed slowdown in percent (default: 5)")
+    parser.add_argument("--metric", choices=METRICS, default="min",
+                        help="statistic to compare (default: min, the least noisy)")
+    args = parser.parse_args()
+
+    base, base_clk = parse(args.baseline)
+    curr, curr_clk = parse(args.current)
+    if not base or not curr:
+        sys.exit("no BENCH lines found in one of the captures")
+    if base_clk != curr_clk:
+        print(f"warning: SYSCLK differs ({base_clk} Hz vs {curr_clk} Hz)")
+
+    regressions = 0
+    print(f"{'suite':<8} {'case':<26} {'base':>10} {'current':>10} {'delta':>8}  per-op")
+    for key in sorted(base):
+        b = base[key]
+        c = curr.get(key)
+        if c is None:
+            print(f"{key[0]:<8} {key[1]:<26} {b[args.metric]:>10} {'missing':>10}")
+            regressions += 1
+            continue
+
+        old, new = b[args.metric], c[args.metric]
+        flag = ""
+        if old:
+            delta = (new - old) * 100.0 / old
+            delta_text = f"{delta:>+7.1f}%"
+            slower, faster = delta > args.threshold, delta < -args.threshold
+        else:
+            # No percentage from a zero baseline: show the cycles gained and
+            # count any increase as a regression.
+            delta_text = f"{new:>+7d}c"
+            slower, faster = new > 0, False
+        if slower:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif faster:
+            flag = "  improved"
+
+        per_op = new / c["ops"] if c["ops"] else new
+        print(f"{key[0]:<8} {key[1]:<26} {old:>10} {new:>10} {delta_text}  {per_op:.2f}{flag}")
+
+    for key in sorted(set(curr) - set(base)):
+        print(f"{key[0]:<8} {key[1]:<26} {'new':>10} {curr[key][args.metric]:>10}")
+
+    print(f"\n{regressions} regression(s) above {args.threshold:.1f}% ({args.metric} cycles)")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
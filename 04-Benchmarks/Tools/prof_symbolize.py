@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Map 04-Benchmarks profiler samples to functions and emit flame-graph input.
+
+The firmware dumps its PC histogram to ITM port 0 (SWO):
+
+    PROF_BEGIN,<rate_hz>,<samples>,<dropped>,<overhead_ppm>
+    PROF,<pc>,<count>
+    PROF_END
+
+Bit 0 of <pc> is set when the sample was taken in handler mode (an ISR).
+Given the ELF file of the same build, this script resolves every PC to the
+enclosing function and prints either collapsed stacks, one per line, for
+flamegraph.pl / speedscope / inferno:
+
+    thread;main 812
+    handler;SysTick_Handler 37
+
+or a table sorted by sample count (--table). Only the last dump in the
+capture is used. No third-party packages are needed.
+"""
+
+import argparse
+import bisect
+import struct
+import sys
+from collections import Counter
+
+SHT_SYMTAB = 2
+STT_FUNC = 2
+
+
+def read_functions(path):
+    """Return a sorted list of (start, end, name) for the FUNC symbols of an ELF32 file."""
+    with open(path, "rb") as fh:
+        data = fh.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        sys.exit(f"{path}: not a little-endian ELF32 file")
+
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+    sections = [struct.unpack_from("<10I", data, shoff + i * shentsize) for i in range(shnum)]
+
+    funcs = []
+    for sh in sections:
+        if sh[1] != SHT_SYMTAB:
+            continue
+        sym_off, sym_size, link, entsize = sh[4], sh[5], sh[6], sh[9]
+        str_off = sections[link][4]
+        for off in range(sym_off, sym_off + sym_size, entsize):
+            name_idx, value, size, info, _, shndx = struct.unpack_from("<IIIBBH", data, off)
+            if info & 0xF != STT_FUNC or shndx == 0:
+                continue
+            end = data.index(b"\0", str_off + name_idx)
+            name = data[str_off + name_idx:end].decode("ascii", "replace")
+            start = value & ~1                      # clear the Thumb bit
+            funcs.append((start, start + size, name))
+    if not funcs:
+        sys.exit(f"{path}: no function symbols (stripped?)")
+
+    funcs.sort()
+    fixed = []
+    for i, (start, end, name) in enumerate(funcs):
+        if end == start and i + 1 < len(funcs):     # size-less (assembly) symbols
+            end = funcs[i + 1][0]
+        fixed.append((start, end, name))
+    return fixed
+
+
+def parse_capture(path):
+    """Return (header fields, Counter{pc: count}) of the last dump in a capture."""
+    header, hist, current = None, None, None
+    with open(path, encoding="utf-8", errors="replace") as fh:
+        for line in fh:
+            fields = line.strip().split(",")
+            if fields[0] == "PROF_BEGIN" and len(fields) == 5:
+                current = (dict(zip(("rate_hz", "samples", "dropped", "overhead_ppm"),
+                                    (int(v) for v in fields[1:]))), Counter())
+            elif fields[0] == "PROF" and len(fields) == 3 and current:
+                current[1][int(fields[1], 0)] += int(fields[2])
+            elif fields[0] == "PROF_END" and current:
+                header, hist = current
+                current = None
+    if hist is None:
+        sys.exit(f"{path}: no complete PROF_BEGIN ... PROF_END dump found")
+    return header, hist
+
+
+def resolve(funcs, starts, pc):
+    """Name of the function containing pc, or its address when unknown."""
+    i = bisect.bisect_right(starts, pc) - 1
+    if i >= 0 and funcs[i][0] <= pc < funcs[i][1]:
+        return funcs[i][2]
+    return f"[0x{pc:08X}]"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="ELF file of the profiled build (Debug/04-Benchmarks.elf)")
+    parser.add_argument("capture", help="SWO/ITM capture containing a PROF dump")
+    parser.add_argument("--table", action="store_true",
+                        help="print a per-function table instead of collapsed stacks")
+    parser.add_argument("--no-context", action="store_true",
+                        help="do not split samples into thread/handler roots")
+    args = parser.parse_args()
+
+    funcs = read_functions(args.elf)
+    starts = [f[0] for f in funcs]
+    header, hist = parse_capture(args.capture)
+
+    stacks = Counter()
+    for key, count in hist.items():
+        context = "handler" if key & 1 else "thread"
+        name = resolve(funcs, starts, key & ~1)
+        stacks[name if args.no_context else f"{context};{name}"] += count
+
+    if not args.table:
+        for stack, count in sorted(stacks.items()):
+            print(f"{stack} {count}")
+        return 0
+
+    total = sum(stacks.values()) or 1
+    print(f"rate {header['rate_hz']} Hz, {header['samples']} samples, "
+          f"{header['dropped']} dropped, estimated overhead {header['overhead_ppm'] / 10000:.3f}%")
+    print(f"{'samples':>8} {'share':>7}  function")
+    for stack, count in stacks.most_common():
+        print(f"{count:>8} {count * 100.0 / total:>6.2f}%  {stack}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,169 @@
+/**
+  * @file	logic_analyzer.h
+  * @author	Parham Estiri
+  * @brief	DMA-sampled GPIO logic analyzer.
+  *
+  * 		This module provides:
+  * 		 - Port snapshots: TIM8 update events trigger DMA2 Stream1 (channel 7)
+  * 		   to copy `GPIOx->IDR` into a circular buffer, up to LA_RATE_MAX_HZ
+  * 		 - Trigger on a pattern (mask/value) or on an edge of one channel
+  * 		 - Configurable pre- and post-trigger depth
+  * 		 - Run-length compressed export over ITM stimulus port 0 (SWO),
+  * 		   converted to VCD by Tools/la_vcd.py
+  *
+  * 		The captured port and channel names come from the BSP
+  * 		(stm32f407g_disc1.h): the LED port (GPIOD) or the button port (GPIOA).
+  *
+  * @note	Trigger detection runs in LA_Poll() from the main loop. When the
+  * 		scan falls behind the DMA, the oldest unscanned samples are skipped
+  * 		(see LA_Stats_t.skipped) so the pre-trigger window stays intact.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef LOGIC_ANALYZER_H_
+#define LOGIC_ANALYZER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+#include "stm32f407g_disc1.h"
+
+/******************************  Configuration  ******************************/
+#define LA_PORT_LEDS			0U		/**< Capture the LED port (GPIOD)		*/
+#define LA_PORT_BUTTON			1U		/**< Capture the button port (GPIOA)	*/
+
+#define LA_PORT_SELECT			LA_PORT_LEDS	/**< Captured port					*/
+
+#define LA_DEPTH_LOG2			15U		/**< 32768 samples (64 KB of SRAM)				*/
+#define LA_GUARD				1024U	/**< Samples kept free for the stop latency		*/
+#define LA_RATE_MAX_HZ			8400000UL	/**< TIM8 clock / 20						*/
+
+#if (LA_PORT_SELECT == LA_PORT_LEDS)
+#define LA_GPIO_PORT			LED_GPIO_PORT
+#define LA_GPIO_CLK_EN()		LED_GPIO_CLK_EN()
+#define LA_CHANNEL_MASK			((1U << LED_GREEN_PIN) | (1U << LED_ORANGE_PIN) | \
+								 (1U << LED_RED_PIN)   | (1U << LED_BLUE_PIN))	/**< Exported channels	*/
+#else
+#define LA_GPIO_PORT			BUTTON_GPIO_PORT
+#define LA_GPIO_CLK_EN()		BUTTON_GPIO_CLK_EN()
+#define LA_CHANNEL_MASK			0xFFFFU		/**< Exported channels				*/
+#endif /* LA_PORT_SELECT */
+
+#define LA_DEPTH				(1UL << LA_DEPTH_LOG2)
+#define LA_WINDOW_MAX			(LA_DEPTH - LA_GUARD)	/**< Maximum pre + post samples	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Trigger conditions.
+  */
+typedef enum {
+	LA_TRIG_NONE	= 0,	/**< Trigger immediately after the pre-trigger fill	*/
+	LA_TRIG_PATTERN	= 1,	/**< (sample & mask) == value						*/
+	LA_TRIG_RISING	= 2,	/**< Rising edge on `channel`						*/
+	LA_TRIG_FALLING	= 3,	/**< Falling edge on `channel`						*/
+	LA_TRIG_EDGE	= 4		/**< Any edge on `channel`							*/
+} LA_TrigMode_t;
+
+/**
+  * @brief	Capture configuration.
+  */
+typedef struct {
+	uint32_t		rate_hz;	/**< Sample rate (1 kHz to LA_RATE_MAX_HZ)		*/
+	uint32_t		pre;		/**< Samples kept before the trigger			*/
+	uint32_t		post;		/**< Samples captured from the trigger on		*/
+	LA_TrigMode_t	mode;		/**< Trigger condition							*/
+	uint16_t		mask;		/**< Pattern mask (LA_TRIG_PATTERN)				*/
+	uint16_t		value;		/**< Pattern value (LA_TRIG_PATTERN)			*/
+	uint8_t			channel;	/**< Pin number (edge triggers)					*/
+} LA_Config_t;
+
+/**
+  * @brief	Capture states.
+  */
+typedef enum {
+	LA_STATE_IDLE		= 0,	/**< Not armed								*/
+	LA_STATE_PREFILL	= 1,	/**< Filling the pre-trigger window			*/
+	LA_STATE_ARMED		= 2,	/**< Scanning for the trigger				*/
+	LA_STATE_POST		= 3,	/**< Triggered, capturing post-trigger		*/
+	LA_STATE_DONE		= 4,	/**< Capture complete, ready to export		*/
+	LA_STATE_ERROR		= 5		/**< DMA error or stop overshoot			*/
+} LA_State_t;
+
+/**
+  * @brief	Status codes.
+  */
+typedef enum {
+	LA_OK		= 0,	/**< Success					*/
+	LA_EINVAL	= 1,	/**< Invalid configuration		*/
+	LA_EBUSY	= 2		/**< Capture in progress		*/
+} LA_Status_t;
+
+/**
+  * @brief	Capture statistics.
+  */
+typedef struct {
+	uint32_t	rate_hz;	/**< Actual sample rate					*/
+	uint32_t	samples;	/**< Samples in the capture window		*/
+	uint32_t	skipped;	/**< Samples not scanned for a trigger	*/
+	uint32_t	runs;		/**< Runs in the RLE export				*/
+} LA_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Enable the port, TIM8 and DMA2 clocks and configure the DMA interrupt.
+  * @param	None
+  * @retval	None
+  */
+void LA_Init(void);
+
+/**
+  * @brief	Start a capture.
+  * @param[in] cfg	Capture configuration.
+  * @retval	LA_OK, LA_EINVAL (rate, depth or channel out of range) or LA_EBUSY.
+  */
+LA_Status_t LA_Arm(const LA_Config_t *cfg);
+
+/**
+  * @brief	Advance the capture: scan for the trigger and stop after the post-trigger depth.
+  * @param	None
+  * @retval	Current state.
+  * @note	Call continuously from the main loop while a capture is running.
+  */
+LA_State_t LA_Poll(void);
+
+/**
+  * @brief	Stop sampling and return to LA_STATE_IDLE.
+  * @param	None
+  * @retval	None
+  */
+void LA_Abort(void);
+
+/**
+  * @brief	Write the capture as run-length encoded lines to ITM stimulus port 0.
+  *
+  * 		`LA_BEGIN,<rate_hz>,<samples>,<trigger>,<port>`, one `LA_CH,<bit>,<name>`
+  * 		per exported channel, one `LA,<value>,<count>` per run and `LA_END,<runs>`.
+  * 		`<trigger>` is the sample index of the trigger (equal to `pre`).
+  *
+  * @param	None
+  * @retval	Number of runs, 0 when no capture is available.
+  */
+uint32_t LA_Export(void);
+
+/**
+  * @brief	Read the statistics of the last capture.
+  * @param[out] stats	Destination.
+  * @retval	None
+  */
+void LA_GetStats(LA_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOGIC_ANALYZER_H_ */
@@ -0,0 +1,145 @@
+/**
+  * @file	flash.c
+  * @author	Parham Estiri
+  * @brief	Flash interface performance configuration (wait states and ART accelerator).
+  *
+  * 		This file provides:
+  * 		 - Wait-state table lookup per supply voltage range
+  * 		 - LATENCY programming with read-back check
+  * 		 - Cache reset/enable sequencing and prefetch control
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "flash.h"
+
+#define FLASH_LATENCY_MAX		7U			/**< Highest LATENCY setting				*/
+
+/** @brief	HCLK covered by one wait state for each supply voltage range (Hz). */
+static const uint32_t FLASH_WS_STEP_HZ[] = {
+		20000000UL,		/**< 1.8 V - 2.1 V	*/
+		22000000UL,		/**< 2.1 V - 2.4 V	*/
+		24000000UL,		/**< 2.4 V - 2.7 V	*/
+		30000000UL		/**< 2.7 V - 3.6 V	*/
+};
+
+/**
+  * @brief	Minimum number of wait states for a given HCLK and supply voltage.
+  * @param[in] hclk_hz	AHB clock in Hz.
+  * @param[in] vrange	Supply voltage range.
+  * @retval	Wait states (0 to 7).
+  */
+uint32_t Flash_GetLatency(uint32_t hclk_hz, Flash_VRange_t vrange)
+{
+	if (vrange > FLASH_VRANGE_2V7_3V6)		/**< Unknown range: be safe		*/
+		return FLASH_LATENCY_MAX;
+
+	uint32_t step = FLASH_WS_STEP_HZ[vrange];
+	uint32_t ws = (hclk_hz + step - 1U) / step;		/**< CPU cycles per flash access	*/
+	ws = (ws > 0U) ? (ws - 1U) : 0U;				/**< Wait states = cycles - 1		*/
+
+	return (ws > FLASH_LATENCY_MAX) ? FLASH_LATENCY_MAX : ws;
+}
+
+/**
+  * @brief	Program FLASH_ACR LATENCY and wait until it is taken into account.
+  * @param[in] latency	Wait states (0 to 7).
+  * @retval	None
+  * @note	When raising HCLK, call this before switching the clock; when
+  * 		lowering HCLK, call it after the switch.
+  */
+void Flash_SetLatency(uint32_t latency)
+{
+	if (latency > FLASH_LATENCY_MAX)
+		latency = FLASH_LATENCY_MAX;
+
+	FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | (latency << FLASH_ACR_LATENCY_Pos);
+	while ((FLASH->ACR & FLASH_ACR_LATENCY) != (latency << FLASH_ACR_LATENCY_Pos));	/**< Read back	*/
+}
+
+/**
+  * @brief	Program the minimum wait states for a given HCLK and supply voltage.
+  * @param[in] hclk_hz	AHB clock in Hz.
+  * @param[in] vrange	Supply voltage range.
+  * @retval	None
+  * @note	Same ordering rule as Flash_SetLatency().
+  */
+void Flash_SetLatencyForClock(uint32_t hclk_hz, Flash_VRange_t vrange)
+{
+	Flash_SetLatency(Flash_GetLatency(hclk_hz, vrange));
+}
+
+/**
+  * @brief	Enable a set of accelerator features and disable the others.
+  * @param[in] accel	OR of FLASH_ACCEL_ICACHE, FLASH_ACCEL_DCACHE, FLASH_ACCEL_PREFETCH.
+  * @retval	None
+  * @note	Caches that are switched on are reset first, so no stale lines survive.
+  */
+void Flash_SetAccelerator(uint32_t accel)
+{
+	uint32_t acr = FLASH->ACR & ~(FLASH_ACR_ICEN | FLASH_ACR_DCEN | FLASH_ACR_PRFTEN);
+	uint32_t rst = 0;
+
+	accel &= FLASH_ACCEL_ALL;
+	if (accel & FLASH_ACCEL_ICACHE)
+		rst |= FLASH_ACR_ICRST;
+	if (accel & FLASH_ACCEL_DCACHE)
+		rst |= FLASH_ACR_DCRST;
+
+	FLASH->ACR = acr;					/**< Caches must be disabled to be reset	*/
+	if (rst)
+	{
+		FLASH->ACR = acr | rst;			/**< Reset caches							*/
+		FLASH->ACR = acr;				/**< Release reset							*/
+	}
+	FLASH->ACR = acr | accel;			/**< Enable requested features				*/
+}
+
+/**
+  * @brief	Apply an accelerator workload profile.
+  * @param[in] profile	Workload profile.
+  * @retval	None
+  */
+void Flash_SetProfile(Flash_Profile_t profile)
+{
+	switch (profile)
+	{
+		case FLASH_PROFILE_LINEAR:
+			Flash_SetAccelerator(FLASH_ACCEL_ALL);
+			break;
+
+		case FLASH_PROFILE_BRANCHY:
+			Flash_SetAccelerator(FLASH_ACCEL_ICACHE | FLASH_ACCEL_DCACHE);
+			break;
+
+		case FLASH_PROFILE_OFF:
+		default:
+			Flash_SetAccelerator(0U);
+			break;
+	}
+}
+
+/**
+  * @brief	Enable or disable the prefetch buffer only.
+  * @param[in] enable	1 to enable, 0 to disable.
+  * @retval	None
+  */
+void Flash_SetPrefetch(uint8_t enable)
+{
+	if (enable)
+		FLASH->ACR |= FLASH_ACR_PRFTEN;
+	else
+		FLASH->ACR &= ~FLASH_ACR_PRFTEN;
+}
+
+/**
+  * @brief	Invalidate the instruction and data caches, keeping their enable state.
+  * @param	None
+  * @retval	None
+  * @note	Call after programming or erasing flash, before executing or reading
+  * 		the modified area.
+  */
+void Flash_ResetCaches(void)
+{
+	Flash_SetAccelerator(FLASH->ACR & FLASH_ACCEL_ALL);
+}
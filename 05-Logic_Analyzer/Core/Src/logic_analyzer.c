@@ -0,0 +1,454 @@
+/**
+  * @file	logic_analyzer.c
+  * @author	Parham Estiri
+  * @brief	DMA-sampled GPIO logic analyzer.
+  *
+  * 		This file provides:
+  * 		 - TIM8 sample clock and DMA2 Stream1 circular capture of GPIOx->IDR
+  * 		 - Absolute sample position (DMA wraps + NDTR)
+  * 		 - Pattern/edge trigger scan with pre- and post-trigger depth
+  * 		 - Run-length encoded ITM export
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "logic_analyzer.h"
+
+#define LA_DEPTH_MASK		(LA_DEPTH - 1UL)
+#define LA_RATE_MIN_HZ		1000UL			/**< Lowest sample rate						*/
+#define LA_TIM_CLK_HZ		SystemCoreClock	/**< APB2 /2, timer clock x2 (168 MHz)		*/
+#define LA_DMA_STREAM		DMA2_Stream1	/**< TIM8_UP request: stream 1, channel 7	*/
+#define LA_DMA_CHANNEL		7UL
+#define LA_DMA_IRQn			DMA2_Stream1_IRQn
+#define LA_DMA_PRIORITY		0x01U			/**< DMA wrap counter pre-emption priority	*/
+
+static uint16_t la_buffer[LA_DEPTH];				/**< Circular sample buffer					*/
+static volatile uint32_t la_wraps = 0;				/**< Completed buffer passes (DMA TC)		*/
+static volatile LA_State_t la_state = LA_STATE_IDLE;	/**< Capture state						*/
+static LA_Config_t la_cfg;							/**< Configuration of the current capture	*/
+static LA_Stats_t la_stats;							/**< Statistics of the current capture		*/
+static uint32_t la_scan = 0;						/**< Next absolute index to scan			*/
+static uint16_t la_prev = 0;						/**< Sample before la_scan					*/
+static uint32_t la_trigger = 0;						/**< Absolute index of the trigger sample	*/
+
+#if (LA_PORT_SELECT == LA_PORT_LEDS)
+/** @brief	Channel names taken from the BSP pin definitions. */
+static const char *const la_channel_name[16] = {
+		[LED_GREEN_PIN]		= "LED_GREEN",
+		[LED_ORANGE_PIN]	= "LED_ORANGE",
+		[LED_RED_PIN]		= "LED_RED",
+		[LED_BLUE_PIN]		= "LED_BLUE"
+};
+#else
+/** @brief	Channel names taken from the BSP pin definitions. */
+static const char *const la_channel_name[16] = {
+		[BUTTON_PIN]		= "USER_BUTTON"
+};
+#endif /* LA_PORT_SELECT */
+
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t LA_Position(void);
+static void LA_Stop(void);
+static uint8_t LA_Scan(uint32_t limit);
+static void LA_Print(const char *str);
+static void LA_PrintU32(uint32_t value);
+static void LA_PrintHex16(uint16_t value);
+
+/**
+  * @brief	Enable the port, TIM8 and DMA2 clocks and configure the DMA interrupt.
+  * @param	None
+  * @retval	None
+  */
+void LA_Init(void)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+
+	LA_GPIO_CLK_EN();								/**< IDR is read even for output/AF pins	*/
+	RCC->APB2ENR |= RCC_APB2ENR_TIM8EN;				/**< Sample clock							*/
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;				/**< Only DMA2 reaches AHB1 (GPIO)			*/
+
+	TIM8->CR1 = 0;
+	LA_DMA_STREAM->CR = 0;
+	while (LA_DMA_STREAM->CR & DMA_SxCR_EN);
+
+	NVIC_SetPriority(LA_DMA_IRQn, NVIC_EncodePriority(PG, LA_DMA_PRIORITY, 0));
+	NVIC_EnableIRQ(LA_DMA_IRQn);
+}
+
+/**
+  * @brief	Start a capture.
+  * @param[in] cfg	Capture configuration.
+  * @retval	LA_OK, LA_EINVAL (rate, depth or channel out of range) or LA_EBUSY.
+  */
+LA_Status_t LA_Arm(const LA_Config_t *cfg)
+{
+	if (la_state == LA_STATE_PREFILL || la_state == LA_STATE_ARMED || la_state == LA_STATE_POST)
+		return LA_EBUSY;
+	if (cfg->rate_hz < LA_RATE_MIN_HZ || cfg->rate_hz > LA_RATE_MAX_HZ)
+		return LA_EINVAL;
+	if (cfg->post == 0 || cfg->pre > LA_WINDOW_MAX || cfg->post > LA_WINDOW_MAX - cfg->pre)
+		return LA_EINVAL;
+	if (cfg->mode > LA_TRIG_EDGE || (cfg->mode >= LA_TRIG_RISING && cfg->channel > 15U))
+		return LA_EINVAL;
+
+	la_cfg = *cfg;
+	la_wraps = 0;
+	la_stats.samples = 0;
+	la_stats.skipped = 0;
+	la_stats.runs = 0;
+
+	/* Sample clock: TIM8 update at rate_hz */
+	uint32_t div = LA_TIM_CLK_HZ / cfg->rate_hz;
+	uint32_t psc = (div - 1U) >> 16;				/**< Smallest prescaler with ARR <= 0xFFFF	*/
+	uint32_t arr = div / (psc + 1U) - 1U;
+	la_stats.rate_hz = LA_TIM_CLK_HZ / ((psc + 1U) * (arr + 1U));
+
+	TIM8->CR1  = 0;
+	TIM8->DIER = 0;
+	TIM8->PSC  = psc;
+	TIM8->ARR  = arr;
+	TIM8->CNT  = 0;
+	TIM8->EGR  = TIM_EGR_UG;						/**< Load PSC before the DMA request is on	*/
+	TIM8->SR   = 0;
+
+	/* DMA2 Stream1: IDR -> la_buffer, half-words, circular, direct mode */
+	LA_DMA_STREAM->CR = 0;
+	while (LA_DMA_STREAM->CR & DMA_SxCR_EN);
+	DMA2->LIFCR = DMA_LIFCR_CTCIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTEIF1
+				| DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CFEIF1;
+	LA_DMA_STREAM->PAR  = (uint32_t)&LA_GPIO_PORT->IDR;
+	LA_DMA_STREAM->M0AR = (uint32_t)la_buffer;
+	LA_DMA_STREAM->NDTR = LA_DEPTH;
+	LA_DMA_STREAM->FCR  = 0;						/**< Direct mode: NDTR matches memory		*/
+	LA_DMA_STREAM->CR   = (LA_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+						| DMA_SxCR_PL						/**< Very high priority				*/
+						| DMA_SxCR_MSIZE_0					/**< Memory: 16-bit					*/
+						| DMA_SxCR_PSIZE_0					/**< Peripheral: 16-bit				*/
+						| DMA_SxCR_MINC
+						| DMA_SxCR_CIRC
+						| DMA_SxCR_TCIE						/**< Count buffer passes			*/
+						| DMA_SxCR_TEIE
+						| DMA_SxCR_DMEIE;
+	LA_DMA_STREAM->CR  |= DMA_SxCR_EN;
+
+	la_state = LA_STATE_PREFILL;
+	TIM8->DIER = TIM_DIER_UDE;						/**< Update event -> DMA request			*/
+	TIM8->CR1  = TIM_CR1_CEN;						/**< Start sampling							*/
+
+	return LA_OK;
+}
+
+/**
+  * @brief	Advance the capture: scan for the trigger and stop after the post-trigger depth.
+  * @param	None
+  * @retval	Current state.
+  * @note	Call continuously from the main loop while a capture is running.
+  */
+LA_State_t LA_Poll(void)
+{
+	LA_State_t state = la_state;
+
+	if (state != LA_STATE_PREFILL && state != LA_STATE_ARMED && state != LA_STATE_POST)
+		return state;
+
+	uint32_t pos = LA_Position();
+
+	if (state == LA_STATE_PREFILL)
+	{
+		if (pos <= la_cfg.pre)						/**< Pre-trigger window not yet full		*/
+			return state;
+
+		if (la_cfg.mode == LA_TRIG_NONE)
+		{
+			la_trigger = la_cfg.pre;
+			state = LA_STATE_POST;
+		}
+		else
+		{
+			la_scan = la_cfg.pre;
+			la_prev = la_buffer[(la_scan ? la_scan - 1U : 0U) & LA_DEPTH_MASK];
+			state = LA_STATE_ARMED;
+		}
+		la_state = state;
+	}
+
+	if (state == LA_STATE_ARMED)
+	{
+		uint32_t limit = pos - 1U;					/**< Newest sample may still be in flight	*/
+		uint32_t lag_max = LA_DEPTH - la_cfg.pre - LA_GUARD;
+
+		if (limit - la_scan > lag_max)				/**< Too far behind: keep the pre window	*/
+		{
+			uint32_t skip = (limit - la_scan) - lag_max;
+			la_scan += skip;
+			la_stats.skipped += skip;
+			la_prev = la_buffer[(la_scan - 1U) & LA_DEPTH_MASK];
+		}
+
+		if (!LA_Scan(limit))
+			return state;
+		state = LA_STATE_POST;
+		la_state = state;
+	}
+
+	if ((int32_t)(pos - (la_trigger + la_cfg.post)) < 0)
+		return state;
+
+	LA_Stop();
+	uint32_t end = LA_Position();
+	if (end - (la_trigger - la_cfg.pre) > LA_DEPTH)	/**< Oldest pre-trigger samples overwritten	*/
+	{
+		la_state = LA_STATE_ERROR;
+		return LA_STATE_ERROR;
+	}
+
+	la_stats.samples = la_cfg.pre + la_cfg.post;
+	la_state = LA_STATE_DONE;
+	return LA_STATE_DONE;
+}
+
+/**
+  * @brief	Stop sampling and return to LA_STATE_IDLE.
+  * @param	None
+  * @retval	None
+  */
+void LA_Abort(void)
+{
+	LA_Stop();
+	la_state = LA_STATE_IDLE;
+}
+
+/**
+  * @brief	Write the capture as run-length encoded lines to ITM stimulus port 0.
+  * @param	None
+  * @retval	Number of runs, 0 when no capture is available.
+  */
+uint32_t LA_Export(void)
+{
+	if (la_state != LA_STATE_DONE)
+		return 0;
+
+	const uint32_t first = la_trigger - la_cfg.pre;
+	const uint32_t count = la_stats.samples;
+	const char port = (char)('A' + ((uint32_t)LA_GPIO_PORT - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE));
+
+	LA_Print("LA_BEGIN,");
+	LA_PrintU32(la_stats.rate_hz);
+	LA_Print(",");
+	LA_PrintU32(count);
+	LA_Print(",");
+	LA_PrintU32(la_cfg.pre);
+	LA_Print(",");
+	ITM_SendChar((uint32_t)port);
+	LA_Print("\n");
+
+	for (uint32_t ch = 0; ch < 16U; ch++)
+	{
+		if (!(LA_CHANNEL_MASK & (1UL << ch)))
+			continue;
+		LA_Print("LA_CH,");
+		LA_PrintU32(ch);
+		LA_Print(",");
+		if (la_channel_name[ch])
+		{
+			LA_Print(la_channel_name[ch]);
+		}
+		else
+		{
+			ITM_SendChar('P');
+			ITM_SendChar((uint32_t)port);
+			LA_PrintU32(ch);
+		}
+		LA_Print("\n");
+	}
+
+	uint32_t runs = 0;
+	uint16_t value = la_buffer[first & LA_DEPTH_MASK] & LA_CHANNEL_MASK;
+	uint32_t length = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint16_t s = la_buffer[(first + i) & LA_DEPTH_MASK] & LA_CHANNEL_MASK;
+		if (s != value)
+		{
+			LA_Print("LA,");
+			LA_PrintHex16(value);
+			LA_Print(",");
+			LA_PrintU32(length);
+			LA_Print("\n");
+			runs++;
+			value = s;
+			length = 0;
+		}
+		length++;
+	}
+	LA_Print("LA,");
+	LA_PrintHex16(value);
+	LA_Print(",");
+	LA_PrintU32(length);
+	LA_Print("\n");
+	runs++;
+
+	LA_Print("LA_END,");
+	LA_PrintU32(runs);
+	LA_Print("\n");
+
+	la_stats.runs = runs;
+	return runs;
+}
+
+/**
+  * @brief	Read the statistics of the last capture.
+  * @param[out] stats	Destination.
+  * @retval	None
+  */
+void LA_GetStats(LA_Stats_t *stats)
+{
+	*stats = la_stats;
+}
+
+/**
+  * @brief	Absolute index of the next sample the DMA will write.
+  * @retval	Samples written since LA_Arm().
+  * @note	A wrap whose TC interrupt is still pending is counted here, so the
+  * 		position never steps back when NDTR has already reloaded.
+  */
+static uint32_t LA_Position(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t wraps = la_wraps;
+	uint32_t ndtr = LA_DMA_STREAM->NDTR;
+	if (DMA2->LISR & DMA_LISR_TCIF1)				/**< Wrapped, interrupt not yet served		*/
+	{
+		wraps++;
+		ndtr = LA_DMA_STREAM->NDTR;					/**< Re-read: the first read may predate it	*/
+	}
+
+	__set_PRIMASK(primask);
+	return (wraps << LA_DEPTH_LOG2) + (LA_DEPTH - ndtr);
+}
+
+/**
+  * @brief	Stop the sample clock and disable the DMA stream.
+  * @param	None
+  * @retval	None
+  */
+static void LA_Stop(void)
+{
+	TIM8->CR1  = 0;
+	TIM8->DIER = 0;
+	LA_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+	while (LA_DMA_STREAM->CR & DMA_SxCR_EN);		/**< Last transfer completes first			*/
+}
+
+/**
+  * @brief	Scan samples [la_scan, limit) for the trigger condition.
+  * @param[in] limit	Absolute index to stop at (exclusive).
+  * @retval	1 if the trigger was found (la_trigger set), 0 otherwise.
+  */
+static uint8_t LA_Scan(uint32_t limit)
+{
+	uint32_t i = la_scan;
+	uint16_t prev = la_prev;
+
+	if (la_cfg.mode == LA_TRIG_PATTERN)
+	{
+		for (; i != limit; i++)
+		{
+			if ((la_buffer[i & LA_DEPTH_MASK] & la_cfg.mask) == la_cfg.value)
+			{
+				la_trigger = i;
+				return 1;
+			}
+		}
+	}
+	else
+	{
+		const uint16_t bit  = (uint16_t)(1U << la_cfg.channel);
+		const uint16_t rise = (la_cfg.mode != LA_TRIG_FALLING) ? bit : 0U;
+		const uint16_t fall = (la_cfg.mode != LA_TRIG_RISING)  ? bit : 0U;
+
+		for (; i != limit; i++)
+		{
+			uint16_t s = la_buffer[i & LA_DEPTH_MASK];
+			if (((uint16_t)(~prev & s) & rise) || ((uint16_t)(prev & ~s) & fall))
+			{
+				la_trigger = i;
+				return 1;
+			}
+			prev = s;
+		}
+	}
+
+	la_scan = i;
+	la_prev = prev;
+	return 0;
+}
+
+/**
+  * @brief	DMA2 Stream1 interrupt handler: counts buffer passes, stops on errors.
+  */
+void DMA2_Stream1_IRQHandler(void)
+{
+	uint32_t isr = DMA2->LISR;
+
+	if (isr & DMA_LISR_TCIF1)
+	{
+		DMA2->LIFCR = DMA_LIFCR_CTCIF1;
+		la_wraps++;
+	}
+	if (isr & (DMA_LISR_TEIF1 | DMA_LISR_DMEIF1))
+	{
+		DMA2->LIFCR = DMA_LIFCR_CTEIF1 | DMA_LIFCR_CDMEIF1;
+		LA_Stop();
+		la_state = LA_STATE_ERROR;
+	}
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  * @param[in] str	Null-terminated string.
+  * @retval	None
+  */
+static void LA_Print(const char *str)
+{
+	while (*str)
+	{
+		ITM_SendChar((uint32_t)*str++);
+	}
+}
+
+/**
+  * @brief	Write an unsigned decimal number to ITM stimulus port 0.
+  * @param[in] value	Number to print.
+  * @retval	None
+  */
+static void LA_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf) - 1;
+
+	buf[i] = '\0';
+	do {
+		buf[--i] = (char)('0' + (value % 10U));
+		value /= 10U;
+	} while (value != 0);
+
+	LA_Print(&buf[i]);
+}
+
+/**
+  * @brief	Write a 16-bit number as four hex digits to ITM stimulus port 0.
+  * @param[in] value	Number to print.
+  * @retval	None
+  */
+static void LA_PrintHex16(uint16_t value)
+{
+	static const char hex[] = "0123456789ABCDEF";
+
+	for (int32_t shift = 12; shift >= 0; shift -= 4)
+	{
+		ITM_SendChar((uint32_t)hex[(value >> shift) & 0xFU]);
+	}
+}
@@ -0,0 +1,139 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	On-chip logic analyzer.
+  *
+  * 		This file initializes the system, board support package (BSP) and
+  * 		the logic analyzer, drives a test signal on the four LEDs (TIM4 PWM)
+  * 		and captures the LED port on every press of the user button. Each
+  * 		capture is exported over ITM stimulus port 0 (SWO on PB3) as
+  * 		run-length encoded lines (see logic_analyzer.h).
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "logic_analyzer.h"
+
+#define TEST_SIGNAL_PERIOD_US	100U	/**< 10 kHz PWM on the LEDs		*/
+
+static volatile uint8_t la_request = 1;	/**< Set by the button callback to start a capture	*/
+
+/**
+  * @brief	Capture settings: 1 MHz, 4 ms before and 16 ms after a rising edge on the green LED.
+  */
+static const LA_Config_t la_config = {
+		.rate_hz	= 1000000UL,
+		.pre		= 4096U,
+		.post		= 16384U,
+		.mode		= LA_TRIG_RISING,
+		.mask		= 0,
+		.value		= 0,
+		.channel	= LED_GREEN_PIN
+};
+
+/**************************  Static Function Prototypes  ***************************/
+#if !defined(QEMU_NETDUINOPLUS2)
+static void Test_Signal_Init(void);
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs, button in EXTI mode).
+  * 		3. Initializes the logic analyzer (TIM8 + DMA2 Stream1).
+  * 		4. Starts a 10 kHz PWM test signal on the LEDs (10/30/50/70 % duty).
+  * 		5. Enters an infinite loop that arms a capture when requested,
+  * 		   polls it and exports it once complete.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	BSP_Button_Init(BUTTON_MODE_EXTI);	/**< Button starts a new capture			*/
+	LA_Init();							/**< Sample clock and DMA					*/
+#if !defined(QEMU_NETDUINOPLUS2)
+	Test_Signal_Init();					/**< TIM4 debounces the button under QEMU	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	/**< Main loop */
+	while (1)
+	{
+		if (la_request && LA_Arm(&la_config) == LA_OK)
+		{
+			la_request = 0;
+		}
+
+		switch (LA_Poll())
+		{
+			case LA_STATE_DONE:
+				LA_Export();			/**< RLE lines over ITM			*/
+				LA_Abort();				/**< Back to idle				*/
+				break;
+
+			case LA_STATE_ERROR:
+				LA_Abort();
+				la_request = 1;			/**< Retry						*/
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+/**
+  * @brief	Button callback: request another capture.
+  */
+void BSP_Button_Callback(void)
+{
+	la_request = 1;
+}
+
+#if !defined(QEMU_NETDUINOPLUS2)
+/**
+  * @brief	Drive a PWM test signal on the four LEDs.
+  *
+  * 		PD12..PD15 are TIM4 CH1..CH4 (AF2). All channels share a 10 kHz
+  * 		period with 10, 30, 50 and 70 % duty cycle.
+  *
+  * @param	None
+  * @retval	None
+  */
+static void Test_Signal_Init(void)
+{
+	static const uint8_t led_pin[LEDn] = { LED_GREEN_PIN, LED_ORANGE_PIN, LED_RED_PIN, LED_BLUE_PIN };
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;			/**< Enable TIM4 clock					*/
+
+	for (uint32_t i = 0; i < LEDn; i++)			/**< LED pins: alternate function 2		*/
+	{
+		uint32_t pin = led_pin[i];
+		LED_GPIO_PORT->MODER = (LED_GPIO_PORT->MODER & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+		LED_GPIO_PORT->AFR[pin >> 3] = (LED_GPIO_PORT->AFR[pin >> 3] & ~(0xFUL << ((pin & 7U) * 4)))
+									 | (2UL << ((pin & 7U) * 4));
+	}
+
+	TIM4->PSC   = 84 - 1;						/**< 84 MHz / 84 = 1 MHz				*/
+	TIM4->ARR   = TEST_SIGNAL_PERIOD_US - 1;
+	TIM4->CCMR1 = (6UL << TIM_CCMR1_OC1M_Pos) | TIM_CCMR1_OC1PE		/**< PWM mode 1, preload	*/
+				| (6UL << TIM_CCMR1_OC2M_Pos) | TIM_CCMR1_OC2PE;
+	TIM4->CCMR2 = (6UL << TIM_CCMR2_OC3M_Pos) | TIM_CCMR2_OC3PE
+				| (6UL << TIM_CCMR2_OC4M_Pos) | TIM_CCMR2_OC4PE;
+	TIM4->CCR1  = TEST_SIGNAL_PERIOD_US * 10U / 100U;
+	TIM4->CCR2  = TEST_SIGNAL_PERIOD_US * 30U / 100U;
+	TIM4->CCR3  = TEST_SIGNAL_PERIOD_US * 50U / 100U;
+	TIM4->CCR4  = TEST_SIGNAL_PERIOD_US * 70U / 100U;
+	TIM4->CCER  = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E;
+	TIM4->EGR   = TIM_EGR_UG;					/**< Load prescaler and compare values	*/
+	TIM4->CR1   = TIM_CR1_ARPE | TIM_CR1_CEN;
+}
+#endif /* QEMU_NETDUINOPLUS2 */
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Convert a 05-Logic_Analyzer capture to a VCD file.
+
+The firmware writes each capture to ITM port 0 (SWO) as run-length encoded
+lines:
+
+    LA_BEGIN,<rate_hz>,<samples>,<trigger>,<port>
+    LA_CH,<bit>,<name>
+    LA,<value hex>,<count>
+    LA_END,<runs>
+
+Capture the SWO output to a text file (for example with the STM32CubeIDE SWV
+console), then run:
+
+    python3 la_vcd.py capture.txt -o capture.vcd
+
+The VCD opens in GTKWave, PulseView, or sigrok-cli (`-I vcd`). A `TRIGGER`
+signal goes high at the trigger sample. Lines that do not start with `LA`
+are ignored. Only the last capture in the file is used, unless you pick
+another with --index. No third-party packages are needed.
+"""
+
+import argparse
+import sys
+
+
+def parse(path):
+    """Return a list of captures: dicts with rate, samples, trigger, port, channels, runs."""
+    captures, cur = [], None
+    with open(path, encoding="utf-8", errors="replace") as fh:
+        for line in fh:
+            fields = line.strip().split(",")
+            tag = fields[0]
+            if tag == "LA_BEGIN" and len(fields) == 5:
+                cur = {"rate": int(fields[1]), "samples": int(fields[2]),
+                       "trigger": int(fields[3]), "port": fields[4],
+                       "channels": [], "runs": []}
+            elif cur is None:
+                continue
+            elif tag == "LA_CH" and len(fields) == 3:
+                cur["channels"].append((int(fields[1]), fields[2]))
+            elif tag == "LA" and len(fields) == 3:
+                cur["runs"].append((int(fields[1], 16), int(fields[2])))
+            elif tag == "LA_END":
+                total = sum(n for _, n in cur["runs"])
+                if total != cur["samples"]:
+                    print(f"warning: capture has {total} samples, header says {cur['samples']}",
+                          file=sys.stderr)
+                captures.append(cur)
+                cur = None
+    return captures
+
+
+def vcd_ids(count):
+    """Short printable VCD identifiers."""
+    return [chr(33 + i) for i in range(count)]
+
+
+def write_vcd(cap, out):
+    """Write one capture as VCD; time unit is 1 ns."""
+    chans = cap["channels"]
+    ids = vcd_ids(len(chans) + 1)
+    trig_id = ids[-1]
+    ns_per_sample = 1e9 / cap["rate"]
+
+    out.write("$date STM32F407 on-chip logic analyzer $end\n")
+    out.write("$timescale 1 ns $end\n")
+    out.write(f"$scope module GPIO{cap['port']} $end\n")
+    for (bit, name), ident in zip(chans, ids):
+        out.write(f"$var wire 1 {ident} {name} $end\n")
+    out.write(f"$var wire 1 {trig_id} TRIGGER $end\n")
+    out.write("$upscope $end\n$enddefinitions $end\n")
+
+    events = {}                                 # sample index -> value changes
+    index, prev = 0, None
+    for value, count in cap["runs"]:
+        changes = [f"{(value >> bit) & 1}{ident}" for (bit, _), ident in zip(chans, ids)
+                   if prev is None or ((value ^ prev) >> bit) & 1]
+        if changes:
+            events.setdefault(index, []).extend(changes)
+        prev = value
+        index += count
+    if cap["trigger"] > 0:
+        events.setdefault(0, []).append(f"0{trig_id}")
+    events.setdefault(cap["trigger"], []).append(f"1{trig_id}")
+
+    for at in sorted(events):
+        out.write(f"#{round(at * ns_per_sample)}\n" + "\n".join(events[at]) + "\n")
+    out.write(f"#{round(index * ns_per_sample)}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", help="SWO/ITM text capture")
+    parser.add_argument("-o", "--output", help="VCD file to write (default: stdout)")
+    parser.add_argument("--index", type=int, default=-1,
+                        help="capture to convert, 0-based (default: last)")
+    args = parser.parse_args()
+
+    captures = parse(args.capture)
+    if not captures:
+        sys.exit("no complete LA_BEGIN ... LA_END capture found")
+    cap = captures[args.index]
+
+    ratio = cap["samples"] * 2 / max(1, len(cap["runs"]) * 4)
+    print(f"{cap['samples']} samples at {cap['rate']} Hz, {len(cap['runs'])} runs "
+          f"(RLE {ratio:.1f}:1 vs 16-bit samples), trigger at {cap['trigger']}", file=sys.stderr)
+
+    if args.output:
+        with open(args.output, "w", encoding="ascii") as out:
+            write_vcd(cap, out)
+    else:
+        write_vcd(cap, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,110 @@
+/**
+  * @file	input_capture.h
+  * @author	Parham Estiri
+  * @brief	Input-capture frequency, period and duty-cycle measurement with DMA.
+  *
+  * 		This module provides three independent capture units:
+  * 		 - TIM2 (32-bit) on PB10, TIM5 (32-bit) on PA2, TIM3 (16-bit) on PB0
+  * 		 - Channel 3 captures rising edges (TI3 direct), channel 4 captures
+  * 		   falling edges of the same pin (TI3 indirect)
+  * 		 - Each capture channel is copied by its own DMA1 stream into a ring
+  * 		   buffer of timestamps, so no interrupt is taken per edge
+  * 		 - Batch processing with reciprocal counting: frequency is
+  * 		   `periods × timer clock / elapsed ticks` over every period in the
+  * 		   batch, so resolution is set by the timer clock, not by a gate time
+  *
+  * 		| Unit | Pin  | AF | Rise (CH3)           | Fall (CH4)           |
+  * 		|------|------|----|----------------------|----------------------|
+  * 		| TIM2 | PB10 | 1  | DMA1 Stream1, ch 3   | DMA1 Stream6, ch 3   |
+  * 		| TIM5 | PA2  | 2  | DMA1 Stream0, ch 6   | DMA1 Stream3, ch 6   |
+  * 		| TIM3 | PB0  | 2  | DMA1 Stream7, ch 5   | DMA1 Stream2, ch 5   |
+  *
+  * @note	TIM3 is 16-bit: with IC_TIM3_PSC = 0 a period must stay below
+  * 		65536 ticks (780 µs, i.e. above 1.3 kHz). Use TIM2/TIM5 for slow signals.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef INPUT_CAPTURE_H_
+#define INPUT_CAPTURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+
+/******************************  Configuration  ******************************/
+#define IC_RING_LOG2			8U		/**< 256 timestamps per edge direction			*/
+#define IC_GUARD				16U		/**< Ring entries never read (DMA headroom)		*/
+#define IC_FILTER				0U		/**< Input filter (0 = none, up to 15)			*/
+#define IC_TIM2_PSC				0U		/**< TIM2 prescaler (84 MHz ticks)				*/
+#define IC_TIM5_PSC				0U		/**< TIM5 prescaler (84 MHz ticks)				*/
+#define IC_TIM3_PSC				0U		/**< TIM3 prescaler (84 MHz ticks)				*/
+
+#define IC_RING					(1UL << IC_RING_LOG2)
+#define IC_TIM_CLK_HZ			(SystemCoreClock / 2U)	/**< APB1 /4, timer clock x2 (84 MHz)	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Capture units.
+  */
+typedef enum {
+	IC_UNIT_TIM2	= 0,	/**< TIM2, PB10		*/
+	IC_UNIT_TIM5	= 1,	/**< TIM5, PA2		*/
+	IC_UNIT_TIM3	= 2,	/**< TIM3, PB0		*/
+	IC_UNITS		= 3
+} IC_Unit_t;
+
+/**
+  * @brief	Result of one batch.
+  */
+typedef struct {
+	uint32_t	periods;		/**< Complete periods in the batch (0: no new edges)	*/
+	uint64_t	ticks;			/**< Timer ticks spanned by those periods				*/
+	uint64_t	freq_uhz;		/**< Frequency in µHz (reciprocal)						*/
+	uint32_t	period_ns;		/**< Mean period in ns									*/
+	uint32_t	duty_ppm;		/**< Duty cycle in parts per million					*/
+	uint32_t	overruns;		/**< Batches that skipped overwritten edges (total)		*/
+} IC_Result_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure the pins, timers and DMA streams of all capture units (stopped).
+  * @param	None
+  * @retval	None
+  */
+void IC_Init(void);
+
+/**
+  * @brief	Start capturing on a unit.
+  * @param[in] unit	Capture unit.
+  * @retval	None
+  */
+void IC_Start(IC_Unit_t unit);
+
+/**
+  * @brief	Stop capturing on a unit.
+  * @param[in] unit	Capture unit.
+  * @retval	None
+  */
+void IC_Stop(IC_Unit_t unit);
+
+/**
+  * @brief	Process every edge captured since the previous call.
+  * @param[in] unit		Capture unit.
+  * @param[out] result	Batch result.
+  * @retval	1 if the batch contains at least one complete period, 0 otherwise.
+  * @note	When more than IC_RING - IC_GUARD edges arrived since the previous
+  * 		call, the older ones are skipped and the batch covers the most recent
+  * 		edges only (counted in `overruns`). Reciprocal counting stays exact.
+  */
+uint8_t IC_Process(IC_Unit_t unit, IC_Result_t *result);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* INPUT_CAPTURE_H_ */
@@ -0,0 +1,35 @@
+/**
+  * @file	qemu_board.h
+  * @author	Parham Estiri
+  * @brief	Board shim for running the firmware under QEMU (netduinoplus2).
+  *
+  * 		The `netduinoplus2` machine of `qemu-system-arm` emulates an STM32F405,
+  * 		which shares the memory map of the STM32F407 but only models a subset
+  * 		of its peripherals. This header collects the constants that differ:
+  * 		 - RCC, PWR, FLASH interface and DBGMCU are not emulated, so the PLL
+  * 		   never locks and SYSCLK is fixed by the machine.
+  * 		 - GPIO ports are not emulated (reads return 0, writes are ignored).
+  * 		 - Only TIM2..TIM5 are emulated, clocked from a fixed 1 GHz source,
+  * 		   without one-pulse mode.
+  * 		 - SysTick, NVIC, EXTI and SYSCFG behave as on the real device.
+  *
+  * @note	Only included when QEMU_NETDUINOPLUS2 is defined (QEMU build configuration).
+  *
+  * Target	QEMU netduinoplus2 (STM32F405RG)
+  */
+
+#ifndef QEMU_BOARD_H_
+#define QEMU_BOARD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define QEMU_SYSCLK_HZ			168000000UL		/**< Fixed SYSCLK of the netduinoplus2 machine	*/
+#define QEMU_TIMER_CLK_HZ		1000000000UL	/**< Input clock of the emulated TIM2..TIM5		*/
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* QEMU_BOARD_H_ */
@@ -0,0 +1,345 @@
+/**
+  * @file	input_capture.c
+  * @author	Parham Estiri
+  * @brief	Input-capture frequency, period and duty-cycle measurement with DMA.
+  *
+  * 		This file provides:
+  * 		 - Unit table (timer, pin, DMA streams) and their configuration
+  * 		 - DMA1 stream wrap counters (one transfer-complete interrupt per
+  * 		   IC_RING edges, not per edge)
+  * 		 - Batch processing: period sum, rise/fall pairing, reciprocal frequency
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "input_capture.h"
+
+#define IC_RING_MASK		(IC_RING - 1UL)
+#define IC_DMA_PRIORITY		0x02U			/**< Wrap counter pre-emption priority		*/
+#define IC_DMA_STREAMS		8U
+
+/**
+  * @brief	Static description of a capture unit.
+  */
+typedef struct {
+	TIM_TypeDef			*tim;			/**< Timer instance							*/
+	DMA_Stream_TypeDef	*rise_dma;		/**< Stream serving CC3 (rising edges)		*/
+	DMA_Stream_TypeDef	*fall_dma;		/**< Stream serving CC4 (falling edges)		*/
+	uint32_t			dma_channel;	/**< Request channel for both streams		*/
+	GPIO_TypeDef		*port;			/**< Input pin port							*/
+	uint32_t			pin;			/**< Input pin number						*/
+	uint32_t			af;				/**< Alternate function (TIMx_CH3)			*/
+	uint32_t			psc;			/**< Timer prescaler						*/
+	uint32_t			max;			/**< Counter mask (16 or 32 bits)			*/
+	uint32_t			tim_en;			/**< RCC_APB1ENR timer clock bit			*/
+	uint32_t			gpio_en;		/**< RCC_AHB1ENR port clock bit				*/
+} IC_Def_t;
+
+/**
+  * @brief	Run-time state of a capture unit.
+  */
+typedef struct {
+	uint32_t	rise[IC_RING];		/**< Rising edge timestamps (DMA ring)		*/
+	uint32_t	fall[IC_RING];		/**< Falling edge timestamps (DMA ring)		*/
+	uint32_t	rise_read;			/**< Next rising edge to process (absolute)	*/
+	uint32_t	fall_read;			/**< Next falling edge to process (absolute)*/
+	uint32_t	last_rise;			/**< Timestamp of the last processed rise	*/
+	uint8_t		has_last;			/**< last_rise is valid						*/
+	uint32_t	overruns;			/**< Batches that skipped edges				*/
+} IC_State_t;
+
+/** @brief	Capture units (see the table in input_capture.h). */
+static const IC_Def_t ic_def[IC_UNITS] = {
+		[IC_UNIT_TIM2] = { TIM2, DMA1_Stream1, DMA1_Stream6, 3, GPIOB, 10, 1, IC_TIM2_PSC, 0xFFFFFFFFUL,
+						   RCC_APB1ENR_TIM2EN, RCC_AHB1ENR_GPIOBEN },
+		[IC_UNIT_TIM5] = { TIM5, DMA1_Stream0, DMA1_Stream3, 6, GPIOA,  2, 2, IC_TIM5_PSC, 0xFFFFFFFFUL,
+						   RCC_APB1ENR_TIM5EN, RCC_AHB1ENR_GPIOAEN },
+		[IC_UNIT_TIM3] = { TIM3, DMA1_Stream7, DMA1_Stream2, 5, GPIOB,  0, 2, IC_TIM3_PSC, 0x0000FFFFUL,
+						   RCC_APB1ENR_TIM3EN, RCC_AHB1ENR_GPIOBEN }
+};
+
+/** @brief	DMA1 stream interrupt numbers. */
+static const IRQn_Type ic_dma_irq[IC_DMA_STREAMS] = {
+		DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+		DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn
+};
+
+/** @brief	Flag offset of a stream inside LISR/HISR (streams 0/4, 1/5, 2/6, 3/7). */
+static const uint8_t ic_dma_flag_pos[4] = { 0U, 6U, 16U, 22U };
+
+static IC_State_t ic_state[IC_UNITS];					/**< Unit state and rings				*/
+static volatile uint32_t ic_dma_wraps[IC_DMA_STREAMS];	/**< Completed ring passes per stream	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t IC_Stream_Index(const DMA_Stream_TypeDef *stream);
+static void IC_DMA_Start(DMA_Stream_TypeDef *stream, uint32_t channel, volatile uint32_t *src, uint32_t *ring);
+static void IC_DMA_Stop(DMA_Stream_TypeDef *stream);
+static uint32_t IC_Position(const DMA_Stream_TypeDef *stream);
+static void IC_DMA_IRQHandler(uint32_t n);
+
+/**
+  * @brief	Configure the pins, timers and DMA streams of all capture units (stopped).
+  * @param	None
+  * @retval	None
+  */
+void IC_Init(void)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;				/**< DMA1 serves the APB1 timers			*/
+
+	for (uint32_t u = 0; u < IC_UNITS; u++)
+	{
+		const IC_Def_t *d = &ic_def[u];
+
+		RCC->AHB1ENR |= d->gpio_en;
+		RCC->APB1ENR |= d->tim_en;
+
+		d->port->MODER = (d->port->MODER & ~(3UL << (d->pin * 2))) | (2UL << (d->pin * 2));	/**< AF	*/
+		d->port->PUPDR &= ~(3UL << (d->pin * 2));	/**< No pull: driven by the signal		*/
+		d->port->AFR[d->pin >> 3] = (d->port->AFR[d->pin >> 3] & ~(0xFUL << ((d->pin & 7U) * 4)))
+								  | (d->af << ((d->pin & 7U) * 4));
+
+		d->tim->CR1   = 0;							/**< Counter stopped, up-counting			*/
+		d->tim->PSC   = d->psc;
+		d->tim->ARR   = d->max;						/**< Free-running over the full range		*/
+		d->tim->CCMR2 = (1UL << TIM_CCMR2_CC3S_Pos)	/**< IC3 on TI3: rising edges				*/
+					  | (IC_FILTER << TIM_CCMR2_IC3F_Pos)
+					  | (2UL << TIM_CCMR2_CC4S_Pos)	/**< IC4 on TI3: falling edges				*/
+					  | (IC_FILTER << TIM_CCMR2_IC4F_Pos);
+		d->tim->CCER  = TIM_CCER_CC4P;				/**< CC4 on the falling edge, both disabled	*/
+
+		NVIC_SetPriority(ic_dma_irq[IC_Stream_Index(d->rise_dma)], NVIC_EncodePriority(PG, IC_DMA_PRIORITY, 0));
+		NVIC_SetPriority(ic_dma_irq[IC_Stream_Index(d->fall_dma)], NVIC_EncodePriority(PG, IC_DMA_PRIORITY, 0));
+		NVIC_EnableIRQ(ic_dma_irq[IC_Stream_Index(d->rise_dma)]);
+		NVIC_EnableIRQ(ic_dma_irq[IC_Stream_Index(d->fall_dma)]);
+	}
+}
+
+/**
+  * @brief	Start capturing on a unit.
+  * @param[in] unit	Capture unit.
+  * @retval	None
+  */
+void IC_Start(IC_Unit_t unit)
+{
+	const IC_Def_t *d = &ic_def[unit];
+	IC_State_t *st = &ic_state[unit];
+
+	IC_Stop(unit);
+	st->rise_read = 0;
+	st->fall_read = 0;
+	st->has_last  = 0;
+	st->overruns  = 0;
+
+	IC_DMA_Start(d->rise_dma, d->dma_channel, &d->tim->CCR3, st->rise);
+	IC_DMA_Start(d->fall_dma, d->dma_channel, &d->tim->CCR4, st->fall);
+
+	d->tim->CNT  = 0;
+	d->tim->EGR  = TIM_EGR_UG;						/**< Load prescaler							*/
+	d->tim->SR   = 0;
+	d->tim->DIER = TIM_DIER_CC3DE | TIM_DIER_CC4DE;	/**< One DMA request per captured edge		*/
+	d->tim->CCER = TIM_CCER_CC3E | TIM_CCER_CC4E | TIM_CCER_CC4P;
+	d->tim->CR1  = TIM_CR1_CEN;
+}
+
+/**
+  * @brief	Stop capturing on a unit.
+  * @param[in] unit	Capture unit.
+  * @retval	None
+  */
+void IC_Stop(IC_Unit_t unit)
+{
+	const IC_Def_t *d = &ic_def[unit];
+
+	d->tim->CR1  = 0;
+	d->tim->DIER = 0;
+	d->tim->CCER = TIM_CCER_CC4P;
+	IC_DMA_Stop(d->rise_dma);
+	IC_DMA_Stop(d->fall_dma);
+}
+
+/**
+  * @brief	Process every edge captured since the previous call.
+  * @param[in] unit		Capture unit.
+  * @param[out] result	Batch result.
+  * @retval	1 if the batch contains at least one complete period, 0 otherwise.
+  */
+uint8_t IC_Process(IC_Unit_t unit, IC_Result_t *result)
+{
+	const IC_Def_t *d = &ic_def[unit];
+	IC_State_t *st = &ic_state[unit];
+	const uint32_t span = IC_RING - IC_GUARD;
+	const uint32_t rise_end = IC_Position(d->rise_dma);
+	const uint32_t fall_end = IC_Position(d->fall_dma);
+	uint8_t skipped = 0;
+
+	if (rise_end - st->rise_read > span)			/**< Oldest rises overwritten: resync		*/
+	{
+		st->rise_read = rise_end - span;
+		st->has_last = 0;
+		skipped = 1;
+	}
+	if (fall_end - st->fall_read > span)
+	{
+		st->fall_read = fall_end - span;
+		skipped = 1;
+	}
+	st->overruns += skipped;
+
+	uint64_t ticks = 0, high = 0;
+	uint32_t periods = 0, pairs = 0;
+
+	for (; st->rise_read != rise_end; st->rise_read++)
+	{
+		uint32_t r = st->rise[st->rise_read & IC_RING_MASK];
+
+		if (st->has_last)
+		{
+			uint32_t period = (r - st->last_rise) & d->max;
+			ticks += period;
+			periods++;
+
+			while (st->fall_read != fall_end)		/**< Falling edge inside [last_rise, r)		*/
+			{
+				uint32_t h = (st->fall[st->fall_read & IC_RING_MASK] - st->last_rise) & d->max;
+				if (h != 0 && h < period)
+				{
+					high += h;
+					pairs++;
+					st->fall_read++;
+					break;
+				}
+				if (h > (d->max >> 1))				/**< Before last_rise: stale, drop it		*/
+				{
+					st->fall_read++;
+					continue;
+				}
+				break;								/**< Belongs to a later period				*/
+			}
+		}
+		st->last_rise = r;
+		st->has_last = 1;
+	}
+
+	result->periods  = periods;
+	result->ticks    = ticks;
+	result->overruns = st->overruns;
+	if (periods == 0 || ticks == 0)
+	{
+		result->freq_uhz  = 0;
+		result->period_ns = 0;
+		result->duty_ppm  = 0;
+		return 0;
+	}
+
+	const uint64_t clk = IC_TIM_CLK_HZ / (d->psc + 1U);
+	uint64_t period_ns = (ticks * 1000000000ULL) / (periods * clk);
+
+	result->freq_uhz  = ((uint64_t)periods * clk * 1000000ULL) / ticks;		/**< Reciprocal counting	*/
+	result->period_ns = (period_ns > 0xFFFFFFFFULL) ? 0xFFFFFFFFUL : (uint32_t)period_ns;
+	result->duty_ppm  = pairs ? (uint32_t)((high * periods * 1000000ULL) / (pairs * ticks)) : 0U;
+	return 1;
+}
+
+/**
+  * @brief	Index (0..7) of a DMA1 stream.
+  */
+static uint32_t IC_Stream_Index(const DMA_Stream_TypeDef *stream)
+{
+	return ((uint32_t)stream - DMA1_Stream0_BASE) / (DMA1_Stream1_BASE - DMA1_Stream0_BASE);
+}
+
+/**
+  * @brief	Start a circular 32-bit peripheral-to-memory stream into a ring.
+  * @param[in] stream	DMA1 stream.
+  * @param[in] channel	Request channel.
+  * @param[in] src		Capture/compare register.
+  * @param[in] ring		Destination ring (IC_RING words).
+  * @retval	None
+  */
+static void IC_DMA_Start(DMA_Stream_TypeDef *stream, uint32_t channel, volatile uint32_t *src, uint32_t *ring)
+{
+	uint32_t n = IC_Stream_Index(stream);
+	volatile uint32_t *ifcr = (n < 4U) ? &DMA1->LIFCR : &DMA1->HIFCR;
+
+	IC_DMA_Stop(stream);
+	*ifcr = 0x3DUL << ic_dma_flag_pos[n & 3U];		/**< Clear TC, HT, TE, DME, FE				*/
+	ic_dma_wraps[n] = 0;
+
+	stream->PAR  = (uint32_t)src;
+	stream->M0AR = (uint32_t)ring;
+	stream->NDTR = IC_RING;
+	stream->FCR  = 0;								/**< Direct mode: NDTR matches memory		*/
+	stream->CR   = (channel << DMA_SxCR_CHSEL_Pos)
+				 | DMA_SxCR_PL_1					/**< High priority							*/
+				 | DMA_SxCR_MSIZE_1					/**< Memory: 32-bit							*/
+				 | DMA_SxCR_PSIZE_1					/**< Peripheral: 32-bit						*/
+				 | DMA_SxCR_MINC
+				 | DMA_SxCR_CIRC
+				 | DMA_SxCR_TCIE;					/**< Count ring passes						*/
+	stream->CR  |= DMA_SxCR_EN;
+}
+
+/**
+  * @brief	Disable a DMA stream and wait until it is off.
+  */
+static void IC_DMA_Stop(DMA_Stream_TypeDef *stream)
+{
+	stream->CR &= ~DMA_SxCR_EN;
+	while (stream->CR & DMA_SxCR_EN);
+}
+
+/**
+  * @brief	Absolute number of timestamps a stream has written.
+  * @note	A wrap whose interrupt is still pending is counted here, so the
+  * 		position never steps back when NDTR has already reloaded.
+  */
+static uint32_t IC_Position(const DMA_Stream_TypeDef *stream)
+{
+	uint32_t n = IC_Stream_Index(stream);
+	volatile uint32_t *isr = (n < 4U) ? &DMA1->LISR : &DMA1->HISR;
+	uint32_t tcif = DMA_LISR_TCIF0 << ic_dma_flag_pos[n & 3U];
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t wraps = ic_dma_wraps[n];
+	uint32_t ndtr = stream->NDTR;
+	if (*isr & tcif)								/**< Wrapped, interrupt not yet served		*/
+	{
+		wraps++;
+		ndtr = stream->NDTR;
+	}
+
+	__set_PRIMASK(primask);
+	return (wraps << IC_RING_LOG2) + (IC_RING - ndtr);
+}
+
+/**
+  * @brief	Common DMA1 stream interrupt: count ring passes, clear errors.
+  * @param[in] n	Stream index.
+  */
+static void IC_DMA_IRQHandler(uint32_t n)
+{
+	volatile uint32_t *isr  = (n < 4U) ? &DMA1->LISR  : &DMA1->HISR;
+	volatile uint32_t *ifcr = (n < 4U) ? &DMA1->LIFCR : &DMA1->HIFCR;
+	uint32_t pos = ic_dma_flag_pos[n & 3U];
+	uint32_t flags = (*isr >> pos) & 0x3DUL;
+
+	*ifcr = flags << pos;
+	if (flags & DMA_LISR_TCIF0)
+		ic_dma_wraps[n]++;
+}
+
+/** @brief	TIM5 CH3 (rising) ring pass. */
+void DMA1_Stream0_IRQHandler(void) { IC_DMA_IRQHandler(0); }
+/** @brief	TIM2 CH3 (rising) ring pass. */
+void DMA1_Stream1_IRQHandler(void) { IC_DMA_IRQHandler(1); }
+/** @brief	TIM3 CH4 (falling) ring pass. */
+void DMA1_Stream2_IRQHandler(void) { IC_DMA_IRQHandler(2); }
+/** @brief	TIM5 CH4 (falling) ring pass. */
+void DMA1_Stream3_IRQHandler(void) { IC_DMA_IRQHandler(3); }
+/** @brief	TIM2 CH4 (falling) ring pass. */
+void DMA1_Stream6_IRQHandler(void) { IC_DMA_IRQHandler(6); }
+/** @brief	TIM3 CH3 (rising) ring pass. */
+void DMA1_Stream7_IRQHandler(void) { IC_DMA_IRQHandler(7); }
@@ -0,0 +1,199 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	Input-capture frequency and duty-cycle measurement.
+  *
+  * 		This file initializes the system, board support package (BSP) LEDs
+  * 		and the three input-capture units, drives a test signal on three LEDs
+  * 		(TIM4 PWM) and prints one measurement per unit every 100 ms over ITM
+  * 		stimulus port 0 (SWO on PB3):
+  *
+  * 		`IC,<unit>,<periods>,<freq Hz>,<period ns>,<duty %>,<overruns>`
+  *
+  * 		Jumper the LEDs to the capture inputs to measure the test signal:
+  * 		PD12 -> PB10 (TIM2), PD13 -> PA2 (TIM5), PD14 -> PB0 (TIM3).
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "delay.h"
+#include "input_capture.h"
+
+#define TEST_SIGNAL_HZ			2000U		/**< Test PWM rate						*/
+#define TEST_SIGNAL_ARR			(84000000UL / TEST_SIGNAL_HZ - 1U)	/**< TIM4 at 84 MHz	*/
+#define REPORT_PERIOD_MS		100U		/**< One batch per unit every 100 ms	*/
+
+/* A normal batch must fit the ring, or every IC_Process() call overruns */
+_Static_assert((uint64_t)TEST_SIGNAL_HZ * REPORT_PERIOD_MS / 1000U < IC_RING - IC_GUARD,
+			   "Test signal too fast for the report period: edges of one batch exceed the ring");
+
+/** @brief	Unit names, as printed. */
+static const char *const ic_name[IC_UNITS] = { "TIM2", "TIM5", "TIM3" };
+
+/**************************  Static Function Prototypes  ***************************/
+#if !defined(QEMU_NETDUINOPLUS2)
+static void Test_Signal_Init(void);
+#endif /* QEMU_NETDUINOPLUS2 */
+static void Report(IC_Unit_t unit, const IC_Result_t *result);
+static void ITM_Print(const char *str);
+static void ITM_PrintU32(uint32_t value);
+static void ITM_PrintFixed(uint64_t value, uint32_t scale, uint32_t digits);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs).
+  * 		3. Initializes and starts the capture units (TIM2, TIM5, TIM3 + DMA1).
+  * 		4. Starts a 2 kHz PWM test signal on the LEDs (25/50/75 % duty).
+  * 		   About 200 periods arrive per report, within the 240 the ring
+  * 		   holds, so every batch uses every edge.
+  * 		5. Enters an infinite loop that processes and prints every unit
+  * 		   each REPORT_PERIOD_MS.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	IC_Result_t result;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	IC_Init();							/**< Capture timers and DMA1 streams		*/
+	Delay_Init();						/**< Report period							*/
+#if !defined(QEMU_NETDUINOPLUS2)
+	Test_Signal_Init();					/**< TIM4 debounces the button under QEMU	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	for (uint32_t u = 0; u < IC_UNITS; u++)
+	{
+#if defined(QEMU_NETDUINOPLUS2)
+		if (u == IC_UNIT_TIM5)
+			continue;					/**< TIM5 is the delay timer under QEMU		*/
+#endif /* QEMU_NETDUINOPLUS2 */
+		IC_Start((IC_Unit_t)u);
+	}
+
+	/**< Main loop */
+	while (1)
+	{
+		Delay_ms(REPORT_PERIOD_MS);
+
+		for (uint32_t u = 0; u < IC_UNITS; u++)
+		{
+			IC_Process((IC_Unit_t)u, &result);
+			Report((IC_Unit_t)u, &result);
+		}
+	}
+}
+
+#if !defined(QEMU_NETDUINOPLUS2)
+/**
+  * @brief	Drive a PWM test signal on three LEDs.
+  *
+  * 		PD12..PD14 are TIM4 CH1..CH3 (AF2). All channels share a 2 kHz
+  * 		period with 25, 50 and 75 % duty cycle.
+  *
+  * @param	None
+  * @retval	None
+  */
+static void Test_Signal_Init(void)
+{
+	static const uint8_t led_pin[3] = { LED_GREEN_PIN, LED_ORANGE_PIN, LED_RED_PIN };
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;			/**< Enable TIM4 clock					*/
+
+	for (uint32_t i = 0; i < 3U; i++)			/**< LED pins: alternate function 2		*/
+	{
+		uint32_t pin = led_pin[i];
+		LED_GPIO_PORT->MODER = (LED_GPIO_PORT->MODER & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+		LED_GPIO_PORT->AFR[pin >> 3] = (LED_GPIO_PORT->AFR[pin >> 3] & ~(0xFUL << ((pin & 7U) * 4)))
+									 | (2UL << ((pin & 7U) * 4));
+	}
+
+	TIM4->PSC   = 0;							/**< 84 MHz tick						*/
+	TIM4->ARR   = TEST_SIGNAL_ARR;
+	TIM4->CCMR1 = (6UL << TIM_CCMR1_OC1M_Pos) | TIM_CCMR1_OC1PE		/**< PWM mode 1, preload	*/
+				| (6UL << TIM_CCMR1_OC2M_Pos) | TIM_CCMR1_OC2PE;
+	TIM4->CCMR2 = (6UL << TIM_CCMR2_OC3M_Pos) | TIM_CCMR2_OC3PE;
+	TIM4->CCR1  = (TEST_SIGNAL_ARR + 1U) * 25U / 100U;
+	TIM4->CCR2  = (TEST_SIGNAL_ARR + 1U) * 50U / 100U;
+	TIM4->CCR3  = (TEST_SIGNAL_ARR + 1U) * 75U / 100U;
+	TIM4->CCER  = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E;
+	TIM4->EGR   = TIM_EGR_UG;					/**< Load prescaler and compare values	*/
+	TIM4->CR1   = TIM_CR1_ARPE | TIM_CR1_CEN;
+}
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/**
+  * @brief	Print one batch result as an `IC,...` line.
+  * @param[in] unit		Capture unit.
+  * @param[in] result	Batch result.
+  * @retval	None
+  */
+static void Report(IC_Unit_t unit, const IC_Result_t *result)
+{
+	ITM_Print("IC,");
+	ITM_Print(ic_name[unit]);
+	ITM_Print(",");
+	ITM_PrintU32(result->periods);
+	ITM_Print(",");
+	ITM_PrintFixed(result->freq_uhz, 1000000UL, 6);			/**< Hz, 1 µHz resolution	*/
+	ITM_Print(",");
+	ITM_PrintU32(result->period_ns);
+	ITM_Print(",");
+	ITM_PrintFixed(result->duty_ppm, 10000UL, 4);			/**< Percent				*/
+	ITM_Print(",");
+	ITM_PrintU32(result->overruns);
+	ITM_Print("\n");
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write an unsigned decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf);
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	ITM_Print(&buf[i]);
+}
+
+/**
+  * @brief	Write `value / scale` as a fixed-point decimal with @p digits fraction digits.
+  */
+static void ITM_PrintFixed(uint64_t value, uint32_t scale, uint32_t digits)
+{
+	uint32_t frac = (uint32_t)(value % scale);
+	char buf[8];
+
+	ITM_PrintU32((uint32_t)(value / scale));
+	ITM_SendChar('.');
+	buf[digits] = '\0';
+	for (uint32_t i = digits; i > 0; i--)
+	{
+		buf[i - 1U] = (char)('0' + frac % 10U);
+		frac /= 10U;
+	}
+	ITM_Print(buf);
+}
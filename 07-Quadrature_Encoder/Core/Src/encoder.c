@@ -0,0 +1,212 @@
+/**
+  * @file	encoder.c
+  * @author	Parham Estiri
+  * @brief	Quadrature encoder interface with 64-bit position and M/T velocity.
+  *
+  * 		This file provides:
+  * 		 - TIM3 encoder mode (x4) with CC1 latching the count on rising A edges
+  * 		 - TIM2 free-running timestamp, captured through TRGO -> ITR2 -> TRC
+  * 		 - Per-tick position extension, index latch and M/T velocity
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "encoder.h"
+
+#define ENC_SHIFT			(32U - ENC_CNT_BITS)
+#define ENC_COUNTS_PER_EDGE	4L				/**< x4 counts per period of A				*/
+#define ENC_GPIO_AF			2UL				/**< TIM3_CH1/CH2/CH3 on PB4/PB5/PB0		*/
+#define ENC_PIN_A			4U
+#define ENC_PIN_B			5U
+#define ENC_PIN_INDEX		0U
+
+static Enc_State_t enc_state;				/**< Result of the last tick					*/
+static int64_t enc_pos;						/**< Position at enc_last_cnt					*/
+static uint32_t enc_last_cnt;				/**< Counter value at the last tick				*/
+static uint32_t enc_edge_time;				/**< Timestamp of the last latched edge			*/
+static int64_t enc_edge_pos;				/**< Position at the last latched edge			*/
+static uint8_t enc_edge_valid;				/**< enc_edge_time/pos can start an M/T window	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static int32_t Enc_Delta(uint32_t now, uint32_t then);
+
+/**
+  * @brief	Configure the pins, encoder counter and timestamp timer, and start them.
+  * @param	None
+  * @retval	None
+  */
+void Enc_Init(void)
+{
+	static const uint8_t pins[] = { ENC_PIN_A, ENC_PIN_B, ENC_PIN_INDEX };
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
+	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN | RCC_APB1ENR_TIM2EN;
+
+	for (uint32_t i = 0; i < sizeof(pins); i++)		/**< AF2, pull-up (open-collector encoders)	*/
+	{
+		uint32_t pin = pins[i];
+		GPIOB->MODER = (GPIOB->MODER & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+		GPIOB->PUPDR = (GPIOB->PUPDR & ~(3UL << (pin * 2))) | (1UL << (pin * 2));
+		GPIOB->AFR[pin >> 3] = (GPIOB->AFR[pin >> 3] & ~(0xFUL << ((pin & 7U) * 4)))
+							 | (ENC_GPIO_AF << ((pin & 7U) * 4));
+	}
+
+	/* Encoder counter: both inputs counted, CC1 latches CNT on rising A, CC3 on index */
+	ENC_TIM->CR1   = 0;
+	ENC_TIM->PSC   = 0;
+	ENC_TIM->ARR   = 0xFFFFFFFFUL >> ENC_SHIFT;
+	ENC_TIM->CCMR1 = (1UL << TIM_CCMR1_CC1S_Pos) | (ENC_FILTER << TIM_CCMR1_IC1F_Pos)	/**< IC1 = TI1	*/
+				   | (1UL << TIM_CCMR1_CC2S_Pos) | (ENC_FILTER << TIM_CCMR1_IC2F_Pos);	/**< IC2 = TI2	*/
+	ENC_TIM->CCMR2 = (1UL << TIM_CCMR2_CC3S_Pos) | (ENC_FILTER << TIM_CCMR2_IC3F_Pos);	/**< IC3 = TI3	*/
+	ENC_TIM->CCER  = TIM_CCER_CC1E | TIM_CCER_CC3E;		/**< Non-inverted, capture on rising edges	*/
+	ENC_TIM->SMCR  = 3UL << TIM_SMCR_SMS_Pos;			/**< Encoder mode 3: count on TI1 and TI2	*/
+	ENC_TIM->CR2   = 3UL << TIM_CR2_MMS_Pos;			/**< TRGO: pulse on every CC1 capture		*/
+	ENC_TIM->CNT   = 0;
+	ENC_TIM->EGR   = TIM_EGR_UG;
+	ENC_TIM->SR    = 0;
+
+	/* Timestamp timer: free-running, CC1 captures CNT on the encoder's TRGO */
+	ENC_TS_TIM->CR1   = 0;
+	ENC_TS_TIM->PSC   = 0;
+	ENC_TS_TIM->ARR   = 0xFFFFFFFFUL;
+	ENC_TS_TIM->SMCR  = ENC_TS_ITR << TIM_SMCR_TS_Pos;		/**< TRGI = ITR2, slave mode disabled	*/
+	ENC_TS_TIM->CCMR1 = 3UL << TIM_CCMR1_CC1S_Pos;			/**< IC1 = TRC								*/
+	ENC_TS_TIM->CCER  = TIM_CCER_CC1E;
+	ENC_TS_TIM->CNT   = 0;
+	ENC_TS_TIM->EGR   = TIM_EGR_UG;
+	ENC_TS_TIM->SR    = 0;
+
+	enc_pos        = 0;
+	enc_last_cnt   = 0;
+	enc_edge_time  = 0;
+	enc_edge_valid = 0;
+	enc_state      = (Enc_State_t){ 0 };
+
+	ENC_TS_TIM->CR1 = TIM_CR1_CEN;
+	ENC_TIM->CR1    = TIM_CR1_CEN;
+}
+
+/**
+  * @brief	Estimator tick: extend the position, latch the index, update velocity.
+  * @note	Call at ENC_TICK_HZ from one context only (for example SysTick_Callback()).
+  * @param	None
+  * @retval	None
+  */
+void Enc_Tick(void)
+{
+	uint32_t idx_cnt = 0, edge_cnt, edge_time, check_cnt, check_time;
+	uint8_t idx_hit = 0;
+
+	/* Latched values first, live counter last: every latch is at or before `cnt` */
+	if (ENC_TIM->SR & TIM_SR_CC3IF)
+	{
+		idx_cnt = ENC_TIM->CCR3;					/**< Reading CCR3 clears CC3IF				*/
+		ENC_TIM->SR = ~TIM_SR_CC3OF;				/**< Several index pulses: keep the last	*/
+		idx_hit = 1;
+	}
+	do {											/**< Coherent (count, time) pair			*/
+		edge_cnt   = ENC_TIM->CCR1;
+		edge_time  = ENC_TS_TIM->CCR1;
+		check_cnt  = ENC_TIM->CCR1;
+		check_time = ENC_TS_TIM->CCR1;
+	} while (edge_cnt != check_cnt || edge_time != check_time);
+	const uint32_t now = ENC_TS_TIM->CNT;
+	const uint32_t cnt = ENC_TIM->CNT;
+
+	/* Position: signed delta of the N-bit counter, accumulated in 64 bits */
+	enc_pos += Enc_Delta(cnt, enc_last_cnt);
+	enc_last_cnt = cnt;
+	enc_state.position = enc_pos;
+
+	if (idx_hit)
+	{
+		enc_state.index_position = enc_pos - Enc_Delta(cnt, idx_cnt);
+		enc_state.index_count++;
+	}
+
+	/* Velocity (M/T): counts between the last two latched edges over their exact time */
+	if (edge_time != enc_edge_time)
+	{
+		int64_t edge_pos = enc_pos - Enc_Delta(cnt, edge_cnt);
+
+		if (enc_edge_valid)
+		{
+			enc_state.velocity_mcps = ((edge_pos - enc_edge_pos) * (int64_t)ENC_TS_CLK_HZ * 1000)
+									/ (int64_t)(edge_time - enc_edge_time);
+		}
+		enc_edge_time  = edge_time;
+		enc_edge_pos   = edge_pos;
+		enc_edge_valid = 1;
+	}
+	else if (enc_edge_valid)						/**< No edge this tick: bound by the age	*/
+	{
+		uint32_t age = now - enc_edge_time;
+
+		if (age >= (uint32_t)((uint64_t)ENC_TS_CLK_HZ * ENC_STALL_MS / 1000U))
+		{
+			enc_state.velocity_mcps = 0;			/**< Stopped: next edge starts a new window	*/
+			enc_edge_valid = 0;
+		}
+		else
+		{
+			int64_t bound = (ENC_COUNTS_PER_EDGE * (int64_t)ENC_TS_CLK_HZ * 1000) / (int64_t)age;
+			if (enc_state.velocity_mcps > bound)
+				enc_state.velocity_mcps = bound;
+			else if (enc_state.velocity_mcps < -bound)
+				enc_state.velocity_mcps = -bound;
+		}
+	}
+	enc_state.edge_age_us = (uint32_t)(((uint64_t)(now - enc_edge_time) * 1000000U) / ENC_TS_CLK_HZ);
+}
+
+/**
+  * @brief	Live 64-bit position (includes counts since the last tick).
+  * @param	None
+  * @retval	Position in counts.
+  */
+int64_t Enc_GetPosition(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	int64_t position = enc_pos + Enc_Delta(ENC_TIM->CNT, enc_last_cnt);
+	__set_PRIMASK(primask);
+	return position;
+}
+
+/**
+  * @brief	Copy the state computed by the last tick.
+  * @param[out] state	Snapshot.
+  * @retval	None
+  */
+void Enc_GetState(Enc_State_t *state)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	*state = enc_state;
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief	Redefine the current position (for example 0 at a home switch or index).
+  * @param[in] position	New position in counts.
+  * @retval	None
+  */
+void Enc_SetPosition(int64_t position)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	int64_t shift = position - (enc_pos + Enc_Delta(ENC_TIM->CNT, enc_last_cnt));
+	enc_pos                  += shift;
+	enc_edge_pos             += shift;
+	enc_state.position       += shift;
+	enc_state.index_position += shift;
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief	Signed difference of two ENC_CNT_BITS-wide counter values.
+  */
+static int32_t Enc_Delta(uint32_t now, uint32_t then)
+{
+	return (int32_t)((now - then) << ENC_SHIFT) >> ENC_SHIFT;
+}
@@ -0,0 +1,220 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	Quadrature encoder position and velocity.
+  *
+  * 		This file initializes the system, board support package (BSP), the
+  * 		encoder interface and SysTick (estimator tick), drives a quadrature
+  * 		test signal on two LEDs (TIM4 toggle outputs) and prints the encoder
+  * 		state every 100 ms over ITM stimulus port 0 (SWO on PB3):
+  *
+  * 		`ENC,<position>,<counts/s>,<rpm>,<index count>,<index position>,<edge age us>`
+  *
+  * 		Jumper PD12 -> PB4 (A) and PD13 -> PB5 (B) to decode the test signal.
+  * 		The user button reverses its direction.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "systick.h"
+#include "encoder.h"
+
+#define TEST_SIGNAL_HALF		4200U		/**< 84 MHz / (2 x 4200) = 10 kHz per phase	*/
+#define REPORT_PERIOD_MS		100U		/**< One report line every 100 ms			*/
+
+/**************************  Static Function Prototypes  ***************************/
+#if !defined(QEMU_NETDUINOPLUS2)
+static void Test_Signal_Init(void);
+#endif /* QEMU_NETDUINOPLUS2 */
+static void Report(const Enc_State_t *state);
+static void ITM_Print(const char *str);
+static void ITM_PrintU64(uint64_t value);
+static void ITM_PrintS64(int64_t value);
+static void ITM_PrintFixed(int64_t value, uint32_t scale, uint32_t digits);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs, button in EXTI mode).
+  * 		3. Initializes the encoder interface (TIM3 encoder mode, TIM2 timestamps).
+  * 		4. Starts SysTick at ENC_TICK_HZ; every tick runs Enc_Tick().
+  * 		5. Starts a 10 kHz quadrature test signal on PD12/PD13.
+  * 		6. Enters an infinite loop that prints the encoder state.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	Enc_State_t state;
+	uint32_t last_report = 0;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	BSP_Button_Init(BUTTON_MODE_EXTI);	/**< Button reverses the test signal		*/
+	Enc_Init();							/**< Encoder counter and edge timestamps	*/
+	SysTick_Init(ENC_TICK_HZ, SYSTICK_CMSIS);	/**< Estimator tick					*/
+#if !defined(QEMU_NETDUINOPLUS2)
+	Test_Signal_Init();					/**< TIM4 debounces the button under QEMU	*/
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	/**< Main loop */
+	while (1)
+	{
+		if ((SysTick_GetTick() - last_report) * (1000U / ENC_TICK_HZ) >= REPORT_PERIOD_MS)
+		{
+			last_report = SysTick_GetTick();
+			Enc_GetState(&state);
+			Report(&state);
+		}
+		__WFI();						/**< Sleep until the next tick				*/
+	}
+}
+
+/**
+  * @brief	SysTick callback: run the encoder estimator.
+  */
+void SysTick_Callback(void)
+{
+	Enc_Tick();
+}
+
+/**
+  * @brief	Button callback: reverse the test signal (swap the A/B phase offsets).
+  */
+void BSP_Button_Callback(void)
+{
+#if !defined(QEMU_NETDUINOPLUS2)
+	uint32_t ccr1 = TIM4->CCR1;
+	TIM4->CCR1 = TIM4->CCR2;
+	TIM4->CCR2 = ccr1;
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+#if !defined(QEMU_NETDUINOPLUS2)
+/**
+  * @brief	Drive a quadrature test signal on the green and orange LEDs.
+  *
+  * 		PD12/PD13 are TIM4 CH1/CH2 (AF2) in toggle mode. Both toggle once
+  * 		per counter period, CH2 half a period after CH1, which gives two
+  * 		10 kHz square waves 90° apart (40 000 counts/s after x4 decoding).
+  *
+  * @param	None
+  * @retval	None
+  */
+static void Test_Signal_Init(void)
+{
+	static const uint8_t led_pin[2] = { LED_GREEN_PIN, LED_ORANGE_PIN };
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;			/**< Enable TIM4 clock					*/
+
+	for (uint32_t i = 0; i < 2U; i++)			/**< LED pins: alternate function 2		*/
+	{
+		uint32_t pin = led_pin[i];
+		LED_GPIO_PORT->MODER = (LED_GPIO_PORT->MODER & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+		LED_GPIO_PORT->AFR[pin >> 3] = (LED_GPIO_PORT->AFR[pin >> 3] & ~(0xFUL << ((pin & 7U) * 4)))
+									 | (2UL << ((pin & 7U) * 4));
+	}
+
+	TIM4->PSC   = 0;							/**< 84 MHz tick						*/
+	TIM4->ARR   = TEST_SIGNAL_HALF - 1U;
+	TIM4->CCMR1 = (3UL << TIM_CCMR1_OC1M_Pos)	/**< Toggle on match					*/
+				| (3UL << TIM_CCMR1_OC2M_Pos);
+	TIM4->CCR1  = 0;							/**< A leads B: counting up				*/
+	TIM4->CCR2  = TEST_SIGNAL_HALF / 2U;
+	TIM4->CCER  = TIM_CCER_CC1E | TIM_CCER_CC2E;
+	TIM4->EGR   = TIM_EGR_UG;
+	TIM4->CR1   = TIM_CR1_CEN;
+}
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/**
+  * @brief	Print the encoder state as an `ENC,...` line.
+  * @param[in] state	Encoder state.
+  * @retval	None
+  */
+static void Report(const Enc_State_t *state)
+{
+	ITM_Print("ENC,");
+	ITM_PrintS64(state->position);
+	ITM_Print(",");
+	ITM_PrintFixed(state->velocity_mcps, 1000U, 3);					/**< counts/s	*/
+	ITM_Print(",");
+	ITM_PrintFixed(state->velocity_mcps * 60 / ENC_CPR, 1000U, 3);	/**< rpm		*/
+	ITM_Print(",");
+	ITM_PrintU64(state->index_count);
+	ITM_Print(",");
+	ITM_PrintS64(state->index_position);
+	ITM_Print(",");
+	ITM_PrintU64(state->edge_age_us);
+	ITM_Print("\n");
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write an unsigned decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintU64(uint64_t value)
+{
+	char buf[21];
+	uint32_t i = sizeof(buf);
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	ITM_Print(&buf[i]);
+}
+
+/**
+  * @brief	Write a signed decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintS64(int64_t value)
+{
+	if (value < 0)
+	{
+		ITM_SendChar('-');
+		ITM_PrintU64(0U - (uint64_t)value);
+	}
+	else
+	{
+		ITM_PrintU64((uint64_t)value);
+	}
+}
+
+/**
+  * @brief	Write `value / scale` as a signed fixed-point decimal with @p digits fraction digits.
+  */
+static void ITM_PrintFixed(int64_t value, uint32_t scale, uint32_t digits)
+{
+	uint64_t magnitude = (value < 0) ? 0U - (uint64_t)value : (uint64_t)value;
+	uint32_t frac = (uint32_t)(magnitude % scale);
+	char buf[8];
+
+	if (value < 0)
+		ITM_SendChar('-');
+	ITM_PrintU64(magnitude / scale);
+	ITM_SendChar('.');
+	buf[digits] = '\0';
+	for (uint32_t i = digits; i > 0; i--)
+	{
+		buf[i - 1U] = (char)('0' + frac % 10U);
+		frac /= 10U;
+	}
+	ITM_Print(buf);
+}
@@ -0,0 +1,103 @@
+/**
+  * @file	ws2812.h
+  * @author	Parham Estiri
+  * @brief	WS2812 (NeoPixel) addressable LED strip driver using TIM PWM + DMA.
+  *
+  * 		This module provides:
+  * 		 - A GRB pixel frame (3 bytes per LED) set through WS_SetPixel()
+  * 		 - 800 kHz PWM on TIM3 CH1 (PC6), one timer period per bit; the DMA
+  * 		   writes the next duty cycle into CCR1 on every update event
+  * 		 - A small double-buffered duty ring (two chunks of WS_CHUNK_LEDS LEDs):
+  * 		   the half-transfer and transfer-complete interrupts encode the next
+  * 		   chunk while the other one is being sent
+  * 		 - Combined brightness and gamma look-up table applied while encoding
+  *
+  * 		RAM: 3 bytes per LED plus 2 x 24 x WS_CHUNK_LEDS half-words, instead
+  * 		of 48 bytes per LED for a fully encoded frame.
+  *
+  * @note	WS2812 inputs expect 0.7 x VDD. Use a level shifter, or set
+  * 		WS_OPEN_DRAIN and pull PC6 (5 V tolerant) up to 5 V.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef WS2812_H_
+#define WS2812_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "stm32f407xx.h"
+
+/******************************  Configuration  ******************************/
+#define WS_LED_COUNT			1024U	/**< LEDs on the strip (30.7 ms per frame)			*/
+#define WS_CHUNK_LEDS			16U		/**< LEDs encoded per half-transfer interrupt		*/
+#define WS_RESET_US				300U	/**< Latch: line low after the last bit (WS2812B)	*/
+#define WS_OPEN_DRAIN			0U		/**< 1: open-drain output with external pull-up		*/
+#define WS_DMA_PRIORITY			0x01U	/**< Refill deadline is one chunk (480 µs)			*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Driver status codes.
+  */
+typedef enum {
+	WS_OK		= 0,	/**< Success								*/
+	WS_EINVAL	= 1,	/**< Pixel index out of range				*/
+	WS_EBUSY	= 2		/**< A frame is being sent					*/
+} WS_Status_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure PC6, TIM3 and DMA1 Stream2, and clear the frame.
+  * @param	None
+  * @retval	None
+  */
+void WS_Init(void);
+
+/**
+  * @brief	Set one pixel in the frame (not sent until WS_Show()).
+  * @param[in] index	LED index, 0 is the first LED on the strip.
+  * @param[in] r,g,b	Colour, 0..255 before brightness and gamma.
+  * @retval	WS_OK or WS_EINVAL.
+  */
+WS_Status_t WS_SetPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+  * @brief	Set every pixel to one colour.
+  * @param[in] r,g,b	Colour.
+  * @retval	None
+  */
+void WS_Fill(uint8_t r, uint8_t g, uint8_t b);
+
+/**
+  * @brief	Set the global brightness (rebuilds the brightness/gamma table).
+  * @param[in] brightness	0 (off) .. 255 (full).
+  * @retval	None
+  * @note	Takes effect for the next frame sent.
+  */
+void WS_SetBrightness(uint8_t brightness);
+
+/**
+  * @brief	Start sending the frame.
+  * @param	None
+  * @retval	WS_OK, or WS_EBUSY while the previous frame and its latch are still being sent.
+  * @note	The frame is read while it is sent: wait for WS_IsBusy() == 0
+  * 		before changing pixels to avoid tearing.
+  */
+WS_Status_t WS_Show(void);
+
+/**
+  * @brief	Whether a frame is being sent.
+  * @param	None
+  * @retval	1 while busy, 0 when idle.
+  */
+uint8_t WS_IsBusy(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* WS2812_H_ */
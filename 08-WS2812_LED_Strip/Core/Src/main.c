@@ -0,0 +1,100 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	WS2812 addressable LED strip demo.
+  *
+  * 		This file initializes the system, board support package (BSP) and
+  * 		the WS2812 driver, then sends a moving rainbow to the strip as fast
+  * 		as the strip accepts frames (about 32 fps for 1024 LEDs). The green
+  * 		LED toggles every 32 frames, the user button steps the brightness.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "ws2812.h"
+
+#define BRIGHTNESS_STEP		64U		/**< Button: 64, 128, 192, 255, then 0	*/
+
+static volatile uint8_t brightness_request;		/**< Set by the button callback		*/
+
+/**************************  Static Function Prototypes  ***************************/
+static void Render_Rainbow(uint32_t frame);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs, button in EXTI mode).
+  * 		3. Initializes the strip driver (TIM3 CH1 on PC6 + DMA1 Stream2).
+  * 		4. Enters an infinite loop: wait for the previous frame, render the
+  * 		   next one and start sending it. The CPU only encodes one chunk of
+  * 		   16 LEDs per DMA interrupt while a frame is being sent.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	uint32_t frame = 0;
+	uint32_t brightness = BRIGHTNESS_STEP;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	BSP_Button_Init(BUTTON_MODE_EXTI);	/**< Button steps the brightness			*/
+	WS_Init();							/**< Strip driver							*/
+	WS_SetBrightness((uint8_t)brightness);
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	/**< Main loop */
+	while (1)
+	{
+		while (WS_IsBusy())
+			__WFI();					/**< Sleep between chunk interrupts			*/
+
+		if (brightness_request)
+		{
+			brightness_request = 0;
+			brightness = (brightness >= 255U) ? 0U : brightness + BRIGHTNESS_STEP;
+			WS_SetBrightness((uint8_t)((brightness > 255U) ? 255U : brightness));
+		}
+
+		Render_Rainbow(frame);
+		WS_Show();
+
+		if ((++frame & 31U) == 0)
+			BSP_LED_Toggle(LED_GREEN);	/**< About 1 Hz at 32 fps					*/
+	}
+}
+
+/**
+  * @brief	Button callback: step the brightness.
+  */
+void BSP_Button_Callback(void)
+{
+	brightness_request = 1;
+}
+
+/**
+  * @brief	Fill the frame with a rainbow that moves by one hue step per frame.
+  * @param[in] frame	Frame counter.
+  * @retval	None
+  */
+static void Render_Rainbow(uint32_t frame)
+{
+	for (uint32_t i = 0; i < WS_LED_COUNT; i++)
+	{
+		uint8_t hue = (uint8_t)(i * 4U + frame * 2U);	/**< 64 LEDs per colour cycle	*/
+		uint8_t step = (uint8_t)((hue % 85U) * 3U);
+
+		if (hue < 85U)
+			WS_SetPixel(i, (uint8_t)(255U - step), step, 0);
+		else if (hue < 170U)
+			WS_SetPixel(i, 0, (uint8_t)(255U - step), step);
+		else
+			WS_SetPixel(i, step, 0, (uint8_t)(255U - step));
+	}
+}
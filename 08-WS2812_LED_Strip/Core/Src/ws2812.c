@@ -0,0 +1,270 @@
+/**
+  * @file	ws2812.c
+  * @author	Parham Estiri
+  * @brief	WS2812 (NeoPixel) addressable LED strip driver using TIM PWM + DMA.
+  *
+  * 		This file provides:
+  * 		 - TIM3 CH1 PWM at 800 kHz, CCR1 reloaded by DMA1 Stream2 (TIM3_UP)
+  * 		 - Chunked encoding from the half-transfer/transfer-complete interrupt
+  * 		 - Nibble look-up encoding (two 64-bit stores per colour byte)
+  * 		 - Brightness and gamma 2.8 table
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "ws2812.h"
+
+#define WS_BIT_HZ			800000UL		/**< WS2812 data rate						*/
+#define WS_TIM				TIM3
+#define WS_TIM_CLK_HZ		(SystemCoreClock / 2U)	/**< APB1 /4, timer clock x2 (84 MHz)	*/
+#define WS_PIN				6U				/**< PC6 = TIM3_CH1 (AF2)					*/
+#define WS_GPIO_AF			2UL
+#define WS_DMA_STREAM		DMA1_Stream2	/**< TIM3_UP request: stream 2, channel 5	*/
+#define WS_DMA_CHANNEL		5UL
+#define WS_DMA_IRQn			DMA1_Stream2_IRQn
+#define WS_DMA_FLAG_POS		16U				/**< Stream 2 flags in LISR/LIFCR			*/
+
+#define WS_SLOTS_PER_LED	24U				/**< One PWM period per bit, GRB			*/
+#define WS_WORDS_PER_LED	(WS_SLOTS_PER_LED / 4U)		/**< 4 half-word slots per uint64_t	*/
+#define WS_HALF_WORDS		(WS_CHUNK_LEDS * WS_WORDS_PER_LED)
+#define WS_CHUNK_US			(WS_CHUNK_LEDS * 30U)		/**< 24 bits x 1.25 µs per LED		*/
+#define WS_DATA_HALVES		((WS_LED_COUNT + WS_CHUNK_LEDS - 1U) / WS_CHUNK_LEDS)
+#define WS_RESET_HALVES		((WS_RESET_US + WS_CHUNK_US - 1U) / WS_CHUNK_US + 1U)
+#define WS_TOTAL_HALVES		(WS_DATA_HALVES + WS_RESET_HALVES)
+
+/** @brief	Gamma 2.8 correction: perceived brightness to PWM level. */
+static const uint8_t ws_gamma[256] = {
+		  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+		  2,   3,   3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,
+		  5,   6,   6,   6,   6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,
+		 10,  10,  11,  11,  11,  12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,
+		 17,  17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,  25,
+		 25,  26,  27,  27,  28,  29,  29,  30,  31,  32,  32,  33,  34,  35,  35,  36,
+		 37,  38,  39,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
+		 51,  52,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  66,  67,  68,
+		 69,  70,  72,  73,  74,  75,  77,  78,  79,  81,  82,  83,  85,  86,  87,  89,
+		 90,  92,  93,  95,  96,  98,  99, 101, 102, 104, 105, 107, 109, 110, 112, 114,
+		115, 117, 119, 120, 122, 124, 126, 127, 129, 131, 133, 135, 137, 138, 140, 142,
+		144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164, 167, 169, 171, 173, 175,
+		177, 180, 182, 184, 186, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213,
+		215, 218, 220, 223, 225, 228, 231, 233, 236, 239, 241, 244, 247, 249, 252, 255
+};
+
+static uint8_t ws_pixels[WS_LED_COUNT * 3U];		/**< Frame, GRB order as sent			*/
+static uint64_t ws_dma[2U * WS_HALF_WORDS];			/**< Duty ring: two chunks				*/
+static uint64_t ws_nibble[16];						/**< 4 bits -> 4 duty half-words		*/
+static uint8_t ws_lut[256];							/**< Brightness then gamma				*/
+static uint8_t ws_brightness = 255U;
+static volatile uint8_t ws_lut_dirty = 1;
+static volatile uint8_t ws_busy;
+static uint32_t ws_done;							/**< Chunks fully sent in this frame	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static void WS_Encode(uint32_t chunk);
+static void WS_Stop(void);
+
+/**
+  * @brief	Configure PC6, TIM3 and DMA1 Stream2, and clear the frame.
+  * @param	None
+  * @retval	None
+  */
+void WS_Init(void)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+	const uint32_t period = WS_TIM_CLK_HZ / WS_BIT_HZ;		/**< 105 ticks = 1.25 µs			*/
+	const uint16_t t0h = (uint16_t)(period * 32U / 100U);	/**< 0.40 µs high: bit 0			*/
+	const uint16_t t1h = (uint16_t)(period * 64U / 100U);	/**< 0.80 µs high: bit 1			*/
+
+	for (uint32_t n = 0; n < 16U; n++)					/**< MSB first, lowest address first	*/
+	{
+		uint64_t w = 0;
+		for (uint32_t k = 0; k < 4U; k++)
+			w |= (uint64_t)((n & (8U >> k)) ? t1h : t0h) << (16U * k);
+		ws_nibble[n] = w;
+	}
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOCEN | RCC_AHB1ENR_DMA1EN;
+	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+
+	GPIOC->MODER   = (GPIOC->MODER & ~(3UL << (WS_PIN * 2))) | (2UL << (WS_PIN * 2));	/**< AF		*/
+	GPIOC->OSPEEDR = (GPIOC->OSPEEDR & ~(3UL << (WS_PIN * 2))) | (2UL << (WS_PIN * 2));	/**< Fast	*/
+	GPIOC->OTYPER  = (GPIOC->OTYPER & ~(1UL << WS_PIN)) | (WS_OPEN_DRAIN << WS_PIN);
+	GPIOC->AFR[WS_PIN >> 3] = (GPIOC->AFR[WS_PIN >> 3] & ~(0xFUL << ((WS_PIN & 7U) * 4)))
+							| (WS_GPIO_AF << ((WS_PIN & 7U) * 4));
+
+	WS_TIM->CR1   = TIM_CR1_ARPE;
+	WS_TIM->PSC   = 0;
+	WS_TIM->ARR   = period - 1U;
+	WS_TIM->CCMR1 = (6UL << TIM_CCMR1_OC1M_Pos) | TIM_CCMR1_OC1PE;	/**< PWM mode 1, CCR1 preloaded	*/
+	WS_TIM->CCR1  = 0;									/**< Idle low (reset/latch level)		*/
+	WS_TIM->CCER  = TIM_CCER_CC1E;
+	WS_TIM->EGR   = TIM_EGR_UG;
+
+	NVIC_SetPriority(WS_DMA_IRQn, NVIC_EncodePriority(PG, WS_DMA_PRIORITY, 0));
+	NVIC_EnableIRQ(WS_DMA_IRQn);
+
+	WS_Fill(0, 0, 0);
+}
+
+/**
+  * @brief	Set one pixel in the frame (not sent until WS_Show()).
+  * @param[in] index	LED index, 0 is the first LED on the strip.
+  * @param[in] r,g,b	Colour, 0..255 before brightness and gamma.
+  * @retval	WS_OK or WS_EINVAL.
+  */
+WS_Status_t WS_SetPixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
+{
+	if (index >= WS_LED_COUNT)
+		return WS_EINVAL;
+
+	uint8_t *p = &ws_pixels[index * 3U];
+	p[0] = g;
+	p[1] = r;
+	p[2] = b;
+	return WS_OK;
+}
+
+/**
+  * @brief	Set every pixel to one colour.
+  * @param[in] r,g,b	Colour.
+  * @retval	None
+  */
+void WS_Fill(uint8_t r, uint8_t g, uint8_t b)
+{
+	for (uint32_t i = 0; i < WS_LED_COUNT; i++)
+		WS_SetPixel(i, r, g, b);
+}
+
+/**
+  * @brief	Set the global brightness (rebuilds the brightness/gamma table).
+  * @param[in] brightness	0 (off) .. 255 (full).
+  * @retval	None
+  * @note	Takes effect for the next frame sent.
+  */
+void WS_SetBrightness(uint8_t brightness)
+{
+	ws_brightness = brightness;
+	ws_lut_dirty = 1;
+}
+
+/**
+  * @brief	Start sending the frame.
+  * @param	None
+  * @retval	WS_OK, or WS_EBUSY while the previous frame and its latch are still being sent.
+  */
+WS_Status_t WS_Show(void)
+{
+	if (ws_busy)
+		return WS_EBUSY;
+
+	if (ws_lut_dirty)									/**< Scale first, so dimming is perceptual	*/
+	{
+		ws_lut_dirty = 0;
+		for (uint32_t v = 0; v < 256U; v++)
+			ws_lut[v] = ws_gamma[(v * ws_brightness + 127U) / 255U];
+	}
+
+	ws_done = 0;
+	WS_Encode(0);
+	WS_Encode(1);
+	ws_busy = 1;
+
+	DMA1->LIFCR = 0x3DUL << WS_DMA_FLAG_POS;			/**< Clear TC, HT, TE, DME, FE				*/
+	WS_DMA_STREAM->PAR  = (uint32_t)&WS_TIM->CCR1;
+	WS_DMA_STREAM->M0AR = (uint32_t)ws_dma;
+	WS_DMA_STREAM->NDTR = 2U * WS_CHUNK_LEDS * WS_SLOTS_PER_LED;
+	WS_DMA_STREAM->FCR  = 0;							/**< Direct mode							*/
+	WS_DMA_STREAM->CR   = (WS_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+						| DMA_SxCR_PL_1					/**< High priority							*/
+						| DMA_SxCR_MSIZE_0				/**< Memory: 16-bit							*/
+						| DMA_SxCR_PSIZE_0				/**< Peripheral: 16-bit						*/
+						| DMA_SxCR_MINC
+						| DMA_SxCR_CIRC
+						| DMA_SxCR_DIR_0				/**< Memory to peripheral					*/
+						| DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	WS_DMA_STREAM->CR  |= DMA_SxCR_EN;
+
+	WS_TIM->CNT  = 0;
+	WS_TIM->DIER = TIM_DIER_UDE;						/**< One CCR1 reload per bit				*/
+	WS_TIM->CR1 |= TIM_CR1_CEN;
+	return WS_OK;
+}
+
+/**
+  * @brief	Whether a frame is being sent.
+  * @param	None
+  * @retval	1 while busy, 0 when idle.
+  */
+uint8_t WS_IsBusy(void)
+{
+	return ws_busy;
+}
+
+/**
+  * @brief	Encode one chunk of the frame into its half of the duty ring.
+  * @param[in] chunk	Chunk index in the frame; past the last LED it encodes the latch (all 0).
+  */
+static void WS_Encode(uint32_t chunk)
+{
+	uint64_t *dst = &ws_dma[(chunk & 1U) * WS_HALF_WORDS];
+	uint32_t led = chunk * WS_CHUNK_LEDS;
+
+	for (uint32_t i = 0; i < WS_CHUNK_LEDS; i++, led++)
+	{
+		if (led < WS_LED_COUNT)
+		{
+			const uint8_t *p = &ws_pixels[led * 3U];
+			for (uint32_t c = 0; c < 3U; c++)
+			{
+				uint8_t v = ws_lut[p[c]];
+				*dst++ = ws_nibble[v >> 4];
+				*dst++ = ws_nibble[v & 0xFU];
+			}
+		}
+		else
+		{
+			for (uint32_t w = 0; w < WS_WORDS_PER_LED; w++)
+				*dst++ = 0;							/**< CCR1 = 0: line stays low				*/
+		}
+	}
+}
+
+/**
+  * @brief	Stop the timer and the stream, leave the line low.
+  */
+static void WS_Stop(void)
+{
+	WS_TIM->CR1 &= ~TIM_CR1_CEN;
+	WS_TIM->DIER = 0;
+	WS_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+	WS_TIM->CCR1 = 0;
+	WS_TIM->EGR  = TIM_EGR_UG;						/**< Load CCR1 = 0 now						*/
+	ws_busy = 0;
+}
+
+/**
+  * @brief	DMA1 Stream2 interrupt: refill the half that was just sent.
+  */
+void DMA1_Stream2_IRQHandler(void)
+{
+	uint32_t flags = (DMA1->LISR >> WS_DMA_FLAG_POS) & 0x3DUL;
+	DMA1->LIFCR = flags << WS_DMA_FLAG_POS;
+
+	if (flags & DMA_LISR_TEIF0)
+	{
+		WS_Stop();
+		return;
+	}
+
+	for (uint32_t event = flags & (DMA_LISR_HTIF0 | DMA_LISR_TCIF0); event; event &= event - 1U)
+	{
+		if (++ws_done >= WS_TOTAL_HALVES)			/**< Data and latch sent					*/
+		{
+			WS_Stop();
+			return;
+		}
+		WS_Encode(ws_done + 1U);					/**< Chunk after the one now being sent		*/
+	}
+}
@@ -0,0 +1,166 @@
+/**
+  * @file	motor_pwm.h
+  * @author	Parham Estiri
+  * @brief	Three-phase complementary PWM on TIM1 with synchronous ADC sampling.
+  *
+  * 		This module provides:
+  * 		 - Center-aligned complementary PWM on TIM1 CH1..CH3 / CH1N..CH3N
+  * 		   with programmable dead-time (BDTR.DTG computed from nanoseconds)
+  * 		 - Break input (BKIN, PE15, active low) that disables the outputs
+  * 		   in hardware; re-armed by software with MC_ClearFault()
+  * 		 - ADC1 injected conversions triggered at the PWM center (counter
+  * 		   peak, low-side switches on) through TIM1 TRGO = OC4REF
+  * 		 - A control-loop callback run from the ADC JEOC interrupt; the
+  * 		   interrupt handler executes from SRAM (.RamFunc)
+  * 		 - Trigger-to-CCR-write latency measured in TIM1 ticks on every cycle
+  *
+  * 		| Signal | Pin  | Signal | Pin  | ADC (injected)          |
+  * 		|--------|------|--------|------|-------------------------|
+  * 		| CH1    | PE9  | CH1N   | PE8  | JDR1: PA1 (IN1), I_a    |
+  * 		| CH2    | PE11 | CH2N   | PE10 | JDR2: PB0 (IN8), I_b    |
+  * 		| CH3    | PE13 | CH3N   | PE12 | JDR3: PB1 (IN9), V_bus  |
+  * 		| BKIN   | PE15 |        |      |                         |
+  *
+  * @note	TIM8 has the same register layout; moving the module to TIM8 needs
+  * 		its pins (CH1..3 on PC6..PC8, BKIN on PA6) and JEXTSEL changed.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef MOTOR_PWM_H_
+#define MOTOR_PWM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define MC_TIM_CLK_HZ			SystemCoreClock	/**< APB2 /2, timer clock x2 (168 MHz)		*/
+#define MC_PWM_HZ_MIN			2000UL			/**< Lowest PWM frequency (ARR <= 65535)	*/
+#define MC_PWM_HZ_MAX			100000UL		/**< Highest PWM frequency					*/
+#define MC_DEADTIME_NS_MAX		6000UL			/**< Largest dead-time BDTR can encode		*/
+#define MC_TRIGGER_ADVANCE		144U			/**< Trigger ticks before the peak, so the
+													 three sample windows straddle it		*/
+#define MC_ADC_PRIORITY			0x00U			/**< Control loop: highest priority			*/
+#define MC_BRK_PRIORITY			0x00U			/**< Fault report							*/
+
+#define MC_RAMFUNC				__attribute__((section(".RamFunc")))	/**< Run from SRAM		*/
+#define MC_DUTY_ONE				65536UL			/**< Duty scale: 65536 = 100 %				*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Driver status codes.
+  */
+typedef enum {
+	MC_OK		= 0,	/**< Success								*/
+	MC_EINVAL	= 1,	/**< Parameter out of range					*/
+	MC_EFAULT	= 2		/**< Break input still active				*/
+} MC_Status_t;
+
+/**
+  * @brief	PWM configuration.
+  */
+typedef struct {
+	uint32_t	pwm_hz;			/**< PWM frequency (center-aligned)			*/
+	uint32_t	deadtime_ns;	/**< Dead-time inserted on every edge		*/
+} MC_Config_t;
+
+/**
+  * @brief	One synchronous ADC sample set (raw 12-bit).
+  */
+typedef struct {
+	uint16_t	i_a;			/**< Phase A current shunt					*/
+	uint16_t	i_b;			/**< Phase B current shunt					*/
+	uint16_t	v_bus;			/**< DC bus voltage divider					*/
+} MC_Sample_t;
+
+/**
+  * @brief	Phase duty cycles, 0..MC_DUTY_ONE (high-side on-time fraction).
+  */
+typedef struct {
+	uint32_t	a;
+	uint32_t	b;
+	uint32_t	c;
+} MC_Duty_t;
+
+/**
+  * @brief	Control-loop callback: compute the next duties from a sample set.
+  * @note	Runs in the ADC interrupt at the PWM rate. Mark it MC_RAMFUNC.
+  */
+typedef void (*MC_Callback_t)(const MC_Sample_t *sample, MC_Duty_t *duty);
+
+/**
+  * @brief	Control-loop statistics.
+  */
+typedef struct {
+	uint32_t	cycles;			/**< Control-loop interrupts				*/
+	uint32_t	latency_last;	/**< Trigger to CCR write, TIM1 ticks		*/
+	uint32_t	latency_min;
+	uint32_t	latency_max;
+	uint32_t	isr_cycles_max;	/**< Longest interrupt, CPU cycles (DWT)	*/
+	uint32_t	late;			/**< CCR writes after the next update		*/
+	uint32_t	faults;			/**< Break events							*/
+	uint32_t	deadtime_ns;	/**< Dead-time actually programmed			*/
+	uint32_t	pwm_hz;			/**< PWM frequency actually programmed		*/
+} MC_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure TIM1, the PWM/break pins and ADC1 (outputs disabled).
+  * @param[in] config	PWM frequency and dead-time.
+  * @retval	MC_OK or MC_EINVAL.
+  */
+MC_Status_t MC_Init(const MC_Config_t *config);
+
+/**
+  * @brief	Set the control-loop callback (NULL: hold 50 % duty).
+  * @param[in] callback	Callback run from the ADC JEOC interrupt.
+  * @retval	None
+  */
+void MC_SetCallback(MC_Callback_t callback);
+
+/**
+  * @brief	Start the counter and the ADC, enable the outputs (MOE).
+  * @param	None
+  * @retval	MC_OK, or MC_EFAULT if the break input is active.
+  */
+MC_Status_t MC_Start(void);
+
+/**
+  * @brief	Disable the outputs (idle state) and stop the control loop.
+  * @param	None
+  * @retval	None
+  */
+void MC_Stop(void);
+
+/**
+  * @brief	Re-arm after a break: clear the fault once BKIN is released.
+  * @param	None
+  * @retval	MC_OK, or MC_EFAULT if the break input is still active.
+  * @note	Outputs stay disabled; call MC_Start() to enable them again.
+  */
+MC_Status_t MC_ClearFault(void);
+
+/**
+  * @brief	Whether a break event disabled the outputs.
+  * @param	None
+  * @retval	1 when faulted, 0 otherwise.
+  */
+uint8_t MC_IsFaulted(void);
+
+/**
+  * @brief	Copy the control-loop statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void MC_GetStats(MC_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* MOTOR_PWM_H_ */
@@ -0,0 +1,199 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	Three-phase complementary PWM with synchronous current sampling.
+  *
+  * 		This file initializes the system, board support package (BSP) and
+  * 		the motor PWM module (TIM1 at 20 kHz, 500 ns dead-time), and runs an
+  * 		open-loop V/f sine modulation from the ADC control-loop callback.
+  * 		Every 500 ms the loop statistics and the latest samples are printed
+  * 		over ITM stimulus port 0 (SWO on PB3):
+  *
+  * 		`MC,<loops>,<latency ns>,<max latency ns>,<max isr cycles>,<late>,<faults>,<I_a>,<I_b>,<V_bus>`
+  *
+  * 		A break (PE15 low) turns on the red LED; the user button re-arms.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "delay.h"
+#include "motor_pwm.h"
+
+#define PWM_HZ				20000UL		/**< Control loop rate						*/
+#define DEADTIME_NS			500UL		/**< Gate driver dead-time					*/
+#define ELECTRICAL_HZ		50UL		/**< Output frequency						*/
+#define MODULATION_Q15		16384L		/**< Modulation index 0.5					*/
+#define REPORT_PERIOD_MS	500U
+
+/** @brief	One sine period, Q15, in SRAM (read by the control loop every cycle). */
+static int16_t sine_q15[256] = {
+		     0,    804,   1608,   2410,   3212,   4011,   4808,   5602,   6393,   7179,   7962,   8739,
+		  9512,  10278,  11039,  11793,  12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+		 18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,  23170,  23731,  24279,  24811,
+		 25329,  25832,  26319,  26790,  27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+		 30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,  32137,  32285,  32412,  32521,
+		 32609,  32678,  32728,  32757,  32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+		 32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,  30273,  29956,  29621,  29268,
+		 28898,  28510,  28105,  27683,  27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+		 23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,  18204,  17530,  16846,  16151,
+		 15446,  14732,  14010,  13279,  12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+		  6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,      0,   -804,  -1608,  -2410,
+		 -3212,  -4011,  -4808,  -5602,  -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+		-12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159,
+		-20787, -21403, -22005, -22594, -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+		-27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, -30273, -30571, -30852, -31113,
+		-31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+		-32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580,
+		-31356, -31113, -30852, -30571, -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+		-27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, -23170, -22594, -22005, -21403,
+		-20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+		-12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,  -6393,  -5602,  -4808,  -4011,
+		 -3212,  -2410,  -1608,   -804
+};
+
+static uint32_t phase_acc;								/**< Electrical angle, 2^32 = 360°	*/
+static const uint32_t phase_step = (uint32_t)(((uint64_t)ELECTRICAL_HZ << 32) / PWM_HZ);
+static volatile MC_Sample_t last_sample;				/**< For the report					*/
+static volatile uint8_t rearm_request;					/**< Set by the button callback		*/
+
+/**************************  Static Function Prototypes  ***************************/
+static MC_RAMFUNC void Control_Loop(const MC_Sample_t *sample, MC_Duty_t *duty);
+static void Report(void);
+static void ITM_Print(const char *str);
+static void ITM_PrintU32(uint32_t value);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs, button in EXTI mode).
+  * 		3. Initializes TIM1 (20 kHz center-aligned, 500 ns dead-time, break)
+  * 		   and ADC1 (injected, triggered at the PWM center).
+  * 		4. Registers the V/f control loop and enables the outputs.
+  * 		5. Enters an infinite loop that reports statistics and handles faults.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	static const MC_Config_t mc_config = { .pwm_hz = PWM_HZ, .deadtime_ns = DEADTIME_NS };
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	BSP_Button_Init(BUTTON_MODE_EXTI);	/**< Button re-arms after a fault			*/
+	Delay_Init();						/**< Report period							*/
+	MC_Init(&mc_config);				/**< TIM1, break input, ADC1				*/
+	MC_SetCallback(Control_Loop);
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	if (MC_Start() == MC_OK)
+		BSP_LED_On(LED_GREEN);			/**< Outputs enabled						*/
+
+	/**< Main loop */
+	while (1)
+	{
+		Delay_ms(REPORT_PERIOD_MS);
+
+		if (MC_IsFaulted())
+		{
+			BSP_LED_Off(LED_GREEN);
+			BSP_LED_On(LED_RED);
+		}
+		if (rearm_request)
+		{
+			rearm_request = 0;
+			if (MC_ClearFault() == MC_OK && MC_Start() == MC_OK)
+			{
+				BSP_LED_Off(LED_RED);
+				BSP_LED_On(LED_GREEN);
+			}
+		}
+
+		Report();
+	}
+}
+
+/**
+  * @brief	Button callback: re-arm the outputs after a fault.
+  */
+void BSP_Button_Callback(void)
+{
+	rearm_request = 1;
+}
+
+/**
+  * @brief	Open-loop V/f modulation: three sines 120° apart around 50 % duty.
+  * @param[in] sample	Synchronous ADC samples (stored for the report).
+  * @param[out] duty	Next phase duties.
+  * @retval	None
+  */
+static MC_RAMFUNC void Control_Loop(const MC_Sample_t *sample, MC_Duty_t *duty)
+{
+	last_sample = *sample;
+
+	phase_acc += phase_step;
+	const uint32_t idx = phase_acc >> 24;
+
+	duty->a = (uint32_t)((int32_t)(MC_DUTY_ONE / 2U) + ((sine_q15[idx] * MODULATION_Q15) >> 15));
+	duty->b = (uint32_t)((int32_t)(MC_DUTY_ONE / 2U) + ((sine_q15[(idx + 85U) & 0xFFU] * MODULATION_Q15) >> 15));
+	duty->c = (uint32_t)((int32_t)(MC_DUTY_ONE / 2U) + ((sine_q15[(idx + 171U) & 0xFFU] * MODULATION_Q15) >> 15));
+}
+
+/**
+  * @brief	Print the control-loop statistics and the latest samples as an `MC,...` line.
+  */
+static void Report(void)
+{
+	MC_Stats_t stats;
+	MC_GetStats(&stats);
+
+	ITM_Print("MC,");
+	ITM_PrintU32(stats.cycles);
+	ITM_Print(",");
+	ITM_PrintU32((uint32_t)((uint64_t)stats.latency_last * 1000000000ULL / MC_TIM_CLK_HZ));
+	ITM_Print(",");
+	ITM_PrintU32((uint32_t)((uint64_t)stats.latency_max * 1000000000ULL / MC_TIM_CLK_HZ));
+	ITM_Print(",");
+	ITM_PrintU32(stats.isr_cycles_max);
+	ITM_Print(",");
+	ITM_PrintU32(stats.late);
+	ITM_Print(",");
+	ITM_PrintU32(stats.faults);
+	ITM_Print(",");
+	ITM_PrintU32(last_sample.i_a);
+	ITM_Print(",");
+	ITM_PrintU32(last_sample.i_b);
+	ITM_Print(",");
+	ITM_PrintU32(last_sample.v_bus);
+	ITM_Print("\n");
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write an unsigned decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf);
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	ITM_Print(&buf[i]);
+}
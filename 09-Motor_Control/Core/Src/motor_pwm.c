@@ -0,0 +1,320 @@
+/**
+  * @file	motor_pwm.c
+  * @author	Parham Estiri
+  * @brief	Three-phase complementary PWM on TIM1 with synchronous ADC sampling.
+  *
+  * 		This file provides:
+  * 		 - TIM1 center-aligned PWM, dead-time encoding and break handling
+  * 		 - ADC1 injected sequence triggered by TIM1 TRGO (OC4REF rising edge)
+  * 		 - The control-loop interrupt (SRAM) with latency measurement
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "motor_pwm.h"
+
+#define MC_GPIO_AF			1UL				/**< TIM1 on port E							*/
+#define MC_BKIN_PIN			15U				/**< PE15 = TIM1_BKIN						*/
+#define MC_ADC_CLK_DIV		1UL				/**< ADCPRE: PCLK2 / 4 = 21 MHz				*/
+#define MC_ADC_JEXTSEL		1UL				/**< Injected trigger: TIM1_TRGO			*/
+
+static const uint8_t mc_pwm_pins[] = { 8, 9, 10, 11, 12, 13 };	/**< CH1N, CH1 .. CH3N, CH3	*/
+
+static MC_Callback_t volatile mc_callback;	/**< Control loop (NULL: 50 % duty)			*/
+static uint32_t mc_arr;						/**< PWM half-period in ticks				*/
+static uint32_t mc_ccr4;					/**< ADC trigger point (up-counting)		*/
+static volatile uint8_t mc_faulted;			/**< Break fired since MC_ClearFault()		*/
+static volatile MC_Stats_t mc_stats;
+
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t MC_DeadTime_Encode(uint32_t ns, uint32_t *actual_ns);
+static uint8_t MC_Break_Active(void);
+
+/**
+  * @brief	Configure TIM1, the PWM/break pins and ADC1 (outputs disabled).
+  * @param[in] config	PWM frequency and dead-time.
+  * @retval	MC_OK or MC_EINVAL.
+  */
+MC_Status_t MC_Init(const MC_Config_t *config)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+	uint32_t deadtime_ns;
+
+	if (config->pwm_hz < MC_PWM_HZ_MIN || config->pwm_hz > MC_PWM_HZ_MAX
+			|| config->deadtime_ns > MC_DEADTIME_NS_MAX)
+		return MC_EINVAL;
+
+	const uint32_t dtg = MC_DeadTime_Encode(config->deadtime_ns, &deadtime_ns);
+
+	mc_arr  = MC_TIM_CLK_HZ / (2U * config->pwm_hz);	/**< Up and down: two ticks per count	*/
+	mc_ccr4 = mc_arr - MC_TRIGGER_ADVANCE;
+	mc_stats = (MC_Stats_t){ .latency_min = 0xFFFFFFFFUL, .deadtime_ns = deadtime_ns,
+							 .pwm_hz = MC_TIM_CLK_HZ / (2U * mc_arr) };
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_GPIOEEN;
+	RCC->APB2ENR |= RCC_APB2ENR_TIM1EN | RCC_APB2ENR_ADC1EN;
+
+	/* Cycle counter for the interrupt duration */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	/* TIM1: center-aligned mode 1, preloaded ARR and CCRx, outputs off until MOE */
+	TIM1->CR1   = TIM_CR1_CMS_0 | TIM_CR1_ARPE;
+	TIM1->CR2   = 7UL << TIM_CR2_MMS_Pos;			/**< TRGO = OC4REF							*/
+	TIM1->PSC   = 0;
+	TIM1->ARR   = mc_arr;
+	TIM1->RCR   = 0;
+	TIM1->CCMR1 = (6UL << TIM_CCMR1_OC1M_Pos) | TIM_CCMR1_OC1PE		/**< PWM mode 1				*/
+				| (6UL << TIM_CCMR1_OC2M_Pos) | TIM_CCMR1_OC2PE;
+	TIM1->CCMR2 = (6UL << TIM_CCMR2_OC3M_Pos) | TIM_CCMR2_OC3PE
+				| (7UL << TIM_CCMR2_OC4M_Pos) | TIM_CCMR2_OC4PE;	/**< PWM mode 2: high near the peak	*/
+	TIM1->CCR1  = mc_arr / 2U;
+	TIM1->CCR2  = mc_arr / 2U;
+	TIM1->CCR3  = mc_arr / 2U;
+	TIM1->CCR4  = mc_ccr4;
+	TIM1->CCER  = TIM_CCER_CC1E | TIM_CCER_CC1NE	/**< Active-high high- and low-side gates	*/
+				| TIM_CCER_CC2E | TIM_CCER_CC2NE
+				| TIM_CCER_CC3E | TIM_CCER_CC3NE;
+	TIM1->BDTR  = dtg								/**< Dead-time								*/
+				| TIM_BDTR_OSSR | TIM_BDTR_OSSI		/**< Drive idle levels (low) when disabled	*/
+				| TIM_BDTR_BKE;						/**< Break enabled, active low, no AOE		*/
+	TIM1->EGR   = TIM_EGR_UG;
+	TIM1->SR    = 0;
+	TIM1->DIER  = TIM_DIER_BIE;
+
+	/* Pins: PWM and BKIN on AF1 (BKIN pulled up), shunts and bus voltage analog */
+	for (uint32_t i = 0; i < sizeof(mc_pwm_pins); i++)
+	{
+		uint32_t pin = mc_pwm_pins[i];
+		GPIOE->MODER   = (GPIOE->MODER & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+		GPIOE->OSPEEDR = (GPIOE->OSPEEDR & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+		GPIOE->AFR[pin >> 3] = (GPIOE->AFR[pin >> 3] & ~(0xFUL << ((pin & 7U) * 4)))
+							 | (MC_GPIO_AF << ((pin & 7U) * 4));
+	}
+	GPIOE->MODER = (GPIOE->MODER & ~(3UL << (MC_BKIN_PIN * 2))) | (2UL << (MC_BKIN_PIN * 2));
+	GPIOE->PUPDR = (GPIOE->PUPDR & ~(3UL << (MC_BKIN_PIN * 2))) | (1UL << (MC_BKIN_PIN * 2));
+	GPIOE->AFR[1] = (GPIOE->AFR[1] & ~(0xFUL << ((MC_BKIN_PIN & 7U) * 4)))
+				  | (MC_GPIO_AF << ((MC_BKIN_PIN & 7U) * 4));
+	GPIOA->MODER |= 3UL << (1U * 2);				/**< PA1 = ADC123_IN1						*/
+	GPIOB->MODER |= (3UL << (0U * 2)) | (3UL << (1U * 2));	/**< PB0 = IN8, PB1 = IN9			*/
+
+	/* ADC1: injected sequence IN1, IN8, IN9 on the TRGO rising edge */
+	ADC->CCR    = (ADC->CCR & ~ADC_CCR_ADCPRE) | (MC_ADC_CLK_DIV << ADC_CCR_ADCPRE_Pos);
+	ADC1->SMPR2 &= ~(ADC_SMPR2_SMP1 | ADC_SMPR2_SMP8 | ADC_SMPR2_SMP9);	/**< 3 cycles each	*/
+	ADC1->JSQR  = (2UL << ADC_JSQR_JL_Pos)			/**< 3 conversions: JSQ2, JSQ3, JSQ4		*/
+				| (1UL << ADC_JSQR_JSQ2_Pos)
+				| (8UL << ADC_JSQR_JSQ3_Pos)
+				| (9UL << ADC_JSQR_JSQ4_Pos);
+	ADC1->CR1   = ADC_CR1_SCAN | ADC_CR1_JEOCIE;
+	ADC1->CR2   = (1UL << ADC_CR2_JEXTEN_Pos)		/**< Rising edge							*/
+				| (MC_ADC_JEXTSEL << ADC_CR2_JEXTSEL_Pos)
+				| ADC_CR2_ADON;
+
+	NVIC_SetPriority(ADC_IRQn, NVIC_EncodePriority(PG, MC_ADC_PRIORITY, 0));
+	NVIC_SetPriority(TIM1_BRK_TIM9_IRQn, NVIC_EncodePriority(PG, MC_BRK_PRIORITY, 0));
+	NVIC_EnableIRQ(ADC_IRQn);
+	NVIC_EnableIRQ(TIM1_BRK_TIM9_IRQn);
+
+	mc_faulted = 0;
+	return MC_OK;
+}
+
+/**
+  * @brief	Set the control-loop callback (NULL: hold 50 % duty).
+  * @param[in] callback	Callback run from the ADC JEOC interrupt.
+  * @retval	None
+  */
+void MC_SetCallback(MC_Callback_t callback)
+{
+	mc_callback = callback;
+}
+
+/**
+  * @brief	Start the counter and the ADC, enable the outputs (MOE).
+  * @param	None
+  * @retval	MC_OK, or MC_EFAULT if the break input is active.
+  */
+MC_Status_t MC_Start(void)
+{
+	if (mc_faulted || MC_Break_Active())
+		return MC_EFAULT;
+
+	TIM1->BDTR |= TIM_BDTR_MOE;
+	TIM1->CR1  |= TIM_CR1_CEN;
+	return MC_OK;
+}
+
+/**
+  * @brief	Disable the outputs (idle state) and stop the control loop.
+  * @param	None
+  * @retval	None
+  */
+void MC_Stop(void)
+{
+	TIM1->BDTR &= ~TIM_BDTR_MOE;					/**< Idle levels: all gates low				*/
+	TIM1->CR1  &= ~TIM_CR1_CEN;						/**< No more ADC triggers					*/
+}
+
+/**
+  * @brief	Re-arm after a break: clear the fault once BKIN is released.
+  * @param	None
+  * @retval	MC_OK, or MC_EFAULT if the break input is still active.
+  */
+MC_Status_t MC_ClearFault(void)
+{
+	if (MC_Break_Active())
+		return MC_EFAULT;
+
+	TIM1->SR    = ~TIM_SR_BIF;
+	TIM1->DIER |= TIM_DIER_BIE;
+	mc_faulted  = 0;
+	return MC_OK;
+}
+
+/**
+  * @brief	Whether a break event disabled the outputs.
+  * @param	None
+  * @retval	1 when faulted, 0 otherwise.
+  */
+uint8_t MC_IsFaulted(void)
+{
+	return mc_faulted;
+}
+
+/**
+  * @brief	Copy the control-loop statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void MC_GetStats(MC_Stats_t *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	*stats = mc_stats;
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief	Encode a dead-time into BDTR.DTG (tDTS = 1 / 168 MHz, CKD = 0).
+  * @param[in] ns			Requested dead-time, rounded up to the next step.
+  * @param[out] actual_ns	Dead-time actually programmed.
+  * @retval	DTG field.
+  */
+static uint32_t MC_DeadTime_Encode(uint32_t ns, uint32_t *actual_ns)
+{
+	const uint32_t clk_mhz = MC_TIM_CLK_HZ / 1000000UL;
+	uint32_t t = (ns * clk_mhz + 999U) / 1000U;		/**< Ticks of tDTS							*/
+	uint32_t dtg, ticks;
+
+	if (t <= 127U)									/**< 0xxxxxxx: DTG x tDTS					*/
+	{
+		dtg = t;
+		ticks = t;
+	}
+	else if (t <= 254U)								/**< 10xxxxxx: (64 + DTG) x 2 tDTS			*/
+	{
+		dtg = (t + 1U) / 2U - 64U;
+		ticks = (64U + dtg) * 2U;
+		dtg |= 0x80U;
+	}
+	else if (t <= 504U)								/**< 110xxxxx: (32 + DTG) x 8 tDTS			*/
+	{
+		dtg = (t + 7U) / 8U - 32U;
+		ticks = (32U + dtg) * 8U;
+		dtg |= 0xC0U;
+	}
+	else											/**< 111xxxxx: (32 + DTG) x 16 tDTS			*/
+	{
+		dtg = (t + 15U) / 16U - 32U;
+		if (dtg > 31U)
+			dtg = 31U;
+		ticks = (32U + dtg) * 16U;
+		dtg |= 0xE0U;
+	}
+
+	*actual_ns = ticks * 1000U / clk_mhz;
+	return dtg;
+}
+
+/**
+  * @brief	Whether BKIN (PE15, active low) is asserted.
+  */
+static uint8_t MC_Break_Active(void)
+{
+	return (GPIOE->IDR & (1UL << MC_BKIN_PIN)) ? 0U : 1U;
+}
+
+/**
+  * @brief	ADC interrupt (JEOC): read the samples, run the control loop,
+  * 		write the next duties and measure the latency.
+  *
+  * 		The trigger fires when the counter passes CCR4 counting up. The new
+  * 		duties are preloaded and take effect at the next update event. A
+  * 		write still made while counting down lands before the valley update;
+  * 		a write made after the counter turned up again is counted as late.
+  *
+  * @note	Runs from SRAM: no flash wait states and no contention with the
+  * 		instruction fetches of the interrupted code.
+  */
+MC_RAMFUNC void ADC_IRQHandler(void)
+{
+	const uint32_t start = DWT->CYCCNT;
+	MC_Sample_t sample;
+	MC_Duty_t duty = { MC_DUTY_ONE / 2U, MC_DUTY_ONE / 2U, MC_DUTY_ONE / 2U };
+	MC_Callback_t callback = mc_callback;
+
+	ADC1->SR = ~ADC_SR_JEOC;
+	sample.i_a   = (uint16_t)ADC1->JDR1;
+	sample.i_b   = (uint16_t)ADC1->JDR2;
+	sample.v_bus = (uint16_t)ADC1->JDR3;
+
+	if (callback)
+		callback(&sample, &duty);
+
+	const uint32_t arr = mc_arr;
+	TIM1->CCR1 = ((duty.a > MC_DUTY_ONE ? MC_DUTY_ONE : duty.a) * arr) >> 16;
+	TIM1->CCR2 = ((duty.b > MC_DUTY_ONE ? MC_DUTY_ONE : duty.b) * arr) >> 16;
+	TIM1->CCR3 = ((duty.c > MC_DUTY_ONE ? MC_DUTY_ONE : duty.c) * arr) >> 16;
+
+	/* Ticks since the trigger, from the counter position and direction */
+	const uint32_t cnt = TIM1->CNT;
+	uint32_t latency;
+	if (TIM1->CR1 & TIM_CR1_DIR)					/**< Past the peak, before the valley		*/
+	{
+		latency = (arr - mc_ccr4) + (arr - cnt);
+	}
+	else if (cnt >= mc_ccr4)						/**< Before the peak						*/
+	{
+		latency = cnt - mc_ccr4;
+	}
+	else											/**< Past the valley: missed an update		*/
+	{
+		latency = (arr - mc_ccr4) + arr + cnt;
+		mc_stats.late++;
+	}
+
+	mc_stats.cycles++;
+	mc_stats.latency_last = latency;
+	if (latency < mc_stats.latency_min)
+		mc_stats.latency_min = latency;
+	if (latency > mc_stats.latency_max)
+		mc_stats.latency_max = latency;
+
+	const uint32_t cycles = DWT->CYCCNT - start;
+	if (cycles > mc_stats.isr_cycles_max)
+		mc_stats.isr_cycles_max = cycles;
+}
+
+/**
+  * @brief	TIM1 break interrupt: the hardware already cleared MOE.
+  */
+void TIM1_BRK_TIM9_IRQHandler(void)
+{
+	if (TIM1->SR & TIM_SR_BIF)
+	{
+		TIM1->SR    = ~TIM_SR_BIF;
+		TIM1->DIER &= ~TIM_DIER_BIE;				/**< BIF stays set while BKIN is low		*/
+		mc_faulted  = 1;
+		mc_stats.faults++;
+	}
+}
@@ -0,0 +1,158 @@
+/**
+  * @file	stepper.h
+  * @author	Parham Estiri
+  * @brief	Stepper motor pulse-train generator with DMA-driven acceleration profiles.
+  *
+  * 		This module provides:
+  * 		 - One timer per axis; every timer period is one step pulse
+  * 		 - Per-step periods (ARR values) precomputed for a trapezoidal or
+  * 		   S-curve ramp; DMA writes the next ARR on every update event, so a
+  * 		   step pulse costs no CPU time
+  * 		 - Three DMA segments per move (accelerate, cruise, decelerate): the
+  * 		   cruise segment repeats one value with memory increment off, so a
+  * 		   move of any length needs only the ramp tables. A segment longer
+  * 		   than the 16-bit NDTR (65535 steps) is reloaded in pieces from the
+  * 		   transfer-complete interrupt
+  * 		 - Exact step count: the last segment's transfer-complete interrupt
+  * 		   sets one-pulse mode, the counter stops after the last period
+  * 		 - Synchronized start: TIM2 (master, TRGO = enable) starts every
+  * 		   selected axis timer in the same clock cycle through ITR1
+  *
+  * 		| Axis | Timer | Step (PWM)    | Dir  | DMA (TIMx_UP)       |
+  * 		|------|-------|---------------|------|---------------------|
+  * 		| X    | TIM3  | PB4  CH1 AF2  | PB5  | DMA1 Stream2, ch 5  |
+  * 		| Y    | TIM4  | PD12 CH1 AF2  | PD13 | DMA1 Stream6, ch 2  |
+  * 		| Z    | TIM1  | PE9  CH1 AF1  | PE7  | DMA2 Stream5, ch 6  |
+  *
+  * @note	The step output rises STEP_PULSE_DELAY ticks after each update and
+  * 		stays high until the end of the period (PWM mode 2), so the line is
+  * 		low whenever the axis is stopped. Drivers step on the rising edge.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef STEPPER_H_
+#define STEPPER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define STEP_TICK_HZ			4000000UL	/**< Step timer tick (16-bit: 61 .. 100k steps/s)	*/
+#define STEP_RATE_MIN_HZ		(STEP_TICK_HZ / 65536UL + 1UL)
+#define STEP_RATE_MAX_HZ		100000UL	/**< Highest step rate								*/
+#define STEP_PULSE_DELAY		8U			/**< Low time before each rising edge (2 µs)		*/
+#define STEP_RAMP_MAX			2048U		/**< Ramp table entries per axis (x2: accel, decel)	*/
+#define STEP_DMA_PRIORITY		0x01U		/**< Segment switch: due within one step period		*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Axes.
+  */
+typedef enum {
+	STEP_AXIS_X		= 0,	/**< TIM3				*/
+	STEP_AXIS_Y		= 1,	/**< TIM4				*/
+	STEP_AXIS_Z		= 2,	/**< TIM1				*/
+	STEP_AXES		= 3
+} Step_Axis_t;
+
+/**
+  * @brief	Acceleration profiles.
+  */
+typedef enum {
+	STEP_PROFILE_TRAPEZOID	= 0,	/**< Constant acceleration							*/
+	STEP_PROFILE_SCURVE		= 1		/**< Smoothstep velocity, peak acceleration `accel`	*/
+} Step_Profile_t;
+
+/**
+  * @brief	Driver status codes.
+  */
+typedef enum {
+	STEP_OK			= 0,	/**< Success										*/
+	STEP_EINVAL		= 1,	/**< Parameter out of range							*/
+	STEP_EBUSY		= 2		/**< Axis is moving									*/
+} Step_Status_t;
+
+/**
+  * @brief	Move request.
+  */
+typedef struct {
+	int32_t			steps;		/**< Relative move; the sign selects the direction
+									 (INT32_MIN is rejected)						*/
+	uint32_t		v_start;	/**< Start and end rate (steps/s)					*/
+	uint32_t		v_max;		/**< Cruise rate (steps/s)							*/
+	uint32_t		accel;		/**< Acceleration (steps/s²)						*/
+	Step_Profile_t	profile;	/**< Ramp shape										*/
+} Step_Move_t;
+
+/**
+  * @brief	Planned move.
+  */
+typedef struct {
+	uint32_t		ramp_steps;	/**< Steps in each ramp								*/
+	uint32_t		v_peak;		/**< Rate reached (below v_max for short moves)	*/
+	uint32_t		time_us;	/**< Move duration									*/
+} Step_Plan_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure the pins, axis timers, DMA streams and the sync timer.
+  * @param	None
+  * @retval	None
+  */
+void Step_Init(void);
+
+/**
+  * @brief	Compute the ramp tables of a move and arm the axis (not started).
+  * @param[in] axis		Axis.
+  * @param[in] move		Move request.
+  * @param[out] plan	Planned move (may be NULL).
+  * @retval	STEP_OK, STEP_EINVAL or STEP_EBUSY.
+  */
+Step_Status_t Step_Plan(Step_Axis_t axis, const Step_Move_t *move, Step_Plan_t *plan);
+
+/**
+  * @brief	Start one armed axis.
+  * @param[in] axis		Axis.
+  * @retval	STEP_OK, STEP_EINVAL (not armed) or STEP_EBUSY.
+  */
+Step_Status_t Step_Start(Step_Axis_t axis);
+
+/**
+  * @brief	Start several armed axes in the same timer clock cycle.
+  * @param[in] mask		Bit n selects axis n.
+  * @retval	STEP_OK, STEP_EINVAL (an axis is not armed) or STEP_EBUSY.
+  */
+Step_Status_t Step_StartSync(uint32_t mask);
+
+/**
+  * @brief	Abort a move immediately (no deceleration).
+  * @param[in] axis		Axis (out of range: ignored).
+  * @retval	None
+  */
+void Step_Stop(Step_Axis_t axis);
+
+/**
+  * @brief	Whether an axis is moving.
+  * @param[in] axis		Axis.
+  * @retval	1 while moving, 0 when idle, armed or out of range.
+  */
+uint8_t Step_IsBusy(Step_Axis_t axis);
+
+/**
+  * @brief	Axis position in steps (exact when idle, within one step while moving).
+  * @param[in] axis		Axis.
+  * @retval	Position, 0 for an axis out of range.
+  */
+int32_t Step_GetPosition(Step_Axis_t axis);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STEPPER_H_ */
@@ -0,0 +1,129 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	Three-axis stepper pulse-train demo.
+  *
+  * 		This file initializes the system, board support package (BSP) and
+  * 		the stepper module, then moves three axes back and forth with a
+  * 		synchronized start: X with a trapezoidal ramp to 100 k steps/s,
+  * 		Y with an S-curve, Z with a short trapezoid. Each plan and the final
+  * 		positions are printed over ITM stimulus port 0 (SWO on PB3):
+  *
+  * 		`STEP,<axis>,<steps>,<ramp steps>,<peak steps/s>,<time us>`
+  * 		`POS,<x>,<y>,<z>`
+  *
+  * 		The Y step output is PD12, so the green LED shows its pulse train.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "delay.h"
+#include "stepper.h"
+
+#define PAUSE_MS		500U		/**< Pause between moves		*/
+
+/** @brief	Demo moves (the sign alternates every round). */
+static const Step_Move_t demo_move[STEP_AXES] = {
+		[STEP_AXIS_X] = { 40000, 1000U, 100000U, 2500000U, STEP_PROFILE_TRAPEZOID },
+		[STEP_AXIS_Y] = { 40000, 1000U, 100000U, 2500000U, STEP_PROFILE_SCURVE },
+		[STEP_AXIS_Z] = {  4000,  500U,  20000U,  200000U, STEP_PROFILE_TRAPEZOID }
+};
+
+/**************************  Static Function Prototypes  ***************************/
+static void ITM_Print(const char *str);
+static void ITM_PrintS32(int32_t value);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs).
+  * 		3. Initializes the stepper axes (TIM3, TIM4, TIM1 + DMA) and TIM2 (sync).
+  * 		4. Enters an infinite loop: plan the three moves, start them together,
+  * 		   wait (the CPU only handles three interrupts per axis and move),
+  * 		   then reverse the direction.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	int32_t sign = 1;
+	Step_Plan_t plan;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	Delay_Init();						/**< Pause between moves					*/
+	Step_Init();						/**< Axis timers, DMA streams, sync timer	*/
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	/**< Main loop */
+	while (1)
+	{
+		for (uint32_t a = 0; a < STEP_AXES; a++)
+		{
+			Step_Move_t move = demo_move[a];
+			move.steps *= sign;
+			Step_Plan((Step_Axis_t)a, &move, &plan);
+
+			ITM_Print("STEP,");
+			ITM_PrintS32((int32_t)a);
+			ITM_Print(",");
+			ITM_PrintS32(move.steps);
+			ITM_Print(",");
+			ITM_PrintS32((int32_t)plan.ramp_steps);
+			ITM_Print(",");
+			ITM_PrintS32((int32_t)plan.v_peak);
+			ITM_Print(",");
+			ITM_PrintS32((int32_t)plan.time_us);
+			ITM_Print("\n");
+		}
+
+		Step_StartSync((1UL << STEP_AXES) - 1U);
+		while (Step_IsBusy(STEP_AXIS_X) || Step_IsBusy(STEP_AXIS_Y) || Step_IsBusy(STEP_AXIS_Z))
+			__WFI();					/**< Woken by segment interrupts			*/
+
+		ITM_Print("POS,");
+		ITM_PrintS32(Step_GetPosition(STEP_AXIS_X));
+		ITM_Print(",");
+		ITM_PrintS32(Step_GetPosition(STEP_AXIS_Y));
+		ITM_Print(",");
+		ITM_PrintS32(Step_GetPosition(STEP_AXIS_Z));
+		ITM_Print("\n");
+
+		sign = -sign;
+		Delay_ms(PAUSE_MS);
+	}
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write a signed decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintS32(int32_t value)
+{
+	char buf[12];
+	uint32_t i = sizeof(buf);
+	uint32_t magnitude = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + magnitude % 10U);
+		magnitude /= 10U;
+	} while (magnitude);
+	if (value < 0)
+		buf[--i] = '-';
+	ITM_Print(&buf[i]);
+}
@@ -0,0 +1,501 @@
+/**
+  * @file	stepper.c
+  * @author	Parham Estiri
+  * @brief	Stepper motor pulse-train generator with DMA-driven acceleration profiles.
+  *
+  * 		This file provides:
+  * 		 - Axis table (timer, pins, DMA stream)
+  * 		 - Ramp planning (trapezoid, S-curve) into ARR tables
+  * 		 - Segment chaining from the DMA transfer-complete interrupt
+  * 		 - TIM2 master for synchronized starts
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "stepper.h"
+
+#define STEP_ARR_MIN		(STEP_PULSE_DELAY + 2U)	/**< Keep a high time after the edge	*/
+#define STEP_SYNC_TIM		TIM2					/**< ITR1 of TIM1, TIM3 and TIM4		*/
+#define STEP_SYNC_ITR		1UL
+#define STEP_SEGMENTS		3U						/**< Accelerate, cruise, decelerate		*/
+#define STEP_DMA_NDTR_MAX	0xFFFFUL				/**< 16-bit NDTR: longer segments are
+														 loaded in several pieces			*/
+
+/**
+  * @brief	Static description of an axis.
+  */
+typedef struct {
+	TIM_TypeDef			*tim;			/**< Step timer								*/
+	uint8_t				apb2;			/**< Timer on APB2 (168 MHz) instead of APB1	*/
+	DMA_TypeDef			*dma;			/**< DMA controller							*/
+	DMA_Stream_TypeDef	*stream;		/**< Stream serving TIMx_UP					*/
+	uint8_t				stream_n;		/**< Stream number (0..7)					*/
+	uint32_t			channel;		/**< Request channel						*/
+	IRQn_Type			irq;			/**< Stream interrupt						*/
+	GPIO_TypeDef		*step_port;		/**< Step output (TIMx_CH1)					*/
+	uint8_t				step_pin;
+	uint8_t				step_af;
+	GPIO_TypeDef		*dir_port;		/**< Direction output						*/
+	uint8_t				dir_pin;
+} Step_Def_t;
+
+/**
+  * @brief	One DMA segment of a move.
+  */
+typedef struct {
+	const uint16_t		*src;			/**< ARR values								*/
+	uint32_t			count;			/**< Transfers								*/
+	uint8_t				minc;			/**< 0: repeat *src (cruise)				*/
+} Step_Seg_t;
+
+/**
+  * @brief	Axis state.
+  */
+typedef enum {
+	STEP_STATE_IDLE		= 0,
+	STEP_STATE_ARMED	= 1,
+	STEP_STATE_RUNNING	= 2
+} Step_State_t;
+
+/**
+  * @brief	Run-time data of an axis.
+  */
+typedef struct {
+	uint16_t			accel[STEP_RAMP_MAX];	/**< ARR per step, slow to fast			*/
+	uint16_t			decel[STEP_RAMP_MAX];	/**< Same ramp, fast to slow				*/
+	uint16_t			cruise;					/**< ARR at v_peak						*/
+	Step_Seg_t			seg[STEP_SEGMENTS];
+	uint8_t				seg_count;
+	volatile uint8_t	seg_index;				/**< Segment being transferred			*/
+	volatile uint32_t	seg_left;				/**< Transfers of seg_index not loaded yet	*/
+	volatile uint32_t	seg_load;				/**< Transfers in the stream (NDTR at load)	*/
+	volatile uint32_t	seg_base;				/**< Steps started before this load		*/
+	uint32_t			total;					/**< Steps in the move					*/
+	int32_t				dir;					/**< +1 or -1							*/
+	int32_t				position;				/**< Position before the move			*/
+	volatile Step_State_t state;
+} Step_Axis_Data_t;
+
+/** @brief	Axes (see the table in stepper.h). */
+static const Step_Def_t step_def[STEP_AXES] = {
+		[STEP_AXIS_X] = { TIM3, 0, DMA1, DMA1_Stream2, 2, 5, DMA1_Stream2_IRQn, GPIOB,  4, 2, GPIOB,  5 },
+		[STEP_AXIS_Y] = { TIM4, 0, DMA1, DMA1_Stream6, 6, 2, DMA1_Stream6_IRQn, GPIOD, 12, 2, GPIOD, 13 },
+		[STEP_AXIS_Z] = { TIM1, 1, DMA2, DMA2_Stream5, 5, 6, DMA2_Stream5_IRQn, GPIOE,  9, 1, GPIOE,  7 }
+};
+
+/** @brief	Flag offset of a stream inside LISR/HISR (streams 0/4, 1/5, 2/6, 3/7). */
+static const uint8_t step_dma_flag_pos[4] = { 0U, 6U, 16U, 22U };
+
+static Step_Axis_Data_t step_axis[STEP_AXES];
+
+/**************************  Static Function Prototypes  ***************************/
+static void Step_DMA_Load(const Step_Def_t *d, const uint16_t *src, uint32_t count, uint8_t minc);
+static void Step_Seg_Load(Step_Axis_t axis);
+static void Step_DMA_IRQHandler(Step_Axis_t axis);
+static uint32_t Step_Done(Step_Axis_t axis);
+static uint32_t Step_Isqrt(uint64_t x);
+static uint16_t Step_Arr(uint32_t rate_hz);
+
+/**
+  * @brief	Configure the pins, axis timers, DMA streams and the sync timer.
+  * @param	None
+  * @retval	None
+  */
+void Step_Init(void)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_GPIODEN | RCC_AHB1ENR_GPIOEEN
+				  | RCC_AHB1ENR_DMA1EN | RCC_AHB1ENR_DMA2EN;
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM3EN | RCC_APB1ENR_TIM4EN;
+	RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+
+	for (uint32_t a = 0; a < STEP_AXES; a++)
+	{
+		const Step_Def_t *d = &step_def[a];
+		const uint32_t sp = d->step_pin, dp = d->dir_pin;
+		const uint32_t clk = d->apb2 ? SystemCoreClock : SystemCoreClock / 2U;
+
+		d->step_port->MODER = (d->step_port->MODER & ~(3UL << (sp * 2))) | (2UL << (sp * 2));	/**< AF		*/
+		d->step_port->AFR[sp >> 3] = (d->step_port->AFR[sp >> 3] & ~(0xFUL << ((sp & 7U) * 4)))
+								   | ((uint32_t)d->step_af << ((sp & 7U) * 4));
+		d->dir_port->MODER = (d->dir_port->MODER & ~(3UL << (dp * 2))) | (1UL << (dp * 2));		/**< Out	*/
+
+		d->tim->CR1   = 0;
+		d->tim->PSC   = clk / STEP_TICK_HZ - 1U;
+		d->tim->ARR   = 0xFFFF;
+		d->tim->CCR1  = STEP_PULSE_DELAY;
+		d->tim->CCMR1 = 7UL << TIM_CCMR1_OC1M_Pos;		/**< PWM mode 2: low until CCR1, then high	*/
+		d->tim->CCER  = TIM_CCER_CC1E;
+		d->tim->EGR   = TIM_EGR_UG;
+		d->tim->SR    = 0;
+		if (d->tim == TIM1)
+			d->tim->BDTR = TIM_BDTR_MOE;				/**< Advanced timer: enable the outputs		*/
+
+		NVIC_SetPriority(d->irq, NVIC_EncodePriority(PG, STEP_DMA_PRIORITY, 0));
+		NVIC_EnableIRQ(d->irq);
+		step_axis[a].state = STEP_STATE_IDLE;
+	}
+
+	STEP_SYNC_TIM->CR1 = 0;
+	STEP_SYNC_TIM->CR2 = 1UL << TIM_CR2_MMS_Pos;		/**< TRGO = counter enable					*/
+}
+
+/**
+  * @brief	Compute the ramp tables of a move and arm the axis (not started).
+  * @param[in] axis		Axis.
+  * @param[in] move		Move request.
+  * @param[out] plan	Planned move (may be NULL).
+  * @retval	STEP_OK, STEP_EINVAL or STEP_EBUSY.
+  */
+Step_Status_t Step_Plan(Step_Axis_t axis, const Step_Move_t *move, Step_Plan_t *plan)
+{
+	if (axis >= STEP_AXES || move->steps == 0 || move->steps == INT32_MIN || move->accel == 0
+			|| move->v_start < STEP_RATE_MIN_HZ || move->v_max > STEP_RATE_MAX_HZ
+			|| move->v_max < move->v_start)
+		return STEP_EINVAL;
+	if (Step_IsBusy(axis))
+		return STEP_EBUSY;
+
+	const Step_Def_t *d = &step_def[axis];
+	Step_Axis_Data_t *s = &step_axis[axis];
+	const uint32_t n = (move->steps < 0) ? (uint32_t)(-move->steps) : (uint32_t)move->steps;
+	const uint64_t v0_sq = (uint64_t)move->v_start * move->v_start;
+	const uint64_t dv_sq = (uint64_t)move->v_max * move->v_max - v0_sq;
+	const uint8_t scurve = (move->profile == STEP_PROFILE_SCURVE);
+
+	/* Ramp length: v² = v0² + 2·a·k (trapezoid); the S-curve needs 1.5x for the same peak */
+	uint64_t nr64 = scurve ? (3U * dv_sq) / (4U * (uint64_t)move->accel)
+						   : dv_sq / (2U * (uint64_t)move->accel);
+	if (nr64 > STEP_RAMP_MAX)
+		nr64 = STEP_RAMP_MAX;
+	if (nr64 > n / 2U)
+		nr64 = n / 2U;									/**< Short move: triangle / S without cruise	*/
+	const uint32_t nr = (uint32_t)nr64;
+
+	uint32_t v_peak = move->v_start;
+	if (nr > 0)
+	{
+		v_peak = scurve ? Step_Isqrt(v0_sq + (4U * (uint64_t)move->accel * nr) / 3U)
+						: Step_Isqrt(v0_sq + 2U * (uint64_t)move->accel * nr);
+		if (v_peak > move->v_max)
+			v_peak = move->v_max;
+	}
+
+	uint64_t ticks = 0;
+	for (uint32_t k = 0; k < nr; k++)
+	{
+		uint32_t v;
+		if (scurve)										/**< v0 + (vp - v0) · smoothstep(x), x in Q16	*/
+		{
+			uint64_t x  = ((2ULL * k + 1U) << 15) / nr;
+			uint64_t x2 = (x * x) >> 16;
+			uint64_t x3 = (x2 * x) >> 16;
+			v = move->v_start + (uint32_t)(((uint64_t)(v_peak - move->v_start) * (3U * x2 - 2U * x3)) >> 16);
+		}
+		else
+		{
+			v = Step_Isqrt(v0_sq + 2U * (uint64_t)move->accel * k);
+		}
+		s->accel[k] = Step_Arr(v);
+		s->decel[nr - 1U - k] = s->accel[k];
+		ticks += 2U * ((uint32_t)s->accel[k] + 1U);
+	}
+	s->cruise = Step_Arr(v_peak);
+	const uint32_t nc = n - 2U * nr;
+	ticks += (uint64_t)nc * ((uint32_t)s->cruise + 1U);
+
+	/* Segments: the first period is loaded directly, DMA supplies periods 2..n */
+	s->seg_count = 0;
+	if (nr > 1U)
+		s->seg[s->seg_count++] = (Step_Seg_t){ &s->accel[1], nr - 1U, 1 };
+	if (nc > (nr ? 0U : 1U))
+		s->seg[s->seg_count++] = (Step_Seg_t){ &s->cruise, nc - (nr ? 0U : 1U), 0 };
+	if (nr > 0U)
+		s->seg[s->seg_count++] = (Step_Seg_t){ s->decel, nr, 1 };
+	s->seg_index = 0;
+	s->seg_left  = s->seg[0].count;
+	s->seg_base  = 1;
+	s->total     = n;
+	s->dir       = (move->steps < 0) ? -1 : 1;
+
+	if (s->dir > 0)
+		d->dir_port->BSRR = 1UL << d->dir_pin;
+	else
+		d->dir_port->BSRR = 1UL << (d->dir_pin + 16U);
+
+	d->tim->CR1  = 0;
+	d->tim->SMCR = 0;
+	d->tim->DIER = 0;
+	d->tim->ARR  = nr ? s->accel[0] : s->cruise;		/**< No preload: DMA writes take effect now	*/
+	d->tim->CNT  = 0;
+	d->tim->EGR  = TIM_EGR_UG;
+	d->tim->SR   = 0;
+	if (s->seg_count)
+	{
+		Step_Seg_Load(axis);
+		d->tim->DIER = TIM_DIER_UDE;					/**< One ARR transfer per step				*/
+	}
+	else
+	{
+		d->tim->CR1 = TIM_CR1_OPM;						/**< Single step							*/
+	}
+	s->state = STEP_STATE_ARMED;
+
+	if (plan)
+	{
+		plan->ramp_steps = nr;
+		plan->v_peak     = v_peak;
+		plan->time_us    = (uint32_t)(ticks * 1000000ULL / STEP_TICK_HZ);
+	}
+	return STEP_OK;
+}
+
+/**
+  * @brief	Start one armed axis.
+  * @param[in] axis		Axis.
+  * @retval	STEP_OK, STEP_EINVAL (not armed) or STEP_EBUSY.
+  */
+Step_Status_t Step_Start(Step_Axis_t axis)
+{
+	if (axis >= STEP_AXES)
+		return STEP_EINVAL;
+	return Step_StartSync(1UL << axis);
+}
+
+/**
+  * @brief	Start several armed axes in the same timer clock cycle.
+  * @param[in] mask		Bit n selects axis n.
+  * @retval	STEP_OK, STEP_EINVAL (an axis is not armed) or STEP_EBUSY.
+  */
+Step_Status_t Step_StartSync(uint32_t mask)
+{
+	if (mask == 0 || mask >= (1UL << STEP_AXES))
+		return STEP_EINVAL;
+
+	for (uint32_t a = 0; a < STEP_AXES; a++)
+	{
+		if (!(mask & (1UL << a)))
+			continue;
+		if (step_axis[a].state == STEP_STATE_RUNNING)
+			return STEP_EBUSY;
+		if (step_axis[a].state != STEP_STATE_ARMED)
+			return STEP_EINVAL;
+	}
+
+	for (uint32_t a = 0; a < STEP_AXES; a++)
+	{
+		if (!(mask & (1UL << a)))
+			continue;
+		step_def[a].tim->SMCR = (STEP_SYNC_ITR << TIM_SMCR_TS_Pos)
+							  | (6UL << TIM_SMCR_SMS_Pos);		/**< Trigger mode: CEN on ITR1	*/
+		step_axis[a].state = STEP_STATE_RUNNING;
+	}
+
+	STEP_SYNC_TIM->CR1 = TIM_CR1_CEN;					/**< Rising TRGO starts every slave			*/
+	STEP_SYNC_TIM->CR1 = 0;
+	return STEP_OK;
+}
+
+/**
+  * @brief	Abort a move immediately (no deceleration).
+  * @param[in] axis		Axis (out of range: ignored).
+  * @retval	None
+  */
+void Step_Stop(Step_Axis_t axis)
+{
+	if (axis >= STEP_AXES)
+		return;
+
+	const Step_Def_t *d = &step_def[axis];
+	Step_Axis_Data_t *s = &step_axis[axis];
+
+	d->tim->CR1  = 0;
+	d->tim->DIER = 0;
+	d->stream->CR &= ~DMA_SxCR_EN;
+	if (s->state == STEP_STATE_RUNNING)
+		s->position += s->dir * (int32_t)Step_Done(axis);
+	d->tim->CNT = 0;									/**< Below CCR1: output low					*/
+	s->state = STEP_STATE_IDLE;
+}
+
+/**
+  * @brief	Whether an axis is moving.
+  * @param[in] axis		Axis.
+  * @retval	1 while moving, 0 when idle, armed or out of range.
+  */
+uint8_t Step_IsBusy(Step_Axis_t axis)
+{
+	if (axis >= STEP_AXES)
+		return 0;
+
+	Step_Axis_Data_t *s = &step_axis[axis];
+
+	if (s->state != STEP_STATE_RUNNING)
+		return 0;
+	if (!(step_def[axis].tim->CR1 & TIM_CR1_CEN) && s->seg_index >= s->seg_count)
+	{
+		s->position += s->dir * (int32_t)s->total;		/**< Stopped by one-pulse mode: complete	*/
+		s->state = STEP_STATE_IDLE;
+		return 0;
+	}
+	return 1;
+}
+
+/**
+  * @brief	Axis position in steps (exact when idle, within one step while moving).
+  * @param[in] axis		Axis.
+  * @retval	Position, 0 for an axis out of range.
+  */
+int32_t Step_GetPosition(Step_Axis_t axis)
+{
+	if (axis >= STEP_AXES)
+		return 0;
+
+	Step_Axis_Data_t *s = &step_axis[axis];
+
+	if (!Step_IsBusy(axis))
+		return s->position;
+	return s->position + s->dir * (int32_t)Step_Done(axis);
+}
+
+/**
+  * @brief	Load the next piece (at most STEP_DMA_NDTR_MAX transfers) of the current segment.
+  */
+static void Step_Seg_Load(Step_Axis_t axis)
+{
+	Step_Axis_Data_t *s = &step_axis[axis];
+	const Step_Seg_t *seg = &s->seg[s->seg_index];
+	const uint32_t offset = seg->minc ? seg->count - s->seg_left : 0U;
+
+	s->seg_load  = (s->seg_left > STEP_DMA_NDTR_MAX) ? STEP_DMA_NDTR_MAX : s->seg_left;
+	s->seg_left -= s->seg_load;
+	Step_DMA_Load(&step_def[axis], seg->src + offset, s->seg_load, seg->minc);
+}
+
+/**
+  * @brief	Load transfers into an axis stream and enable it.
+  */
+static void Step_DMA_Load(const Step_Def_t *d, const uint16_t *src, uint32_t count, uint8_t minc)
+{
+	volatile uint32_t *ifcr = (d->stream_n < 4U) ? &d->dma->LIFCR : &d->dma->HIFCR;
+
+	d->stream->CR &= ~DMA_SxCR_EN;
+	while (d->stream->CR & DMA_SxCR_EN);
+	*ifcr = 0x3DUL << step_dma_flag_pos[d->stream_n & 3U];		/**< Clear TC, HT, TE, DME, FE	*/
+
+	d->stream->PAR  = (uint32_t)&d->tim->ARR;
+	d->stream->M0AR = (uint32_t)src;
+	d->stream->NDTR = count;
+	d->stream->FCR  = 0;								/**< Direct mode							*/
+	d->stream->CR   = (d->channel << DMA_SxCR_CHSEL_Pos)
+					| DMA_SxCR_PL_1						/**< High priority							*/
+					| DMA_SxCR_MSIZE_0					/**< Memory: 16-bit							*/
+					| DMA_SxCR_PSIZE_0					/**< Peripheral: 16-bit						*/
+					| (minc ? DMA_SxCR_MINC : 0U)
+					| DMA_SxCR_DIR_0					/**< Memory to peripheral					*/
+					| DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	d->stream->CR  |= DMA_SxCR_EN;
+}
+
+/**
+  * @brief	Common stream interrupt: load the next piece or segment, or stop after the last step.
+  *
+  * 		Transfer complete means the last ARR of the load was just written
+  * 		at the start of its period. The next request comes one full step
+  * 		period later, which is the deadline for loading the next one.
+  */
+static void Step_DMA_IRQHandler(Step_Axis_t axis)
+{
+	const Step_Def_t *d = &step_def[axis];
+	Step_Axis_Data_t *s = &step_axis[axis];
+	volatile uint32_t *isr  = (d->stream_n < 4U) ? &d->dma->LISR  : &d->dma->HISR;
+	volatile uint32_t *ifcr = (d->stream_n < 4U) ? &d->dma->LIFCR : &d->dma->HIFCR;
+	const uint32_t pos = step_dma_flag_pos[d->stream_n & 3U];
+	const uint32_t flags = (*isr >> pos) & 0x3DUL;
+
+	*ifcr = flags << pos;
+
+	if (flags & DMA_LISR_TEIF0)
+	{
+		Step_Stop(axis);
+		return;
+	}
+	if (!(flags & DMA_LISR_TCIF0))
+		return;
+
+	s->seg_base += s->seg_load;
+	if (s->seg_left)
+		Step_Seg_Load(axis);							/**< Cruise longer than 65535 steps		*/
+	else if (++s->seg_index < s->seg_count)
+	{
+		s->seg_left = s->seg[s->seg_index].count;
+		Step_Seg_Load(axis);
+	}
+	else
+		d->tim->CR1 |= TIM_CR1_OPM;						/**< Stop at the end of the last period		*/
+}
+
+/**
+  * @brief	Steps started so far in the running move.
+  */
+static uint32_t Step_Done(Step_Axis_t axis)
+{
+	const Step_Def_t *d = &step_def[axis];
+	Step_Axis_Data_t *s = &step_axis[axis];
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t done = s->seg_base;
+	if (s->seg_index < s->seg_count)
+		done += s->seg_load - d->stream->NDTR;
+
+	__set_PRIMASK(primask);
+	return (done > s->total) ? s->total : done;
+}
+
+/**
+  * @brief	Integer square root (floor).
+  */
+static uint32_t Step_Isqrt(uint64_t x)
+{
+	uint64_t r = 0, bit = 1ULL << 62;
+
+	while (bit > x)
+		bit >>= 2;
+	while (bit)
+	{
+		if (x >= r + bit)
+		{
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else
+		{
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)r;
+}
+
+/**
+  * @brief	ARR value for a step rate, clamped to the 16-bit range.
+  */
+static uint16_t Step_Arr(uint32_t rate_hz)
+{
+	uint32_t arr = STEP_TICK_HZ / (rate_hz ? rate_hz : 1U) - 1U;
+
+	if (arr < STEP_ARR_MIN)
+		arr = STEP_ARR_MIN;
+	if (arr > 0xFFFFU)
+		arr = 0xFFFFU;
+	return (uint16_t)arr;
+}
+
+/** @brief	X axis (TIM3_UP) segment end. */
+void DMA1_Stream2_IRQHandler(void) { Step_DMA_IRQHandler(STEP_AXIS_X); }
+/** @brief	Y axis (TIM4_UP) segment end. */
+void DMA1_Stream6_IRQHandler(void) { Step_DMA_IRQHandler(STEP_AXIS_Y); }
+/** @brief	Z axis (TIM1_UP) segment end. */
+void DMA2_Stream5_IRQHandler(void) { Step_DMA_IRQHandler(STEP_AXIS_Z); }
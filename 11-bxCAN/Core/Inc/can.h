@@ -0,0 +1,218 @@
+/**
+  * @file	can.h
+  * @author	Parham Estiri
+  * @brief	bxCAN driver for CAN1 and CAN2 with filter-bank planning and
+  * 		interrupt-driven mailbox rings.
+  *
+  * 		This module provides:
+  * 		 - Bit timing computed from the APB1 clock (RCC_CFGR.PPRE1) for a
+  * 		   requested bit rate and sample point
+  * 		 - Filter-bank planning from a list of accepted identifiers: IDs
+  * 		   that differ in a few bits are merged into exact mask entries,
+  * 		   single IDs go to list banks, and each bank uses the 16- or
+  * 		   32-bit scale that holds the most entries; the 28 banks are
+  * 		   split between CAN1 and CAN2 with CAN2SB
+  * 		 - FIFO0/FIFO1 receive interrupts that drain the hardware FIFOs
+  * 		   into lock-free single-producer single-consumer rings
+  * 		 - Transmission through the three mailboxes in identifier order:
+  * 		   queued frames wait in a priority heap, and a mailbox holding a
+  * 		   lower-priority frame is aborted and requeued when a more urgent
+  * 		   frame arrives (no priority inversion)
+  * 		 - Normal, loopback, silent and silent-loopback modes
+  *
+  * 		| Controller | TX         | RX         | Interrupts                  |
+  * 		|------------|------------|------------|-----------------------------|
+  * 		| CAN1       | PD1  AF9   | PD0  AF9   | CAN1_TX, CAN1_RX0/1, SCE    |
+  * 		| CAN2       | PB13 AF9   | PB12 AF9   | CAN2_TX, CAN2_RX0/1, SCE    |
+  *
+  * @note	CAN2 is a slave of CAN1: it needs the CAN1 clock, and its filter
+  * 		banks live in the CAN1 registers. Configure the filters with
+  * 		Can_SetFilters() once, after Can_Init() of both controllers.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef CAN_H_
+#define CAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define CAN_RX_RING				64U			/**< Frames per receive ring (power of two)		*/
+#define CAN_TX_QUEUE			32U			/**< Frames waiting for a mailbox				*/
+#define CAN_FILTER_BANKS		28U			/**< Banks shared by CAN1 and CAN2				*/
+#define CAN_ACCEPT_MAX			64U			/**< Accepted IDs per controller				*/
+#define CAN_INIT_TIMEOUT		1000000UL	/**< Mode-change polling limit (loop passes)	*/
+#define CAN_RX_PRIORITY			0x02U		/**< FIFO drain: before the FIFO (3 frames) fills */
+#define CAN_TX_PRIORITY			0x03U		/**< Mailbox refill								*/
+#define CAN_SCE_PRIORITY		0x04U		/**< Error and bus-off reporting				*/
+
+#define CAN_STD_MAX				0x7FFUL		/**< Largest 11-bit identifier					*/
+#define CAN_EXT_MAX				0x1FFFFFFFUL/**< Largest 29-bit identifier					*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Controllers.
+  */
+typedef enum {
+	CAN_PORT_1		= 0,	/**< CAN1 (master, owns the filter banks)	*/
+	CAN_PORT_2		= 1,	/**< CAN2 (slave)							*/
+	CAN_PORTS		= 2
+} Can_Port_t;
+
+/**
+  * @brief	Operating modes (BTR.LBKM / BTR.SILM).
+  */
+typedef enum {
+	CAN_MODE_NORMAL				= 0,	/**< Bus operation								*/
+	CAN_MODE_LOOPBACK			= 1,	/**< TX looped to RX, still driven on CANTX		*/
+	CAN_MODE_SILENT				= 2,	/**< Listen only, never drives the bus			*/
+	CAN_MODE_SILENT_LOOPBACK	= 3		/**< Self-test without any bus or transceiver	*/
+} Can_Mode_t;
+
+/**
+  * @brief	Driver status codes.
+  */
+typedef enum {
+	CAN_OK			= 0,	/**< Success										*/
+	CAN_EINVAL		= 1,	/**< No bit timing or parameter out of range		*/
+	CAN_ETIMEOUT	= 2,	/**< Controller did not change mode					*/
+	CAN_EFULL		= 3,	/**< Transmit queue full							*/
+	CAN_ENOBANK		= 4		/**< Accepted IDs need more than 28 filter banks	*/
+} Can_Status_t;
+
+/**
+  * @brief	Controller configuration.
+  */
+typedef struct {
+	uint32_t	bitrate;		/**< Bit rate (bit/s), e.g. 500000				*/
+	uint16_t	sample_point;	/**< Sample point in per mille, e.g. 875		*/
+	uint8_t		sjw;			/**< Resynchronization jump width (1..4 tq)		*/
+	Can_Mode_t	mode;			/**< Operating mode								*/
+} Can_Config_t;
+
+/**
+  * @brief	Bit timing actually programmed.
+  */
+typedef struct {
+	uint32_t	prescaler;		/**< BRP + 1									*/
+	uint32_t	tq_per_bit;		/**< 1 + TS1 + TS2								*/
+	uint32_t	ts1;			/**< Time segment 1 (tq)						*/
+	uint32_t	ts2;			/**< Time segment 2 (tq)						*/
+	uint32_t	sample_point;	/**< Achieved sample point (per mille)			*/
+} Can_Timing_t;
+
+/**
+  * @brief	CAN frame (data frames and remote frames).
+  */
+typedef struct {
+	uint32_t	id;				/**< 11- or 29-bit identifier					*/
+	uint8_t		ide;			/**< 1: extended identifier						*/
+	uint8_t		rtr;			/**< 1: remote frame							*/
+	uint8_t		dlc;			/**< Data length (0..8)							*/
+	uint8_t		fmi;			/**< RX: filter match index; TX: unused			*/
+	uint16_t	time;			/**< RX: 16-bit timestamp (TTCM); TX: unused	*/
+	uint8_t		data[8];		/**< Payload									*/
+} Can_Frame_t;
+
+/**
+  * @brief	Accepted identifier.
+  */
+typedef struct {
+	uint32_t	id;				/**< 11- or 29-bit identifier					*/
+	uint8_t		ide;			/**< 1: extended identifier						*/
+	uint8_t		fifo;			/**< Receive FIFO (0 or 1)						*/
+} Can_Accept_t;
+
+/**
+  * @brief	Filter-bank plan summary.
+  */
+typedef struct {
+	uint32_t	banks[CAN_PORTS];	/**< Banks used per controller				*/
+	uint32_t	entries[CAN_PORTS];	/**< Filter entries after merging			*/
+	uint32_t	masks[CAN_PORTS];	/**< Entries that needed mask mode			*/
+} Can_FilterInfo_t;
+
+/**
+  * @brief	Controller statistics.
+  */
+typedef struct {
+	uint32_t	tx_ok;			/**< Frames sent								*/
+	uint32_t	tx_err;			/**< Mailboxes completed without success		*/
+	uint32_t	tx_preempt;		/**< Mailboxes aborted for a higher priority	*/
+	uint32_t	rx[2];			/**< Frames received per FIFO					*/
+	uint32_t	rx_drop[2];		/**< Frames dropped: software ring full			*/
+	uint32_t	rx_overrun[2];	/**< Frames lost in hardware (FOVR)				*/
+	uint32_t	bus_off;		/**< Bus-off events								*/
+	uint32_t	esr;			/**< Last error status register					*/
+} Can_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure a controller and its pins, then join the bus.
+  * @param[in] port		Controller.
+  * @param[in] config	Bit rate, sample point, SJW and mode.
+  * @param[out] timing	Bit timing actually programmed (may be NULL).
+  * @retval	CAN_OK, CAN_EINVAL (no exact bit timing) or CAN_ETIMEOUT.
+  * @note	No frame is received until Can_SetFilters() is called.
+  */
+Can_Status_t Can_Init(Can_Port_t port, const Can_Config_t *config, Can_Timing_t *timing);
+
+/**
+  * @brief	Program the 28 filter banks from lists of accepted identifiers.
+  * @param[in] accept1	IDs accepted by CAN1.
+  * @param[in] count1	Entries in accept1 (up to CAN_ACCEPT_MAX).
+  * @param[in] accept2	IDs accepted by CAN2 (may be NULL).
+  * @param[in] count2	Entries in accept2 (up to CAN_ACCEPT_MAX).
+  * @param[out] info	Plan summary (may be NULL).
+  * @retval	CAN_OK, CAN_EINVAL or CAN_ENOBANK (nothing changed).
+  * @note	Matching is exact: a frame is accepted only if its ID is listed.
+  */
+Can_Status_t Can_SetFilters(const Can_Accept_t *accept1, uint32_t count1,
+							const Can_Accept_t *accept2, uint32_t count2,
+							Can_FilterInfo_t *info);
+
+/**
+  * @brief	Queue a frame for transmission (highest priority sent first).
+  * @param[in] port		Controller.
+  * @param[in] frame	Frame to send.
+  * @retval	CAN_OK, CAN_EINVAL or CAN_EFULL.
+  */
+Can_Status_t Can_Transmit(Can_Port_t port, const Can_Frame_t *frame);
+
+/**
+  * @brief	Take the oldest received frame of a FIFO.
+  * @param[in] port		Controller.
+  * @param[in] fifo		Receive FIFO (0 or 1).
+  * @param[out] frame	Received frame.
+  * @retval	1 if a frame was returned, 0 if the ring is empty or port/fifo is out of range.
+  * @note	One reader per ring (the main loop); the producer is the interrupt.
+  */
+uint8_t Can_Receive(Can_Port_t port, uint32_t fifo, Can_Frame_t *frame);
+
+/**
+  * @brief	Number of frames still queued or in the mailboxes.
+  * @param[in] port		Controller.
+  * @retval	Pending frames, 0 for a port out of range.
+  */
+uint32_t Can_TxPending(Can_Port_t port);
+
+/**
+  * @brief	Copy the controller statistics.
+  * @param[in] port		Controller.
+  * @param[out] stats	Statistics.
+  * @retval	CAN_OK or CAN_EINVAL (stats unchanged).
+  */
+Can_Status_t Can_GetStats(Can_Port_t port, Can_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CAN_H_ */
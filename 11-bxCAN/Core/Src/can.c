@@ -0,0 +1,952 @@
+/**
+  * @file	can.c
+  * @author	Parham Estiri
+  * @brief	bxCAN driver for CAN1 and CAN2 with filter-bank planning and
+  * 		interrupt-driven mailbox rings.
+  *
+  * 		This file provides:
+  * 		 - Controller table (registers, pins, interrupts) and initialization
+  * 		 - Bit-timing search over 8..25 time quanta per bit
+  * 		 - Filter planning: exact mask merging, then bank packing that picks
+  * 		   list or mask mode and 16- or 32-bit scale per bank
+  * 		 - Receive rings filled by the FIFO0/FIFO1 interrupts
+  * 		 - Transmit priority heap feeding the three mailboxes
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "can.h"
+
+#define CAN_RX_RING_MASK	(CAN_RX_RING - 1UL)
+#define CAN_MAILBOXES		3U
+#define CAN_RX_FIFOS		2U
+#define CAN_TQ_MIN			8U				/**< 1 + TS1 (>= 1) + TS2 (>= 1), room for the SP	*/
+#define CAN_TQ_MAX			25U				/**< 1 + 16 + 8										*/
+#define CAN_BRP_MAX			1024U
+#define CAN_TS1_MAX			16U
+#define CAN_TS2_MAX			8U
+#define CAN_SJW_MAX			4U
+
+/* Filter register layout (RM0090, 32.7.4) */
+#define CAN_F16_STD(id)		((uint32_t)(id) << 5)			/**< STID[10:0] RTR IDE EXID[17:15]	*/
+#define CAN_F16_MASK_ALL	((1UL << 4) | (1UL << 3))		/**< RTR and IDE must match			*/
+#define CAN_F32_STD(id)		((uint32_t)(id) << 21)			/**< STID[10:0] EXID[17:0] IDE RTR 0	*/
+#define CAN_F32_EXT(id)		(((uint32_t)(id) << 3) | (1UL << 2))
+#define CAN_F32_MASK_ALL	((1UL << 2) | (1UL << 1))
+
+/**
+  * @brief	Static description of a controller.
+  */
+typedef struct {
+	CAN_TypeDef		*can;			/**< Controller instance					*/
+	GPIO_TypeDef	*port;			/**< TX/RX pin port							*/
+	uint32_t		tx_pin;			/**< CANx_TX pin number						*/
+	uint32_t		rx_pin;			/**< CANx_RX pin number						*/
+	uint32_t		gpio_en;		/**< RCC_AHB1ENR port clock bit				*/
+	uint32_t		can_en;			/**< RCC_APB1ENR controller clock bits		*/
+	IRQn_Type		tx_irq;
+	IRQn_Type		rx0_irq;
+	IRQn_Type		rx1_irq;
+	IRQn_Type		sce_irq;
+} Can_Def_t;
+
+/**
+  * @brief	Queued transmit frame.
+  */
+typedef struct {
+	uint32_t	key;				/**< Arbitration order (lower wins)			*/
+	uint32_t	seq;				/**< Queue order among equal keys			*/
+	Can_Frame_t	frame;
+} Can_TxEntry_t;
+
+/**
+  * @brief	Run-time state of a controller.
+  */
+typedef struct {
+	Can_Frame_t			rx[CAN_RX_FIFOS][CAN_RX_RING];		/**< Receive rings per FIFO				*/
+	volatile uint32_t	rx_head[CAN_RX_FIFOS];				/**< Written by the interrupt only		*/
+	volatile uint32_t	rx_tail[CAN_RX_FIFOS];				/**< Written by Can_Receive() only		*/
+	Can_TxEntry_t		heap[CAN_TX_QUEUE + CAN_MAILBOXES];	/**< Min-heap on (key, seq)	*/
+	uint32_t			heap_len;
+	uint32_t			seq;					/**< Next queue sequence number			*/
+	Can_TxEntry_t		mb[CAN_MAILBOXES];		/**< Copy of each mailbox's frame		*/
+	uint8_t				mb_busy[CAN_MAILBOXES];	/**< Mailbox holds a pending frame		*/
+	uint8_t				mb_abort[CAN_MAILBOXES];/**< Abort requested for a preemption	*/
+	Can_Stats_t			stats;
+} Can_State_t;
+
+/**
+  * @brief	Filter entry: IDs matching `id` on every `care` bit.
+  */
+typedef struct {
+	uint32_t	id;					/**< Don't-care bits cleared				*/
+	uint32_t	care;				/**< Bits compared by the filter			*/
+	uint8_t		ide;
+	uint8_t		fifo;
+} Can_Entry_t;
+
+/** @brief	Controllers (see the table in can.h). */
+static const Can_Def_t can_def[CAN_PORTS] = {
+		[CAN_PORT_1] = { CAN1, GPIOD,  1,  0, RCC_AHB1ENR_GPIODEN, RCC_APB1ENR_CAN1EN,
+						 CAN1_TX_IRQn, CAN1_RX0_IRQn, CAN1_RX1_IRQn, CAN1_SCE_IRQn },
+		[CAN_PORT_2] = { CAN2, GPIOB, 13, 12, RCC_AHB1ENR_GPIOBEN, RCC_APB1ENR_CAN1EN | RCC_APB1ENR_CAN2EN,
+						 CAN2_TX_IRQn, CAN2_RX0_IRQn, CAN2_RX1_IRQn, CAN2_SCE_IRQn }
+};
+
+static Can_State_t can_state[CAN_PORTS];					/**< Rings, queues, statistics			*/
+static Can_Entry_t can_entry[CAN_PORTS][CAN_ACCEPT_MAX];	/**< Filter planning scratch			*/
+
+/**************************  Static Function Prototypes  ***************************/
+static Can_Status_t Can_Timing(uint32_t clk, const Can_Config_t *config, Can_Timing_t *timing);
+static uint8_t Can_WaitAck(const CAN_TypeDef *can, uint32_t set);
+static uint32_t Can_Key(const Can_Frame_t *frame);
+static uint8_t Can_Before(const Can_TxEntry_t *a, const Can_TxEntry_t *b);
+static void Can_HeapPush(Can_State_t *st, const Can_TxEntry_t *entry);
+static void Can_HeapPop(Can_State_t *st, Can_TxEntry_t *entry);
+static void Can_TxPump(Can_Port_t port);
+static void Can_TX_IRQHandler(Can_Port_t port);
+static void Can_RX_IRQHandler(Can_Port_t port, uint32_t fifo);
+static void Can_SCE_IRQHandler(Can_Port_t port);
+static uint32_t Can_Merge(Can_Entry_t *entry, uint32_t count);
+static uint32_t Can_Pack(const Can_Entry_t *entry, uint32_t count, uint32_t bank, uint8_t write);
+static void Can_Bank_Write(uint32_t bank, uint8_t list, uint8_t scale32, uint32_t fifo, uint32_t fr1, uint32_t fr2);
+
+/**
+  * @brief	Configure a controller and its pins, then join the bus.
+  * @param[in] port		Controller.
+  * @param[in] config	Bit rate, sample point, SJW and mode.
+  * @param[out] timing	Bit timing actually programmed (may be NULL).
+  * @retval	CAN_OK, CAN_EINVAL (no exact bit timing) or CAN_ETIMEOUT.
+  */
+Can_Status_t Can_Init(Can_Port_t port, const Can_Config_t *config, Can_Timing_t *timing)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+	Can_Timing_t t;
+
+	if (port >= CAN_PORTS || config->mode > CAN_MODE_SILENT_LOOPBACK)
+		return CAN_EINVAL;
+
+	const Can_Def_t *d = &can_def[port];
+	Can_State_t *st = &can_state[port];
+
+	/* APB1 clock = HCLK >> PPRE1 (42 MHz with RCC_CFGR_PPRE1_DIV4) */
+	const uint32_t apb1 = SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+	if (Can_Timing(apb1, config, &t) != CAN_OK)
+		return CAN_EINVAL;
+
+	uint32_t sjw = config->sjw;						/**< 1 .. min(4, TS2)						*/
+	if (sjw < 1U)			sjw = 1U;
+	if (sjw > CAN_SJW_MAX)	sjw = CAN_SJW_MAX;
+	if (sjw > t.ts2)		sjw = t.ts2;
+
+	RCC->AHB1ENR |= d->gpio_en;
+	RCC->APB1ENR |= d->can_en;						/**< CAN2 also needs the CAN1 clock			*/
+
+	/* TX: AF9 push-pull, high speed; RX: AF9 with pull-up (recessive when unconnected) */
+	d->port->MODER   = (d->port->MODER & ~((3UL << (d->tx_pin * 2)) | (3UL << (d->rx_pin * 2))))
+					 | (2UL << (d->tx_pin * 2)) | (2UL << (d->rx_pin * 2));
+	d->port->OTYPER &= ~(1UL << d->tx_pin);
+	d->port->OSPEEDR |= 3UL << (d->tx_pin * 2);
+	d->port->PUPDR   = (d->port->PUPDR & ~((3UL << (d->tx_pin * 2)) | (3UL << (d->rx_pin * 2))))
+					 | (1UL << (d->rx_pin * 2));
+	d->port->AFR[d->tx_pin >> 3] = (d->port->AFR[d->tx_pin >> 3] & ~(0xFUL << ((d->tx_pin & 7U) * 4)))
+								 | (9UL << ((d->tx_pin & 7U) * 4));
+	d->port->AFR[d->rx_pin >> 3] = (d->port->AFR[d->rx_pin >> 3] & ~(0xFUL << ((d->rx_pin & 7U) * 4)))
+								 | (9UL << ((d->rx_pin & 7U) * 4));
+
+	/* Leave sleep, enter initialization */
+	d->can->MCR = CAN_MCR_INRQ;
+	if (!Can_WaitAck(d->can, 1))
+		return CAN_ETIMEOUT;
+
+	d->can->MCR = CAN_MCR_INRQ
+				| CAN_MCR_ABOM						/**< Leave bus-off automatically			*/
+				| CAN_MCR_RFLM						/**< Full FIFO keeps the oldest frames		*/
+				| CAN_MCR_TTCM;						/**< 16-bit bit-time stamp on reception		*/
+	d->can->BTR = ((uint32_t)config->mode << CAN_BTR_LBKM_Pos)	/**< LBKM = bit 30, SILM = bit 31	*/
+				| ((sjw - 1U) << CAN_BTR_SJW_Pos)
+				| ((t.ts2 - 1U) << CAN_BTR_TS2_Pos)
+				| ((t.ts1 - 1U) << CAN_BTR_TS1_Pos)
+				| ((t.prescaler - 1U) << CAN_BTR_BRP_Pos);
+
+	/* Software state */
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	st->rx_head[0] = st->rx_tail[0] = 0;
+	st->rx_head[1] = st->rx_tail[1] = 0;
+	st->heap_len = 0;
+	for (uint32_t m = 0; m < CAN_MAILBOXES; m++)
+	{
+		st->mb_busy[m]  = 0;
+		st->mb_abort[m] = 0;
+	}
+	st->stats = (Can_Stats_t){ 0 };
+	__set_PRIMASK(primask);
+
+	d->can->IER = CAN_IER_TMEIE						/**< Mailbox completed (RQCPx)				*/
+				| CAN_IER_FMPIE0 | CAN_IER_FOVIE0	/**< FIFO0 pending / overrun				*/
+				| CAN_IER_FMPIE1 | CAN_IER_FOVIE1	/**< FIFO1 pending / overrun				*/
+				| CAN_IER_ERRIE | CAN_IER_BOFIE | CAN_IER_EPVIE;
+
+	NVIC_SetPriority(d->rx0_irq, NVIC_EncodePriority(PG, CAN_RX_PRIORITY, 0));
+	NVIC_SetPriority(d->rx1_irq, NVIC_EncodePriority(PG, CAN_RX_PRIORITY, 0));
+	NVIC_SetPriority(d->tx_irq,  NVIC_EncodePriority(PG, CAN_TX_PRIORITY, 0));
+	NVIC_SetPriority(d->sce_irq, NVIC_EncodePriority(PG, CAN_SCE_PRIORITY, 0));
+	NVIC_EnableIRQ(d->rx0_irq);
+	NVIC_EnableIRQ(d->rx1_irq);
+	NVIC_EnableIRQ(d->tx_irq);
+	NVIC_EnableIRQ(d->sce_irq);
+
+	/* Join the bus: waits for 11 recessive bits on CANRX (internal in loopback) */
+	d->can->MCR &= ~CAN_MCR_INRQ;
+	if (!Can_WaitAck(d->can, 0))
+		return CAN_ETIMEOUT;
+
+	if (timing)
+		*timing = t;
+
+	return CAN_OK;
+}
+
+/**
+  * @brief	Program the 28 filter banks from lists of accepted identifiers.
+  * @param[in] accept1	IDs accepted by CAN1.
+  * @param[in] count1	Entries in accept1 (up to CAN_ACCEPT_MAX).
+  * @param[in] accept2	IDs accepted by CAN2 (may be NULL).
+  * @param[in] count2	Entries in accept2 (up to CAN_ACCEPT_MAX).
+  * @param[out] info	Plan summary (may be NULL).
+  * @retval	CAN_OK, CAN_EINVAL or CAN_ENOBANK (nothing changed).
+  */
+Can_Status_t Can_SetFilters(const Can_Accept_t *accept1, uint32_t count1,
+							const Can_Accept_t *accept2, uint32_t count2,
+							Can_FilterInfo_t *info)
+{
+	const Can_Accept_t *accept[CAN_PORTS] = { accept1, accept2 };
+	const uint32_t count[CAN_PORTS] = { count1, count2 };
+	uint32_t entries[CAN_PORTS], banks[CAN_PORTS];
+
+	for (uint32_t p = 0; p < CAN_PORTS; p++)
+	{
+		if (count[p] > CAN_ACCEPT_MAX || (count[p] && !accept[p]))
+			return CAN_EINVAL;
+
+		for (uint32_t i = 0; i < count[p]; i++)
+		{
+			const Can_Accept_t *a = &accept[p][i];
+			const uint32_t width = a->ide ? CAN_EXT_MAX : CAN_STD_MAX;
+
+			if (a->id > width || a->fifo > 1U)
+				return CAN_EINVAL;
+			can_entry[p][i] = (Can_Entry_t){ a->id, width, a->ide ? 1U : 0U, a->fifo };
+		}
+		entries[p] = Can_Merge(can_entry[p], count[p]);
+		banks[p]   = Can_Pack(can_entry[p], entries[p], 0, 0);
+	}
+
+	/* CAN2SB is 1..27: each controller keeps at least one bank */
+	const uint32_t start2 = banks[0] ? banks[0] : 1U;
+	if (start2 > CAN_FILTER_BANKS - 1U || start2 + banks[1] > CAN_FILTER_BANKS)
+		return CAN_ENOBANK;
+
+	RCC->APB1ENR |= RCC_APB1ENR_CAN1EN;				/**< Filter banks live in CAN1				*/
+
+	CAN1->FMR |= CAN_FMR_FINIT;						/**< Filter initialization mode				*/
+	CAN1->FA1R = 0;									/**< Deactivate every bank					*/
+	CAN1->FMR  = (CAN1->FMR & ~CAN_FMR_CAN2SB) | (start2 << CAN_FMR_CAN2SB_Pos) | CAN_FMR_FINIT;
+	Can_Pack(can_entry[CAN_PORT_1], entries[CAN_PORT_1], 0, 1);
+	Can_Pack(can_entry[CAN_PORT_2], entries[CAN_PORT_2], start2, 1);
+	CAN1->FMR &= ~CAN_FMR_FINIT;					/**< Filters active							*/
+
+	if (info)
+	{
+		for (uint32_t p = 0; p < CAN_PORTS; p++)
+		{
+			info->banks[p]   = banks[p];
+			info->entries[p] = entries[p];
+			info->masks[p]   = 0;
+			for (uint32_t i = 0; i < entries[p]; i++)
+				info->masks[p] += can_entry[p][i].care != (can_entry[p][i].ide ? CAN_EXT_MAX : CAN_STD_MAX);
+		}
+	}
+
+	return CAN_OK;
+}
+
+/**
+  * @brief	Queue a frame for transmission (highest priority sent first).
+  * @param[in] port		Controller.
+  * @param[in] frame	Frame to send.
+  * @retval	CAN_OK, CAN_EINVAL or CAN_EFULL.
+  */
+Can_Status_t Can_Transmit(Can_Port_t port, const Can_Frame_t *frame)
+{
+	Can_State_t *st = &can_state[port];
+	Can_Status_t status = CAN_OK;
+
+	if (port >= CAN_PORTS || frame->dlc > 8U || frame->id > (frame->ide ? CAN_EXT_MAX : CAN_STD_MAX))
+		return CAN_EINVAL;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (st->heap_len >= CAN_TX_QUEUE)
+		status = CAN_EFULL;							/**< Extra slots are kept for preemptions	*/
+	else
+	{
+		Can_TxEntry_t e = { Can_Key(frame), st->seq++, *frame };
+		Can_HeapPush(st, &e);
+		Can_TxPump(port);
+	}
+
+	__set_PRIMASK(primask);
+	return status;
+}
+
+/**
+  * @brief	Take the oldest received frame of a FIFO.
+  * @param[in] port		Controller.
+  * @param[in] fifo		Receive FIFO (0 or 1).
+  * @param[out] frame	Received frame.
+  * @retval	1 if a frame was returned, 0 if the ring is empty or port/fifo is out of range.
+  */
+uint8_t Can_Receive(Can_Port_t port, uint32_t fifo, Can_Frame_t *frame)
+{
+	if (port >= CAN_PORTS || fifo >= CAN_RX_FIFOS)
+		return 0;
+
+	Can_State_t *st = &can_state[port];
+	const uint32_t tail = st->rx_tail[fifo];
+
+	if (tail == st->rx_head[fifo])
+		return 0;
+
+	*frame = st->rx[fifo][tail & CAN_RX_RING_MASK];
+	__DMB();										/**< Copy done before the slot is released	*/
+	st->rx_tail[fifo] = tail + 1U;
+	return 1;
+}
+
+/**
+  * @brief	Number of frames still queued or in the mailboxes.
+  * @param[in] port		Controller.
+  * @retval	Pending frames, 0 for a port out of range.
+  */
+uint32_t Can_TxPending(Can_Port_t port)
+{
+	if (port >= CAN_PORTS)
+		return 0;
+
+	const Can_State_t *st = &can_state[port];
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t n = st->heap_len + st->mb_busy[0] + st->mb_busy[1] + st->mb_busy[2];
+	__set_PRIMASK(primask);
+	return n;
+}
+
+/**
+  * @brief	Copy the controller statistics.
+  * @param[in] port		Controller.
+  * @param[out] stats	Statistics.
+  * @retval	CAN_OK or CAN_EINVAL (stats unchanged).
+  */
+Can_Status_t Can_GetStats(Can_Port_t port, Can_Stats_t *stats)
+{
+	if (port >= CAN_PORTS)
+		return CAN_EINVAL;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	*stats = can_state[port].stats;
+	__set_PRIMASK(primask);
+	return CAN_OK;
+}
+
+/**
+  * @brief	Find the bit timing closest to the requested sample point.
+  *
+  * 		Tries every bit length from 25 down to 8 time quanta whose
+  * 		prescaler divides the APB1 clock exactly, so the bit rate has no
+  * 		error. Longer bits are preferred on ties (finer SJW resolution).
+  *
+  * @param[in] clk		APB1 clock (Hz).
+  * @param[in] config	Requested bit rate and sample point.
+  * @param[out] timing	Selected timing.
+  * @retval	CAN_OK or CAN_EINVAL.
+  */
+static Can_Status_t Can_Timing(uint32_t clk, const Can_Config_t *config, Can_Timing_t *timing)
+{
+	uint32_t best_err = 0xFFFFFFFFUL;
+
+	if (config->bitrate == 0U || config->bitrate > 1000000UL
+			|| config->sample_point < 500U || config->sample_point > 950U)
+		return CAN_EINVAL;
+
+	for (uint32_t tq = CAN_TQ_MAX; tq >= CAN_TQ_MIN; tq--)
+	{
+		const uint32_t rate_tq = config->bitrate * tq;
+
+		if (clk % rate_tq)
+			continue;
+		const uint32_t brp = clk / rate_tq;
+		if (brp < 1U || brp > CAN_BRP_MAX)
+			continue;
+
+		/* Sample point = (1 + TS1) / tq */
+		int32_t ts1 = (int32_t)((tq * config->sample_point + 500U) / 1000U) - 1;
+		const int32_t ts1_min = ((int32_t)tq - 1 - (int32_t)CAN_TS2_MAX) > 1 ? (int32_t)tq - 1 - (int32_t)CAN_TS2_MAX : 1;
+		const int32_t ts1_max = ((int32_t)tq - 2) < (int32_t)CAN_TS1_MAX ? (int32_t)tq - 2 : (int32_t)CAN_TS1_MAX;
+		if (ts1 < ts1_min)	ts1 = ts1_min;
+		if (ts1 > ts1_max)	ts1 = ts1_max;
+
+		const uint32_t sp  = (uint32_t)(1 + ts1) * 1000U / tq;
+		const uint32_t err = sp > config->sample_point ? sp - config->sample_point : config->sample_point - sp;
+		if (err < best_err)
+		{
+			best_err = err;
+			*timing = (Can_Timing_t){ brp, tq, (uint32_t)ts1, tq - 1U - (uint32_t)ts1, sp };
+		}
+	}
+
+	return best_err == 0xFFFFFFFFUL ? CAN_EINVAL : CAN_OK;
+}
+
+/**
+  * @brief	Wait for MSR.INAK to reach a state.
+  * @param[in] can	Controller.
+  * @param[in] set	1: wait for initialization mode, 0: wait for normal mode.
+  * @retval	1 on success, 0 on timeout.
+  */
+static uint8_t Can_WaitAck(const CAN_TypeDef *can, uint32_t set)
+{
+	for (uint32_t n = 0; n < CAN_INIT_TIMEOUT; n++)
+	{
+		const uint32_t msr = can->MSR;
+		if (((msr & CAN_MSR_INAK) != 0U) == (set != 0U) && !(msr & CAN_MSR_SLAK))
+			return 1;
+	}
+	return 0;
+}
+
+/**
+  * @brief	Arbitration key: compares like the bus does (lower value wins).
+  *
+  * 		Bits 31..21 base ID, 20 RTR/SRR, 19 IDE, 18..1 extended ID, 0 RTR.
+  * 		A standard data frame beats a standard remote frame, which beats
+  * 		any extended frame with the same base ID.
+  *
+  * @param[in] frame	Frame.
+  * @retval	Key.
+  */
+static uint32_t Can_Key(const Can_Frame_t *frame)
+{
+	if (!frame->ide)
+		return (frame->id << 21) | ((frame->rtr ? 1UL : 0UL) << 20);
+
+	return ((frame->id >> 18) << 21) | (1UL << 20) | (1UL << 19)
+		 | ((frame->id & 0x3FFFFUL) << 1) | (frame->rtr ? 1UL : 0UL);
+}
+
+/**
+  * @brief	Heap order: key first, then queue order (frames with one ID stay in order).
+  */
+static uint8_t Can_Before(const Can_TxEntry_t *a, const Can_TxEntry_t *b)
+{
+	if (a->key != b->key)
+		return a->key < b->key;
+	return (int32_t)(a->seq - b->seq) < 0;
+}
+
+/**
+  * @brief	Insert an entry into the transmit heap.
+  */
+static void Can_HeapPush(Can_State_t *st, const Can_TxEntry_t *entry)
+{
+	uint32_t i = st->heap_len++;
+
+	while (i > 0U)
+	{
+		const uint32_t parent = (i - 1U) / 2U;
+		if (!Can_Before(entry, &st->heap[parent]))
+			break;
+		st->heap[i] = st->heap[parent];
+		i = parent;
+	}
+	st->heap[i] = *entry;
+}
+
+/**
+  * @brief	Remove the most urgent entry from the transmit heap (heap not empty).
+  */
+static void Can_HeapPop(Can_State_t *st, Can_TxEntry_t *entry)
+{
+	*entry = st->heap[0];
+
+	const Can_TxEntry_t last = st->heap[--st->heap_len];
+	const uint32_t n = st->heap_len;
+	uint32_t i = 0;
+
+	for (;;)
+	{
+		uint32_t child = 2U * i + 1U;
+		if (child >= n)
+			break;
+		if (child + 1U < n && Can_Before(&st->heap[child + 1U], &st->heap[child]))
+			child++;
+		if (!Can_Before(&st->heap[child], &last))
+			break;
+		st->heap[i] = st->heap[child];
+		i = child;
+	}
+	if (n)
+		st->heap[i] = last;
+}
+
+/**
+  * @brief	Move queued frames into free mailboxes, preempting if needed.
+  *
+  * 		With TXFP = 0 the controller sends the pending mailbox with the
+  * 		lowest identifier, so the mailboxes only need the most urgent
+  * 		frames. A frame is held back while a mailbox holds the same key,
+  * 		because equal identifiers leave in mailbox-number order, not queue
+  * 		order. When all three mailboxes are busy and the head of the queue
+  * 		beats one of them, the least urgent mailbox is aborted; its frame
+  * 		returns to the queue in the transmit interrupt.
+  *
+  * @param[in] port	Controller.
+  * @retval	None
+  * @note	Called with interrupts disabled or from the TX interrupt.
+  */
+static void Can_TxPump(Can_Port_t port)
+{
+	CAN_TypeDef *can = can_def[port].can;
+	Can_State_t *st = &can_state[port];
+
+	while (st->heap_len)
+	{
+		uint32_t free_mb = CAN_MAILBOXES, worst = CAN_MAILBOXES;
+		uint8_t aborting = 0;
+
+		for (uint32_t m = 0; m < CAN_MAILBOXES; m++)
+		{
+			if (!st->mb_busy[m])
+			{
+				if (free_mb == CAN_MAILBOXES)
+					free_mb = m;
+				continue;
+			}
+			if (st->mb[m].key == st->heap[0].key)
+				return;								/**< Same ID in flight: keep the order		*/
+			aborting |= st->mb_abort[m];
+			if (worst == CAN_MAILBOXES || Can_Before(&st->mb[worst], &st->mb[m]))
+				worst = m;
+		}
+
+		if (free_mb == CAN_MAILBOXES)
+		{
+			/* All busy: preempt the least urgent mailbox (one abort at a time) */
+			if (!aborting && Can_Before(&st->heap[0], &st->mb[worst]))
+			{
+				st->mb_abort[worst] = 1;
+				can->TSR = CAN_TSR_ABRQ0 << (8U * worst);
+				st->stats.tx_preempt++;
+			}
+			return;
+		}
+
+		Can_TxEntry_t *e = &st->mb[free_mb];
+		Can_HeapPop(st, e);
+
+		CAN_TxMailBox_TypeDef *mb = &can->sTxMailBox[free_mb];
+		const Can_Frame_t *f = &e->frame;
+		mb->TDTR = f->dlc;
+		mb->TDLR = (uint32_t)f->data[0] | ((uint32_t)f->data[1] << 8)
+				 | ((uint32_t)f->data[2] << 16) | ((uint32_t)f->data[3] << 24);
+		mb->TDHR = (uint32_t)f->data[4] | ((uint32_t)f->data[5] << 8)
+				 | ((uint32_t)f->data[6] << 16) | ((uint32_t)f->data[7] << 24);
+		mb->TIR  = (f->ide ? ((f->id << CAN_TI0R_EXID_Pos) | CAN_TI0R_IDE) : (f->id << CAN_TI0R_STID_Pos))
+				 | (f->rtr ? CAN_TI0R_RTR : 0U)
+				 | CAN_TI0R_TXRQ;					/**< Request transmission					*/
+		st->mb_busy[free_mb] = 1;
+	}
+}
+
+/**
+  * @brief	Transmit interrupt: account completed mailboxes and refill them.
+  * @param[in] port	Controller.
+  * @retval	None
+  */
+static void Can_TX_IRQHandler(Can_Port_t port)
+{
+	CAN_TypeDef *can = can_def[port].can;
+	Can_State_t *st = &can_state[port];
+	const uint32_t tsr = can->TSR;
+
+	for (uint32_t m = 0; m < CAN_MAILBOXES; m++)
+	{
+		const uint32_t rqcp = CAN_TSR_RQCP0 << (8U * m);
+
+		if (!(tsr & rqcp))
+			continue;
+		can->TSR = rqcp;							/**< Also clears TXOK, ALST, TERR			*/
+
+		if (tsr & (CAN_TSR_TXOK0 << (8U * m)))
+			st->stats.tx_ok++;						/**< Sent (the abort came too late)			*/
+		else if (st->mb_abort[m])
+			Can_HeapPush(st, &st->mb[m]);			/**< Preempted: back in the queue			*/
+		else
+			st->stats.tx_err++;
+
+		st->mb_busy[m]  = 0;
+		st->mb_abort[m] = 0;
+	}
+
+	Can_TxPump(port);
+}
+
+/**
+  * @brief	Receive interrupt: drain a hardware FIFO into its ring.
+  * @param[in] port	Controller.
+  * @param[in] fifo	Receive FIFO (0 or 1).
+  * @retval	None
+  */
+static void Can_RX_IRQHandler(Can_Port_t port, uint32_t fifo)
+{
+	CAN_TypeDef *can = can_def[port].can;
+	Can_State_t *st = &can_state[port];
+	volatile uint32_t *rfr = fifo ? &can->RF1R : &can->RF0R;
+	CAN_FIFOMailBox_TypeDef *mb = &can->sFIFOMailBox[fifo];
+	uint32_t head = st->rx_head[fifo];
+
+	while (*rfr & CAN_RF0R_FMP0)
+	{
+		const uint32_t rir  = mb->RIR;
+		const uint32_t rdtr = mb->RDTR;
+		const uint32_t rdlr = mb->RDLR;
+		const uint32_t rdhr = mb->RDHR;
+		*rfr = CAN_RF0R_RFOM0;						/**< Release the output mailbox				*/
+
+		if (head - st->rx_tail[fifo] >= CAN_RX_RING)
+		{
+			st->stats.rx_drop[fifo]++;
+			continue;
+		}
+
+		Can_Frame_t *f = &st->rx[fifo][head & CAN_RX_RING_MASK];
+		f->ide  = (rir & CAN_RI0R_IDE) ? 1U : 0U;
+		f->id   = f->ide ? (rir >> CAN_RI0R_EXID_Pos) : (rir >> CAN_RI0R_STID_Pos);
+		f->rtr  = (rir & CAN_RI0R_RTR) ? 1U : 0U;
+		f->dlc  = (uint8_t)(rdtr & CAN_RDT0R_DLC);
+		f->fmi  = (uint8_t)((rdtr & CAN_RDT0R_FMI) >> CAN_RDT0R_FMI_Pos);
+		f->time = (uint16_t)(rdtr >> CAN_RDT0R_TIME_Pos);
+		for (uint32_t i = 0; i < 4U; i++)
+		{
+			f->data[i]      = (uint8_t)(rdlr >> (8U * i));
+			f->data[i + 4U] = (uint8_t)(rdhr >> (8U * i));
+		}
+		head++;
+		st->stats.rx[fifo]++;
+	}
+
+	if (*rfr & CAN_RF0R_FOVR0)
+	{
+		*rfr = CAN_RF0R_FOVR0;
+		st->stats.rx_overrun[fifo]++;				/**< At least one frame lost in hardware	*/
+	}
+
+	__DMB();										/**< Frames written before they are published */
+	st->rx_head[fifo] = head;
+}
+
+/**
+  * @brief	Status-change interrupt: record bus-off and error-passive events.
+  * @param[in] port	Controller.
+  * @retval	None
+  */
+static void Can_SCE_IRQHandler(Can_Port_t port)
+{
+	CAN_TypeDef *can = can_def[port].can;
+	Can_State_t *st = &can_state[port];
+	const uint32_t esr = can->ESR;
+
+	st->stats.esr = esr;
+	if (esr & CAN_ESR_BOFF)
+		st->stats.bus_off++;						/**< ABOM recovers after 128 x 11 recessive bits */
+
+	can->MSR = CAN_MSR_ERRI;
+}
+
+/**
+  * @brief	Merge entries that differ in one compared bit into mask entries.
+  *
+  * 		Repeats until no pair merges (same FIFO, ID type and mask, IDs
+  * 		differing in exactly one compared bit): {0x100, 0x101} becomes
+  * 		0x100/0x7FE, and sixteen consecutive aligned IDs become one entry.
+  * 		Every merge is exact, so no extra ID is accepted. Duplicates are
+  * 		removed on the way.
+  *
+  * @param[in,out] entry	Entries.
+  * @param[in] count		Number of entries.
+  * @retval	Number of entries left.
+  */
+static uint32_t Can_Merge(Can_Entry_t *entry, uint32_t count)
+{
+	uint8_t merged;
+
+	do
+	{
+		merged = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			for (uint32_t j = i + 1U; j < count; )
+			{
+				const uint32_t diff = entry[i].id ^ entry[j].id;
+
+				if (entry[i].ide != entry[j].ide || entry[i].fifo != entry[j].fifo
+						|| entry[i].care != entry[j].care || (diff & (diff - 1U)))
+				{
+					j++;
+					continue;
+				}
+
+				entry[i].care &= ~diff;				/**< diff == 0: duplicate, nothing changes	*/
+				entry[i].id   &= ~diff;
+				entry[j] = entry[--count];			/**< Re-examine the entry moved into j		*/
+				merged |= diff != 0U;
+			}
+		}
+	} while (merged);
+
+	return count;
+}
+
+/**
+  * @brief	Pack filter entries into banks, per FIFO, with the fewest banks.
+  *
+  * 		Bank capacity by mode and scale:
+  * 		| Entries            | Bank                | Per bank |
+  * 		|--------------------|---------------------|----------|
+  * 		| Standard, single   | 16-bit list         | 4        |
+  * 		| Standard, masked   | 16-bit mask         | 2        |
+  * 		| Extended, single   | 32-bit list         | 2        |
+  * 		| Extended, masked   | 32-bit mask         | 1        |
+  *
+  * 		Leftover slots are shared: k standard singles can fill a 16-bit mask
+  * 		bank (mask = all ones) and one can fill the free half of a 32-bit
+  * 		list bank. Every split is tried and the cheapest one is used. Unused
+  * 		slots repeat an entry of the same bank.
+  *
+  * @param[in] entry	Merged entries.
+  * @param[in] count	Number of entries.
+  * @param[in] bank		First bank.
+  * @param[in] write	0: only count the banks, 1: program them (FINIT set).
+  * @retval	Number of banks used.
+  */
+static uint32_t Can_Pack(const Can_Entry_t *entry, uint32_t count, uint32_t bank, uint8_t write)
+{
+	const uint32_t first = bank;
+
+	for (uint32_t fifo = 0; fifo < 2U; fifo++)
+	{
+		uint32_t sl = 0, sm = 0, el = 0, em = 0;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const Can_Entry_t *e = &entry[i];
+			if (e->fifo != fifo)
+				continue;
+			if (!e->ide && e->care == CAN_STD_MAX)
+				sl++;
+			else if (!e->ide)
+				sm++;
+			else if (e->care == CAN_EXT_MAX)
+				el++;
+			else
+				em++;
+		}
+
+		/* k singles into 16-bit mask banks, f (0/1) single into a 32-bit list bank */
+		uint32_t best_k = 0, best_f = 0, best = 0xFFFFFFFFUL;
+		for (uint32_t f = 0; f <= ((el & 1U) && sl ? 1U : 0U); f++)
+		{
+			for (uint32_t k = 0; k + f <= sl; k++)
+			{
+				const uint32_t cost = (sm + k + 1U) / 2U + (sl - k - f + 3U) / 4U + (el + f + 1U) / 2U + em;
+				if (cost < best)
+				{
+					best = cost;
+					best_k = k;
+					best_f = f;
+				}
+			}
+		}
+		if (!write)
+		{
+			bank += best;
+			continue;
+		}
+
+		/* Emit: one pass per bank type, slots filled in entry order */
+		uint32_t slot[4], n = 0, singles = 0;
+
+		for (uint32_t type = 0; type < 4U; type++)
+		{
+			for (uint32_t i = 0; i <= count; i++)
+			{
+				if (i < count)
+				{
+					const Can_Entry_t *e = &entry[i];
+					uint32_t v;
+					uint8_t take = 0;
+
+					if (e->fifo != fifo)
+						continue;
+					const uint8_t single = e->care == (e->ide ? CAN_EXT_MAX : CAN_STD_MAX);
+					uint32_t rank = 0;						/**< Standard single: 0..sl-1			*/
+					if (!e->ide && single)
+						rank = singles++;
+
+					switch (type)
+					{
+					case 0:		/**< 16-bit list: standard singles after the moved ones		*/
+						take = !e->ide && single && rank >= best_k + best_f;
+						v = CAN_F16_STD(e->id);
+						break;
+					case 1:		/**< 16-bit mask: masked standard, then the first k singles	*/
+						take = !e->ide && (!single || rank < best_k);
+						v = CAN_F16_STD(e->id) | ((CAN_F16_STD(e->care) | CAN_F16_MASK_ALL) << 16);
+						break;
+					case 2:		/**< 32-bit list: extended singles, then single k			*/
+						take = single && (e->ide || (best_f && rank == best_k));
+						v = e->ide ? CAN_F32_EXT(e->id) : CAN_F32_STD(e->id);
+						break;
+					default:	/**< 32-bit mask: masked extended (ID then mask)			*/
+						take = e->ide && !single;
+						v = i;
+						break;
+					}
+					if (!take)
+						continue;
+					slot[n++] = v;
+				}
+
+				const uint32_t per_bank = (type == 0U) ? 4U : (type == 3U) ? 1U : 2U;
+				if (n == 0U || (n < per_bank && i < count))
+					continue;
+				while (n < per_bank)
+				{
+					slot[n] = slot[n - 1U];			/**< Pad with a repeat					*/
+					n++;
+				}
+
+				switch (type)
+				{
+				case 0:
+					Can_Bank_Write(bank, 1, 0, fifo, slot[0] | (slot[1] << 16), slot[2] | (slot[3] << 16));
+					break;
+				case 1:
+					Can_Bank_Write(bank, 0, 0, fifo, slot[0], slot[1]);
+					break;
+				case 2:
+					Can_Bank_Write(bank, 1, 1, fifo, slot[0], slot[1]);
+					break;
+				default:
+					Can_Bank_Write(bank, 0, 1, fifo, CAN_F32_EXT(entry[slot[0]].id),
+								   (entry[slot[0]].care << 3) | CAN_F32_MASK_ALL);
+					break;
+				}
+				bank++;
+				n = 0;
+			}
+			singles = 0;
+		}
+	}
+
+	return bank - first;
+}
+
+/**
+  * @brief	Program and activate one filter bank (FINIT must be set).
+  * @param[in] bank		Bank number (0..27).
+  * @param[in] list		1: identifier list mode, 0: mask mode.
+  * @param[in] scale32	1: one 32-bit filter pair, 0: two 16-bit pairs.
+  * @param[in] fifo		FIFO assignment.
+  * @param[in] fr1		FR1 value.
+  * @param[in] fr2		FR2 value.
+  * @retval	None
+  */
+static void Can_Bank_Write(uint32_t bank, uint8_t list, uint8_t scale32, uint32_t fifo, uint32_t fr1, uint32_t fr2)
+{
+	const uint32_t bit = 1UL << bank;
+
+	CAN1->FM1R  = list    ? (CAN1->FM1R  | bit) : (CAN1->FM1R  & ~bit);
+	CAN1->FS1R  = scale32 ? (CAN1->FS1R  | bit) : (CAN1->FS1R  & ~bit);
+	CAN1->FFA1R = fifo    ? (CAN1->FFA1R | bit) : (CAN1->FFA1R & ~bit);
+	CAN1->sFilterRegister[bank].FR1 = fr1;
+	CAN1->sFilterRegister[bank].FR2 = fr2;
+	CAN1->FA1R |= bit;
+}
+
+/**
+  * @brief	CAN1 transmit interrupt handler.
+  */
+void CAN1_TX_IRQHandler(void)
+{
+	Can_TX_IRQHandler(CAN_PORT_1);
+}
+
+/**
+  * @brief	CAN1 FIFO0 interrupt handler.
+  */
+void CAN1_RX0_IRQHandler(void)
+{
+	Can_RX_IRQHandler(CAN_PORT_1, 0);
+}
+
+/**
+  * @brief	CAN1 FIFO1 interrupt handler.
+  */
+void CAN1_RX1_IRQHandler(void)
+{
+	Can_RX_IRQHandler(CAN_PORT_1, 1);
+}
+
+/**
+  * @brief	CAN1 status-change and error interrupt handler.
+  */
+void CAN1_SCE_IRQHandler(void)
+{
+	Can_SCE_IRQHandler(CAN_PORT_1);
+}
+
+/**
+  * @brief	CAN2 transmit interrupt handler.
+  */
+void CAN2_TX_IRQHandler(void)
+{
+	Can_TX_IRQHandler(CAN_PORT_2);
+}
+
+/**
+  * @brief	CAN2 FIFO0 interrupt handler.
+  */
+void CAN2_RX0_IRQHandler(void)
+{
+	Can_RX_IRQHandler(CAN_PORT_2, 0);
+}
+
+/**
+  * @brief	CAN2 FIFO1 interrupt handler.
+  */
+void CAN2_RX1_IRQHandler(void)
+{
+	Can_RX_IRQHandler(CAN_PORT_2, 1);
+}
+
+/**
+  * @brief	CAN2 status-change and error interrupt handler.
+  */
+void CAN2_SCE_IRQHandler(void)
+{
+	Can_SCE_IRQHandler(CAN_PORT_2);
+}
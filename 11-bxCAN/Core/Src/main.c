@@ -0,0 +1,260 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	bxCAN self-test: hardware filtering and mailbox throughput.
+  *
+  * 		This file initializes the system, board support package (BSP) and
+  * 		both CAN controllers in silent-loopback mode (no bus, no transceiver:
+  * 		CAN1 at 1 Mbit/s, CAN2 at 500 kbit/s), then keeps their transmit
+  * 		queues full with a rotating set of identifiers. Only some of them
+  * 		are in the accept lists, so the filter banks discard the rest in
+  * 		hardware. Once per second the counters are printed over ITM stimulus
+  * 		port 0 (SWO on PB3):
+  *
+  * 		`BT,<port>,<prescaler>,<tq per bit>,<sample point per mille>`
+  * 		`FILT,<port>,<accepted ids>,<entries>,<mask entries>,<banks>`
+  * 		`CAN,<port>,<sent>,<rx fifo0>,<rx fifo1>,<dropped>,<overruns>,<preempted>,<leaked>,<bus-off>`
+  *
+  * 		`leaked` counts received frames whose ID is not in the accept list
+  * 		(must stay 0). The green LED toggles on every report; the red LED
+  * 		is lit if a controller failed to start.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "can.h"
+
+#define DEMO_BURST		8U			/**< Frames queued per loop pass	*/
+
+/** @brief	Controller configurations. */
+static const Can_Config_t demo_config[CAN_PORTS] = {
+		[CAN_PORT_1] = { 1000000UL, 875U, 1U, CAN_MODE_SILENT_LOOPBACK },
+		[CAN_PORT_2] = {  500000UL, 875U, 1U, CAN_MODE_SILENT_LOOPBACK }
+};
+
+/** @brief	CAN1 accept list: 0x100..0x10F merge into one mask entry, 0x18FF1000..3 into another. */
+static const Can_Accept_t demo_accept1[] = {
+		{ 0x100, 0, 0 }, { 0x101, 0, 0 }, { 0x102, 0, 0 }, { 0x103, 0, 0 },
+		{ 0x104, 0, 0 }, { 0x105, 0, 0 }, { 0x106, 0, 0 }, { 0x107, 0, 0 },
+		{ 0x108, 0, 0 }, { 0x109, 0, 0 }, { 0x10A, 0, 0 }, { 0x10B, 0, 0 },
+		{ 0x10C, 0, 0 }, { 0x10D, 0, 0 }, { 0x10E, 0, 0 }, { 0x10F, 0, 0 },
+		{ 0x123, 0, 0 }, { 0x321, 0, 0 }, { 0x456, 0, 0 }, { 0x7FF, 0, 0 },
+		{ 0x18FF1000, 1, 1 }, { 0x18FF1001, 1, 1 }, { 0x18FF1002, 1, 1 }, { 0x18FF1003, 1, 1 },
+		{ 0x0CF00400, 1, 1 }
+};
+
+/** @brief	CAN2 accept list. */
+static const Can_Accept_t demo_accept2[] = {
+		{ 0x080, 0, 0 }, { 0x081, 0, 0 }, { 0x082, 0, 0 }, { 0x083, 0, 0 },
+		{ 0x700, 0, 1 }, { 0x701, 0, 1 }, { 0x1ABCDE00, 1, 1 }
+};
+
+/** @brief	Transmitted identifiers (accepted and rejected), {id, ide}. */
+static const uint32_t demo_tx_id[][2] = {
+		{ 0x100, 0 }, { 0x10F, 0 }, { 0x110, 0 }, { 0x123, 0 }, { 0x124, 0 }, { 0x7FF, 0 },
+		{ 0x083, 0 }, { 0x084, 0 }, { 0x700, 0 }, { 0x702, 0 },
+		{ 0x18FF1002, 1 }, { 0x18FF1004, 1 }, { 0x0CF00400, 1 }, { 0x1ABCDE00, 1 }, { 0x1ABCDE01, 1 }
+};
+
+#define DEMO_TX_IDS		(sizeof(demo_tx_id) / sizeof(demo_tx_id[0]))
+
+static uint32_t demo_leaked[CAN_PORTS];		/**< Frames the filters should have rejected	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static uint8_t Demo_Accepted(const Can_Accept_t *list, uint32_t count, const Can_Frame_t *frame);
+static void Demo_Report(Can_Port_t port);
+static void ITM_Print(const char *str);
+static void ITM_PrintU32(uint32_t value);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs).
+  * 		3. Starts CAN1 and CAN2 in silent-loopback mode with bit timing
+  * 		   computed from the APB1 clock, and plans the filter banks.
+  * 		4. Enters an infinite loop: tops up both transmit queues, drains the
+  * 		   receive rings, checks every frame against the accept lists and
+  * 		   reports once per second (DWT cycle counter).
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	const Can_Accept_t *accept[CAN_PORTS] = { demo_accept1, demo_accept2 };
+	const uint32_t accept_n[CAN_PORTS] = { sizeof(demo_accept1) / sizeof(demo_accept1[0]),
+										   sizeof(demo_accept2) / sizeof(demo_accept2[0]) };
+	Can_Timing_t timing[CAN_PORTS];
+	Can_FilterInfo_t info;
+	Can_Frame_t frame;
+	uint32_t next_id[CAN_PORTS] = { 0 }, seq = 0;
+	uint8_t ready = 1;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+	/* Report period from the cycle counter */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	for (uint32_t p = 0; p < CAN_PORTS; p++)
+	{
+		if (Can_Init((Can_Port_t)p, &demo_config[p], &timing[p]) != CAN_OK)
+		{
+			ready = 0;					/**< No bxCAN (e.g. QEMU): nothing to test	*/
+			continue;
+		}
+		ITM_Print("BT,");
+		ITM_PrintU32(p + 1U);
+		ITM_Print(",");
+		ITM_PrintU32(timing[p].prescaler);
+		ITM_Print(",");
+		ITM_PrintU32(timing[p].tq_per_bit);
+		ITM_Print(",");
+		ITM_PrintU32(timing[p].sample_point);
+		ITM_Print("\n");
+	}
+
+	if (ready && Can_SetFilters(demo_accept1, accept_n[0], demo_accept2, accept_n[1], &info) != CAN_OK)
+		ready = 0;
+
+	if (!ready)
+	{
+		BSP_LED_On(LED_RED);
+		ITM_Print("CAN,init failed\n");
+		while (1);
+	}
+
+	for (uint32_t p = 0; p < CAN_PORTS; p++)
+	{
+		ITM_Print("FILT,");
+		ITM_PrintU32(p + 1U);
+		ITM_Print(",");
+		ITM_PrintU32(accept_n[p]);
+		ITM_Print(",");
+		ITM_PrintU32(info.entries[p]);
+		ITM_Print(",");
+		ITM_PrintU32(info.masks[p]);
+		ITM_Print(",");
+		ITM_PrintU32(info.banks[p]);
+		ITM_Print("\n");
+	}
+
+	uint32_t last = DWT->CYCCNT;
+
+	/**< Main loop */
+	while (1)
+	{
+		for (uint32_t p = 0; p < CAN_PORTS; p++)
+		{
+			/* Keep the queue busy: the mailboxes never run dry */
+			for (uint32_t n = 0; n < DEMO_BURST && Can_TxPending((Can_Port_t)p) < CAN_TX_QUEUE / 2U; n++)
+			{
+				frame = (Can_Frame_t){ .id = demo_tx_id[next_id[p]][0], .ide = (uint8_t)demo_tx_id[next_id[p]][1],
+									   .dlc = 8U };
+				for (uint32_t i = 0; i < 4U; i++)
+					frame.data[i] = (uint8_t)(seq >> (8U * i));
+				seq++;
+				next_id[p] = (next_id[p] + 1U) % DEMO_TX_IDS;
+				Can_Transmit((Can_Port_t)p, &frame);
+			}
+
+			for (uint32_t fifo = 0; fifo < 2U; fifo++)
+			{
+				while (Can_Receive((Can_Port_t)p, fifo, &frame))
+				{
+					if (!Demo_Accepted(accept[p], accept_n[p], &frame))
+						demo_leaked[p]++;
+				}
+			}
+		}
+
+		if (DWT->CYCCNT - last >= SystemCoreClock)
+		{
+			last += SystemCoreClock;
+			Demo_Report(CAN_PORT_1);
+			Demo_Report(CAN_PORT_2);
+			BSP_LED_Toggle(LED_GREEN);
+		}
+	}
+}
+
+/**
+  * @brief	Whether a received frame is in an accept list.
+  * @param[in] list		Accept list.
+  * @param[in] count	Entries in the list.
+  * @param[in] frame	Received frame.
+  * @retval	1 if listed, 0 otherwise.
+  */
+static uint8_t Demo_Accepted(const Can_Accept_t *list, uint32_t count, const Can_Frame_t *frame)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (list[i].id == frame->id && list[i].ide == frame->ide)
+			return 1;
+	}
+	return 0;
+}
+
+/**
+  * @brief	Print the counters of one controller.
+  * @param[in] port	Controller.
+  * @retval	None
+  */
+static void Demo_Report(Can_Port_t port)
+{
+	Can_Stats_t stats;
+
+	Can_GetStats(port, &stats);
+
+	ITM_Print("CAN,");
+	ITM_PrintU32((uint32_t)port + 1U);
+	ITM_Print(",");
+	ITM_PrintU32(stats.tx_ok);
+	ITM_Print(",");
+	ITM_PrintU32(stats.rx[0]);
+	ITM_Print(",");
+	ITM_PrintU32(stats.rx[1]);
+	ITM_Print(",");
+	ITM_PrintU32(stats.rx_drop[0] + stats.rx_drop[1]);
+	ITM_Print(",");
+	ITM_PrintU32(stats.rx_overrun[0] + stats.rx_overrun[1]);
+	ITM_Print(",");
+	ITM_PrintU32(stats.tx_preempt);
+	ITM_Print(",");
+	ITM_PrintU32(demo_leaked[port]);
+	ITM_Print(",");
+	ITM_PrintU32(stats.bus_off);
+	ITM_Print("\n");
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write an unsigned decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf);
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	ITM_Print(&buf[i]);
+}
@@ -0,0 +1,149 @@
+/**
+  * @file	i2c.h
+  * @author	Parham Estiri
+  * @brief	Non-blocking I2C1 master with DMA and a queued transaction engine.
+  *
+  * 		This module provides:
+  * 		 - A queue of caller-owned jobs; each job is an optional write
+  * 		   segment followed by an optional read segment (repeated START)
+  * 		 - An event-interrupt state machine (SB, ADDR, BTF) with DMA for
+  * 		   the data bytes: the CPU never polls the I2C flags
+  * 		 - Back-to-back jobs chained with a repeated START, so a burst of
+  * 		   small register accesses costs one STOP at the end of the queue
+  * 		 - Completion callbacks run from interrupt context
+  * 		 - A per-job watchdog (TIM14) and bus recovery: up to nine SCL
+  * 		   pulses release a slave holding SDA low, then a STOP and a
+  * 		   peripheral reset. The interrupts only abort the job; the
+  * 		   recovery itself runs from I2C_Poll() in the main loop
+  *
+  * 		| Signal  | Pin | Resource                       |
+  * 		|---------|-----|--------------------------------|
+  * 		| SCL     | PB6 | AF4, open drain                |
+  * 		| SDA     | PB9 | AF4, open drain                |
+  * 		| I2C1_TX |     | DMA1 Stream6, channel 1        |
+  * 		| I2C1_RX |     | DMA1 Stream0, channel 1        |
+  *
+  * @note	On the STM32F407G-DISC1 the CS43L22 audio codec (address 0x4A)
+  * 		is on these pins and has 4.7 kΩ pull-ups; its reset line is PD4.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef I2C_H_
+#define I2C_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define I2C_QUEUE				16U			/**< Jobs waiting (power of two)				*/
+#define I2C_SPEED_MAX			400000UL	/**< Fast mode									*/
+#define I2C_EV_PRIORITY			0x02U		/**< Event interrupt: SB, ADDR, BTF				*/
+#define I2C_ER_PRIORITY			0x02U		/**< Error interrupt: AF, ARLO, BERR, OVR		*/
+#define I2C_DMA_PRIORITY		0x02U		/**< RX complete: STOP or repeated START		*/
+#define I2C_WDG_PRIORITY		0x02U		/**< Job watchdog: same level, never pre-empts	*/
+#define I2C_TIMEOUT_BASE_US		1000UL		/**< Watchdog: fixed part per job				*/
+#define I2C_TIMEOUT_BYTE_US		200UL		/**< Watchdog: per byte (2x a byte at 100 kHz)	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Job status.
+  */
+typedef enum {
+	I2C_OK			= 0,	/**< Completed										*/
+	I2C_PENDING		= 1,	/**< Queued or running								*/
+	I2C_ENACK		= 2,	/**< Address or data byte not acknowledged			*/
+	I2C_EBUS		= 3,	/**< Bus error or arbitration lost					*/
+	I2C_ETIMEOUT	= 4,	/**< Watchdog expired (bus recovered)				*/
+	I2C_EINVAL		= 5,	/**< Bad parameter									*/
+	I2C_EFULL		= 6,	/**< Queue full										*/
+	I2C_EDMA		= 7		/**< DMA transfer error (bus recovered)				*/
+} I2C_Status_t;
+
+struct I2C_Job;
+
+/**
+  * @brief	Completion callback (interrupt context, keep it short).
+  */
+typedef void (*I2C_Callback_t)(struct I2C_Job *job);
+
+/**
+  * @brief	Transaction: START, write tx[], repeated START, read rx[], STOP.
+  *
+  * 		tx_len = 0 gives a plain read, rx_len = 0 a plain write, and both
+  * 		0 an address probe. The job and its buffers must stay valid until
+  * 		status leaves I2C_PENDING.
+  */
+typedef struct I2C_Job {
+	uint8_t					addr;		/**< 7-bit slave address					*/
+	const uint8_t			*tx;		/**< Write segment							*/
+	uint16_t				tx_len;
+	uint8_t					*rx;		/**< Read segment							*/
+	uint16_t				rx_len;
+	I2C_Callback_t			callback;	/**< Called on completion (may be NULL)		*/
+	void					*arg;		/**< Free for the caller					*/
+	volatile I2C_Status_t	status;		/**< Set by the driver						*/
+} I2C_Job_t;
+
+/**
+  * @brief	Driver statistics.
+  */
+typedef struct {
+	uint32_t	jobs;			/**< Jobs completed (any status)				*/
+	uint32_t	nacks;			/**< Jobs ended by a NACK						*/
+	uint32_t	bus_errors;		/**< Jobs ended by BERR or ARLO					*/
+	uint32_t	timeouts;		/**< Jobs ended by the watchdog					*/
+	uint32_t	dma_errors;		/**< Jobs ended by a DMA transfer error			*/
+	uint32_t	recoveries;		/**< Bus recovery sequences						*/
+	uint32_t	stops;			/**< STOP conditions (queue drained)			*/
+} I2C_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure I2C1, its pins, DMA streams and the watchdog timer.
+  * @param[in] speed_hz	SCL frequency (up to 400 kHz).
+  * @retval	I2C_OK or I2C_EINVAL.
+  * @note	Recovers the bus first if a slave holds SDA low.
+  */
+I2C_Status_t I2C_Init(uint32_t speed_hz);
+
+/**
+  * @brief	Queue a job; it starts at once if the bus is idle.
+  * @param[in,out] job	Job (status set to I2C_PENDING).
+  * @retval	I2C_OK, I2C_EINVAL or I2C_EFULL.
+  */
+I2C_Status_t I2C_Submit(I2C_Job_t *job);
+
+/**
+  * @brief	Run a bus recovery requested by the interrupts, then restart the queue.
+  * @param	None
+  * @retval	None
+  * @note	Call from the main loop. After an error or a timeout, queued jobs
+  * 		wait for this call; the recovery takes up to about 100 µs.
+  */
+void I2C_Poll(void);
+
+/**
+  * @brief	Number of jobs queued or running.
+  * @param	None
+  * @retval	Pending jobs.
+  */
+uint32_t I2C_Pending(void);
+
+/**
+  * @brief	Copy the driver statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void I2C_GetStats(I2C_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* I2C_H_ */
@@ -0,0 +1,641 @@
+/**
+  * @file	i2c.c
+  * @author	Parham Estiri
+  * @brief	Non-blocking I2C1 master with DMA and a queued transaction engine.
+  *
+  * 		This file provides:
+  * 		 - Job queue and the event/error interrupt state machine
+  * 		 - DMA1 Stream6 (TX) and Stream0 (RX) set-up per segment
+  * 		 - STOP or repeated START selection at the end of each job
+  * 		 - TIM14 one-shot: job watchdog, and the deferred START that waits
+  * 		   for a pending STOP without polling CR1
+  * 		 - Bus recovery by bit-banging SCL, deferred to I2C_Poll() so no
+  * 		   interrupt handler busy-waits
+  *
+  * 		Sequence of a write-then-read job (RM0090, 27.3.3):
+  *
+  * 		    START  SB: DR = addr|W  ADDR: DMA TX  ...  BTF: START
+  * 		    SB: DR = addr|R  ADDR: ACK, LAST, DMA RX  ...  DMA TC: STOP or START
+  *
+  * 		A single-byte read clears ACK and programs STOP/START right after
+  * 		ADDR, as the reference manual requires.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "i2c.h"
+
+#define I2C_QUEUE_MASK		(I2C_QUEUE - 1UL)
+#define I2C_SCL_PIN			6U
+#define I2C_SDA_PIN			9U
+#define I2C_AF				4U
+#define I2C_DMA_CHANNEL		1U
+#define I2C_RX_FLAG_POS		0U				/**< Stream0 flags in LISR					*/
+#define I2C_TX_FLAG_POS		16U				/**< Stream6 flags in HISR					*/
+#define I2C_DEFER_US		20UL			/**< Re-check of a pending STOP				*/
+#define I2C_RECOVER_PULSES	9U				/**< Enough to finish any byte plus ACK		*/
+#define I2C_RECOVER_HALF_US	5UL				/**< 100 kHz recovery clock					*/
+
+/**
+  * @brief	Engine state.
+  */
+typedef enum {
+	I2C_PHASE_IDLE	= 0,	/**< No job on the bus						*/
+	I2C_PHASE_WRITE	= 1,	/**< Address + write segment				*/
+	I2C_PHASE_READ	= 2		/**< Address + read segment					*/
+} I2C_Phase_t;
+
+static I2C_Job_t *i2c_queue[I2C_QUEUE];		/**< Head job is the one on the bus			*/
+static volatile uint32_t i2c_head;			/**< Next free slot (absolute)				*/
+static volatile uint32_t i2c_tail;			/**< Running job (absolute)					*/
+static volatile I2C_Phase_t i2c_phase;
+static uint8_t i2c_chained;					/**< START already requested for the next job	*/
+static uint8_t i2c_tx_active;				/**< TX DMA running: BTF ends the segment	*/
+static uint8_t i2c_rx_active;				/**< RX DMA running: TC ends the segment	*/
+static uint8_t i2c_deferred;				/**< TIM14 will issue the next START		*/
+static volatile uint8_t i2c_recover;		/**< Bus recovery pending: queue held		*/
+static uint32_t i2c_speed;					/**< SCL frequency (for re-configuration)	*/
+static I2C_Stats_t i2c_stats;
+
+/**************************  Static Function Prototypes  ***************************/
+static void I2C_Config(void);
+static void I2C_Pins(uint32_t mode);
+static void I2C_Abort(void);
+static void I2C_Recover(void);
+static void I2C_Delay_us(uint32_t us);
+static void I2C_DMA_Start(DMA_Stream_TypeDef *stream, uint32_t flag_pos, uint32_t dir, uint32_t mem, uint16_t len);
+static void I2C_DMA_Stop(DMA_Stream_TypeDef *stream);
+static void I2C_Watchdog(uint32_t us);
+static void I2C_Arm(void);
+static void I2C_Kick(void);
+static void I2C_Condition(void);
+static void I2C_RX_Done(void);
+static void I2C_Complete(I2C_Status_t status);
+static void I2C_Fail(I2C_Status_t status);
+
+/**
+  * @brief	Configure I2C1, its pins, DMA streams and the watchdog timer.
+  * @param[in] speed_hz	SCL frequency (up to 400 kHz).
+  * @retval	I2C_OK or I2C_EINVAL.
+  */
+I2C_Status_t I2C_Init(uint32_t speed_hz)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+
+	if (speed_hz == 0U || speed_hz > I2C_SPEED_MAX)
+		return I2C_EINVAL;
+	i2c_speed = speed_hz;
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_DMA1EN;
+	RCC->APB1ENR |= RCC_APB1ENR_I2C1EN | RCC_APB1ENR_TIM14EN;
+
+	/* Cycle counter for the recovery clock */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	/* Open drain, released; a slave left in the middle of a byte is clocked out */
+	GPIOB->OTYPER  |= (1UL << I2C_SCL_PIN) | (1UL << I2C_SDA_PIN);
+	GPIOB->OSPEEDR |= (2UL << (I2C_SCL_PIN * 2)) | (2UL << (I2C_SDA_PIN * 2));
+	GPIOB->PUPDR   &= ~((3UL << (I2C_SCL_PIN * 2)) | (3UL << (I2C_SDA_PIN * 2)));	/**< External pull-ups	*/
+	GPIOB->AFR[0]   = (GPIOB->AFR[0] & ~(0xFUL << (I2C_SCL_PIN * 4))) | (I2C_AF << (I2C_SCL_PIN * 4));
+	GPIOB->AFR[1]   = (GPIOB->AFR[1] & ~(0xFUL << ((I2C_SDA_PIN - 8U) * 4))) | (I2C_AF << ((I2C_SDA_PIN - 8U) * 4));
+	I2C_Recover();
+	i2c_stats.recoveries = 0;						/**< The power-up sequence does not count	*/
+
+	/* TIM14: 1 MHz one-shot (timer clock = 2 x APB1) */
+	const uint32_t apb1 = SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+	TIM14->CR1  = 0;
+	TIM14->PSC  = ((apb1 == SystemCoreClock) ? apb1 : 2U * apb1) / 1000000UL - 1U;
+	TIM14->ARR  = 0xFFFF;
+	TIM14->EGR  = TIM_EGR_UG;						/**< Load the prescaler						*/
+	TIM14->SR   = 0;
+	TIM14->DIER = TIM_DIER_UIE;
+
+	NVIC_SetPriority(I2C1_EV_IRQn, NVIC_EncodePriority(PG, I2C_EV_PRIORITY, 0));
+	NVIC_SetPriority(I2C1_ER_IRQn, NVIC_EncodePriority(PG, I2C_ER_PRIORITY, 0));
+	NVIC_SetPriority(DMA1_Stream0_IRQn, NVIC_EncodePriority(PG, I2C_DMA_PRIORITY, 0));
+	NVIC_SetPriority(DMA1_Stream6_IRQn, NVIC_EncodePriority(PG, I2C_DMA_PRIORITY, 0));
+	NVIC_SetPriority(TIM8_TRG_COM_TIM14_IRQn, NVIC_EncodePriority(PG, I2C_WDG_PRIORITY, 0));
+	NVIC_EnableIRQ(I2C1_EV_IRQn);
+	NVIC_EnableIRQ(I2C1_ER_IRQn);
+	NVIC_EnableIRQ(DMA1_Stream0_IRQn);
+	NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+	NVIC_EnableIRQ(TIM8_TRG_COM_TIM14_IRQn);
+
+	return I2C_OK;
+}
+
+/**
+  * @brief	Queue a job; it starts at once if the bus is idle.
+  * @param[in,out] job	Job (status set to I2C_PENDING).
+  * @retval	I2C_OK, I2C_EINVAL or I2C_EFULL.
+  */
+I2C_Status_t I2C_Submit(I2C_Job_t *job)
+{
+	I2C_Status_t status = I2C_OK;
+
+	if (!job || job->addr > 0x7FU || (job->tx_len && !job->tx) || (job->rx_len && !job->rx))
+		return I2C_EINVAL;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (i2c_head - i2c_tail >= I2C_QUEUE)
+		status = I2C_EFULL;
+	else
+	{
+		job->status = I2C_PENDING;
+		i2c_queue[i2c_head & I2C_QUEUE_MASK] = job;
+		i2c_head++;
+		if (i2c_phase == I2C_PHASE_IDLE && !i2c_deferred && !i2c_recover)
+			I2C_Kick();
+	}
+
+	__set_PRIMASK(primask);
+	return status;
+}
+
+/**
+  * @brief	Run a bus recovery requested by the interrupts, then restart the queue.
+  * @param	None
+  * @retval	None
+  * @note	I2C1 is disabled and TIM14 stopped while a recovery is pending, so
+  * 		none of the driver interrupts touches the pins meanwhile.
+  */
+void I2C_Poll(void)
+{
+	if (!i2c_recover)
+		return;
+
+	I2C_Recover();									/**< Thread context: interrupts stay enabled	*/
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	i2c_recover = 0;
+	if (i2c_phase == I2C_PHASE_IDLE && !i2c_deferred && i2c_head != i2c_tail)
+		I2C_Kick();									/**< Jobs queued behind the failed one		*/
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief	Number of jobs queued or running.
+  * @param	None
+  * @retval	Pending jobs.
+  */
+uint32_t I2C_Pending(void)
+{
+	return i2c_head - i2c_tail;
+}
+
+/**
+  * @brief	Copy the driver statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void I2C_GetStats(I2C_Stats_t *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	*stats = i2c_stats;
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief	Program the I2C1 timing and enable it (event and error interrupts).
+  */
+static void I2C_Config(void)
+{
+	const uint32_t apb1 = SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+	const uint32_t mhz = apb1 / 1000000UL;
+	uint32_t ccr;
+
+	I2C1->CR1 = I2C_CR1_SWRST;						/**< Clear BUSY and any half-done transfer	*/
+	I2C1->CR1 = 0;
+	I2C1->CR2 = (mhz << I2C_CR2_FREQ_Pos) | I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+
+	if (i2c_speed <= 100000UL)
+	{
+		ccr = apb1 / (2U * i2c_speed);				/**< Standard mode: Tlow = Thigh			*/
+		if (ccr < 4U)
+			ccr = 4U;
+		I2C1->TRISE = mhz + 1U;						/**< 1000 ns maximum rise time				*/
+	}
+	else
+	{
+		ccr = apb1 / (3U * i2c_speed);				/**< Fast mode, DUTY = 0: Tlow = 2 Thigh	*/
+		if (ccr < 1U)
+			ccr = 1U;
+		ccr |= I2C_CCR_FS;
+		I2C1->TRISE = mhz * 300U / 1000U + 1U;		/**< 300 ns maximum rise time				*/
+	}
+	I2C1->CCR = ccr;
+	I2C1->CR1 = I2C_CR1_PE;
+}
+
+/**
+  * @brief	Switch SCL/SDA between the I2C peripheral and GPIO outputs.
+  * @param[in] mode	1: general-purpose output (bit-bang), 2: alternate function.
+  */
+static void I2C_Pins(uint32_t mode)
+{
+	GPIOB->MODER = (GPIOB->MODER & ~((3UL << (I2C_SCL_PIN * 2)) | (3UL << (I2C_SDA_PIN * 2))))
+				 | (mode << (I2C_SCL_PIN * 2)) | (mode << (I2C_SDA_PIN * 2));
+}
+
+/**
+  * @brief	Release a stuck bus, then reset and re-configure I2C1.
+  *
+  * 		A slave reset or interrupted in the middle of a read keeps SDA low
+  * 		while it waits for the rest of its byte. Up to nine SCL pulses let
+  * 		it shift the byte out and see a NACK; a STOP then returns the bus
+  * 		to idle. The I2C peripheral itself is reset with SWRST (clears a
+  * 		stuck BUSY flag).
+  *
+  * @note	Takes up to about 100 µs (bit-banged at 100 kHz): called from
+  * 		I2C_Init() and I2C_Poll() only, never from an interrupt handler.
+  */
+static void I2C_Recover(void)
+{
+	I2C_Abort();
+
+	GPIOB->BSRR = (1UL << I2C_SCL_PIN) | (1UL << I2C_SDA_PIN);	/**< Released (open drain)	*/
+	I2C_Pins(1U);
+	I2C_Delay_us(I2C_RECOVER_HALF_US);
+
+	for (uint32_t n = 0; n < I2C_RECOVER_PULSES && !(GPIOB->IDR & (1UL << I2C_SDA_PIN)); n++)
+	{
+		GPIOB->BSRR = 1UL << (I2C_SCL_PIN + 16U);	/**< SCL low								*/
+		I2C_Delay_us(I2C_RECOVER_HALF_US);
+		GPIOB->BSRR = 1UL << I2C_SCL_PIN;			/**< SCL released							*/
+		I2C_Delay_us(I2C_RECOVER_HALF_US);
+	}
+
+	/* STOP: SDA rises while SCL is high */
+	GPIOB->BSRR = 1UL << (I2C_SCL_PIN + 16U);
+	I2C_Delay_us(I2C_RECOVER_HALF_US);
+	GPIOB->BSRR = 1UL << (I2C_SDA_PIN + 16U);
+	I2C_Delay_us(I2C_RECOVER_HALF_US);
+	GPIOB->BSRR = 1UL << I2C_SCL_PIN;
+	I2C_Delay_us(I2C_RECOVER_HALF_US);
+	GPIOB->BSRR = 1UL << I2C_SDA_PIN;
+	I2C_Delay_us(I2C_RECOVER_HALF_US);
+
+	I2C_Pins(2U);
+	I2C_Config();
+	i2c_stats.recoveries++;
+}
+
+/**
+  * @brief	Disable I2C1 and stop both DMA streams (no more events or requests).
+  */
+static void I2C_Abort(void)
+{
+	I2C1->CR1 = 0;
+	I2C1->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+	I2C_DMA_Stop(DMA1_Stream6);
+	I2C_DMA_Stop(DMA1_Stream0);
+	i2c_tx_active = 0;
+	i2c_rx_active = 0;
+}
+
+/**
+  * @brief	Busy-wait on the cycle counter (bus recovery only).
+  */
+static void I2C_Delay_us(uint32_t us)
+{
+	const uint32_t start = DWT->CYCCNT;
+	const uint32_t cycles = us * (SystemCoreClock / 1000000UL);
+
+	while (DWT->CYCCNT - start < cycles);
+}
+
+/**
+  * @brief	Start a one-shot DMA transfer between memory and I2C1->DR.
+  * @param[in] stream	DMA1 stream.
+  * @param[in] flag_pos	Stream flag offset in LISR/HISR.
+  * @param[in] dir		DMA_SxCR_DIR value (0: peripheral to memory).
+  * @param[in] mem		Buffer address.
+  * @param[in] len		Bytes to transfer.
+  */
+static void I2C_DMA_Start(DMA_Stream_TypeDef *stream, uint32_t flag_pos, uint32_t dir, uint32_t mem, uint16_t len)
+{
+	volatile uint32_t *ifcr = (stream == DMA1_Stream0) ? &DMA1->LIFCR : &DMA1->HIFCR;
+
+	I2C_DMA_Stop(stream);
+	*ifcr = 0x3DUL << flag_pos;						/**< Clear TC, HT, TE, DME, FE				*/
+
+	stream->PAR  = (uint32_t)&I2C1->DR;
+	stream->M0AR = mem;
+	stream->NDTR = len;
+	stream->FCR  = 0;								/**< Direct mode							*/
+	stream->CR   = (I2C_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+				 | DMA_SxCR_PL_1					/**< High priority							*/
+				 | DMA_SxCR_MINC					/**< Byte transfers (MSIZE = PSIZE = 0)		*/
+				 | dir
+				 | DMA_SxCR_TEIE					/**< Transfer error ends the job			*/
+				 | ((stream == DMA1_Stream0) ? DMA_SxCR_TCIE : 0U);	/**< TX ends on BTF instead	*/
+	stream->CR  |= DMA_SxCR_EN;
+}
+
+/**
+  * @brief	Disable a DMA stream and wait until it is off.
+  */
+static void I2C_DMA_Stop(DMA_Stream_TypeDef *stream)
+{
+	stream->CR &= ~DMA_SxCR_EN;
+	while (stream->CR & DMA_SxCR_EN);
+}
+
+/**
+  * @brief	(Re)start TIM14 as a one-shot of `us` microseconds.
+  */
+static void I2C_Watchdog(uint32_t us)
+{
+	TIM14->CR1 = 0;
+	TIM14->SR  = 0;
+	TIM14->CNT = 0;
+	TIM14->ARR = (us > 0xFFFFUL) ? 0xFFFFUL : us;
+	TIM14->CR1 = TIM_CR1_OPM | TIM_CR1_URS | TIM_CR1_CEN;
+}
+
+/**
+  * @brief	Make the head job current: select its first phase, arm the watchdog.
+  */
+static void I2C_Arm(void)
+{
+	const I2C_Job_t *job = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+
+	i2c_phase = (job->tx_len || !job->rx_len) ? I2C_PHASE_WRITE : I2C_PHASE_READ;
+	I2C_Watchdog(I2C_TIMEOUT_BASE_US + I2C_TIMEOUT_BYTE_US * (2U + job->tx_len + job->rx_len));
+}
+
+/**
+  * @brief	Start the head job from idle, or defer it while a STOP is pending.
+  * @note	CR1 must not be written while STOP is set (RM0090, I2C_CR1).
+  */
+static void I2C_Kick(void)
+{
+	if (I2C1->CR1 & I2C_CR1_STOP)
+	{
+		i2c_deferred = 1;							/**< TIM14 checks again shortly				*/
+		I2C_Watchdog(I2C_DEFER_US);
+		return;
+	}
+
+	I2C_Arm();
+	I2C1->CR1 |= I2C_CR1_START;
+}
+
+/**
+  * @brief	End the current job on the bus: repeated START if another job is
+  * 		queued (no STOP between them), STOP otherwise.
+  */
+static void I2C_Condition(void)
+{
+	i2c_chained = (i2c_head - i2c_tail) > 1U;
+
+	if (i2c_chained)
+		I2C1->CR1 |= I2C_CR1_START;
+	else
+	{
+		I2C1->CR1 |= I2C_CR1_STOP;
+		i2c_stats.stops++;
+	}
+}
+
+/**
+  * @brief	Read segment finished (DMA transfer complete).
+  */
+static void I2C_RX_Done(void)
+{
+	const I2C_Job_t *job = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+
+	DMA1->LIFCR = 0x3DUL << I2C_RX_FLAG_POS;
+	I2C1->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+	i2c_rx_active = 0;
+
+	if (job->rx_len > 1U)
+		I2C_Condition();							/**< NACK already sent (LAST)				*/
+	I2C_Complete(I2C_OK);
+}
+
+/**
+  * @brief	Retire the current job and move to the next one.
+  * @param[in] status	Job result.
+  */
+static void I2C_Complete(I2C_Status_t status)
+{
+	I2C_Job_t *job = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+
+	TIM14->CR1 = 0;
+	TIM14->SR  = 0;
+	i2c_tail++;
+	i2c_stats.jobs++;
+	if (status == I2C_ENACK)	i2c_stats.nacks++;
+	if (status == I2C_EBUS)		i2c_stats.bus_errors++;
+	if (status == I2C_ETIMEOUT)	i2c_stats.timeouts++;
+	if (status == I2C_EDMA)		i2c_stats.dma_errors++;
+
+	job->status = status;
+	if (job->callback)
+		job->callback(job);							/**< May submit: phase is not idle yet		*/
+
+	if (i2c_chained)
+	{
+		i2c_chained = 0;
+		I2C_Arm();									/**< START already requested				*/
+	}
+	else
+	{
+		i2c_phase = I2C_PHASE_IDLE;
+		if (i2c_head != i2c_tail && !i2c_recover)
+			I2C_Kick();								/**< Queued during the STOP					*/
+	}
+}
+
+/**
+  * @brief	End the current job with an error and hand the bus recovery to I2C_Poll().
+  * @param[in] status	Job result.
+  */
+static void I2C_Fail(I2C_Status_t status)
+{
+	I2C_Abort();
+	i2c_recover = 1;								/**< Holds the queue until I2C_Poll()		*/
+	i2c_chained = 0;
+	I2C_Complete(status);
+}
+
+/**
+  * @brief	I2C1 event interrupt handler: SB, ADDR, BTF.
+  */
+void I2C1_EV_IRQHandler(void)
+{
+	const uint32_t sr1 = I2C1->SR1;
+
+	if (i2c_phase == I2C_PHASE_IDLE)
+	{
+		(void)I2C1->SR2;
+		return;
+	}
+
+	const I2C_Job_t *job = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+
+	if (sr1 & I2C_SR1_SB)
+	{
+		if (i2c_rx_active)
+		{
+			/* Single-byte read chained with START: the byte is in, its TC may still be pending */
+			I2C_RX_Done();
+			job = i2c_queue[i2c_tail & I2C_QUEUE_MASK];
+		}
+		I2C1->DR = ((uint32_t)job->addr << 1) | (i2c_phase == I2C_PHASE_READ ? 1U : 0U);
+		return;
+	}
+
+	if (sr1 & I2C_SR1_ADDR)
+	{
+		if (i2c_phase == I2C_PHASE_WRITE)
+		{
+			if (job->tx_len)
+			{
+				I2C_DMA_Start(DMA1_Stream6, I2C_TX_FLAG_POS, DMA_SxCR_DIR_0, (uint32_t)job->tx, job->tx_len);
+				i2c_tx_active = 1;
+				I2C1->CR2 |= I2C_CR2_DMAEN;
+				(void)I2C1->SR2;					/**< Clear ADDR: transfer starts			*/
+			}
+			else
+			{
+				(void)I2C1->SR2;					/**< Address probe: acknowledged			*/
+				I2C_Condition();
+				I2C_Complete(I2C_OK);
+			}
+		}
+		else
+		{
+			I2C_DMA_Start(DMA1_Stream0, I2C_RX_FLAG_POS, 0U, (uint32_t)job->rx, job->rx_len);
+			i2c_rx_active = 1;
+			if (job->rx_len == 1U)
+			{
+				I2C1->CR1 &= ~I2C_CR1_ACK;			/**< NACK the only byte						*/
+				I2C1->CR2 |= I2C_CR2_DMAEN;
+				(void)I2C1->SR2;
+				I2C_Condition();					/**< Must follow ADDR clear directly		*/
+			}
+			else
+			{
+				I2C1->CR1 |= I2C_CR1_ACK;
+				I2C1->CR2 |= I2C_CR2_DMAEN | I2C_CR2_LAST;	/**< NACK on the last DMA byte		*/
+				(void)I2C1->SR2;
+			}
+		}
+		return;
+	}
+
+	if ((sr1 & I2C_SR1_BTF) && i2c_tx_active && DMA1_Stream6->NDTR == 0U
+			&& !(I2C1->CR1 & (I2C_CR1_START | I2C_CR1_STOP)))
+	{
+		/* Last written byte shifted out */
+		i2c_tx_active = 0;
+		I2C1->CR2 &= ~I2C_CR2_DMAEN;
+
+		if (job->rx_len)
+		{
+			i2c_phase = I2C_PHASE_READ;
+			I2C1->CR1 |= I2C_CR1_START;				/**< Repeated START, then address + R		*/
+		}
+		else
+		{
+			I2C_Condition();
+			I2C_Complete(I2C_OK);
+		}
+	}
+}
+
+/**
+  * @brief	I2C1 error interrupt handler: AF (NACK), BERR, ARLO, OVR.
+  */
+void I2C1_ER_IRQHandler(void)
+{
+	const uint32_t sr1 = I2C1->SR1;
+
+	if (sr1 & I2C_SR1_OVR)
+		I2C1->SR1 = ~I2C_SR1_OVR;					/**< Cannot happen with clock stretching	*/
+
+	if (i2c_phase == I2C_PHASE_IDLE)
+	{
+		I2C1->SR1 = ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO);
+		return;
+	}
+
+	if (sr1 & (I2C_SR1_BERR | I2C_SR1_ARLO))
+	{
+		I2C1->SR1 = ~(I2C_SR1_BERR | I2C_SR1_ARLO);
+		I2C_Fail(I2C_EBUS);
+		return;
+	}
+
+	if (sr1 & I2C_SR1_AF)
+	{
+		I2C1->SR1 = ~I2C_SR1_AF;
+		I2C1->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+		I2C_DMA_Stop(DMA1_Stream6);
+		I2C_DMA_Stop(DMA1_Stream0);
+		i2c_tx_active = 0;
+		i2c_rx_active = 0;
+		I2C_Condition();							/**< Master may STOP or restart after a NACK */
+		I2C_Complete(I2C_ENACK);
+	}
+}
+
+/**
+  * @brief	DMA1 Stream0 interrupt handler: I2C1 read segment complete or transfer error.
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+	const uint32_t lisr = DMA1->LISR;
+
+	if ((lisr & (DMA_LISR_TEIF0 << I2C_RX_FLAG_POS)) && i2c_rx_active)
+	{
+		DMA1->LIFCR = 0x3DUL << I2C_RX_FLAG_POS;
+		I2C_Fail(I2C_EDMA);
+	}
+	else if ((lisr & (DMA_LISR_TCIF0 << I2C_RX_FLAG_POS)) && i2c_rx_active)
+		I2C_RX_Done();
+	else
+		DMA1->LIFCR = 0x3DUL << I2C_RX_FLAG_POS;	/**< Already handled on SB					*/
+}
+
+/**
+  * @brief	DMA1 Stream6 interrupt handler: I2C1 write segment transfer error.
+  * @note	The write segment ends on BTF, so TEIF is the only enabled source.
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+	const uint32_t hisr = DMA1->HISR;
+
+	DMA1->HIFCR = 0x3DUL << I2C_TX_FLAG_POS;
+	if ((hisr & (DMA_HISR_TEIF4 << I2C_TX_FLAG_POS)) && i2c_tx_active)
+		I2C_Fail(I2C_EDMA);
+}
+
+/**
+  * @brief	TIM14 interrupt handler: deferred START or job watchdog.
+  */
+void TIM8_TRG_COM_TIM14_IRQHandler(void)
+{
+	TIM14->SR = 0;
+
+	if (i2c_deferred)
+	{
+		i2c_deferred = 0;
+		if (i2c_phase == I2C_PHASE_IDLE && i2c_head != i2c_tail)
+			I2C_Kick();								/**< Defers again if STOP is still set		*/
+		return;
+	}
+
+	if (i2c_phase != I2C_PHASE_IDLE)
+	{
+		/* No progress: slave holding SCL/SDA, or BUSY stuck */
+		I2C_Fail(I2C_ETIMEOUT);
+	}
+}
@@ -0,0 +1,227 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	Queued I2C transactions with the on-board CS43L22 codec.
+  *
+  * 		This file initializes the system, board support package (BSP) and
+  * 		the I2C1 master, releases the CS43L22 from reset and reads its chip
+  * 		ID. The main loop then keeps eight write/read-back register jobs in
+  * 		flight on the codec's volume registers (they are chained with
+  * 		repeated STARTs), never waiting for the bus. Once per second it
+  * 		probes an absent address (NACK path) and prints over ITM stimulus
+  * 		port 0 (SWO on PB3):
+  *
+  * 		`ID,<chip id register>`
+  * 		`I2C,<jobs/s>,<nacks>,<bus errors>,<timeouts>,<recoveries>,<stops>,<mismatches>`
+  *
+  * 		The green LED toggles on every report; the red LED shows a wrong
+  * 		chip ID or a read-back mismatch.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "i2c.h"
+
+#define CODEC_ADDR			0x4AU		/**< CS43L22 (AD0 = 0)							*/
+#define CODEC_RESET_PIN		4U			/**< PD4, active low							*/
+#define CODEC_REG_ID		0x01U		/**< Chip ID and revision						*/
+#define CODEC_ID_MASK		0xF8U
+#define CODEC_ID			0xE0U		/**< Chip ID 11100b in bits 7..3				*/
+#define I2C_SPEED_HZ		100000UL	/**< CS43L22 control port maximum				*/
+#define ABSENT_ADDR			0x50U		/**< Nothing answers here on the DISC1			*/
+#define DEMO_SLOTS			8U			/**< Jobs kept in flight						*/
+
+/**
+  * @brief	One pipelined register test: write a value, then read it back.
+  */
+typedef struct {
+	I2C_Job_t	job;
+	uint8_t		tx[2];			/**< Register, value							*/
+	uint8_t		rx[1];			/**< Read-back									*/
+	uint8_t		reading;		/**< Job in flight is the read-back				*/
+} Demo_Slot_t;
+
+/** @brief	8-bit read/write codec registers: PCM A/B, master A/B, headphone A/B, speaker A/B volume. */
+static const uint8_t demo_reg[DEMO_SLOTS] = { 0x1A, 0x1B, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25 };
+
+static Demo_Slot_t demo_slot[DEMO_SLOTS];
+static uint32_t demo_mismatch;			/**< Read-back differs from the written value	*/
+
+/**************************  Static Function Prototypes  ***************************/
+static void Codec_Reset_Release(void);
+static void Demo_Next(Demo_Slot_t *slot, uint8_t value);
+static void ITM_Print(const char *str);
+static void ITM_PrintU32(uint32_t value);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs).
+  * 		3. Initializes I2C1 (100 kHz, DMA, watchdog) and releases the codec reset.
+  * 		4. Reads the codec chip ID.
+  * 		5. Enters an infinite loop: resubmits every finished job with the
+  * 		   next write or read-back, and reports once per second.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	uint8_t id_reg = CODEC_REG_ID, id = 0, value = 0;
+	I2C_Job_t id_job = { .addr = CODEC_ADDR, .tx = &id_reg, .tx_len = 1, .rx = &id, .rx_len = 1 };
+	I2C_Job_t probe = { .addr = ABSENT_ADDR, .status = I2C_OK };
+	I2C_Stats_t stats;
+	uint32_t last_jobs = 0;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+#if defined(QEMU_NETDUINOPLUS2)
+	ITM_Print("I2C,not emulated\n");	/**< No I2C, TIM14 or cycle counter in QEMU	*/
+	while (1);
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	/* Report period from the cycle counter */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	I2C_Init(I2C_SPEED_HZ);				/**< I2C1 on PB6/PB9, DMA1 S6/S0, TIM14	*/
+	Codec_Reset_Release();
+
+	I2C_Submit(&id_job);
+	while (id_job.status == I2C_PENDING)	/**< The only wait: ID before the test	*/
+		I2C_Poll();
+
+	ITM_Print("ID,");
+	ITM_PrintU32(id_job.status == I2C_OK ? id : 0xFFFFFFFFUL);
+	ITM_Print("\n");
+	if (id_job.status != I2C_OK || (id & CODEC_ID_MASK) != CODEC_ID)
+		BSP_LED_On(LED_RED);
+
+	for (uint32_t s = 0; s < DEMO_SLOTS; s++)
+	{
+		demo_slot[s].job.status = I2C_OK;
+		demo_slot[s].reading = 1;		/**< First pass starts with a write			*/
+		demo_slot[s].tx[0] = demo_reg[s];
+		demo_slot[s].tx[1] = 0;
+		demo_slot[s].rx[0] = 0;
+	}
+
+	uint32_t last = DWT->CYCCNT;
+
+	/**< Main loop */
+	while (1)
+	{
+		I2C_Poll();						/**< Bus recovery after an error			*/
+
+		for (uint32_t s = 0; s < DEMO_SLOTS; s++)
+		{
+			if (demo_slot[s].job.status != I2C_PENDING)
+				Demo_Next(&demo_slot[s], value++);
+		}
+
+		if (DWT->CYCCNT - last >= SystemCoreClock)
+		{
+			last += SystemCoreClock;
+
+			if (probe.status != I2C_PENDING)
+				I2C_Submit(&probe);		/**< Expected to end with I2C_ENACK		*/
+
+			I2C_GetStats(&stats);
+			ITM_Print("I2C,");
+			ITM_PrintU32(stats.jobs - last_jobs);
+			ITM_Print(",");
+			ITM_PrintU32(stats.nacks);
+			ITM_Print(",");
+			ITM_PrintU32(stats.bus_errors);
+			ITM_Print(",");
+			ITM_PrintU32(stats.timeouts);
+			ITM_Print(",");
+			ITM_PrintU32(stats.recoveries);
+			ITM_Print(",");
+			ITM_PrintU32(stats.stops);
+			ITM_Print(",");
+			ITM_PrintU32(demo_mismatch);
+			ITM_Print("\n");
+			last_jobs = stats.jobs;
+
+			BSP_LED_Toggle(LED_GREEN);
+			if (demo_mismatch)
+				BSP_LED_On(LED_RED);
+		}
+	}
+}
+
+/**
+  * @brief	Drive the CS43L22 reset line (PD4) high.
+  */
+static void Codec_Reset_Release(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIODEN;
+	GPIOD->MODER = (GPIOD->MODER & ~(3UL << (CODEC_RESET_PIN * 2))) | (1UL << (CODEC_RESET_PIN * 2));
+	GPIOD->BSRR  = 1UL << CODEC_RESET_PIN;
+}
+
+/**
+  * @brief	Check a finished slot and queue its next job.
+  * @param[in,out] slot	Slot whose job is no longer pending.
+  * @param[in] value	Value for the next write.
+  */
+static void Demo_Next(Demo_Slot_t *slot, uint8_t value)
+{
+	I2C_Job_t *job = &slot->job;
+
+	if (slot->reading)
+	{
+		if (job->status == I2C_OK && job->rx_len && slot->rx[0] != slot->tx[1])
+			demo_mismatch++;
+
+		slot->tx[1] = value;			/**< Write: register, value					*/
+		*job = (I2C_Job_t){ .addr = CODEC_ADDR, .tx = slot->tx, .tx_len = 2 };
+		slot->reading = 0;
+	}
+	else
+	{
+		/* Read back: register, repeated START, one byte */
+		*job = (I2C_Job_t){ .addr = CODEC_ADDR, .tx = slot->tx, .tx_len = 1, .rx = slot->rx, .rx_len = 1 };
+		slot->reading = 1;
+	}
+
+	if (I2C_Submit(job) != I2C_OK)
+	{
+		slot->reading ^= 1U;			/**< Queue full: same step on the next pass	*/
+		job->rx_len = 0;				/**< Nothing to compare						*/
+		job->status = I2C_OK;
+	}
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write an unsigned decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf);
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	ITM_Print(&buf[i]);
+}
@@ -0,0 +1,178 @@
+/**
+  * @file	spi_bus.h
+  * @author	Parham Estiri
+  * @brief	Shared SPI bus scheduler: per-device settings, chip-select
+  * 		management and DMA chaining on SPI1, SPI2 and SPI3.
+  *
+  * 		This module provides:
+  * 		 - Devices with their own mode (CPOL/CPHA), clock limit and CS pin;
+  * 		   CR1 is rewritten only when the device changes
+  * 		 - A transfer queue per bus shared by every device on it
+  * 		 - Full-duplex DMA for large transfers (any length: chunks of
+  * 		   65535 bytes under one CS) and a polled, interrupt-free path for
+  * 		   transfers up to SPI_POLL_MAX bytes
+  * 		 - An optional command header (up to 8 bytes, sent first under the
+  * 		   same CS) so reads need no padded TX buffer
+  * 		 - CS released through BSRR in the DMA completion interrupt, which
+  * 		   then starts the next queued transfer back-to-back
+  *
+  * 		| Bus  | SCK  | MISO | MOSI | AF | RX DMA              | TX DMA              |
+  * 		|------|------|------|------|----|---------------------|---------------------|
+  * 		| SPI1 | PA5  | PA6  | PA7  | 5  | DMA2 Stream0, ch 3  | DMA2 Stream3, ch 3  |
+  * 		| SPI2 | PB13 | PB14 | PB15 | 5  | DMA1 Stream3, ch 0  | DMA1 Stream4, ch 0  |
+  * 		| SPI3 | PC10 | PC11 | PC12 | 6  | DMA1 Stream0, ch 0  | DMA1 Stream5, ch 0  |
+  *
+  * @note	SPI1 runs from APB2 (84 MHz, SCK up to 42 MHz); SPI2 and SPI3 run
+  * 		from APB1 (42 MHz, SCK up to 21 MHz).
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef SPI_BUS_H_
+#define SPI_BUS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define SPI_QUEUE				16U			/**< Transfers waiting per bus (power of two)	*/
+#define SPI_POLL_MAX			16U			/**< Largest transfer sent without DMA			*/
+#define SPI_HEADER_MAX			8U			/**< Command header bytes						*/
+#define SPI_DMA_PRIORITY		0x02U		/**< RX complete: CS release and chaining		*/
+#define SPI_FILL_BYTE			0xFFU		/**< Sent when a transfer has no TX buffer		*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	SPI buses.
+  */
+typedef enum {
+	SPI_BUS_1		= 0,
+	SPI_BUS_2		= 1,
+	SPI_BUS_3		= 2,
+	SPI_BUSES		= 3
+} SPI_Bus_t;
+
+/**
+  * @brief	Clock polarity and phase.
+  */
+typedef enum {
+	SPI_MODE_0		= 0,	/**< CPOL = 0, CPHA = 0					*/
+	SPI_MODE_1		= 1,	/**< CPOL = 0, CPHA = 1					*/
+	SPI_MODE_2		= 2,	/**< CPOL = 1, CPHA = 0					*/
+	SPI_MODE_3		= 3		/**< CPOL = 1, CPHA = 1					*/
+} SPI_Mode_t;
+
+/**
+  * @brief	Transfer status.
+  */
+typedef enum {
+	SPI_OK			= 0,	/**< Completed										*/
+	SPI_PENDING		= 1,	/**< Queued or running								*/
+	SPI_EINVAL		= 2,	/**< Bad parameter									*/
+	SPI_EFULL		= 3		/**< Queue full										*/
+} SPI_Status_t;
+
+/**
+  * @brief	Device on a bus (filled by SPI_Device_Init()).
+  */
+typedef struct {
+	SPI_Bus_t		bus;		/**< Bus the device is wired to				*/
+	GPIO_TypeDef	*cs_port;	/**< Chip-select port (active low)			*/
+	uint32_t		cs_pin;		/**< Chip-select pin number					*/
+	uint32_t		cr1;		/**< Mode and baud rate bits of SPI_CR1		*/
+	uint32_t		sck_hz;		/**< SCK actually used						*/
+} SPI_Device_t;
+
+struct SPI_Xfer;
+
+/**
+  * @brief	Completion callback (interrupt context for DMA transfers).
+  */
+typedef void (*SPI_Callback_t)(struct SPI_Xfer *xfer);
+
+/**
+  * @brief	Transfer: CS low, header[], then len bytes full-duplex, CS high.
+  *
+  * 		tx = NULL sends SPI_FILL_BYTE, rx = NULL discards what is read.
+  * 		The transfer and its buffers must stay valid until status leaves
+  * 		SPI_PENDING.
+  */
+typedef struct SPI_Xfer {
+	SPI_Device_t			*dev;		/**< Target device							*/
+	uint8_t					header[SPI_HEADER_MAX];	/**< Command/address bytes		*/
+	uint8_t					header_len;
+	const uint8_t			*tx;		/**< Data sent (may be NULL)				*/
+	uint8_t					*rx;		/**< Data received (may be NULL)			*/
+	uint32_t				len;		/**< Data bytes								*/
+	SPI_Callback_t			callback;	/**< Called on completion (may be NULL)		*/
+	void					*arg;		/**< Free for the caller					*/
+	volatile SPI_Status_t	status;		/**< Set by the driver						*/
+	uint32_t				done;		/**< Driver: data bytes already moved		*/
+} SPI_Xfer_t;
+
+/**
+  * @brief	Bus statistics.
+  */
+typedef struct {
+	uint32_t	xfers;			/**< Transfers completed						*/
+	uint32_t	polled;			/**< ... of which without DMA					*/
+	uint32_t	bytes;			/**< Header and data bytes						*/
+	uint32_t	switches;		/**< CR1 reconfigurations (device changes)		*/
+} SPI_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure a bus: pins, SPI master, DMA streams.
+  * @param[in] bus	Bus.
+  * @retval	SPI_OK or SPI_EINVAL.
+  */
+SPI_Status_t SPI_Bus_Init(SPI_Bus_t bus);
+
+/**
+  * @brief	Describe a device and configure its chip-select pin (released).
+  * @param[out] dev		Device.
+  * @param[in] bus		Bus (initialized).
+  * @param[in] cs_port	Chip-select port.
+  * @param[in] cs_pin	Chip-select pin number.
+  * @param[in] mode		Clock polarity and phase.
+  * @param[in] max_hz	Highest SCK the device accepts.
+  * @retval	SPI_OK or SPI_EINVAL (max_hz below the slowest divider).
+  */
+SPI_Status_t SPI_Device_Init(SPI_Device_t *dev, SPI_Bus_t bus, GPIO_TypeDef *cs_port, uint32_t cs_pin,
+							 SPI_Mode_t mode, uint32_t max_hz);
+
+/**
+  * @brief	Queue a transfer; it runs at once if its bus is idle.
+  * @param[in,out] xfer	Transfer (status set to SPI_PENDING).
+  * @retval	SPI_OK, SPI_EINVAL or SPI_EFULL.
+  * @note	When the bus is idle, polled transfers run to completion inside
+  * 		this call (no interrupt); DMA transfers return at once.
+  */
+SPI_Status_t SPI_Submit(SPI_Xfer_t *xfer);
+
+/**
+  * @brief	Number of transfers queued or running on a bus.
+  * @param[in] bus	Bus.
+  * @retval	Pending transfers, 0 for an invalid bus.
+  */
+uint32_t SPI_Pending(SPI_Bus_t bus);
+
+/**
+  * @brief	Copy the statistics of a bus.
+  * @param[in] bus		Bus.
+  * @param[out] stats	Statistics, zeroed for an invalid bus.
+  * @retval	None
+  */
+void SPI_GetStats(SPI_Bus_t bus, SPI_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SPI_BUS_H_ */
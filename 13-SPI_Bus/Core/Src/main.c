@@ -0,0 +1,232 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	Two devices contending for SPI1: LIS3DSH polling and bulk DMA.
+  *
+  * 		This file initializes the system, board support package (BSP),
+  * 		SPI1 and two devices on it:
+  * 		 - The on-board LIS3DSH accelerometer (CS PE3, mode 3, <= 10 MHz):
+  * 		   7-byte reads (header + 6 data bytes) take the polled path
+  * 		 - A bulk device (CS PE2, mode 0, 42 MHz), standing for an external
+  * 		   flash or display: 4 KiB full-duplex transfers take the DMA path
+  *
+  * 		The main loop only resubmits finished transfers; the bus switches
+  * 		CR1 between the two devices and chains the queue from the DMA
+  * 		interrupt. Once per second it prints over ITM stimulus port 0
+  * 		(SWO on PB3):
+  *
+  * 		`ID,<WHO_AM_I>`
+  * 		`ACC,<x>,<y>,<z>` (raw, ±2 g full scale: 1 LSB = 0.06 mg)
+  * 		`SPI,<transfers/s>,<polled/s>,<bytes/s>,<device switches/s>,<bus use per mille>`
+  *
+  * 		The green LED toggles on every report; the red LED shows a wrong
+  * 		WHO_AM_I.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "spi_bus.h"
+
+#define LIS_CS_PIN			3U			/**< PE3										*/
+#define LIS_MAX_HZ			10000000UL	/**< LIS3DSH SPI clock limit					*/
+#define LIS_READ			0x80U		/**< Address bit 7: read						*/
+#define LIS_WHO_AM_I		0x0FU
+#define LIS_ID				0x3FU
+#define LIS_CTRL_REG4		0x20U		/**< ODR, BDU, axis enable						*/
+#define LIS_CTRL_REG4_VAL	0x97U		/**< 1600 Hz, X/Y/Z on							*/
+#define LIS_CTRL_REG6		0x25U
+#define LIS_CTRL_REG6_VAL	0x10U		/**< ADD_INC: address auto-increment			*/
+#define LIS_OUT_X_L			0x28U		/**< X, Y, Z: six bytes, little-endian			*/
+
+#define BULK_CS_PIN			2U			/**< PE2										*/
+#define BULK_MAX_HZ			42000000UL	/**< Fastest SPI1 clock							*/
+#define BULK_LEN			4096U		/**< Bytes per bulk transfer					*/
+#define BULK_XFERS			2U			/**< Bulk transfers kept queued					*/
+
+static SPI_Device_t lis;				/**< Accelerometer								*/
+static SPI_Device_t bulk;				/**< Bulk device								*/
+static uint8_t bulk_tx[BULK_XFERS][BULK_LEN];
+static uint8_t bulk_rx[BULK_XFERS][BULK_LEN];
+
+/**************************  Static Function Prototypes  ***************************/
+static void LIS_Write(uint8_t reg, uint8_t value);
+static uint8_t LIS_Read(uint8_t reg);
+static void ITM_Print(const char *str);
+static void ITM_PrintU32(uint32_t value);
+static void ITM_PrintS32(int32_t value);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs).
+  * 		3. Initializes SPI1, the LIS3DSH and the bulk device.
+  * 		4. Checks WHO_AM_I and starts the accelerometer at 1600 Hz.
+  * 		5. Enters an infinite loop: resubmits the accelerometer read and
+  * 		   the bulk transfers as soon as they finish, reports once per second.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	SPI_Xfer_t acc = { .dev = &lis, .header = { LIS_OUT_X_L | LIS_READ }, .header_len = 1, .len = 6,
+					   .status = SPI_OK };
+	SPI_Xfer_t big[BULK_XFERS];
+	uint8_t xyz[6] = { 0 };
+	SPI_Stats_t stats, prev = { 0 };
+	uint32_t acc_reads = 0, bulk_bytes = 0;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+#if defined(QEMU_NETDUINOPLUS2)
+	ITM_Print("SPI,not emulated\n");	/**< No GPIO, DMA or cycle counter in QEMU	*/
+	while (1);
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	/* Report period from the cycle counter */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOEEN;
+	SPI_Bus_Init(SPI_BUS_1);
+	SPI_Device_Init(&lis,  SPI_BUS_1, GPIOE, LIS_CS_PIN,  SPI_MODE_3, LIS_MAX_HZ);
+	SPI_Device_Init(&bulk, SPI_BUS_1, GPIOE, BULK_CS_PIN, SPI_MODE_0, BULK_MAX_HZ);
+
+	const uint8_t id = LIS_Read(LIS_WHO_AM_I);
+	ITM_Print("ID,");
+	ITM_PrintU32(id);
+	ITM_Print("\n");
+	if (id != LIS_ID)
+		BSP_LED_On(LED_RED);
+	LIS_Write(LIS_CTRL_REG6, LIS_CTRL_REG6_VAL);
+	LIS_Write(LIS_CTRL_REG4, LIS_CTRL_REG4_VAL);
+
+	acc.rx = xyz;
+	for (uint32_t b = 0; b < BULK_XFERS; b++)
+	{
+		for (uint32_t i = 0; i < BULK_LEN; i++)
+			bulk_tx[b][i] = (uint8_t)(i + b);
+		big[b] = (SPI_Xfer_t){ .dev = &bulk, .tx = bulk_tx[b], .rx = bulk_rx[b], .len = BULK_LEN,
+							   .status = SPI_OK };
+	}
+
+	uint32_t last = DWT->CYCCNT;
+
+	/**< Main loop */
+	while (1)
+	{
+		if (acc.status != SPI_PENDING && SPI_Submit(&acc) == SPI_OK)
+			acc_reads++;
+
+		for (uint32_t b = 0; b < BULK_XFERS; b++)
+		{
+			if (big[b].status != SPI_PENDING && SPI_Submit(&big[b]) == SPI_OK)
+				bulk_bytes += BULK_LEN;
+		}
+
+		if (DWT->CYCCNT - last >= SystemCoreClock)
+		{
+			last += SystemCoreClock;
+			SPI_GetStats(SPI_BUS_1, &stats);
+
+			/* Bus time actually clocked: bits / SCK of each device, in µs per second */
+			const uint64_t busy_us = (uint64_t)acc_reads * 7U * 8U * 1000000U / lis.sck_hz
+								   + (uint64_t)bulk_bytes * 8U * 1000000U / bulk.sck_hz;
+			acc_reads = 0;
+			bulk_bytes = 0;
+
+			ITM_Print("ACC,");
+			ITM_PrintS32((int16_t)(xyz[0] | (xyz[1] << 8)));
+			ITM_Print(",");
+			ITM_PrintS32((int16_t)(xyz[2] | (xyz[3] << 8)));
+			ITM_Print(",");
+			ITM_PrintS32((int16_t)(xyz[4] | (xyz[5] << 8)));
+			ITM_Print("\n");
+
+			ITM_Print("SPI,");
+			ITM_PrintU32(stats.xfers - prev.xfers);
+			ITM_Print(",");
+			ITM_PrintU32(stats.polled - prev.polled);
+			ITM_Print(",");
+			ITM_PrintU32(stats.bytes - prev.bytes);
+			ITM_Print(",");
+			ITM_PrintU32(stats.switches - prev.switches);
+			ITM_Print(",");
+			ITM_PrintU32((uint32_t)(busy_us / 1000U));
+			ITM_Print("\n");
+			prev = stats;
+
+			BSP_LED_Toggle(LED_GREEN);
+		}
+	}
+}
+
+/**
+  * @brief	Write one LIS3DSH register (polled path, returns when done).
+  */
+static void LIS_Write(uint8_t reg, uint8_t value)
+{
+	SPI_Xfer_t x = { .dev = &lis, .header = { reg, value }, .header_len = 2 };
+
+	SPI_Submit(&x);
+	while (x.status == SPI_PENDING);
+}
+
+/**
+  * @brief	Read one LIS3DSH register (polled path, returns when done).
+  */
+static uint8_t LIS_Read(uint8_t reg)
+{
+	uint8_t value = 0;
+	SPI_Xfer_t x = { .dev = &lis, .header = { reg | LIS_READ }, .header_len = 1, .rx = &value, .len = 1 };
+
+	SPI_Submit(&x);
+	while (x.status == SPI_PENDING);
+	return value;
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write an unsigned decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf);
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	ITM_Print(&buf[i]);
+}
+
+/**
+  * @brief	Write a signed decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintS32(int32_t value)
+{
+	if (value < 0)
+	{
+		ITM_Print("-");
+		ITM_PrintU32((uint32_t)(-(int64_t)value));
+	}
+	else
+		ITM_PrintU32((uint32_t)value);
+}
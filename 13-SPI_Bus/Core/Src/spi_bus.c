@@ -0,0 +1,464 @@
+/**
+  * @file	spi_bus.c
+  * @author	Parham Estiri
+  * @brief	Shared SPI bus scheduler: per-device settings, chip-select
+  * 		management and DMA chaining on SPI1, SPI2 and SPI3.
+  *
+  * 		This file provides:
+  * 		 - Bus table (SPI instance, pins, DMA streams) and initialization
+  * 		 - The run loop that owns a bus while its queue is not empty: it
+  * 		   selects the device, drives CS, sends the header, and either
+  * 		   finishes a small transfer by polling or hands over to DMA
+  * 		 - RX DMA transfer-complete handlers that release CS and re-enter
+  * 		   the run loop, so queued transfers follow each other without
+  * 		   returning to the main loop
+  *
+  * 		Ownership: SPI_Submit() starts the run loop only when the bus is
+  * 		idle (busy flag taken with interrupts masked). The loop gives the
+  * 		bus back when the queue is empty, or passes it to the DMA
+  * 		interrupt when a DMA transfer is started.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "spi_bus.h"
+
+#define SPI_QUEUE_MASK		(SPI_QUEUE - 1UL)
+#define SPI_DMA_CHUNK		65535UL			/**< NDTR limit								*/
+#define SPI_BSY_POLLS		1024UL			/**< >= one SCK at /256 on APB1 (1024 HCLK)	*/
+
+/**
+  * @brief	Static description of a bus.
+  */
+typedef struct {
+	SPI_TypeDef			*spi;			/**< SPI instance							*/
+	GPIO_TypeDef		*port;			/**< SCK/MISO/MOSI port						*/
+	uint32_t			sck;			/**< Pin numbers							*/
+	uint32_t			miso;
+	uint32_t			mosi;
+	uint32_t			af;				/**< Alternate function						*/
+	uint32_t			gpio_en;		/**< RCC_AHB1ENR port clock bit				*/
+	uint8_t				apb2;			/**< 1: clock on APB2, 0: APB1				*/
+	uint32_t			spi_en;			/**< RCC_APBxENR SPI clock bit				*/
+	DMA_TypeDef			*dma;			/**< DMA controller							*/
+	uint32_t			dma_en;			/**< RCC_AHB1ENR DMA clock bit				*/
+	DMA_Stream_TypeDef	*rx_stream;
+	uint32_t			rx_n;			/**< RX stream number						*/
+	DMA_Stream_TypeDef	*tx_stream;
+	uint32_t			tx_n;			/**< TX stream number						*/
+	uint32_t			channel;		/**< Request channel for both streams		*/
+	IRQn_Type			rx_irq;
+} SPI_Def_t;
+
+/**
+  * @brief	Run-time state of a bus.
+  */
+typedef struct {
+	SPI_Xfer_t			*queue[SPI_QUEUE];	/**< Tail entry is the running transfer	*/
+	volatile uint32_t	head;				/**< Next free slot (absolute)			*/
+	volatile uint32_t	tail;				/**< Running transfer (absolute)		*/
+	volatile uint8_t	busy;				/**< Run loop or DMA owns the bus		*/
+	uint32_t			cr1;				/**< Device settings currently in CR1	*/
+	uint32_t			chunk;				/**< Bytes of the DMA transfer running	*/
+	SPI_Stats_t			stats;
+} SPI_State_t;
+
+/** @brief	Buses (see the table in spi_bus.h). */
+static const SPI_Def_t spi_def[SPI_BUSES] = {
+		[SPI_BUS_1] = { SPI1, GPIOA,  5,  6,  7, 5, RCC_AHB1ENR_GPIOAEN, 1, RCC_APB2ENR_SPI1EN,
+						DMA2, RCC_AHB1ENR_DMA2EN, DMA2_Stream0, 0, DMA2_Stream3, 3, 3, DMA2_Stream0_IRQn },
+		[SPI_BUS_2] = { SPI2, GPIOB, 13, 14, 15, 5, RCC_AHB1ENR_GPIOBEN, 0, RCC_APB1ENR_SPI2EN,
+						DMA1, RCC_AHB1ENR_DMA1EN, DMA1_Stream3, 3, DMA1_Stream4, 4, 0, DMA1_Stream3_IRQn },
+		[SPI_BUS_3] = { SPI3, GPIOC, 10, 11, 12, 6, RCC_AHB1ENR_GPIOCEN, 0, RCC_APB1ENR_SPI3EN,
+						DMA1, RCC_AHB1ENR_DMA1EN, DMA1_Stream0, 0, DMA1_Stream5, 5, 0, DMA1_Stream0_IRQn }
+};
+
+/** @brief	Flag offset of a stream inside LISR/HISR (streams 0/4, 1/5, 2/6, 3/7). */
+static const uint8_t spi_dma_flag_pos[4] = { 0U, 6U, 16U, 22U };
+
+static SPI_State_t spi_state[SPI_BUSES];
+static const uint8_t spi_fill = SPI_FILL_BYTE;		/**< TX source when tx == NULL			*/
+static uint8_t spi_discard;							/**< RX sink when rx == NULL			*/
+
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t SPI_Clock(SPI_Bus_t bus);
+static void SPI_Pin_AF(GPIO_TypeDef *port, uint32_t pin, uint32_t af);
+static void SPI_Run(SPI_Bus_t bus);
+static void SPI_Poll(SPI_TypeDef *spi, const uint8_t *tx, uint8_t *rx, uint32_t len);
+static void SPI_DMA_Chunk(SPI_Bus_t bus, SPI_Xfer_t *xfer);
+static void SPI_DMA_ClearFlags(const SPI_Def_t *d, uint32_t n);
+static void SPI_Finish(SPI_Bus_t bus, SPI_Xfer_t *xfer);
+static void SPI_DMA_IRQHandler(SPI_Bus_t bus);
+
+/**
+  * @brief	Configure a bus: pins, SPI master, DMA streams.
+  * @param[in] bus	Bus.
+  * @retval	SPI_OK or SPI_EINVAL.
+  */
+SPI_Status_t SPI_Bus_Init(SPI_Bus_t bus)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+
+	if (bus >= SPI_BUSES)
+		return SPI_EINVAL;
+
+	const SPI_Def_t *d = &spi_def[bus];
+
+	RCC->AHB1ENR |= d->gpio_en | d->dma_en;
+	if (d->apb2)
+		RCC->APB2ENR |= d->spi_en;
+	else
+		RCC->APB1ENR |= d->spi_en;
+
+	SPI_Pin_AF(d->port, d->sck,  d->af);
+	SPI_Pin_AF(d->port, d->miso, d->af);
+	SPI_Pin_AF(d->port, d->mosi, d->af);
+
+	d->spi->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI;	/**< Master, NSS in software (CS on GPIO)	*/
+	d->spi->CR2 = 0;
+	spi_state[bus] = (SPI_State_t){ 0 };
+
+	NVIC_SetPriority(d->rx_irq, NVIC_EncodePriority(PG, SPI_DMA_PRIORITY, 0));
+	NVIC_EnableIRQ(d->rx_irq);
+
+	return SPI_OK;
+}
+
+/**
+  * @brief	Describe a device and configure its chip-select pin (released).
+  * @param[out] dev		Device.
+  * @param[in] bus		Bus (initialized).
+  * @param[in] cs_port	Chip-select port.
+  * @param[in] cs_pin	Chip-select pin number.
+  * @param[in] mode		Clock polarity and phase.
+  * @param[in] max_hz	Highest SCK the device accepts.
+  * @retval	SPI_OK or SPI_EINVAL (max_hz below the slowest divider).
+  */
+SPI_Status_t SPI_Device_Init(SPI_Device_t *dev, SPI_Bus_t bus, GPIO_TypeDef *cs_port, uint32_t cs_pin,
+							 SPI_Mode_t mode, uint32_t max_hz)
+{
+	if (bus >= SPI_BUSES || cs_pin > 15U || mode > SPI_MODE_3)
+		return SPI_EINVAL;
+
+	const uint32_t pclk = SPI_Clock(bus);
+	uint32_t br = 0;
+
+	while (br < 7U && (pclk >> (br + 1U)) > max_hz)	/**< SCK = PCLK / 2^(BR + 1)			*/
+		br++;
+	if ((pclk >> (br + 1U)) > max_hz)
+		return SPI_EINVAL;
+
+	dev->bus     = bus;
+	dev->cs_port = cs_port;
+	dev->cs_pin  = cs_pin;
+	dev->sck_hz  = pclk >> (br + 1U);
+	dev->cr1     = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI
+				 | (br << SPI_CR1_BR_Pos)
+				 | ((mode & 2U) ? SPI_CR1_CPOL : 0U)
+				 | ((mode & 1U) ? SPI_CR1_CPHA : 0U);
+
+	/* CS: released before it becomes an output, push-pull, fast edges */
+	cs_port->BSRR     = 1UL << cs_pin;
+	cs_port->OTYPER  &= ~(1UL << cs_pin);
+	cs_port->OSPEEDR |= 3UL << (cs_pin * 2);
+	cs_port->MODER    = (cs_port->MODER & ~(3UL << (cs_pin * 2))) | (1UL << (cs_pin * 2));
+
+	return SPI_OK;
+}
+
+/**
+  * @brief	Queue a transfer; it runs at once if its bus is idle.
+  * @param[in,out] xfer	Transfer (status set to SPI_PENDING).
+  * @retval	SPI_OK, SPI_EINVAL or SPI_EFULL.
+  */
+SPI_Status_t SPI_Submit(SPI_Xfer_t *xfer)
+{
+	if (!xfer || !xfer->dev || xfer->dev->bus >= SPI_BUSES || xfer->header_len > SPI_HEADER_MAX)
+		return SPI_EINVAL;
+
+	const SPI_Bus_t bus = xfer->dev->bus;
+	SPI_State_t *st = &spi_state[bus];
+	uint8_t start = 0;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (st->head - st->tail >= SPI_QUEUE)
+	{
+		__set_PRIMASK(primask);
+		return SPI_EFULL;
+	}
+	xfer->status = SPI_PENDING;
+	st->queue[st->head & SPI_QUEUE_MASK] = xfer;
+	st->head++;
+	if (!st->busy)
+	{
+		st->busy = 1;								/**< This call becomes the bus owner		*/
+		start = 1;
+	}
+
+	__set_PRIMASK(primask);
+
+	if (start)
+		SPI_Run(bus);
+
+	return SPI_OK;
+}
+
+/**
+  * @brief	Number of transfers queued or running on a bus.
+  * @param[in] bus	Bus.
+  * @retval	Pending transfers, 0 for an invalid bus.
+  */
+uint32_t SPI_Pending(SPI_Bus_t bus)
+{
+	if (bus >= SPI_BUSES)
+		return 0;
+
+	return spi_state[bus].head - spi_state[bus].tail;
+}
+
+/**
+  * @brief	Copy the statistics of a bus.
+  * @param[in] bus		Bus.
+  * @param[out] stats	Statistics, zeroed for an invalid bus.
+  * @retval	None
+  */
+void SPI_GetStats(SPI_Bus_t bus, SPI_Stats_t *stats)
+{
+	if (!stats)
+		return;
+
+	if (bus >= SPI_BUSES)
+	{
+		*stats = (SPI_Stats_t){ 0 };
+		return;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	*stats = spi_state[bus].stats;
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief	Kernel clock of a bus (PCLK2 for SPI1, PCLK1 for SPI2/SPI3).
+  */
+static uint32_t SPI_Clock(SPI_Bus_t bus)
+{
+	const uint32_t cfgr = RCC->CFGR;
+
+	if (spi_def[bus].apb2)
+		return SystemCoreClock >> APBPrescTable[(cfgr & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+	return SystemCoreClock >> APBPrescTable[(cfgr & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+/**
+  * @brief	Put a pin in alternate-function mode, push-pull, very high speed.
+  */
+static void SPI_Pin_AF(GPIO_TypeDef *port, uint32_t pin, uint32_t af)
+{
+	port->MODER    = (port->MODER & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+	port->OTYPER  &= ~(1UL << pin);
+	port->OSPEEDR |= 3UL << (pin * 2);
+	port->AFR[pin >> 3] = (port->AFR[pin >> 3] & ~(0xFUL << ((pin & 7U) * 4))) | (af << ((pin & 7U) * 4));
+}
+
+/**
+  * @brief	Run queued transfers until the queue is empty or DMA takes over.
+  * @param[in] bus	Bus (caller owns it: busy = 1).
+  * @retval	None
+  */
+static void SPI_Run(SPI_Bus_t bus)
+{
+	const SPI_Def_t *d = &spi_def[bus];
+	SPI_State_t *st = &spi_state[bus];
+
+	for (;;)
+	{
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		if (st->head == st->tail)
+		{
+			st->busy = 0;							/**< Next SPI_Submit() starts the loop		*/
+			__set_PRIMASK(primask);
+			return;
+		}
+		SPI_Xfer_t *xfer = st->queue[st->tail & SPI_QUEUE_MASK];
+		__set_PRIMASK(primask);
+
+		const SPI_Device_t *dev = xfer->dev;
+
+		/* Device settings: CPOL/CPHA/BR may only change while SPE = 0 */
+		if (st->cr1 != dev->cr1)
+		{
+			d->spi->CR1 = dev->cr1;
+			d->spi->CR1 = dev->cr1 | SPI_CR1_SPE;	/**< SCK idles at the new CPOL before CS	*/
+			st->cr1 = dev->cr1;
+			st->stats.switches++;
+		}
+
+		dev->cs_port->BSRR = 1UL << (dev->cs_pin + 16U);	/**< CS low							*/
+
+		if (xfer->header_len)
+			SPI_Poll(d->spi, xfer->header, NULL, xfer->header_len);
+		xfer->done = 0;
+
+		if (xfer->len > SPI_POLL_MAX)
+		{
+			SPI_DMA_Chunk(bus, xfer);				/**< The RX interrupt continues the loop	*/
+			return;
+		}
+
+		SPI_Poll(d->spi, xfer->tx, xfer->rx, xfer->len);
+		st->stats.polled++;
+		SPI_Finish(bus, xfer);
+	}
+}
+
+/**
+  * @brief	Full-duplex transfer by polling TXE/RXNE (small transfers).
+  *
+  * 		Keeps one byte in the shift register and one in the TX buffer, so
+  * 		bytes follow each other without gaps. Interrupts are masked for
+  * 		the duration: an interrupt between two RXNE reads would overrun.
+  */
+static void SPI_Poll(SPI_TypeDef *spi, const uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+	uint32_t t = 0, r = 0;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	while (r < len)
+	{
+		if (t < len && t - r < 2U && (spi->SR & SPI_SR_TXE))
+		{
+			*(volatile uint8_t *)&spi->DR = tx ? tx[t] : SPI_FILL_BYTE;
+			t++;
+		}
+		if (spi->SR & SPI_SR_RXNE)
+		{
+			const uint8_t b = *(volatile uint8_t *)&spi->DR;
+			if (rx)
+				rx[r] = b;
+			r++;
+		}
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief	Start the next DMA chunk (up to 65535 bytes) of a transfer.
+  */
+static void SPI_DMA_Chunk(SPI_Bus_t bus, SPI_Xfer_t *xfer)
+{
+	const SPI_Def_t *d = &spi_def[bus];
+	SPI_State_t *st = &spi_state[bus];
+	const uint32_t n = (xfer->len - xfer->done > SPI_DMA_CHUNK) ? SPI_DMA_CHUNK : xfer->len - xfer->done;
+	const uint32_t cr = (d->channel << DMA_SxCR_CHSEL_Pos)
+					  | DMA_SxCR_PL_1;				/**< High priority, byte transfers			*/
+
+	st->chunk = n;
+	SPI_DMA_ClearFlags(d, d->rx_n);
+	SPI_DMA_ClearFlags(d, d->tx_n);
+
+	d->rx_stream->PAR  = (uint32_t)&d->spi->DR;
+	d->rx_stream->M0AR = xfer->rx ? (uint32_t)&xfer->rx[xfer->done] : (uint32_t)&spi_discard;
+	d->rx_stream->NDTR = n;
+	d->rx_stream->FCR  = 0;
+	d->rx_stream->CR   = cr | (xfer->rx ? DMA_SxCR_MINC : 0U) | DMA_SxCR_TCIE;
+
+	d->tx_stream->PAR  = (uint32_t)&d->spi->DR;
+	d->tx_stream->M0AR = xfer->tx ? (uint32_t)&xfer->tx[xfer->done] : (uint32_t)&spi_fill;
+	d->tx_stream->NDTR = n;
+	d->tx_stream->FCR  = 0;
+	d->tx_stream->CR   = cr | (xfer->tx ? DMA_SxCR_MINC : 0U) | DMA_SxCR_DIR_0;	/**< Memory to peripheral	*/
+
+	/* RM0090 order: RX request first, both streams, then TX request */
+	d->spi->CR2 = SPI_CR2_RXDMAEN;
+	d->rx_stream->CR |= DMA_SxCR_EN;
+	d->tx_stream->CR |= DMA_SxCR_EN;
+	d->spi->CR2 = SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+}
+
+/**
+  * @brief	Clear TC, HT, TE, DME and FE of a stream.
+  */
+static void SPI_DMA_ClearFlags(const SPI_Def_t *d, uint32_t n)
+{
+	volatile uint32_t *ifcr = (n < 4U) ? &d->dma->LIFCR : &d->dma->HIFCR;
+	*ifcr = 0x3DUL << spi_dma_flag_pos[n & 3U];
+}
+
+/**
+  * @brief	Release CS and retire the running transfer.
+  * @note	Called once the last byte has been received (RXNE polled, or RX
+  * 		DMA complete), so every bit is already on the wire: BSY only
+  * 		covers the end of the last SCK period. The wait is bounded so a
+  * 		stuck BSY (mode fault, bad clock) cannot hang the DMA interrupt.
+  */
+static void SPI_Finish(SPI_Bus_t bus, SPI_Xfer_t *xfer)
+{
+	const SPI_Def_t *d = &spi_def[bus];
+	SPI_State_t *st = &spi_state[bus];
+
+	for (uint32_t n = SPI_BSY_POLLS; n && (d->spi->SR & SPI_SR_BSY); n--);	/**< Last SCK edge	*/
+	xfer->dev->cs_port->BSRR = 1UL << xfer->dev->cs_pin;	/**< CS high						*/
+
+	st->stats.xfers++;
+	st->stats.bytes += xfer->header_len + xfer->len;
+	st->tail++;
+	xfer->status = SPI_OK;
+	if (xfer->callback)
+		xfer->callback(xfer);						/**< May submit: the run loop picks it up	*/
+}
+
+/**
+  * @brief	RX DMA transfer complete: next chunk, or CS release and the next transfer.
+  * @param[in] bus	Bus.
+  * @retval	None
+  */
+static void SPI_DMA_IRQHandler(SPI_Bus_t bus)
+{
+	const SPI_Def_t *d = &spi_def[bus];
+	SPI_State_t *st = &spi_state[bus];
+	SPI_Xfer_t *xfer = st->queue[st->tail & SPI_QUEUE_MASK];
+
+	SPI_DMA_ClearFlags(d, d->rx_n);
+	d->spi->CR2 = 0;
+	xfer->done += st->chunk;
+
+	if (xfer->done < xfer->len)
+	{
+		SPI_DMA_Chunk(bus, xfer);					/**< Same CS, next 64 KiB					*/
+		return;
+	}
+
+	SPI_Finish(bus, xfer);
+	SPI_Run(bus);									/**< Chain the queue from the interrupt		*/
+}
+
+/**
+  * @brief	DMA2 Stream0 interrupt handler (SPI1 RX).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+	SPI_DMA_IRQHandler(SPI_BUS_1);
+}
+
+/**
+  * @brief	DMA1 Stream3 interrupt handler (SPI2 RX).
+  */
+void DMA1_Stream3_IRQHandler(void)
+{
+	SPI_DMA_IRQHandler(SPI_BUS_2);
+}
+
+/**
+  * @brief	DMA1 Stream0 interrupt handler (SPI3 RX).
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+	SPI_DMA_IRQHandler(SPI_BUS_3);
+}
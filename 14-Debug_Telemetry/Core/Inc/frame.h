@@ -0,0 +1,146 @@
+/**
+  * @file	frame.h
+  * @author	Parham Estiri
+  * @brief	COBS framing with CRC-16 for batched telemetry records.
+  *
+  * 		This module provides:
+  * 		 - A streaming encoder that appends records straight into the
+  * 		   COBS-encoded frame buffer: no raw staging copy, the CRC is
+  * 		   updated on the way
+  * 		 - Batching: many small records share one frame, one delimiter,
+  * 		   one CRC and (on the link) one DMA transfer
+  * 		 - An incremental decoder, fed any number of bytes at a time;
+  * 		   a 0x00 byte always ends a frame, so it resynchronizes at the
+  * 		   next frame after corruption or a lost byte
+  *
+  * 		Frame before COBS encoding (little-endian):
+  *
+  * 		| seq (1) | type (1) | len (1) | data (len) | ... more records ... | CRC-16 (2) |
+  *
+  * 		CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) covers seq and the
+  * 		records. On the wire: COBS(frame), then 0x00.
+  *
+  * @note	Tools/frame_decode.py implements the same decoder on the host.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define FRAME_PAYLOAD_MAX		256U		/**< Record bytes (headers + data) per frame	*/
+#define FRAME_RECORD_MAX		(FRAME_PAYLOAD_MAX - 2U)	/**< Data bytes of a record alone in a frame	*/
+#define FRAME_RAW_MAX			(FRAME_PAYLOAD_MAX + 3U)	/**< seq + records + CRC		*/
+#define FRAME_ENCODED_MAX		(FRAME_RAW_MAX + FRAME_RAW_MAX / 254U + 2U)	/**< COBS + 0x00	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Framing status.
+  */
+typedef enum {
+	FRAME_OK		= 0,
+	FRAME_EFULL		= 1,	/**< Record does not fit in this frame				*/
+	FRAME_EINVAL	= 2		/**< Record longer than FRAME_RECORD_MAX			*/
+} Frame_Status_t;
+
+/**
+  * @brief	Frame being built (encoded as records are added).
+  */
+typedef struct {
+	uint8_t		buf[FRAME_ENCODED_MAX];	/**< COBS output, sent as is				*/
+	uint16_t	len;				/**< Encoded bytes so far						*/
+	uint16_t	code_at;			/**< Index of the open COBS code byte			*/
+	uint8_t		code;				/**< Open block length + 1						*/
+	uint16_t	payload;			/**< Record bytes added							*/
+	uint16_t	records;			/**< Records added								*/
+	uint16_t	crc;				/**< Running CRC								*/
+} Frame_Encoder_t;
+
+/**
+  * @brief	Record handler: called once per record of every valid frame.
+  */
+typedef void (*Frame_Handler_t)(uint8_t type, const uint8_t *data, uint32_t len, void *ctx);
+
+/**
+  * @brief	Incremental decoder state.
+  */
+typedef struct {
+	uint8_t			buf[FRAME_RAW_MAX];	/**< Decoded bytes of the current frame		*/
+	uint16_t		len;
+	uint8_t			left;			/**< Data bytes left in the COBS block			*/
+	uint8_t			code;			/**< Code byte of the current block (0: none)	*/
+	uint8_t			bad;			/**< Frame broken: skip to the next 0x00		*/
+	uint8_t			seq;			/**< Next expected sequence number				*/
+	uint8_t			synced;			/**< A frame has been received					*/
+	Frame_Handler_t	handler;
+	void			*ctx;
+	uint32_t		frames;			/**< Valid frames								*/
+	uint32_t		errors;			/**< Broken frames (CRC, COBS, length)			*/
+	uint32_t		lost;			/**< Frames missing from the sequence			*/
+} Frame_Decoder_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Start a frame.
+  * @param[out] enc	Encoder.
+  * @param[in] seq	Sequence number (lets the receiver count lost frames).
+  * @retval	None
+  */
+void Frame_Begin(Frame_Encoder_t *enc, uint8_t seq);
+
+/**
+  * @brief	Append one record, COBS-encoding it into the frame buffer.
+  * @param[in,out] enc	Encoder.
+  * @param[in] type		Record type.
+  * @param[in] data		Record data.
+  * @param[in] len		Data bytes (at most FRAME_RECORD_MAX).
+  * @retval	FRAME_OK, FRAME_EFULL (frame unchanged) or FRAME_EINVAL.
+  */
+Frame_Status_t Frame_Add(Frame_Encoder_t *enc, uint8_t type, const void *data, uint32_t len);
+
+/**
+  * @brief	Data bytes a further record could still carry in this frame.
+  * @param[in] enc	Encoder.
+  * @retval	0 .. FRAME_RECORD_MAX.
+  */
+uint32_t Frame_Room(const Frame_Encoder_t *enc);
+
+/**
+  * @brief	Append the CRC and the delimiter.
+  * @param[in,out] enc	Encoder.
+  * @retval	Bytes to send, starting at enc->buf.
+  */
+uint32_t Frame_End(Frame_Encoder_t *enc);
+
+/**
+  * @brief	Reset a decoder.
+  * @param[out] dec		Decoder.
+  * @param[in] handler	Record handler.
+  * @param[in] ctx		Passed to the handler.
+  * @retval	None
+  */
+void Frame_Decoder_Init(Frame_Decoder_t *dec, Frame_Handler_t handler, void *ctx);
+
+/**
+  * @brief	Feed received bytes; complete frames are checked and dispatched.
+  * @param[in,out] dec	Decoder.
+  * @param[in] data		Received bytes.
+  * @param[in] len		Number of bytes.
+  * @retval	None
+  */
+void Frame_Decode(Frame_Decoder_t *dec, const uint8_t *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FRAME_H_ */
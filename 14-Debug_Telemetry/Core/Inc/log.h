@@ -0,0 +1,229 @@
+/**
+  * @file	log.h
+  * @author	Parham Estiri
+  * @brief	Deferred binary logging: the target stores IDs and raw arguments,
+  * 		the host formats the text.
+  *
+  * 		This module provides:
+  * 		 - LOG_ERROR() ... LOG_DEBUG() with printf-style format strings
+  * 		   (checked by the compiler, never formatted on the target)
+  * 		 - Format strings interned in `.logstr`, a section the linker keeps
+  * 		   in the ELF but never loads: a call costs a 16-bit string ID,
+  * 		   a cycle-counter timestamp and 4 bytes per argument
+  * 		 - A lock-free multi-producer ring (LDREX/STREX reservation), safe
+  * 		   from threads and interrupts of any priority
+  * 		 - Compile-time level filtering: calls above LOG_LEVEL expand to
+  * 		   nothing, their arguments are not evaluated
+  *
+  * 		Record in the ring (little-endian):
+  *
+  * 		| Byte | 0   | 1..2 | 3..6     | 7..            |
+  * 		|------|-----|------|----------|----------------|
+  * 		|      | len | ID   | CYCCNT   | 4 bytes / arg  |
+  *
+  * 		The ID is the address of the format string inside `.logstr`;
+  * 		Tools/log_decode.py reads the string back from the ELF of the same
+  * 		build. Arguments are integers up to 32 bits, pointers, `float`/
+  * 		`double` (sent as `float`) and `%s` strings that live in flash.
+  * 		64-bit integers and any other type fail to compile: cast them, or
+  * 		split a 64-bit value into two `%lu` words.
+  *
+  * @note	The linker scripts place `.logstr` at address 0 as an INFO
+  * 		section and assert that it stays below 64 KiB.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define LOG_LEVEL_NONE			0U
+#define LOG_LEVEL_ERROR			1U
+#define LOG_LEVEL_WARN			2U
+#define LOG_LEVEL_INFO			3U
+#define LOG_LEVEL_DEBUG			4U
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL				LOG_LEVEL_DEBUG	/**< Calls above this level compile to nothing	*/
+#endif /* LOG_LEVEL */
+
+#define LOG_BUFFER_SIZE			2048U		/**< Ring bytes (power of two)					*/
+#define LOG_HEADER				7U			/**< len, ID, timestamp							*/
+#define LOG_ARGS_MAX			8U			/**< Arguments per call							*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Logger statistics.
+  */
+typedef struct {
+	uint32_t	records;		/**< Records stored								*/
+	uint32_t	bytes;			/**< Record bytes stored						*/
+	uint32_t	dropped;		/**< Records lost: ring full					*/
+} Log_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Start the cycle counter used for timestamps and empty the ring.
+  * @retval	None
+  */
+void Log_Init(void);
+
+/**
+  * @brief	Store one record (called by the LOG_xxx() macros).
+  * @param[in] id	Format string address inside `.logstr`.
+  * @param[in] args	Arguments, one 32-bit word each.
+  * @param[in] n	Number of arguments (at most LOG_ARGS_MAX).
+  * @retval	None
+  * @note	Never blocks: when the ring is full the record is dropped.
+  */
+void Log_Write(uint32_t id, const uint32_t *args, uint32_t n);
+
+/**
+  * @brief	Move complete records out of the ring (single consumer).
+  * @param[out] dst	Destination.
+  * @param[in] max	Destination size in bytes.
+  * @retval	Bytes copied; records are never split.
+  */
+uint32_t Log_Read(uint8_t *dst, uint32_t max);
+
+/**
+  * @brief	Bytes reserved in the ring (complete or still being written).
+  * @retval	Pending bytes.
+  */
+uint32_t Log_Pending(void);
+
+/**
+  * @brief	Copy the logger statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void Log_GetStats(Log_Stats_t *stats);
+
+/******************************  Argument Packing  ******************************/
+
+/** @brief	Bit pattern of a float argument. */
+static inline uint32_t Log_F32(double value)
+{
+	union { float f; uint32_t u; } v = { .f = (float)value };
+	return v.u;
+}
+
+/** @brief	Integer and character arguments. */
+static inline uint32_t Log_U32(uint32_t value)
+{
+	return value;
+}
+
+/** @brief	Pointer arguments (`%p`, and `%s` for strings in flash). */
+static inline uint32_t Log_Ptr(const volatile void *value)
+{
+	return (uint32_t)value;
+}
+
+/** @brief	64-bit integers: selecting this is a build error (one word per argument). */
+uint32_t Log_No64(uint64_t value)
+	__attribute__((error("64-bit log argument: cast to uint32_t or log the two halves")));
+
+/** @brief	Compile-time printf format check only, never called. */
+__attribute__((format(printf, 1, 2))) static inline void Log_Check(const char *fmt, ...)
+{
+	(void)fmt;
+}
+
+/**
+  * @brief	Pick the packing function from the argument type.
+  *
+  * 		Every integer type up to 32 bits is listed, so `default` only sees
+  * 		pointers (Log_Ptr() takes any object pointer) and types that do
+  * 		not convert to one, such as a struct, which then fail to compile.
+  */
+#define LOG_ARG(x)			_Generic((x),									\
+								_Bool:				Log_U32,				\
+								char:				Log_U32,				\
+								signed char:		Log_U32,				\
+								unsigned char:		Log_U32,				\
+								short:				Log_U32,				\
+								unsigned short:		Log_U32,				\
+								int:				Log_U32,				\
+								unsigned int:		Log_U32,				\
+								long:				Log_U32,				\
+								unsigned long:		Log_U32,				\
+								long long:			Log_No64,				\
+								unsigned long long:	Log_No64,				\
+								float:				Log_F32,				\
+								double:				Log_F32,				\
+								default:			Log_Ptr)(x)
+
+#define LOG_STR_(x)			#x
+#define LOG_STR(x)			LOG_STR_(x)
+#define LOG_CAT_(a, b)		a##b
+#define LOG_CAT(a, b)		LOG_CAT_(a, b)
+
+#define LOG_NARGS(...)		LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...)	n
+
+#define LOG_MAP_0()
+#define LOG_MAP_1(a)		LOG_ARG(a),
+#define LOG_MAP_2(a, ...)	LOG_ARG(a), LOG_MAP_1(__VA_ARGS__)
+#define LOG_MAP_3(a, ...)	LOG_ARG(a), LOG_MAP_2(__VA_ARGS__)
+#define LOG_MAP_4(a, ...)	LOG_ARG(a), LOG_MAP_3(__VA_ARGS__)
+#define LOG_MAP_5(a, ...)	LOG_ARG(a), LOG_MAP_4(__VA_ARGS__)
+#define LOG_MAP_6(a, ...)	LOG_ARG(a), LOG_MAP_5(__VA_ARGS__)
+#define LOG_MAP_7(a, ...)	LOG_ARG(a), LOG_MAP_6(__VA_ARGS__)
+#define LOG_MAP_8(a, ...)	LOG_ARG(a), LOG_MAP_7(__VA_ARGS__)
+#define LOG_MAP(...)		LOG_CAT(LOG_MAP_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+/**
+  * @brief	Intern the format string and store one record.
+  *
+  * 		The interned string is "<level>\x1F<file>\x1F<line>\x1F<format>".
+  * 		The format must be a string literal.
+  */
+#define LOG_EMIT(level, fmt, ...)																\
+	do {																						\
+		static const char log_fmt_[] __attribute__((section(".logstr"), used)) =				\
+			level "\x1F" __FILE__ "\x1F" LOG_STR(__LINE__) "\x1F" fmt;							\
+		const uint32_t log_args_[] = { LOG_MAP(__VA_ARGS__) 0U };								\
+		if (0)																					\
+			Log_Check(fmt, ##__VA_ARGS__);														\
+		Log_Write((uint32_t)log_fmt_, log_args_, LOG_NARGS(__VA_ARGS__));						\
+	} while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...)		LOG_EMIT("E", fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...)		do { } while (0)
+#endif /* LOG_LEVEL >= LOG_LEVEL_ERROR */
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...)		LOG_EMIT("W", fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...)		do { } while (0)
+#endif /* LOG_LEVEL >= LOG_LEVEL_WARN */
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...)		LOG_EMIT("I", fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...)		do { } while (0)
+#endif /* LOG_LEVEL >= LOG_LEVEL_INFO */
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...)		LOG_EMIT("D", fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...)		do { } while (0)
+#endif /* LOG_LEVEL >= LOG_LEVEL_DEBUG */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_H_ */
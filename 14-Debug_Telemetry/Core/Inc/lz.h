@@ -0,0 +1,96 @@
+/**
+  * @file	lz.h
+  * @author	Parham Estiri
+  * @brief	Streaming LZ77 (LZSS) compressor with a fixed RAM budget.
+  *
+  * 		This module provides:
+  * 		 - Block-by-block compression of a continuous stream: each call
+  * 		   compresses one buffer into one block ending on an item, while
+  * 		   matches may reach back into earlier blocks (the window is kept
+  * 		   between calls), so even small blocks compress well
+  * 		 - A fixed RAM budget: LZ_WINDOW bytes of history plus a hash
+  * 		   table of LZ_HASH_SIZE 16-bit positions, no heap. The defaults
+  * 		   use 1.5 KiB; LZ_WINDOW_BITS 9 / LZ_HASH_BITS 7 need 772 bytes
+  * 		 - A bounded output: a block is never larger than LZ_BOUND(len)
+  *
+  * 		Block format: a flag byte announces the next 8 items, bit 0 first.
+  * 		A clear bit is a literal byte, a set bit a match:
+  *
+  * 		| byte 0            | byte 1                      | byte 2 (L = 15 only) |
+  * 		|-------------------|-----------------------------|----------------------|
+  * 		| (D - 1) bits 0..7 | (D - 1) bits 8..11 << 4, L  | length - 18          |
+  *
+  * 		where D is the distance back (1..LZ_WINDOW) and the length is
+  * 		L + 3 (3..LZ_MATCH_MAX). The block ends with its last item; the
+  * 		decoder knows the block length from the transport.
+  *
+  * @note	Greedy parsing with one hash candidate per position (LZ4-style):
+  * 		speed first, ratio second. Depends on <stdint.h> only, so the same
+  * 		file builds for the host (Tools/lz_bench.c). Tools/lz_codec.py is
+  * 		the host decoder.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef LZ_H_
+#define LZ_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stdint.h>
+
+/******************************  Configuration  ******************************/
+#ifndef LZ_WINDOW_BITS
+#define LZ_WINDOW_BITS			10U			/**< History: 2^bits bytes (8 .. 12)			*/
+#endif
+#ifndef LZ_HASH_BITS
+#define LZ_HASH_BITS			8U			/**< Hash table: 2^bits positions				*/
+#endif
+
+#define LZ_WINDOW				(1UL << LZ_WINDOW_BITS)
+#define LZ_HASH_SIZE			(1UL << LZ_HASH_BITS)
+#define LZ_MATCH_MIN			3U
+#define LZ_MATCH_MAX			(LZ_MATCH_MIN + 15U + 255U)
+#define LZ_BOUND(len)			((len) + ((len) + 7U) / 8U)	/**< Worst-case block size	*/
+
+#if (LZ_WINDOW_BITS < 8) || (LZ_WINDOW_BITS > 12)
+#error "LZ_WINDOW_BITS must be 8 .. 12 (12-bit distances)"
+#endif
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Compressor state (LZ_WINDOW + 2 * LZ_HASH_SIZE + 4 bytes).
+  */
+typedef struct {
+	uint8_t		window[LZ_WINDOW];		/**< Last LZ_WINDOW bytes of the stream		*/
+	uint16_t	head[LZ_HASH_SIZE];		/**< Latest position of each 3-byte hash	*/
+	uint32_t	pos;					/**< Bytes compressed since LZ_Init()		*/
+} LZ_Stream_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Start a new stream (the decoder must start a new one as well).
+  * @param[out] lz	Compressor state.
+  * @retval	None
+  */
+void LZ_Init(LZ_Stream_t *lz);
+
+/**
+  * @brief	Compress the next part of the stream into one block.
+  * @param[in,out] lz	Compressor state.
+  * @param[in] src		Input.
+  * @param[in] len		Input bytes.
+  * @param[out] dst		Output, at least LZ_BOUND(len) bytes.
+  * @retval	Block size in bytes. Every block must reach the decoder, in order.
+  */
+uint32_t LZ_Compress(LZ_Stream_t *lz, const uint8_t *src, uint32_t len, uint8_t *dst);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LZ_H_ */
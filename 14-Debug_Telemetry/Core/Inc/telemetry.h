@@ -0,0 +1,112 @@
+/**
+  * @file	telemetry.h
+  * @author	Parham Estiri
+  * @brief	Batched telemetry over the serial link: records are packed into
+  * 		COBS frames and sent by DMA.
+  *
+  * 		This module provides:
+  * 		 - Two frame buffers: one is filled while the other is on the wire
+  * 		 - Flushing when a frame is full or TELEMETRY_FLUSH_MS after its
+  * 		   first record, so bursts share frames and quiet periods still
+  * 		   see records promptly
+  * 		 - Record types shared with Tools/frame_decode.py
+  *
+  * 		| Type             | Data                                                   |
+  * 		|------------------|--------------------------------------------------------|
+  * 		| TELEMETRY_LOG    | Deferred-log records (see log.h), never split          |
+  * 		| TELEMETRY_LOG_LZ | u8 block index, then an LZ block of log records (lz.h) |
+  * 		| TELEMETRY_BUTTON | u32 press count, u32 time in ms                        |
+  * 		| TELEMETRY_STATS  | u32 uptime s, log records, log bytes, log dropped,     |
+  * 		|                  | frames, records, link bytes, records refused           |
+  *
+  * 		TELEMETRY_LOG_LZ blocks form one compressed stream. Index 0 starts
+  * 		a new stream; a receiver that missed a block waits for the next 0.
+  *
+  * @note	Thread context only; interrupts hand events to the main loop.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+#include "frame.h"
+
+/******************************  Configuration  ******************************/
+#define TELEMETRY_FLUSH_MS		10U			/**< Longest wait of a record for its frame		*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Record types.
+  */
+typedef enum {
+	TELEMETRY_LOG		= 1,
+	TELEMETRY_BUTTON	= 2,
+	TELEMETRY_STATS		= 3,
+	TELEMETRY_LOG_LZ	= 4
+} Telemetry_Type_t;
+
+/**
+  * @brief	Link statistics.
+  */
+typedef struct {
+	uint32_t	frames;			/**< Frames sent								*/
+	uint32_t	records;		/**< Records sent								*/
+	uint32_t	bytes;			/**< Bytes on the wire (encoded, delimiters)	*/
+	uint32_t	refused;		/**< Records refused: both buffers in use		*/
+} Telemetry_Stats_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Initialize the serial link and the first frame.
+  * @retval	None
+  */
+void Telemetry_Init(void);
+
+/**
+  * @brief	Add a record to the current frame (flushing it first if full).
+  * @param[in] type	Record type.
+  * @param[in] data	Record data.
+  * @param[in] len	Data bytes (at most FRAME_RECORD_MAX).
+  * @retval	FRAME_OK, FRAME_EFULL (link busy, retry later) or FRAME_EINVAL.
+  */
+Frame_Status_t Telemetry_Add(Telemetry_Type_t type, const void *data, uint32_t len);
+
+/**
+  * @brief	Data bytes the next record can carry without a flush.
+  * @retval	0 .. FRAME_RECORD_MAX.
+  */
+uint32_t Telemetry_Room(void);
+
+/**
+  * @brief	Send the current frame once it is full or old enough.
+  * @retval	None
+  * @note	Call from the main loop.
+  */
+void Telemetry_Poll(void);
+
+/**
+  * @brief	Send the current frame now (if it holds records).
+  * @retval	FRAME_OK, or FRAME_EFULL while the other frame is still on the wire.
+  */
+Frame_Status_t Telemetry_Flush(void);
+
+/**
+  * @brief	Copy the link statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void Telemetry_GetStats(Telemetry_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* TELEMETRY_H_ */
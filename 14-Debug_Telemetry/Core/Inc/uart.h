@@ -0,0 +1,73 @@
+/**
+  * @file	uart.h
+  * @author	Parham Estiri
+  * @brief	USART2 serial link with DMA transmission.
+  *
+  * 		This module provides:
+  * 		 - USART2 at a configurable baud rate, 8N1
+  * 		 - Transmission of whole buffers by DMA: one interrupt per buffer,
+  * 		   none per byte
+  *
+  * 		| Signal   | Pin | Resource                    |
+  * 		|----------|-----|-----------------------------|
+  * 		| TX       | PA2 | AF7                         |
+  * 		| RX       | PA3 | AF7, pull-up                |
+  * 		| USART2_TX|     | DMA1 Stream6, channel 4     |
+  *
+  * @note	Connect PA2/PA3 to a 3.3 V USB-UART adapter (cross TX/RX, common GND).
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef UART_H_
+#define UART_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define UART_BAUD				921600UL	/**< 42 MHz / 921600: 0.02 % error				*/
+#define UART_DMA_PRIORITY		0x03U		/**< TX complete								*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Link status.
+  */
+typedef enum {
+	UART_OK			= 0,
+	UART_BUSY		= 1,	/**< Previous buffer still being sent				*/
+	UART_EINVAL		= 2		/**< Empty or longer than 65535 bytes				*/
+} UART_Status_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure PA2/PA3, USART2 and the TX DMA stream.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  */
+void UART_Init(uint32_t baud);
+
+/**
+  * @brief	Start sending a buffer by DMA.
+  * @param[in] data	Bytes to send (must stay valid until UART_TxBusy() returns 0).
+  * @param[in] len	Number of bytes.
+  * @retval	UART_OK, UART_BUSY or UART_EINVAL.
+  */
+UART_Status_t UART_Write(const void *data, uint32_t len);
+
+/**
+  * @brief	Whether a buffer is still being sent.
+  * @retval	1 while the TX DMA transfer runs, 0 otherwise.
+  */
+uint8_t UART_TxBusy(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UART_H_ */
@@ -0,0 +1,256 @@
+/**
+  * @file	frame.c
+  * @author	Parham Estiri
+  * @brief	COBS framing with CRC-16 for batched telemetry records.
+  *
+  * 		COBS replaces every 0x00 of the frame with the distance to the next
+  * 		one, so 0x00 only appears as the delimiter. The encoder keeps the
+  * 		position of the open code byte and patches it when the block ends,
+  * 		which lets records be encoded straight into the output buffer.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "frame.h"
+
+#define FRAME_CRC_INIT		0xFFFFU
+
+/** @brief	CRC-16/CCITT-FALSE, four bits at a time (32-byte table). */
+static const uint16_t frame_crc_nibble[16] = {
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+		0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/**************************  Static Function Prototypes  ***************************/
+static uint16_t Frame_CRC(uint16_t crc, uint8_t byte);
+static void Frame_Put(Frame_Encoder_t *enc, uint8_t byte);
+static void Frame_Dispatch(Frame_Decoder_t *dec);
+
+/**
+  * @brief	Start a frame.
+  * @param[out] enc	Encoder.
+  * @param[in] seq	Sequence number (lets the receiver count lost frames).
+  * @retval	None
+  */
+void Frame_Begin(Frame_Encoder_t *enc, uint8_t seq)
+{
+	enc->code_at = 0;
+	enc->len     = 1;
+	enc->code    = 1;
+	enc->payload = 0;
+	enc->records = 0;
+	enc->crc     = FRAME_CRC_INIT;
+	Frame_Put(enc, seq);
+}
+
+/**
+  * @brief	Append one record, COBS-encoding it into the frame buffer.
+  * @param[in,out] enc	Encoder.
+  * @param[in] type		Record type.
+  * @param[in] data		Record data.
+  * @param[in] len		Data bytes (at most FRAME_RECORD_MAX).
+  * @retval	FRAME_OK, FRAME_EFULL (frame unchanged) or FRAME_EINVAL.
+  */
+Frame_Status_t Frame_Add(Frame_Encoder_t *enc, uint8_t type, const void *data, uint32_t len)
+{
+	const uint8_t *p = data;
+
+	if (len > FRAME_RECORD_MAX)
+		return FRAME_EINVAL;
+	if (enc->payload + 2U + len > FRAME_PAYLOAD_MAX)
+		return FRAME_EFULL;
+
+	Frame_Put(enc, type);
+	Frame_Put(enc, (uint8_t)len);
+	for (uint32_t i = 0; i < len; i++)
+		Frame_Put(enc, p[i]);
+
+	enc->payload += (uint16_t)(2U + len);
+	enc->records++;
+	return FRAME_OK;
+}
+
+/**
+  * @brief	Data bytes a further record could still carry in this frame.
+  * @param[in] enc	Encoder.
+  * @retval	0 .. FRAME_RECORD_MAX.
+  */
+uint32_t Frame_Room(const Frame_Encoder_t *enc)
+{
+	const uint32_t free = FRAME_PAYLOAD_MAX - enc->payload;
+
+	if (free <= 2U)
+		return 0;
+	return (free - 2U > FRAME_RECORD_MAX) ? FRAME_RECORD_MAX : free - 2U;
+}
+
+/**
+  * @brief	Append the CRC and the delimiter.
+  * @param[in,out] enc	Encoder.
+  * @retval	Bytes to send, starting at enc->buf.
+  */
+uint32_t Frame_End(Frame_Encoder_t *enc)
+{
+	const uint16_t crc = enc->crc;
+
+	Frame_Put(enc, (uint8_t)crc);
+	Frame_Put(enc, (uint8_t)(crc >> 8));
+	enc->buf[enc->code_at] = enc->code;			/**< Close the last block				*/
+	enc->buf[enc->len++] = 0x00U;				/**< Delimiter							*/
+	return enc->len;
+}
+
+/**
+  * @brief	Reset a decoder.
+  * @param[out] dec		Decoder.
+  * @param[in] handler	Record handler.
+  * @param[in] ctx		Passed to the handler.
+  * @retval	None
+  */
+void Frame_Decoder_Init(Frame_Decoder_t *dec, Frame_Handler_t handler, void *ctx)
+{
+	dec->len     = 0;
+	dec->left    = 0;
+	dec->code    = 0;
+	dec->bad     = 0;
+	dec->seq     = 0;
+	dec->synced  = 0;
+	dec->handler = handler;
+	dec->ctx     = ctx;
+	dec->frames  = 0;
+	dec->errors  = 0;
+	dec->lost    = 0;
+}
+
+/**
+  * @brief	Feed received bytes; complete frames are checked and dispatched.
+  * @param[in,out] dec	Decoder.
+  * @param[in] data		Received bytes.
+  * @param[in] len		Number of bytes.
+  * @retval	None
+  */
+void Frame_Decode(Frame_Decoder_t *dec, const uint8_t *data, uint32_t len)
+{
+	for (uint32_t i = 0; i < len; i++)
+	{
+		const uint8_t b = data[i];
+
+		if (b == 0x00U)							/**< Delimiter: always ends a frame		*/
+		{
+			if (!dec->bad && dec->left == 0U && dec->len > 0U)
+				Frame_Dispatch(dec);
+			else if (dec->bad || dec->len > 0U || dec->left)
+				dec->errors++;
+			dec->len  = 0;
+			dec->left = 0;
+			dec->code = 0;
+			dec->bad  = 0;
+			continue;
+		}
+		if (dec->bad)
+			continue;
+
+		if (dec->left == 0U)					/**< Code byte							*/
+		{
+			if (dec->code != 0U && dec->code != 0xFFU)
+			{
+				if (dec->len >= FRAME_RAW_MAX)
+				{
+					dec->bad = 1;
+					continue;
+				}
+				dec->buf[dec->len++] = 0x00U;	/**< The zero the previous block stood for	*/
+			}
+			dec->code = b;
+			dec->left = (uint8_t)(b - 1U);
+			continue;
+		}
+
+		if (dec->len >= FRAME_RAW_MAX)
+		{
+			dec->bad = 1;
+			continue;
+		}
+		dec->buf[dec->len++] = b;
+		dec->left--;
+	}
+}
+
+/**
+  * @brief	One step of CRC-16/CCITT-FALSE.
+  */
+static uint16_t Frame_CRC(uint16_t crc, uint8_t byte)
+{
+	crc = (uint16_t)((crc << 4) ^ frame_crc_nibble[((crc >> 12) ^ (byte >> 4)) & 0x0FU]);
+	crc = (uint16_t)((crc << 4) ^ frame_crc_nibble[((crc >> 12) ^ byte) & 0x0FU]);
+	return crc;
+}
+
+/**
+  * @brief	COBS-encode one byte into the frame buffer.
+  */
+static void Frame_Put(Frame_Encoder_t *enc, uint8_t byte)
+{
+	enc->crc = Frame_CRC(enc->crc, byte);
+
+	if (byte == 0x00U)
+	{
+		enc->buf[enc->code_at] = enc->code;		/**< Block ends at this zero			*/
+		enc->code_at = enc->len++;
+		enc->code = 1;
+		return;
+	}
+
+	enc->buf[enc->len++] = byte;
+	if (++enc->code == 0xFFU)					/**< 254 non-zero bytes: full block		*/
+	{
+		enc->buf[enc->code_at] = enc->code;
+		enc->code_at = enc->len++;
+		enc->code = 1;
+	}
+}
+
+/**
+  * @brief	Check a decoded frame and hand its records to the handler.
+  */
+static void Frame_Dispatch(Frame_Decoder_t *dec)
+{
+	const uint8_t *p = dec->buf;
+	const uint32_t n = dec->len;
+	uint16_t crc = FRAME_CRC_INIT;
+
+	if (n < 3U)
+	{
+		dec->errors++;
+		return;
+	}
+	for (uint32_t i = 0; i < n - 2U; i++)
+		crc = Frame_CRC(crc, p[i]);
+	if (crc != (uint16_t)(p[n - 2U] | (p[n - 1U] << 8)))
+	{
+		dec->errors++;
+		return;
+	}
+
+	/* Records must tile the payload exactly */
+	uint32_t at = 1;
+	while (at + 2U <= n - 2U && at + 2U + p[at + 1U] <= n - 2U)
+		at += 2U + p[at + 1U];
+	if (at != n - 2U)
+	{
+		dec->errors++;
+		return;
+	}
+
+	if (dec->synced)
+		dec->lost += (uint8_t)(p[0] - dec->seq);
+	dec->seq = (uint8_t)(p[0] + 1U);
+	dec->synced = 1;
+	dec->frames++;
+
+	for (at = 1; at < n - 2U; at += 2U + p[at + 1U])
+	{
+		if (dec->handler)
+			dec->handler(p[at], &p[at + 2U], p[at + 1U], dec->ctx);
+	}
+}
@@ -0,0 +1,160 @@
+/**
+  * @file	log.c
+  * @author	Parham Estiri
+  * @brief	Deferred binary logging: lock-free record ring.
+  *
+  * 		Producers reserve space by advancing `log_head` with LDREX/STREX,
+  * 		fill the record and write its length byte last. A length byte of
+  * 		zero means "reserved, not yet complete", so a record interrupted
+  * 		by a higher-priority logger is never read half-written: the
+  * 		consumer stops at it and picks it up on a later call. The consumer
+  * 		zeroes what it has read before releasing the space.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "log.h"
+
+#define LOG_MASK			(LOG_BUFFER_SIZE - 1U)
+
+#if (LOG_BUFFER_SIZE & LOG_MASK) != 0U
+#error "LOG_BUFFER_SIZE must be a power of two"
+#endif
+
+static uint8_t log_buf[LOG_BUFFER_SIZE];
+static volatile uint32_t log_head;			/**< Reserved up to here (producers)	*/
+static volatile uint32_t log_tail;			/**< Released up to here (consumer)		*/
+static volatile Log_Stats_t log_stats;
+
+/**************************  Static Function Prototypes  ***************************/
+static void Log_AtomicAdd(volatile uint32_t *counter, uint32_t value);
+
+/**
+  * @brief	Start the cycle counter used for timestamps and empty the ring.
+  * @retval	None
+  */
+void Log_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	for (uint32_t i = 0; i < LOG_BUFFER_SIZE; i++)
+		log_buf[i] = 0;
+	log_head = 0;
+	log_tail = 0;
+	log_stats.records = 0;
+	log_stats.bytes = 0;
+	log_stats.dropped = 0;
+}
+
+/**
+  * @brief	Store one record (called by the LOG_xxx() macros).
+  * @param[in] id	Format string address inside `.logstr`.
+  * @param[in] args	Arguments, one 32-bit word each.
+  * @param[in] n	Number of arguments (at most LOG_ARGS_MAX).
+  * @retval	None
+  */
+void Log_Write(uint32_t id, const uint32_t *args, uint32_t n)
+{
+	const uint32_t len = LOG_HEADER + 4U * n;
+	const uint32_t stamp = DWT->CYCCNT;
+	uint32_t head;
+
+	/* Reserve: retried only if another context logged in between */
+	do {
+		head = __LDREXW(&log_head);
+		if (head + len - log_tail > LOG_BUFFER_SIZE)
+		{
+			__CLREX();
+			Log_AtomicAdd(&log_stats.dropped, 1U);
+			return;
+		}
+	} while (__STREXW(head + len, &log_head));
+
+	uint32_t p = head + 1U;
+
+	log_buf[p++ & LOG_MASK] = (uint8_t)id;
+	log_buf[p++ & LOG_MASK] = (uint8_t)(id >> 8);
+	log_buf[p++ & LOG_MASK] = (uint8_t)stamp;
+	log_buf[p++ & LOG_MASK] = (uint8_t)(stamp >> 8);
+	log_buf[p++ & LOG_MASK] = (uint8_t)(stamp >> 16);
+	log_buf[p++ & LOG_MASK] = (uint8_t)(stamp >> 24);
+	for (uint32_t i = 0; i < n; i++)
+	{
+		const uint32_t a = args[i];
+		log_buf[p++ & LOG_MASK] = (uint8_t)a;
+		log_buf[p++ & LOG_MASK] = (uint8_t)(a >> 8);
+		log_buf[p++ & LOG_MASK] = (uint8_t)(a >> 16);
+		log_buf[p++ & LOG_MASK] = (uint8_t)(a >> 24);
+	}
+
+	__DMB();										/**< Payload before the length byte		*/
+	log_buf[head & LOG_MASK] = (uint8_t)len;		/**< Commit								*/
+
+	Log_AtomicAdd(&log_stats.records, 1U);
+	Log_AtomicAdd(&log_stats.bytes, len);
+}
+
+/**
+  * @brief	Move complete records out of the ring (single consumer).
+  * @param[out] dst	Destination.
+  * @param[in] max	Destination size in bytes.
+  * @retval	Bytes copied; records are never split.
+  */
+uint32_t Log_Read(uint8_t *dst, uint32_t max)
+{
+	uint32_t tail = log_tail, out = 0;
+
+	while (tail != log_head)
+	{
+		const uint32_t len = log_buf[tail & LOG_MASK];
+
+		if (len == 0U || out + len > max)
+			break;									/**< Still being written, or no room	*/
+		__DMB();									/**< Length byte before the payload		*/
+
+		for (uint32_t i = 0; i < len; i++)
+		{
+			dst[out++] = log_buf[tail & LOG_MASK];
+			log_buf[tail & LOG_MASK] = 0;			/**< Any byte may be a future length	*/
+			tail++;
+		}
+	}
+
+	__DMB();										/**< Zeroes before the space is reused	*/
+	log_tail = tail;
+	return out;
+}
+
+/**
+  * @brief	Bytes reserved in the ring (complete or still being written).
+  * @retval	Pending bytes.
+  */
+uint32_t Log_Pending(void)
+{
+	return log_head - log_tail;
+}
+
+/**
+  * @brief	Copy the logger statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void Log_GetStats(Log_Stats_t *stats)
+{
+	stats->records = log_stats.records;
+	stats->bytes   = log_stats.bytes;
+	stats->dropped = log_stats.dropped;
+}
+
+/**
+  * @brief	Add to a counter shared by every priority level.
+  */
+static void Log_AtomicAdd(volatile uint32_t *counter, uint32_t value)
+{
+	uint32_t v;
+
+	do {
+		v = __LDREXW(counter) + value;
+	} while (__STREXW(v, counter));
+}
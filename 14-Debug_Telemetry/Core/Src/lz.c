@@ -0,0 +1,131 @@
+/**
+  * @file	lz.c
+  * @author	Parham Estiri
+  * @brief	Streaming LZ77 (LZSS) compressor with a fixed RAM budget.
+  *
+  * 		Every input byte is copied into the window ring as it is consumed,
+  * 		and the position of every 3-byte sequence is stored in the hash
+  * 		table. A match candidate is the last position with the same hash;
+  * 		its bytes are compared for real, so hash collisions and stale
+  * 		16-bit positions only cost a missed match, never a wrong one.
+  * 		Bytes of a match that overlap the current position (distance
+  * 		shorter than the length) are taken from the input itself.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "lz.h"
+
+#define LZ_MASK				(LZ_WINDOW - 1U)
+
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t LZ_Hash(const uint8_t *p);
+static uint32_t LZ_Match(const LZ_Stream_t *lz, const uint8_t *src, uint32_t left, uint32_t dist);
+
+/**
+  * @brief	Start a new stream (the decoder must start a new one as well).
+  * @param[out] lz	Compressor state.
+  * @retval	None
+  */
+void LZ_Init(LZ_Stream_t *lz)
+{
+	for (uint32_t i = 0; i < LZ_WINDOW; i++)
+		lz->window[i] = 0;
+	for (uint32_t i = 0; i < LZ_HASH_SIZE; i++)
+		lz->head[i] = 0;
+	lz->pos = 0;
+}
+
+/**
+  * @brief	Compress the next part of the stream into one block.
+  * @param[in,out] lz	Compressor state.
+  * @param[in] src		Input.
+  * @param[in] len		Input bytes.
+  * @param[out] dst		Output, at least LZ_BOUND(len) bytes.
+  * @retval	Block size in bytes. Every block must reach the decoder, in order.
+  */
+uint32_t LZ_Compress(LZ_Stream_t *lz, const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+	uint32_t i = 0, out = 0, flag_at = 0, items = 8;
+
+	while (i < len)
+	{
+		uint32_t dist = 0, run = 1;
+
+		if (len - i >= LZ_MATCH_MIN)
+		{
+			const uint32_t h = LZ_Hash(&src[i]);
+
+			dist = (uint16_t)(lz->pos - lz->head[h]);
+			lz->head[h] = (uint16_t)lz->pos;
+			if (dist != 0U && dist <= LZ_WINDOW)
+				run = LZ_Match(lz, &src[i], len - i, dist);
+		}
+
+		if (items == 8U)
+		{
+			flag_at = out++;						/**< Flags for the next 8 items			*/
+			dst[flag_at] = 0;
+			items = 0;
+		}
+
+		if (run >= LZ_MATCH_MIN)
+		{
+			const uint32_t d = dist - 1U, l = run - LZ_MATCH_MIN;
+
+			dst[flag_at] |= (uint8_t)(1U << items);
+			dst[out++] = (uint8_t)d;
+			dst[out++] = (uint8_t)(((d >> 8) << 4) | (l < 15U ? l : 15U));
+			if (l >= 15U)
+				dst[out++] = (uint8_t)(l - 15U);
+		}
+		else
+		{
+			run = 1;
+			dst[out++] = src[i];
+		}
+		items++;
+
+		/* Consume the item; positions inside a match are hashed too */
+		for (uint32_t k = 0; k < run; k++, i++)
+		{
+			if (k != 0U && len - i >= LZ_MATCH_MIN)
+				lz->head[LZ_Hash(&src[i])] = (uint16_t)lz->pos;
+			lz->window[lz->pos & LZ_MASK] = src[i];
+			lz->pos++;
+		}
+	}
+
+	return out;
+}
+
+/**
+  * @brief	Hash of the 3 bytes at p (Fibonacci hashing).
+  */
+static uint32_t LZ_Hash(const uint8_t *p)
+{
+	const uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+
+	return (uint32_t)(v * 2654435761U) >> (32U - LZ_HASH_BITS);
+}
+
+/**
+  * @brief	Length of the match at distance dist (0 .. LZ_MATCH_MAX).
+  * @param[in] lz	Compressor state (history up to the current position).
+  * @param[in] src	Current position in the input.
+  * @param[in] left	Input bytes left in this block.
+  * @param[in] dist	Distance back, 1 .. LZ_WINDOW.
+  */
+static uint32_t LZ_Match(const LZ_Stream_t *lz, const uint8_t *src, uint32_t left, uint32_t dist)
+{
+	const uint32_t max = left < LZ_MATCH_MAX ? left : LZ_MATCH_MAX;
+	const uint32_t from = lz->pos - dist;
+	uint32_t n = 0;
+
+	while (n < max && n < dist && lz->window[(from + n) & LZ_MASK] == src[n])
+		n++;
+	if (n == dist)
+		while (n < max && src[n - dist] == src[n])	/**< Overlap: repeats the input itself	*/
+			n++;
+	return n;
+}
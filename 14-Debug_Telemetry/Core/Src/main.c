@@ -0,0 +1,314 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	Deferred binary logging and batched telemetry frames.
+  *
+  * 		This file initializes the system, board support package (BSP) LEDs,
+  * 		the user button in interrupt mode, the deferred logger and the
+  * 		telemetry link (USART2). It first measures what a log call costs
+  * 		against formatting the same message with snprintf(), then logs a
+  * 		debug sample every millisecond from the main loop and one record
+  * 		per button press from the EXTI0 interrupt.
+  *
+  * 		Log records are compressed (LZ, 1.5 KiB of state) in blocks of up to
+  * 		LOG_CHUNK bytes. The blocks, button events and a statistics record
+  * 		per second are batched into COBS frames on USART2 (decode them with
+  * 		Tools/frame_decode.py and the ELF of this build). A plain text
+  * 		summary goes to ITM stimulus port 0 (SWO on PB3):
+  *
+  * 		`COST,<log 0 args>,<log 2 args>,<log 4 args>,<snprintf 2 args>` (cycles)
+  * 		`LOG,<records/s>,<bytes/s>,<dropped>`
+  * 		`TLM,<frames/s>,<records/s>,<link bytes/s>,<refused>`
+  * 		`LZ,<log bytes/s>,<compressed bytes/s>,<compressed %>,<compress KB/s>`
+  *
+  * 		The green LED toggles on every report; the red LED shows dropped
+  * 		records.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include <stdio.h>
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "log.h"
+#include "telemetry.h"
+#include "lz.h"
+
+#define COST_RUNS			16U			/**< Best of, for the cost measurement		*/
+#define LOG_CHUNK			224U		/**< Log bytes per compressed block			*/
+
+#if LZ_BOUND(LOG_CHUNK) + 1U > FRAME_RECORD_MAX
+#error "a compressed LOG_CHUNK must fit one record"
+#endif
+
+/**
+  * @brief	Log compression state and statistics.
+  */
+typedef struct {
+	LZ_Stream_t	stream;
+	uint8_t		block[1U + LZ_BOUND(LOG_CHUNK)];	/**< Index + block waiting for the link	*/
+	uint32_t	len;				/**< Bytes in block (0: none waiting)		*/
+	uint8_t		index;				/**< Block index, 0 restarts the stream		*/
+	uint32_t	drained;			/**< CYCCNT of the last drain				*/
+	uint32_t	in;					/**< Log bytes compressed					*/
+	uint32_t	out;				/**< Compressed bytes						*/
+	uint32_t	cycles;				/**< Cycles spent compressing				*/
+} Log_LZ_t;
+
+static Log_LZ_t log_lz;
+
+static volatile uint32_t presses;		/**< Button presses							*/
+static volatile uint32_t press_ms;		/**< Time of the last press					*/
+
+/**************************  Static Function Prototypes  ***************************/
+static void Log_Cost(void);
+static void Log_Drain(void);
+static void Telemetry_Report(const Log_Stats_t *log, const Telemetry_Stats_t *link, uint32_t uptime);
+static void ITM_Print(const char *str);
+static void ITM_PrintU32(uint32_t value);
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes system clock and core peripherals.
+  * 		2. Initializes board support package (LEDs, button, EXTI0 for the button).
+  * 		3. Initializes the logger and the telemetry link, measures the cost
+  * 		   of a log call.
+  * 		4. Enters an infinite loop: one debug record per millisecond, moves
+  * 		   log records and button events into telemetry frames, sends a
+  * 		   statistics record and reports once per second.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	Log_Stats_t stats, prev = { 0 };
+	Telemetry_Stats_t link, link_prev = { 0 };
+	uint32_t lz_in = 0, lz_out = 0, lz_cycles = 0;
+	uint32_t sample = 0, sent_presses = 0, uptime = 0;
+
+	System_Init();						/**< Initialize system configuration		*/
+	BSP_LED_Init();						/**< Initialize all LEDs on the board		*/
+	BSP_Button_Init(BUTTON_MODE_EXTI);	/**< Button press logs from EXTI0			*/
+	Log_Init();							/**< Ring and cycle counter					*/
+	Telemetry_Init();					/**< USART2 on PA2/PA3, DMA1 Stream6		*/
+
+	__enable_irq();						/**< Enable IRQs globally					*/
+
+#if defined(QEMU_NETDUINOPLUS2)
+	ITM_Print("LOG,not emulated\n");	/**< No cycle counter or trace port in QEMU	*/
+	while (1);
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	LOG_INFO("boot: %lu Hz, ring %u bytes", SystemCoreClock, LOG_BUFFER_SIZE);
+	Log_Cost();
+
+	const uint32_t ms = SystemCoreClock / 1000U;
+	uint32_t last = DWT->CYCCNT, tick = last;
+
+	/**< Main loop */
+	while (1)
+	{
+		if (DWT->CYCCNT - tick >= ms)
+		{
+			tick += ms;
+			LOG_DEBUG("sample %lu: tick %lu", sample, tick);
+			sample++;
+		}
+
+		if (presses != sent_presses)
+		{
+			const uint32_t event[2] = { presses, press_ms };
+			if (Telemetry_Add(TELEMETRY_BUTTON, event, sizeof(event)) == FRAME_OK)
+				sent_presses = event[0];
+		}
+
+		Log_Drain();
+		Telemetry_Poll();
+
+		if (DWT->CYCCNT - last >= SystemCoreClock)
+		{
+			last += SystemCoreClock;
+			uptime++;
+			Log_GetStats(&stats);
+			Telemetry_GetStats(&link);
+			Telemetry_Report(&stats, &link, uptime);
+
+			ITM_Print("LOG,");
+			ITM_PrintU32(stats.records - prev.records);
+			ITM_Print(",");
+			ITM_PrintU32(stats.bytes - prev.bytes);
+			ITM_Print(",");
+			ITM_PrintU32(stats.dropped);
+			ITM_Print("\n");
+			prev = stats;
+
+			ITM_Print("TLM,");
+			ITM_PrintU32(link.frames - link_prev.frames);
+			ITM_Print(",");
+			ITM_PrintU32(link.records - link_prev.records);
+			ITM_Print(",");
+			ITM_PrintU32(link.bytes - link_prev.bytes);
+			ITM_Print(",");
+			ITM_PrintU32(link.refused);
+			ITM_Print("\n");
+			link_prev = link;
+
+			const uint32_t in = log_lz.in - lz_in, out = log_lz.out - lz_out;
+			const uint32_t cycles = log_lz.cycles - lz_cycles;
+			ITM_Print("LZ,");
+			ITM_PrintU32(in);
+			ITM_Print(",");
+			ITM_PrintU32(out);
+			ITM_Print(",");
+			ITM_PrintU32(in ? out * 100U / in : 0U);
+			ITM_Print(",");
+			ITM_PrintU32(cycles ? (uint32_t)((uint64_t)in * SystemCoreClock / cycles / 1000U) : 0U);
+			ITM_Print("\n");
+			lz_in = log_lz.in;
+			lz_out = log_lz.out;
+			lz_cycles = log_lz.cycles;
+
+			BSP_LED_Toggle(LED_GREEN);
+			if (stats.dropped)
+				BSP_LED_On(LED_RED);
+		}
+	}
+}
+
+/**
+  * @brief	Log every button press (EXTI0 interrupt context).
+  */
+void BSP_Button_Callback(void)
+{
+	press_ms = DWT->CYCCNT / (SystemCoreClock / 1000U);
+	presses++;
+	LOG_INFO("button press %lu at %lu ms", presses, press_ms);
+}
+
+/**
+  * @brief	Best-of-COST_RUNS cycles of a log call and of snprintf().
+  */
+static void Log_Cost(void)
+{
+	uint32_t best[4] = { ~0UL, ~0UL, ~0UL, ~0UL };
+	char text[64];
+
+	for (uint32_t i = 0; i < COST_RUNS; i++)
+	{
+		uint32_t t = DWT->CYCCNT;
+		LOG_DEBUG("cost: no arguments");
+		t = DWT->CYCCNT - t;
+		if (t < best[0])
+			best[0] = t;
+
+		t = DWT->CYCCNT;
+		LOG_DEBUG("cost: %lu %ld", i, -(int32_t)i);
+		t = DWT->CYCCNT - t;
+		if (t < best[1])
+			best[1] = t;
+
+		t = DWT->CYCCNT;
+		LOG_DEBUG("cost: %lu %ld %x %lu", i, -(int32_t)i, 0xC0FFEEU, t);
+		t = DWT->CYCCNT - t;
+		if (t < best[2])
+			best[2] = t;
+
+		t = DWT->CYCCNT;
+		snprintf(text, sizeof(text), "cost: %lu %ld", (unsigned long)i, -(long)i);
+		t = DWT->CYCCNT - t;
+		if (t < best[3])
+			best[3] = t;
+
+		Log_Drain();					/**< Keep the ring from filling				*/
+	}
+
+	LOG_INFO("cost cycles: log %lu/%lu/%lu (0/2/4 args), snprintf %lu", best[0], best[1], best[2], best[3]);
+
+	ITM_Print("COST,");
+	for (uint32_t k = 0; k < 4U; k++)
+	{
+		ITM_PrintU32(best[k]);
+		ITM_Print(k < 3U ? "," : "\n");
+	}
+}
+
+/**
+  * @brief	Compress finished log records into a block and queue it.
+  *
+  * 		Records are drained once LOG_CHUNK bytes are pending or every
+  * 		TELEMETRY_FLUSH_MS, so blocks are large enough to compress well.
+  * 		A block is kept until the link takes it: the stream cannot skip
+  * 		one. The stream restarts every 256 blocks (index 0), which bounds
+  * 		what a receiver loses after a dropped frame.
+  */
+static void Log_Drain(void)
+{
+	Log_LZ_t *lz = &log_lz;
+
+	if (lz->len == 0U)
+	{
+		uint8_t chunk[LOG_CHUNK];
+
+		if (Log_Pending() < LOG_CHUNK
+			&& DWT->CYCCNT - lz->drained < (SystemCoreClock / 1000U) * TELEMETRY_FLUSH_MS)
+			return;
+		lz->drained = DWT->CYCCNT;
+
+		const uint32_t n = Log_Read(chunk, sizeof(chunk));
+		if (n == 0U)
+			return;
+
+		if (lz->index == 0U)
+			LZ_Init(&lz->stream);
+		const uint32_t t = DWT->CYCCNT;
+		lz->block[0] = lz->index++;
+		lz->len = 1U + LZ_Compress(&lz->stream, chunk, n, &lz->block[1]);
+		lz->cycles += DWT->CYCCNT - t;
+		lz->in += n;
+		lz->out += lz->len;
+	}
+
+	if (lz->len > Telemetry_Room() && Telemetry_Flush() != FRAME_OK)
+		return;										/**< Both frames busy: retry later		*/
+	if (Telemetry_Add(TELEMETRY_LOG_LZ, lz->block, lz->len) == FRAME_OK)
+		lz->len = 0;
+}
+
+/**
+  * @brief	Queue the once-per-second statistics record.
+  */
+static void Telemetry_Report(const Log_Stats_t *log, const Telemetry_Stats_t *link, uint32_t uptime)
+{
+	const uint32_t record[8] = { uptime, log->records, log->bytes, log->dropped,
+								 link->frames, link->records, link->bytes, link->refused };
+
+	Telemetry_Add(TELEMETRY_STATS, record, sizeof(record));
+}
+
+/**
+  * @brief	Write a string to ITM stimulus port 0.
+  */
+static void ITM_Print(const char *str)
+{
+	while (*str)
+		ITM_SendChar((uint32_t)*str++);
+}
+
+/**
+  * @brief	Write an unsigned decimal to ITM stimulus port 0.
+  */
+static void ITM_PrintU32(uint32_t value)
+{
+	char buf[11];
+	uint32_t i = sizeof(buf);
+
+	buf[--i] = '\0';
+	do {
+		buf[--i] = (char)('0' + value % 10U);
+		value /= 10U;
+	} while (value);
+	ITM_Print(&buf[i]);
+}
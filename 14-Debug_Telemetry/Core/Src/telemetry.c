@@ -0,0 +1,123 @@
+/**
+  * @file	telemetry.c
+  * @author	Parham Estiri
+  * @brief	Batched telemetry over the serial link.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "telemetry.h"
+#include "uart.h"
+
+#define TELEMETRY_FULL		8U			/**< Send once less room than this is left		*/
+
+static Frame_Encoder_t tlm_frame[2];	/**< Filled / on the wire						*/
+static uint8_t tlm_fill;				/**< Index of the frame being filled			*/
+static uint8_t tlm_seq;
+static uint32_t tlm_opened;				/**< CYCCNT at the first record of the frame	*/
+static Telemetry_Stats_t tlm_stats;
+
+/**
+  * @brief	Initialize the serial link and the first frame.
+  * @retval	None
+  */
+void Telemetry_Init(void)
+{
+	UART_Init(UART_BAUD);
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;		/**< Frame age from the cycle counter	*/
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	tlm_fill = 0;
+	tlm_seq = 0;
+	tlm_stats = (Telemetry_Stats_t){ 0 };
+	Frame_Begin(&tlm_frame[tlm_fill], tlm_seq);
+}
+
+/**
+  * @brief	Add a record to the current frame (flushing it first if full).
+  * @param[in] type	Record type.
+  * @param[in] data	Record data.
+  * @param[in] len	Data bytes (at most FRAME_RECORD_MAX).
+  * @retval	FRAME_OK, FRAME_EFULL (link busy, retry later) or FRAME_EINVAL.
+  */
+Frame_Status_t Telemetry_Add(Telemetry_Type_t type, const void *data, uint32_t len)
+{
+	Frame_Encoder_t *enc = &tlm_frame[tlm_fill];
+
+	if (len > FRAME_RECORD_MAX)
+		return FRAME_EINVAL;
+	if (len > Frame_Room(enc))
+	{
+		if (Telemetry_Flush() != FRAME_OK)
+		{
+			tlm_stats.refused++;
+			return FRAME_EFULL;
+		}
+		enc = &tlm_frame[tlm_fill];
+	}
+
+	if (enc->records == 0U)
+		tlm_opened = DWT->CYCCNT;
+	return Frame_Add(enc, (uint8_t)type, data, len);
+}
+
+/**
+  * @brief	Data bytes the next record can carry without a flush.
+  * @retval	0 .. FRAME_RECORD_MAX.
+  */
+uint32_t Telemetry_Room(void)
+{
+	return Frame_Room(&tlm_frame[tlm_fill]);
+}
+
+/**
+  * @brief	Send the current frame once it is full or old enough.
+  * @retval	None
+  */
+void Telemetry_Poll(void)
+{
+	const Frame_Encoder_t *enc = &tlm_frame[tlm_fill];
+
+	if (enc->records == 0U)
+		return;
+	if (Frame_Room(enc) < TELEMETRY_FULL
+		|| DWT->CYCCNT - tlm_opened >= (SystemCoreClock / 1000U) * TELEMETRY_FLUSH_MS)
+		Telemetry_Flush();
+}
+
+/**
+  * @brief	Send the current frame now (if it holds records).
+  * @retval	FRAME_OK, or FRAME_EFULL while the other frame is still on the wire.
+  */
+Frame_Status_t Telemetry_Flush(void)
+{
+	Frame_Encoder_t *enc = &tlm_frame[tlm_fill];
+
+	if (enc->records == 0U)
+		return FRAME_OK;
+	if (UART_TxBusy())
+		return FRAME_EFULL;						/**< The other buffer is still on the wire	*/
+
+	const uint16_t records = enc->records;
+	const uint32_t len = Frame_End(enc);
+
+	UART_Write(enc->buf, len);
+	tlm_stats.frames++;
+	tlm_stats.records += records;
+	tlm_stats.bytes += len;
+
+	tlm_fill ^= 1U;
+	Frame_Begin(&tlm_frame[tlm_fill], ++tlm_seq);
+	return FRAME_OK;
+}
+
+/**
+  * @brief	Copy the link statistics.
+  * @param[out] stats	Statistics.
+  * @retval	None
+  */
+void Telemetry_GetStats(Telemetry_Stats_t *stats)
+{
+	*stats = tlm_stats;
+}
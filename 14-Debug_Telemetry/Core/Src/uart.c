@@ -0,0 +1,109 @@
+/**
+  * @file	uart.c
+  * @author	Parham Estiri
+  * @brief	USART2 serial link with DMA transmission.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "uart.h"
+
+#define UART_TX_PIN			2U			/**< PA2										*/
+#define UART_RX_PIN			3U			/**< PA3										*/
+#define UART_AF				7U			/**< USART1..3									*/
+#define UART_DMA_CHANNEL	4U			/**< USART2_TX on DMA1 Stream6					*/
+#define UART_TX_FLAGS		(0x3DUL << 16)	/**< Stream6 flags in HIFCR				*/
+
+static volatile uint8_t uart_tx_busy;
+
+/**************************  Static Function Prototypes  ***************************/
+static void UART_Pin_AF(uint32_t pin);
+
+/**
+  * @brief	Configure PA2/PA3, USART2 and the TX DMA stream.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  */
+void UART_Init(uint32_t baud)
+{
+	uint32_t PG = NVIC_GetPriorityGrouping();
+	const uint32_t pclk = SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA1EN;
+	RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
+
+	UART_Pin_AF(UART_TX_PIN);
+	UART_Pin_AF(UART_RX_PIN);
+	GPIOA->PUPDR = (GPIOA->PUPDR & ~(3UL << (UART_RX_PIN * 2))) | (1UL << (UART_RX_PIN * 2));	/**< Idle high	*/
+
+	USART2->CR1 = 0;
+	USART2->BRR = (pclk + baud / 2U) / baud;	/**< 16x oversampling: BRR = PCLK1 / baud	*/
+	USART2->CR2 = 0;							/**< 1 stop bit								*/
+	USART2->CR3 = USART_CR3_DMAT;
+	USART2->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+
+	DMA1_Stream6->CR   = 0;
+	while (DMA1_Stream6->CR & DMA_SxCR_EN);
+	DMA1_Stream6->PAR  = (uint32_t)&USART2->DR;
+	DMA1_Stream6->FCR  = 0;
+	DMA1_Stream6->CR   = (UART_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos)
+					   | DMA_SxCR_MINC						/**< Byte transfers, memory increments	*/
+					   | DMA_SxCR_DIR_0						/**< Memory to peripheral				*/
+					   | DMA_SxCR_TCIE;
+	DMA1->HIFCR = UART_TX_FLAGS;
+	uart_tx_busy = 0;
+
+	NVIC_SetPriority(DMA1_Stream6_IRQn, NVIC_EncodePriority(PG, UART_DMA_PRIORITY, 0));
+	NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+}
+
+/**
+  * @brief	Start sending a buffer by DMA.
+  * @param[in] data	Bytes to send (must stay valid until UART_TxBusy() returns 0).
+  * @param[in] len	Number of bytes.
+  * @retval	UART_OK, UART_BUSY or UART_EINVAL.
+  */
+UART_Status_t UART_Write(const void *data, uint32_t len)
+{
+	if (len == 0U || len > 0xFFFFU)
+		return UART_EINVAL;
+	if (uart_tx_busy)
+		return UART_BUSY;
+
+	uart_tx_busy = 1;
+	DMA1->HIFCR = UART_TX_FLAGS;
+	DMA1_Stream6->M0AR = (uint32_t)data;
+	DMA1_Stream6->NDTR = len;
+	DMA1_Stream6->CR  |= DMA_SxCR_EN;
+	return UART_OK;
+}
+
+/**
+  * @brief	Whether a buffer is still being sent.
+  * @retval	1 while the TX DMA transfer runs, 0 otherwise.
+  */
+uint8_t UART_TxBusy(void)
+{
+	return uart_tx_busy;
+}
+
+/**
+  * @brief	Put a UART pin in alternate-function mode.
+  */
+static void UART_Pin_AF(uint32_t pin)
+{
+	GPIOA->MODER    = (GPIOA->MODER & ~(3UL << (pin * 2))) | (2UL << (pin * 2));
+	GPIOA->OTYPER  &= ~(1UL << pin);
+	GPIOA->OSPEEDR |= 2UL << (pin * 2);
+	GPIOA->AFR[pin >> 3] = (GPIOA->AFR[pin >> 3] & ~(0xFUL << ((pin & 7U) * 4))) | (UART_AF << ((pin & 7U) * 4));
+}
+
+/**
+  * @brief	DMA1 Stream6 interrupt handler (USART2 TX complete).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+	DMA1->HIFCR = UART_TX_FLAGS;
+	uart_tx_busy = 0;							/**< The last byte sits in DR: the next
+													 transfer simply queues behind it	*/
+}
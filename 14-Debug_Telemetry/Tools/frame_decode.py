@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""Decode the 14-Debug_Telemetry serial link: COBS frames of batched records.
+
+Every frame on the wire is COBS(seq | records | CRC-16) followed by 0x00,
+where each record is type (1 byte) | len (1 byte) | data. The CRC is
+CRC-16/CCITT-FALSE over seq and the records. A 0x00 byte always ends a
+frame, so decoding resynchronizes at the next frame after a corrupted or
+lost byte. Broken frames are counted and skipped.
+
+Read a capture file, a serial device (set it up first, e.g.
+`stty -F /dev/ttyUSB0 921600 raw`) or stdin ("-"):
+
+    python3 frame_decode.py /dev/ttyUSB0 --elf Debug/14-Debug_Telemetry.elf
+    python3 frame_decode.py capture.bin --log-out log.bin
+
+Record types (telemetry.h):
+
+    1 LOG     deferred-log records, decoded with log_decode.py when --elf is given
+    2 BUTTON  u32 press count, u32 time in ms
+    3 STATS   u32 uptime s, log records, log bytes, log dropped,
+              frames, records, link bytes, records refused
+    4 LOG_LZ  u8 block index, LZ block of deferred-log records (lz_codec.py);
+              index 0 starts a new stream, after a missed block the decoder
+              waits for the next 0
+
+Other types are printed as hex. A summary of frames, errors and lost frames
+(sequence gaps) is printed at the end. No third-party packages are needed.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import lz_codec  # noqa: E402
+
+CRC_INIT = 0xFFFF
+STATS_FIELDS = ("uptime_s", "log_records", "log_bytes", "log_dropped",
+                "frames", "records", "link_bytes", "refused")
+
+
+def crc16(data, crc=CRC_INIT):
+    """CRC-16/CCITT-FALSE."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(block):
+    """Decode one COBS block (without the 0x00 delimiter), or None if malformed."""
+    out, pos = bytearray(), 0
+    while pos < len(block):
+        code = block[pos]
+        if code == 0 or pos + code > len(block):
+            return None
+        out += block[pos + 1:pos + code]
+        pos += code
+        if code != 0xFF and pos < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+class LogStream:
+    """Reassemble the LOG_LZ block stream into raw log records."""
+
+    def __init__(self):
+        self.dec = None
+        self.index = 0
+        self.packed = self.raw = self.skipped = 0
+
+    def feed(self, block):
+        """Return the log records of one LOG_LZ record (b"" while out of sync)."""
+        self.packed += len(block)
+        if not block:
+            return b""
+        if block[0] == 0:
+            self.dec = lz_codec.Decompressor()
+        elif self.dec is None or block[0] != self.index:
+            self.dec = None                         # missed a block: wait for index 0
+        if self.dec is None:
+            self.skipped += 1
+            return b""
+        self.index = (block[0] + 1) & 0xFF
+        try:
+            data = self.dec.decompress(block[1:])
+        except ValueError:
+            self.dec = None
+            self.skipped += 1
+            return b""
+        self.raw += len(data)
+        return data
+
+
+class FrameDecoder:
+    """Incremental decoder: feed() any chunk, get the records of complete frames."""
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.frames = self.errors = self.lost = 0
+        self.seq = None
+
+    def feed(self, data):
+        """Yield (seq, [(type, data), ...]) for every valid frame completed by data."""
+        self.pending += data
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                return
+            block, self.pending = bytes(self.pending[:end]), self.pending[end + 1:]
+            if not block:
+                continue                            # idle delimiters
+            frame = self._check(cobs_decode(block))
+            if frame is not None:
+                yield frame
+
+    def _check(self, raw):
+        if raw is None or len(raw) < 3 or crc16(raw[:-2]) != struct.unpack_from("<H", raw, len(raw) - 2)[0]:
+            self.errors += 1
+            return None
+        records, pos, end = [], 1, len(raw) - 2
+        while pos + 2 <= end and pos + 2 + raw[pos + 1] <= end:
+            records.append((raw[pos], raw[pos + 2:pos + 2 + raw[pos + 1]]))
+            pos += 2 + raw[pos + 1]
+        if pos != end:
+            self.errors += 1
+            return None
+        if self.seq is not None:
+            self.lost += (raw[0] - self.seq) & 0xFF
+        self.seq = (raw[0] + 1) & 0xFF
+        self.frames += 1
+        return raw[0], records
+
+
+def read_chunks(path):
+    """Yield input chunks as they arrive (works for files, ttys and pipes)."""
+    if path == "-":
+        fd, close = sys.stdin.buffer.fileno(), False
+    else:
+        fd, close = os.open(path, os.O_RDONLY), True
+    try:
+        while True:
+            chunk = os.read(fd, 4096)
+            if not chunk:
+                return
+            yield chunk
+    finally:
+        if close:
+            os.close(fd)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="capture file, serial device, or - for stdin")
+    parser.add_argument("--elf", help="ELF of the running build: decode LOG records to text")
+    parser.add_argument("--clock", type=float, default=168e6,
+                        help="CPU clock in Hz for log timestamps (default 168e6)")
+    parser.add_argument("--log-out", help="append the raw LOG record stream to this file")
+    args = parser.parse_args()
+
+    logs = None
+    if args.elf:
+        import log_decode
+        elf = log_decode.Elf(args.elf)
+        logs = (log_decode, elf, log_decode.load_formats(elf), log_decode.Clock(args.clock))
+    log_out = open(args.log_out, "ab") if args.log_out else None
+
+    dec, lz = FrameDecoder(), LogStream()
+    try:
+        for chunk in read_chunks(args.input):
+            for seq, records in dec.feed(chunk):
+                for rtype, data in records:
+                    if rtype == 4:
+                        rtype, data = 1, lz.feed(data)
+                        if not data:
+                            continue
+                    if rtype == 1:
+                        if log_out:
+                            log_out.write(data)
+                        if logs:
+                            mod, elf, formats, clock = logs
+                            for sec, level, path, line, text in mod.decode(data, formats, elf, clock):
+                                print(f"[{sec:11.6f}] {level} {path}:{line}: {text}")
+                        elif not log_out:
+                            print(f"{seq:3} LOG {len(data)} bytes")
+                    elif rtype == 2 and len(data) == 8:
+                        count, ms = struct.unpack("<II", data)
+                        print(f"{seq:3} BUTTON press {count} at {ms} ms")
+                    elif rtype == 3 and len(data) == 4 * len(STATS_FIELDS):
+                        values = struct.unpack(f"<{len(STATS_FIELDS)}I", data)
+                        print(f"{seq:3} STATS " + " ".join(f"{k}={v}" for k, v in zip(STATS_FIELDS, values)))
+                    else:
+                        print(f"{seq:3} TYPE{rtype} {data.hex()}")
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if log_out:
+            log_out.close()
+
+    print(f"frames {dec.frames}, errors {dec.errors}, lost {dec.lost}", file=sys.stderr)
+    if lz.packed:
+        print(f"log {lz.raw} bytes from {lz.packed} compressed, "
+              f"{lz.skipped} blocks skipped", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
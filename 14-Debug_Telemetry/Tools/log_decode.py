@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Turn 14-Debug_Telemetry deferred-log records back into text.
+
+The firmware never formats log messages. Each LOG_xxx() call stores a record:
+
+    len (1 byte) | string ID (2) | CYCCNT (4) | one 32-bit word per argument
+
+all little-endian, where the string ID is the address of the format string
+inside the `.logstr` section. That section is linked into the ELF but never
+loaded into flash, so this script needs the ELF file of the same build:
+
+    python3 log_decode.py Debug/14-Debug_Telemetry.elf capture.bin
+
+The capture is the raw record stream, for example the LOG records saved by
+`frame_decode.py --log-out log.bin` from the telemetry link, or the bytes
+of an ITM stimulus port. Use "-" to read stdin. frame_decode.py --elf
+decodes LOG records in place with this module. Each record prints as
+
+    [   1.234567] I main.c:98: button press 3 after 1250 ms
+
+Timestamps are unwrapped from the 32-bit cycle counter, so records must not be
+more than one counter period (25.6 s at 168 MHz) apart. `%s` arguments are
+read from the loaded sections of the ELF (strings in flash only). Bytes that
+do not form a valid record are skipped, which resynchronizes the stream after
+a lost byte. No third-party packages are needed.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+HEADER = 7
+CONV = re.compile(r"%([-+ #0]*)(\d+)?(?:\.(\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfgGcsp%])")
+
+
+class Elf:
+    """Sections of a little-endian ELF32 (target) or ELF64 (host build) file."""
+
+    def __init__(self, path):
+        with open(path, "rb") as fh:
+            self.data = data = fh.read()
+        if data[:4] != b"\x7fELF" or data[5] != 1:
+            sys.exit(f"{path}: not a little-endian ELF file")
+        if data[4] == 1:
+            shoff, = struct.unpack_from("<I", data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+            fmt = "<IIIIIIIIII"
+        else:
+            shoff, = struct.unpack_from("<Q", data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3A)
+            fmt = "<IIQQQQIIQQ"
+        raw = [struct.unpack_from(fmt, data, shoff + i * shentsize) for i in range(shnum)]
+        names = raw[shstrndx][4]
+        # (name, type, flags, addr, offset, size)
+        self.sections = [(self._cstr(names + s[0]), s[1], s[2], s[3], s[4], s[5]) for s in raw]
+
+    def _cstr(self, off):
+        end = self.data.index(b"\0", off)
+        return self.data[off:end].decode("utf-8", "replace")
+
+    def section(self, name):
+        for sec in self.sections:
+            if sec[0] == name:
+                return sec
+        return None
+
+    def string_at(self, addr):
+        """NUL-terminated string at a load address, or None outside loaded sections."""
+        for name, stype, flags, base, off, size in self.sections:
+            if flags & SHF_ALLOC and stype != SHT_NOBITS and base <= addr < base + size:
+                return self._cstr(off + addr - base)
+        return None
+
+
+def load_formats(elf):
+    """Return {string ID: (level, file, line, format)} from the .logstr section."""
+    sec = elf.section(".logstr")
+    if sec is None:
+        sys.exit("no .logstr section: wrong ELF, or no LOG_xxx() call in the build")
+    _, _, _, base, off, size = sec
+    blob = elf.data[off:off + size]
+    formats, pos = {}, 0
+    while pos < size:
+        end = blob.index(b"\0", pos)
+        if end > pos:
+            parts = blob[pos:end].decode("utf-8", "replace").split("\x1f", 3)
+            if len(parts) == 4:
+                level, path, line, fmt = parts
+                formats[base + pos] = (level, path.replace("\\", "/").rsplit("/", 1)[-1],
+                                       line, fmt)
+        pos = end + 1
+    return formats
+
+
+def arg_count(fmt):
+    return sum(1 for m in CONV.finditer(fmt) if m.group(5) != "%")
+
+
+def render(fmt, words, elf):
+    """Apply a printf format to 32-bit argument words."""
+    it = iter(words)
+
+    def conv(m):
+        flags, width, prec, _, c = m.groups()
+        if c == "%":
+            return "%"
+        w = next(it, 0)
+        spec = "%" + flags + (width or "") + (f".{prec}" if prec is not None else "")
+        if c in "di":
+            return (spec + "d") % struct.unpack("<i", struct.pack("<I", w))[0]
+        if c in "uoxX":
+            return (spec + ("d" if c == "u" else c)) % w
+        if c in "eEfgG":
+            return (spec + c) % struct.unpack("<f", struct.pack("<I", w))[0]
+        if c == "c":
+            return (spec + "c") % chr(w & 0xFF)
+        if c == "p":
+            return f"0x{w:08x}"
+        text = elf.string_at(w)
+        return (spec + "s") % (text if text is not None else f"<0x{w:08x}>")
+
+    return CONV.sub(conv, fmt)
+
+
+class Clock:
+    """Unwraps the 32-bit cycle counter into seconds."""
+
+    def __init__(self, hz):
+        self.hz, self.last, self.high = hz, None, 0
+
+    def seconds(self, stamp):
+        if self.last is not None and stamp < self.last:
+            self.high += 1 << 32
+        self.last = stamp
+        return (self.high + stamp) / self.hz
+
+
+def decode(stream, formats, elf, clock):
+    """Yield (seconds, level, file, line, text) for every valid record."""
+    pos = 0
+    while pos + HEADER <= len(stream):
+        length = stream[pos]
+        sid, stamp = struct.unpack_from("<HI", stream, pos + 1)
+        entry = formats.get(sid)
+        if entry is None or length != HEADER + 4 * arg_count(entry[3]) or pos + length > len(stream):
+            pos += 1                                # not a record start: resynchronize
+            continue
+        words = struct.unpack_from(f"<{(length - HEADER) // 4}I", stream, pos + HEADER)
+        pos += length
+        level, path, line, fmt = entry
+        yield clock.seconds(stamp), level, path, line, render(fmt, words, elf)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="ELF file of the logging build (Debug/14-Debug_Telemetry.elf)")
+    parser.add_argument("capture", help="raw record bytes, or - for stdin")
+    parser.add_argument("--clock", type=float, default=168e6,
+                        help="CPU clock in Hz for the timestamps (default 168e6)")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    formats = load_formats(elf)
+    if args.capture == "-":
+        stream = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as fh:
+            stream = fh.read()
+
+    for seconds, level, path, line, text in decode(stream, formats, elf, Clock(args.clock)):
+        print(f"[{seconds:11.6f}] {level} {path}:{line}: {text}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,211 @@
+/**
+  * @file	lz_bench.c
+  * @author	Parham Estiri
+  * @brief	Host benchmark of the firmware compressor (Core/Src/lz.c).
+  *
+  * 		Builds the target's lz.c unchanged and reports, per capture file,
+  * 		the compression ratio and the host compression speed with the same
+  * 		block size as the firmware (224 bytes, LOG_CHUNK):
+  *
+  * 		    cc -O2 -ICore/Inc -o lz_bench Tools/lz_bench.c Core/Src/lz.c
+  * 		    ./lz_bench log.bin
+  *
+  * 		The RAM budget is a build option, as on the target:
+  * 		-DLZ_WINDOW_BITS=9 -DLZ_HASH_BITS=7. --out writes the blocks of
+  * 		the last file (u16 length, little-endian, then the block) for the
+  * 		reference decoder to check the round trip:
+  *
+  * 		    ./lz_bench log.bin --out log.lz
+  * 		    python3 Tools/lz_codec.py log.lz --expect log.bin
+  *
+  * Target	Host (C99, POSIX clock_gettime)
+  */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lz.h"
+
+#define BENCH_BLOCK_DEFAULT		224U		/**< LOG_CHUNK: bytes per firmware block		*/
+#define BENCH_MIN_SECONDS		0.5			/**< Repeat the file until this much time ran	*/
+
+static LZ_Stream_t bench_lz;				/**< Same state the firmware keeps			*/
+
+/**************************  Static Function Prototypes  ***************************/
+static uint8_t *Bench_Load(const char *path, uint32_t *len);
+static double Bench_Now(void);
+static uint32_t Bench_Pass(const uint8_t *data, uint32_t len, uint32_t block, uint8_t *dst, FILE *out);
+
+/**
+  * @brief	Benchmark every capture named on the command line.
+  * @retval	0 on success, 1 on a usage or I/O error.
+  */
+int main(int argc, char **argv)
+{
+	const char *out_path = NULL;
+	uint32_t block = BENCH_BLOCK_DEFAULT;
+	int files = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--block") && i + 1 < argc)
+			block = (uint32_t)strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+			out_path = argv[++i];
+		else if (argv[i][0] == '-')
+		{
+			fprintf(stderr, "usage: %s [--block N] [--out FILE] capture...\n", argv[0]);
+			return 1;
+		}
+	}
+	if (block == 0U || block > 32768U)
+	{
+		fprintf(stderr, "--block must be 1 .. 32768 (u16 block lengths in --out)\n");
+		return 1;
+	}
+
+	printf("window %lu B, hash %lu entries, target RAM %lu B, block %u B\n",
+		   (unsigned long)LZ_WINDOW, (unsigned long)LZ_HASH_SIZE,
+		   (unsigned long)sizeof(LZ_Stream_t), (unsigned)block);
+
+	uint8_t *dst = malloc(LZ_BOUND(block));
+	if (!dst)
+		return 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (argv[i][0] == '-')
+		{
+			i++;									/**< Option value							*/
+			continue;
+		}
+
+		uint32_t len;
+		uint8_t *data = Bench_Load(argv[i], &len);
+		if (!data)
+		{
+			free(dst);
+			return 1;
+		}
+		files++;
+		if (len == 0U)
+		{
+			printf("%s: empty\n", argv[i]);
+			free(data);
+			continue;
+		}
+
+		/* One pass for the size (and the block file), then repeat for a stable time */
+		FILE *out = out_path ? fopen(out_path, "wb") : NULL;
+		if (out_path && !out)
+		{
+			perror(out_path);
+			free(data);
+			free(dst);
+			return 1;
+		}
+		LZ_Init(&bench_lz);
+		const uint32_t packed = Bench_Pass(data, len, block, dst, out);
+		if (out)
+			fclose(out);
+
+		uint32_t passes = 0;
+		const double t0 = Bench_Now();
+		double t;
+		do {
+			LZ_Init(&bench_lz);
+			Bench_Pass(data, len, block, dst, NULL);
+			passes++;
+			t = Bench_Now() - t0;
+		} while (t < BENCH_MIN_SECONDS);
+
+		printf("%s: %u -> %u bytes, ratio %.2f (%.1f %%), compress %.2f MB/s (C, lz.c)\n",
+			   argv[i], (unsigned)len, (unsigned)packed, (double)len / packed,
+			   100.0 * packed / len, (double)len * passes / 1e6 / t);
+		free(data);
+	}
+
+	free(dst);
+	if (files == 0)
+	{
+		fprintf(stderr, "usage: %s [--block N] [--out FILE] capture...\n", argv[0]);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+  * @brief	Read a whole file.
+  * @param[in] path	File name.
+  * @param[out] len	Size in bytes.
+  * @retval	Buffer (free() it), NULL on error.
+  */
+static uint8_t *Bench_Load(const char *path, uint32_t *len)
+{
+	FILE *f = fopen(path, "rb");
+	uint8_t *data = NULL;
+	long size;
+
+	if (!f)
+	{
+		perror(path);
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && size <= 0x7FFFFFFFL
+			&& fseek(f, 0, SEEK_SET) == 0 && (data = malloc((size_t)size + 1U)) != NULL
+			&& fread(data, 1, (size_t)size, f) == (size_t)size)
+		*len = (uint32_t)size;
+	else
+	{
+		fprintf(stderr, "%s: read error\n", path);
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	return data;
+}
+
+/**
+  * @brief	Monotonic time.
+  * @retval	Seconds.
+  */
+static double Bench_Now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+  * @brief	Compress a buffer block by block into one stream.
+  * @param[in] data		Input.
+  * @param[in] len		Input bytes.
+  * @param[in] block	Input bytes per block.
+  * @param[out] dst		Block buffer, LZ_BOUND(block) bytes.
+  * @param[in] out		Block file (u16 length + block), or NULL.
+  * @retval	Compressed bytes.
+  */
+static uint32_t Bench_Pass(const uint8_t *data, uint32_t len, uint32_t block, uint8_t *dst, FILE *out)
+{
+	uint32_t packed = 0;
+
+	for (uint32_t i = 0; i < len; i += block)
+	{
+		const uint32_t n = (len - i < block) ? len - i : block;
+		const uint32_t size = LZ_Compress(&bench_lz, &data[i], n, dst);
+
+		packed += size;
+		if (out)
+		{
+			const uint8_t hdr[2] = { (uint8_t)size, (uint8_t)(size >> 8) };
+			fwrite(hdr, 1, sizeof(hdr), out);
+			fwrite(dst, 1, size, out);
+		}
+	}
+	return packed;
+}
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Host side of the 14-Debug_Telemetry LZ stream (Core/Inc/lz.h).
+
+Reference decoder: frame_decode.py uses the Decompressor class for LOG_LZ
+records. Ratio and speed are measured on the firmware's own compressor by
+Tools/lz_bench.c, which builds Core/Src/lz.c for the host; this script then
+checks its output:
+
+    cc -O2 -ICore/Inc -o lz_bench Tools/lz_bench.c Core/Src/lz.c
+    ./lz_bench log.bin --out log.lz
+    python3 Tools/lz_codec.py log.lz --expect log.bin
+
+The block file holds each block as a u16 little-endian length followed by
+the block. The exit status is 1 when the decoded stream differs from
+--expect. No third-party packages are needed.
+"""
+
+import argparse
+import sys
+import time
+
+MATCH_MIN = 3
+
+
+class Decompressor:
+    """Streaming decompressor: feed whole blocks, in order."""
+
+    def __init__(self, window_bits=12):
+        self.keep = 1 << window_bits                # history needed by later blocks
+        self.history = bytearray()
+
+    def decompress(self, block):
+        """Decode one block; raises ValueError on malformed input."""
+        hist, start, pos = self.history, len(self.history), 0
+        while pos < len(block):
+            flags = block[pos]
+            pos += 1
+            for bit in range(8):
+                if pos >= len(block):
+                    break
+                if not flags >> bit & 1:
+                    hist.append(block[pos])
+                    pos += 1
+                    continue
+                if pos + 2 > len(block):
+                    raise ValueError("truncated match")
+                dist = (block[pos] | (block[pos + 1] >> 4) << 8) + 1
+                length = (block[pos + 1] & 0x0F) + MATCH_MIN
+                pos += 2
+                if length == 15 + MATCH_MIN:
+                    if pos >= len(block):
+                        raise ValueError("truncated match")
+                    length += block[pos]
+                    pos += 1
+                if dist > len(hist):
+                    raise ValueError("distance before the start of the stream")
+                for _ in range(length):             # byte by byte: may overlap itself
+                    hist.append(hist[-dist])
+        out = bytes(hist[start:])
+        del hist[:max(0, len(hist) - self.keep)]
+        return out
+
+
+def read_blocks(data):
+    """Split a block file (u16 little-endian length, then the block) into blocks."""
+    blocks, pos = [], 0
+    while pos < len(data):
+        if pos + 2 > len(data):
+            raise ValueError("truncated block length")
+        size = data[pos] | data[pos + 1] << 8
+        if pos + 2 + size > len(data):
+            raise ValueError("truncated block")
+        blocks.append(data[pos + 2:pos + 2 + size])
+        pos += 2 + size
+    return blocks
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("blocks", help="block file written by lz_bench --out")
+    parser.add_argument("--expect", help="original capture: check the round trip")
+    parser.add_argument("-o", "--output", help="write the decoded stream here")
+    args = parser.parse_args()
+
+    with open(args.blocks, "rb") as f:
+        blocks = read_blocks(f.read())
+    dec = Decompressor()
+    t0 = time.perf_counter()
+    restored = b"".join(dec.decompress(b) for b in blocks)
+    t1 = time.perf_counter()
+    packed = sum(len(b) for b in blocks)
+    print(f"{args.blocks}: {len(blocks)} blocks, {packed} -> {len(restored)} bytes, "
+          f"decompress {len(restored) / 1e6 / max(t1 - t0, 1e-9):.2f} MB/s (Python)")
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(restored)
+    if args.expect:
+        with open(args.expect, "rb") as f:
+            if f.read() != restored:
+                print("round trip FAILED")
+                return 1
+        print("round trip OK")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,78 @@
+/**
+  * @file	boot.h
+  * @author	Parham Estiri
+  * @brief	Slot selection and hand-over to the application.
+  *
+  * 		Boot_Start() picks the slot to run:
+  * 		1. Of the slots with a consistent header whose image was not rejected,
+  * 		   the highest version wins (the confirmed slot on a tie).
+  * 		2. If that is not the confirmed slot, it is a new image on trial: it
+  * 		   gets BOOT_TRIAL_MAX boots to call BootState_Confirm(). After that
+  * 		   it is rejected and the other slot boots again (rollback), provided
+  * 		   there is one to fall back to.
+  * 		3. The image is checked in full only when its CRC is not in the
+  * 		   verification cache; a failed check rejects it and step 1 repeats.
+  * 		4. VTOR is set to the image's vector table, the peripherals the
+  * 		   bootloader used are reset, and the image starts with the clock
+  * 		   tree in its reset state (16 MHz HSI).
+  *
+  * 		Fast path (confirmed image, cached): read the state log, check two
+  * 		headers, jump. No flash is written and no image is scanned.
+  *
+  * 		Trial boots start the IWDG (BOOT_TRIAL_IWDG), so an image that hangs
+  * 		before BootState_Confirm() is reset and its attempts run out without
+  * 		anyone pressing reset. The watchdog cannot be stopped: an image keeps
+  * 		writing IWDG->KR = 0xAAAA at least every BOOT_TRIAL_IWDG_RELOAD / 500
+  * 		seconds while it runs (harmless when the IWDG is not running), or
+  * 		takes one watchdog reset after it confirmed and then boots normally.
+  * 		With BOOT_TRIAL_IWDG 0, a hanging trial image is rolled back only
+  * 		after manual resets (BOOT_TRIAL_MAX of them).
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+#include "boot_state.h"
+
+/******************************  Configuration  ******************************/
+#define BOOT_TRIAL_IWDG			1U			/**< 1: start the watchdog for trial boots		*/
+#define BOOT_TRIAL_IWDG_RELOAD	2000U		/**< 4 s at LSI / 64 (about 500 Hz)				*/
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Select a slot and start its image.
+  * @retval	None; returns only if no slot holds a bootable image.
+  */
+void Boot_Start(void);
+
+/**
+  * @brief	Slot an update should be written to.
+  * @param[in] state	Current boot state.
+  * @retval	The slot other than the confirmed one; if none is confirmed, the
+  * 		slot other than the one Boot_Start() would run (slot A if neither
+  * 		holds an image).
+  * @note	Never overwrites the image that runs or is known to run.
+  */
+uint8_t Boot_UpdateSlot(const Boot_State_t *state);
+
+/**
+  * @brief	Check the vector table of an image.
+  * @param[in] header	Image header (load_addr and size are used).
+  * @retval	1 if the initial SP is word-aligned in SRAM1/2 or CCM RAM and the
+  * 		reset vector is a Thumb address inside the image, 0 otherwise.
+  */
+uint8_t Boot_VectorsValid(const Image_Header_t *header);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BOOT_H_ */
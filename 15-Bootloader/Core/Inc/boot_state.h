@@ -0,0 +1,92 @@
+/**
+  * @file	boot_state.h
+  * @author	Parham Estiri
+  * @brief	Persistent boot state: confirmed slot, trial, verification cache.
+  *
+  * 		This module provides:
+  * 		 - A record log in two 16 KiB flash sectors. Each change appends one
+  * 		   32-byte record; the valid record with the highest sequence number
+  * 		   wins. A sector is only erased after the other one holds a newer
+  * 		   record, so a reset at any point leaves a valid state behind
+  * 		 - A verification cache: the CRC of each image that was checked in
+  * 		   full, so a normal boot only checks the 64-byte header
+  * 		 - Trial bookkeeping for a new image, and BootState_Confirm() for the
+  * 		   application to call once it runs correctly
+  *
+  * 		A normal boot of the confirmed image writes nothing. Records are
+  * 		appended after an update, for each trial boot and on confirmation,
+  * 		so a sector lasts 512 such events before it is erased.
+  *
+  * @note	Applications that confirm their boot add boot_state.c, image.c,
+  * 		flash.c and crc.c (with their headers) to their build.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef BOOT_STATE_H_
+#define BOOT_STATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+#include "image.h"
+#include "flash.h"
+
+/******************************  Configuration  ******************************/
+#define BOOT_STATE_ADDR0		0x08008000UL	/**< Sector 2							*/
+#define BOOT_STATE_ADDR1		0x0800C000UL	/**< Sector 3							*/
+#define BOOT_STATE_SECTOR0		2U
+#define BOOT_STATE_SECTOR1		3U
+#define BOOT_STATE_SECTOR_SIZE	0x4000UL
+#define BOOT_STATE_MAGIC		0x54534F42UL	/**< "BOST"								*/
+#define BOOT_TRIAL_MAX			3U				/**< Boots of a new image without confirmation before rollback	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Boot state record (32 bytes).
+  */
+typedef struct {
+	uint32_t	magic;
+	uint32_t	seq;				/**< Increments with every record				*/
+	uint8_t		confirmed;			/**< Slot known to run, or IMAGE_SLOT_NONE		*/
+	uint8_t		trial;				/**< Slot on trial, or IMAGE_SLOT_NONE			*/
+	uint8_t		attempts;			/**< Boots of the trial slot so far				*/
+	uint8_t		reserved;
+	uint32_t	verified[IMAGE_SLOTS];	/**< CRC of the image checked in full, 0: none	*/
+	uint32_t	rejected[IMAGE_SLOTS];	/**< CRC of an image not to boot again, 0: none	*/
+	uint32_t	crc;				/**< CRC-32 of the words above					*/
+} Boot_State_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Read the current state.
+  * @param[out] state	State; defaults (nothing confirmed, nothing cached) if none is stored.
+  * @retval	None
+  */
+void BootState_Load(Boot_State_t *state);
+
+/**
+  * @brief	Append a record with a changed state.
+  * @param[in,out] state	State from BootState_Load(); seq and crc are updated.
+  * @retval	FLASH_OK, or the error of the failed erase or write.
+  * @note	Call BootState_Load() first: it finds where the next record goes.
+  */
+Flash_Status_t BootState_Save(Boot_State_t *state);
+
+/**
+  * @brief	Mark the running image as good (called by the application).
+  * @retval	FLASH_OK if confirmed (or already confirmed), FLASH_EINVAL when not
+  * 		running from a slot, or the error of the failed write.
+  * @note	Ends the trial of a new image: it will not be rolled back.
+  */
+Flash_Status_t BootState_Confirm(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* BOOT_STATE_H_ */
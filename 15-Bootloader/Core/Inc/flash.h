@@ -0,0 +1,76 @@
+/**
+  * @file	flash.h
+  * @author	Parham Estiri
+  * @brief	Internal flash erase and programming.
+  *
+  * 		This module provides:
+  * 		 - Sector erase and 32-bit word programming (PSIZE x32, valid for a
+  * 		   2.7 .. 3.6 V supply as on the STM32F407G-DISC1)
+  * 		 - Read-back of every programmed word, so a write that did not take
+  * 		   (locked, protected, or not emulated) is reported, not assumed
+  * 		 - Data cache reset after an erase, so no stale line is read back
+  *
+  * 		| Sector | Address    | Size   |
+  * 		|--------|------------|--------|
+  * 		| 0 .. 3 | 0x08000000 | 16 KiB |
+  * 		| 4      | 0x08010000 | 64 KiB |
+  * 		| 5 .. 11| 0x08020000 | 128 KiB|
+  *
+  * @note	The CPU stalls on instruction fetch from flash while an erase or
+  * 		program operation runs (single bank): sector erase takes 0.5 .. 2 s
+  * 		for 128 KiB sectors, word programming about 16 us.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Flash operation status.
+  */
+typedef enum {
+	FLASH_OK		= 0,
+	FLASH_EINVAL	= 1,	/**< Address not word-aligned or not in flash	*/
+	FLASH_ERROR		= 2,	/**< Error flag set by the flash interface		*/
+	FLASH_EVERIFY	= 3		/**< Read-back differs from the written value	*/
+} Flash_Status_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Erase one sector.
+  * @param[in] sector	Sector number, 0 .. 11.
+  * @retval	FLASH_OK, FLASH_EINVAL or FLASH_ERROR.
+  */
+Flash_Status_t Flash_EraseSector(uint32_t sector);
+
+/**
+  * @brief	Program words into erased flash.
+  * @param[in] addr		Destination, word-aligned.
+  * @param[in] data		Words (any alignment).
+  * @param[in] words	Number of words.
+  * @retval	FLASH_OK, FLASH_EINVAL, FLASH_ERROR or FLASH_EVERIFY.
+  */
+Flash_Status_t Flash_Program(uint32_t addr, const void *data, uint32_t words);
+
+/**
+  * @brief	Sector that contains an address.
+  * @param[in] addr	Flash address.
+  * @retval	Sector number, or 0xFFFFFFFF outside the flash.
+  */
+uint32_t Flash_Sector(uint32_t addr);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FLASH_H_ */
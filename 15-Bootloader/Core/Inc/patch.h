@@ -0,0 +1,127 @@
+/**
+  * @file	patch.h
+  * @author	Parham Estiri
+  * @brief	Streaming binary patch (delta) decoder.
+  *
+  * 		Rebuilds a new image from the image in the other slot (the base) and
+  * 		a patch made by Tools/image_tool.py (diff), in the style of bsdiff:
+  * 		most of a rebuilt image is the base with small byte differences
+  * 		(moved code changes addresses and branch offsets), the rest is new.
+  *
+  * 		Stream (integers little-endian, counts as LEB128 varints):
+  *
+  * 		| Part    | Content                                                  |
+  * 		|---------|----------------------------------------------------------|
+  * 		| Header  | "BPAT", base CRC, base size, new size (4 words)          |
+  * 		| Record  | copy, extra, seek (zigzag), copy data, extra bytes       |
+  *
+  * 		A record produces `copy` bytes from the base at the base position,
+  * 		each plus a difference byte (mod 256), then `extra` bytes taken from
+  * 		the stream as they are. The base position then moves by `seek`.
+  * 		Copy data is a sequence of `same` (count of bytes whose difference
+  * 		is 0) and `literal` (count, then that many difference bytes) until
+  * 		`copy` bytes are covered: unchanged runs cost one or two bytes.
+  *
+  * 		The new image is linked for the other slot, so every absolute address
+  * 		in it differs from the base. Before the differences are applied, each
+  * 		aligned base word that points into the base's room (base .. base +
+  * 		dest_max) is moved by dest - base, the way detools filters Cortex-M
+  * 		code: only addresses that moved with the code change cost patch bytes.
+  *
+  * 		The decoder accepts the stream in pieces of any size. The base is
+  * 		read in place from flash; the output is collected in a
+  * 		PATCH_BUF_SIZE buffer and programmed into erased flash whenever it is
+  * 		full, so RAM use does not depend on the image size.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef PATCH_H_
+#define PATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Configuration  ******************************/
+#define PATCH_MAGIC				0x54415042UL	/**< "BPAT"								*/
+#define PATCH_HEADER_SIZE		16U
+#define PATCH_BUF_SIZE			256U			/**< Output bytes per flash write (multiple of 4)	*/
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Patch decoder status.
+  */
+typedef enum {
+	PATCH_OK		= 0,
+	PATCH_EFORMAT	= 1,	/**< Malformed stream or incomplete at the end		*/
+	PATCH_EBASE		= 2,	/**< Made for another base image					*/
+	PATCH_ERANGE	= 3,	/**< Reads past the base or writes past the new size	*/
+	PATCH_EFLASH	= 4		/**< Programming the output failed					*/
+} Patch_Status_t;
+
+/**
+  * @brief	Decoder state (PATCH_BUF_SIZE + 60 bytes).
+  */
+typedef struct {
+	uint32_t	base;				/**< Base image in flash						*/
+	uint32_t	base_size;
+	uint32_t	base_crc;
+	uint32_t	base_pos;
+	uint32_t	dest;				/**< Flash address of the new image				*/
+	uint32_t	dest_max;			/**< Room at dest								*/
+	uint32_t	new_size;			/**< From the stream header						*/
+	uint32_t	new_pos;			/**< Bytes produced (programmed or buffered)	*/
+	uint32_t	copy;				/**< Current record: copy bytes left			*/
+	uint32_t	extra;				/**< Extra bytes left							*/
+	int32_t		seek;
+	uint32_t	run;				/**< Literal bytes left							*/
+	uint32_t	value;				/**< Varint being read							*/
+	uint32_t	buf_len;			/**< Header bytes, then output bytes buffered	*/
+	uint8_t		shift;
+	uint8_t		state;
+	uint8_t		status;				/**< First error, repeated by later calls		*/
+	uint32_t	buf[PATCH_BUF_SIZE / 4U];
+} Patch_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Start decoding a patch.
+  * @param[out] patch	Decoder state.
+  * @param[in] base		Address of the base image, word-aligned.
+  * @param[in] base_size	Base image size in bytes.
+  * @param[in] base_crc	Base image CRC (from its header), checked against the patch.
+  * @param[in] dest		Erased, word-aligned flash for the new image.
+  * @param[in] dest_max	Room at dest in bytes.
+  * @retval	None
+  */
+void Patch_Init(Patch_t *patch, uint32_t base, uint32_t base_size, uint32_t base_crc,
+				uint32_t dest, uint32_t dest_max);
+
+/**
+  * @brief	Decode the next piece of the stream.
+  * @param[in,out] patch	Decoder state.
+  * @param[in] data		Stream bytes.
+  * @param[in] len		Number of bytes.
+  * @retval	PATCH_OK, or the first error (returned again by all later calls).
+  */
+Patch_Status_t Patch_Feed(Patch_t *patch, const uint8_t *data, uint32_t len);
+
+/**
+  * @brief	Finish decoding: check that the stream is complete, program the
+  * 		rest of the output.
+  * @param[in,out] patch	Decoder state.
+  * @param[out] size	Size of the new image in bytes.
+  * @retval	PATCH_OK or the error.
+  */
+Patch_Status_t Patch_End(Patch_t *patch, uint32_t *size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PATCH_H_ */
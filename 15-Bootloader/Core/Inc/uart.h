@@ -0,0 +1,62 @@
+/**
+  * @file	uart.h
+  * @author	Parham Estiri
+  * @brief	Polled USART2 for the update protocol.
+  *
+  * 		The bootloader has nothing else to do while it waits for the host,
+  * 		so reception and transmission simply poll the status register; no
+  * 		interrupt is enabled, nothing has to be undone before the jump
+  * 		beyond a peripheral reset.
+  *
+  * 		| Signal | Pin | Resource      |
+  * 		|--------|-----|---------------|
+  * 		| TX     | PA2 | AF7           |
+  * 		| RX     | PA3 | AF7, pull-up  |
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef UART_H_
+#define UART_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Configure PA2/PA3 and USART2 (8N1) from the current APB1 clock.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  */
+void UART_Init(uint32_t baud);
+
+/**
+  * @brief	Wait for one received byte.
+  * @retval	Byte.
+  * @note	An overrun is cleared and the lost bytes are left to the protocol CRC.
+  */
+uint8_t UART_Getc(void);
+
+/**
+  * @brief	Send bytes, waiting for room in the data register.
+  * @param[in] data	Bytes.
+  * @param[in] len	Number of bytes.
+  * @retval	None
+  */
+void UART_Write(const void *data, uint32_t len);
+
+/**
+  * @brief	Wait until the last byte has left the shift register.
+  * @retval	None
+  */
+void UART_Flush(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UART_H_ */
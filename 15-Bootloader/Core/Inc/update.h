@@ -0,0 +1,114 @@
+/**
+  * @file	update.h
+  * @author	Parham Estiri
+  * @brief	Firmware update over USART2 into the inactive slot.
+  *
+  * 		The host (Tools/image_tool.py) drives a stop-and-wait exchange: one
+  * 		request, one reply. Frames, little-endian:
+  *
+  * 		| Direction | Frame                                              |
+  * 		|-----------|----------------------------------------------------|
+  * 		| Request   | 0xA5, command, length (2), payload, CRC-32 (4)     |
+  * 		| Reply     | 0x5A, status, length (2), payload, CRC-32 (4)      |
+  *
+  * 		The CRC (crc.h) covers command/status, length and payload. A request
+  * 		with a bad CRC is answered with UPDATE_ECRC and can be sent again.
+  *
+  * 		| Command | Payload                  | Action                                   |
+  * 		|---------|--------------------------|------------------------------------------|
+  * 		| INFO    | -                        | Reply Update_Info_t                      |
+  * 		| ERASE   | -                        | Forget the target slot, erase it         |
+  * 		| WRITE   | offset (4), data         | Program data at slot + offset            |
+  * 		| PATCH   | offset (4), patch data   | Decode a delta against the other slot    |
+  * 		| FINISH  | Image_Header_t           | Check the image, then program the header |
+  * 		| RESET   | -                        | Reply, then reset (boots the new image)  |
+  *
+  * 		Updates only ever go to the slot Boot_UpdateSlot() names, never over
+  * 		the image that is known to run. The header is written last, after
+  * 		the image passed its CRC check: an interrupted update leaves a slot
+  * 		without a valid header, which the boot selection ignores. The new
+  * 		image's CRC goes into the verification cache, so its first boot
+  * 		does not scan it again; it then boots on trial (boot.h).
+  *
+  * 		Instead of WRITE, the image can arrive as a patch (patch.h) made
+  * 		against the image in the other slot, which is then the base. PATCH
+  * 		pieces carry their offset in the patch stream; they must arrive in
+  * 		order, and a piece sent again after a lost reply is acknowledged
+  * 		without being decoded twice. FINISH checks the rebuilt image the same
+  * 		way as an uploaded one.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#ifndef UPDATE_H_
+#define UPDATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "system.h"
+#include "image.h"
+
+/******************************  Configuration  ******************************/
+#define UPDATE_BAUD				115200UL
+#define UPDATE_CHUNK_MAX		256U		/**< Data bytes per WRITE (multiple of 4)		*/
+#define UPDATE_PAYLOAD_MAX		(4U + UPDATE_CHUNK_MAX)
+#define UPDATE_SYNC_REQUEST		0xA5U
+#define UPDATE_SYNC_REPLY		0x5AU
+
+/******************************  Type Definitions  ******************************/
+
+/**
+  * @brief	Request commands.
+  */
+typedef enum {
+	UPDATE_CMD_INFO		= 1,
+	UPDATE_CMD_ERASE	= 2,
+	UPDATE_CMD_WRITE	= 3,
+	UPDATE_CMD_FINISH	= 4,
+	UPDATE_CMD_RESET	= 5,
+	UPDATE_CMD_PATCH	= 6
+} Update_Command_t;
+
+/**
+  * @brief	Reply status.
+  */
+typedef enum {
+	UPDATE_OK		= 0,
+	UPDATE_ECRC		= 1,	/**< Request CRC mismatch: send it again			*/
+	UPDATE_EINVAL	= 2,	/**< Unknown command, bad length or range			*/
+	UPDATE_ESTATE	= 3,	/**< No preceding ERASE, or PATCH out of order		*/
+	UPDATE_EFLASH	= 4,	/**< Erase or programming failed					*/
+	UPDATE_EVERIFY	= 5,	/**< Header, image CRC or vector table invalid		*/
+	UPDATE_EPATCH	= 6		/**< Patch malformed or made for another base image	*/
+} Update_Status_t;
+
+/**
+  * @brief	INFO reply payload (32 bytes).
+  */
+typedef struct {
+	uint8_t		target;				/**< Slot this session writes to				*/
+	uint8_t		confirmed;			/**< Boot state (boot_state.h)					*/
+	uint8_t		trial;
+	uint8_t		attempts;
+	uint32_t	target_addr;		/**< Start of the target slot					*/
+	uint32_t	slot_size;
+	uint32_t	version[IMAGE_SLOTS];	/**< Version per slot, 0: no valid header	*/
+	uint32_t	chunk_max;			/**< UPDATE_CHUNK_MAX							*/
+	uint32_t	crc[IMAGE_SLOTS];	/**< Image CRC per slot: the base a patch needs	*/
+} Update_Info_t;
+
+/******************************  Function Prototypes  ******************************/
+
+/**
+  * @brief	Serve update requests until RESET.
+  * @retval	None; does not return.
+  */
+void Update_Run(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UPDATE_H_ */
@@ -0,0 +1,221 @@
+/**
+  * @file	boot.c
+  * @author	Parham Estiri
+  * @brief	Slot selection and hand-over to the application.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <stddef.h>
+#include "boot.h"
+
+#define BOOT_RAM_END			(SRAM1_BASE + 0x20000UL)		/**< SRAM1 + SRAM2		*/
+#define BOOT_CCM_END			(CCMDATARAM_BASE + 0x10000UL)
+
+/**************************  Static Function Prototypes  ***************************/
+static uint8_t Boot_Candidate(const Boot_State_t *state);
+static uint8_t Boot_Fallback(const Boot_State_t *state, uint8_t slot);
+static void Boot_Reject(Boot_State_t *state, uint8_t slot, const Image_Header_t *header);
+static __NO_RETURN void Boot_Jump(uint32_t vectors, uint8_t trial);
+
+/**
+  * @brief	Select a slot and start its image.
+  * @retval	None; returns only if no slot holds a bootable image.
+  */
+void Boot_Start(void)
+{
+	Boot_State_t state;
+	uint8_t dirty = 0;
+
+	BootState_Load(&state);
+
+	for (uint32_t pass = 0; pass <= IMAGE_SLOTS; pass++)		/**< Each failed pass rejects a slot	*/
+	{
+		const uint8_t slot = Boot_Candidate(&state);
+		const Image_Header_t *header;
+		uint8_t trial = 0;
+
+		if (slot == IMAGE_SLOT_NONE)
+			break;
+		header = Image_GetHeader(slot);
+
+		if (slot != state.confirmed)
+		{
+			if (state.trial != slot)
+			{
+				state.trial = slot;
+				state.attempts = 0;
+				dirty = 1;
+			}
+			if (state.attempts < BOOT_TRIAL_MAX)
+			{
+				state.attempts++;
+				dirty = 1;
+			}
+			else if (Boot_Fallback(&state, slot))
+			{
+				Boot_Reject(&state, slot, header);		/**< Never confirmed: roll back		*/
+				dirty = 1;
+				continue;
+			}
+			/* else: nothing to roll back to, keep booting it */
+			trial = 1;
+		}
+
+		if (state.verified[slot] != header->crc)
+		{
+			if (!Image_Verify(header) || !Boot_VectorsValid(header))
+			{
+				Boot_Reject(&state, slot, header);
+				dirty = 1;
+				continue;
+			}
+			state.verified[slot] = header->crc;
+			dirty = 1;
+		}
+
+		if (dirty)
+			BootState_Save(&state);					/**< Boots even if the log cannot be written	*/
+		Boot_Jump(header->load_addr, trial);
+	}
+
+	if (dirty)
+		BootState_Save(&state);
+}
+
+/**
+  * @brief	Slot an update should be written to.
+  * @param[in] state	Current boot state.
+  * @retval	The slot other than the confirmed one; if none is confirmed, the
+  * 		slot other than the one Boot_Start() would run (slot A if neither
+  * 		holds an image).
+  * @note	Never overwrites the image that runs or is known to run.
+  */
+uint8_t Boot_UpdateSlot(const Boot_State_t *state)
+{
+	uint8_t slot = state->confirmed;
+
+	if (slot == IMAGE_SLOT_NONE)
+		slot = Boot_Candidate(state);
+	return (slot == IMAGE_SLOT_NONE) ? 0U : (uint8_t)(slot ^ 1U);
+}
+
+/**
+  * @brief	Slot with the highest version among consistent, not rejected images.
+  */
+static uint8_t Boot_Candidate(const Boot_State_t *state)
+{
+	uint8_t best = IMAGE_SLOT_NONE;
+	uint32_t version = 0;
+
+	for (uint8_t slot = 0; slot < IMAGE_SLOTS; slot++)
+	{
+		const Image_Header_t *header = Image_GetHeader(slot);
+
+		if (header == NULL || state->rejected[slot] == header->crc)
+			continue;
+		if (best == IMAGE_SLOT_NONE || header->version > version
+		 || (header->version == version && slot == state->confirmed))
+		{
+			best = slot;
+			version = header->version;
+		}
+	}
+	return best;
+}
+
+/**
+  * @brief	Whether the other slot holds an image to roll back to.
+  */
+static uint8_t Boot_Fallback(const Boot_State_t *state, uint8_t slot)
+{
+	const uint8_t other = slot ^ 1U;
+	const Image_Header_t *header = Image_GetHeader(other);
+
+	return header != NULL && state->rejected[other] != header->crc;
+}
+
+/**
+  * @brief	Never boot this image again (until it is written anew).
+  */
+static void Boot_Reject(Boot_State_t *state, uint8_t slot, const Image_Header_t *header)
+{
+	state->rejected[slot] = header->crc;
+	state->verified[slot] = 0;
+	if (state->trial == slot)
+	{
+		state->trial = IMAGE_SLOT_NONE;
+		state->attempts = 0;
+	}
+	if (state->confirmed == slot)
+		state->confirmed = IMAGE_SLOT_NONE;
+}
+
+/**
+  * @brief	Check the vector table of an image.
+  * @param[in] header	Image header (load_addr and size are used).
+  * @retval	1 if the initial SP is word-aligned in SRAM1/2 or CCM RAM and the
+  * 		reset vector is a Thumb address inside the image, 0 otherwise.
+  */
+uint8_t Boot_VectorsValid(const Image_Header_t *header)
+{
+	const uint32_t *vectors = (const uint32_t *)header->load_addr;
+	const uint32_t sp = vectors[0];
+	const uint32_t pc = vectors[1];
+
+	if (sp & 3U)
+		return 0;
+	if (!((sp > SRAM1_BASE && sp <= BOOT_RAM_END) || (sp > CCMDATARAM_BASE && sp <= BOOT_CCM_END)))
+		return 0;
+	return (pc & 1U) && (pc & ~1UL) - header->load_addr < header->size;	/**< Thumb, in the image	*/
+}
+
+/**
+  * @brief	Put back what the bootloader changed and start the image.
+  * @param[in] vectors	Vector table of the image.
+  * @param[in] trial	1 for a trial boot (starts the watchdog if configured).
+  */
+static __NO_RETURN void Boot_Jump(uint32_t vectors, uint8_t trial)
+{
+	const uint32_t *table = (const uint32_t *)vectors;
+
+	__disable_irq();
+	SysTick->CTRL = 0;
+	for (uint32_t i = 0; i < sizeof(NVIC->ICER) / sizeof(NVIC->ICER[0]); i++)
+	{
+		NVIC->ICER[i] = 0xFFFFFFFFUL;
+		NVIC->ICPR[i] = 0xFFFFFFFFUL;
+	}
+
+	/* Peripherals used here back to their reset state, clocks off */
+	RCC->AHB1RSTR |= RCC_AHB1RSTR_GPIOARST | RCC_AHB1RSTR_GPIODRST | RCC_AHB1RSTR_CRCRST;
+	RCC->AHB1RSTR &= ~(RCC_AHB1RSTR_GPIOARST | RCC_AHB1RSTR_GPIODRST | RCC_AHB1RSTR_CRCRST);
+	RCC->APB1RSTR |= RCC_APB1RSTR_USART2RST;
+	RCC->APB1RSTR &= ~RCC_APB1RSTR_USART2RST;
+	RCC->AHB1ENR &= ~(RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_GPIODEN | RCC_AHB1ENR_CRCEN);
+	RCC->APB1ENR &= ~RCC_APB1ENR_USART2EN;
+
+#if BOOT_TRIAL_IWDG
+	if (trial)
+	{
+		IWDG->KR = 0xCCCCU;							/**< Start (cannot be stopped again)	*/
+		IWDG->KR = 0x5555U;							/**< Unlock PR and RLR					*/
+		IWDG->PR = 4U;								/**< LSI / 64							*/
+		IWDG->RLR = BOOT_TRIAL_IWDG_RELOAD;
+		while (IWDG->SR);
+		IWDG->KR = 0xAAAAU;
+	}
+#else
+	(void)trial;
+#endif /* BOOT_TRIAL_IWDG */
+
+	SCB->VTOR = vectors;
+	__DSB();
+	__ISB();
+	__enable_irq();									/**< PRIMASK as after reset				*/
+
+	__ASM volatile ("msr msp, %0\n\t"
+					"bx  %1"
+					: : "r" (table[0]), "r" (table[1]) : "memory");
+	while (1);										/**< Not reached						*/
+}
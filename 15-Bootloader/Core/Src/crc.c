@@ -0,0 +1,107 @@
+/**
+  * @file	crc.c
+  * @author	Parham Estiri
+  * @brief	CRC-32 on the hardware CRC calculation unit.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <string.h>
+#include "crc.h"
+
+#if defined(QEMU_NETDUINOPLUS2)
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t CRC_Feed(uint32_t crc, uint32_t word);
+#endif /* QEMU_NETDUINOPLUS2 */
+
+/**
+  * @brief	Enable the CRC unit clock.
+  * @retval	None
+  */
+void CRC_Init(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+	(void)RCC->AHB1ENR;						/**< Delay after enabling the clock	*/
+}
+
+/**
+  * @brief	CRC of a word-aligned block.
+  * @param[in] data		Words.
+  * @param[in] words	Number of words.
+  * @retval	CRC-32/MPEG-2 over the words.
+  */
+uint32_t CRC_Words(const uint32_t *data, uint32_t words)
+{
+#if defined(QEMU_NETDUINOPLUS2)
+	uint32_t crc = 0xFFFFFFFFUL;
+
+	while (words--)
+		crc = CRC_Feed(crc, *data++);
+	return crc;
+#else
+	CRC->CR = CRC_CR_RESET;
+
+	while (words >= 4U)						/**< Unrolled: the loop overhead would dominate	*/
+	{
+		CRC->DR = data[0];
+		CRC->DR = data[1];
+		CRC->DR = data[2];
+		CRC->DR = data[3];
+		data += 4;
+		words -= 4U;
+	}
+	while (words--)
+		CRC->DR = *data++;
+	return CRC->DR;
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+/**
+  * @brief	CRC of a byte string, zero-padded to a multiple of 4 bytes.
+  * @param[in] data	Bytes (any alignment).
+  * @param[in] len	Number of bytes.
+  * @retval	CRC-32/MPEG-2 over the padded words.
+  */
+uint32_t CRC_Bytes(const void *data, uint32_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	uint32_t word;
+#if defined(QEMU_NETDUINOPLUS2)
+	uint32_t crc = 0xFFFFFFFFUL;
+#else
+	CRC->CR = CRC_CR_RESET;
+#endif /* QEMU_NETDUINOPLUS2 */
+
+	for (; len; p += 4)
+	{
+		const uint32_t n = (len < 4U) ? len : 4U;
+
+		word = 0;
+		memcpy(&word, p, n);				/**< Unaligned-safe, zero-padded		*/
+		len -= n;
+#if defined(QEMU_NETDUINOPLUS2)
+		crc = CRC_Feed(crc, word);
+#else
+		CRC->DR = word;
+#endif /* QEMU_NETDUINOPLUS2 */
+	}
+
+#if defined(QEMU_NETDUINOPLUS2)
+	return crc;
+#else
+	return CRC->DR;
+#endif /* QEMU_NETDUINOPLUS2 */
+}
+
+#if defined(QEMU_NETDUINOPLUS2)
+/**
+  * @brief	One word through CRC-32/MPEG-2, bit by bit (as the hardware does).
+  */
+static uint32_t CRC_Feed(uint32_t crc, uint32_t word)
+{
+	crc ^= word;
+	for (uint32_t i = 0; i < 32U; i++)
+		crc = (crc & 0x80000000UL) ? (crc << 1) ^ 0x04C11DB7UL : (crc << 1);
+	return crc;
+}
+#endif /* QEMU_NETDUINOPLUS2 */
@@ -0,0 +1,134 @@
+/**
+  * @file	flash.c
+  * @author	Parham Estiri
+  * @brief	Internal flash erase and programming.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <string.h>
+#include "flash.h"
+
+#define FLASH_KEY1				0x45670123UL
+#define FLASH_KEY2				0xCDEF89ABUL
+#define FLASH_SECTORS			12U
+#define FLASH_SR_ERRORS			(FLASH_SR_PGSERR | FLASH_SR_PGPERR | FLASH_SR_PGAERR | FLASH_SR_WRPERR | FLASH_SR_OPERR)
+
+/**************************  Static Function Prototypes  ***************************/
+static void Flash_Unlock(void);
+static void Flash_Lock(void);
+static Flash_Status_t Flash_Wait(void);
+
+/**
+  * @brief	Erase one sector.
+  * @param[in] sector	Sector number, 0 .. 11.
+  * @retval	FLASH_OK, FLASH_EINVAL or FLASH_ERROR.
+  */
+Flash_Status_t Flash_EraseSector(uint32_t sector)
+{
+	Flash_Status_t status;
+
+	if (sector >= FLASH_SECTORS)
+		return FLASH_EINVAL;
+
+	Flash_Unlock();
+	FLASH->CR = FLASH_CR_PSIZE_1					/**< x32 parallelism				*/
+			  | FLASH_CR_SER
+			  | (sector << FLASH_CR_SNB_Pos);
+	FLASH->CR |= FLASH_CR_STRT;
+	status = Flash_Wait();
+	FLASH->CR &= ~FLASH_CR_SER;
+	Flash_Lock();
+
+	if (FLASH->ACR & FLASH_ACR_DCEN)				/**< Drop lines of the old contents	*/
+	{
+		FLASH->ACR &= ~FLASH_ACR_DCEN;
+		FLASH->ACR |= FLASH_ACR_DCRST;
+		FLASH->ACR &= ~FLASH_ACR_DCRST;
+		FLASH->ACR |= FLASH_ACR_DCEN;
+	}
+	return status;
+}
+
+/**
+  * @brief	Program words into erased flash.
+  * @param[in] addr		Destination, word-aligned.
+  * @param[in] data		Words (any alignment).
+  * @param[in] words	Number of words.
+  * @retval	FLASH_OK, FLASH_EINVAL, FLASH_ERROR or FLASH_EVERIFY.
+  */
+Flash_Status_t Flash_Program(uint32_t addr, const void *data, uint32_t words)
+{
+	const uint8_t *src = (const uint8_t *)data;
+	Flash_Status_t status = FLASH_OK;
+
+	if ((addr & 3U) || addr < FLASH_BASE || addr > FLASH_END || words > (FLASH_END + 1U - addr) / 4U)
+		return FLASH_EINVAL;
+
+	Flash_Unlock();
+	FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+	for (; words && status == FLASH_OK; words--, addr += 4U, src += 4)
+	{
+		uint32_t word;
+
+		memcpy(&word, src, 4U);
+		*(volatile uint32_t *)addr = word;
+		status = Flash_Wait();
+		if (status == FLASH_OK && *(volatile uint32_t *)addr != word)
+			status = FLASH_EVERIFY;
+	}
+	FLASH->CR &= ~FLASH_CR_PG;
+	Flash_Lock();
+	return status;
+}
+
+/**
+  * @brief	Sector that contains an address.
+  * @param[in] addr	Flash address.
+  * @retval	Sector number, or 0xFFFFFFFF outside the flash.
+  */
+uint32_t Flash_Sector(uint32_t addr)
+{
+	if (addr < FLASH_BASE || addr > FLASH_END)
+		return 0xFFFFFFFFUL;
+	addr -= FLASH_BASE;
+	if (addr < 0x10000UL)
+		return addr / 0x4000UL;						/**< 16 KiB sectors 0 .. 3			*/
+	if (addr < 0x20000UL)
+		return 4U;
+	return 4U + addr / 0x20000UL;					/**< 128 KiB sectors 5 .. 11		*/
+}
+
+/**
+  * @brief	Unlock the flash control register.
+  */
+static void Flash_Unlock(void)
+{
+	if (FLASH->CR & FLASH_CR_LOCK)
+	{
+		FLASH->KEYR = FLASH_KEY1;
+		FLASH->KEYR = FLASH_KEY2;
+	}
+	FLASH->SR = FLASH_SR_EOP | FLASH_SR_ERRORS;		/**< Write 1 to clear				*/
+}
+
+/**
+  * @brief	Lock the flash control register.
+  */
+static void Flash_Lock(void)
+{
+	FLASH->CR |= FLASH_CR_LOCK;
+}
+
+/**
+  * @brief	Wait for the current operation and collect its error flags.
+  */
+static Flash_Status_t Flash_Wait(void)
+{
+	uint32_t sr;
+
+	while (FLASH->SR & FLASH_SR_BSY);
+	sr = FLASH->SR;
+	FLASH->SR = FLASH_SR_EOP | (sr & FLASH_SR_ERRORS);
+	return (sr & FLASH_SR_ERRORS) ? FLASH_ERROR : FLASH_OK;
+}
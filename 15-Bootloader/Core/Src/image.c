@@ -0,0 +1,79 @@
+/**
+  * @file	image.c
+  * @author	Parham Estiri
+  * @brief	Flash layout and application image format.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <stddef.h>
+#include "image.h"
+#include "crc.h"
+
+#define IMAGE_HEADER_WORDS		((sizeof(Image_Header_t) / 4U) - 1U)	/**< Covered by header_crc	*/
+
+/**
+  * @brief	Start address of a slot.
+  * @param[in] slot	0 (A) or 1 (B).
+  * @retval	Address.
+  */
+uint32_t Image_SlotAddr(uint8_t slot)
+{
+	return (slot == 0U) ? IMAGE_SLOT_A_ADDR : IMAGE_SLOT_B_ADDR;
+}
+
+/**
+  * @brief	First flash sector of a slot.
+  * @param[in] slot	0 (A) or 1 (B).
+  * @retval	Sector number.
+  */
+uint32_t Image_SlotSector(uint8_t slot)
+{
+	return (slot == 0U) ? IMAGE_SLOT_A_SECTOR : IMAGE_SLOT_B_SECTOR;
+}
+
+/**
+  * @brief	Slot that contains an address.
+  * @param[in] addr	Address, e.g. SCB->VTOR of the running image.
+  * @retval	Slot, or IMAGE_SLOT_NONE.
+  */
+uint8_t Image_SlotOf(uint32_t addr)
+{
+	for (uint8_t slot = 0; slot < IMAGE_SLOTS; slot++)
+		if (addr - Image_SlotAddr(slot) < IMAGE_SLOT_SIZE)
+			return slot;
+	return IMAGE_SLOT_NONE;
+}
+
+/**
+  * @brief	Header of a slot, if it is consistent.
+  * @param[in] slot	0 (A) or 1 (B).
+  * @retval	Header, or NULL if missing, corrupt or not linked for this slot.
+  * @note	Checks the header only, not the image behind it.
+  */
+const Image_Header_t *Image_GetHeader(uint8_t slot)
+{
+	const uint32_t base = Image_SlotAddr(slot);
+	const Image_Header_t *header = (const Image_Header_t *)base;
+
+	if (slot >= IMAGE_SLOTS || header->magic != IMAGE_MAGIC)
+		return NULL;										/**< Erased or never written	*/
+	if (CRC_Words((const uint32_t *)header, IMAGE_HEADER_WORDS) != header->header_crc)
+		return NULL;
+	if (header->header_size != IMAGE_HEADER_SIZE
+	 || header->load_addr != base + IMAGE_HEADER_SIZE		/**< Linked for the other slot	*/
+	 || header->size == 0U || (header->size & 3U)
+	 || header->size > IMAGE_SLOT_SIZE - IMAGE_HEADER_SIZE)
+		return NULL;
+	return header;
+}
+
+/**
+  * @brief	Check the image behind a header against its CRC.
+  * @param[in] header	Header returned by Image_GetHeader().
+  * @retval	1 if the image is intact, 0 otherwise.
+  */
+uint8_t Image_Verify(const Image_Header_t *header)
+{
+	return CRC_Words((const uint32_t *)header->load_addr, header->size / 4U) == header->crc;
+}
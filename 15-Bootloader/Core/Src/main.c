@@ -0,0 +1,47 @@
+/**
+  * @file	main.c
+  * @author	Parham Estiri
+  * @brief	A/B bootloader.
+  *
+  * 		This file initializes the system, the CRC unit and the user button,
+  * 		then starts the image of the selected slot (boot.h). It enters update
+  * 		mode (update.h) instead when the user button is held at reset or no
+  * 		slot holds a bootable image; the orange LED shows update mode.
+  *
+  * @note	Uses CMSIS-only style (no HAL).
+  */
+
+#include "system.h"
+#include "stm32f407g_disc1.h"
+#include "crc.h"
+#include "boot.h"
+#include "update.h"
+
+/**
+  * @brief	Application entry point.
+  *
+  * 		The main function performs the following steps:
+  * 		1. Initializes core peripherals (the clock stays on the 16 MHz HSI).
+  * 		2. Enables the CRC unit and reads the user button.
+  * 		3. Button released: selects a slot and jumps to its image (no return).
+  * 		4. Button held, or nothing bootable: serves update requests on
+  * 		   USART2 until the host resets the board.
+  *
+  * @param	None
+  * @retval int		Always returns 0 (though this function never exits).
+  */
+int main(void)
+{
+	System_Init();			/**< Initialize system configuration		*/
+	CRC_Init();				/**< Image and boot state checks			*/
+	BSP_Button_Init(BUTTON_MODE_GPIO);		/**< Button read once, no interrupt	*/
+
+	if (!BSP_Button_Read())
+		Boot_Start();		/**< Returns only if no slot is bootable	*/
+
+	BSP_LED_Init();
+	BSP_LED_On(LED_ORANGE);	/**< Update mode							*/
+	Update_Run();			/**< Ends with a reset						*/
+
+	while (1);
+}
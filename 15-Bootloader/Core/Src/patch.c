@@ -0,0 +1,268 @@
+/**
+  * @file	patch.c
+  * @author	Parham Estiri
+  * @brief	Streaming binary patch (delta) decoder.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "patch.h"
+#include "flash.h"
+
+/**
+  * @brief	Decoder states: which field the next stream byte belongs to.
+  */
+typedef enum {
+	PATCH_S_HEADER = 0,
+	PATCH_S_COPY,				/**< Varint: copy count of the next record	*/
+	PATCH_S_EXTRA,				/**< Varint: extra count					*/
+	PATCH_S_SEEK,				/**< Varint: zigzag base position change	*/
+	PATCH_S_SAME,				/**< Varint: unchanged bytes				*/
+	PATCH_S_LITERAL,			/**< Varint: difference bytes that follow	*/
+	PATCH_S_DIFF,				/**< Difference byte						*/
+	PATCH_S_DATA				/**< Extra byte								*/
+} Patch_State_t;
+
+/**************************  Static Function Prototypes  ***************************/
+static Patch_Status_t Patch_Byte(Patch_t *patch, uint8_t byte);
+static Patch_Status_t Patch_Value(Patch_t *patch, uint32_t value);
+static Patch_Status_t Patch_Header(Patch_t *patch);
+static Patch_Status_t Patch_Next(Patch_t *patch);
+static uint8_t Patch_Base(const Patch_t *patch, uint32_t pos);
+static Patch_Status_t Patch_Put(Patch_t *patch, uint8_t byte);
+static Patch_Status_t Patch_Flush(Patch_t *patch);
+
+/**
+  * @brief	Start decoding a patch.
+  * @param[out] patch	Decoder state.
+  * @param[in] base		Address of the base image, word-aligned.
+  * @param[in] base_size	Base image size in bytes.
+  * @param[in] base_crc	Base image CRC (from its header), checked against the patch.
+  * @param[in] dest		Erased, word-aligned flash for the new image.
+  * @param[in] dest_max	Room at dest in bytes.
+  * @retval	None
+  */
+void Patch_Init(Patch_t *patch, uint32_t base, uint32_t base_size, uint32_t base_crc,
+				uint32_t dest, uint32_t dest_max)
+{
+	*patch = (Patch_t){
+		.base = base,
+		.base_size = base_size,
+		.base_crc = base_crc,
+		.dest = dest,
+		.dest_max = dest_max,
+		.state = PATCH_S_HEADER,
+	};
+}
+
+/**
+  * @brief	Decode the next piece of the stream.
+  * @param[in,out] patch	Decoder state.
+  * @param[in] data		Stream bytes.
+  * @param[in] len		Number of bytes.
+  * @retval	PATCH_OK, or the first error (returned again by all later calls).
+  */
+Patch_Status_t Patch_Feed(Patch_t *patch, const uint8_t *data, uint32_t len)
+{
+	while (len-- && patch->status == PATCH_OK)
+		patch->status = (uint8_t)Patch_Byte(patch, *data++);
+	return (Patch_Status_t)patch->status;
+}
+
+/**
+  * @brief	Finish decoding: check that the stream is complete, program the
+  * 		rest of the output.
+  * @param[in,out] patch	Decoder state.
+  * @param[out] size	Size of the new image in bytes.
+  * @retval	PATCH_OK or the error.
+  */
+Patch_Status_t Patch_End(Patch_t *patch, uint32_t *size)
+{
+	if (patch->status == PATCH_OK
+	 && (patch->state != PATCH_S_COPY || patch->shift != 0U || patch->new_pos != patch->new_size))
+		patch->status = PATCH_EFORMAT;		/**< Stopped inside a record or short of the size	*/
+	if (patch->status == PATCH_OK)
+		patch->status = (uint8_t)Patch_Flush(patch);
+
+	*size = patch->new_size;
+	return (Patch_Status_t)patch->status;
+}
+
+/**
+  * @brief	Decode one stream byte.
+  */
+static Patch_Status_t Patch_Byte(Patch_t *patch, uint8_t byte)
+{
+	switch (patch->state)
+	{
+		case PATCH_S_HEADER:
+			((uint8_t *)patch->buf)[patch->buf_len++] = byte;
+			return (patch->buf_len == PATCH_HEADER_SIZE) ? Patch_Header(patch) : PATCH_OK;
+
+		case PATCH_S_DIFF:
+			if (patch->base_pos >= patch->base_size)
+				return PATCH_ERANGE;
+			patch->copy--;
+			{
+				const Patch_Status_t status = Patch_Put(patch, (uint8_t)(Patch_Base(patch, patch->base_pos++) + byte));
+
+				if (status != PATCH_OK || --patch->run != 0U)
+					return status;
+			}
+			patch->state = PATCH_S_SAME;
+			return Patch_Next(patch);
+
+		case PATCH_S_DATA:
+			patch->extra--;
+			{
+				const Patch_Status_t status = Patch_Put(patch, byte);
+
+				return (status == PATCH_OK) ? Patch_Next(patch) : status;
+			}
+
+		default:							/**< Varint fields, 7 bits per byte, LSB first	*/
+			if (patch->shift > 28U || (patch->shift == 28U && (byte & 0x70U)))
+				return PATCH_EFORMAT;		/**< Above 32 bits								*/
+			patch->value |= (uint32_t)(byte & 0x7FU) << patch->shift;
+			if (byte & 0x80U)
+			{
+				patch->shift += 7U;
+				return PATCH_OK;
+			}
+			{
+				const uint32_t value = patch->value;
+
+				patch->value = 0;
+				patch->shift = 0;
+				return Patch_Value(patch, value);
+			}
+	}
+}
+
+/**
+  * @brief	Use a complete varint field.
+  */
+static Patch_Status_t Patch_Value(Patch_t *patch, uint32_t value)
+{
+	switch (patch->state)
+	{
+		case PATCH_S_COPY:
+			patch->copy = value;
+			patch->state = PATCH_S_EXTRA;
+			return PATCH_OK;
+
+		case PATCH_S_EXTRA:
+			patch->extra = value;
+			patch->state = PATCH_S_SEEK;
+			return PATCH_OK;
+
+		case PATCH_S_SEEK:
+			patch->seek = (int32_t)(value >> 1) ^ -(int32_t)(value & 1U);	/**< Zigzag	*/
+			if (patch->copy > patch->new_size - patch->new_pos
+			 || patch->extra > patch->new_size - patch->new_pos - patch->copy)
+				return PATCH_ERANGE;
+			patch->state = PATCH_S_SAME;
+			return Patch_Next(patch);
+
+		case PATCH_S_SAME:
+			if (value > patch->copy || value > patch->base_size - patch->base_pos)
+				return PATCH_ERANGE;
+			patch->copy -= value;
+			while (value--)
+			{
+				const Patch_Status_t status = Patch_Put(patch, Patch_Base(patch, patch->base_pos++));
+
+				if (status != PATCH_OK)
+					return status;
+			}
+			patch->state = PATCH_S_LITERAL;
+			return Patch_Next(patch);
+
+		case PATCH_S_LITERAL:
+			if (value > patch->copy)
+				return PATCH_ERANGE;
+			patch->run = value;
+			patch->state = value ? PATCH_S_DIFF : PATCH_S_SAME;
+			return PATCH_OK;
+
+		default:
+			return PATCH_EFORMAT;
+	}
+}
+
+/**
+  * @brief	Check the stream header against the base and the destination.
+  */
+static Patch_Status_t Patch_Header(Patch_t *patch)
+{
+	const uint32_t *header = patch->buf;
+
+	patch->buf_len = 0;
+	if (header[0] != PATCH_MAGIC || (header[3] & 3U) || header[3] > patch->dest_max)
+		return PATCH_EFORMAT;
+	if (header[1] != patch->base_crc || header[2] != patch->base_size)
+		return PATCH_EBASE;
+
+	patch->new_size = header[3];
+	patch->state = PATCH_S_COPY;
+	return PATCH_OK;
+}
+
+/**
+  * @brief	Move on once the current part of a record is done: copy data,
+  * 		then extra bytes, then the seek and the next record.
+  */
+static Patch_Status_t Patch_Next(Patch_t *patch)
+{
+	if (patch->state == PATCH_S_SAME || patch->state == PATCH_S_LITERAL)
+	{
+		if (patch->copy)
+			return PATCH_OK;				/**< More copy data follows						*/
+		patch->state = PATCH_S_DATA;
+	}
+	if (patch->extra)
+		return PATCH_OK;
+
+	if ((patch->seek < 0) ? (0U - (uint32_t)patch->seek > patch->base_pos)
+						  : ((uint32_t)patch->seek > patch->base_size - patch->base_pos))
+		return PATCH_ERANGE;
+	patch->base_pos += (uint32_t)patch->seek;
+	patch->state = PATCH_S_COPY;
+	return PATCH_OK;
+}
+
+/**
+  * @brief	Base byte, with addresses into the base moved to the destination.
+  */
+static uint8_t Patch_Base(const Patch_t *patch, uint32_t pos)
+{
+	uint32_t word = *(const uint32_t *)(patch->base + (pos & ~3U));
+
+	if (word - patch->base < patch->dest_max)
+		word += patch->dest - patch->base;
+	return (uint8_t)(word >> (8U * (pos & 3U)));
+}
+
+/**
+  * @brief	Append one output byte, programming the buffer when it is full.
+  */
+static Patch_Status_t Patch_Put(Patch_t *patch, uint8_t byte)
+{
+	if (patch->new_pos >= patch->new_size)
+		return PATCH_ERANGE;
+	((uint8_t *)patch->buf)[patch->buf_len++] = byte;
+	patch->new_pos++;
+	return (patch->buf_len == PATCH_BUF_SIZE) ? Patch_Flush(patch) : PATCH_OK;
+}
+
+/**
+  * @brief	Program the buffered output (a multiple of 4 bytes).
+  */
+static Patch_Status_t Patch_Flush(Patch_t *patch)
+{
+	const uint32_t addr = patch->dest + patch->new_pos - patch->buf_len;
+	const Flash_Status_t status = Flash_Program(addr, patch->buf, patch->buf_len / 4U);
+
+	patch->buf_len = 0;
+	return (status == FLASH_OK) ? PATCH_OK : PATCH_EFLASH;
+}
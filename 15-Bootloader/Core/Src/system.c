@@ -0,0 +1,41 @@
+/**
+  * @file	system.c
+  * @author	Parham Estiri
+  * @brief	System Initialization and Configuration.
+  *
+  * 		This file contains:
+  * 		 - NVIC priority grouping macros
+  * 		 - QEMU (netduinoplus2) start-up path, selected by QEMU_NETDUINOPLUS2
+  *
+  * 		Unlike the other projects, the bootloader leaves the clock tree as
+  * 		reset set it up (16 MHz HSI): the application it starts configures
+  * 		HSE and PLL itself and expects to find them off.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "system.h"
+
+/************************  NVIC Priority Group Definitions  ************************/
+#define NVIC_PRIORITYGROUP_0	0x7UL	/**< 0 bits for pre-emption priority, 4 bits for subpriority */
+#define NVIC_PRIORITYGROUP_1	0x6UL	/**< 1 bits for pre-emption priority, 3 bits for subpriority */
+#define NVIC_PRIORITYGROUP_2	0x5UL	/**< 2 bits for pre-emption priority, 2 bits for subpriority */
+#define NVIC_PRIORITYGROUP_3	0x4UL	/**< 3 bits for pre-emption priority, 1 bits for subpriority */
+#define NVIC_PRIORITYGROUP_4	0x3UL	/**< 4 bits for pre-emption priority, 0 bits for subpriority */
+
+/**
+  * @brief	Sets NVIC priority grouping and updates SystemCoreClock variable (clock left at reset).
+  * @param	None
+  * @retval	None
+  * @note	This function must be called at the beginning of main() before using peripherals.
+  */
+void System_Init(void)
+{
+	NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);	/**< NVIC: 4 preemptive, 0 sub-priority bits  */
+#if defined(QEMU_NETDUINOPLUS2)
+	/* RCC is not emulated: SYSCLK is fixed by the machine */
+	SystemCoreClock = QEMU_SYSCLK_HZ;
+#else
+	SystemCoreClockUpdate();						/**< 16 MHz HSI							  */
+#endif /* QEMU_NETDUINOPLUS2 */
+}
@@ -0,0 +1,78 @@
+/**
+  * @file	uart.c
+  * @author	Parham Estiri
+  * @brief	Polled USART2 for the update protocol.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include "uart.h"
+
+/**
+  * @brief	Configure PA2/PA3 and USART2 (8N1) from the current APB1 clock.
+  * @param[in] baud	Baud rate.
+  * @retval	None
+  */
+void UART_Init(uint32_t baud)
+{
+	const uint32_t pclk1 = SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
+	RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
+	(void)RCC->APB1ENR;								/**< Delay after enabling the clock		*/
+
+	GPIOA->MODER &= ~(GPIO_MODER_MODER2 | GPIO_MODER_MODER3);
+	GPIOA->MODER |= GPIO_MODER_MODER2_1 | GPIO_MODER_MODER3_1;		/**< Alternate function	*/
+	GPIOA->AFR[0] &= ~((0xFU << (4 * 2)) | (0xFU << (4 * 3)));
+	GPIOA->AFR[0] |= (7U << (4 * 2)) | (7U << (4 * 3));			/**< AF7: USART2		*/
+	GPIOA->PUPDR &= ~(GPIO_PUPDR_PUPDR2 | GPIO_PUPDR_PUPDR3);
+	GPIOA->PUPDR |= GPIO_PUPDR_PUPDR3_0;			/**< RX idles high when unconnected		*/
+
+	USART2->CR1 = 0;
+	USART2->BRR = (pclk1 + baud / 2U) / baud;		/**< 16x oversampling: mantissa.fraction	*/
+	USART2->CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+}
+
+/**
+  * @brief	Wait for one received byte.
+  * @retval	Byte.
+  * @note	An overrun is cleared and the lost bytes are left to the protocol CRC.
+  */
+uint8_t UART_Getc(void)
+{
+	while (1)
+	{
+		const uint32_t sr = USART2->SR;
+
+		if (sr & USART_SR_ORE)
+			(void)USART2->DR;						/**< SR then DR read clears ORE			*/
+		else if (sr & USART_SR_RXNE)
+			return (uint8_t)USART2->DR;
+	}
+}
+
+/**
+  * @brief	Send bytes, waiting for room in the data register.
+  * @param[in] data	Bytes.
+  * @param[in] len	Number of bytes.
+  * @retval	None
+  */
+void UART_Write(const void *data, uint32_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+
+	while (len--)
+	{
+		while (!(USART2->SR & USART_SR_TXE));
+		USART2->DR = *p++;
+	}
+}
+
+/**
+  * @brief	Wait until the last byte has left the shift register.
+  * @retval	None
+  */
+void UART_Flush(void)
+{
+	while (!(USART2->SR & USART_SR_TC));
+}
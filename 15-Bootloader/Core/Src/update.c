@@ -0,0 +1,295 @@
+/**
+  * @file	update.c
+  * @author	Parham Estiri
+  * @brief	Firmware update over USART2 into the inactive slot.
+  *
+  * Target	STM32F407VGT6
+  */
+
+#include <stddef.h>
+#include <string.h>
+#include "update.h"
+#include "boot.h"
+#include "crc.h"
+#include "uart.h"
+#include "patch.h"
+
+static uint8_t update_frame[3U + UPDATE_PAYLOAD_MAX + 4U];	/**< command/status, length, payload, CRC	*/
+static Boot_State_t update_state;
+static uint8_t update_target;
+static uint8_t update_erased;				/**< Target erased, header not yet written		*/
+static Patch_t update_patch;
+static uint32_t update_patched;				/**< Patch bytes decoded since ERASE			*/
+
+/**************************  Static Function Prototypes  ***************************/
+static uint32_t Update_Receive(void);
+static void Update_Reply(Update_Status_t status, const void *payload, uint32_t len);
+static Update_Status_t Update_Erase(void);
+static Update_Status_t Update_Write(const uint8_t *payload, uint32_t len);
+static Update_Status_t Update_Patch(const uint8_t *payload, uint32_t len);
+static Update_Status_t Update_Finish(const uint8_t *payload, uint32_t len);
+static void Update_Info(void);
+
+/**
+  * @brief	Serve update requests until RESET.
+  * @retval	None; does not return.
+  */
+void Update_Run(void)
+{
+	BootState_Load(&update_state);
+	update_target = Boot_UpdateSlot(&update_state);
+	UART_Init(UPDATE_BAUD);
+
+	while (1)
+	{
+		const uint32_t len = Update_Receive();
+		const uint8_t *payload = &update_frame[3];
+
+		switch (update_frame[0])
+		{
+			case UPDATE_CMD_INFO:
+				Update_Info();
+				break;
+
+			case UPDATE_CMD_ERASE:
+				Update_Reply(len ? UPDATE_EINVAL : Update_Erase(), NULL, 0);
+				break;
+
+			case UPDATE_CMD_WRITE:
+				Update_Reply(Update_Write(payload, len), NULL, 0);
+				break;
+
+			case UPDATE_CMD_PATCH:
+				Update_Reply(Update_Patch(payload, len), NULL, 0);
+				break;
+
+			case UPDATE_CMD_FINISH:
+				Update_Reply(Update_Finish(payload, len), NULL, 0);
+				break;
+
+			case UPDATE_CMD_RESET:
+				Update_Reply(UPDATE_OK, NULL, 0);
+				UART_Flush();
+				NVIC_SystemReset();
+				break;
+
+			default:
+				Update_Reply(UPDATE_EINVAL, NULL, 0);
+				break;
+		}
+	}
+}
+
+/**
+  * @brief	Wait for a request with a valid CRC.
+  * @retval	Payload length; command and payload are in update_frame.
+  */
+static uint32_t Update_Receive(void)
+{
+	while (1)
+	{
+		uint32_t len, crc = 0;
+
+		while (UART_Getc() != UPDATE_SYNC_REQUEST);		/**< Resynchronize on the sync byte	*/
+
+		for (uint32_t i = 0; i < 3U; i++)
+			update_frame[i] = UART_Getc();
+		len = update_frame[1] | ((uint32_t)update_frame[2] << 8);
+		if (len > UPDATE_PAYLOAD_MAX)
+			continue;
+
+		for (uint32_t i = 0; i < len; i++)
+			update_frame[3U + i] = UART_Getc();
+		for (uint32_t i = 0; i < 4U; i++)
+			crc |= (uint32_t)UART_Getc() << (8U * i);
+
+		if (CRC_Bytes(update_frame, 3U + len) == crc)
+			return len;
+		Update_Reply(UPDATE_ECRC, NULL, 0);
+	}
+}
+
+/**
+  * @brief	Send a reply frame (reuses the request buffer).
+  */
+static void Update_Reply(Update_Status_t status, const void *payload, uint32_t len)
+{
+	const uint8_t sync = UPDATE_SYNC_REPLY;
+	uint32_t crc;
+
+	update_frame[0] = (uint8_t)status;
+	update_frame[1] = (uint8_t)len;
+	update_frame[2] = (uint8_t)(len >> 8);
+	if (len)
+		memmove(&update_frame[3], payload, len);
+	crc = CRC_Bytes(update_frame, 3U + len);
+	memcpy(&update_frame[3U + len], &crc, 4U);			/**< Little-endian core			*/
+
+	UART_Write(&sync, 1U);
+	UART_Write(update_frame, 3U + len + 4U);
+}
+
+/**
+  * @brief	Forget the target slot in the boot state, then erase it.
+  */
+static Update_Status_t Update_Erase(void)
+{
+	const uint32_t sector = Image_SlotSector(update_target);
+
+	if (update_state.verified[update_target] || update_state.rejected[update_target]
+	 || update_state.trial == update_target)
+	{
+		update_state.verified[update_target] = 0;		/**< Before the contents change	*/
+		update_state.rejected[update_target] = 0;
+		if (update_state.trial == update_target)
+		{
+			update_state.trial = IMAGE_SLOT_NONE;
+			update_state.attempts = 0;
+		}
+		if (BootState_Save(&update_state) != FLASH_OK)
+			return UPDATE_EFLASH;
+	}
+
+	update_erased = 0;
+	update_patched = 0;
+	for (uint32_t i = 0; i < IMAGE_SLOT_SECTORS; i++)
+		if (Flash_EraseSector(sector + i) != FLASH_OK)
+			return UPDATE_EFLASH;
+	update_erased = 1;
+	return UPDATE_OK;
+}
+
+/**
+  * @brief	WRITE: offset (4), data. Only the image area, never the header.
+  */
+static Update_Status_t Update_Write(const uint8_t *payload, uint32_t len)
+{
+	uint32_t offset;
+
+	if (!update_erased || update_patched)
+		return UPDATE_ESTATE;
+	if (len <= 4U || ((len - 4U) & 3U))
+		return UPDATE_EINVAL;
+	memcpy(&offset, payload, 4U);
+	len -= 4U;
+	if ((offset & 3U) || offset < IMAGE_HEADER_SIZE || offset > IMAGE_SLOT_SIZE - len)
+		return UPDATE_EINVAL;
+
+	return (Flash_Program(Image_SlotAddr(update_target) + offset, payload + 4, len / 4U) == FLASH_OK)
+		   ? UPDATE_OK : UPDATE_EFLASH;
+}
+
+/**
+  * @brief	PATCH: offset in the patch stream (4), patch data. The base is the
+  * 		image in the other slot; the output goes where WRITE would put it.
+  */
+static Update_Status_t Update_Patch(const uint8_t *payload, uint32_t len)
+{
+	uint32_t offset;
+	Patch_Status_t status;
+
+	if (!update_erased)
+		return UPDATE_ESTATE;
+	if (len <= 4U)
+		return UPDATE_EINVAL;
+	memcpy(&offset, payload, 4U);
+	len -= 4U;
+
+	if (offset < update_patched && offset + len == update_patched)
+		return UPDATE_OK;							/**< Sent again: its reply was lost		*/
+	if (offset != update_patched)
+		return UPDATE_ESTATE;
+
+	if (offset == 0U)
+	{
+		const uint8_t base_slot = update_target ^ 1U;
+		const Image_Header_t *base = Image_GetHeader(base_slot);
+
+		if (base == NULL)
+			return UPDATE_EPATCH;
+		Patch_Init(&update_patch, base->load_addr, base->size, base->crc,
+				   Image_SlotAddr(update_target) + IMAGE_HEADER_SIZE, IMAGE_SLOT_SIZE - IMAGE_HEADER_SIZE);
+	}
+
+	status = Patch_Feed(&update_patch, payload + 4, len);
+	if (status != PATCH_OK)
+	{
+		update_erased = 0;							/**< Start over with ERASE				*/
+		return (status == PATCH_EFLASH) ? UPDATE_EFLASH : UPDATE_EPATCH;
+	}
+	update_patched += len;
+	return UPDATE_OK;
+}
+
+/**
+  * @brief	FINISH: check the written image against the header, then commit it.
+  */
+static Update_Status_t Update_Finish(const uint8_t *payload, uint32_t len)
+{
+	const uint32_t base = Image_SlotAddr(update_target);
+	Image_Header_t header;
+
+	if (!update_erased)
+		return UPDATE_ESTATE;
+	if (len != sizeof(header))
+		return UPDATE_EINVAL;
+	memcpy(&header, payload, sizeof(header));
+
+	if (update_patched)
+	{
+		uint32_t size;
+		const Patch_Status_t status = Patch_End(&update_patch, &size);
+
+		if (status != PATCH_OK)
+		{
+			update_erased = 0;
+			return (status == PATCH_EFLASH) ? UPDATE_EFLASH : UPDATE_EPATCH;
+		}
+		if (size != header.size)
+			return UPDATE_EVERIFY;
+	}
+
+	if (header.magic != IMAGE_MAGIC
+	 || CRC_Words((const uint32_t *)&header, sizeof(header) / 4U - 1U) != header.header_crc
+	 || header.header_size != IMAGE_HEADER_SIZE
+	 || header.load_addr != base + IMAGE_HEADER_SIZE		/**< Linked for the other slot	*/
+	 || header.size == 0U || (header.size & 3U)
+	 || header.size > IMAGE_SLOT_SIZE - IMAGE_HEADER_SIZE
+	 || !Image_Verify(&header)
+	 || !Boot_VectorsValid(&header))						/**< Boot_Start() would reject it	*/
+		return UPDATE_EVERIFY;
+
+	if (Flash_Program(base, &header, sizeof(header) / 4U) != FLASH_OK
+	 || Image_GetHeader(update_target) == NULL)
+		return UPDATE_EFLASH;
+	update_erased = 0;
+
+	update_state.verified[update_target] = header.crc;	/**< First boot skips the scan	*/
+	BootState_Save(&update_state);						/**< Only a cache: boots anyway	*/
+	return UPDATE_OK;
+}
+
+/**
+  * @brief	INFO: target slot, boot state and slot versions.
+  */
+static void Update_Info(void)
+{
+	Update_Info_t info = {
+		.target = update_target,
+		.confirmed = update_state.confirmed,
+		.trial = update_state.trial,
+		.attempts = update_state.attempts,
+		.target_addr = Image_SlotAddr(update_target),
+		.slot_size = IMAGE_SLOT_SIZE,
+		.chunk_max = UPDATE_CHUNK_MAX,
+	};
+
+	for (uint8_t slot = 0; slot < IMAGE_SLOTS; slot++)
+	{
+		const Image_Header_t *header = Image_GetHeader(slot);
+
+		info.version[slot] = header ? header->version : 0U;
+		info.crc[slot] = header ? header->crc : 0U;
+	}
+	Update_Reply(UPDATE_OK, &info, sizeof(info));
+}
@@ -0,0 +1,523 @@
+#!/usr/bin/env python3
+"""Build, inspect, diff and upload application images for the 15-Bootloader A/B slots.
+
+An image runs in place, so it is linked for one slot: in the application's
+STM32F407VGTX_FLASH.ld set FLASH ORIGIN to the slot address + 0x200 and
+LENGTH to 384K - 0x200 (slot A 0x08020200, slot B 0x08080200), then export
+a raw binary (arm-none-eabi-objcopy -O binary app.elf app_a.bin).
+
+    python3 image_tool.py sign app_a.bin app_a.img --slot a --version 1.2.0
+    python3 image_tool.py info app_a.img
+    python3 image_tool.py flash /dev/ttyACM0 app_a.img app_b.img
+    python3 image_tool.py diff app_a_1.img app_b_2.img a1_to_b2.patch
+    python3 image_tool.py flash /dev/ttyACM0 a1_to_b2.patch app_a_2.img app_b_2.img
+
+`sign` prepends the 512-byte header area (Core/Inc/image.h). `flash` talks
+to the bootloader in update mode (hold the user button during reset): it
+asks which slot to write, picks the image linked for that slot, erases,
+writes (skipping all-0xFF chunks), and lets the bootloader check the CRC
+before the header is committed. The new image then boots on trial and has
+to call BootState_Confirm(), or the bootloader rolls back to the other slot
+after three boots. Images only replace the running one when their version
+is higher.
+
+`diff` makes a patch (Core/Inc/patch.h) that turns the image running in one
+slot into the new image for the other. The bootloader rebuilds the new image
+from the old one in flash, so only the differences cross the link: a few
+KiB for a typical change instead of the whole image. `flash` sends a patch
+when the target slot and the running image match it, and falls back to a
+full image otherwise. No third-party packages are needed (POSIX serial via
+termios).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+HEADER_SIZE = 0x200
+HEADER_FORMAT = "<6I9II"                       # magic .. load_addr, reserved[9], header_crc
+MAGIC = 0x474D4942                             # "BIMG"
+SLOTS = {"a": 0x08020000, "b": 0x08080000}
+SLOT_SIZE = 0x60000
+RAM_RANGES = ((0x20000000, 0x20020000), (0x10000000, 0x10010000))
+
+SYNC_REQUEST, SYNC_REPLY = 0xA5, 0x5A
+CMD_INFO, CMD_ERASE, CMD_WRITE, CMD_FINISH, CMD_RESET, CMD_PATCH = range(1, 7)
+STATUS = {0: "ok", 1: "frame CRC error", 2: "invalid request", 3: "slot not erased",
+          4: "flash error", 5: "image check failed", 6: "patch rejected"}
+INFO_FORMAT = "<4B7I"
+
+PATCH_MAGIC = 0x54415042                       # "BPAT"
+PATCH_GRAM = 8                                 # bytes hashed to find matches in the old image
+PATCH_CANDIDATES = 32                          # old positions tried per hash
+PATCH_GIVE_UP = 64                             # bytes without gain that end a copy
+
+
+def crc32_stm(data, crc=0xFFFFFFFF):
+    """CRC-32/MPEG-2 as the STM32 CRC unit computes it: little-endian words,
+    the last one zero-padded."""
+    data = bytes(data) + bytes(-len(data) % 4)
+    for (word,) in struct.iter_unpack("<I", data):
+        crc ^= word
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else crc << 1
+        crc &= 0xFFFFFFFF
+    return crc
+
+
+def parse_version(text):
+    parts = [int(p) for p in text.split(".")]
+    if not 1 <= len(parts) <= 3 or parts[0] > 255 or (len(parts) > 1 and parts[1] > 255) \
+            or (len(parts) > 2 and parts[2] > 0xFFFF):
+        raise argparse.ArgumentTypeError("version is major[.minor[.patch]], 255.255.65535 at most")
+    parts += [0] * (3 - len(parts))
+    return (parts[0] << 24) | (parts[1] << 16) | parts[2]
+
+
+def format_version(version):
+    return f"{version >> 24}.{(version >> 16) & 0xFF}.{version & 0xFFFF}"
+
+
+def make_header(body, load_addr, version):
+    words = [MAGIC, HEADER_SIZE, version, len(body), crc32_stm(body), load_addr] + [0] * 9
+    words.append(crc32_stm(struct.pack("<15I", *words)))
+    return struct.pack(HEADER_FORMAT, *words)
+
+
+def parse_header(data):
+    """Fields of the 64-byte image header at the start of data, or raise ValueError."""
+    if len(data) < struct.calcsize(HEADER_FORMAT):
+        raise ValueError("file too short")
+    fields = struct.unpack_from(HEADER_FORMAT, data)
+    magic, header_size, version, size, crc, load_addr = fields[:6]
+    if magic != MAGIC or crc32_stm(data[:60]) != fields[-1] or header_size != HEADER_SIZE:
+        raise ValueError("no valid header")
+    slot = next((s for s, a in SLOTS.items() if a + HEADER_SIZE == load_addr), None)
+    if slot is None:
+        raise ValueError(f"load address 0x{load_addr:08x} is not a slot")
+    return {"version": version, "size": size, "crc": crc, "load_addr": load_addr, "slot": slot}
+
+
+def parse_image(image):
+    """Header fields of an image file, or raise ValueError."""
+    header = parse_header(image)
+    if len(image) != HEADER_SIZE + header["size"]:
+        raise ValueError("header does not match the file size")
+    if crc32_stm(image[HEADER_SIZE:]) != header["crc"]:
+        raise ValueError("image CRC mismatch")
+    return header
+
+
+def is_patch(data):
+    return len(data) >= 68 and struct.unpack_from("<I", data, 64)[0] == PATCH_MAGIC
+
+
+def parse_patch(data):
+    """Fields of a patch file: the new image's header, then the patch stream."""
+    header = parse_header(data)
+    if len(data) < 64 + 16:
+        raise ValueError("file too short")
+    _, base_crc, base_size, new_size = struct.unpack_from("<4I", data, 64)
+    if new_size != header["size"]:
+        raise ValueError("patch does not match its header")
+    header.update(base_crc=base_crc, base_size=base_size, stream=data[64:])
+    return header
+
+
+def check_vectors(body, load_addr):
+    sp, pc = struct.unpack_from("<II", body)
+    if not any(lo < sp <= hi for lo, hi in RAM_RANGES) or sp & 3:
+        raise ValueError(f"initial SP 0x{sp:08x} is not in RAM: not a vector table?")
+    if not pc & 1 or not 0 <= (pc & ~1) - load_addr < len(body):
+        raise ValueError(f"reset vector 0x{pc:08x} is outside the image: "
+                         f"linked for 0x{load_addr:08x}?")
+
+
+def varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append(value & 0x7F | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def match_length(a, ai, b, bi):
+    """Length of the common prefix of a[ai:] and b[bi:]."""
+    limit = min(len(a) - ai, len(b) - bi)
+    length, step = 0, 64
+    while length < limit:
+        n = min(step, limit - length)
+        if a[ai + length:ai + length + n] == b[bi + length:bi + length + n]:
+            length += n
+            step = min(step * 2, 4096)
+        elif n == 1:
+            break
+        else:
+            step = n // 2
+    return length
+
+
+def extend_forward(old, op, new, np):
+    """Bytes to copy from old[op:] for new[np:]: as far as matches outnumber
+    differences (the bsdiff criterion), giving up after PATCH_GIVE_UP bytes
+    without gain."""
+    limit = min(len(old) - op, len(new) - np)
+    i = score = best = best_len = 0
+    while i < limit and i - best_len <= PATCH_GIVE_UP:
+        run = match_length(old, op + i, new, np + i)
+        if run:
+            i += run
+            score += run
+            if score > best:
+                best, best_len = score, i
+        else:
+            i += 1
+            score -= 1
+    return best_len
+
+
+def extend_backward(old, op, new, np, limit):
+    """Bytes before old[op] and new[np] worth copying too, at most limit."""
+    score = best = best_len = 0
+    for i in range(1, limit + 1):
+        score += 1 if old[op - i] == new[np - i] else -1
+        if score > best:
+            best, best_len = score, i
+        elif i - best_len > PATCH_GIVE_UP:
+            break
+    return best_len
+
+
+def encode_copy(old, op, new, np, length):
+    """Copy data: runs of unchanged bytes, and literal runs of differences.
+    Short zero runs stay inside a literal, where they cost less."""
+    diff = bytes((new[np + i] - old[op + i]) & 0xFF for i in range(length))
+    out, i = bytearray(), 0
+    while i < length:
+        start = i
+        while i < length and not diff[i]:
+            i += 1
+        out += varint(i - start)
+        if i == length:
+            break
+        start = i
+        while i < length:
+            if diff[i]:
+                i += 1
+                continue
+            zeros = len(diff[i:i + 3]) - len(diff[i:i + 3].lstrip(b"\0"))
+            if zeros > 2 or i + zeros == length:
+                break
+            i += zeros
+        out += varint(i - start) + diff[start:i]
+    return out
+
+
+def rebase(old, old_addr, new_addr):
+    """The base as the firmware decoder sees it: aligned words pointing into
+    the old image's room moved to the new image's address."""
+    words = list(struct.unpack(f"<{len(old) // 4}I", old))
+    room = SLOT_SIZE - HEADER_SIZE
+    for i, word in enumerate(words):
+        if 0 <= word - old_addr < room:
+            words[i] = (word + new_addr - old_addr) & 0xFFFFFFFF
+    return struct.pack(f"<{len(words)}I", *words)
+
+
+def make_patch(old, new, old_addr, new_addr):
+    """Patch stream (Core/Inc/patch.h) rebuilding image body new, linked at
+    new_addr, from old, linked at old_addr."""
+    crc, size = crc32_stm(old), len(old)
+    old = rebase(old, old_addr, new_addr)
+    index = {}
+    for pos in range(len(old) - PATCH_GRAM + 1):
+        positions = index.setdefault(old[pos:pos + PATCH_GRAM], [])
+        if len(positions) < PATCH_CANDIDATES:
+            positions.append(pos)
+
+    copies = [(0, 0, 0)]                        # new position, old position, length
+    pos = covered = delta = 0
+    while pos + PATCH_GRAM <= len(new):
+        best_len, best_old = 0, 0
+        for cand in [pos + delta] + index.get(new[pos:pos + PATCH_GRAM], []):
+            if 0 <= cand < len(old):            # the continuation first: wins ties
+                length = match_length(old, cand, new, pos)
+                if length > best_len:
+                    best_len, best_old = length, cand
+        if best_len < PATCH_GRAM:
+            pos += 1
+            continue
+        back = extend_backward(old, best_old, new, pos, min(best_old, pos - covered))
+        length = extend_forward(old, best_old, new, pos)
+        copies.append((pos - back, best_old - back, back + length))
+        covered = pos = pos + length
+        delta = best_old - (pos - length)
+
+    out = bytearray(struct.pack("<4I", PATCH_MAGIC, crc, size, len(new)))
+    for (np, op, length), following in zip(copies, copies[1:] + [(len(new), None, 0)]):
+        extra = new[np + length:following[0]]
+        seek = (following[1] if following[1] is not None else op + length) - (op + length)
+        out += varint(length) + varint(len(extra)) + varint((seek << 1) ^ (seek >> 63))
+        out += encode_copy(old, op, new, np, length) + extra
+    return bytes(out)
+
+
+def apply_patch(old, stream, old_addr, new_addr):
+    """Host model of the firmware decoder, to check a patch before it is sent."""
+    def read_varint():
+        nonlocal pos
+        value = shift = 0
+        while True:
+            byte = stream[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    magic, _, _, size = struct.unpack_from("<4I", stream)
+    old = rebase(old, old_addr, new_addr)
+    new, pos, op = bytearray(), 16, 0
+    while len(new) < size:
+        copy, extra, seek = read_varint(), read_varint(), read_varint()
+        end = len(new) + copy
+        while len(new) < end:
+            same = read_varint()
+            new += old[op:op + same]
+            op += same
+            if len(new) < end:
+                count = read_varint()
+                new += bytes((o + d) & 0xFF for o, d in zip(old[op:op + count], stream[pos:pos + count]))
+                op, pos = op + count, pos + count
+        new += stream[pos:pos + extra]
+        pos += extra
+        op += (seek >> 1) ^ -(seek & 1)
+    if magic != PATCH_MAGIC or pos != len(stream):
+        raise ValueError("malformed patch")
+    return bytes(new)
+
+
+def cmd_sign(args):
+    body = open(args.input, "rb").read()
+    body += b"\xff" * (-len(body) % 4)
+    load_addr = SLOTS[args.slot] + HEADER_SIZE
+    if not body or len(body) > SLOT_SIZE - HEADER_SIZE:
+        raise SystemExit(f"{args.input}: {len(body)} bytes do not fit a slot")
+    try:
+        check_vectors(body, load_addr)
+    except ValueError as err:
+        raise SystemExit(f"{args.input}: {err}")
+    header = make_header(body, load_addr, args.version)
+    with open(args.output, "wb") as out:
+        out.write(header + b"\xff" * (HEADER_SIZE - len(header)) + body)
+    print(f"{args.output}: slot {args.slot.upper()}, version {format_version(args.version)}, "
+          f"{len(body)} bytes, CRC 0x{crc32_stm(body):08x}")
+    return 0
+
+
+def cmd_diff(args):
+    files = []
+    for path in (args.old, args.new):
+        data = open(path, "rb").read()
+        try:
+            files.append((data, parse_image(data)))
+        except ValueError as err:
+            raise SystemExit(f"{path}: {err}")
+    (old, base), (new, target) = files
+    if base["slot"] == target["slot"]:
+        raise SystemExit(f"both images are linked for slot {base['slot'].upper()}: the new one "
+                         f"has to be built for the slot that is not running")
+    start = time.monotonic()
+    addrs = base["load_addr"], target["load_addr"]
+    stream = make_patch(old[HEADER_SIZE:], new[HEADER_SIZE:], *addrs)
+    if apply_patch(old[HEADER_SIZE:], stream, *addrs) != new[HEADER_SIZE:]:
+        raise SystemExit("internal error: the patch does not rebuild the image")
+    with open(args.output, "wb") as out:
+        out.write(new[:64] + stream)
+    print(f"{args.output}: slot {base['slot'].upper()} {format_version(base['version'])} -> "
+          f"slot {target['slot'].upper()} {format_version(target['version'])}, {len(stream)} bytes "
+          f"for a {target['size']}-byte image ({100 * len(stream) / target['size']:.1f}%), "
+          f"{time.monotonic() - start:.1f} s")
+    return 0
+
+
+def cmd_info(args):
+    status = 0
+    for path in args.images:
+        data = open(path, "rb").read()
+        try:
+            if is_patch(data):
+                h = parse_patch(data)
+                print(f"{path}: patch to slot {h['slot'].upper()}, version {format_version(h['version'])}, "
+                      f"{h['size']} bytes from a {h['base_size']}-byte base with CRC 0x{h['base_crc']:08x}, "
+                      f"{len(h['stream'])} bytes")
+            else:
+                h = parse_image(data)
+                print(f"{path}: slot {h['slot'].upper()}, version {format_version(h['version'])}, "
+                      f"{h['size']} bytes, CRC 0x{h['crc']:08x}")
+        except ValueError as err:
+            print(f"{path}: {err}")
+            status = 1
+    return status
+
+
+class Link:
+    """Stop-and-wait request/reply exchange with the bootloader."""
+
+    def __init__(self, port, baud, timeout):
+        import termios
+        self.fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+        attr = termios.tcgetattr(self.fd)
+        speed = getattr(termios, f"B{baud}")
+        attr[0] = attr[1] = attr[3] = 0                      # raw: no input/output/line processing
+        attr[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attr[4] = attr[5] = speed
+        attr[6][termios.VMIN], attr[6][termios.VTIME] = 0, 1  # reads return after 0.1 s
+        termios.tcsetattr(self.fd, termios.TCSANOW, attr)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.timeout = timeout
+
+    def read(self, n, deadline):
+        data = bytearray()
+        while len(data) < n:
+            if time.monotonic() > deadline:
+                return None
+            data += os.read(self.fd, n - len(data))
+        return bytes(data)
+
+    def request(self, cmd, payload=b"", timeout=None, retries=3):
+        body = struct.pack("<BH", cmd, len(payload)) + payload
+        frame = bytes([SYNC_REQUEST]) + body + struct.pack("<I", crc32_stm(body))
+        for _ in range(retries):
+            os.write(self.fd, frame)
+            deadline = time.monotonic() + (timeout or self.timeout)
+            reply = self.reply(deadline)
+            if reply is not None and reply[0] != 1:        # not a frame CRC error: done
+                return reply
+        raise SystemExit(f"no valid reply to command {cmd}")
+
+    def reply(self, deadline):
+        while True:
+            sync = self.read(1, deadline)
+            if sync is None:
+                return None
+            if sync[0] != SYNC_REPLY:
+                continue
+            head = self.read(3, deadline)
+            if head is None:
+                return None
+            status, length = struct.unpack("<BH", head)
+            rest = self.read(length + 4, deadline)
+            if rest is None:
+                return None
+            if crc32_stm(head + rest[:length]) == struct.unpack_from("<I", rest, length)[0]:
+                return status, rest[:length]
+
+
+def check(reply, what):
+    status, payload = reply
+    if status:
+        raise SystemExit(f"{what}: {STATUS.get(status, status)}")
+    return payload
+
+
+def cmd_flash(args):
+    images, patches = {}, []
+    for path in args.images:
+        data = open(path, "rb").read()
+        try:
+            if is_patch(data):
+                patches.append((path, data, parse_patch(data)))
+            else:
+                images[parse_image(data)["slot"]] = (path, data)
+        except ValueError as err:
+            raise SystemExit(f"{path}: {err}")
+
+    link = Link(args.port, args.baud, args.timeout)
+    info = struct.unpack(INFO_FORMAT, check(link.request(CMD_INFO), "info"))
+    target, confirmed, trial, attempts, target_addr, _, ver_a, ver_b, chunk, crc_a, crc_b = info
+    slot = "ab"[target]
+    names = {0: "A", 1: "B"}
+    print(f"bootloader: confirmed {names.get(confirmed, '-')}, trial {names.get(trial, '-')}"
+          f" ({attempts} boots), A {format_version(ver_a) if ver_a else '-'}, "
+          f"B {format_version(ver_b) if ver_b else '-'}, writing slot {slot.upper()}")
+    base_crc = crc_b if target == 0 else crc_a
+    patch = next((p for p in patches if p[2]["slot"] == slot and p[2]["base_crc"] == base_crc), None)
+    if patch is None and slot not in images:
+        raise SystemExit(f"no image linked for slot {slot.upper()} (0x{target_addr + HEADER_SIZE:08x}), "
+                         f"and no patch from the image in slot {'ba'[target].upper()}")
+    path, data = patch[:2] if patch else images[slot]
+    header = data[:64]
+    version = parse_header(header)["version"]
+    running = ver_b if target == 0 else ver_a
+    if running and version <= running:
+        print(f"warning: version {format_version(version)} is not above the other slot's "
+              f"{format_version(running)}, it will not be selected", file=sys.stderr)
+
+    start = time.monotonic()
+    check(link.request(CMD_ERASE, timeout=30), "erase")
+    if patch:
+        body, written = patch[2]["stream"], 0
+        for offset in range(0, len(body), chunk):
+            data = body[offset:offset + chunk]
+            check(link.request(CMD_PATCH, struct.pack("<I", offset) + data), f"patch at {offset}")
+            written += len(data)
+            print(f"\r{written}/{len(body)} patch bytes", end="", file=sys.stderr)
+    else:
+        body, written = data[HEADER_SIZE:], 0
+        for offset in range(0, len(body), chunk):
+            data = body[offset:offset + chunk]
+            if data.count(0xFF) == len(data):
+                continue                                # erased already
+            payload = struct.pack("<I", HEADER_SIZE + offset) + data
+            check(link.request(CMD_WRITE, payload), f"write at 0x{HEADER_SIZE + offset:x}")
+            written += len(data)
+            print(f"\r{offset + len(data)}/{len(body)} bytes", end="", file=sys.stderr)
+    print(file=sys.stderr)
+    check(link.request(CMD_FINISH, header, timeout=10), "finish")
+    print(f"{path}: {written} bytes sent, image verified in {time.monotonic() - start:.1f} s")
+    if not args.no_reset:
+        check(link.request(CMD_RESET), "reset")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("sign", help="add the image header to a raw binary")
+    p.add_argument("input", help="raw binary linked at the slot address + 0x200")
+    p.add_argument("output")
+    p.add_argument("--slot", choices=sorted(SLOTS), required=True, help="slot it is linked for")
+    p.add_argument("--version", type=parse_version, required=True, help="major.minor.patch")
+    p.set_defaults(func=cmd_sign)
+
+    p = sub.add_parser("info", help="check image files")
+    p.add_argument("images", nargs="+")
+    p.set_defaults(func=cmd_info)
+
+    p = sub.add_parser("diff", help="make a patch from the running image to a new one")
+    p.add_argument("old", help="image in the slot that runs (the base)")
+    p.add_argument("new", help="new image, linked for the other slot")
+    p.add_argument("output")
+    p.set_defaults(func=cmd_diff)
+
+    p = sub.add_parser("flash", help="upload through the bootloader's update mode")
+    p.add_argument("port", help="serial device, e.g. /dev/ttyACM0")
+    p.add_argument("images", nargs="+",
+                   help="the same release built for slot A and/or B, and/or patches to it")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("--timeout", type=float, default=2.0, help="reply timeout in s")
+    p.add_argument("--no-reset", action="store_true", help="stay in update mode afterwards")
+    p.set_defaults(func=cmd_flash)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""QEMU integration test of the projects that have a QEMU-Test build.
+
+Each such project (Core/Src/selftest.c present) is booted on the STM32F405
+netduinoplus2 machine of qemu-system-arm. The QEMU-Test configuration defines
+QEMU_SELFTEST, so main() runs SelfTest_Run() after the initialization: it
+times SysTick and the TIM peripherals against TIM2 and checks that the
+interrupts reach their handlers, prints one PASS/FAIL line per check over
+semihosting and ends QEMU with SYS_EXIT (status 0 when every check passed).
+
+QEMU runs with -icount shift=3,sleep=off, so the emulated timers count
+virtual time derived from the instruction count and the result does not
+depend on the host load.
+
+    python3 Tools/qemu_test.py                      # every project, prebuilt
+    python3 Tools/qemu_test.py --build 03-Button_EXTI
+
+--build runs make in <project>/QEMU-Test first (the makefile STM32CubeIDE
+generates for the configuration). The exit status is 1 when a project fails,
+times out or has no image, 0 otherwise.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+CONFIG = "QEMU-Test"
+
+
+def projects():
+    """Return the project directories that have a self-test, in order."""
+    return sorted(name for name in os.listdir(ROOT)
+                  if os.path.isfile(os.path.join(ROOT, name, "Core", "Src", "selftest.c")))
+
+
+def build(project):
+    """Build the QEMU-Test configuration; return True on success."""
+    result = subprocess.run(["make", "-C", os.path.join(ROOT, project, CONFIG), "-j", "all"],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode != 0:
+        print(result.stdout)
+    return result.returncode == 0
+
+
+def run(project, qemu, timeout):
+    """Boot one image; return (passed, output)."""
+    elf = os.path.join(ROOT, project, CONFIG, project + ".elf")
+    if not os.path.isfile(elf):
+        return False, f"{elf}: no image (build the {CONFIG} configuration or pass --build)\n"
+
+    command = [qemu, "-M", "netduinoplus2", "-nographic", "-monitor", "none",
+               "-serial", "null", "-icount", "shift=3,sleep=off",
+               "-semihosting-config", "enable=on,target=native", "-kernel", elf]
+    try:
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                text=True, timeout=timeout)
+    except subprocess.TimeoutExpired as exc:
+        output = exc.stdout.decode(errors="replace") if isinstance(exc.stdout, bytes) else (exc.stdout or "")
+        return False, output + f"timeout after {timeout} s (no SYS_EXIT)\n"
+    except FileNotFoundError:
+        return False, f"{qemu}: not found\n"
+
+    output = result.stdout
+    if result.returncode != 0:
+        output += f"exit status {result.returncode}\n"
+    return result.returncode == 0, output
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("projects", nargs="*", help="project directories (default: all with a self-test)")
+    parser.add_argument("--build", action="store_true", help=f"build the {CONFIG} configuration first")
+    parser.add_argument("--qemu", default="qemu-system-arm", help="QEMU binary (default: %(default)s)")
+    parser.add_argument("--timeout", type=float, default=30.0, help="seconds per project (default: %(default)s)")
+    args = parser.parse_args()
+
+    failed = []
+    for project in args.projects or projects():
+        project = os.path.basename(os.path.normpath(project))
+        print(f"== {project}")
+        if args.build and not build(project):
+            print("build failed")
+            failed.append(project)
+            continue
+        passed, output = run(project, args.qemu, args.timeout)
+        print(output, end="")
+        if not passed:
+            failed.append(project)
+
+    print(f"{len(failed)} failed: {' '.join(failed)}" if failed else "all passed")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())